@@ -0,0 +1,584 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+// bench_imath.cpp : standalone iMath kernels microbenchmark.
+// Sweeps MathN/SMath kernels (auto dispatching, _st, _mt and column/row-wise variants) over matrix shapes and thread
+// counts and reports the best and the median run time as ns/element and GB/s. Results could be saved as CSV and/or
+// JSON and compared against a previously saved CSV baseline.
+// Run with --help to see the options. Exit code is 1 if any result regressed against the baseline more than the
+// tolerance allows, 2 on bad arguments or i/o errors.
+//
+// Unlike tests/test_perf_decisions.cpp this doesn't depend on gtest, the RNG and Windows-only parts of nntl,
+// so it builds with CMake on Linux as well (see bench/CMakeLists.txt).
+
+#include "stdafx.h"
+
+#include "../nntl/math.h"
+#include "../nntl/common.h"
+
+#include "../nntl/interface/threads/workers.h"
+#include "../nntl/interface/imemmgr/imemmgr.h"
+#include "../nntl/interface/math/mathn.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace nntl;
+
+typedef math::d_real_t real_t;
+typedef math::smatrix<real_t> realmtx_t;
+typedef threads::Workers<real_t, numel_cnt_t> iThreads_t;
+typedef imem::imemmgr iMemmgr_t;
+typedef math::MathN<real_t, iThreads_t, iMemmgr_t> imath_t;
+typedef imath_t::Thresholds_t thr_t;
+
+//tiling factor of mTilingRoll/mTilingUnroll
+static constexpr vec_len_t sTilingK = 4;
+
+//////////////////////////////////////////////////////////////////////////
+// matrices and vectors the kernels operate on. Everything is allocated before the timing starts.
+struct bench_data {
+	realmtx_t A;//main operand, modified in place by some kernels
+	realmtx_t A0;//pristine copy of A
+	realmtx_t B;//second operand of the same size
+	realmtx_t C;//third operand of the same size (positive values)
+	realmtx_t T;//transposed A, bBatchInRow()==true
+	realmtx_t Tl;//A tiled with sTilingK
+	::std::vector<real_t> vRows, vCols;
+	//mrwL2NormSquared_mt() wants rows()*cur_workers_count() elements
+	::std::vector<real_t> vNorms;
+	::std::vector<vec_len_t> vIdxs;
+
+	bool init(const vec_len_t r, const vec_len_t c, const thread_id_t workersCnt, ::std::mt19937_64& rg) {
+		if (!A.resize(r, c) || !A0.resize(r, c) || !B.resize(r, c) || !C.resize(r, c)) return false;
+		T.set_batchInRow(true);
+		if (!T.resize(c, r)) return false;
+		Tl.clear();
+		if (0 == c % sTilingK && !Tl.resize(r*sTilingK, c / sTilingK)) return false;
+
+		vRows.assign(r, real_t(1));
+		vCols.assign(c, real_t(0));
+		vIdxs.assign(r, 0);
+		vNorms.assign(static_cast<size_t>(r)*workersCnt, real_t(0));
+
+		::std::uniform_real_distribution<real_t> dAB(real_t(-1), real_t(1)), dC(real_t(.5), real_t(2));
+		const auto ne = A.numel();
+		const auto pA0 = A0.data(), pB = B.data(), pC = C.data();
+		for (numel_cnt_t i = 0; i < ne; ++i) {
+			pA0[i] = dAB(rg);
+			pB[i] = dAB(rg);
+			pC[i] = dC(rg);
+		}
+		for (auto& v : vRows) v = dC(rg);
+		restore();
+		return true;
+	}
+	void restore()noexcept {
+		A0.copy_to(A);
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////
+struct kernel_variant {
+	const char* szName;
+	::std::function<void(imath_t&, bench_data&)> f;
+};
+
+struct kernel_desc {
+	const char* szName;
+	//value of the Thresholds_t member that the auto variant compares the matrix numel() with. 0 if not applicable
+	numel_cnt_t threshold;
+	//count of real_t values read and written by the kernel per element of A. Used to derive GB/s
+	unsigned valuesPerElem;
+	//kernel modifies A, so it must be restored before each run
+	bool bRestoreA;
+	::std::vector<kernel_variant> variants;
+	//kernel operates on bench_data::Tl, so the shape must be compatible with sTilingK
+	bool bNeedsTiling;
+
+	bool applicable(const bench_data& d)const noexcept {
+		return !bNeedsTiling || !d.Tl.empty();
+	}
+};
+
+static ::std::vector<kernel_desc> make_kernels() {
+	typedef imath_t M;
+	typedef bench_data D;
+	const real_t mom = real_t(.9), lr = real_t(.01), emaDecay = real_t(.9), numStab = real_t(1e-5);
+
+	::std::vector<kernel_desc> k;
+	//////////////////////////////////////////////////////////////////////////
+	// elementwise
+	k.push_back({ "evMul_ip", thr_t::evMul_ip, 3, true, {
+		{ "auto", [](M& iM, D& d) { iM.evMul_ip(d.A, d.B); } },
+		{ "st", [](M& iM, D& d) { iM.evMul_ip_st(d.A, d.B); } },
+		{ "mt", [](M& iM, D& d) { iM.evMul_ip_mt(d.A, d.B); } }
+	}, false });
+	k.push_back({ "evAdd_ip", thr_t::evAdd_ip, 3, true, {
+		{ "auto", [](M& iM, D& d) { iM.evAdd_ip(d.A, d.B); } },
+		{ "st", [](M& iM, D& d) { iM.evAdd_ip_st(d.A, d.B); } },
+		{ "mt", [](M& iM, D& d) { iM.evAdd_ip_mt(d.A, d.B); } }
+	}, false });
+	k.push_back({ "evSquare", thr_t::evSquare, 2, false, {
+		{ "auto", [](M& iM, D& d) { iM.evSquare(d.A, d.B); } },
+		{ "st", [](M& iM, D& d) { iM.evSquare_st(d.A, d.B); } },
+		{ "mt", [](M& iM, D& d) { iM.evSquare_mt(d.A, d.B); } }
+	}, false });
+	k.push_back({ "sigm", thr_t::sigm, 2, true, {
+		{ "auto", [](M& iM, D& d) { iM.sigm(d.A); } },
+		{ "st", [](M& iM, D& d) { iM.sigm_st(d.A); } },
+		{ "mt", [](M& iM, D& d) { iM.sigm_mt(d.A); } }
+	}, false });
+	k.push_back({ "relu", thr_t::relu, 2, true, {
+		{ "auto", [](M& iM, D& d) { iM.relu(d.A); } },
+		{ "st", [](M& iM, D& d) { iM.relu_st(d.A); } },
+		{ "mt", [](M& iM, D& d) { iM.relu_mt(d.A); } }
+	}, false });
+	k.push_back({ "apply_momentum", thr_t::apply_momentum, 3, true, {
+		{ "auto", [mom](M& iM, D& d) { iM.apply_momentum(d.A, mom, d.B); } },
+		{ "st", [mom](M& iM, D& d) { iM.apply_momentum_st(d.A, mom, d.B); } },
+		{ "mt", [mom](M& iM, D& d) { iM.apply_momentum_mt(d.A, mom, d.B); } }
+	}, false });
+	k.push_back({ "RMSProp_Hinton", thr_t::RMSProp_Hinton, 4, true, {
+		{ "auto", [=](M& iM, D& d) { iM.RMSProp_Hinton(d.A, d.C, lr, emaDecay, numStab); } },
+		{ "st", [=](M& iM, D& d) { iM.RMSProp_Hinton_st(d.A, d.C, lr, emaDecay, numStab); } },
+		{ "mt", [=](M& iM, D& d) { iM.RMSProp_Hinton_mt(d.A, d.C, lr, emaDecay, numStab); } }
+	}, false });
+
+	//////////////////////////////////////////////////////////////////////////
+	// row/column-wise
+	k.push_back({ "mrwSum", thr_t::mrwSum, 1, false, {
+		{ "auto", [](M& iM, D& d) { iM.mrwSum(d.A, &d.vRows[0]); } },
+		{ "st", [](M& iM, D& d) { iM.mrwSum_st(d.A, &d.vRows[0]); } },
+		{ "mt", [](M& iM, D& d) { iM.mrwSum_mt(d.A, &d.vRows[0]); } },
+		{ "st_cw", [](M& iM, D& d) { iM.mrwSum_st_cw(d.A, &d.vRows[0]); } },
+		{ "st_rw", [](M& iM, D& d) { iM.mrwSum_st_rw(d.A, &d.vRows[0]); } },
+		{ "mt_cw", [](M& iM, D& d) { iM.mrwSum_mt_cw(d.A, &d.vRows[0]); } },
+		{ "mt_rw", [](M& iM, D& d) { iM.mrwSum_mt_rw(d.A, &d.vRows[0]); } }
+	}, false });
+	k.push_back({ "mrwMax", thr_t::mrwMax, 1, false, {
+		{ "auto", [](M& iM, D& d) { iM.mrwMax(d.A, &d.vRows[0]); } },
+		{ "st", [](M& iM, D& d) { iM.mrwMax_st(d.A, &d.vRows[0]); } },
+		{ "mt", [](M& iM, D& d) { iM.mrwMax_mt(d.A, &d.vRows[0]); } },
+		{ "st_cw", [](M& iM, D& d) { iM.mrwMax_st_cw(d.A, &d.vRows[0]); } },
+		{ "st_rw", [](M& iM, D& d) { iM.mrwMax_st_rw(d.A, &d.vRows[0]); } },
+		{ "mt_rw", [](M& iM, D& d) { iM.mrwMax_mt_rw(d.A, &d.vRows[0]); } }
+	}, false });
+	k.push_back({ "mrwIdxsOfMax", thr_t::mrwIdxsOfMax, 1, false, {
+		{ "auto", [](M& iM, D& d) { iM.mrwIdxsOfMax(d.A, &d.vIdxs[0]); } },
+		{ "st", [](M& iM, D& d) { iM.mrwIdxsOfMax_st(d.A, &d.vIdxs[0]); } },
+		{ "mt", [](M& iM, D& d) { iM.mrwIdxsOfMax_mt(d.A, &d.vIdxs[0]); } },
+		{ "st_cw", [](M& iM, D& d) { iM.mrwIdxsOfMax_st_cw(d.A, &d.vIdxs[0]); } },
+		{ "st_rw", [](M& iM, D& d) { iM.mrwIdxsOfMax_st_rw(d.A, &d.vIdxs[0]); } },
+		{ "mt_cw", [](M& iM, D& d) { iM.mrwIdxsOfMax_mt_cw(d.A, &d.vIdxs[0]); } },
+		{ "mt_rw", [](M& iM, D& d) { iM.mrwIdxsOfMax_mt_rw(d.A, &d.vIdxs[0]); } }
+	}, false });
+	k.push_back({ "mrwMulByVec", thr_t::mrwMulByVec, 2, true, {
+		{ "auto", [](M& iM, D& d) { iM.mrwMulByVec(d.A, &d.vRows[0]); } },
+		{ "st", [](M& iM, D& d) { iM.mrwMulByVec_st(d.A, &d.vRows[0]); } },
+		{ "mt", [](M& iM, D& d) { iM.mrwMulByVec_mt(d.A, &d.vRows[0]); } },
+		{ "st_cw", [](M& iM, D& d) { iM.mrwMulByVec_st_cw(d.A, &d.vRows[0]); } },
+		{ "st_rw", [](M& iM, D& d) { iM.mrwMulByVec_st_rw(d.A, &d.vRows[0]); } },
+		{ "mt_cw", [](M& iM, D& d) { iM.mrwMulByVec_mt_cw(d.A, &d.vRows[0]); } },
+		{ "mt_rw", [](M& iM, D& d) { iM.mrwMulByVec_mt_rw(d.A, &d.vRows[0]); } }
+	}, false });
+	k.push_back({ "mrwL2NormSquared", thr_t::mrwL2NormSquared, 1, false, {
+		{ "auto", [](M& iM, D& d) { iM.mrwL2NormSquared(d.A, &d.vNorms[0]); } },
+		{ "st", [](M& iM, D& d) { iM.mrwL2NormSquared_st(d.A, &d.vNorms[0]); } },
+		{ "mt", [](M& iM, D& d) { iM.mrwL2NormSquared_mt(d.A, &d.vNorms[0]); } }
+	}, false });
+	k.push_back({ "mcwMean", thr_t::mcwMean<false>::v, 1, false, {
+		{ "auto", [](M& iM, D& d) { iM.mcwMean<false>(d.A, &d.vCols[0]); } },
+		{ "st", [](M& iM, D& d) { iM.mcwMean_st<false>(d.A, &d.vCols[0]); } },
+		{ "mt", [](M& iM, D& d) { iM.mcwMean_mt<false>(d.A, &d.vCols[0]); } }
+	}, false });
+	k.push_back({ "mcwSub_ip", thr_t::mcwSub_ip, 2, true, {
+		{ "auto", [](M& iM, D& d) { iM.mcwSub_ip(d.A, &d.vCols[0]); } },
+		{ "st", [](M& iM, D& d) { iM.mcwSub_ip_st(d.A, &d.vCols[0]); } },
+		{ "mt", [](M& iM, D& d) { iM.mcwSub_ip_mt(d.A, &d.vCols[0]); } }
+	}, false });
+
+	//////////////////////////////////////////////////////////////////////////
+	// data movement
+	k.push_back({ "mTranspose", 0, 2, false, {
+		{ "auto", [](M& iM, D& d) { iM.mTranspose(d.A, d.T); } },
+		{ "st", [](M& , D& d) { M::mTranspose_blocked_st(d.A, d.T, false); } },
+		{ "mt", [](M& iM, D& d) { iM.mTranspose_blocked_mt(d.A, d.T, false); } },
+		{ "seq_read", [](M& , D& d) { M::mTranspose_seq_read(d.A, d.T, false); } },
+		{ "seq_write", [](M& , D& d) { M::mTranspose_seq_write(d.A, d.T, false); } }
+	}, false });
+	k.push_back({ "mTilingRoll", thr_t::mTilingRoll, 2, false, {
+		{ "auto", [](M& iM, D& d) { iM.mTilingRoll(d.A, d.Tl); } },
+		{ "st", [](M& iM, D& d) { iM.mTilingRoll_st(d.A, d.Tl); } },
+		{ "mt", [](M& iM, D& d) { iM.mTilingRoll_mt(d.A, d.Tl); } },
+		{ "seqread_st", [](M& iM, D& d) { iM.mTilingRoll_seqread_st(d.A, d.Tl); } },
+		{ "seqwrite_st", [](M& iM, D& d) { iM.mTilingRoll_seqwrite_st(d.A, d.Tl); } },
+		{ "seqread_mt", [](M& iM, D& d) { iM.mTilingRoll_seqread_mt(d.A, d.Tl); } },
+		{ "seqwrite_mt", [](M& iM, D& d) { iM.mTilingRoll_seqwrite_mt(d.A, d.Tl); } }
+	}, true });
+	k.push_back({ "mTilingUnroll", thr_t::mTilingUnroll, 2, false, {
+		{ "auto", [](M& iM, D& d) { iM.mTilingUnroll(d.Tl, d.A); } },
+		{ "st", [](M& iM, D& d) { iM.mTilingUnroll_st(d.Tl, d.A); } },
+		{ "mt", [](M& iM, D& d) { iM.mTilingUnroll_mt(d.Tl, d.A); } },
+		{ "seqread_st", [](M& iM, D& d) { iM.mTilingUnroll_seqread_st(d.Tl, d.A); } },
+		{ "seqwrite_st", [](M& iM, D& d) { iM.mTilingUnroll_seqwrite_st(d.Tl, d.A); } },
+		{ "seqread_mt", [](M& iM, D& d) { iM.mTilingUnroll_seqread_mt(d.Tl, d.A); } },
+		{ "seqwrite_mt", [](M& iM, D& d) { iM.mTilingUnroll_seqwrite_mt(d.Tl, d.A); } }
+	}, true });
+	return k;
+}
+
+//////////////////////////////////////////////////////////////////////////
+struct bench_opts {
+	::std::vector<::std::pair<vec_len_t, vec_len_t>> shapes;
+	::std::vector<thread_id_t> threads;
+	::std::string filter, jsonFile, csvFile, baselineFile;
+	unsigned repeats = 200, warmup = 10;
+	double tolerance = .1;
+	bool bList = false;
+	bool bHelp = false;
+
+	bench_opts() {
+		shapes = { { 100, 10 },{ 100, 100 },{ 1000, 100 },{ 100, 1000 },{ 1000, 1000 },{ 10000, 100 },{ 4000, 2000 } };
+		const thread_id_t hw = ::std::max(thread_id_t(1), static_cast<thread_id_t>(::std::thread::hardware_concurrency()));
+		threads = { 1 };
+		if (hw / 2 > 1) threads.push_back(hw / 2);
+		if (hw > 1) threads.push_back(hw);
+	}
+};
+
+struct bench_result {
+	::std::string kernel, variant;
+	vec_len_t rows, cols;
+	thread_id_t threads;
+	numel_cnt_t numel, threshold;
+	unsigned valuesPerElem;
+	double bestNs, medianNs;
+
+	double ns_per_elem()const noexcept { return bestNs / static_cast<double>(numel); }
+	//bytes per nanosecond == GB/s
+	double gb_per_s()const noexcept {
+		return static_cast<double>(numel)*valuesPerElem*sizeof(real_t) / bestNs;
+	}
+	::std::string key()const {
+		::std::ostringstream s;
+		s << kernel << '/' << variant << '/' << rows << 'x' << cols << "/t" << threads;
+		return s.str();
+	}
+};
+
+static void print_help() {
+	STDCOUTL("bench_imath - iMath kernels microbenchmark. Options:\n"
+		"  --shapes=RxC[,RxC...]   matrix shapes to sweep\n"
+		"  --threads=N[,N...]      total threads counts (including the main thread) to sweep\n"
+		"  --filter=substr         run only kernels/variants whose 'kernel/variant' name contains substr\n"
+		"  --repeats=N             timed runs per measurement (default 200), the best and the median are reported\n"
+		"  --warmup=N              untimed runs before the measurement (default 10)\n"
+		"  --csv=file              save results as CSV (the format --baseline expects)\n"
+		"  --json=file             save results as JSON\n"
+		"  --baseline=file         compare ns/element against a CSV saved earlier\n"
+		"  --tolerance=x           allowed relative slowdown against the baseline (default 0.1 == 10%)\n"
+		"  --list                  list kernels and variants and exit\n"
+		"  --help                  show this help");
+}
+
+template<typename T, typename F>
+static bool parse_list(const ::std::string& s, ::std::vector<T>& dest, F&& parseOne) {
+	dest.clear();
+	::std::istringstream is(s);
+	::std::string it;
+	while (::std::getline(is, it, ',')) {
+		T v;
+		if (it.empty() || !parseOne(it, v)) return false;
+		dest.push_back(v);
+	}
+	return !dest.empty();
+}
+
+static bool parse_args(int argc, char** argv, bench_opts& o) {
+	for (int i = 1; i < argc; ++i) {
+		const ::std::string a(argv[i]);
+		const auto eq = a.find('=');
+		const auto name = a.substr(0, eq);
+		const auto val = eq == ::std::string::npos ? ::std::string() : a.substr(eq + 1);
+		bool bOk = true;
+		try {
+			if ("--shapes" == name) {
+				bOk = parse_list(val, o.shapes, [](const ::std::string& s, ::std::pair<vec_len_t, vec_len_t>& v) {
+					const auto x = s.find_first_of("xX");
+					if (x == ::std::string::npos) return false;
+					v.first = static_cast<vec_len_t>(::std::stoul(s.substr(0, x)));
+					v.second = static_cast<vec_len_t>(::std::stoul(s.substr(x + 1)));
+					return v.first > 0 && v.second > 0;
+				});
+			} else if ("--threads" == name) {
+				bOk = parse_list(val, o.threads, [](const ::std::string& s, thread_id_t& v) {
+					v = static_cast<thread_id_t>(::std::stoul(s));
+					return v > 0;
+				});
+			} else if ("--filter" == name) {
+				o.filter = val;
+			} else if ("--repeats" == name) {
+				o.repeats = static_cast<unsigned>(::std::stoul(val));
+				bOk = o.repeats > 0;
+			} else if ("--warmup" == name) {
+				o.warmup = static_cast<unsigned>(::std::stoul(val));
+			} else if ("--csv" == name) {
+				o.csvFile = val;
+			} else if ("--json" == name) {
+				o.jsonFile = val;
+			} else if ("--baseline" == name) {
+				o.baselineFile = val;
+			} else if ("--tolerance" == name) {
+				o.tolerance = ::std::stod(val);
+				bOk = o.tolerance >= 0;
+			} else if ("--list" == name) {
+				o.bList = true;
+			} else if ("--help" == name) {
+				o.bHelp = true;
+			} else bOk = false;
+		} catch (const ::std::exception&) {
+			bOk = false;
+		}
+		if (!bOk || (eq == ::std::string::npos && "--list" != name && "--help" != name)) {
+			STDCOUTL("Invalid argument: " << a);
+			return false;
+		}
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+static void run_variant(imath_t& iM, bench_data& d, const kernel_desc& kd, const kernel_variant& kv
+	, const bench_opts& o, double& bestNs, double& medianNs)
+{
+	typedef ::std::chrono::steady_clock clock_t;
+	::std::vector<double> times(o.repeats);
+
+	if (kd.bRestoreA) d.restore();
+	for (unsigned i = 0; i < o.warmup; ++i) {
+		kv.f(iM, d);
+		if (kd.bRestoreA) d.restore();
+	}
+	for (unsigned i = 0; i < o.repeats; ++i) {
+		const auto t0 = clock_t::now();
+		kv.f(iM, d);
+		const auto t1 = clock_t::now();
+		times[i] = static_cast<double>(::std::chrono::duration_cast<::std::chrono::nanoseconds>(t1 - t0).count());
+		if (kd.bRestoreA) d.restore();
+	}
+	::std::sort(times.begin(), times.end());
+	//clock resolution may yield zeros for tiny shapes
+	bestNs = ::std::max(times.front(), 1.);
+	medianNs = ::std::max(times[times.size() / 2], 1.);
+}
+
+static numel_cnt_t temp_mem_required(const imath_t& iM, const bench_opts& o)noexcept {
+	numel_cnt_t r = 0;
+	for (const auto& s : o.shapes) {
+		r = ::std::max({ r, iM.mrwIdxsOfMax_needTempMem<real_t>(s.first)
+			, iM.mrwSum_needTempMem<real_t>(math::smatrix_td::mtx_size_t(s.first, s.second)) });
+	}
+	return r;
+}
+
+static bool run_all(const ::std::vector<kernel_desc>& kernels, const bench_opts& o, ::std::vector<bench_result>& res) {
+	::std::mt19937_64 rg(0);
+	bench_data d;
+
+	for (const auto nt : o.threads) {
+		imath_t iM(nt);
+		iM.preinit(temp_mem_required(iM, o));
+		if (!iM.init()) {
+			STDCOUTL("Failed to init iMath for " << nt << " threads");
+			return false;
+		}
+
+		for (const auto& s : o.shapes) {
+			if (!d.init(s.first, s.second, iM.ithreads().cur_workers_count(), rg)) {
+				STDCOUTL("Failed to allocate matrices of size " << s.first << "x" << s.second);
+				return false;
+			}
+			STDCOUTL("** threads=" << nt << ", shape=" << s.first << "x" << s.second << " (numel=" << d.A.numel() << ")");
+
+			for (const auto& kd : kernels) {
+				if (!kd.applicable(d)) continue;
+				double stBest = 0, mtBest = 0;
+				for (const auto& kv : kd.variants) {
+					const auto fullName = ::std::string(kd.szName) + "/" + kv.szName;
+					if (!o.filter.empty() && fullName.find(o.filter) == ::std::string::npos) continue;
+
+					bench_result r{ kd.szName, kv.szName, s.first, s.second, nt, d.A.numel(), kd.threshold, kd.valuesPerElem, 0, 0 };
+					run_variant(iM, d, kd, kv, o, r.bestNs, r.medianNs);
+					if (!::std::strcmp("st", kv.szName)) stBest = r.bestNs;
+					if (!::std::strcmp("mt", kv.szName)) mtBest = r.bestNs;
+
+					char buf[160];
+					sprintf_s(buf, "  %-18s %-12s %10.3f ns/el %9.3f GB/s  (best %.0f ns, median %.0f ns)", kd.szName, kv.szName
+						, r.ns_per_elem(), r.gb_per_s(), r.bestNs, r.medianNs);
+					STDCOUTL(buf);
+					res.push_back(::std::move(r));
+				}
+				//Thresholds_t sanity hint: does the auto dispatching pick the faster of _st/_mt for this shape?
+				if (kd.threshold && stBest > 0 && mtBest > 0 && nt > 1) {
+					const bool bAutoSt = d.A.numel() < kd.threshold, bStFaster = stBest <= mtBest;
+					if (bAutoSt != bStFaster) {
+						STDCOUTL("  !" << kd.szName << ": Thresholds_t value " << kd.threshold << " selects _" << (bAutoSt ? "st" : "mt")
+							<< ", but _" << (bStFaster ? "st" : "mt") << " is faster here");
+					}
+				}
+			}
+		}
+		iM.deinit();
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+static const char* const szCsvHeader = "kernel,variant,rows,cols,threads,numel,threshold,best_ns,median_ns,ns_per_elem,gb_per_s";
+
+static bool save_csv(const ::std::string& fn, const ::std::vector<bench_result>& res) {
+	::std::ofstream f(fn);
+	if (!f) return false;
+	f.precision(10);
+	f << szCsvHeader << '\n';
+	for (const auto& r : res) {
+		f << r.kernel << ',' << r.variant << ',' << r.rows << ',' << r.cols << ',' << r.threads << ',' << r.numel << ','
+			<< r.threshold << ',' << r.bestNs << ',' << r.medianNs << ',' << r.ns_per_elem() << ',' << r.gb_per_s() << '\n';
+	}
+	return static_cast<bool>(f);
+}
+
+static bool save_json(const ::std::string& fn, const ::std::vector<bench_result>& res, const bench_opts& o) {
+	::std::ofstream f(fn);
+	if (!f) return false;
+	f.precision(10);
+	f << "{\n  \"real_t_size\": " << sizeof(real_t) << ",\n  \"hardware_concurrency\": " << ::std::thread::hardware_concurrency()
+		<< ",\n  \"repeats\": " << o.repeats << ",\n  \"warmup\": " << o.warmup << ",\n  \"results\": [";
+	bool bFirst = true;
+	for (const auto& r : res) {
+		f << (bFirst ? "\n" : ",\n") << "    {\"kernel\": \"" << r.kernel << "\", \"variant\": \"" << r.variant
+			<< "\", \"rows\": " << r.rows << ", \"cols\": " << r.cols << ", \"threads\": " << r.threads << ", \"numel\": " << r.numel
+			<< ", \"threshold\": " << r.threshold << ", \"best_ns\": " << r.bestNs << ", \"median_ns\": " << r.medianNs
+			<< ", \"ns_per_elem\": " << r.ns_per_elem() << ", \"gb_per_s\": " << r.gb_per_s() << "}";
+		bFirst = false;
+	}
+	f << "\n  ]\n}\n";
+	return static_cast<bool>(f);
+}
+
+//returns the count of regressions or -1 on error
+static int compare_with_baseline(const ::std::string& fn, const ::std::vector<bench_result>& res, const double tol) {
+	::std::ifstream f(fn);
+	::std::string line;
+	if (!f || !::std::getline(f, line) || line.compare(0, ::std::strlen(szCsvHeader), szCsvHeader)) {
+		STDCOUTL("Failed to read the baseline or it has unexpected format: " << fn);
+		return -1;
+	}
+
+	::std::map<::std::string, double> base;
+	while (::std::getline(f, line)) {
+		::std::vector<::std::string> c;
+		::std::istringstream is(line);
+		::std::string it;
+		while (::std::getline(is, it, ',')) c.push_back(it);
+		if (c.size() < 10) continue;
+		base[c[0] + "/" + c[1] + "/" + c[2] + "x" + c[3] + "/t" + c[4]] = ::std::stod(c[9]);
+	}
+
+	int regressions = 0, improvements = 0, matched = 0;
+	STDCOUTL("\nComparison with the baseline " << fn << " (tolerance " << tol * 100 << "%):");
+	for (const auto& r : res) {
+		const auto it = base.find(r.key());
+		if (it == base.end() || it->second <= 0) continue;
+		++matched;
+		const double rel = r.ns_per_elem() / it->second - 1;
+		if (rel > tol) {
+			++regressions;
+			STDCOUTL("  REGRESSION  " << r.key() << ": " << it->second << " -> " << r.ns_per_elem() << " ns/el (+" << rel * 100 << "%)");
+		} else if (rel < -tol) {
+			++improvements;
+			STDCOUTL("  improvement " << r.key() << ": " << it->second << " -> " << r.ns_per_elem() << " ns/el (" << rel * 100 << "%)");
+		}
+	}
+	STDCOUTL(matched << " results matched the baseline, " << regressions << " regressions, " << improvements << " improvements");
+	return regressions;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv) {
+	bench_opts o;
+	if (!parse_args(argc, argv, o)) {
+		print_help();
+		return 2;
+	}
+	if (o.bHelp) {
+		print_help();
+		return 0;
+	}
+
+	const auto kernels = make_kernels();
+	if (o.bList) {
+		for (const auto& kd : kernels) {
+			STDCOUT(kd.szName << ":");
+			for (const auto& kv : kd.variants) STDCOUT(" " << kv.szName);
+			STDCOUTL("");
+		}
+		return 0;
+	}
+
+	::std::vector<bench_result> res;
+	if (!run_all(kernels, o, res)) return 2;
+
+	if (!o.csvFile.empty() && !save_csv(o.csvFile, res)) {
+		STDCOUTL("Failed to write " << o.csvFile);
+		return 2;
+	}
+	if (!o.jsonFile.empty() && !save_json(o.jsonFile, res, o)) {
+		STDCOUTL("Failed to write " << o.jsonFile);
+		return 2;
+	}
+	if (!o.baselineFile.empty()) {
+		const auto r = compare_with_baseline(o.baselineFile, res, o.tolerance);
+		if (r < 0) return 2;
+		if (r > 0) return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,530 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+// bench_train.cpp : end-to-end training throughput benchmark.
+// Trains a fixed catalogue of architectures built from the stock layers on synthetic structured data and reports
+// steady state samples/s, per-epoch time spread and peak resident set size. No datasets are required.
+// Run with --help to see the options. Results could be saved as CSV/JSON and compared against a CSV baseline;
+// exit code is 1 if the throughput of any architecture dropped more than the tolerance allows, 2 on errors.
+//
+// Epoch times are taken in onEpochEndCB, so the very first epoch (it also contains the initial loss evaluation done
+// by nnet::train()) is always treated as a warm up one and never counted. The per-epoch evaluation and divergence
+// checks are turned off, so the numbers are pure fprop/bprop/weights update time.
+//
+// Requires the same external RNG package as the rest of nntl (see README.md).
+
+#include "stdafx.h"
+
+#include "../nntl/nntl.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib,"psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace nntl;
+
+typedef d_interfaces::real_t real_t;
+typedef math::smatrix_deform<real_t> realmtxdef_t;
+typedef grad_works<d_interfaces> gw_t;
+
+//////////////////////////////////////////////////////////////////////////
+struct bench_cfg {
+	vec_len_t trainCnt = 10000, testCnt = 1000, batchSize = 100;
+	//feature blocks are gated by the corresponding gate column (used by LPHO, other archs see gates as ordinary features)
+	neurons_count_t gatesCnt = 4, blockWidth = 64, classesCnt = 10;
+	numel_cnt_t epochs = 6, warmup = 1;
+	uint64_t seed = 0x5eed;
+
+	::std::string filter, csvFile, jsonFile, baselineFile;
+	double tolerance = .05;
+	bool bList = false;
+	bool bHelp = false;
+
+	neurons_count_t xWidth()const noexcept { return gatesCnt + gatesCnt*blockWidth; }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// synthetic data: X = [gates | gatesCnt blocks of blockWidth normally distributed features], closed gate zeroes its block.
+// Y is one-hot argmax of a fixed random linear teacher applied to X, so the data is learnable and doesn't depend on
+// anything but the seed.
+static bool make_td(const bench_cfg& c, inmem_train_data<real_t>& td) {
+	::std::mt19937_64 rg(c.seed);
+	::std::normal_distribution<real_t> nd;
+	::std::bernoulli_distribution gateOpen(.75);
+
+	const neurons_count_t xw = c.xWidth();
+	::std::vector<real_t> teacher(static_cast<size_t>(xw)*c.classesCnt), logits(c.classesCnt);
+	for (auto& v : teacher) v = nd(rg);
+
+	const auto make_set = [&](const vec_len_t cnt, realmtxdef_t& X, realmtxdef_t& Y) {
+		X.will_emulate_biases();
+		if (!X.resize(cnt, xw) || !Y.resize(cnt, c.classesCnt)) return false;
+		Y.zeros();
+		for (vec_len_t r = 0; r < cnt; ++r) {
+			for (neurons_count_t g = 0; g < c.gatesCnt; ++g) {
+				const bool bOpen = gateOpen(rg);
+				X.set(r, g, bOpen ? real_t(1) : real_t(0));
+				for (neurons_count_t f = 0; f < c.blockWidth; ++f) {
+					const auto v = nd(rg);
+					X.set(r, c.gatesCnt + g*c.blockWidth + f, bOpen ? v : real_t(0));
+				}
+			}
+			::std::fill(logits.begin(), logits.end(), real_t(0));
+			for (neurons_count_t i = 0; i < xw; ++i) {
+				const auto x = X.get(r, i);
+				for (neurons_count_t k = 0; k < c.classesCnt; ++k) logits[k] += x*teacher[static_cast<size_t>(i)*c.classesCnt + k];
+			}
+			Y.set(r, static_cast<vec_len_t>(::std::max_element(logits.begin(), logits.end()) - logits.begin()), real_t(1));
+		}
+		return X.test_biases_strict();
+	};
+
+	realmtxdef_t trX, trY, tX, tY;
+	return make_set(c.trainCnt, trX, trY) && make_set(c.testCnt, tX, tY)
+		&& td.absorb(::std::move(trX), ::std::move(trY), ::std::move(tX), ::std::move(tY));
+}
+
+//////////////////////////////////////////////////////////////////////////
+// architectures catalogue. Every arch owns its layers and exposes the layers pack as lp
+typedef LFC<activation::relu<real_t>> LH;
+typedef layer_output<activation::sigm_quad_loss<real_t>> LOutQuad;
+typedef layer_output<activation::softmax_xentropy_loss<real_t>> LOutSoftmax;
+
+struct arch_lfc_deep {
+	layer_input<> lInp;
+	LH l1, l2, l3, l4, l5, l6;
+	LOutQuad lOutp;
+	layers<decltype(lInp), LH, LH, LH, LH, LH, LH, LOutQuad> lp;
+
+	arch_lfc_deep(const bench_cfg& c, const real_t lr)noexcept
+		: lInp(c.xWidth()), l1(256, lr), l2(256, lr), l3(256, lr), l4(256, lr), l5(256, lr), l6(256, lr)
+		, lOutp(c.classesCnt, lr), lp(lInp, l1, l2, l3, l4, l5, l6, lOutp)
+	{}
+};
+
+struct arch_lph_wide {
+	layer_input<> lInp;
+	LH lA, lB, lC, lD;
+	LPH<PHL<LH>, PHL<LH>, PHL<LH>, PHL<LH>> lPh;
+	LH lTop;
+	LOutQuad lOutp;
+	layers<decltype(lInp), decltype(lPh), LH, LOutQuad> lp;
+
+	arch_lph_wide(const bench_cfg& c, const real_t lr)noexcept
+		: lInp(c.xWidth()), lA(256, lr), lB(256, lr), lC(256, lr), lD(256, lr)
+		, lPh(make_PHL(lA, 0, c.xWidth() / 4), make_PHL(lB, c.xWidth() / 4, c.xWidth() / 4)
+			, make_PHL(lC, 2 * (c.xWidth() / 4), c.xWidth() / 4), make_PHL(lD, 3 * (c.xWidth() / 4), c.xWidth() - 3 * (c.xWidth() / 4)))
+		, lTop(128, lr), lOutp(c.classesCnt, lr), lp(lInp, lPh, lTop, lOutp)
+	{}
+};
+
+struct arch_lpt_tiling {
+	static constexpr neurons_count_t K = 8;
+
+	layer_input<> lInp;
+	LH lUnd, lTiled;
+	LPT<LH> lTile;
+	LH lTop;
+	LOutQuad lOutp;
+	layers<decltype(lInp), LH, decltype(lTile), LH, LOutQuad> lp;
+
+	arch_lpt_tiling(const bench_cfg& c, const real_t lr)noexcept
+		: lInp(c.xWidth()), lUnd(K * 64, lr), lTiled(32, lr), lTile(lTiled, K)
+		, lTop(128, lr), lOutp(c.classesCnt, lr), lp(lInp, lUnd, lTile, lTop, lOutp)
+	{}
+};
+
+struct arch_lpho_gating {
+	layer_input<> lInp;
+	LIGFI<> lGate;
+	LH lA, lB, lC, lD;
+	LPHO<false, PHL<decltype(lGate)>, PHL<LH>, PHL<LH>, PHL<LH>, PHL<LH>> lPho;
+	LH lTop;
+	LOutQuad lOutp;
+	layers<decltype(lInp), decltype(lPho), LH, LOutQuad> lp;
+
+	arch_lpho_gating(const bench_cfg& c, const real_t lr)noexcept
+		: lInp(c.xWidth()), lA(128, lr), lB(128, lr), lC(128, lr), lD(128, lr)
+		, lPho(make_PHL(lGate, 0, c.gatesCnt)
+			, make_PHL(lA, c.gatesCnt, c.blockWidth), make_PHL(lB, c.gatesCnt + c.blockWidth, c.blockWidth)
+			, make_PHL(lC, c.gatesCnt + 2 * c.blockWidth, c.blockWidth), make_PHL(lD, c.gatesCnt + 3 * c.blockWidth, c.blockWidth))
+		, lTop(128, lr), lOutp(c.classesCnt, lr), lp(lInp, lPho, lTop, lOutp)
+	{
+		NNTL_ASSERT(4 == c.gatesCnt);
+	}
+};
+
+struct arch_softmax {
+	layer_input<> lInp;
+	LH l1, l2;
+	LOutSoftmax lOutp;
+	layers<decltype(lInp), LH, LH, LOutSoftmax> lp;
+
+	arch_softmax(const bench_cfg& c, const real_t lr)noexcept
+		: lInp(c.xWidth()), l1(512, lr), l2(256, lr), lOutp(c.classesCnt, lr), lp(lInp, l1, l2, lOutp)
+	{}
+};
+
+//////////////////////////////////////////////////////////////////////////
+struct optimizer_setup {
+	const char* szName;
+	gw_t::GradType type;
+	real_t lr;
+
+	template<typename _L> ::std::enable_if_t<layer_has_gradworks<_L>::value> operator()(_L& l)const noexcept {
+		typedef ::std::decay_t<decltype(l.get_gradWorks())> gw_type;
+		auto& gw = l.get_gradWorks();
+		gw.set_type(static_cast<typename gw_type::GradType>(type)).learning_rate(lr);
+		if (gw_t::ClassicalConstant == type) gw.nesterov_momentum(real_t(.9));
+		else gw.numeric_stabilizer(real_t(1e-8));
+	}
+	template<typename _L> ::std::enable_if_t<!layer_has_gradworks<_L>::value> operator()(_L&)const noexcept {}
+};
+
+static const optimizer_setup optSGD{ "sgd_nesterov", gw_t::ClassicalConstant, real_t(.01) }
+	, optRMSProp{ "rmsprop", gw_t::RMSProp_Hinton, real_t(.001) }
+	, optAdam{ "adam", gw_t::Adam, real_t(.001) };
+
+//////////////////////////////////////////////////////////////////////////
+struct bench_result {
+	::std::string arch, optimizer;
+	vec_len_t trainCnt, batchSize;
+	numel_cnt_t epochs, warmup;
+	double samplesPerSec, epochMean, epochStd, epochMin, epochMax, peakRssMb;
+	bool bPeakRssIsPerArch;
+
+	double epoch_cv_pct()const noexcept { return epochMean > 0 ? 100 * epochStd / epochMean : 0; }
+	::std::string key()const {
+		::std::ostringstream s;
+		s << arch << '/' << optimizer << "/n" << trainCnt << "/b" << batchSize;
+		return s.str();
+	}
+};
+
+//resets the process peak resident set size counter if OS allows it. Returns false if the peak can't be reset and
+//thus is cumulative over the whole run.
+static bool reset_peak_rss()noexcept {
+#if defined(_WIN32)
+	return false;
+#else
+	//Linux 4.0+: writing "5" to clear_refs resets VmHWM
+	FILE* f = ::fopen("/proc/self/clear_refs", "w");
+	if (!f) return false;
+	const bool r = ::fputs("5", f) >= 0;
+	return (0 == ::fclose(f)) && r;
+#endif
+}
+
+static double peak_rss_mb()noexcept {
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS pmc;
+	return ::GetProcessMemoryInfo(::GetCurrentProcess(), &pmc, sizeof(pmc)) ? double(pmc.PeakWorkingSetSize) / (1 << 20) : 0.;
+#else
+	if (FILE* f = ::fopen("/proc/self/status", "r")) {
+		char line[256];
+		double kb = -1;
+		while (::fgets(line, sizeof(line), f)) {
+			if (!::strncmp(line, "VmHWM:", 6)) {
+				kb = ::atof(line + 6);
+				break;
+			}
+		}
+		::fclose(f);
+		if (kb >= 0) return kb / 1024;
+	}
+	struct rusage ru;
+	return 0 == ::getrusage(RUSAGE_SELF, &ru) ? double(ru.ru_maxrss) / 1024 : 0.;
+#endif
+}
+
+template<typename ArchT>
+static bool run_arch(const char* szArch, const optimizer_setup& opt, inmem_train_data<real_t>& td, const bench_cfg& c
+	, bench_result& res)
+{
+	typedef ::std::chrono::steady_clock clock_t;
+
+	const bool bRssReset = reset_peak_rss();
+
+	ArchT arch(c, opt.lr);
+	arch.lp.for_each_layer(opt);
+
+	auto nn = make_nnet(arch.lp);
+	nn.get_iRng().seed64(c.seed);
+
+	nnet_train_opts<real_t, training_observer_silent<real_t>> opts(c.epochs, false);
+	opts.batchSize(c.batchSize).noDivergenceCheck().calcFullLossValue(false).ImmediatelyDeinit(true);
+
+	::std::vector<clock_t::time_point> epochEnds;
+	epochEnds.reserve(static_cast<size_t>(c.epochs));
+	const auto ec = nn.train(td, opts, [&epochEnds](const numel_cnt_t)noexcept {
+		epochEnds.push_back(clock_t::now());
+		return true;
+	});
+	if (decltype(nn)::ErrorCode::Success != ec) {
+		STDCOUTL(szArch << "/" << opt.szName << ": training failed: " << nn.get_last_error_string());
+		return false;
+	}
+	NNTL_ASSERT(static_cast<numel_cnt_t>(epochEnds.size()) == c.epochs);
+
+	//epoch i duration is epochEnds[i]-epochEnds[i-1], the first c.warmup epochs are skipped
+	::std::vector<double> t;
+	for (size_t i = static_cast<size_t>(c.warmup); i < epochEnds.size(); ++i) {
+		t.push_back(::std::chrono::duration<double>(epochEnds[i] - epochEnds[i - 1]).count());
+	}
+	NNTL_ASSERT(!t.empty());
+	double sum = 0, sqSum = 0;
+	for (const auto v : t) sum += v;
+	const double mean = sum / t.size();
+	for (const auto v : t) sqSum += (v - mean)*(v - mean);
+
+	res = bench_result{ szArch, opt.szName, c.trainCnt, c.batchSize, c.epochs, c.warmup
+		, static_cast<double>(c.trainCnt)*t.size() / sum, mean, t.size() > 1 ? ::std::sqrt(sqSum / (t.size() - 1)) : 0.
+		, *::std::min_element(t.begin(), t.end()), *::std::max_element(t.begin(), t.end()), peak_rss_mb(), bRssReset };
+	return true;
+}
+
+struct catalogue_entry {
+	const char* szArch;
+	const optimizer_setup& opt;
+	bool(*pRun)(const char*, const optimizer_setup&, inmem_train_data<real_t>&, const bench_cfg&, bench_result&);
+};
+
+static const catalogue_entry g_catalogue[] = {
+	{ "lfc_deep", optSGD, &run_arch<arch_lfc_deep> },
+	{ "lfc_deep", optRMSProp, &run_arch<arch_lfc_deep> },
+	{ "lfc_deep", optAdam, &run_arch<arch_lfc_deep> },
+	{ "lph_wide", optAdam, &run_arch<arch_lph_wide> },
+	{ "lpt_tiling", optAdam, &run_arch<arch_lpt_tiling> },
+	{ "lpho_gating", optAdam, &run_arch<arch_lpho_gating> },
+	{ "softmax_out", optRMSProp, &run_arch<arch_softmax> },
+	{ "softmax_out", optAdam, &run_arch<arch_softmax> }
+};
+
+//////////////////////////////////////////////////////////////////////////
+static void print_help() {
+	STDCOUTL("bench_train - end-to-end training throughput benchmark. Options:\n"
+		"  --filter=substr     run only entries whose 'arch/optimizer' name contains substr\n"
+		"  --samples=N         training set size (default 10000)\n"
+		"  --batch=N           batch size (default 100)\n"
+		"  --epochs=N          epochs per architecture including the warm up ones (default 6)\n"
+		"  --warmup=N          epochs to skip, at least 1 (default 1)\n"
+		"  --seed=N            data and weights seed\n"
+		"  --csv=file          save results as CSV (the format --baseline expects)\n"
+		"  --json=file         save results as JSON\n"
+		"  --baseline=file     compare samples/s against a CSV saved earlier\n"
+		"  --tolerance=x       allowed relative throughput drop against the baseline (default 0.05 == 5%)\n"
+		"  --list              list the catalogue and exit\n"
+		"  --help              show this help");
+}
+
+static bool parse_args(int argc, char** argv, bench_cfg& c) {
+	for (int i = 1; i < argc; ++i) {
+		const ::std::string a(argv[i]);
+		const auto eq = a.find('=');
+		const auto name = a.substr(0, eq);
+		const auto val = eq == ::std::string::npos ? ::std::string() : a.substr(eq + 1);
+		bool bOk = true;
+		try {
+			if ("--filter" == name) c.filter = val;
+			else if ("--samples" == name) c.trainCnt = static_cast<vec_len_t>(::std::stoul(val));
+			else if ("--batch" == name) c.batchSize = static_cast<vec_len_t>(::std::stoul(val));
+			else if ("--epochs" == name) c.epochs = static_cast<numel_cnt_t>(::std::stoul(val));
+			else if ("--warmup" == name) c.warmup = static_cast<numel_cnt_t>(::std::stoul(val));
+			else if ("--seed" == name) c.seed = ::std::stoull(val);
+			else if ("--csv" == name) c.csvFile = val;
+			else if ("--json" == name) c.jsonFile = val;
+			else if ("--baseline" == name) c.baselineFile = val;
+			else if ("--tolerance" == name) c.tolerance = ::std::stod(val);
+			else if ("--list" == name) c.bList = true;
+			else if ("--help" == name) c.bHelp = true;
+			else bOk = false;
+		} catch (const ::std::exception&) {
+			bOk = false;
+		}
+		if (!bOk || (eq == ::std::string::npos && "--list" != name && "--help" != name)) {
+			STDCOUTL("Invalid argument: " << a);
+			return false;
+		}
+	}
+	if (c.warmup < 1 || c.epochs <= c.warmup || c.batchSize < 1 || c.trainCnt < c.batchSize || c.tolerance < 0) {
+		STDCOUTL("Invalid options: need 1 <= warmup < epochs, 1 <= batch <= samples and tolerance >= 0");
+		return false;
+	}
+	return true;
+}
+
+static const char* const szCsvHeader = "arch,optimizer,train_samples,batch,epochs,warmup,samples_per_s"
+	",epoch_mean_s,epoch_std_s,epoch_cv_pct,epoch_min_s,epoch_max_s,peak_rss_mb";
+
+static bool save_csv(const ::std::string& fn, const ::std::vector<bench_result>& res) {
+	::std::ofstream f(fn);
+	if (!f) return false;
+	f.precision(10);
+	f << szCsvHeader << '\n';
+	for (const auto& r : res) {
+		f << r.arch << ',' << r.optimizer << ',' << r.trainCnt << ',' << r.batchSize << ',' << r.epochs << ',' << r.warmup << ','
+			<< r.samplesPerSec << ',' << r.epochMean << ',' << r.epochStd << ',' << r.epoch_cv_pct() << ',' << r.epochMin << ','
+			<< r.epochMax << ',' << r.peakRssMb << '\n';
+	}
+	return static_cast<bool>(f);
+}
+
+static bool save_json(const ::std::string& fn, const ::std::vector<bench_result>& res, const bench_cfg& c) {
+	::std::ofstream f(fn);
+	if (!f) return false;
+	f.precision(10);
+	f << "{\n  \"real_t_size\": " << sizeof(real_t) << ",\n  \"hardware_concurrency\": " << ::std::thread::hardware_concurrency()
+		<< ",\n  \"x_width\": " << c.xWidth() << ",\n  \"classes\": " << c.classesCnt << ",\n  \"seed\": " << c.seed
+		<< ",\n  \"results\": [";
+	bool bFirst = true;
+	for (const auto& r : res) {
+		f << (bFirst ? "\n" : ",\n") << "    {\"arch\": \"" << r.arch << "\", \"optimizer\": \"" << r.optimizer
+			<< "\", \"train_samples\": " << r.trainCnt << ", \"batch\": " << r.batchSize << ", \"epochs\": " << r.epochs
+			<< ", \"warmup\": " << r.warmup << ", \"samples_per_s\": " << r.samplesPerSec << ", \"epoch_mean_s\": " << r.epochMean
+			<< ", \"epoch_std_s\": " << r.epochStd << ", \"epoch_cv_pct\": " << r.epoch_cv_pct() << ", \"epoch_min_s\": " << r.epochMin
+			<< ", \"epoch_max_s\": " << r.epochMax << ", \"peak_rss_mb\": " << r.peakRssMb
+			<< ", \"peak_rss_per_arch\": " << (r.bPeakRssIsPerArch ? "true" : "false") << "}";
+		bFirst = false;
+	}
+	f << "\n  ]\n}\n";
+	return static_cast<bool>(f);
+}
+
+//returns the count of regressions or -1 on error
+static int compare_with_baseline(const ::std::string& fn, const ::std::vector<bench_result>& res, const double tol) {
+	::std::ifstream f(fn);
+	::std::string line;
+	if (!f || !::std::getline(f, line) || line.compare(0, ::std::strlen(szCsvHeader), szCsvHeader)) {
+		STDCOUTL("Failed to read the baseline or it has unexpected format: " << fn);
+		return -1;
+	}
+	::std::map<::std::string, double> base;
+	while (::std::getline(f, line)) {
+		::std::vector<::std::string> c;
+		::std::istringstream is(line);
+		::std::string it;
+		while (::std::getline(is, it, ',')) c.push_back(it);
+		if (c.size() < 7) continue;
+		base[c[0] + "/" + c[1] + "/n" + c[2] + "/b" + c[3]] = ::std::stod(c[6]);
+	}
+
+	int regressions = 0, matched = 0;
+	STDCOUTL("\nComparison with the baseline " << fn << " (tolerance " << tol * 100 << "%):");
+	for (const auto& r : res) {
+		const auto it = base.find(r.key());
+		if (it == base.end() || it->second <= 0) continue;
+		++matched;
+		const double rel = r.samplesPerSec / it->second - 1;
+		const bool bRegr = rel < -tol;
+		if (bRegr) ++regressions;
+		char buf[192];
+		sprintf_s(buf, "  %-11s %-36s %10.1f -> %10.1f samples/s (%+.1f%%)", bRegr ? "REGRESSION" : "", r.key().c_str()
+			, it->second, r.samplesPerSec, rel * 100);
+		STDCOUTL(buf);
+	}
+	STDCOUTL(matched << " results matched the baseline, " << regressions << " regressions");
+	return regressions;
+}
+
+//////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv) {
+	bench_cfg c;
+	if (!parse_args(argc, argv, c)) {
+		print_help();
+		return 2;
+	}
+	if (c.bHelp) {
+		print_help();
+		return 0;
+	}
+	if (c.bList) {
+		for (const auto& e : g_catalogue) STDCOUTL(e.szArch << "/" << e.opt.szName);
+		return 0;
+	}
+
+	inmem_train_data<real_t> td;
+	STDCOUTL("Generating synthetic data: " << c.trainCnt << " train and " << c.testCnt << " test samples of width "
+		<< c.xWidth() << ", " << c.classesCnt << " classes...");
+	if (!make_td(c, td)) {
+		STDCOUTL("Failed to generate the data");
+		return 2;
+	}
+
+	::std::vector<bench_result> res;
+	for (const auto& e : g_catalogue) {
+		const auto fullName = ::std::string(e.szArch) + "/" + e.opt.szName;
+		if (!c.filter.empty() && fullName.find(c.filter) == ::std::string::npos) continue;
+
+		bench_result r;
+		if (!e.pRun(e.szArch, e.opt, td, c, r)) return 2;
+
+		char buf[256];
+		sprintf_s(buf, "%-26s %10.1f samples/s, epoch %.3fs +- %.3fs (cv %.1f%%, min %.3fs, max %.3fs), peak RSS %.1f MB%s"
+			, fullName.c_str(), r.samplesPerSec, r.epochMean, r.epochStd, r.epoch_cv_pct(), r.epochMin, r.epochMax, r.peakRssMb
+			, r.bPeakRssIsPerArch ? "" : " (process-wide)");
+		STDCOUTL(buf);
+		res.push_back(::std::move(r));
+	}
+
+	if (!c.csvFile.empty() && !save_csv(c.csvFile, res)) {
+		STDCOUTL("Failed to write " << c.csvFile);
+		return 2;
+	}
+	if (!c.jsonFile.empty() && !save_json(c.jsonFile, res, c)) {
+		STDCOUTL("Failed to write " << c.jsonFile);
+		return 2;
+	}
+	if (!c.baselineFile.empty()) {
+		const auto r = compare_with_baseline(c.baselineFile, res, c.tolerance);
+		if (r < 0) return 2;
+		if (r > 0) return 1;
+	}
+	return 0;
+}
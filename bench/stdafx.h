@@ -0,0 +1,135 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+// stdafx.h : common header of the benchmark executables. Must be included before any nntl file.
+// Plays the same role as tests/stdafx.h: nntl core expects the user to define STDCOUT/STDCOUTL and a few other things.
+//
+
+#pragma once
+
+//min() and max() triggers very weird compiler crash while doing ::std::numeric_limits<vec_len_t>::max()
+#define NOMINMAX
+
+#define _USE_MATH_DEFINES // for C++ math constants
+
+#include <stdio.h>
+#include <iostream>
+
+#define STDCOUT(args) ::std::cout << args
+#define STDCOUTL(args) STDCOUT(args) << ::std::endl
+
+//////////////////////////////////////////////////////////////////////////
+// nntl core is written against MSVC CRT. Non-Windows builds (see bench/CMakeLists.txt) get the minimal set of
+// replacements required to compile the core, the layers and the nnet.
+#if !defined(_WIN32)
+
+#include <cstdarg>
+#include <cstring>
+#include <cerrno>
+#include <xmmintrin.h>
+
+//MSVC STL brings these in through <iostream>, nntl core relies on that
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+
+#ifndef __forceinline
+#define __forceinline inline __attribute__((always_inline))
+#endif
+
+//_controlfp_s() emulation over MXCSR for the flags nntl uses (denormals handling and rounding mode)
+#define _MCW_DN 0x03000000u
+#define _DN_SAVE 0x00000000u
+#define _DN_FLUSH 0x01000000u
+#define _MCW_RC 0x00000300u
+#define _RC_NEAR 0x00000000u
+#define _RC_CHOP 0x00000300u
+#define _CW_DEFAULT (_RC_NEAR | _DN_SAVE)
+
+inline int _controlfp_s(unsigned int* pCurrent, const unsigned int newVal, const unsigned int mask)noexcept {
+	//MXCSR: bit 6 - DAZ, bit 15 - FTZ, bits 13-14 - rounding control
+	static constexpr unsigned int csrDn = (1u << 6) | (1u << 15), csrRc = 3u << 13;
+	auto csr = _mm_getcsr();
+	if (mask & _MCW_DN) {
+		csr = ((newVal & _MCW_DN) == _DN_FLUSH) ? (csr | csrDn) : (csr & ~csrDn);
+	}
+	if (mask & _MCW_RC) {
+		csr = ((newVal & _MCW_RC) == _RC_CHOP) ? (csr | csrRc) : (csr & ~csrRc);
+	}
+	if (mask) _mm_setcsr(csr);
+	if (pCurrent) {
+		*pCurrent = (((csr & csrDn) == csrDn) ? _DN_FLUSH : _DN_SAVE) | (((csr & csrRc) == csrRc) ? _RC_CHOP : _RC_NEAR);
+	}
+	return 0;
+}
+
+inline int vsprintf_s(char* buf, const size_t bufSize, const char* fmt, va_list args)noexcept {
+	if (!buf || !bufSize) return -1;
+	const int r = ::vsnprintf(buf, bufSize, fmt, args);
+	if (r < 0 || static_cast<size_t>(r) >= bufSize) {
+		buf[0] = 0;
+		return -1;
+	}
+	return r;
+}
+inline int sprintf_s(char* buf, const size_t bufSize, const char* fmt, ...)noexcept {
+	va_list args;
+	va_start(args, fmt);
+	const int r = vsprintf_s(buf, bufSize, fmt, args);
+	va_end(args);
+	return r;
+}
+template<size_t _N>
+inline int sprintf_s(char(&buf)[_N], const char* fmt, ...)noexcept {
+	va_list args;
+	va_start(args, fmt);
+	const int r = vsprintf_s(buf, _N, fmt, args);
+	va_end(args);
+	return r;
+}
+#define printf_s printf
+
+inline int strcpy_s(char* dest, const size_t destSize, const char* src)noexcept {
+	if (!dest || !destSize || !src) return EINVAL;
+	const auto l = ::strlen(src);
+	if (l >= destSize) {
+		dest[0] = 0;
+		return ERANGE;
+	}
+	::memcpy(dest, src, l + 1);
+	return 0;
+}
+template<size_t _N>
+inline int strcpy_s(char(&dest)[_N], const char* src)noexcept { return strcpy_s(dest, _N, src); }
+
+#endif //!defined(_WIN32)
@@ -69,6 +69,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define NNTL_STRINGIZE(s) #s
 
+#define _NNTL_CONCAT_IMPL(a, b) a##b
+//concatenates tokens after macro expansion, i.e. NNTL_CONCAT(name_, __LINE__) gives name_123
+#define NNTL_CONCAT(a, b) _NNTL_CONCAT_IMPL(a, b)
+
 //#define NNTL_UNREF(P)          (P)
 #define NNTL_UNREF(P)     (P)
 
@@ -42,6 +42,7 @@ namespace nntl {
 
 			InvalidInputLayerNeuronsCount,
 			InvalidOutputLayerNeuronsCount,
+			InvalidEnsembleIncomingNeuronsCount,
 
 			InvalidBatchSizeCombination,
 
@@ -58,6 +59,7 @@ namespace nntl {
 			DropoutInitFailed,
 			//PAInitFailed,
 			CantAllocateMemoryForGatingMask,
+			CantAllocateMemoryForGatedRowsIdxs,
 			CantAllocateMemoryForTempData,
 			CantAllocateMemoryForWeights,
 			//CantAllocateMemoryForTmpBiasStorage,
@@ -65,10 +67,12 @@ namespace nntl {
 			CantInitializeIRng,
 			CantInitializeObserver,
 			CantInitializeGradWorks,
+			UnsupportedGradWorksSettings,
 			CantInitializeActFunc,
 			CantInitializeWeights,
 			CantInitializePAB,
 			NNDiverged,
+			GradientExchangeFailed,
 
 			PostInitStopFromCallback
 		};
@@ -82,6 +86,7 @@ namespace nntl {
 
 			case InvalidInputLayerNeuronsCount: return NNTL_STRING("Input layer neurons count mismatches train_x width.");
 			case InvalidOutputLayerNeuronsCount: return NNTL_STRING("Output layer neurons count mismatches train_y width.");
+			case InvalidEnsembleIncomingNeuronsCount: return NNTL_STRING("Incoming neurons count of a member-wise ensemble layer isn't divisible by the members count.");
 
 			case InvalidBatchSizeCombination: return NNTL_STRING("Invalid batch size combination encountered.");
 
@@ -98,6 +103,7 @@ namespace nntl {
 			case DropoutInitFailed: return NNTL_STRING("Dropout initialization routine failed");
 			//case PAInitFailed: return NNTL_STRING("PAB initialization routine failed");
 			case CantAllocateMemoryForGatingMask: return NNTL_STRING("Cant allocate memory for gating mask");
+			case CantAllocateMemoryForGatedRowsIdxs: return NNTL_STRING("Cant allocate memory for indexes of gated rows");
 			case CantAllocateMemoryForTempData: return NNTL_STRING("Cant allocate memory for temporarily data");
 			case CantAllocateMemoryForWeights: return NNTL_STRING("Cant allocate memory for weight matrix");
 			//case CantAllocateMemoryForTmpBiasStorage: return NNTL_STRING("Cant allocate memory for tmp bias storage");
@@ -105,10 +111,12 @@ namespace nntl {
 			case CantInitializeIRng: return NNTL_STRING("Cant initialize iRng interface");
 			case CantInitializeObserver: return NNTL_STRING("Cant initialize observer");
 			case CantInitializeGradWorks: return NNTL_STRING("Cant initialize grad_works object");
+			case UnsupportedGradWorksSettings: return NNTL_STRING("The layer doesn't support some of grad_works settings (e.g. momentums, max-norm or loss addendums for LE)");
 			case CantInitializeActFunc: return NNTL_STRING("Cant initialize activation function");
 			case CantInitializeWeights: return NNTL_STRING("Weights initialization failed");
 			case CantInitializePAB: return NNTL_STRING("Activations penalizer initialization failed");
 			case NNDiverged: return NNTL_STRING("NN diverged! (Training loss value surpassed the threshold from opts.divergenceCheckThreshold())");
+			case GradientExchangeFailed: return NNTL_STRING("Distributed gradient exchange failed (transport timeout or a dead peer)");
 			case PostInitStopFromCallback: return NNTL_STRING("Callback onInitCB returned non successfull code");
 			default: NNTL_ASSERT(!"WTF?"); return NNTL_STRING("Unknown code.");
 			}
@@ -81,6 +81,10 @@ namespace nntl_supp {
 		static_assert(8 + 1 + FIELD_ENTRY::sFieldNameTotalLength == sizeof(FIELD_ENTRY), "WTF?");
 #pragma pack(pop)
 
+		template <typename DestDT> inline BYTE data_type()noexcept;
+		template <> inline BYTE data_type<double>()noexcept { return dt_double; }
+		template <> inline BYTE data_type<float>()noexcept { return dt_float; }
+
 		template <typename DestDT> inline bool correct_data_type(BYTE dt)noexcept { return false; }
 		template <> inline bool correct_data_type<double>(BYTE dt)noexcept { return dt_double == dt; }
 		template <> inline bool correct_data_type<float>(BYTE dt)noexcept { return dt_float == dt; }
@@ -113,7 +117,8 @@ namespace nntl_supp {
 			IncoherentSeqClassCount,
 			IncoherentMetaAndContent,
 
-			MemoryAllocationFailed
+			MemoryAllocationFailed,
+			FailedToWriteData
 		};
 
 		//TODO: table lookup would be better here. But it's not essential
@@ -144,6 +149,7 @@ namespace nntl_supp {
 			case IncoherentMetaAndContent:return NNTL_STRING("Incoherent file header description and content");
 
 			case MemoryAllocationFailed: return NNTL_STRING("Not Enough Memory");
+			case FailedToWriteData: return NNTL_STRING("Failed to write data");
 
 			default: NNTL_ASSERT(!"WTF?"); return NNTL_STRING("Unknown code.");
 			}
@@ -208,6 +214,38 @@ namespace nntl_supp {
 			return _read_into(fp, dest, static_cast<int>(hdr.wFieldsCount), static_cast<int>(hdr.wSeqClassCount));
 		}
 
+		//writes td into fname in the format read() expects (X data is written without bias column). Handy to convert
+		// a dataset once from a slow to parse format (such as json) for fast loads later.
+		template<typename TX, typename TY>
+		const ErrorCode write(const char* fname, const train_data<TX, TY>& td)noexcept {
+			NNTL_ASSERT(!td.empty());
+			FILE* fp = nullptr;
+			if (fopen_s(&fp, fname, NNTL_STRING("wb")) || nullptr == fp) return _set_last_error(ErrorCode::FailedToOpenFile);
+			nntl::utils::scope_exit on_exit([&fp]() {
+				if (fp) {
+					fclose(fp);
+					fp = nullptr;
+				}
+			});
+
+			bin_file::HEADER hdr;
+			hdr.dwSignature = hdr.sSignature;
+			hdr.wVersionNum = hdr.sLatestVersion;
+			hdr.wFieldsCount = static_cast<bin_file::WORD>(total_members);
+			hdr.wSeqClassCount = 0;
+			if (1 != fwrite(&hdr, sizeof(hdr), 1, fp)) return _set_last_error(ErrorCode::FailedToWriteData);
+
+			ErrorCode ec = _write_field_entry(fp, train_x, td.train_x());
+			if (ErrorCode::Success == ec) ec = _write_field_entry(fp, train_y, td.train_y());
+			if (ErrorCode::Success == ec) ec = _write_field_entry(fp, test_x, td.test_x());
+			if (ErrorCode::Success == ec) ec = _write_field_entry(fp, test_y, td.test_y());
+			if (ErrorCode::Success != ec) return ec;
+
+			const auto r = fclose(fp);
+			fp = nullptr;
+			return _set_last_error(0 == r ? ErrorCode::Success : ErrorCode::FailedToWriteData);
+		}
+
 	protected:
 		enum _root_members {
 			train_x = 0,
@@ -217,6 +255,16 @@ namespace nntl_supp {
 			total_members
 		};
 
+		inline static const char* _id2name(const _root_members id) noexcept {
+			switch (id) {
+			case train_x: return "train_x";
+			case train_y: return "train_y";
+			case test_x: return "test_x";
+			case test_y: return "test_y";
+			default: NNTL_ASSERT(!"WTF?"); return "";
+			}
+		}
+
 		inline static const _root_members _name2id(const char* sz) noexcept {
 			if (0 == strcmp("train_x", sz)) return _root_members::train_x;
 			if (0 == strcmp("train_y", sz)) return _root_members::train_y;
@@ -340,6 +388,27 @@ namespace nntl_supp {
 			return ec;
 		}
 
+		template<typename T_>
+		ErrorCode _write_field_entry(FILE* fp, const _root_members fieldId, const smatrix<T_>& m)noexcept {
+			static_assert(::std::is_same<T_, double>::value || ::std::is_same<T_, float>::value, "Only float or double data is supported");
+			NNTL_ASSERT(!m.empty() && !m.bBatchInRow());
+			if (m.empty() || m.bBatchInRow()) return _set_last_error(ErrorCode::InvalidDataSize);
+
+#pragma warning(disable : 4815)
+			bin_file::FIELD_ENTRY fe;
+#pragma warning(default : 4815)
+			::std::memset(&fe, 0, sizeof(fe));
+			fe.dwRows = static_cast<bin_file::DWORD>(m.rows());
+			fe.dwCols = static_cast<bin_file::DWORD>(m.cols_no_bias());
+			strncpy_s(fe.szName, _id2name(fieldId), bin_file::FIELD_ENTRY::sFieldNameTotalLength - 1);
+			fe.bDataType = bin_file::data_type<T_>();
+
+			if (1 != fwrite(&fe, sizeof(fe), 1, fp)) return _set_last_error(ErrorCode::FailedToWriteData);
+			const size_t bytes = static_cast<size_t>(m.byte_size_no_bias());
+			if (1 != fwrite(m.data(), bytes, 1, fp)) return _set_last_error(ErrorCode::FailedToWriteData);
+			return ErrorCode::Success;
+		}
+
 		//////////////////////////////////////////////////////////////////////////
 		template<typename T_>
 		ErrorCode _impl_read_field_entry(FILE* fp, smatrix<T_>& m, _root_members* pTdFieldId = nullptr)noexcept {
@@ -0,0 +1,699 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//Native raw binary checkpoints: weights and optimizer state (_grad_works' m_Vw, m_optMtxA, m_optMtxB, beta1^t, beta2^t)
+// of every learnable layer (of every weights block of a layer, see layer_has_weights_blocks) are stored as raw column-major blobs, so saving is a plain memcpy()+fwrite() and loading
+// is an mmap() + a copy. No conversion or serialization framework is involved, therefore the file is tied to the
+// real_t type (and the endianness) it was written with.
+//
+//File layout (see ckpt_file namespace): HEADER, ENTRY[dwEntriesCount], then entry blobs. Every blob starts at
+// a sAlignment-aligned file offset.
+//
+//checkpoint_writer::snapshot() copies the state into one of two buffers and returns. The buffer is written on
+// a background (BgWorkers) thread to "<fileName>.tmp", which is then renamed to fileName, so a crash during the write
+// never destroys the previous checkpoint. If the previous snapshot still waits for the writer when a new one is taken,
+// the older one is dropped. Call wait() to make sure everything is on disk and to get an error code of writes.
+//Usage (note that the writer must outlive the training):
+//	checkpoint_writer<real_t> cw;
+//	nn.train(td, opts, [&cw, &lp](size_t epochEnded) {
+//		cw.snapshot(lp, "net.ckpt", epochEnded);
+//		return true;
+//	});
+//	cw.wait();
+//
+//checkpoint_reader maps the file into memory and restores layers. Weights can be restored at any time after the
+// layers were assembled into a layer_pack (i.e. before nnet::train()). However, optimizer state exists only inside
+// nnet::train() (it's allocated in gw_init()), so to continue the training with the saved optimizer state, pass
+// make_checkpoint_restorer() as the onInitCB of nnet::train().
+//Weights are always restored with the layer's set_weights() (set_weights_blocks()), so layers that derive something
+// from the weights (such as compressed copies of LFCP) rebuild it. The mask of pruned weights (see
+// nntl::layer_has_prune_mask) is stored as a separate entry and is restored along with the weights; a layer that has no
+// mask entry gets restored as a dense one.
+//Note that the ILR (individual learning rates) state is not saved.
+
+#include <array>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "../../errors.h"
+#include "../../_nnet_errs.h"
+#include "../../interface/threads/bgworkers.h"
+#include "../../layer/_layer_base.h"
+#include "mapped_file.h"
+
+namespace nntl_supp {
+
+	namespace ckpt_file {
+		typedef uint64_t QWORD;
+		typedef uint32_t DWORD;
+		typedef uint16_t WORD;
+		typedef uint8_t  BYTE;
+
+		enum DATA_TYPES {
+			dt_double = 0,
+			dt_float = 1
+		};
+
+		enum BLOB_KIND {
+			bk_weights = 0,
+			bk_Vw,//the order of optimizer state kinds must match _grad_works::StateMtx
+			bk_optMtxA,
+			bk_optMtxB,
+			bk_pruneMask
+		};
+
+		static constexpr size_t sAlignment = 64;
+
+#pragma pack(push, 1)
+		struct HEADER {
+			DWORD dwSignature;
+			WORD wVersionNum; //format version number
+			BYTE bDataType;
+			BYTE bReserved;
+			DWORD dwEntriesCount;//total count of ENTRY structures immediately after HEADER
+			DWORD dwReserved;
+			QWORD qwEpoch;//arbitrary user supplied tag
+			QWORD qwFileSize;
+			BYTE reserved[32];
+
+			static constexpr DWORD sSignature = 0x6B636E6Eu;//"kcnn" as a big-endian number, kept for existing files
+			static constexpr WORD sLatestVersion = 0;
+		};
+		static_assert(64 == sizeof(HEADER), "WTF??");
+
+		struct ENTRY {
+			QWORD qwLayerTypeId;
+			QWORD qwDataOffset;//from the beginning of the file, multiple of sAlignment
+			DWORD dwLayerIdx;
+			DWORD dwRows;
+			DWORD dwCols;
+			BYTE bKind;//BLOB_KIND
+			BYTE bWeightsBlock;//weights block index (see nntl::layer_has_weights_blocks), 0 for layers with a single weights matrix
+			BYTE reserved1[2];
+			double dBeta1t, dBeta2t;//optimizer scalar state, meaningful for bk_weights entries only
+			BYTE reserved2[16];
+		};
+		static_assert(64 == sizeof(ENTRY), "WTF??");
+#pragma pack(pop)
+
+		template <typename DestDT> inline BYTE data_type()noexcept;
+		template <> inline BYTE data_type<double>()noexcept { return dt_double; }
+		template <> inline BYTE data_type<float>()noexcept { return dt_float; }
+
+		inline size_t align(const size_t v)noexcept { return (v + sAlignment - 1) & ~(sAlignment - 1); }
+
+		inline FILE* fopen_write(const char* fileName)noexcept {
+#if defined(_MSC_VER)
+			FILE* fp = nullptr;
+			return fopen_s(&fp, fileName, "wb") ? nullptr : fp;
+#else
+			return ::std::fopen(fileName, "wb");
+#endif
+		}
+
+		inline bool sync_file(FILE* fp)noexcept {
+#if defined(_WIN32)
+			return 0 == _commit(_fileno(fp));
+#else
+			return 0 == ::fsync(::fileno(fp));
+#endif
+		}
+
+		//atomically (where possible) replaces dest with src
+		inline bool replace_file(const char* src, const char* dest)noexcept {
+#if defined(_WIN32)
+			return !!::MoveFileExA(src, dest, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+			return 0 == ::rename(src, dest);
+#endif
+		}
+
+		template<class T>
+		struct Call_flush {
+			T*const ptr;
+
+			Call_flush(T*const p)noexcept :ptr(p) {}
+			bool operator()(const nntl::thread_id_t) {
+				return ptr->_bg_flush();
+			}
+		};
+	}
+
+	struct _checkpoint_errs {
+		enum ErrorCode {
+			Success = 0,
+			FailedToOpenFile,
+			FailedToMapFile,
+			FailedToReadHeader,
+			WrongHeaderSignature,
+			UnsupportedFormatVersion,
+			UnsupportedIncorrectDataType,
+			InvalidFileSize,
+			InvalidEntry,
+			MemoryAllocationFailed,
+			FailedToWriteData,
+			FailedToReplaceFile,
+			NotOpened,
+			NoLayerEntry,
+			LayerTypeMismatch,
+			WeightsSizeMismatch,
+			StateSizeMismatch,
+			UnusedEntries
+		};
+
+		static const nntl::strchar_t* get_error_str(const ErrorCode ec) noexcept {
+			switch (ec) {
+			case Success: return NNTL_STRING("No error / success.");
+			case FailedToOpenFile: return NNTL_STRING("Failed to open file.");
+			case FailedToMapFile: return NNTL_STRING("Failed to open or map file into memory.");
+			case FailedToReadHeader: return NNTL_STRING("File is too small to contain a header.");
+			case WrongHeaderSignature: return NNTL_STRING("Wrong header signature.");
+			case UnsupportedFormatVersion: return NNTL_STRING("Unknown or unsupported format version.");
+			case UnsupportedIncorrectDataType: return NNTL_STRING("Checkpoint data type differs from real_t.");
+			case InvalidFileSize: return NNTL_STRING("File size doesn't match the header. Probably the file is truncated.");
+			case InvalidEntry: return NNTL_STRING("Invalid entry found.");
+			case MemoryAllocationFailed: return NNTL_STRING("Memory allocation failed.");
+			case FailedToWriteData: return NNTL_STRING("Failed to write data.");
+			case FailedToReplaceFile: return NNTL_STRING("Failed to rename temporary file to the checkpoint file.");
+			case NotOpened: return NNTL_STRING("Checkpoint file hasn't been opened.");
+			case NoLayerEntry: return NNTL_STRING("Checkpoint doesn't contain weights for some layer.");
+			case LayerTypeMismatch: return NNTL_STRING("Layer type differs from the type stored in checkpoint.");
+			case WeightsSizeMismatch: return NNTL_STRING("Weights size differs from the size stored in checkpoint.");
+			case StateSizeMismatch: return NNTL_STRING("Optimizer state size differs from the size stored in checkpoint.");
+			case UnusedEntries: return NNTL_STRING("Checkpoint contains entries for layers not found in the nnet.");
+
+			default: NNTL_ASSERT(!"WTF?"); return NNTL_STRING("Unknown code.");
+			}
+		}
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	template<typename RealT>
+	class checkpoint_writer : public nntl::_has_last_error<_checkpoint_errs> {
+		checkpoint_writer(const checkpoint_writer& other)noexcept = delete;
+		checkpoint_writer& operator=(const checkpoint_writer& rhs) noexcept = delete;
+
+		typedef checkpoint_writer<RealT> self_t;
+
+	public:
+		typedef RealT real_t;
+		typedef nntl::threads::BgWorkers<> bgworkers_t;
+		typedef ckpt_file::Call_flush<self_t> call_flush_t;
+		friend call_flush_t;
+
+	protected:
+		enum SlotState {
+			slot_free = 0,
+			slot_filling,//by the main thread
+			slot_pending,
+			slot_writing//by the background thread
+		};
+
+		struct slot {
+			::std::vector<char> image;//complete file image. Capacity is reused between snapshots
+			::std::string fileName;
+			uint64_t seq{ 0 };
+			SlotState state{ slot_free };
+		};
+
+		struct src_blob {
+			const real_t* ptr;
+			ckpt_file::QWORD typeId;
+			ckpt_file::DWORD layerIdx, rows, cols;
+			ckpt_file::BYTE kind, block;
+			double beta1t, beta2t;
+		};
+		typedef ::std::vector<src_blob> src_blobs_t;
+
+		struct hlpr_collect {
+			src_blobs_t& src;
+			bool& bOk;
+
+			void _add(const nntl::layer_type_id_t tid, const nntl::layer_index_t idx, const ckpt_file::BYTE kind, const unsigned block
+				, const nntl::math::smatrix<real_t>& m, const double b1t, const double b2t)const noexcept
+			{
+				try {
+					src.push_back(src_blob{ m.data(), tid, idx, static_cast<ckpt_file::DWORD>(m.rows())
+						, static_cast<ckpt_file::DWORD>(m.cols()), kind, static_cast<ckpt_file::BYTE>(block), b1t, b2t });
+				} catch (...) {
+					bOk = false;
+				}
+			}
+
+			template<typename _L>
+			::std::enable_if_t<nntl::layer_has_gradworks<_L>::value> operator()(const _L& l)const noexcept {
+				if (!bOk || !l.has_weights()) return;
+				typedef typename _L::grad_works_t gw_t;
+				static_assert(nntl::layer_weights_blocks_cnt<_L>::value <= 256, "Too many weights blocks");
+
+				for (unsigned b = 0; b < nntl::layer_weights_blocks_cnt<_L>::value; ++b) {
+					const auto& gw = nntl::layer_gradWorks_block(l, b);
+					_add(l.get_layer_type_id(), l.get_layer_idx(), ckpt_file::bk_weights, b, nntl::layer_weights_block(l, b)
+						, static_cast<double>(gw.state_beta1t()), static_cast<double>(gw.state_beta2t()));
+					for (unsigned s = 0; s < gw_t::state_mtx_total; ++s) {
+						const auto& m = gw.get_state_mtx(static_cast<typename gw_t::StateMtx>(s));
+						if (!m.empty()) _add(l.get_layer_type_id(), l.get_layer_idx()
+							, static_cast<ckpt_file::BYTE>(ckpt_file::bk_Vw + s), b, m, 0., 0.);
+					}
+				}
+				_add_mask(l);
+			}
+			template<typename _L>
+			::std::enable_if_t<!nntl::layer_has_gradworks<_L>::value> operator()(const _L&)const noexcept {}
+
+			template<typename _L>
+			::std::enable_if_t<nntl::layer_has_prune_mask<_L>::value> _add_mask(const _L& l)const noexcept {
+				const auto& m = l.get_prune_mask();
+				if (!m.empty()) _add(l.get_layer_type_id(), l.get_layer_idx(), ckpt_file::bk_pruneMask, 0, m, 0., 0.);
+			}
+			template<typename _L>
+			::std::enable_if_t<!nntl::layer_has_prune_mask<_L>::value> _add_mask(const _L&)const noexcept {}
+		};
+
+	protected:
+		::std::mutex m_mtx;
+		::std::condition_variable m_cvIdle;
+
+		//following members are guarded by m_mtx
+		::std::array<slot, 2> m_slots;
+		uint64_t m_seq{ 0 };
+		uint64_t m_droppedCnt{ 0 };
+		ErrorCode m_bgError{ ErrorCode::Success };
+
+		src_blobs_t m_src;//used by the main thread only
+		call_flush_t m_callFlush;
+
+		bgworkers_t m_bg;//must be the last member to be destroyed first
+
+	public:
+		~checkpoint_writer()noexcept {
+			wait();
+			m_bg.delete_tasks();
+		}
+		checkpoint_writer()noexcept : m_callFlush(this), m_bg(1) {
+			m_bg.add_task(m_callFlush);
+		}
+
+		//number of snapshots that were replaced by newer snapshots before being written
+		uint64_t dropped_count()noexcept {
+			::std::lock_guard<::std::mutex> lk(m_mtx);
+			return m_droppedCnt;
+		}
+
+		//Copies weights and optimizer state of every learnable layer of lp into an idle buffer and schedules it to be
+		// written to fileName. Returns as soon as the data is copied. Safe to call from the onEpochEndCB of nnet::train().
+		template<typename LayersT>
+		ErrorCode snapshot(LayersT& lp, const char* fileName, const uint64_t epoch = 0)noexcept {
+			static_assert(::std::is_same<real_t, typename LayersT::real_t>::value, "LayersT::real_t must be the same as RealT");
+			NNTL_ASSERT(fileName && *fileName);
+
+			bool bOk = true;
+			m_src.clear();
+			lp.for_each_layer(hlpr_collect{ m_src, bOk });
+			if (!bOk) return _set_last_error(ErrorCode::MemoryAllocationFailed);
+
+			//layout
+			const size_t entriesOfs = sizeof(ckpt_file::HEADER);
+			size_t totalBytes = ckpt_file::align(entriesOfs + m_src.size() * sizeof(ckpt_file::ENTRY));
+			for (const auto& s : m_src) {
+				totalBytes = ckpt_file::align(totalBytes + sizeof(real_t)*static_cast<size_t>(s.rows)*s.cols);
+			}
+
+			slot& sl = _acquire_slot();
+			try {
+				sl.image.resize(totalBytes);
+				sl.fileName = fileName;
+			} catch (...) {
+				_release_slot(sl, slot_free);
+				return _set_last_error(ErrorCode::MemoryAllocationFailed);
+			}
+
+			char*const pImg = sl.image.data();
+			::std::memset(pImg, 0, entriesOfs + m_src.size() * sizeof(ckpt_file::ENTRY));
+			auto& hdr = *reinterpret_cast<ckpt_file::HEADER*>(pImg);
+			hdr.dwSignature = ckpt_file::HEADER::sSignature;
+			hdr.wVersionNum = ckpt_file::HEADER::sLatestVersion;
+			hdr.bDataType = ckpt_file::data_type<real_t>();
+			hdr.dwEntriesCount = static_cast<ckpt_file::DWORD>(m_src.size());
+			hdr.qwEpoch = epoch;
+			hdr.qwFileSize = totalBytes;
+
+			auto pEntry = reinterpret_cast<ckpt_file::ENTRY*>(pImg + entriesOfs);
+			size_t ofs = ckpt_file::align(entriesOfs + m_src.size() * sizeof(ckpt_file::ENTRY));
+			for (const auto& s : m_src) {
+				auto& e = *pEntry++;
+				e.qwLayerTypeId = s.typeId;
+				e.qwDataOffset = ofs;
+				e.dwLayerIdx = s.layerIdx;
+				e.dwRows = s.rows;
+				e.dwCols = s.cols;
+				e.bKind = s.kind;
+				e.bWeightsBlock = s.block;
+				e.dBeta1t = s.beta1t;
+				e.dBeta2t = s.beta2t;
+
+				const size_t bytes = sizeof(real_t)*static_cast<size_t>(s.rows)*s.cols;
+				::std::memcpy(pImg + ofs, s.ptr, bytes);
+				const size_t nextOfs = ckpt_file::align(ofs + bytes);
+				::std::memset(pImg + ofs + bytes, 0, nextOfs - ofs - bytes);
+				ofs = nextOfs;
+			}
+			NNTL_ASSERT(ofs == totalBytes);
+
+			_release_slot(sl, slot_pending);
+			return _set_last_error(ErrorCode::Success);
+		}
+
+		//blocks until every snapshot taken is written. Returns the first error the writer encountered since the
+		// previous call to wait()
+		ErrorCode wait()noexcept {
+			ErrorCode ec;
+			{
+				::std::unique_lock<::std::mutex> lk(m_mtx);
+				m_cvIdle.wait(lk, [this]() {
+					for (const auto& s : m_slots) {
+						if (slot_pending == s.state || slot_writing == s.state) return false;
+					}
+					return true;
+				});
+				ec = m_bgError;
+				m_bgError = ErrorCode::Success;
+			}
+			return _set_last_error(ec);
+		}
+
+	protected:
+		slot& _acquire_slot()noexcept {
+			::std::lock_guard<::std::mutex> lk(m_mtx);
+			slot* pS = nullptr;
+			for (auto& s : m_slots) {
+				if (slot_free == s.state) {
+					pS = &s;
+					break;
+				}
+			}
+			if (!pS) {
+				//the writer is busy with one slot, so the other must be pending. Replacing it.
+				for (auto& s : m_slots) {
+					if (slot_pending == s.state) {
+						pS = &s;
+						++m_droppedCnt;
+						break;
+					}
+				}
+			}
+			NNTL_ASSERT(pS || !"WTF? There must be a slot the writer isn't using");
+			pS->state = slot_filling;
+			return *pS;
+		}
+
+		void _release_slot(slot& s, const SlotState st)noexcept {
+			NNTL_ASSERT(slot_filling == s.state);
+			::std::lock_guard<::std::mutex> lk(m_mtx);
+			s.seq = ++m_seq;
+			s.state = st;
+		}
+
+		//executed by the background thread. Writes the oldest pending snapshot, returns false if there was nothing to do
+		bool _bg_flush()noexcept {
+			slot* pS = nullptr;
+			{
+				::std::lock_guard<::std::mutex> lk(m_mtx);
+				for (auto& s : m_slots) {
+					if (slot_pending == s.state && (!pS || s.seq < pS->seq)) pS = &s;
+				}
+				if (!pS) return false;
+				pS->state = slot_writing;
+			}
+
+			const auto ec = _write_file(pS->fileName, pS->image);
+
+			{
+				::std::lock_guard<::std::mutex> lk(m_mtx);
+				pS->state = slot_free;
+				if (ErrorCode::Success == m_bgError) m_bgError = ec;
+			}
+			m_cvIdle.notify_all();
+			return true;
+		}
+
+		static ErrorCode _write_file(const ::std::string& fileName, const ::std::vector<char>& image)noexcept {
+			::std::string tmpName;
+			try {
+				tmpName = fileName + ".tmp";
+			} catch (...) {
+				return ErrorCode::MemoryAllocationFailed;
+			}
+
+			FILE* fp = ckpt_file::fopen_write(tmpName.c_str());
+			if (!fp) return ErrorCode::FailedToOpenFile;
+
+			bool bOk = image.size() == ::std::fwrite(image.data(), 1, image.size(), fp);
+			bOk = bOk && 0 == ::std::fflush(fp) && ckpt_file::sync_file(fp);
+			bOk = (0 == ::std::fclose(fp)) && bOk;
+			if (!bOk) {
+				::std::remove(tmpName.c_str());
+				return ErrorCode::FailedToWriteData;
+			}
+			return ckpt_file::replace_file(tmpName.c_str(), fileName.c_str()) ? ErrorCode::Success : ErrorCode::FailedToReplaceFile;
+		}
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	template<typename RealT>
+	class checkpoint_reader : public nntl::_has_last_error<_checkpoint_errs> {
+		checkpoint_reader(const checkpoint_reader& other)noexcept = delete;
+		checkpoint_reader& operator=(const checkpoint_reader& rhs) noexcept = delete;
+
+		typedef checkpoint_reader<RealT> self_t;
+
+	public:
+		typedef RealT real_t;
+		typedef nntl::math::smatrix<real_t> realmtx_t;
+
+	protected:
+		mapped_file m_file;
+		const ckpt_file::HEADER* m_pHdr{ nullptr };
+		const ckpt_file::ENTRY* m_pEntries{ nullptr };
+
+		struct hlpr_restore {
+			self_t& r;
+			ErrorCode& ec;
+			ckpt_file::DWORD& nUsed;
+
+			template<typename _L>
+			::std::enable_if_t<nntl::layer_has_gradworks<_L>::value> operator()(_L& l)const noexcept {
+				if (ErrorCode::Success == ec) ec = r._restore_layer(l, nUsed);
+			}
+			template<typename _L>
+			::std::enable_if_t<!nntl::layer_has_gradworks<_L>::value> operator()(_L&)const noexcept {}
+		};
+
+	public:
+		~checkpoint_reader()noexcept { close(); }
+		checkpoint_reader()noexcept {}
+
+		bool empty()const noexcept { return !m_pHdr; }
+		uint64_t epoch()const noexcept { NNTL_ASSERT(!empty()); return m_pHdr->qwEpoch; }
+		ckpt_file::DWORD entries_count()const noexcept { return m_pHdr ? m_pHdr->dwEntriesCount : 0; }
+
+		void close()noexcept {
+			m_pHdr = nullptr;
+			m_pEntries = nullptr;
+			m_file.close();
+		}
+
+		ErrorCode open(const char* fileName)noexcept {
+			NNTL_ASSERT(fileName && *fileName);
+			close();
+			if (!m_file.open(fileName)) return _set_last_error(ErrorCode::FailedToMapFile);
+			const auto ec = _validate();
+			if (ErrorCode::Success != ec) close();
+			return _set_last_error(ec);
+		}
+
+		const ckpt_file::ENTRY* find_entry(const nntl::layer_index_t idx, const ckpt_file::BYTE kind, const unsigned block = 0)const noexcept {
+			NNTL_ASSERT(!empty());
+			for (ckpt_file::DWORD i = 0; i < m_pHdr->dwEntriesCount; ++i) {
+				const auto& e = m_pEntries[i];
+				if (e.dwLayerIdx == idx && e.bKind == kind && e.bWeightsBlock == block) return &e;
+			}
+			return nullptr;
+		}
+		const real_t* entry_data(const ckpt_file::ENTRY& e)const noexcept {
+			return reinterpret_cast<const real_t*>(m_file.data() + e.qwDataOffset);
+		}
+
+		//Restores weights of every learnable layer of lp. Optimizer state is restored only for layers whose grad_works
+		// has already been initialized (i.e. from within nnet::train(), see make_checkpoint_restorer()).
+		//Every learnable layer must have a weights entry and every entry must be used.
+		template<typename LayersT>
+		ErrorCode restore(LayersT& lp)noexcept {
+			static_assert(::std::is_same<real_t, typename LayersT::real_t>::value, "LayersT::real_t must be the same as RealT");
+			if (empty()) return _set_last_error(ErrorCode::NotOpened);
+
+			ErrorCode ec = ErrorCode::Success;
+			ckpt_file::DWORD nUsed = 0;
+			lp.for_each_layer(hlpr_restore{ *this, ec, nUsed });
+			if (ErrorCode::Success == ec && nUsed != m_pHdr->dwEntriesCount) ec = ErrorCode::UnusedEntries;
+			return _set_last_error(ec);
+		}
+
+	protected:
+		ErrorCode _validate()noexcept {
+			const auto fileSize = m_file.size();
+			if (fileSize < sizeof(ckpt_file::HEADER)) return ErrorCode::FailedToReadHeader;
+
+			const auto pHdr = reinterpret_cast<const ckpt_file::HEADER*>(m_file.data());
+			if (ckpt_file::HEADER::sSignature != pHdr->dwSignature) return ErrorCode::WrongHeaderSignature;
+			if (ckpt_file::HEADER::sLatestVersion != pHdr->wVersionNum) return ErrorCode::UnsupportedFormatVersion;
+			if (ckpt_file::data_type<real_t>() != pHdr->bDataType) return ErrorCode::UnsupportedIncorrectDataType;
+			if (pHdr->qwFileSize != fileSize
+				|| fileSize < sizeof(ckpt_file::HEADER) + sizeof(ckpt_file::ENTRY)*static_cast<size_t>(pHdr->dwEntriesCount))
+			{
+				return ErrorCode::InvalidFileSize;
+			}
+
+			const auto pEntries = reinterpret_cast<const ckpt_file::ENTRY*>(m_file.data() + sizeof(ckpt_file::HEADER));
+			for (ckpt_file::DWORD i = 0; i < pHdr->dwEntriesCount; ++i) {
+				const auto& e = pEntries[i];
+				const auto bytes = sizeof(real_t)*static_cast<ckpt_file::QWORD>(e.dwRows)*e.dwCols;
+				if (e.bKind > ckpt_file::bk_pruneMask || !bytes || e.qwDataOffset % ckpt_file::sAlignment
+					|| e.qwDataOffset > fileSize || fileSize - e.qwDataOffset < bytes)
+				{
+					return ErrorCode::InvalidEntry;
+				}
+			}
+			m_pHdr = pHdr;
+			m_pEntries = pEntries;
+			return ErrorCode::Success;
+		}
+
+		template<typename _L>
+		ErrorCode _restore_layer(_L& l, ckpt_file::DWORD& nUsed)noexcept {
+			typedef typename _L::grad_works_t gw_t;
+			static constexpr unsigned nBlocks = nntl::layer_weights_blocks_cnt<_L>::value;
+			const auto idx = l.get_layer_idx();
+
+			const ckpt_file::ENTRY* pW[nBlocks];
+			//the mapping is read-only, but W is only read from
+			realmtx_t W[nBlocks];
+			for (unsigned b = 0; b < nBlocks; ++b) {
+				pW[b] = find_entry(idx, ckpt_file::bk_weights, b);
+				if (!pW[b]) return ErrorCode::NoLayerEntry;
+				if (pW[b]->qwLayerTypeId != l.get_layer_type_id()) return ErrorCode::LayerTypeMismatch;
+				++nUsed;
+				W[b].useExternalStorage(const_cast<real_t*>(entry_data(*pW[b]))
+					, static_cast<nntl::vec_len_t>(pW[b]->dwRows), static_cast<nntl::vec_len_t>(pW[b]->dwCols));
+			}
+
+			if (l.has_weights()) {
+				for (unsigned b = 0; b < nBlocks; ++b) {
+					if (nntl::layer_weights_block(l, b).size() != W[b].size()) return ErrorCode::WeightsSizeMismatch;
+				}
+			}
+			const auto ec = _set_weights(l, W, nUsed);
+			if (ErrorCode::Success != ec) return ec;
+
+			for (unsigned b = 0; b < nBlocks; ++b) {
+				auto& gw = nntl::layer_gradWorks_block(l, b);
+				bool bStateRestored = false;
+				for (unsigned s = 0; s < gw_t::state_mtx_total; ++s) {
+					const auto pE = find_entry(idx, static_cast<ckpt_file::BYTE>(ckpt_file::bk_Vw + s), b);
+					if (!pE) continue;
+					++nUsed;
+
+					auto& m = gw.get_state_mtx(static_cast<typename gw_t::StateMtx>(s));
+					if (m.empty()) continue;//grad_works isn't initialized yet or the optimizer doesn't need this matrix
+					if (m.rows() != pE->dwRows || m.cols() != pE->dwCols) return ErrorCode::StateSizeMismatch;
+					::std::memcpy(m.data(), entry_data(*pE), m.byte_size());
+					bStateRestored = true;
+				}
+				if (bStateRestored) gw.restore_state(static_cast<real_t>(pW[b]->dBeta1t), static_cast<real_t>(pW[b]->dBeta2t));
+			}
+			return ErrorCode::Success;
+		}
+
+		template<typename _L>
+		::std::enable_if_t<nntl::layer_has_prune_mask<_L>::value, ErrorCode> _set_weights(_L& l, const realmtx_t* pW
+			, ckpt_file::DWORD& nUsed)noexcept
+		{
+			realmtx_t mask;
+			const auto pE = find_entry(l.get_layer_idx(), ckpt_file::bk_pruneMask);
+			if (pE) {
+				++nUsed;
+				if (static_cast<nntl::vec_len_t>(pE->dwRows) != pW->rows() || static_cast<nntl::vec_len_t>(pE->dwCols) != pW->cols()) return ErrorCode::WeightsSizeMismatch;
+				mask.useExternalStorage(const_cast<real_t*>(entry_data(*pE)), pW->rows(), pW->cols());
+			}
+			return l.set_weights(*pW, mask) ? ErrorCode::Success : ErrorCode::WeightsSizeMismatch;
+		}
+		template<typename _L>
+		::std::enable_if_t<!nntl::layer_has_prune_mask<_L>::value, ErrorCode> _set_weights(_L& l, const realmtx_t* pW
+			, ckpt_file::DWORD&)noexcept
+		{
+			return nntl::layer_set_weights_blocks(l, pW) ? ErrorCode::Success : ErrorCode::WeightsSizeMismatch;
+		}
+	};
+
+	//the functor to be passed as onInitCB to nnet::train(). Restores weights and optimizer state from an opened checkpoint
+	template<typename LayersT>
+	struct checkpoint_restorer {
+		LayersT& lp;
+		checkpoint_reader<typename LayersT::real_t>& reader;
+
+		nntl::_nnet_errs::ErrorCode operator()()const noexcept {
+			const auto ec = reader.restore(lp);
+			if (checkpoint_reader<typename LayersT::real_t>::ErrorCode::Success != ec) {
+				STDCOUTL("Failed to restore checkpoint: " << reader.get_last_error_str());
+				return nntl::_nnet_errs::ErrorCode::PostInitStopFromCallback;
+			}
+			return nntl::_nnet_errs::ErrorCode::Success;
+		}
+	};
+
+	template<typename LayersT>
+	checkpoint_restorer<LayersT> make_checkpoint_restorer(LayersT& lp, checkpoint_reader<typename LayersT::real_t>& reader)noexcept {
+		return checkpoint_restorer<LayersT>{lp, reader};
+	}
+}
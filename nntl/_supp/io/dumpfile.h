@@ -0,0 +1,843 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//Asynchronous archive for inspector::dumper (and anything else that saves named matrices and scalars through
+// nntl::serialization's nvp interface).
+//
+//adumpfile never touches the disk from the calling thread. Everything saved between open() and close() is copied into
+// a staging buffer taken from a bounded pool; close() hands the buffer to a background (BgWorkers) thread that
+// optionally compresses each record with a fast LZ codec and writes the file. Staging buffers' memory is reused, so
+// there are no allocations in a steady state. When every buffer is busy, open() either waits for the writer
+// (QueueFullPolicy::Block - a backpressure) or drops the whole file (QueueFullPolicy::Drop, see dropped_count()).
+// Call wait() to make sure everything is on disk and to get an error code of background writes.
+//Usage:
+//	typedef inspector::dumper<real_t, nntl_supp::adumpfile<>> myInspector;
+//	myInspector Insp("./dump_dir");
+//	Insp.getArchive().compression(true).policy(nntl_supp::dump_file::QueueFullPolicy::Block);
+//
+//File format is self-describing (see dump_file namespace): HEADER followed by dwRecordsCount records. Every record is
+// a RECORD structure followed by the record name (wNameLen chars, no terminating zero) and the record payload
+// (qwStoredBytes bytes). The payload is a column-major matrix of dwRows*dwCols elements of bDataType type, either
+// raw (bCodec==codec_none) or compressed (codec_lz). Struct nesting is flattened into dot-separated record names
+// (e.g. "lFinal.dLdA"). Use dumpfile_reader to read files back.
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../../errors.h"
+#include "../../interface/math/smatrix.h"
+#include "../../interface/threads/bgworkers.h"
+#include "../../serialization/serialization.h"
+
+namespace nntl_supp {
+
+	namespace dump_file {
+		typedef uint64_t QWORD;
+		typedef uint32_t DWORD;
+		typedef uint16_t WORD;
+		typedef uint8_t  BYTE;
+
+		enum DATA_TYPES {
+			dt_double = 0,
+			dt_float,
+			dt_int8,
+			dt_uint8,
+			dt_int16,
+			dt_uint16,
+			dt_int32,
+			dt_uint32,
+			dt_int64,
+			dt_uint64,
+			dt_bool
+		};
+
+		enum CODECS {
+			codec_none = 0,
+			codec_lz
+		};
+
+		enum class QueueFullPolicy {
+			Block,//wait until the writer frees a staging buffer
+			Drop//drop the file being opened
+		};
+
+#pragma pack(push, 1)
+		struct HEADER {
+			DWORD dwSignature;
+			WORD wVersionNum; //format version number
+			WORD wReserved;
+			DWORD dwRecordsCount;
+			DWORD dwReserved;
+
+			static constexpr DWORD sSignature = 0x70646E6Eu;//"pdnn" as a big-endian number, kept for existing files
+			static constexpr WORD sLatestVersion = 0;
+		};
+		static_assert(16 == sizeof(HEADER), "WTF??");
+
+		struct RECORD {
+			QWORD qwRawBytes;//size of the decompressed payload
+			QWORD qwStoredBytes;//size of the payload in file
+			DWORD dwRows;
+			DWORD dwCols;
+			WORD wNameLen;
+			BYTE bDataType;//DATA_TYPES
+			BYTE bCodec;//CODECS
+			DWORD dwReserved;
+		};
+		static_assert(32 == sizeof(RECORD), "WTF??");
+#pragma pack(pop)
+
+		template <typename T> struct data_type {};
+		template <> struct data_type<double> { static constexpr BYTE value = dt_double; };
+		template <> struct data_type<float> { static constexpr BYTE value = dt_float; };
+		template <> struct data_type<int8_t> { static constexpr BYTE value = dt_int8; };
+		template <> struct data_type<char> { static constexpr BYTE value = dt_int8; };
+		template <> struct data_type<uint8_t> { static constexpr BYTE value = dt_uint8; };
+		template <> struct data_type<int16_t> { static constexpr BYTE value = dt_int16; };
+		template <> struct data_type<uint16_t> { static constexpr BYTE value = dt_uint16; };
+		template <> struct data_type<int32_t> { static constexpr BYTE value = dt_int32; };
+		template <> struct data_type<uint32_t> { static constexpr BYTE value = dt_uint32; };
+		template <> struct data_type<int64_t> { static constexpr BYTE value = dt_int64; };
+		template <> struct data_type<uint64_t> { static constexpr BYTE value = dt_uint64; };
+		template <> struct data_type<bool> { static constexpr BYTE value = dt_bool; };
+
+		//////////////////////////////////////////////////////////////////////////
+		// LZ codec. A byte oriented LZ77 with LZ4-like sequences: token byte (4 bits of a literals count and 4 bits of
+		// a match length-4; 15 means that the value continues in following bytes, each adds up to 255), literals,
+		// 2 bytes little-endian offset and the match length continuation. The last sequence has literals only.
+		// It's fast and does a good job on sparse activations, masks and other data with repeating values.
+
+		static constexpr size_t lz_minMatch = 4;
+		static constexpr unsigned lz_hashLog = 12;
+
+		inline DWORD _lz_read32(const BYTE* p)noexcept {
+			DWORD v;
+			::std::memcpy(&v, p, sizeof(v));
+			return v;
+		}
+		inline DWORD _lz_hash(const DWORD v)noexcept { return (v * 2654435761u) >> (32 - lz_hashLog); }
+
+		inline bool _lz_put_len(BYTE*& op, const BYTE*const oe, size_t v)noexcept {
+			while (v >= 255) {
+				if (op >= oe) return false;
+				*op++ = 255;
+				v -= 255;
+			}
+			if (op >= oe) return false;
+			*op++ = static_cast<BYTE>(v);
+			return true;
+		}
+
+		inline bool _lz_put_seq(BYTE*& op, const BYTE*const oe, const BYTE* pLit, const size_t litLen
+			, const size_t ofs, const size_t mLen)noexcept
+		{
+			if (op >= oe) return false;
+			BYTE*const pToken = op++;
+			*pToken = static_cast<BYTE>((litLen < 15 ? litLen : 15) << 4);
+			if (litLen >= 15 && !_lz_put_len(op, oe, litLen - 15)) return false;
+			if (static_cast<size_t>(oe - op) < litLen) return false;
+			::std::memcpy(op, pLit, litLen);
+			op += litLen;
+			if (mLen) {
+				NNTL_ASSERT(mLen >= lz_minMatch && ofs > 0 && ofs <= 0xFFFF);
+				if (oe - op < 2) return false;
+				*op++ = static_cast<BYTE>(ofs & 0xFF);
+				*op++ = static_cast<BYTE>(ofs >> 8);
+				const size_t ml = mLen - lz_minMatch;
+				*pToken |= static_cast<BYTE>(ml < 15 ? ml : 15);
+				if (ml >= 15 && !_lz_put_len(op, oe, ml - 15)) return false;
+			}
+			return true;
+		}
+
+		//compresses src into dest. Returns the compressed size, or 0 if the result wouldn't fit into destCap bytes (pass
+		// destCap < srcLen to store only data that actually compresses). pTable must have (1 << lz_hashLog) elements.
+		inline size_t lz_compress(const void* src, const size_t srcLen, void* dest, const size_t destCap, DWORD* pTable)noexcept {
+			const BYTE*const s = static_cast<const BYTE*>(src);
+			BYTE* op = static_cast<BYTE*>(dest);
+			const BYTE*const oe = op + destCap;
+			//table stores position+1, 0 means empty
+			::std::memset(pTable, 0, sizeof(DWORD) << lz_hashLog);
+
+			size_t ip = 0, anchor = 0;
+			while (ip + lz_minMatch <= srcLen) {
+				const DWORD seq = _lz_read32(s + ip);
+				const DWORD h = _lz_hash(seq);
+				const size_t ref = pTable[h];
+				pTable[h] = static_cast<DWORD>(ip + 1);
+				if (ref && ip - (ref - 1) <= 0xFFFF && _lz_read32(s + ref - 1) == seq) {
+					const size_t r = ref - 1;
+					size_t mLen = lz_minMatch;
+					while (ip + mLen < srcLen && s[r + mLen] == s[ip + mLen]) ++mLen;
+					if (!_lz_put_seq(op, oe, s + anchor, ip - anchor, ip - r, mLen)) return 0;
+					ip += mLen;
+					anchor = ip;
+				} else ++ip;
+			}
+			if (!_lz_put_seq(op, oe, s + anchor, srcLen - anchor, 0, 0)) return 0;
+			return static_cast<size_t>(op - static_cast<BYTE*>(dest));
+		}
+
+		//returns true if src was decompressed into exactly destLen bytes
+		inline bool lz_decompress(const void* src, const size_t srcLen, void* dest, const size_t destLen)noexcept {
+			const BYTE* ip = static_cast<const BYTE*>(src);
+			const BYTE*const ie = ip + srcLen;
+			BYTE*const d = static_cast<BYTE*>(dest);
+			size_t op = 0;
+
+			while (ip < ie) {
+				const BYTE token = *ip++;
+				size_t litLen = token >> 4;
+				if (15 == litLen) {
+					BYTE b;
+					do {
+						if (ip >= ie) return false;
+						b = *ip++;
+						litLen += b;
+					} while (255 == b);
+				}
+				if (static_cast<size_t>(ie - ip) < litLen || destLen - op < litLen) return false;
+				::std::memcpy(d + op, ip, litLen);
+				ip += litLen;
+				op += litLen;
+				if (ip >= ie) break;//the last sequence
+
+				if (ie - ip < 2) return false;
+				const size_t ofs = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+				ip += 2;
+				if (!ofs || ofs > op) return false;
+				size_t mLen = token & 15;
+				if (15 == mLen) {
+					BYTE b;
+					do {
+						if (ip >= ie) return false;
+						b = *ip++;
+						mLen += b;
+					} while (255 == b);
+				}
+				mLen += lz_minMatch;
+				if (destLen - op < mLen) return false;
+				//matches may overlap, so copying bytewise
+				const BYTE* pM = d + op - ofs;
+				for (size_t i = 0; i < mLen; ++i) d[op + i] = pM[i];
+				op += mLen;
+			}
+			return op == destLen;
+		}
+
+		inline FILE* fopen_mode(const char* fileName, const char* mode)noexcept {
+#if defined(_MSC_VER)
+			FILE* fp = nullptr;
+			return fopen_s(&fp, fileName, mode) ? nullptr : fp;
+#else
+			return ::std::fopen(fileName, mode);
+#endif
+		}
+
+		template<class T>
+		struct Call_flush {
+			T*const ptr;
+
+			Call_flush(T*const p)noexcept :ptr(p) {}
+			bool operator()(const nntl::thread_id_t) {
+				return ptr->_bg_flush();
+			}
+		};
+	}
+
+	struct _dumpfile_errs {
+		enum ErrorCode {
+			Success = 0,
+			FailedToOpenFile,
+			FailedToReadFile,
+			WrongHeaderSignature,
+			UnsupportedFormatVersion,
+			InvalidRecord,
+			FailedToDecompress,
+			MemoryAllocationFailed,
+			FailedToWriteData,
+			NoFileOpened,
+			FileAlreadyOpened,
+			WrongState_NameAlreadySet,
+			WrongState_NoName,
+			NoStructToSave,
+			TooLongName,
+			NoSuchRecord,
+			WrongDataType
+		};
+
+		static const nntl::strchar_t* get_error_str(const ErrorCode ec) noexcept {
+			switch (ec) {
+			case Success: return NNTL_STRING("No error / success.");
+			case FailedToOpenFile: return NNTL_STRING("Failed to open file.");
+			case FailedToReadFile: return NNTL_STRING("Failed to read file.");
+			case WrongHeaderSignature: return NNTL_STRING("Wrong header signature.");
+			case UnsupportedFormatVersion: return NNTL_STRING("Unknown or unsupported format version.");
+			case InvalidRecord: return NNTL_STRING("Invalid record found. Probably the file is truncated.");
+			case FailedToDecompress: return NNTL_STRING("Failed to decompress a record.");
+			case MemoryAllocationFailed: return NNTL_STRING("Memory allocation failed.");
+			case FailedToWriteData: return NNTL_STRING("Failed to write data.");
+			case NoFileOpened: return NNTL_STRING("No file has been opened.");
+			case FileAlreadyOpened: return NNTL_STRING("Previous file must be closed first.");
+			case WrongState_NameAlreadySet: return NNTL_STRING("Wrong state, variable name has already been set.");
+			case WrongState_NoName: return NNTL_STRING("Wrong state, variable name is not set. Use nvp to pass data for saving.");
+			case NoStructToSave: return NNTL_STRING("There's no struct to save. Probably the order of save_struct_begin/save_struct_end has been permutted.");
+			case TooLongName: return NNTL_STRING("Record name is too long.");
+			case NoSuchRecord: return NNTL_STRING("There's no record with the name.");
+			case WrongDataType: return NNTL_STRING("Record data type differs from the requested.");
+
+			default: NNTL_ASSERT(!"WTF?"); return NNTL_STRING("Unknown code.");
+			}
+		}
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	template<typename SerializationOptionsEnumT = ::nntl::serialization::CommonOptions>
+	class adumpfile final
+		: public nntl::_has_last_error<_dumpfile_errs>
+		, public nntl::serialization::simple_archive<adumpfile<SerializationOptionsEnumT>, true>
+		, public nntl::utils::binary_options<SerializationOptionsEnumT>
+	{
+		adumpfile(const adumpfile& other)noexcept = delete;
+		adumpfile& operator=(const adumpfile& rhs) noexcept = delete;
+
+		typedef adumpfile<SerializationOptionsEnumT> self_t;
+
+	public:
+		typedef nntl::threads::BgWorkers<> bgworkers_t;
+		typedef dump_file::Call_flush<self_t> call_flush_t;
+		friend call_flush_t;
+
+		typedef dump_file::QueueFullPolicy QueueFullPolicy;
+
+		//the same modes as _matfile_base has. Every mode creates a new file (an existing file is overwritten)
+		enum FileOpenMode {
+			WriteDelete,
+			UpdateDelete
+		};
+
+		//file extension to use (for example, by inspector::dumper)
+		static constexpr const char* sFileExt = "ndmp";
+
+	protected:
+		enum SlotState {
+			slot_free = 0,
+			slot_filling,//by the main thread
+			slot_pending,
+			slot_writing//by the background thread
+		};
+
+		struct slot {
+			::std::vector<char> image;//records as they're stored in file with uncompressed payloads. Capacity is reused
+			::std::string fileName;
+			uint64_t seq{ 0 };
+			dump_file::DWORD recordsCount{ 0 };
+			SlotState state{ slot_free };
+		};
+
+		//the second member of a pair is a name of the parental struct, that was temporarily closed by bDontNest
+		typedef ::std::vector<::std::pair<::std::string, ::std::string>> structs_stack_t;
+
+	protected:
+		::std::mutex m_mtx;
+		::std::condition_variable m_cvFree;
+
+		//following members are guarded by m_mtx
+		::std::vector<slot> m_slots;
+		uint64_t m_seq{ 0 };
+		uint64_t m_droppedCnt{ 0 };
+		ErrorCode m_bgError{ ErrorCode::Success };
+
+		//used by the main thread only
+		slot* m_pCur{ nullptr };
+		bool m_bOpened{ false };//may be true with m_pCur==nullptr when the file is being dropped
+		const char* m_curVarName{ nullptr };
+		structs_stack_t m_structs;
+		::std::string m_nameBuf;
+
+		QueueFullPolicy m_policy{ QueueFullPolicy::Block };
+		bool m_bCompress{ true };
+
+		//used by the background thread only
+		::std::vector<char> m_compressBuf;
+		::std::vector<dump_file::DWORD> m_lzTable;
+
+		call_flush_t m_callFlush;
+
+		bgworkers_t m_bg;//must be the last member to be destroyed first
+
+	public:
+		~adumpfile()noexcept {
+			if (m_bOpened) close();
+			wait();
+			m_bg.delete_tasks();
+		}
+
+		//maxStaging is the number of staging buffers, i.e. the number of files that can be queued for writing
+		adumpfile(const unsigned maxStaging = 4)noexcept
+			: m_slots(maxStaging > 0 ? maxStaging : 1), m_callFlush(this), m_bg(1)
+		{
+			NNTL_ASSERT(maxStaging > 0);
+			this->turn_on_all_options();
+			m_bg.add_task(m_callFlush);
+		}
+
+		self_t& compression(const bool b)noexcept { m_bCompress = b; return *this; }
+		bool compression()const noexcept { return m_bCompress; }
+		self_t& policy(const QueueFullPolicy p)noexcept { m_policy = p; return *this; }
+		QueueFullPolicy policy()const noexcept { return m_policy; }
+
+		//number of files dropped due to QueueFullPolicy::Drop
+		uint64_t dropped_count()noexcept {
+			::std::lock_guard<::std::mutex> lk(m_mtx);
+			return m_droppedCnt;
+		}
+
+		bool success()const noexcept { return ErrorCode::Success == get_last_error(); }
+
+		ErrorCode open(const char* fname, FileOpenMode = FileOpenMode::WriteDelete)noexcept {
+			NNTL_ASSERT(fname && *fname);
+			if (m_bOpened) return _set_last_error(ErrorCode::FileAlreadyOpened);
+			_set_last_error(ErrorCode::Success);
+			m_curVarName = nullptr;
+			m_structs.clear();
+
+			slot* pS = _acquire_slot();
+			if (pS) {
+				try {
+					pS->fileName = fname;
+				} catch (...) {
+					_release_slot(*pS, slot_free);
+					return _set_last_error(ErrorCode::MemoryAllocationFailed);
+				}
+				pS->image.clear();
+				pS->recordsCount = 0;
+			}
+			m_pCur = pS;
+			m_bOpened = true;
+			return ErrorCode::Success;
+		}
+		ErrorCode open(const ::std::string& fname, FileOpenMode fom = FileOpenMode::WriteDelete)noexcept {
+			return open(fname.c_str(), fom);
+		}
+
+		//schedules the file for writing
+		ErrorCode close()noexcept {
+			if (!m_bOpened) return _set_last_error(ErrorCode::NoFileOpened);
+			NNTL_ASSERT(m_structs.empty() && !m_curVarName);
+			m_bOpened = false;
+			m_curVarName = nullptr;
+			m_structs.clear();
+			if (m_pCur) {
+				_release_slot(*m_pCur, success() ? slot_pending : slot_free);
+				m_pCur = nullptr;
+			}
+			return get_last_error();
+		}
+
+		//blocks until every closed file is written. Returns the first error the writer encountered since the
+		// previous call to wait()
+		ErrorCode wait()noexcept {
+			ErrorCode ec;
+			{
+				::std::unique_lock<::std::mutex> lk(m_mtx);
+				m_cvFree.wait(lk, [this]() {
+					for (const auto& s : m_slots) {
+						if (slot_pending == s.state || slot_writing == s.state) return false;
+					}
+					return true;
+				});
+				ec = m_bgError;
+				m_bgError = ErrorCode::Success;
+			}
+			return ec;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// the same structs API as _matfile_savingEx has. Structs are flattened into dot-separated names of records.
+		// bUpdateIfExist is ignored (records are always appended)
+		ErrorCode save_struct_begin(::std::string&& structName, const bool /*bUpdateIfExist*/, const bool bDontNest)noexcept {
+			if (!success()) return get_last_error();
+			if (!m_bOpened) return _set_last_error(ErrorCode::NoFileOpened);
+			if (m_curVarName) return _set_last_error(ErrorCode::WrongState_NameAlreadySet);
+			try {
+				::std::string parent;
+				if (bDontNest && !m_structs.empty()) {
+					parent = ::std::move(m_structs.back().first);
+					m_structs.pop_back();
+				}
+				m_structs.emplace_back(::std::move(structName), ::std::move(parent));
+			} catch (...) {
+				return _set_last_error(ErrorCode::MemoryAllocationFailed);
+			}
+			return ErrorCode::Success;
+		}
+		ErrorCode save_struct_end()noexcept {
+			if (!success()) return get_last_error();
+			if (m_structs.empty()) return _set_last_error(ErrorCode::NoStructToSave);
+			if (m_curVarName) return _set_last_error(ErrorCode::WrongState_NameAlreadySet);
+			::std::string parent(::std::move(m_structs.back().second));
+			m_structs.pop_back();
+			if (!parent.empty()) {
+				try {
+					m_structs.emplace_back(::std::move(parent), ::std::string());
+				} catch (...) {
+					return _set_last_error(ErrorCode::MemoryAllocationFailed);
+				}
+			}
+			return ErrorCode::Success;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// saving
+		template<class T>
+		self_t& operator<<(const ::boost::serialization::nvp< T > & t) {
+			if (!success()) return *this;
+			if (!m_bOpened) {
+				_set_last_error(ErrorCode::NoFileOpened);
+			} else if (m_curVarName) {
+				_set_last_error(ErrorCode::WrongState_NameAlreadySet);
+			} else {
+				m_curVarName = t.name();
+				*this << t.const_value();
+				NNTL_ASSERT(!m_curVarName || !success());
+				m_curVarName = nullptr;
+			}
+			return *this;
+		}
+
+		template<typename BaseT>
+		self_t& operator<<(const nntl::math::smatrix<BaseT>& t) {
+			NNTL_ASSERT(!t.empty() && t.numel() > 0);
+			_add_record(t.rows(), t.cols(), t.data(), t.byte_size(), dump_file::data_type<BaseT>::value);
+			return *this;
+		}
+		template<typename BaseT>
+		self_t& operator<<(const nntl::math::smatrix_deform<BaseT>& t) {
+			return operator<<(static_cast<const nntl::math::smatrix<BaseT>&>(t));
+		}
+
+		template<typename T>
+		::std::enable_if_t< ::std::is_arithmetic<T>::value, self_t&> operator<<(const T& t) {
+			_add_record(1, 1, &t, sizeof(T), dump_file::data_type<T>::value);
+			return *this;
+		}
+		template<typename T>
+		::std::enable_if_t< ::std::is_enum<T>::value, self_t&> operator<<(const T& t) {
+			return operator<<(static_cast<uint64_t>(t));
+		}
+		//because we've just shadowed simple_archive's operator<<, have to repeat the default code here
+		template<class T>
+		::std::enable_if_t<!::std::is_arithmetic<T>::value && !::std::is_enum<T>::value, self_t&> operator<<(T const & t) {
+			::boost::serialization::serialize_adl(*this, const_cast<T &>(t), ::boost::serialization::version< T >::value);
+			return *this;
+		}
+
+	protected:
+		void _add_record(const nntl::vec_len_t r, const nntl::vec_len_t c, const void* pData, const size_t bytesCnt
+			, const dump_file::BYTE dataType)noexcept
+		{
+			if (!m_curVarName) {
+				_set_last_error(ErrorCode::WrongState_NoName);
+				return;
+			}
+			//the file is being dropped
+			if (!m_pCur) {
+				m_curVarName = nullptr;
+				return;
+			}
+
+			try {
+				m_nameBuf.clear();
+				for (const auto& s : m_structs) {
+					m_nameBuf += s.first;
+					m_nameBuf += '.';
+				}
+				m_nameBuf += m_curVarName;
+			} catch (...) {
+				_set_last_error(ErrorCode::MemoryAllocationFailed);
+				return;
+			}
+			if (m_nameBuf.size() > 0xFFFF) {
+				_set_last_error(ErrorCode::TooLongName);
+				return;
+			}
+
+			auto& img = m_pCur->image;
+			const size_t ofs = img.size();
+			try {
+				img.resize(ofs + sizeof(dump_file::RECORD) + m_nameBuf.size() + bytesCnt);
+			} catch (...) {
+				_set_last_error(ErrorCode::MemoryAllocationFailed);
+				return;
+			}
+			dump_file::RECORD rec;
+			::std::memset(&rec, 0, sizeof(rec));
+			rec.qwRawBytes = bytesCnt;
+			rec.qwStoredBytes = bytesCnt;
+			rec.dwRows = static_cast<dump_file::DWORD>(r);
+			rec.dwCols = static_cast<dump_file::DWORD>(c);
+			rec.wNameLen = static_cast<dump_file::WORD>(m_nameBuf.size());
+			rec.bDataType = dataType;
+			rec.bCodec = dump_file::codec_none;
+
+			char* p = img.data() + ofs;
+			::std::memcpy(p, &rec, sizeof(rec));
+			p += sizeof(rec);
+			::std::memcpy(p, m_nameBuf.data(), m_nameBuf.size());
+			::std::memcpy(p + m_nameBuf.size(), pData, bytesCnt);
+
+			++m_pCur->recordsCount;
+			m_curVarName = nullptr;
+		}
+
+		//returns nullptr if the file must be dropped
+		slot* _acquire_slot()noexcept {
+			::std::unique_lock<::std::mutex> lk(m_mtx);
+			slot* pS = nullptr;
+			const auto fnFind = [this, &pS]() {
+				for (auto& s : m_slots) {
+					if (slot_free == s.state) {
+						pS = &s;
+						return true;
+					}
+				}
+				return false;
+			};
+			if (!fnFind()) {
+				if (QueueFullPolicy::Drop == m_policy) {
+					++m_droppedCnt;
+					return nullptr;
+				}
+				m_cvFree.wait(lk, fnFind);
+			}
+			NNTL_ASSERT(pS);
+			pS->state = slot_filling;
+			return pS;
+		}
+
+		void _release_slot(slot& s, const SlotState st)noexcept {
+			NNTL_ASSERT(slot_filling == s.state);
+			{
+				::std::lock_guard<::std::mutex> lk(m_mtx);
+				s.seq = ++m_seq;
+				s.state = st;
+			}
+			if (slot_free == st) m_cvFree.notify_all();
+		}
+
+		//executed by the background thread. Writes the oldest pending file, returns false if there was nothing to do
+		bool _bg_flush()noexcept {
+			slot* pS = nullptr;
+			bool bCompress;
+			{
+				::std::lock_guard<::std::mutex> lk(m_mtx);
+				for (auto& s : m_slots) {
+					if (slot_pending == s.state && (!pS || s.seq < pS->seq)) pS = &s;
+				}
+				if (!pS) return false;
+				pS->state = slot_writing;
+				bCompress = m_bCompress;
+			}
+
+			const auto ec = _write_file(*pS, bCompress);
+
+			{
+				::std::lock_guard<::std::mutex> lk(m_mtx);
+				pS->state = slot_free;
+				if (ErrorCode::Success == m_bgError) m_bgError = ec;
+			}
+			m_cvFree.notify_all();
+			return true;
+		}
+
+		ErrorCode _write_file(const slot& s, const bool bCompress)noexcept {
+			FILE* fp = dump_file::fopen_mode(s.fileName.c_str(), "wb");
+			if (!fp) return ErrorCode::FailedToOpenFile;
+
+			dump_file::HEADER hdr;
+			::std::memset(&hdr, 0, sizeof(hdr));
+			hdr.dwSignature = dump_file::HEADER::sSignature;
+			hdr.wVersionNum = dump_file::HEADER::sLatestVersion;
+			hdr.dwRecordsCount = s.recordsCount;
+			bool bOk = 1 == ::std::fwrite(&hdr, sizeof(hdr), 1, fp);
+
+			if (bCompress) {
+				try {
+					m_lzTable.resize(size_t(1) << dump_file::lz_hashLog);
+				} catch (...) {
+					bOk = false;
+				}
+			}
+
+			const char* p = s.image.data();
+			const char*const pE = p + s.image.size();
+			while (bOk && p < pE) {
+				dump_file::RECORD rec;
+				::std::memcpy(&rec, p, sizeof(rec));
+				const char*const pName = p + sizeof(rec);
+				const char*const pData = pName + rec.wNameLen;
+				const size_t rawBytes = static_cast<size_t>(rec.qwRawBytes);
+				p = pData + rawBytes;
+				NNTL_ASSERT(p <= pE);
+
+				const char* pStored = pData;
+				if (bCompress && rawBytes > 64) {
+					size_t cb = 0;
+					try {
+						if (m_compressBuf.size() < rawBytes) m_compressBuf.resize(rawBytes);
+						//storing compressed payload only if it saves at least 1/16 of the size
+						cb = dump_file::lz_compress(pData, rawBytes, m_compressBuf.data(), rawBytes - rawBytes / 16, m_lzTable.data());
+					} catch (...) {
+						cb = 0;
+					}
+					if (cb) {
+						rec.bCodec = dump_file::codec_lz;
+						rec.qwStoredBytes = cb;
+						pStored = m_compressBuf.data();
+					}
+				}
+
+				bOk = 1 == ::std::fwrite(&rec, sizeof(rec), 1, fp)
+					&& (!rec.wNameLen || 1 == ::std::fwrite(pName, rec.wNameLen, 1, fp))
+					&& (!rec.qwStoredBytes || 1 == ::std::fwrite(pStored, static_cast<size_t>(rec.qwStoredBytes), 1, fp));
+			}
+
+			bOk = (0 == ::std::fclose(fp)) && bOk;
+			return bOk ? ErrorCode::Success : ErrorCode::FailedToWriteData;
+		}
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	// reads a whole file written by adumpfile into memory (decompressing records)
+	class dumpfile_reader : public nntl::_has_last_error<_dumpfile_errs> {
+		dumpfile_reader(const dumpfile_reader& other)noexcept = delete;
+		dumpfile_reader& operator=(const dumpfile_reader& rhs) noexcept = delete;
+
+	public:
+		struct record {
+			::std::string name;
+			::std::vector<char> data;
+			dump_file::DWORD rows, cols;
+			dump_file::BYTE dataType;
+		};
+		typedef ::std::vector<record> records_t;
+
+	protected:
+		records_t m_records;
+
+	public:
+		~dumpfile_reader()noexcept {}
+		dumpfile_reader()noexcept {}
+
+		const records_t& records()const noexcept { return m_records; }
+		size_t size()const noexcept { return m_records.size(); }
+
+		//returns the first record with the name, or nullptr
+		const record* find(const char* name)const noexcept {
+			for (const auto& r : m_records) {
+				if (r.name == name) return &r;
+			}
+			return nullptr;
+		}
+
+		//copies the record into m (which is resized if necessary). m must not emulate biases, because records store
+		// whole matrices including bias columns
+		template<typename BaseT>
+		ErrorCode get(const char* name, nntl::math::smatrix<BaseT>& m)noexcept {
+			NNTL_ASSERT(!m.emulatesBiases());
+			const auto pR = find(name);
+			if (!pR) return _set_last_error(ErrorCode::NoSuchRecord);
+			if (dump_file::data_type<BaseT>::value != pR->dataType) return _set_last_error(ErrorCode::WrongDataType);
+			if (!m.resize(static_cast<nntl::vec_len_t>(pR->rows), static_cast<nntl::vec_len_t>(pR->cols)))
+				return _set_last_error(ErrorCode::MemoryAllocationFailed);
+			NNTL_ASSERT(m.byte_size() == pR->data.size());
+			::std::memcpy(m.data(), pR->data.data(), pR->data.size());
+			return _set_last_error(ErrorCode::Success);
+		}
+
+		ErrorCode read(const char* fileName)noexcept {
+			NNTL_ASSERT(fileName && *fileName);
+			m_records.clear();
+
+			FILE* fp = dump_file::fopen_mode(fileName, "rb");
+			if (!fp) return _set_last_error(ErrorCode::FailedToOpenFile);
+			const auto ec = _read(fp);
+			::std::fclose(fp);
+			if (ErrorCode::Success != ec) m_records.clear();
+			return _set_last_error(ec);
+		}
+
+	protected:
+		ErrorCode _read(FILE* fp)noexcept {
+			dump_file::HEADER hdr;
+			if (1 != ::std::fread(&hdr, sizeof(hdr), 1, fp)) return ErrorCode::FailedToReadFile;
+			if (dump_file::HEADER::sSignature != hdr.dwSignature) return ErrorCode::WrongHeaderSignature;
+			if (hdr.wVersionNum > dump_file::HEADER::sLatestVersion) return ErrorCode::UnsupportedFormatVersion;
+
+			::std::vector<char> stored;
+			try {
+				m_records.resize(hdr.dwRecordsCount);
+				for (auto& r : m_records) {
+					dump_file::RECORD rec;
+					if (1 != ::std::fread(&rec, sizeof(rec), 1, fp)) return ErrorCode::InvalidRecord;
+					if (rec.bCodec > dump_file::codec_lz || (dump_file::codec_none == rec.bCodec && rec.qwRawBytes != rec.qwStoredBytes))
+						return ErrorCode::InvalidRecord;
+
+					r.rows = rec.dwRows;
+					r.cols = rec.dwCols;
+					r.dataType = rec.bDataType;
+					r.name.resize(rec.wNameLen);
+					if (rec.wNameLen && 1 != ::std::fread(&r.name[0], rec.wNameLen, 1, fp)) return ErrorCode::InvalidRecord;
+
+					r.data.resize(static_cast<size_t>(rec.qwRawBytes));
+					if (dump_file::codec_none == rec.bCodec) {
+						if (rec.qwRawBytes && 1 != ::std::fread(r.data.data(), r.data.size(), 1, fp)) return ErrorCode::InvalidRecord;
+					} else {
+						stored.resize(static_cast<size_t>(rec.qwStoredBytes));
+						if (rec.qwStoredBytes && 1 != ::std::fread(stored.data(), stored.size(), 1, fp)) return ErrorCode::InvalidRecord;
+						if (!dump_file::lz_decompress(stored.data(), stored.size(), r.data.data(), r.data.size()))
+							return ErrorCode::FailedToDecompress;
+					}
+				}
+			} catch (...) {
+				return ErrorCode::MemoryAllocationFailed;
+			}
+			return ErrorCode::Success;
+		}
+	};
+}
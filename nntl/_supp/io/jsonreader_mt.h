@@ -0,0 +1,590 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+// jsonreader_mt reads the same json train_data files as jsonreader (see the description there), but it doesn't build
+// a DOM. The file is memory mapped, every matrix is allocated once and numbers are parsed directly into the column-major
+// storage by several threads:
+//	1. the top level object is scanned sequentially (memchr() to find closing brackets), finding a byte range of
+//		each matrix array;
+//	2. the byte range is split into chunks, each chunk counts the numbers and inner array brackets it contains (in
+//		parallel). Prefix sums over chunks give the matrix size and (column, row) of the first number of every chunk;
+//	3. every chunk parses its numbers straight into the destination matrix (in parallel).
+// So the peak memory is the mapped file (which is backed by the file itself and could be evicted by OS) plus the resulting
+// data. Parsing is done by a fast path for numbers with at most 15 significant digits and a small exponent (exactly
+// rounded), other numbers fall back to ::std::strtod() (which assumes the "C" locale).
+//
+// Only a subset of json is expected in matrix arrays: numbers, commas and whitespace. Other top level members are skipped.
+//
+// USAGE:
+//	jsonreader_mt reader;
+//	const auto ec = reader.read(fname, td, iMath.ithreads());
+// or to convert the file for fast loads later
+//	reader.convert2bin<float>(jsonFName, binFName, iMath.ithreads());
+
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "../../errors.h"
+#include "../../train_data.h"
+#include "mapped_file.h"
+#include "binfile.h"
+
+namespace nntl_supp {
+
+	struct _jsonreader_mt_errs {
+		enum ErrorCode {
+			Success = 0,
+			FailedToOpenFile,
+			FailedToParseJson,
+			RootIsNotAnObject,
+
+			NoTrainX,//ATTN: it's required that order of any trainx, trainy, testx and testy members remains constant
+			NoTrainY,
+			NoTestX,
+			NoTestY,
+
+			InvalidTrainX,
+			InvalidTrainY,
+			InvalidTestX,
+			InvalidTestY,
+
+			MismatchingDataLength,
+			MemoryAllocationFailed,
+			FailedToWriteBinfile
+		};
+
+		static const nntl::strchar_t* get_error_str(const ErrorCode ec) noexcept {
+			switch (ec) {
+			case Success: return NNTL_STRING("No error / success.");
+			case FailedToOpenFile: return NNTL_STRING("Failed to open or map file.");
+			case FailedToParseJson: return NNTL_STRING("Failed to parse json file.");
+			case RootIsNotAnObject: return NNTL_STRING("Parsed JSON: Root is not an object.");
+
+			case NoTrainX: return NNTL_STRING("There is no required 'train_x' field.");
+			case NoTrainY: return NNTL_STRING("There is no required 'train_y' field.");
+			case NoTestX: return NNTL_STRING("There is no required 'test_x' field.");
+			case NoTestY: return NNTL_STRING("There is no required 'test_y' field.");
+
+			case InvalidTrainX: return NNTL_STRING("Invalid 'train_x' field.");
+			case InvalidTrainY: return NNTL_STRING("Invalid 'train_y' field.");
+			case InvalidTestX: return NNTL_STRING("Invalid 'test_x' field.");
+			case InvalidTestY: return NNTL_STRING("Invalid 'test_y' field.");
+
+			case MismatchingDataLength: return NNTL_STRING("Invalid data length");
+			case MemoryAllocationFailed: return NNTL_STRING("Not Enough Memory");
+			case FailedToWriteBinfile: return NNTL_STRING("Failed to write binfile");
+
+			default: NNTL_ASSERT(!"WTF?"); return NNTL_STRING("Unknown code.");
+			}
+		}
+	};
+
+	class jsonreader_mt : public nntl::_has_last_error<_jsonreader_mt_errs>, protected nntl::math::smatrix_td {
+	public:
+		typedef ::nntl::numel_cnt_t numel_cnt_t;
+		template<typename T_> using smatrix = nntl::math::smatrix<T_>;
+		template<typename T_> using smatrix_deform = nntl::math::smatrix_deform<T_>;
+		template<typename TX, typename TY> using train_data = ::nntl::inmem_train_data_stor<TX, TY>;
+
+	protected:
+		template<typename T>
+		struct _is_allowed_w_value_type : public ::std::conditional_t<::nntl::utils::has_value_type<T>::value
+			, ::std::is_same<smatrix<typename T::value_type>, T>, ::std::false_type> {};
+		template<typename T>
+		struct _is_train_data_derived : public ::std::is_base_of<train_data<typename T::x_t, typename T::y_t>, T> {};
+
+		enum _root_members {
+			train_x = 0,
+			train_y,
+			test_x,
+			test_y,
+			total_members
+		};
+
+		struct _chunk {
+			const char* pBeg;
+			const char* pEnd;
+			numel_cnt_t nums, tailNums;//total count of numbers and count of numbers after the last '['
+			numel_cnt_t opens, closes;
+			numel_cnt_t startCol, startRow;//position of the first number of the chunk
+			const char* pError;
+		};
+
+		struct _array_descr {
+			const char* pBeg;//points to the opening '['
+			const char* pEnd;//points right after the closing ']'
+			bool bNested;//array of arrays
+		};
+
+		//////////////////////////////////////////////////////////////////////////
+		//members
+	public:
+		//chunks smaller than this aren't worth a separate thread
+		size_t m_minChunkBytes;
+
+	protected:
+		mapped_file m_file;
+		size_t m_errorOffset;
+		::std::vector<_chunk> m_chunks;
+
+	public:
+		~jsonreader_mt()noexcept {}
+		jsonreader_mt()noexcept : nntl::_has_last_error<_jsonreader_mt_errs>(), m_minChunkBytes(1024 * 1024), m_errorOffset(0) {}
+
+		// reads fname into dest, which can be either nntl::train_data or nntl::train_data::mtx_t (then it reads train_x only).
+		// If readInto_t == nntl::train_data, then all X data will be created with emulateBiases() feature and bMakeMtxBiased
+		// param will be ignored
+		template <typename readInto_t, typename iThreadsT>
+		const ErrorCode read(const char* fname, readInto_t& dest, iThreadsT& iT, const bool bMakeMtxBiased = false)noexcept {
+			static_assert(::std::conditional_t<::nntl::utils::has_x_t_and_y_t<readInto_t>::value
+				, _is_train_data_derived<readInto_t>, _is_allowed_w_value_type<readInto_t>>::value
+				, "Only nntl::train_data or nntl::train_data::mtx_t is supported as readInto_t template parameter");
+
+			m_errorOffset = 0;
+			if (!m_file.open(fname)) return _set_last_error(ErrorCode::FailedToOpenFile);
+			const auto ec = _read(dest, iT, bMakeMtxBiased);
+			m_file.close();
+			return ec;
+		}
+
+		//reads json file and writes it as binfile with data of type T_
+		template <typename T_, typename iThreadsT>
+		const ErrorCode convert2bin(const char* jsonFName, const char* binFName, iThreadsT& iT)noexcept {
+			train_data<T_, T_> td;
+			const auto ec = read(jsonFName, td, iT);
+			if (ErrorCode::Success != ec) return ec;
+
+			binfile bf;
+			return _set_last_error(binfile::ErrorCode::Success == bf.write(binFName, td)
+				? ErrorCode::Success : ErrorCode::FailedToWriteBinfile);
+		}
+
+		::std::string get_last_error_string()const noexcept {
+			::std::string les(get_last_error_str());
+			if (ErrorCode::FailedToParseJson == get_last_error() || (get_last_error() >= ErrorCode::InvalidTrainX
+				&& get_last_error() <= ErrorCode::InvalidTestY))
+			{
+				les = les + " Offset: " + ::std::to_string(m_errorOffset);
+			}
+			return les;
+		}
+		size_t get_error_offset()const noexcept { return m_errorOffset; }
+
+	protected:
+		inline static const char* _get_root_member_str(const _root_members m)noexcept {
+			switch (m) {
+			case train_x:return "train_x";
+			case train_y:return "train_y";
+			case test_x:return "test_x";
+			case test_y:return "test_y";
+			default:
+				NNTL_ASSERT(!"Cant be here!");
+				abort();
+			}
+		}
+
+		ErrorCode _parse_error(const char* p)noexcept {
+			m_errorOffset = static_cast<size_t>(p - m_file.data());
+			return _set_last_error(ErrorCode::FailedToParseJson);
+		}
+		ErrorCode _invalid_member(const _root_members m, const char* p)noexcept {
+			m_errorOffset = static_cast<size_t>(p - m_file.data());
+			return _set_last_error(static_cast<ErrorCode>(static_cast<int>(ErrorCode::InvalidTrainX) + static_cast<int>(m)));
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// top level structure
+
+		template<typename TX, typename TY, typename iThreadsT>
+		ErrorCode _read(train_data<TX, TY>& dest, iThreadsT& iT, const bool)noexcept {
+			_array_descr arrs[total_members];
+			auto ec = _scan_root(arrs, total_members);
+			if (ErrorCode::Success != ec) return ec;
+
+			smatrix_deform<TX> tr_x, t_x;
+			smatrix_deform<TY> tr_y, t_y;
+			tr_x.will_emulate_biases();
+			t_x.will_emulate_biases();
+
+			if (ErrorCode::Success != (ec = _parse_array(arrs[train_x], train_x, tr_x, iT))) return ec;
+			if (ErrorCode::Success != (ec = _parse_array(arrs[train_y], train_y, tr_y, iT))) return ec;
+			if (ErrorCode::Success != (ec = _parse_array(arrs[test_x], test_x, t_x, iT))) return ec;
+			if (ErrorCode::Success != (ec = _parse_array(arrs[test_y], test_y, t_y, iT))) return ec;
+
+			tr_x.update_on_hidden_resize();
+			tr_y.update_on_hidden_resize();
+			t_x.update_on_hidden_resize();
+			t_y.update_on_hidden_resize();
+
+			if (!dest.absorb(::std::move(tr_x), ::std::move(tr_y), ::std::move(t_x), ::std::move(t_y))) {
+				return _set_last_error(ErrorCode::MismatchingDataLength);
+			}
+			return _set_last_error(ErrorCode::Success);
+		}
+
+		template<typename T_, typename iThreadsT>
+		ErrorCode _read(smatrix<T_>& dest, iThreadsT& iT, const bool bMakeMtxBiased)noexcept {
+			_array_descr arrs[total_members];
+			auto ec = _scan_root(arrs, train_x + 1);
+			if (ErrorCode::Success != ec) return ec;
+
+			if (bMakeMtxBiased) dest.will_emulate_biases();
+			if (ErrorCode::Success != (ec = _parse_array(arrs[train_x], train_x, dest, iT))) return ec;
+			return _set_last_error(ErrorCode::Success);
+		}
+
+		static bool _is_ws(const char c)noexcept { return ' ' == c || '\n' == c || '\r' == c || '\t' == c; }
+		static const char* _skip_ws(const char* p, const char*const pEnd)noexcept {
+			while (p < pEnd && _is_ws(*p)) ++p;
+			return p;
+		}
+
+		//p points to the opening '"'. Returns pointer right after the closing '"' or nullptr
+		static const char* _skip_string(const char* p, const char*const pEnd)noexcept {
+			NNTL_ASSERT('"' == *p);
+			for (++p; p < pEnd; ++p) {
+				if ('\\' == *p) ++p;
+				else if ('"' == *p) return p + 1;
+			}
+			return nullptr;
+		}
+
+		//skips any json value. Returns pointer right after the value or nullptr
+		static const char* _skip_value(const char* p, const char*const pEnd)noexcept {
+			int depth = 0;
+			do {
+				p = _skip_ws(p, pEnd);
+				if (p >= pEnd) return nullptr;
+				switch (*p) {
+				case '"':
+					if (!(p = _skip_string(p, pEnd))) return nullptr;
+					break;
+				case '[':
+				case '{':
+					++depth;
+					++p;
+					break;
+				case ']':
+				case '}':
+					if (--depth < 0) return nullptr;
+					++p;
+					break;
+				case ',':
+				case ':':
+					++p;
+					break;
+				default://numbers and literals
+					while (p < pEnd && !_is_ws(*p) && ',' != *p && ':' != *p && ']' != *p && '}' != *p) ++p;
+					break;
+				}
+			} while (depth > 0);
+			return p;
+		}
+
+		//p points to the opening '[' of a matrix array. Finds the end of the array
+		static bool _find_array_end(const char* p, const char*const pEnd, _array_descr& ad)noexcept {
+			NNTL_ASSERT('[' == *p);
+			ad.pBeg = p;
+			p = _skip_ws(p + 1, pEnd);
+			if (p >= pEnd) return false;
+			ad.bNested = ('[' == *p);
+			while (true) {
+				//there're only numbers inside innermost arrays, so the next ']' must be the closing one
+				p = static_cast<const char*>(::std::memchr(p, ']', pEnd - p));
+				if (!p) return false;
+				if (!ad.bNested) break;
+
+				p = _skip_ws(p + 1, pEnd);
+				if (p >= pEnd) return false;
+				if (']' == *p) break;
+				if (',' != *p) return false;
+				p = _skip_ws(p + 1, pEnd);
+				if (p >= pEnd || '[' != *p) return false;
+			}
+			ad.pEnd = p + 1;
+			return true;
+		}
+
+		//the first requiredCnt of _root_members must be present
+		ErrorCode _scan_root(_array_descr(&arrs)[total_members], const int requiredCnt)noexcept {
+			for (auto& a : arrs) a.pBeg = nullptr;
+
+			const char*const pFileEnd = m_file.data() + m_file.size();
+			const char* p = _skip_ws(m_file.data(), pFileEnd);
+			if (p >= pFileEnd || '{' != *p) return _set_last_error(ErrorCode::RootIsNotAnObject);
+			p = _skip_ws(p + 1, pFileEnd);
+			if (p < pFileEnd && '}' == *p) ++p;
+			else {
+				while (true) {
+					if (p >= pFileEnd || '"' != *p) return _parse_error(p);
+					const char*const pKey = p + 1;
+					if (!(p = _skip_string(p, pFileEnd))) return _parse_error(pKey);
+					const size_t keyLen = static_cast<size_t>(p - 1 - pKey);
+
+					p = _skip_ws(p, pFileEnd);
+					if (p >= pFileEnd || ':' != *p) return _parse_error(p);
+					p = _skip_ws(p + 1, pFileEnd);
+					if (p >= pFileEnd) return _parse_error(p);
+
+					int memberId = total_members;
+					for (int i = 0; i < total_members; ++i) {
+						const char*const pName = _get_root_member_str(static_cast<_root_members>(i));
+						if (keyLen == ::std::strlen(pName) && 0 == ::std::memcmp(pKey, pName, keyLen)) {
+							memberId = i;
+							break;
+						}
+					}
+
+					if (total_members == memberId) {
+						if (!(p = _skip_value(p, pFileEnd))) return _parse_error(pKey);
+					} else {
+						const auto m = static_cast<_root_members>(memberId);
+						if ('[' != *p || !_find_array_end(p, pFileEnd, arrs[m])) return _invalid_member(m, p);
+						p = arrs[m].pEnd;
+					}
+
+					p = _skip_ws(p, pFileEnd);
+					if (p >= pFileEnd) return _parse_error(p);
+					if ('}' == *p) break;
+					if (',' != *p) return _parse_error(p);
+					p = _skip_ws(p + 1, pFileEnd);
+				}
+			}
+
+			for (int i = 0; i < requiredCnt; ++i) {
+				if (!arrs[i].pBeg) return _set_last_error(static_cast<ErrorCode>(static_cast<int>(ErrorCode::NoTrainX) + i));
+			}
+			return ErrorCode::Success;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// numbers
+
+		static bool _is_num_char(const char c)noexcept {
+			return (c >= '0' && c <= '9') || '-' == c || '.' == c || 'e' == c || 'E' == c || '+' == c;
+		}
+		static bool _is_digit(const char c)noexcept { return c >= '0' && c <= '9'; }
+
+		//parses a json number starting at p. Returns pointer right after the number or nullptr on error.
+		static const char* _parse_number(const char* p, const char*const pEnd, double& v)noexcept {
+			static constexpr double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11
+				, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+			static constexpr int maxFastDigits = 15;
+
+			const char*const pStart = p;
+			const bool bNeg = ('-' == *p);
+			if (bNeg) ++p;
+			if (p >= pEnd || !_is_digit(*p)) return nullptr;
+
+			uint64_t mant = 0;
+			int nDigits = 0, exp10 = 0;
+			bool bSlow = false;
+			while (p < pEnd && _is_digit(*p)) {
+				if (nDigits < maxFastDigits) {
+					mant = mant * 10 + static_cast<unsigned>(*p - '0');
+					if (mant) ++nDigits;
+				} else bSlow = true;
+				++p;
+			}
+			if (p < pEnd && '.' == *p) {
+				++p;
+				if (p >= pEnd || !_is_digit(*p)) return nullptr;
+				while (p < pEnd && _is_digit(*p)) {
+					if (nDigits < maxFastDigits) {
+						mant = mant * 10 + static_cast<unsigned>(*p - '0');
+						if (mant) ++nDigits;
+						--exp10;
+					} else if ('0' != *p) bSlow = true;
+					++p;
+				}
+			}
+			if (p < pEnd && ('e' == *p || 'E' == *p)) {
+				++p;
+				bool bExpNeg = false;
+				if (p < pEnd && ('-' == *p || '+' == *p)) bExpNeg = ('-' == *p++);
+				if (p >= pEnd || !_is_digit(*p)) return nullptr;
+				int e = 0;
+				while (p < pEnd && _is_digit(*p)) {
+					if (e < 100000) e = e * 10 + (*p - '0');
+					++p;
+				}
+				exp10 += bExpNeg ? -e : e;
+			}
+
+			if (!bSlow && exp10 >= -22 && exp10 <= 22) {
+				//mant < 10^15 < 2^53 is exact, as well as pow10[], so the result is correctly rounded
+				const double m = static_cast<double>(mant);
+				v = exp10 < 0 ? m / pow10[-exp10] : m * pow10[exp10];
+				if (bNeg) v = -v;
+			} else v = ::std::strtod(pStart, nullptr);
+			return p;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// matrices
+
+		void _chunk_count(_chunk& c)noexcept {
+			numel_cnt_t nums = 0, tailNums = 0, opens = 0, closes = 0;
+			for (const char* p = c.pBeg; p < c.pEnd; ++p) {
+				const char ch = *p;
+				if ('[' == ch) {
+					++opens;
+					tailNums = 0;
+				} else if (']' == ch) {
+					++closes;
+				} else if (_is_num_char(ch) && !_is_num_char(p[-1])) {
+					++nums;
+					++tailNums;
+				}
+			}
+			c.nums = nums;
+			c.tailNums = tailNums;
+			c.opens = opens;
+			c.closes = closes;
+		}
+
+		template<typename T_>
+		void _chunk_parse(_chunk& c, T_*const pDest, const numel_cnt_t rows, const numel_cnt_t cols, const bool bNested)noexcept {
+			const char*const pFileEnd = m_file.data() + m_file.size();
+			numel_cnt_t col = c.startCol, row = c.startRow;
+			const char* p = c.pBeg;
+			while (p < c.pEnd) {
+				const char ch = *p;
+				if (_is_ws(ch) || ',' == ch) {
+					++p;
+				} else if (_is_num_char(ch)) {
+					if (p == c.pBeg && _is_num_char(p[-1])) {
+						//the number belongs to the previous chunk
+						while (p < c.pEnd && _is_num_char(*p)) ++p;
+						continue;
+					}
+					if (col < 0 || col >= cols || row >= rows) break;
+					double v;
+					const char*const pNext = _parse_number(p, pFileEnd, v);
+					if (!pNext) break;
+					pDest[col*rows + row] = static_cast<T_>(v);
+					++row;
+					p = pNext;
+				} else if (bNested && '[' == ch) {
+					++col;
+					row = 0;
+					++p;
+				} else if (bNested && ']' == ch) {
+					if (row != rows) break;
+					++p;
+				} else break;
+			}
+			c.pError = p < c.pEnd ? p : nullptr;
+		}
+
+		template<typename T_, typename iThreadsT>
+		ErrorCode _parse_array(const _array_descr& ad, const _root_members memberId, smatrix<T_>& dest, iThreadsT& iT)noexcept {
+			typedef typename iThreadsT::range_t range_t;
+			typedef typename iThreadsT::par_range_t par_range_t;
+
+			//contents between outer brackets
+			const char*const pBeg = ad.pBeg + 1;
+			const char*const pEnd = ad.pEnd - 1;
+			const size_t totBytes = static_cast<size_t>(pEnd - pBeg);
+
+			const size_t nChunks = ::std::max(size_t(1), ::std::min(totBytes / ::std::max(m_minChunkBytes, size_t(1))
+				, static_cast<size_t>(iT.cur_workers_count()) * 4));
+			try {
+				m_chunks.resize(nChunks);
+			} catch (...) {
+				return _set_last_error(ErrorCode::MemoryAllocationFailed);
+			}
+			for (size_t i = 0; i < nChunks; ++i) {
+				auto& c = m_chunks[i];
+				c.pBeg = pBeg + (totBytes * i) / nChunks;
+				c.pEnd = pBeg + (totBytes * (i + 1)) / nChunks;
+				c.pError = nullptr;
+			}
+
+			iT.run([this](const par_range_t& r)noexcept {
+				const auto last = r.offset() + r.cnt();
+				for (auto i = r.offset(); i < last; ++i) _chunk_count(m_chunks[static_cast<size_t>(i)]);
+			}, static_cast<range_t>(nChunks));
+
+			//prefix sums
+			numel_cnt_t col = ad.bNested ? -1 : 0, row = 0, totNums = 0, totOpens = 0, totCloses = 0;
+			for (auto& c : m_chunks) {
+				c.startCol = col;
+				c.startRow = row;
+				if (c.opens) {
+					col += c.opens;
+					row = c.tailNums;
+				} else row += c.nums;
+				totNums += c.nums;
+				totOpens += c.opens;
+				totCloses += c.closes;
+			}
+
+			numel_cnt_t rows, cols;
+			if (ad.bNested) {
+				cols = totOpens;
+				if (cols <= 0 || totOpens != totCloses || totNums % cols) return _invalid_member(memberId, ad.pBeg);
+				rows = totNums / cols;
+			} else {
+				if (totOpens || totCloses) return _invalid_member(memberId, ad.pBeg);
+				rows = totNums;
+				cols = 1;
+			}
+			if (rows <= 0 || rows > ::std::numeric_limits<vec_len_t>::max() || cols > ::std::numeric_limits<vec_len_t>::max()) {
+				return _invalid_member(memberId, ad.pBeg);
+			}
+
+			if (!dest.resize(static_cast<vec_len_t>(rows), static_cast<vec_len_t>(cols))) {
+				return _set_last_error(ErrorCode::MemoryAllocationFailed);
+			}
+
+			T_*const pDest = dest.data();
+			const bool bNested = ad.bNested;
+			iT.run([this, pDest, rows, cols, bNested](const par_range_t& r)noexcept {
+				const auto last = r.offset() + r.cnt();
+				for (auto i = r.offset(); i < last; ++i) _chunk_parse(m_chunks[static_cast<size_t>(i)], pDest, rows, cols, bNested);
+			}, static_cast<range_t>(nChunks));
+
+			for (const auto& c : m_chunks) {
+				if (c.pError) {
+					dest.clear();
+					return _invalid_member(memberId, c.pError);
+				}
+			}
+			return ErrorCode::Success;
+		}
+	};
+
+}
@@ -0,0 +1,123 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//mapped_file maps a whole file into memory read-only (mmap() on POSIX, MapViewOfFile() on Windows).
+//Used by the checkpoint reader and the multithreaded json reader.
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "../../common.h"
+
+namespace nntl_supp {
+
+	//read-only memory mapping of a whole file
+	class mapped_file {
+		mapped_file(const mapped_file& other)noexcept = delete;
+		mapped_file& operator=(const mapped_file& rhs) noexcept = delete;
+
+	protected:
+		const char* m_ptr{ nullptr };
+		size_t m_bytes{ 0 };
+#if defined(_WIN32)
+		HANDLE m_hFile{ INVALID_HANDLE_VALUE }, m_hMap{ nullptr };
+#endif
+
+	public:
+		~mapped_file()noexcept { close(); }
+		mapped_file()noexcept {}
+
+		const char* data()const noexcept { return m_ptr; }
+		size_t size()const noexcept { return m_bytes; }
+		bool empty()const noexcept { return !m_ptr; }
+
+		bool open(const char* fileName)noexcept {
+			close();
+#if defined(_WIN32)
+			m_hFile = ::CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING
+				, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (INVALID_HANDLE_VALUE == m_hFile) return false;
+			LARGE_INTEGER fs;
+			if (!::GetFileSizeEx(m_hFile, &fs) || fs.QuadPart <= 0) {
+				close();
+				return false;
+			}
+			m_hMap = ::CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!m_hMap) {
+				close();
+				return false;
+			}
+			m_ptr = static_cast<const char*>(::MapViewOfFile(m_hMap, FILE_MAP_READ, 0, 0, 0));
+			if (!m_ptr) {
+				close();
+				return false;
+			}
+			m_bytes = static_cast<size_t>(fs.QuadPart);
+#else
+			const int fd = ::open(fileName, O_RDONLY);
+			if (fd < 0) return false;
+			struct stat st;
+			if (0 != ::fstat(fd, &st) || st.st_size <= 0) {
+				::close(fd);
+				return false;
+			}
+			void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);//the mapping holds its own reference to the file
+			if (MAP_FAILED == p) return false;
+			m_ptr = static_cast<const char*>(p);
+			m_bytes = static_cast<size_t>(st.st_size);
+#endif
+			return true;
+		}
+
+		void close()noexcept {
+#if defined(_WIN32)
+			if (m_ptr) ::UnmapViewOfFile(m_ptr);
+			if (m_hMap) ::CloseHandle(m_hMap);
+			if (INVALID_HANDLE_VALUE != m_hFile) ::CloseHandle(m_hFile);
+			m_hMap = nullptr;
+			m_hFile = INVALID_HANDLE_VALUE;
+#else
+			if (m_ptr) ::munmap(const_cast<char*>(m_ptr), m_bytes);
+#endif
+			m_ptr = nullptr;
+			m_bytes = 0;
+		}
+	};
+}
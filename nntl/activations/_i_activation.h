@@ -139,6 +139,18 @@ namespace activation {
 			IN OUT typename iMath::realmtx_t& act_dLdZ, iMath& m) noexcept;
 	};
 
+	//an output activation may optionally define a pair of static functions that fuse f() with dLdZ() and with loss():
+	// void f_dLdZ(const realmtx_t& data_y, realmtx_t& Z2dLdZ, iMath& m) and real_t f_loss(realmtx_t& Z2act, const realmtx_t& data_y, iMath& m)
+	// Both take preactivations Z. layer_output uses them to skip f() during fprop() when its result is needed only to
+	// compute dL/dZ or the loss value.
+	template< class, class = ::std::void_t<> >
+	struct has_fused_loss : ::std::false_type { };
+	template< class ActT >
+	struct has_fused_loss<ActT, ::std::void_t<
+		decltype(ActT::f_dLdZ(::std::declval<const typename ActT::realmtx_t&>(), ::std::declval<typename ActT::realmtx_t&>(), ::std::declval<int&>()))
+		, decltype(ActT::f_loss(::std::declval<typename ActT::realmtx_t&>(), ::std::declval<const typename ActT::realmtx_t&>(), ::std::declval<int&>()))
+	> > : ::std::true_type {};
+
 	template<typename RealT>
 	class _i_quadratic_loss : public _i_activation_loss<RealT> {
 	public:
@@ -47,7 +47,7 @@ namespace activation {
 	template<typename ActT>
 	using is_activation_identity = is_type_of<ActT, type_identity>;
 
-	template<typename RealT = d_interfaces::real_t
+	template<typename RealT = math::d_real_t
 		, typename WeightsInitScheme = weights_init::SNNInit>
 		class identity
 		: public _i_activation<RealT, WeightsInitScheme, true>
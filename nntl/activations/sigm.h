@@ -43,7 +43,7 @@ namespace activation {
 	//////////////////////////////////////////////////////////////////////////
 	//////////////////////////////////////////////////////////////////////////
 	//sigmoid
-	template<typename RealT = d_interfaces::real_t
+	template<typename RealT = math::d_real_t
 		, typename WeightsInitScheme = weights_init::Martens_SI_sigm<>>
 	class sigm
 		: public _i_activation<RealT, WeightsInitScheme, false>
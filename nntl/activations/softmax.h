@@ -80,6 +80,21 @@ namespace activation {
 			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
 			return m.loss_softmax_xentropy(activations, data_y);
 		}
+
+		//fused versions of f()+dLdZ() and f()+loss(). They take preactivations instead of activations (i.e. f() mustn't
+		//be applied beforehand) and need no temporary memory. See activation::has_fused_loss<>
+		template <typename iMath>
+		static void f_dLdZ(const realmtx_t& data_y, realmtx_t& Z2dLdZ, iMath& m)noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!Z2dLdZ.emulatesBiases() && !data_y.emulatesBiases());
+			m.softmax_xentropy_dLdZ(Z2dLdZ, data_y);
+		}
+		template <typename iMath>
+		static real_t f_loss(realmtx_t& Z2act, const realmtx_t& data_y, iMath& m)noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!Z2act.emulatesBiases() && !data_y.emulatesBiases());
+			return m.softmax_xentropy_loss(Z2act, data_y);
+		}
 	};
 
 }
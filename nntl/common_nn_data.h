@@ -85,6 +85,16 @@ namespace _impl {
 
 		bool m_bInTraining;
 
+		//set by layer_pack_vertical when it recomputes fprop() of checkpointed layers during bprop(). Layers must reproduce
+		// the same activations as during the original fprop() then (i.e. reuse dropout masks, don't apply momentum to
+		// weights and so on). Mutable because layers have only const access to common data.
+		mutable bool m_bRecomputingFProp{ false };
+
+		//gradient accumulation over micro-batches (see nnet_train_opts::gradAccumSteps()). m_gradAccumSteps is the setting
+		// (grad_works allocate accumulators if it's >1), m_gradAccumIdx is the index of the current micro-batch within
+		// the current effective batch of m_gradAccumCnt micro-batches. Both are maintained by nnet::train() only.
+		unsigned m_gradAccumSteps{ 1 }, m_gradAccumIdx{ 0 }, m_gradAccumCnt{ 1 };
+
 		//////////////////////////////////////////////////////////////////////////
 		// methods
 	public:
@@ -149,6 +159,30 @@ namespace _impl {
 		void set_training_mode(bool bTraining)noexcept { m_bInTraining = bTraining; }
 		bool is_training_mode()const noexcept { return m_bInTraining; }
 
+		bool is_recomputing_fprop()const noexcept { return m_bRecomputingFProp; }
+		void _set_recomputing_fprop(const bool b)const noexcept {
+			NNTL_ASSERT(!b || m_bInTraining);
+			m_bRecomputingFProp = b;
+		}
+
+		unsigned grad_accum_steps()const noexcept { return m_gradAccumSteps; }
+		bool is_accumulating_grad()const noexcept { return m_gradAccumSteps > 1; }
+		unsigned grad_accum_idx()const noexcept { return m_gradAccumIdx; }
+		unsigned grad_accum_cnt()const noexcept { return m_gradAccumCnt; }
+		bool is_first_grad_accum_step()const noexcept { return 0 == m_gradAccumIdx; }
+		bool is_last_grad_accum_step()const noexcept { return m_gradAccumIdx + 1 == m_gradAccumCnt; }
+
+		void _set_grad_accum_steps(const unsigned n)noexcept {
+			NNTL_ASSERT(n > 0);
+			m_gradAccumSteps = n;
+			_set_grad_accum_step(0, 1);
+		}
+		void _set_grad_accum_step(const unsigned idx, const unsigned cnt)noexcept {
+			NNTL_ASSERT(cnt > 0 && idx < cnt && cnt <= m_gradAccumSteps);
+			m_gradAccumIdx = idx;
+			m_gradAccumCnt = cnt;
+		}
+
 		//#ATTENTION see notes for batch size related member vars of this class!!
 		//returns false if the same mode&batch has already been set
 		bool set_mode_and_batch_size(const bool bTraining, const vec_len_t BatchSize)noexcept {
@@ -281,15 +315,16 @@ namespace _impl {
 
 	public:
 		//restoring types visibility
-		using _base_class::interfaces_t;
-		using _base_class::iMath_t;
-		using _base_class::iRng_t;
-		using _base_class::iThreads_t;
-		using _base_class::iInspect_t;
-		using _base_class::real_t;
+		using typename _base_class::interfaces_t;
+		using typename _base_class::iMath_t;
+		using typename _base_class::iRng_t;
+		using typename _base_class::iThreads_t;
+		using typename _base_class::iInspect_t;
+		using typename _base_class::real_t;
 
-		using _base_class::mtx_size_t;
-		using _base_class::mtx_coords_t;
+		using typename _base_class::mtx_size_t;
+		using typename _base_class::mtx_coords_t;
+		using _base_class::bAllowToBlockLearning;
 
 		typedef common_nn_data<interfaces_t> common_data_t;
 
@@ -373,12 +408,12 @@ namespace _impl {
 		::std::enable_if_t<B, void> _unblockLearning() noexcept { m_bLearningBlockedFlag = false; }
 
 		template<bool B = bAllowToBlockLearning>
-		::std::enable_if_t<!B, static void> _blockLearning() noexcept {
-			static_assert(false, "this feature is designed to be used with a numeric gradient check!");
+		::std::enable_if_t<!B, void> _blockLearning() noexcept {
+			static_assert(B, "this feature is designed to be used with a numeric gradient check!");
 		}
 		template<bool B = bAllowToBlockLearning>
-		::std::enable_if_t<!B, static void> _unblockLearning() noexcept {
-			static_assert(false, "this feature is designed to be used with a numeric gradient check!");
+		::std::enable_if_t<!B, void> _unblockLearning() noexcept {
+			static_assert(B, "this feature is designed to be used with a numeric gradient check!");
 		}
 
 	};
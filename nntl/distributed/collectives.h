@@ -0,0 +1,298 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//collective operations over a ring transport (see interface/_i_transport.h)
+//All functions must be called by every participant of the ring at the same time with the same parameters
+// (except for data). All of them are deterministic, i.e. produce bitwise identical results on every participant. That's
+// important, because weights of data-parallel replicas must not drift apart.
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <limits>
+
+#include "../common.h"
+#include "../interface/_i_transport.h"
+#include "../utils/fp16.h"
+
+namespace nntl {
+namespace distributed {
+
+	//gradient compression applied to the data sent over the wire during all-reduce
+	enum class GradCompression {
+		none,
+		fp16, //data is sent as IEEE binary16. Halves traffic, the sum is still accumulated in real_t.
+		// Beware of gradients outside of (-65504, 65504) range.
+		topK //each participant sends only k biggest (by magnitude) elements. Unsent elements are accumulated in a residual
+		// (error feedback) and added to the next gradient. See Lin et al. "Deep Gradient Compression", arxiv:1712.01887
+	};
+
+	template<typename RealT>
+	class ring_collectives {
+		ring_collectives(const ring_collectives& other)noexcept = delete;
+		ring_collectives& operator=(const ring_collectives& rhs) noexcept = delete;
+
+	public:
+		typedef RealT real_t;
+		typedef utils::fp16_format wire16_t;
+		typedef typename wire16_t::storage_t wire16_storage_t;
+		typedef ::std::uint32_t sparse_idx_t;
+
+		//chunk size for pipelined broadcast
+		static constexpr size_t broadcastChunkBytes = 1 << 16;
+
+	protected:
+		//scratch buffers. They only grow, so in a steady state there are no allocations
+		::std::vector<char> m_sendBuf, m_recvBuf;
+		::std::vector<sparse_idx_t> m_idxs;
+
+	protected:
+		static void _ensure(::std::vector<char>& v, const size_t bytes)noexcept {
+			if (v.size() < bytes) v.resize(bytes);
+		}
+
+		static constexpr numel_cnt_t _chunk_begin(const numel_cnt_t n, const int c, const int P)noexcept {
+			return (n*c) / P;
+		}
+
+		static int _mod(const int v, const int P)noexcept {
+			return ((v % P) + P) % P;
+		}
+
+		template<typename FmtT>
+		static void _add_from(real_t*__restrict pDest, const void* pSrc, const numel_cnt_t cnt, ::std::true_type)noexcept {
+			utils::add_from_16bit<FmtT>(pDest, static_cast<const typename FmtT::storage_t*>(pSrc), static_cast<size_t>(cnt));
+		}
+		template<typename FmtT>
+		static void _add_from(real_t*__restrict pDest, const void* pSrc, const numel_cnt_t cnt, ::std::false_type)noexcept {
+			const real_t*__restrict pS = static_cast<const real_t*>(pSrc);
+			for (numel_cnt_t i = 0; i < cnt; ++i) pDest[i] += pS[i];
+		}
+
+	public:
+		~ring_collectives()noexcept {}
+		ring_collectives()noexcept {}
+
+		//preallocates scratch memory for all-reduce of up to maxNumel elements and participants count
+		void reserve(const numel_cnt_t maxNumel, const int worldSize, const GradCompression gc, const real_t topKRatio = real_t(0))noexcept {
+			NNTL_ASSERT(maxNumel >= 0 && worldSize > 0);
+			if (GradCompression::topK == gc) {
+				const auto k = topK_count(maxNumel, topKRatio);
+				const size_t blockBytes = sparse_block_bytes(k);
+				_ensure(m_sendBuf, blockBytes * worldSize);
+				if (m_idxs.size() < static_cast<size_t>(maxNumel)) m_idxs.resize(static_cast<size_t>(maxNumel));
+			} else {
+				const size_t eb = (GradCompression::fp16 == gc) ? sizeof(wire16_storage_t) : sizeof(real_t);
+				const size_t chunkBytes = static_cast<size_t>(maxNumel / worldSize + 1) * eb;
+				_ensure(m_sendBuf, chunkBytes);
+				_ensure(m_recvBuf, chunkBytes);
+			}
+		}
+
+		static numel_cnt_t topK_count(const numel_cnt_t n, const real_t ratio)noexcept {
+			NNTL_ASSERT(ratio > real_t(0) && ratio <= real_t(1));
+			return ::std::max(numel_cnt_t(1), ::std::min(n, static_cast<numel_cnt_t>(::std::ceil(n*ratio))));
+		}
+		static constexpr size_t sparse_block_bytes(const numel_cnt_t k)noexcept {
+			return static_cast<size_t>(k) * (sizeof(sparse_idx_t) + sizeof(real_t));
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// Ring all-reduce (reduce-scatter followed by all-gather) that replaces the data in p with the mean over all
+		// participants. Each participant sends and receives 2*(P-1)/P*n elements in total, independently of P.
+		template<typename TransportT>
+		bool allreduce_mean(TransportT& t, real_t* p, const numel_cnt_t n, const bool bFp16 = false)noexcept {
+			NNTL_ASSERT(p && n > 0);
+			const int P = t.world_size();
+			if (1 == P) return true;
+			const int r = t.rank();
+
+			if (bFp16) {
+				return _allreduce_mean<wire16_t>(t, p, n, P, r, ::std::true_type());
+			} else return _allreduce_mean<wire16_t>(t, p, n, P, r, ::std::false_type());
+		}
+
+	protected:
+		template<typename FmtT, typename TransportT, typename bCompressT>
+		bool _allreduce_mean(TransportT& t, real_t* p, const numel_cnt_t n, const int P, const int r, bCompressT bCompress)noexcept {
+			const size_t eb = bCompressT::value ? sizeof(typename FmtT::storage_t) : sizeof(real_t);
+			const size_t maxChunkBytes = static_cast<size_t>(n / P + 1) * eb;
+			_ensure(m_sendBuf, maxChunkBytes);
+			_ensure(m_recvBuf, maxChunkBytes);
+
+			const auto chunkPtr = [p, n, P](const int c)noexcept { return p + _chunk_begin(n, c, P); };
+			const auto chunkLen = [n, P](const int c)noexcept { return _chunk_begin(n, c + 1, P) - _chunk_begin(n, c, P); };
+			const auto prepSend = [&](const int c)noexcept -> const void* {
+				if (bCompressT::value) {
+					utils::to_16bit<FmtT>(reinterpret_cast<typename FmtT::storage_t*>(m_sendBuf.data()), chunkPtr(c)
+						, static_cast<size_t>(chunkLen(c)));
+					return m_sendBuf.data();
+				} else return chunkPtr(c);
+			};
+
+			//reduce-scatter. On step s participant r sends chunk (r-s) and receives partial sum of chunk (r-s-1)
+			for (int s = 0; s < P - 1; ++s) {
+				const int sc = _mod(r - s, P), rc = _mod(r - s - 1, P);
+				const auto rLen = chunkLen(rc);
+				if (!t.exchange(prepSend(sc), static_cast<size_t>(chunkLen(sc))*eb, m_recvBuf.data(), static_cast<size_t>(rLen)*eb))
+					return false;
+				_add_from<FmtT>(chunkPtr(rc), m_recvBuf.data(), rLen, bCompress);
+			}
+
+			//now participant r owns complete sum of the chunk (r+1). Turning it into mean and (if compression is used)
+			//rounding it the same way as the others will see it
+			{
+				const int oc = _mod(r + 1, P);
+				real_t*__restrict pC = chunkPtr(oc);
+				const auto len = chunkLen(oc);
+				const real_t sc = real_t(1) / static_cast<real_t>(P);
+				for (numel_cnt_t i = 0; i < len; ++i) pC[i] *= sc;
+				if (bCompressT::value) utils::round_to_16bit<FmtT>(pC, static_cast<size_t>(len));
+			}
+
+			//all-gather. On step s participant r sends chunk (r+1-s) and receives final chunk (r-s)
+			for (int s = 0; s < P - 1; ++s) {
+				const int sc = _mod(r + 1 - s, P), rc = _mod(r - s, P);
+				const auto rLen = chunkLen(rc);
+				if (bCompressT::value) {
+					if (!t.exchange(prepSend(sc), static_cast<size_t>(chunkLen(sc))*eb, m_recvBuf.data(), static_cast<size_t>(rLen)*eb))
+						return false;
+					utils::from_16bit<FmtT>(chunkPtr(rc), reinterpret_cast<const typename FmtT::storage_t*>(m_recvBuf.data())
+						, static_cast<size_t>(rLen));
+				} else {
+					if (!t.exchange(chunkPtr(sc), static_cast<size_t>(chunkLen(sc))*eb, chunkPtr(rc), static_cast<size_t>(rLen)*eb))
+						return false;
+				}
+			}
+			return true;
+		}
+
+	public:
+		//////////////////////////////////////////////////////////////////////////
+		// Sparse all-reduce with error feedback. pResidual must be zeroed before the first call and then preserved between
+		// calls. Each participant sends k=topK_count(n, ratio) (index,value) pairs to everyone (ring all-gather), so
+		// the traffic is P*k*(4+sizeof(real_t)) bytes per participant. On return p contains the mean of sparse gradients.
+		template<typename TransportT>
+		bool allreduce_mean_topK(TransportT& t, real_t* p, real_t* pResidual, const numel_cnt_t n, const real_t ratio)noexcept {
+			NNTL_ASSERT(p && pResidual && n > 0);
+			NNTL_ASSERT(n <= static_cast<numel_cnt_t>(::std::numeric_limits<sparse_idx_t>::max()));
+			const int P = t.world_size();
+			const int r = t.rank();
+
+			const auto k = topK_count(n, ratio);
+			const size_t blockBytes = sparse_block_bytes(k);
+			_ensure(m_sendBuf, blockBytes*P);
+			if (m_idxs.size() < static_cast<size_t>(n)) m_idxs.resize(static_cast<size_t>(n));
+
+			//accumulating fresh gradient into the residual and selecting top-k from the sum
+			for (numel_cnt_t i = 0; i < n; ++i) pResidual[i] += p[i];
+
+			const auto pIdxBeg = m_idxs.data(), pIdxEnd = pIdxBeg + n;
+			::std::iota(pIdxBeg, pIdxEnd, sparse_idx_t(0));
+			if (k < n) {
+				::std::nth_element(pIdxBeg, pIdxBeg + k, pIdxEnd, [pResidual](const sparse_idx_t a, const sparse_idx_t b)noexcept {
+					return ::std::abs(pResidual[a]) > ::std::abs(pResidual[b]);
+				});
+			}
+
+			//packing own block [k indices][k values] into the slot r
+			char* pOwnBlock = m_sendBuf.data() + blockBytes*r;
+			sparse_idx_t* pBIdx = reinterpret_cast<sparse_idx_t*>(pOwnBlock);
+			real_t* pBVal = reinterpret_cast<real_t*>(pOwnBlock + sizeof(sparse_idx_t)*k);
+			for (numel_cnt_t i = 0; i < k; ++i) {
+				const auto idx = pIdxBeg[i];
+				pBIdx[i] = idx;
+				pBVal[i] = pResidual[idx];
+				pResidual[idx] = real_t(0);
+			}
+
+			//ring all-gather of blocks. On step s participant r sends block (r-s) and receives block (r-s-1)
+			for (int s = 0; s < P - 1; ++s) {
+				const int sb = _mod(r - s, P), rb = _mod(r - s - 1, P);
+				if (!t.exchange(m_sendBuf.data() + blockBytes*sb, blockBytes, m_sendBuf.data() + blockBytes*rb, blockBytes))
+					return false;
+			}
+
+			//densifying in a fixed order of participants to get bitwise identical result everywhere
+			::std::fill(p, p + n, real_t(0));
+			for (int b = 0; b < P; ++b) {
+				const char* pBlock = m_sendBuf.data() + blockBytes*b;
+				const sparse_idx_t* pI = reinterpret_cast<const sparse_idx_t*>(pBlock);
+				const real_t* pV = reinterpret_cast<const real_t*>(pBlock + sizeof(sparse_idx_t)*k);
+				for (numel_cnt_t i = 0; i < k; ++i) p[pI[i]] += pV[i];
+			}
+			if (P > 1) {
+				const real_t sc = real_t(1) / static_cast<real_t>(P);
+				for (numel_cnt_t i = 0; i < n; ++i) p[i] *= sc;
+			}
+			return true;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// pipelined ring broadcast of n elements from the participant root to everyone else.
+		template<typename TransportT, typename T>
+		static bool broadcast(TransportT& t, T* p, const numel_cnt_t n, const int root = 0)noexcept {
+			static_assert(::std::is_trivially_copyable<T>::value, "");
+			NNTL_ASSERT(p && n >= 0);
+			const int P = t.world_size();
+			if (1 == P || 0 == n) return true;
+			NNTL_ASSERT(root >= 0 && root < P);
+
+			const int r = t.rank();
+			char* pB = reinterpret_cast<char*>(p);
+			const size_t totBytes = static_cast<size_t>(n) * sizeof(T);
+			const size_t chunksCnt = (totBytes + broadcastChunkBytes - 1) / broadcastChunkBytes;
+			const auto chunkBytes = [totBytes](const size_t c)noexcept {
+				return ::std::min(broadcastChunkBytes, totBytes - c*broadcastChunkBytes);
+			};
+
+			if (r == root) {
+				for (size_t c = 0; c < chunksCnt; ++c) {
+					if (!t.exchange(pB + c*broadcastChunkBytes, chunkBytes(c), nullptr, 0)) return false;
+				}
+			} else {
+				//on step c we're receiving chunk c and forwarding chunk c-1 (unless the next is the root)
+				const bool bForward = t.next_rank() != root;
+				for (size_t c = 0; c <= chunksCnt; ++c) {
+					const bool bSend = bForward && c > 0, bRecv = c < chunksCnt;
+					if (!t.exchange(bSend ? pB + (c - 1)*broadcastChunkBytes : nullptr, bSend ? chunkBytes(c - 1) : 0
+						, bRecv ? pB + c*broadcastChunkBytes : nullptr, bRecv ? chunkBytes(c) : 0)) return false;
+				}
+			}
+			return true;
+		}
+	};
+
+}
+}
@@ -0,0 +1,480 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//Distributed data-parallel training.
+//
+//Every participant (rank) runs an identical copy of the nnet on its own part of data. After each batch gradients dL/dW of
+//each learnable layer are averaged over all participants with ring all-reduce, so every replica applies exactly the same
+//weight update and replicas stay identical (all collectives are deterministic).
+//
+//How it works:
+// - dp_grad_works is a drop-in replacement of grad_works for learnable layers. Its apply_grad(), that's called by a layer
+//		during bprop(), doesn't update weights, but copies dL/dW into a persistent buffer and posts it to a communicator
+//		thread. Then the bprop() proceeds to lower layers while the gradient of the upper layer is being exchanged.
+// - when m_Layers.bprop() is done, nnet::train() calls sync_batch_grad() of each layer's grad_works (top to bottom) that
+//		waits for the exchange of the layer's gradient to finish and then runs the usual (non-distributed) apply_grad()
+//		machinery (loss addendums, optimizers, momentums, max-norm) on the averaged gradient.
+// - with gradient accumulation (nnet_train_opts::gradAccumSteps()) micro-batch gradients are accumulated locally and only
+//		the accumulated gradient of an effective batch is exchanged, once per effective batch.
+// - if an exchange fails (transport timeout, dead peer), nnet::train() stops and returns ErrorCode::GradientExchangeFailed.
+// - a layer with several weights matrices (such as LFCLR, see layer_has_weights_blocks) has a grad_works object per matrix,
+//		every one of them is attached to the communicator and exchanges its own gradient.
+//
+//Requirements for correct results (it's the caller's responsibility):
+// - every rank must have the same architecture and settings and must run the same number of batches per epoch
+//		with the same batch size (different ranks should see different data, though - use different data/seeds);
+// - initial weights must be identical - use make_weights_broadcaster() as the onInitCB of nnet::train();
+// - LRDropout is not supported, because its random masks would be different on different ranks.
+// - sparse updates of layer_embedding aren't exchanged, so dp_grad_works can't be used there (it won't compile).
+// - only the rank 0 should report anything. Wrap the observer into rank0_observer<> (and don't use bReportOnlyTime()
+//		mode on other ranks).
+//
+//Example (see also tests/test_distributed.cpp):
+//	distributed::shm_ring_transport transport("myjob_1234", rank, worldSize);
+//	distributed::dp_communicator<real_t> comm(transport, distributed::GradCompression::fp16);
+//	... layers with LFC<..., distributed::dp_grad_works<myInterfaces>> ...
+//	distributed::attach_communicator(lp, comm);
+//	opts.observer().set_rank(rank);
+//	nn.train(td, opts, onEpochEnd, distributed::make_weights_broadcaster(lp, comm));
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+#include "collectives.h"
+#include "../_nnet_errs.h"
+#include "../grad_works/grad_works.h"
+
+namespace nntl {
+namespace distributed {
+
+	//////////////////////////////////////////////////////////////////////////
+	// communicator owns a thread that performs collective operations in the order of their posting
+	template<typename RealT>
+	class dp_communicator {
+		dp_communicator(const dp_communicator& other)noexcept = delete;
+		dp_communicator& operator=(const dp_communicator& rhs) noexcept = delete;
+
+	public:
+		typedef RealT real_t;
+		typedef ring_collectives<real_t> collectives_t;
+
+		struct job_t {
+			enum State { Idle = 0, Queued, Done, Failed };
+
+			real_t* pData{ nullptr };
+			real_t* pResidual{ nullptr };//for topK only
+			numel_cnt_t numel{ 0 };
+			State state{ Idle };
+		};
+
+	protected:
+		typedef bool(*run_job_f)(void* pTransport, collectives_t& coll, const job_t& j, const GradCompression gc, const real_t topKRatio);
+		typedef bool(*broadcast_f)(void* pTransport, real_t* p, const numel_cnt_t n);
+		typedef bool(*barrier_f)(void* pTransport);
+
+		//type-erased transport, so the transport type doesn't leak into the types of layers
+		void* m_pTransport;
+		run_job_f m_fnRunJob;
+		broadcast_f m_fnBroadcast;
+		barrier_f m_fnBarrier;
+
+		collectives_t m_coll;
+
+		::std::mutex m_mutex;
+		::std::condition_variable m_cvJobs, m_cvDone;
+		//job queue. Vector is never shrinked, so there're no allocations in a steady state
+		::std::vector<job_t*> m_queue;
+		size_t m_queueHead{ 0 };
+		::std::thread m_thread;
+
+		GradCompression m_compression;
+		real_t m_topKRatio;
+		int m_rank, m_worldSize;
+		bool m_bStop{ false };
+
+	protected:
+		template<typename TransportT>
+		static bool _s_run_job(void* pT, collectives_t& coll, const job_t& j, const GradCompression gc, const real_t topKRatio)noexcept {
+			auto& t = *static_cast<TransportT*>(pT);
+			if (GradCompression::topK == gc) {
+				return coll.allreduce_mean_topK(t, j.pData, j.pResidual, j.numel, topKRatio);
+			} else return coll.allreduce_mean(t, j.pData, j.numel, GradCompression::fp16 == gc);
+		}
+		template<typename TransportT>
+		static bool _s_broadcast(void* pT, real_t* p, const numel_cnt_t n)noexcept {
+			return collectives_t::broadcast(*static_cast<TransportT*>(pT), p, n, 0);
+		}
+		template<typename TransportT>
+		static bool _s_barrier(void* pT)noexcept {
+			return static_cast<TransportT*>(pT)->barrier();
+		}
+
+		static void _s_worker(dp_communicator* p)noexcept { p->_worker(); }
+
+		void _worker()noexcept {
+			::std::unique_lock<::std::mutex> lk(m_mutex);
+			while (true) {
+				m_cvJobs.wait(lk, [this]()noexcept {return m_bStop || m_queueHead < m_queue.size(); });
+				if (m_queueHead >= m_queue.size()) {
+					NNTL_ASSERT(m_bStop);
+					break;
+				}
+				job_t* pJ = m_queue[m_queueHead++];
+				if (m_queueHead == m_queue.size()) {
+					m_queue.clear();
+					m_queueHead = 0;
+				}
+				lk.unlock();
+
+				const bool bOk = m_fnRunJob(m_pTransport, m_coll, *pJ, m_compression, m_topKRatio);
+
+				lk.lock();
+				pJ->state = bOk ? job_t::Done : job_t::Failed;
+				m_cvDone.notify_all();
+			}
+		}
+
+	public:
+		~dp_communicator()noexcept {
+			{
+				::std::lock_guard<::std::mutex> lk(m_mutex);
+				m_bStop = true;
+			}
+			m_cvJobs.notify_all();
+			m_thread.join();
+		}
+
+		//topKRatio is the fraction of gradient elements sent by each rank when GradCompression::topK is used
+		template<typename TransportT>
+		dp_communicator(TransportT& t, const GradCompression gc = GradCompression::none, const real_t topKRatio = real_t(.01))noexcept
+			: m_pTransport(&t), m_fnRunJob(&_s_run_job<TransportT>), m_fnBroadcast(&_s_broadcast<TransportT>)
+			, m_fnBarrier(&_s_barrier<TransportT>), m_compression(gc), m_topKRatio(topKRatio)
+			, m_rank(t.rank()), m_worldSize(t.world_size())
+		{
+			NNTL_ASSERT(GradCompression::topK != gc || (topKRatio > real_t(0) && topKRatio <= real_t(1)));
+			m_queue.reserve(64);
+			m_thread = ::std::thread(_s_worker, this);
+		}
+
+		int rank()const noexcept { return m_rank; }
+		int world_size()const noexcept { return m_worldSize; }
+		GradCompression compression()const noexcept { return m_compression; }
+		real_t topK_ratio()const noexcept { return m_topKRatio; }
+
+		void post(job_t& j)noexcept {
+			NNTL_ASSERT(j.pData && j.numel > 0 && j.state != job_t::Queued);
+			NNTL_ASSERT(GradCompression::topK != m_compression || j.pResidual);
+			{
+				::std::lock_guard<::std::mutex> lk(m_mutex);
+				j.state = job_t::Queued;
+				m_queue.push_back(&j);
+			}
+			m_cvJobs.notify_one();
+		}
+
+		//returns false if the job failed
+		bool wait(job_t& j)noexcept {
+			::std::unique_lock<::std::mutex> lk(m_mutex);
+			m_cvDone.wait(lk, [&j]()noexcept {return j.state != job_t::Queued; });
+			const bool r = job_t::Done == j.state;
+			j.state = job_t::Idle;
+			return r;
+		}
+
+		//synchronous ops. Must be called from the main thread only when there're no pending jobs
+		bool broadcast(real_t* p, const numel_cnt_t n)noexcept {
+			NNTL_ASSERT(m_queue.empty());
+			return m_fnBroadcast(m_pTransport, p, n);
+		}
+		bool barrier()noexcept {
+			NNTL_ASSERT(m_queue.empty());
+			return m_fnBarrier(m_pTransport);
+		}
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	//////////////////////////////////////////////////////////////////////////
+	template<typename FinalT, typename InterfacesT, template<typename, typename, size_t> class... MixinsT>
+	class _dp_grad_works : public _grad_works<FinalT, InterfacesT, MixinsT...> {
+		typedef _grad_works<FinalT, InterfacesT, MixinsT...> _base_class_t;
+
+	protected:
+		typedef FinalT self_t;
+		NNTL_METHODS_SELF();
+
+	public:
+		using typename _base_class_t::real_t;
+		using typename _base_class_t::realmtx_t;
+		using typename _base_class_t::realmtxdef_t;
+		using typename _base_class_t::common_data_t;
+
+		typedef dp_communicator<real_t> communicator_t;
+
+	protected:
+		communicator_t* m_pComm{ nullptr };
+
+		realmtxdef_t m_dpGrad;//persistent copy of dL/dW that is being exchanged
+		realmtxdef_t m_dpResidual;//error feedback accumulator for GradCompression::topK
+		realmtxdef_t* m_pDpWeights{ nullptr };
+
+		typename communicator_t::job_t m_dpJob;
+		bool m_bDpPending{ false };
+
+	protected:
+		~_dp_grad_works()noexcept {}
+		_dp_grad_works(const real_t lr) noexcept : _base_class_t(lr) {}
+
+		bool _dp_active()const noexcept { return m_pComm && m_pComm->world_size() > 1; }
+
+	public:
+		self_ref_t set_communicator(communicator_t* p)noexcept {
+			NNTL_ASSERT(!m_bDpPending);
+			m_pComm = p;
+			return get_self();
+		}
+		communicator_t* get_communicator()const noexcept { return m_pComm; }
+
+		bool gw_init(const common_data_t& cd, const realmtx_t& weights)noexcept {
+			if (!_base_class_t::gw_init(cd, weights)) return false;
+
+			m_bDpPending = false;
+			if (_dp_active()) {
+				if (!m_dpGrad.resize(weights.size())) return false;
+				if (GradCompression::topK == m_pComm->compression()) {
+					if (!m_dpResidual.resize(weights.size())) return false;
+					m_dpResidual.zeros();
+				}
+			}
+			return true;
+		}
+
+		void gw_deinit()noexcept {
+			NNTL_ASSERT(!m_bDpPending);
+			m_dpGrad.clear();
+			m_dpResidual.clear();
+			m_pDpWeights = nullptr;
+			_base_class_t::gw_deinit();
+		}
+
+		//doesn't update weights, but schedules the exchange of dLdW. Weights are updated in sync_batch_grad().
+		// When accumulating gradient, it's called once per effective batch with the accumulated dL/dW (see
+		// _grad_works::grad_accum_end()), so micro-batches other than the last one aren't exchanged.
+		void _apply_grad(realmtxdef_t& weights, realmtxdef_t& dLdW) noexcept {
+			if (!_dp_active()) {
+				_base_class_t::_apply_grad(weights, dLdW);
+				return;
+			}
+			NNTL_ASSERT(!m_bDpPending);
+			NNTL_ASSERT(weights.size() == m_dpGrad.size());
+			//dLdW is a temporary storage that will be reused by lower layers, so must make a copy
+			const auto bCopied = dLdW.copy_to(m_dpGrad);
+			NNTL_ASSERT(bCopied);
+			NNTL_UNREF(bCopied);
+
+			m_pDpWeights = &weights;
+			m_dpJob.pData = m_dpGrad.data();
+			m_dpJob.pResidual = m_dpResidual.empty() ? nullptr : m_dpResidual.data();
+			m_dpJob.numel = m_dpGrad.numel();
+			m_pComm->post(m_dpJob);
+			m_bDpPending = true;
+		}
+
+		//different ranks touch different columns in the sparse mode, so the compact gradients can't be all-reduced.
+		// Rejected at compile time instead of letting replicas silently diverge
+		template<typename CommonDataT>
+		bool gw_init_sparse(const CommonDataT&, const realmtx_t&)noexcept {
+			static_assert(!::std::is_same<CommonDataT, CommonDataT>::value
+				, "dp_grad_works doesn't support the sparse mode (layer_embedding), the replicas would diverge");
+			return false;
+		}
+
+		//must be called after the whole bprop() is done. Returns false if the gradient exchange failed. Weights are left
+		// intact then and the training can't continue (nnet::train() returns ErrorCode::GradientExchangeFailed)
+		bool sync_batch_grad()noexcept {
+			if (!m_bDpPending) return true;
+			m_bDpPending = false;
+			if (!m_pComm->wait(m_dpJob)) return false;
+			NNTL_ASSERT(!get_self().bLRDropout() || !"LRDropout is not supported in distributed mode!");
+			_base_class_t::_apply_grad(*m_pDpWeights, m_dpGrad);
+			return true;
+		}
+	};
+
+	template<typename InterfacesT, template<typename, typename, size_t> class... MixinsT>
+	class dp_grad_works_f final : public _dp_grad_works<dp_grad_works_f<InterfacesT, MixinsT...>, InterfacesT, MixinsT...> {
+	public:
+		~dp_grad_works_f()noexcept {}
+		dp_grad_works_f(const typename InterfacesT::iMath_t::real_t lr) noexcept
+			: _dp_grad_works<dp_grad_works_f<InterfacesT, MixinsT...>, InterfacesT, MixinsT...>(lr) {}
+	};
+
+	//same set of mixins as ::nntl::grad_works
+	template<typename InterfacesT>
+	using dp_grad_works = dp_grad_works_f<
+		InterfacesT
+		, GW::ILR
+		, GW::Loss_Addendums_builder< ::std::tuple<
+		loss_addendum::L1<typename InterfacesT::real_t>
+		, loss_addendum::L2<typename InterfacesT::real_t>
+		>>::template type
+	>;
+
+	//////////////////////////////////////////////////////////////////////////
+	// helpers
+
+	template<typename GW, class = ::std::void_t<>>
+	struct is_dp_grad_works : ::std::false_type {};
+	template<typename GW>
+	struct is_dp_grad_works<GW, ::std::void_t<decltype(::std::declval<GW&>().get_communicator())>> : ::std::true_type {};
+
+	template<typename L, class = ::std::void_t<>>
+	struct layer_has_dp_grad_works : ::std::false_type {};
+	template<typename L>
+	struct layer_has_dp_grad_works<L, ::std::void_t<typename L::grad_works_t>> : is_dp_grad_works<typename L::grad_works_t> {};
+
+	template<typename RealT>
+	struct hlpr_layer_attach_communicator {
+		dp_communicator<RealT>* pComm;
+
+		template<typename _L>
+		::std::enable_if_t<layer_has_dp_grad_works<_L>::value> operator()(_L& l)const noexcept {
+			for (unsigned b = 0; b < layer_weights_blocks_cnt<_L>::value; ++b) {
+				layer_gradWorks_block(l, b).set_communicator(pComm);
+			}
+		}
+		template<typename _L>
+		::std::enable_if_t<!layer_has_dp_grad_works<_L>::value> operator()(_L&)const noexcept {}
+	};
+
+	//must be called before nnet::train()
+	template<typename LayersT>
+	void attach_communicator(LayersT& lp, dp_communicator<typename LayersT::real_t>& comm)noexcept {
+		lp.for_each_layer(hlpr_layer_attach_communicator<typename LayersT::real_t>{&comm});
+	}
+
+	//the functor to be passed as onInitCB to nnet::train(). Makes weights of every learnable layer with dp_grad_works
+	//identical to weights of the rank 0. Received weights are passed to the layer's set_weights(), so layers that derive
+	//something from the weights (e.g. compressed copies of LFCP) stay consistent. LFCP keeps its own mask there, it's
+	//the same on every rank as long as ranks are pruned identically
+	template<typename LayersT>
+	struct weights_broadcaster {
+		typedef typename LayersT::real_t real_t;
+
+		LayersT& lp;
+		dp_communicator<real_t>& comm;
+
+		struct hlpr {
+			dp_communicator<real_t>& comm;
+			bool& bOk;
+
+			template<typename _L>
+			::std::enable_if_t<layer_has_dp_grad_works<_L>::value> operator()(_L& l)const noexcept {
+				static constexpr unsigned nBlocks = layer_weights_blocks_cnt<_L>::value;
+				typename _L::realmtx_t W[nBlocks];
+				for (unsigned b = 0; b < nBlocks; ++b) {
+					if (bOk) bOk = layer_weights_block(l, b).clone_to(W[b]);
+					if (bOk) bOk = comm.broadcast(W[b].data(), W[b].numel());
+				}
+				if (bOk) bOk = layer_set_weights_blocks(l, W);
+			}
+			template<typename _L>
+			::std::enable_if_t<!layer_has_dp_grad_works<_L>::value> operator()(_L&)const noexcept {}
+		};
+
+		_nnet_errs::ErrorCode operator()()const noexcept {
+			bool bOk = true;
+			lp.for_each_layer(hlpr{ comm, bOk });
+			if (bOk) bOk = comm.barrier();
+			return bOk ? _nnet_errs::ErrorCode::Success : _nnet_errs::ErrorCode::PostInitStopFromCallback;
+		}
+	};
+
+	template<typename LayersT>
+	weights_broadcaster<LayersT> make_weights_broadcaster(LayersT& lp, dp_communicator<typename LayersT::real_t>& comm)noexcept {
+		return weights_broadcaster<LayersT>{lp, comm};
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// observer wrapper that silences every rank but 0
+	template<typename ObsT>
+	class rank0_observer : public ObsT {
+		typedef ObsT _base_class_t;
+
+	public:
+		typedef typename ObsT::real_t real_t;
+		typedef typename ObsT::realmtx_t realmtx_t;
+		typedef typename ObsT::nanoseconds nanoseconds;
+
+	protected:
+		int m_rank{ 0 };
+
+	public:
+		void set_rank(const int r)noexcept { m_rank = r; }
+		int rank()const noexcept { return m_rank; }
+		bool is_reporting()const noexcept { return 0 == m_rank; }
+
+		template<typename TrainDataT, typename CommonDataT>
+		bool init(numel_cnt_t epochs, TrainDataT& td, const CommonDataT& cd)noexcept {
+			return is_reporting() ? _base_class_t::init(epochs, td, cd) : true;
+		}
+		void deinit()noexcept {
+			if (is_reporting()) _base_class_t::deinit();
+		}
+
+		void report_results_begin(const DataSetsId::data_set_id_t dataSetId, const numel_cnt_t totalBatches)noexcept {
+			if (is_reporting()) _base_class_t::report_results_begin(dataSetId, totalBatches);
+		}
+		template<typename YT, typename CommonDataT>
+		void report_results(const numel_cnt_t batchIdx, const realmtx_t& activations, const math::smatrix<YT>& data_y, const CommonDataT& cd)noexcept {
+			if (is_reporting()) _base_class_t::report_results(batchIdx, activations, data_y, cd);
+		}
+		void report_results_end(const real_t lossVal)noexcept {
+			if (is_reporting()) _base_class_t::report_results_end(lossVal);
+		}
+
+		template<typename TrainDataT>
+		void on_training_start(const TrainDataT& td, vec_len_t batchSize, vec_len_t maxFpropSize, numel_cnt_t numParams)noexcept {
+			if (is_reporting()) _base_class_t::on_training_start(td, batchSize, maxFpropSize, numParams);
+		}
+		void on_training_fragment_end(const numel_cnt_t epochEnded, const real_t trainLoss, const real_t testLoss, const nanoseconds& elapsedSincePrevFragment)noexcept {
+			if (is_reporting()) _base_class_t::on_training_fragment_end(epochEnded, trainLoss, testLoss, elapsedSincePrevFragment);
+		}
+		void on_training_end(const nanoseconds& trainTime)noexcept {
+			if (is_reporting()) _base_class_t::on_training_end(trainTime);
+		}
+	};
+
+}
+}
@@ -64,7 +64,7 @@ namespace nntl {
 		typedef _impl::_dropout_base<RealT> _base_class_t;
 
 	public:
-		using _base_class_t::real_t;
+		using typename _base_class_t::real_t;
 
 		//this flag means that the dropout algorithm doesn't change the activation value if it is zero.
 		// for example, it is the case of classical dropout (it drops values to zeros), but not the case of AlphaDropout
@@ -114,7 +114,9 @@ namespace nntl {
 				NNTL_ASSERT(m_a && m_b && m_mbDropVal);
 
 				_dropout_saveActivations(activations);
-				CD.iRng().gen_matrix_norm(m_dropoutMask);
+				if (CD.is_recomputing_fprop()) {
+					_dropout_unbinarize_mask();
+				} else CD.iRng().gen_matrix_norm(m_dropoutMask);
 
 				auto& _iI = CD.iInspect();
 				_iI.fprop_preDropout(activations, m_dropoutPercentActive, m_dropoutMask);
@@ -129,6 +129,16 @@ namespace nntl {
 				NNTL_ASSERT(c);
 			}
 
+			//turns the binarized mask of the last fprop() (zeros for dropped units and positive values for the rest) back into
+			// the form that make_dropout()-like functions binarize to the same mask. Used to reuse the mask when the fprop()
+			// is recomputed (see CommonDataT::is_recomputing_fprop())
+			void _dropout_unbinarize_mask()noexcept {
+				NNTL_ASSERT(!m_dropoutMask.empty());
+				const auto pM = m_dropoutMask.data();
+				const auto ne = m_dropoutMask.numel();
+				for (numel_cnt_t i = 0; i < ne; ++i) pM[i] = pM[i] > real_t(0) ? real_t(0) : real_t(1);
+			}
+
 			template<typename CommonDataT>
 			bool _dropout_has_original_activations(const CommonDataT& CD) const noexcept {
 				return (bDropoutWorksAtEvaluationToo || CD.is_training_mode()) && bDropout();
@@ -228,7 +238,9 @@ namespace nntl {
 				NNTL_ASSERT(m_dropoutMask.size() == m_origActivations.size());
 
 				_dropout_saveActivations(activations);
-				CD.iRng().gen_matrix_norm(m_dropoutMask);
+				if (CD.is_recomputing_fprop()) {
+					_dropout_unbinarize_mask();
+				} else CD.iRng().gen_matrix_norm(m_dropoutMask);
 
 				auto& _iI = CD.iInspect();
 				_iI.fprop_preDropout(activations, m_dropoutPercentActive, m_dropoutMask);
@@ -104,7 +104,7 @@ namespace nntl {
 
 	public:
 		typedef _impl::common_nn_data<interfaces_t> common_data_t;
-		using _impl::_common_data_consumer<InterfacesT>::real_t;
+		using typename _impl::_common_data_consumer<InterfacesT>::real_t;
 		
 		typedef math::smatrix<real_t> realmtx_t;
 		typedef math::smatrix_deform<real_t> realmtxdef_t;
@@ -206,6 +206,13 @@ namespace nntl {
 		realmtx_t m_Vw;
 		realmtx_t m_optMtxA, m_optMtxB;//some optimizers require additional memory.
 
+		//gradient accumulation only: the sum of dL/dW of micro-batches of the current effective batch, the number of
+		// micro-batches that contributed to it (bprop() of a layer might be skipped, see LPHO) and the weights to update
+		realmtxdef_t m_accdLdW;
+		realmtxdef_t* m_pAccWeights{ nullptr };
+		unsigned m_accCnt{ 0 };
+		bool m_bAccNesterovDone{ false };//the Nesterov momentum step has been made for the current effective batch
+
 		real_t m_optBeta1t, m_optBeta2t;//storage for coefficients some optimizers (Adam, AdaMax) needed
 
 	protected:
@@ -302,6 +309,13 @@ namespace nntl {
 
 			if (!ILR_init(weightsSize))return false;
 
+			if (cd.is_accumulating_grad()) {
+				if (!m_accdLdW.resize(weightsSize))return false;
+			}
+			m_pAccWeights = nullptr;
+			m_accCnt = 0;
+			m_bAccNesterovDone = false;
+
 			set_common_data(cd);
 
 			//we would need twice weightsNumel to make LRDropout for NesterovMomentum if necessary
@@ -332,12 +346,18 @@ namespace nntl {
 			m_Vw.clear();
 			m_optMtxA.clear();
 			m_optMtxB.clear();
+			m_accdLdW.clear();
+			m_pAccWeights = nullptr;
+			m_accCnt = 0;
 
 			//_flags_default();//we shouldn't clear this variable, as it contains only settings but not a run-time data
 		}
 
 		void pre_training_fprop(realmtxdef_t& weights) noexcept {
-			if (!isLearningBlocked() && use_nesterov_momentum()) {
+			//weights are the same for every micro-batch of the effective batch, so momentum is applied once, before the first
+			// fprop() of the layer within it (that isn't necessarily the first micro-batch, see grad_accum_begin())
+			if (!isLearningBlocked() && use_nesterov_momentum() && !m_bAccNesterovDone) {
+				if (get_common_data().grad_accum_cnt() > 1) m_bAccNesterovDone = true;
 				// (1)  vW`(t+1)= momentum*vW(t)
 				// (2)  W`(t+1) = W(t) - momentum*vW(t)
 				//				= W(t) - vW`(t+1)
@@ -389,8 +409,36 @@ namespace nntl {
 			}
 		}
 		
-		//#todo this code should be refactored.
 		void apply_grad(realmtxdef_t& weights, realmtxdef_t& dLdW) noexcept {
+			//when accumulating gradient, weights are updated only after the last micro-batch of the effective batch
+			if (_accumulate_grad(weights, dLdW)) {
+				if (get_common_data().is_last_grad_accum_step()) get_self().grad_accum_end();
+			} else get_self()._apply_grad(weights, dLdW);
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// Gradient accumulation protocol (see nnet_train_opts::gradAccumSteps()). nnet::train() calls grad_accum_begin() of
+		// every grad_works before the first micro-batch of an effective batch and grad_accum_end() after bprop() of the last
+		// one, so the accumulator never carries sums of the previous effective batch over and the update isn't lost even if
+		// the layer's bprop() was skipped for the first or the last micro-batch (LPHO does that for a closed gate).
+		void grad_accum_begin()noexcept {
+			m_accCnt = 0;
+			m_bAccNesterovDone = false;
+		}
+		//updates weights with the mean dL/dW over the micro-batches that contributed to the effective batch. Does nothing
+		// if there were no contributions or they've already been applied by apply_grad() of the last micro-batch
+		void grad_accum_end()noexcept {
+			m_bAccNesterovDone = false;
+			if (!m_accCnt) return;
+			NNTL_ASSERT(m_pAccWeights);
+			if (m_accCnt > 1) get_iMath().evMulC_ip(m_accdLdW, real_t(1) / static_cast<real_t>(m_accCnt));
+			m_accCnt = 0;
+			get_self()._apply_grad(*m_pAccWeights, m_accdLdW);
+		}
+
+		//updates weights with dLdW right away. Derived grad_works might redefine it (see distributed/data_parallel.h)
+		//#todo this code should be refactored.
+		void _apply_grad(realmtxdef_t& weights, realmtxdef_t& dLdW) noexcept {
 			NNTL_ASSERT(dLdW.size() == weights.size());
 			NNTL_ASSERT(weights.bBatchInColumn() && dLdW.bBatchInColumn());//standard layout must be kept for weights
 #ifdef NNTL_AGGRESSIVE_NANS_DBG_CHECK
@@ -579,6 +627,169 @@ namespace nntl {
 			iI.apply_grad_end(weights);
 		}
 
+	protected:
+		//Gradient accumulation. dLdW is a temporary storage that is reused by other layers, so the sum of dL/dW is kept in
+		// m_accdLdW. Returns false if dLdW should be applied right away (no accumulation or a single micro-batch effective
+		// batch). Each dL/dW is already averaged over its micro-batch, so grad_accum_end() divides the sum by the number
+		// of contributions, and since _apply_grad() runs once per effective batch, loss addendums, optimizers and momentums
+		// see the gradient of the effective batch exactly as if it were processed at once.
+		bool _accumulate_grad(realmtxdef_t& weights, const realmtxdef_t& dLdW)noexcept {
+			const auto& CD = get_common_data();
+			if (CD.grad_accum_cnt() < 2) {
+				NNTL_ASSERT(!m_accCnt);
+				return false;
+			}
+
+			NNTL_ASSERT(m_accdLdW.size() == dLdW.size());
+			if (m_accCnt) {
+				NNTL_ASSERT(m_pAccWeights == &weights);
+				get_iMath().evAdd_ip(m_accdLdW, dLdW);
+			} else {
+				const auto bCopied = dLdW.copy_to(m_accdLdW);
+				NNTL_ASSERT(bCopied);
+				NNTL_UNREF(bCopied);
+			}
+			m_pAccWeights = &weights;
+			++m_accCnt;
+			return true;
+		}
+
+	public:
+		//////////////////////////////////////////////////////////////////////////
+
+		//////////////////////////////////////////////////////////////////////////
+		// Sparse ("lazy") mode for layers that touch only a few columns of a huge weight matrix per batch (see layer/embedding.h).
+		// Weights are [D, V] and every column is updated independently; dLdWc is a compact [D, U] gradient of the U columns
+		// listed in pCols (the list must not contain duplicates). Optimizer state is kept for the whole matrix, but only
+		// the touched columns of it are read and updated, so the state of untouched columns stays as it was on their last
+		// update (just like the LazyAdam does). The bias correction terms of Adam-like optimizers are global.
+		// Momentums, ILR, LRDropout, max-norm and loss addendums are NOT supported in the sparse mode - they require
+		// the whole weight matrix to be processed on every step and that's exactly what we're trying to avoid here.
+		// Gradient accumulation isn't supported either - weights are updated on every micro-batch.
+		// gw_init_sparse() fails if the settings aren't supported, check them with is_sparse_mode_supported() to tell why.
+		bool gw_init_sparse(const common_data_t& cd, const realmtx_t& weights)noexcept {
+			if (!is_sparse_mode_supported()) return false;
+
+			const auto weightsSize = weights.size();
+			if (_optimizerRequiresMatrixA()) {
+				if (!m_optMtxA.resize(weightsSize))return false;
+			}
+			if (_optimizerRequiresMatrixB()) {
+				if (!m_optMtxB.resize(weightsSize))return false;
+			}
+
+			set_common_data(cd);
+			set_opt(f_FirstRun, true);
+			return true;
+		}
+
+		bool is_sparse_mode_supported()const noexcept {
+			return !use_momentums() && !bLRDropout() && !use_max_norm() && !hasLossAddendum();
+		}
+
+		//the amount of iMath temporary memory apply_grad_sparse() requires. Call get_iMath().preinit() with it.
+		static constexpr numel_cnt_t apply_grad_sparse_needTempMem(const vec_len_t weightsRows, const vec_len_t maxCols)noexcept {
+			return 2 * math::smatrix_td::sNumel(weightsRows, maxCols);
+		}
+
+		void apply_grad_sparse(realmtx_t& weights, realmtx_t& dLdWc, const vec_len_t*const pCols)noexcept {
+			NNTL_ASSERT(!weights.empty() && !dLdWc.empty() && pCols);
+			NNTL_ASSERT(!weights.emulatesBiases() && !dLdWc.emulatesBiases());
+			NNTL_ASSERT(weights.rows() == dLdWc.rows() && dLdWc.cols() <= weights.cols());
+			NNTL_ASSERT(weights.bBatchInColumn() && dLdWc.bBatchInColumn());
+			NNTL_ASSERT(is_sparse_mode_supported() || !"Not supported in the sparse mode!");
+#ifdef NNTL_AGGRESSIVE_NANS_DBG_CHECK
+			NNTL_ASSERT(dLdWc.test_noNaNs());
+#endif // NNTL_AGGRESSIVE_NANS_DBG_CHECK
+
+			auto& iI = get_iInspect();
+			iI.apply_grad_begin(weights, dLdWc);
+
+			if (isLearningBlocked()) {
+				iI.apply_grad_end(weights);
+				return;
+			}
+
+			const bool bFirstRun = get_opt(f_FirstRun);
+			set_opt(f_FirstRun, false);
+			if (bFirstRun) {
+				//the state starts from zeros, so there's no need in special first run handling below
+				m_optBeta1t = real_t(1.);
+				m_optBeta2t = real_t(1.);
+				m_optGamma = real_t(0.);
+				if (_optimizerRequiresMatrixA()) m_optMtxA.zeros();
+				if (_optimizerRequiresMatrixB()) m_optMtxB.zeros();
+			}
+
+			auto& iM = get_iMath();
+			const auto tmpNumel = dLdWc.numel();
+			const bool bA = _optimizerRequiresMatrixA(), bB = _optimizerRequiresMatrixB();
+			real_t* pTmpA = bA ? iM._istor_alloc(tmpNumel) : nullptr;
+			real_t* pTmpB = bB ? iM._istor_alloc(tmpNumel) : nullptr;
+			realmtx_t A, B;
+			if (bA) {
+				A.useExternalStorage(pTmpA, dLdWc);
+				iM.mExtractColsByIdx(m_optMtxA, pCols, A);
+			}
+			if (bB) {
+				B.useExternalStorage(pTmpB, dLdWc);
+				iM.mExtractColsByIdx(m_optMtxB, pCols, B);
+			}
+
+			const real_t curLr = m_learningRate;
+			switch (m_type) {
+			case ClassicalConstant:
+				iM.evMulC_ip(dLdWc, curLr);
+				break;
+			case RMSProp_Hinton:
+				iM.RMSProp_Hinton(dLdWc, A, curLr, m_optBeta1, m_numericStabilizerEps);
+				break;
+			case RMSProp_Graves:
+				iM.RMSProp_Graves(dLdWc, A, B, curLr, m_optBeta1, m_numericStabilizerEps);
+				break;
+			case RProp:
+				iM.RProp(dLdWc, curLr);
+				break;
+			case ModProp:
+				iM.ModProp(dLdWc, A, curLr, m_optBeta1, m_numericStabilizerEps);
+				break;
+			case Adam:
+				iM.Adam(dLdWc, A, B, m_optBeta1t, m_optBeta2t, curLr, m_optBeta1, m_optBeta2, m_numericStabilizerEps);
+				break;
+			case AdaMax:
+				iM.AdaMax(dLdWc, A, B, m_optBeta1t, curLr, m_optBeta1, m_optBeta2, m_numericStabilizerEps);
+				break;
+			case Nadam:
+			case Radam:
+				iM.RNadam(dLdWc, A, B, m_optBeta1t, m_optBeta2t, curLr, m_optBeta1, m_optBeta2, m_optGamma, m_numericStabilizerEps);
+				break;
+			default:
+				NNTL_ASSERT(!"WTF??");
+				STDCOUTL("*** " << NNTL_FUNCTION << ": Wrong type of optimizer specified!");
+				abort();
+			}
+			iI.apply_grad_postOptimizer(dLdWc, A, B, m_optBeta1t, m_optBeta2t);
+
+			if (bB) {
+				iM.mPutColsByIdx(B, pCols, m_optMtxB);
+				B.clear();
+				iM._istor_free(pTmpB, tmpNumel);
+			}
+			if (bA) {
+				iM.mPutColsByIdx(A, pCols, m_optMtxA);
+				A.clear();
+				iM._istor_free(pTmpA, tmpNumel);
+			}
+
+			iI.apply_grad_update(weights, dLdWc);
+			iM.mSubColsByIdx_ip(weights, pCols, dLdWc);
+
+#ifdef NNTL_AGGRESSIVE_NANS_DBG_CHECK
+			NNTL_ASSERT(weights.test_noNaNs());
+#endif // NNTL_AGGRESSIVE_NANS_DBG_CHECK
+			iI.apply_grad_end(weights);
+		}
+
 		//////////////////////////////////////////////////////////////////////////
 
 		self_ref_t learning_rate(const real_t learningRate)noexcept {
@@ -706,6 +917,35 @@ namespace nntl {
 
 		
 		bool isFirstRun()const noexcept { return get_opt(f_FirstRun); }
+
+		//////////////////////////////////////////////////////////////////////////
+		// optimizer state access (see _supp/io/checkpoint.h). State matrices are allocated by gw_init() and freed by
+		// gw_deinit(), therefore they are non-empty only during nnet::train() and only if current settings require them
+		enum StateMtx {
+			state_Vw = 0,
+			state_optMtxA,
+			state_optMtxB,
+
+			state_mtx_total
+		};
+		const realmtx_t& get_state_mtx(const StateMtx s)const noexcept {
+			NNTL_ASSERT(s < state_mtx_total);
+			return state_Vw == s ? m_Vw : (state_optMtxA == s ? m_optMtxA : m_optMtxB);
+		}
+		realmtx_t& get_state_mtx(const StateMtx s)noexcept {
+			NNTL_ASSERT(s < state_mtx_total);
+			return state_Vw == s ? m_Vw : (state_optMtxA == s ? m_optMtxA : m_optMtxB);
+		}
+		real_t state_beta1t()const noexcept { return m_optBeta1t; }
+		real_t state_beta2t()const noexcept { return m_optBeta2t; }
+
+		//call it after the state matrices were restored (after gw_init()), otherwise the first apply_grad() would reset them
+		self_ref_t restore_state(const real_t beta1t, const real_t beta2t)noexcept {
+			m_optBeta1t = beta1t;
+			m_optBeta2t = beta2t;
+			set_opt(f_FirstRun, false);
+			return get_self();
+		}
 	};
 
 
@@ -131,8 +131,9 @@ namespace inspector {
 		nntl_interface void fprop_preLRDropout4NesterovMomentum(const realmtx_t& vW, const real_t dpa, const realmtx_t& dropoutMask)const noexcept;
 		nntl_interface void fprop_postLRDropout4NesterovMomentum(const realmtx_t& vW)const noexcept;
 
-		//fprop_makePreActivations() has two forms - for layer that has params to learn
-		nntl_interface void fprop_makePreActivations(const realmtx_t& W, const realmtx_t& prevAct)const noexcept;
+		//fprop_makePreActivations() has two forms - for layer that has params to learn (wBlock is the weights block index of
+		// a layer with several weights matrices, see layer_has_weights_blocks)
+		nntl_interface void fprop_makePreActivations(const realmtx_t& W, const realmtx_t& prevAct, const unsigned wBlock = 0)const noexcept;
 		//and for layers without params to learn
 		nntl_interface void fprop_makePreActivations(const realmtx_t& prevAct)const noexcept;
 		nntl_interface void fprop_preactivations(const realmtx_t& Z)const noexcept;
@@ -163,7 +164,7 @@ namespace inspector {
 		nntl_interface void bprop_dAdZ(const realmtx_t& dAdZ) const noexcept;
 		nntl_interface void bprop_dLdZ(const realmtx_t& dLdZ) const noexcept;
 		nntl_interface void bprop_postClampdLdZ(const realmtx_t& dLdZ,const real_t& Ub, const real_t& Lb) const noexcept;
-		nntl_interface void bprop_dLdW(const realmtx_t& dLdZ, const realmtx_t& prevAct, const realmtx_t& dLdW) const noexcept;
+		nntl_interface void bprop_dLdW(const realmtx_t& dLdZ, const realmtx_t& prevAct, const realmtx_t& dLdW, const unsigned wBlock = 0) const noexcept;
 
 		nntl_interface void apply_grad_begin(const realmtx_t& W, const realmtx_t& dLdW)const noexcept;
 		nntl_interface void apply_grad_end(const realmtx_t& W)const noexcept;
@@ -261,8 +262,8 @@ namespace inspector {
 				NNTL_UNREF(vW);
 			}
 
-			void fprop_makePreActivations(const realmtx_t& W, const realmtx_t& prevAct)const noexcept {
-				NNTL_UNREF(W);				NNTL_UNREF(prevAct);
+			void fprop_makePreActivations(const realmtx_t& W, const realmtx_t& prevAct, const unsigned wBlock = 0)const noexcept {
+				NNTL_UNREF(W);				NNTL_UNREF(prevAct);				NNTL_UNREF(wBlock);
 			}
 			void fprop_makePreActivations(const realmtx_t& prevAct)const noexcept { NNTL_UNREF(prevAct); }
 			void fprop_preactivations(const realmtx_t& Z)const noexcept { NNTL_UNREF(Z); }
@@ -300,8 +301,8 @@ namespace inspector {
 			void bprop_postClampdLdZ(const realmtx_t& dLdZ, const real_t& Ub, const real_t& Lb) const noexcept{
 				NNTL_UNREF(dLdZ);				NNTL_UNREF(Ub);				NNTL_UNREF(Lb);
 			}
-			void bprop_dLdW(const realmtx_t& dLdZ, const realmtx_t& prevAct, const realmtx_t& dLdW) const noexcept {
-				NNTL_UNREF(dLdZ);				NNTL_UNREF(prevAct);				NNTL_UNREF(dLdW);
+			void bprop_dLdW(const realmtx_t& dLdZ, const realmtx_t& prevAct, const realmtx_t& dLdW, const unsigned wBlock = 0) const noexcept {
+				NNTL_UNREF(dLdZ);				NNTL_UNREF(prevAct);				NNTL_UNREF(dLdW);				NNTL_UNREF(wBlock);
 			}
 
 			void apply_grad_begin(const realmtx_t& W, const realmtx_t& dLdW)const noexcept {
@@ -316,6 +316,11 @@ namespace math {
 		// L = sum( -y*log(a) )/activations.rows(), dL/dz=a-y
 		nntl_interface real_t loss_softmax_xentropy(const realmtx_t& activations, const realmtx_t& data_y)noexcept;
 
+		// fused softmax() over preactivations Z and dL/dZ = a-y (no loss is computed)
+		nntl_interface void softmax_xentropy_dLdZ(realmtx_t& Z2dLdZ, const realmtx_t& data_y)noexcept;
+		// fused softmax() and loss_softmax_xentropy() over preactivations Z. Returns the same value loss_softmax_xentropy() does
+		nntl_interface real_t softmax_xentropy_loss(realmtx_t& Z2act, const realmtx_t& data_y)noexcept;
+
 		//////////////////////////////////////////////////////////////////////////
 		//gradient application procedures
 		nntl_interface void RMSProp_Hinton(realmtx_t& dW, realmtx_t& rmsF, const real_t learningRate,
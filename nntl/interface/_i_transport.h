@@ -0,0 +1,114 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//This file defines _i_transport interface to a provider of inter-process (or inter-thread) communication, that is
+//used by distributed data-parallel training (see nntl/distributed.h).
+//
+//The interface is ring-oriented on purpose: the only collective algorithms we need (ring all-reduce, ring all-gather and
+//ring broadcast) require each participant to talk only to its neighbours on a logical ring of world_size() participants.
+//Participant with rank r sends data to the next_rank()==(r+1)%world_size() and receives from the
+//prev_rank()==(r-1+world_size())%world_size().
+//
+//Implementations:
+//	- transport/inproc_ring.h - in-process ring for participants running in different threads. Mostly for testing,
+//								but may also be used to split one box into several data-parallel replicas
+//	- transport/shm_ring.h - POSIX shared memory ring for participants running in different processes on the same machine
+//
+//Real multi-box transports (sockets/MPI/whatever) should just implement the same interface.
+
+#include <cstddef>
+
+namespace nntl {
+namespace distributed {
+
+	struct _i_transport {
+	private:
+		typedef _i_transport self_t;
+
+	public:
+		//zero-based rank of this participant
+		nntl_interface int rank()const noexcept;
+		//total number of participants
+		nntl_interface int world_size()const noexcept;
+
+		nntl_interface int next_rank()const noexcept;
+		nntl_interface int prev_rank()const noexcept;
+
+		//simultaneously sends sendBytes bytes from pSend to the next_rank() and receives recvBytes bytes from the prev_rank()
+		// into pRecv. Blocks until both are done. Either of sendBytes or recvBytes may be 0.
+		//Both directions MUST be progressed together (not send-then-receive), because every participant calls it at the
+		// same time and a bounded channel would deadlock otherwise.
+		// Returns false on a transport failure (timeout, broken peer, etc). There's no way to recover from it, so the
+		// only sensible reaction is to stop the training.
+		nntl_interface bool exchange(const void* pSend, const size_t sendBytes, void* pRecv, const size_t recvBytes)noexcept;
+
+		//returns only when all participants have called barrier()
+		nntl_interface bool barrier()noexcept;
+	};
+
+	namespace _impl {
+		//some common code that any ring transport might use
+		template<typename FinalT>
+		class _ring_transport_base : public _i_transport {
+		protected:
+			typedef FinalT self_t;
+			NNTL_METHODS_SELF();
+
+		protected:
+			int m_rank, m_worldSize;
+
+			_ring_transport_base(const int r, const int ws)noexcept : m_rank(r), m_worldSize(ws) {
+				NNTL_ASSERT(ws > 0 && r >= 0 && r < ws);
+			}
+
+		public:
+			int rank()const noexcept { return m_rank; }
+			int world_size()const noexcept { return m_worldSize; }
+
+			int next_rank()const noexcept { return (m_rank + 1) % m_worldSize; }
+			int prev_rank()const noexcept { return (m_rank + m_worldSize - 1) % m_worldSize; }
+
+			//a token is passed over the ring world_size()-1 times. After the last round every participant knows that
+			// every other has entered the barrier().
+			bool barrier()noexcept {
+				char sTok = 1, rTok = 0;
+				for (int i = 1; i < m_worldSize; ++i) {
+					if (!get_self().exchange(&sTok, sizeof(sTok), &rTok, sizeof(rTok))) return false;
+				}
+				return true;
+			}
+		};
+	}
+
+}
+}
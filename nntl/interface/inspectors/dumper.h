@@ -166,6 +166,16 @@ namespace nntl {
 			};
 		}
 
+		//file extension of the archive. Archives may define static const char* sFileExt, ".mat" is used by default
+		template< class, class = ::std::void_t<> >
+		struct archive_file_ext {
+			static constexpr const char* value = "mat";
+		};
+		template< class ArchT >
+		struct archive_file_ext<ArchT, ::std::void_t<decltype(ArchT::sFileExt)>> {
+			static constexpr const char* value = ArchT::sFileExt;
+		};
+
 
 		template<typename FinalChildT, typename RealT, typename ArchiveT, typename CondDumpT, size_t maxNnetDepth = 32>
 		class _dumper_base 
@@ -311,11 +321,12 @@ namespace nntl {
 				if (m_DirToDump.empty()) _epic_fail("m_DirToDump is not set!");
 				if (omode == _ToDump::FProp || omode == _ToDump::BProp) {
 					NNTL_ASSERT(dataSetId == invalid_set_id);
-					sprintf_s(n, ml, omode == _ToDump::FProp ? "%s/ep%03zd_%03zd_f.mat" : "%s/ep%03zd_%03zd_b.mat"
-						, m_DirToDump.c_str(), m_epochIdx + 1, m_batchIdx);
+					sprintf_s(n, ml, omode == _ToDump::FProp ? "%s/ep%03zd_%03zd_f.%s" : "%s/ep%03zd_%03zd_b.%s"
+						, m_DirToDump.c_str(), m_epochIdx + 1, m_batchIdx, archive_file_ext<archive_t>::value);
 				} else {
 					NNTL_ASSERT(omode == _ToDump::CalcErrOnSet && dataSetId >= 0);
-					sprintf_s(n, ml, "%s/ep%03zd_err_%d.mat", m_DirToDump.c_str(), m_epochIdx + 1, dataSetId);
+					sprintf_s(n, ml, "%s/ep%03zd_err_%d.%s", m_DirToDump.c_str(), m_epochIdx + 1, dataSetId
+						, archive_file_ext<archive_t>::value);
 				}
 			}
 			template<bool b = bSplitFiles>
@@ -324,10 +335,12 @@ namespace nntl {
 				if (m_DirToDump.empty()) _epic_fail("m_DirToDump is not set!");
 				if (omode == _ToDump::FProp || omode == _ToDump::BProp) {
 					NNTL_ASSERT(dataSetId == invalid_set_id);
-					sprintf_s(n, ml, "%s/ep%03zd_%03zd_full.mat", m_DirToDump.c_str(), m_epochIdx + 1, m_batchIdx);
+					sprintf_s(n, ml, "%s/ep%03zd_%03zd_full.%s", m_DirToDump.c_str(), m_epochIdx + 1, m_batchIdx
+						, archive_file_ext<archive_t>::value);
 				} else {
 					NNTL_ASSERT(omode == _ToDump::CalcErrOnSet && dataSetId >= 0);
-					sprintf_s(n, ml, "%s/ep%03zd_err_%d.mat", m_DirToDump.c_str(), m_epochIdx + 1, dataSetId);
+					sprintf_s(n, ml, "%s/ep%03zd_err_%d.%s", m_DirToDump.c_str(), m_epochIdx + 1, dataSetId
+						, archive_file_ext<archive_t>::value);
 				}
 			}
 
@@ -560,12 +573,14 @@ namespace nntl {
 				}
 			}
 
-			void fprop_makePreActivations(const realmtx_t& W, const realmtx_t& prevAct)const noexcept {
+			void fprop_makePreActivations(const realmtx_t& W, const realmtx_t& prevAct, const unsigned wBlock = 0)const noexcept {
 				NNTL_UNREF(prevAct);
 				if (bDoDump(m_curLayer)) {
 					_verbalize("fprop_makePreActivations");
 					auto& ar = getArchive();
-					ar & serialization::make_nvp("W", W);
+					char wName[16] = "W";
+					if (wBlock) sprintf_s(wName, "W%u", wBlock);
+					ar & serialization::make_nvp(wName, W);
 					_check_err(ar.get_last_error(), "fprop_makePreActivations: saving W");
 				}
 			}
@@ -68,6 +68,8 @@ namespace inspector {
 		nntl::_impl::gradcheck_phase m_checkPhase;
 
 		mtx_coords_t m_coord;
+		//weights block to check (see layer_has_weights_blocks)
+		unsigned m_wBlock;
 
 		real_t m_stepSize;
 		real_t m_analyticalValue;
@@ -78,33 +80,54 @@ namespace inspector {
 		real_t* m_pChangedEl;
 		real_t m_origElVal;
 
+		//directional mode: the whole W is perturbed by +/-stepSize*(*m_pDirection) and the analytical value is <dL/dW, direction>
+		const realmtx_t* m_pDirection;
+		realmtx_t* m_pWBackup;
+
 		bool m_curLayerMayNeverRun;
 		
 	public:
 		~GradCheck() noexcept {}
-		GradCheck() noexcept : m_layerIdxToCheck(0), m_pChangedEl(nullptr) {}
+		GradCheck() noexcept : m_layerIdxToCheck(0), m_wBlock(0), m_pChangedEl(nullptr), m_pDirection(nullptr), m_pWBackup(nullptr) {}
 
 		void gc_reset()noexcept {
 			m_layerIdxToCheck = 0;
 			m_pChangedEl = nullptr;
+			m_pDirection = nullptr;
+			m_pWBackup = nullptr;
 		}
 
 		void gc_init(const real_t ss)noexcept {
 			m_stepSize = ss;
 			m_pChangedEl = nullptr;
+			m_pDirection = nullptr;
+			m_pWBackup = nullptr;
+		}
+		void gc_deinit()noexcept{
+			m_pChangedEl = nullptr;
+			m_pDirection = nullptr;
+			m_pWBackup = nullptr;
+		}
+
+		//switches dL/dW check to the directional derivative mode. pDirection must have the same size as the layer's W,
+		// pWBackup must be able to hold a copy of W. Pass nullptrs to return to the single element mode.
+		void gc_set_direction(const realmtx_t* pDirection, realmtx_t* pWBackup)noexcept {
+			NNTL_ASSERT(!pDirection == !pWBackup);
+			m_pDirection = pDirection;
+			m_pWBackup = pWBackup;
 		}
-		void gc_deinit()noexcept{ m_pChangedEl = nullptr; }
 
 		const auto gc_getCurParamsGroup()const noexcept {
 			return m_checkParamsGroup;
 		}
 
 		void gc_prep_check_layer(const layer_index_t lidx, const nntl::_impl::gradcheck_paramsGroup gcpg
-			, const mtx_coords_t& coord, const bool bMayNeverRun = false)noexcept
+			, const mtx_coords_t& coord, const bool bMayNeverRun = false, const unsigned wBlock = 0)noexcept
 		{
 			m_layerIdxToCheck = lidx;
 			m_checkParamsGroup = gcpg;
 			m_coord = coord;
+			m_wBlock = wBlock;
 			m_curLayerMayNeverRun = bMayNeverRun;
 			//return *this;
 		}
@@ -130,20 +153,36 @@ namespace inspector {
 			_base_class_t::fprop_begin(lIdx, prevAct, bTrainingMode);
 		}
 
-		void fprop_makePreActivations(const realmtx_t& W, const realmtx_t& prevAct)noexcept {
+		void fprop_makePreActivations(const realmtx_t& W, const realmtx_t& prevAct, const unsigned wBlock = 0)noexcept {
 			if (m_layerIdxToCheck) {
-				if (m_layerIdxToCheck == m_curLayer
+				if (m_layerIdxToCheck == m_curLayer && m_wBlock == wBlock
 					&& nntl::_impl::gradcheck_paramsGroup::dLdW == m_checkParamsGroup
 					&& nntl::_impl::gradcheck_phase::df_analytical != m_checkPhase)
 				{
 					NNTL_ASSERT(!m_pChangedEl);
-					m_pChangedEl = &const_cast<realmtx_t&>(W).get(m_coord);
-					m_origElVal = *m_pChangedEl;
-					*m_pChangedEl += nntl::_impl::gradcheck_phase::df_numeric_plus == m_checkPhase ? m_stepSize : -m_stepSize;
-					m_realBatchSize = prevAct.rows();
+					const real_t ss = nntl::_impl::gradcheck_phase::df_numeric_plus == m_checkPhase ? m_stepSize : -m_stepSize;
+					auto& w = const_cast<realmtx_t&>(W);
+					if (m_pDirection) {
+						NNTL_ASSERT(m_pDirection->size() == W.size() && m_pWBackup->size() == W.size());
+						//never touch memory out of W, the check just fails then, because the numeric value stays zero
+						if (m_pDirection->size() != W.size() || m_pWBackup->size() != W.size()) {
+							_base_class_t::fprop_makePreActivations(W, prevAct, wBlock);
+							return;
+						}
+						W.copy_to(*m_pWBackup);
+						const auto pD = m_pDirection->data();
+						const auto pW = w.data();
+						const auto ne = W.numel();
+						for (numel_cnt_t i = 0; i < ne; ++i) pW[i] += ss*pD[i];
+						m_pChangedEl = pW;
+					} else {
+						m_pChangedEl = &w.get(m_coord);
+						m_origElVal = *m_pChangedEl;
+						*m_pChangedEl += ss;
+					}
 				}
 			}
-			_base_class_t::fprop_makePreActivations(W, prevAct);
+			_base_class_t::fprop_makePreActivations(W, prevAct, wBlock);
 		}
 
 		void fprop_makePreActivations(const realmtx_t& prevAct)noexcept { _base_class_t::fprop_makePreActivations(prevAct); }
@@ -155,8 +194,14 @@ namespace inspector {
 					&& nntl::_impl::gradcheck_phase::df_analytical != m_checkPhase
 					&& m_pChangedEl)
 				{
-					*m_pChangedEl = m_origElVal;
+					//in directional mode m_pChangedEl points to the W data
+					if (m_pDirection) {
+						::std::memcpy(m_pChangedEl, m_pWBackup->data(), m_pWBackup->byte_size());
+					} else *m_pChangedEl = m_origElVal;
 					m_pChangedEl = nullptr;
+					//taking the batch size from Z instead of prevAct, because a layer tiled inplace by LPT computes
+					// k tiles of prevAct rows into a single Z
+					m_realBatchSize = Z.rows();
 				}
 			}
 			_base_class_t::fprop_preactivations(Z);
@@ -213,20 +258,28 @@ namespace inspector {
 			_base_class_t::bprop_finaldLdA(dLdA);
 		}
 
-		void bprop_dLdW(const realmtx_t& dLdZ, const realmtx_t& prevAct, const realmtx_t& dLdW) noexcept {
+		void bprop_dLdW(const realmtx_t& dLdZ, const realmtx_t& prevAct, const realmtx_t& dLdW, const unsigned wBlock = 0) noexcept {
 			if (m_layerIdxToCheck
-				&& m_layerIdxToCheck == m_curLayer
+				&& m_layerIdxToCheck == m_curLayer && m_wBlock == wBlock
 				&& nntl::_impl::gradcheck_paramsGroup::dLdW == m_checkParamsGroup
 				&& nntl::_impl::gradcheck_phase::df_analytical == m_checkPhase
 				//&& m_curLayer.bUpperLayerDifferent() //#todo there should be a check for proper m_curLayer.nestingLevel(),
-				// but it's not necessary now, because we expect only a single bprop_dLdW() call per layer.
+				// but it's not necessary now, because we expect only a single bprop_dLdW() call per weights block of a layer.
 				)
 			{
 				NNTL_ASSERT(::std::isnan(m_analyticalValue));
-				m_analyticalValue = dLdW.get(m_coord);
+				if (m_pDirection) {
+					NNTL_ASSERT(m_pDirection->size() == dLdW.size());
+					const auto pD = m_pDirection->data();
+					const auto pdW = dLdW.data();
+					const auto ne = ::std::min(dLdW.numel(), m_pDirection->numel());
+					real_t v = real_t(0);
+					for (numel_cnt_t i = 0; i < ne; ++i) v += pdW[i] * pD[i];
+					m_analyticalValue = v;
+				} else m_analyticalValue = dLdW.get(m_coord);
 				m_realBatchSize = dLdZ.rows();
 			}
-			_base_class_t::bprop_dLdW(dLdZ, prevAct, dLdW);
+			_base_class_t::bprop_dLdW(dLdZ, prevAct, dLdW, wBlock);
 		}
 
 		void bprop_end(const realmtx_t& dLdAPrev) noexcept {
@@ -140,8 +140,8 @@ namespace inspector {
 		}
 
 
-		void fprop_makePreActivations(const realmtx_t& W, const realmtx_t& prevAct)const noexcept {
-			NNTL_UNREF(prevAct);
+		void fprop_makePreActivations(const realmtx_t& W, const realmtx_t& prevAct, const unsigned wBlock = 0)const noexcept {
+			NNTL_UNREF(prevAct); NNTL_UNREF(wBlock);
 			inspect(W, "Current weights");
 		}
 
@@ -34,31 +34,59 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 namespace nntl {
 namespace math {
 
+	namespace _impl {
+		//monotonic mapping of floating point values to unsigned integers, the same idea as in ::boost::sort::spreadsort::float_sort
+		// https://www.boost.org/doc/libs/1_75_0/libs/sort/doc/html/sort/single_thread/spreadsort/sort_hpp/float_sort.html
+		// For any non-NaN a and b: (a < b) == (key(a) < key(b)) and (a == b) == (key(a) == key(b)) (-0.0 is mapped to +0.0)
+		template<typename T>
+		struct fp_radix_key {
+			static_assert(::std::is_floating_point<T>::value, "");
+			typedef ::std::conditional_t<sizeof(T) == sizeof(uint32_t), uint32_t, uint64_t> key_t;
+			static_assert(sizeof(key_t) == sizeof(T), "");
+
+			static constexpr unsigned keyBits = sizeof(key_t) * 8;
+			//a histogram over (1<<histBits) buckets of key's highest bits covers sign, the whole exponent
+			// and (for float) 3 highest bits of mantissa
+			static constexpr unsigned histBits = 12;
+			static constexpr unsigned histShift = keyBits - histBits;
+
+			static key_t key(const T v)noexcept {
+				const T c = (v == T(0)) ? T(0) : v;
+				key_t u;
+				::std::memcpy(&u, &c, sizeof(u));
+				//negative values are inverted, positive just get the sign bit set
+				return u ^ (static_cast<key_t>(key_t(0) - (u >> (keyBits - 1))) | (key_t(1) << (keyBits - 1)));
+			}
+		};
+	}
+
 	//functors to use with mcwFindKOrdered, member functions must be static
-	//Note that it's possible to speedup even more by utilizing the same idea as in ::bbost::sort::spreadsort::float_sort
-	// https://www.boost.org/doc/libs/1_75_0/libs/sort/doc/html/sort/single_thread/spreadsort/sort_hpp/float_sort.html
-	// i.e. compare floats as integers, but that's a bit too much for now, leave for #TODO
+	// radix_key() must return an unsigned integer that is bigger for a better value, see _impl::fp_radix_key
 
 	template<typename T>
 	struct Order_BiggestDistinct {
 		static constexpr T most_extreme()noexcept { return ::std::numeric_limits<T>::lowest(); }
 		static constexpr bool first_better(const T& vNew, const T& vOld)noexcept { return vNew > vOld; }
+		static typename _impl::fp_radix_key<T>::key_t radix_key(const T v)noexcept { return _impl::fp_radix_key<T>::key(v); }
 	};
 	template<typename T>
 	struct Order_Biggest {
 		static constexpr T most_extreme()noexcept { return ::std::numeric_limits<T>::lowest(); }
 		static constexpr bool first_better(const T& vNew, const T& vOld)noexcept { return vNew >= vOld; }
+		static typename _impl::fp_radix_key<T>::key_t radix_key(const T v)noexcept { return _impl::fp_radix_key<T>::key(v); }
 	};
 
 	template<typename T>
 	struct Order_SmallestDistinct {
 		static constexpr T most_extreme()noexcept { return ::std::numeric_limits<T>::max(); }
 		static constexpr bool first_better(const T& vNew, const T& vOld)noexcept { return vNew < vOld; }
+		static typename _impl::fp_radix_key<T>::key_t radix_key(const T v)noexcept { return ~_impl::fp_radix_key<T>::key(v); }
 	};
 	template<typename T>
 	struct Order_Smallest {
 		static constexpr T most_extreme()noexcept { return ::std::numeric_limits<T>::max(); }
 		static constexpr bool first_better(const T& vNew, const T& vOld)noexcept { return vNew <= vOld; }
+		static typename _impl::fp_radix_key<T>::key_t radix_key(const T v)noexcept { return ~_impl::fp_radix_key<T>::key(v); }
 	};
 
 	//////////////////////////////////////////////////////////////////////////
@@ -185,6 +213,11 @@ namespace math {
 	public:
 		typedef OrderTpl<SrcT> OrderFunctor_t;
 		typedef mcwFindKOrdered_hlpr<SrcT, OrderTpl> mcwFindKOrdered_hlpr_t;
+
+		typedef typename _impl::fp_radix_key<SrcT>::key_t radix_key_t;
+
+		//when true, equal values are not distinct and the latest of them takes the place in the cache
+		static constexpr bool bNonStrictComparision = OrderFunctor_t::first_better(OrderFunctor_t::most_extreme(), OrderFunctor_t::most_extreme());
 		
 		//mainly for debug use
 		static bool is_hlprmtx_ok(const hlprmtx_t& hlpr)noexcept {
@@ -0,0 +1,191 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//cache blocked transposition of a column major matrix with in-register SIMD tiles. Used by MathN::mTranspose_blocked_st()
+// and MathN::mTranspose_blocked_mt().
+// float uses SSE 4x4 tiles and double uses SSE2 2x2 sub-tiles of a 4x4 tile, both are always available on x64.
+// When the compiler targets AVX (/arch:AVX or -mavx, i.e. __AVX__ is defined), float uses 8x8 AVX tiles.
+// Other types are transposed with scalar tiles.
+
+#include <cstddef>
+#include <immintrin.h>
+
+namespace nntl {
+namespace math {
+
+	namespace _impl {
+
+		//transposes a tile of sTile x sTile elements. pS points to a column major source with leading dimension ldS,
+		// pD to a column major destination with leading dimension ldD, i.e. pD[r*ldD + c] = pS[c*ldS + r]
+		template<typename T>
+		struct transpose_tile {
+			static constexpr ptrdiff_t sTile = 4;
+
+			static void full(const T*__restrict pS, const ptrdiff_t ldS, T*__restrict pD, const ptrdiff_t ldD)noexcept {
+				for (ptrdiff_t c = 0; c < sTile; ++c) {
+					for (ptrdiff_t r = 0; r < sTile; ++r) {
+						pD[r*ldD + c] = pS[c*ldS + r];
+					}
+				}
+			}
+		};
+
+	#if defined(__AVX__)
+		template<>
+		struct transpose_tile<float> {
+			static constexpr ptrdiff_t sTile = 8;
+
+			static void full(const float*__restrict pS, const ptrdiff_t ldS, float*__restrict pD, const ptrdiff_t ldD)noexcept {
+				//i-th register holds i-th source column
+				const __m256 r0 = _mm256_loadu_ps(pS), r1 = _mm256_loadu_ps(pS + ldS)
+					, r2 = _mm256_loadu_ps(pS + 2 * ldS), r3 = _mm256_loadu_ps(pS + 3 * ldS)
+					, r4 = _mm256_loadu_ps(pS + 4 * ldS), r5 = _mm256_loadu_ps(pS + 5 * ldS)
+					, r6 = _mm256_loadu_ps(pS + 6 * ldS), r7 = _mm256_loadu_ps(pS + 7 * ldS);
+
+				const __m256 t0 = _mm256_unpacklo_ps(r0, r1), t1 = _mm256_unpackhi_ps(r0, r1)
+					, t2 = _mm256_unpacklo_ps(r2, r3), t3 = _mm256_unpackhi_ps(r2, r3)
+					, t4 = _mm256_unpacklo_ps(r4, r5), t5 = _mm256_unpackhi_ps(r4, r5)
+					, t6 = _mm256_unpacklo_ps(r6, r7), t7 = _mm256_unpackhi_ps(r6, r7);
+
+				const __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2))
+					, s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2))
+					, s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0)), s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2))
+					, s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0)), s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+				//i-th register holds i-th source row, i.e. i-th destination column
+				_mm256_storeu_ps(pD, _mm256_permute2f128_ps(s0, s4, 0x20));
+				_mm256_storeu_ps(pD + ldD, _mm256_permute2f128_ps(s1, s5, 0x20));
+				_mm256_storeu_ps(pD + 2 * ldD, _mm256_permute2f128_ps(s2, s6, 0x20));
+				_mm256_storeu_ps(pD + 3 * ldD, _mm256_permute2f128_ps(s3, s7, 0x20));
+				_mm256_storeu_ps(pD + 4 * ldD, _mm256_permute2f128_ps(s0, s4, 0x31));
+				_mm256_storeu_ps(pD + 5 * ldD, _mm256_permute2f128_ps(s1, s5, 0x31));
+				_mm256_storeu_ps(pD + 6 * ldD, _mm256_permute2f128_ps(s2, s6, 0x31));
+				_mm256_storeu_ps(pD + 7 * ldD, _mm256_permute2f128_ps(s3, s7, 0x31));
+			}
+		};
+
+	#else //defined(__AVX__)
+
+		template<>
+		struct transpose_tile<float> {
+			static constexpr ptrdiff_t sTile = 4;
+
+			static void full(const float*__restrict pS, const ptrdiff_t ldS, float*__restrict pD, const ptrdiff_t ldD)noexcept {
+				__m128 r0 = _mm_loadu_ps(pS), r1 = _mm_loadu_ps(pS + ldS), r2 = _mm_loadu_ps(pS + 2 * ldS), r3 = _mm_loadu_ps(pS + 3 * ldS);
+				_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+				_mm_storeu_ps(pD, r0);
+				_mm_storeu_ps(pD + ldD, r1);
+				_mm_storeu_ps(pD + 2 * ldD, r2);
+				_mm_storeu_ps(pD + 3 * ldD, r3);
+			}
+		};
+
+	#endif //defined(__AVX__)
+
+		//used with AVX too, the 256 bit 4x4 version needs cross lane permutes and measured slower
+		template<>
+		struct transpose_tile<double> {
+			static constexpr ptrdiff_t sTile = 4;
+
+			static void full(const double*__restrict pS, const ptrdiff_t ldS, double*__restrict pD, const ptrdiff_t ldD)noexcept {
+				for (ptrdiff_t c = 0; c < sTile; c += 2) {
+					for (ptrdiff_t r = 0; r < sTile; r += 2) {
+						const __m128d c0 = _mm_loadu_pd(pS + c*ldS + r), c1 = _mm_loadu_pd(pS + (c + 1)*ldS + r);
+						_mm_storeu_pd(pD + r*ldD + c, _mm_unpacklo_pd(c0, c1));
+						_mm_storeu_pd(pD + (r + 1)*ldD + c, _mm_unpackhi_pd(c0, c1));
+					}
+				}
+			}
+		};
+
+		//cache oblivious transposition: the block is recursively split in halves along its bigger dimension until it
+		// fits into sBlock x sBlock, then the block is processed with transpose_tile<T> tiles and scalar edges.
+		// Split points are multiples of sBlock, so all tiles but the edge ones are processed by the SIMD code.
+		template<typename T>
+		struct transpose_blocked {
+			typedef transpose_tile<T> tile_t;
+			static constexpr ptrdiff_t sTile = tile_t::sTile;
+
+			//sBlock x sBlock elements of src and the same of dest should fit into L1 cache together
+			static constexpr ptrdiff_t sBlock = sizeof(T) > 4 ? 32 : 64;
+			static_assert(0 == sBlock % sTile, "");
+
+			//transposes rows x cols block of pS (column major, leading dimension ldS) into pD (leading dimension ldD)
+			static void block(const T*__restrict pS, const ptrdiff_t ldS, T*__restrict pD, const ptrdiff_t ldD
+				, const ptrdiff_t rows, const ptrdiff_t cols)noexcept
+			{
+				if (rows <= sBlock && cols <= sBlock) {
+					_leaf(pS, ldS, pD, ldD, rows, cols);
+				} else if (rows >= cols) {
+					const auto r2 = _split(rows);
+					block(pS, ldS, pD, ldD, r2, cols);
+					block(pS + r2, ldS, pD + r2*ldD, ldD, rows - r2, cols);
+				} else {
+					const auto c2 = _split(cols);
+					block(pS, ldS, pD, ldD, rows, c2);
+					block(pS + c2*ldS, ldS, pD + c2, ldD, rows, cols - c2);
+				}
+			}
+
+		protected:
+			//returns a half of n>sBlock rounded up to a multiple of sBlock, that is always less than n
+			static constexpr ptrdiff_t _split(const ptrdiff_t n)noexcept {
+				return ((n / 2 + sBlock - 1) / sBlock)*sBlock;
+			}
+
+			static void _leaf(const T*__restrict pS, const ptrdiff_t ldS, T*__restrict pD, const ptrdiff_t ldD
+				, const ptrdiff_t rows, const ptrdiff_t cols)noexcept
+			{
+				const ptrdiff_t rowsT = rows - rows % sTile, colsT = cols - cols % sTile;
+				for (ptrdiff_t c = 0; c < colsT; c += sTile) {
+					for (ptrdiff_t r = 0; r < rowsT; r += sTile) {
+						tile_t::full(pS + c*ldS + r, ldS, pD + r*ldD + c, ldD);
+					}
+					for (ptrdiff_t cc = c; cc < c + sTile; ++cc) {
+						for (ptrdiff_t r = rowsT; r < rows; ++r) {
+							pD[r*ldD + cc] = pS[cc*ldS + r];
+						}
+					}
+				}
+				for (ptrdiff_t c = colsT; c < cols; ++c) {
+					for (ptrdiff_t r = 0; r < rows; ++r) {
+						pD[r*ldD + c] = pS[c*ldS + r];
+					}
+				}
+			}
+		};
+
+	}
+
+}
+}
@@ -43,8 +43,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "mathn_thr.h"
 
 #include "smath.h"
+#include "smatrix_csr.h"
 
 #include "_mcwFindKOrdered_hlpr.h"
+#include "_transpose_hlpr.h"
 
 namespace nntl {
 namespace math {
@@ -59,9 +61,14 @@ namespace math {
 		typedef _SMath<RealT, iThreadsT, iMemmgrT, ThresholdsT, FinalPolymorphChild> base_class_t;
 		typedef bindingBlasT b_BLAS_t;
 
-		using base_class_t::real_t;
-		using base_class_t::realmtx_t;
-		using base_class_t::realmtxdef_t;
+		using typename base_class_t::real_t;
+		using typename base_class_t::realmtx_t;
+		using typename base_class_t::realmtxdef_t;
+		using typename base_class_t::Thresholds_t;
+		using typename base_class_t::self_t;
+
+		template<typename T>
+		using converter_reduce_data_tpl = typename base_class_t::template converter_reduce_data_tpl<T>;
 		//using base_class_t::numel_cnt_t;
 		//using base_class_t::vec_len_t;
 
@@ -83,14 +90,14 @@ namespace math {
 			_mrw_SOFTMAXPARTS(const real_t*const _pMax, real_t*const _pNum)noexcept : pMax(_pMax), pNumerator(_pNum) {}
 
 			template<_OperationType OpType, typename BaseT>
-			::std::enable_if_t<OpType == mrw_cw> op(const BaseT& mtxElm, BaseT& vecElm, const numel_cnt_t r, const numel_cnt_t c, const numel_cnt_t mtxRows)noexcept {
+			::std::enable_if_t<OpType == base_class_t::mrw_cw> op(const BaseT& mtxElm, BaseT& vecElm, const numel_cnt_t r, const numel_cnt_t c, const numel_cnt_t mtxRows)noexcept {
 				const auto numerator = ::std::exp(mtxElm - *(pMax + r));
 				vecElm += numerator;
 				*(pNumerator + r) = numerator;
 			}
 
 			template<_OperationType OpType, typename BaseT>
-			::std::enable_if_t<OpType == mrw_rw> op(const BaseT& mtxElm, BaseT& vecElm, const numel_cnt_t r, const numel_cnt_t c, const numel_cnt_t mtxRows)noexcept {
+			::std::enable_if_t<OpType == base_class_t::mrw_rw> op(const BaseT& mtxElm, BaseT& vecElm, const numel_cnt_t r, const numel_cnt_t c, const numel_cnt_t mtxRows)noexcept {
 				const auto numerator = ::std::exp(mtxElm - *pMx);
 				vecElm += numerator;
 				*pNum = numerator;
@@ -124,6 +131,7 @@ namespace math {
 
 		~_MathN()noexcept {};
 		_MathN() noexcept : base_class_t() {}
+		explicit _MathN(const thread_id_t nThreads) noexcept : base_class_t(nThreads) {}
 
 		//////////////////////////////////////////////////////////////////////////
 		// i_math interface implementation
@@ -725,6 +733,343 @@ namespace math {
 			}
 		}
 
+		//////////////////////////////////////////////////////////////////////////
+		//////////////////////////////////////////////////////////////////////////
+		// Index based versions of mExtractRowsByMask()/mFillRowsByMask(). Row indexes pIdxs must be sorted ascending and
+		// might be obtained with vMakeIdxsOfNonZeros() from the mask only once to be reused for many matrices. There's
+		// no mask scanning at all and only the rows referenced are read (extract) or computed (fill).
+		//dest.rows() is the number of indexes in pIdxs
+		//biases are ignored!
+		void mExtractRowsByIdx(const realmtx_t& src, const vec_len_t*const pIdxs, realmtx_t& dest)noexcept {
+			if (src.numel_no_bias() < Thresholds_t::mExtractRowsByIdx) {
+				get_self().mExtractRowsByIdx_st(src, pIdxs, dest);
+			} else get_self().mExtractRowsByIdx_mt(src, pIdxs, dest);
+		}
+		void mExtractRowsByIdx_st(const realmtx_t& src, const vec_len_t*const pIdxs, realmtx_t& dest)noexcept {
+			NNTL_ASSERT(!src.empty() && pIdxs && !dest.empty() && src.cols_no_bias() == dest.cols_no_bias());
+			NNTL_ASSERT(dest.rows() <= src.rows() && dest.rows());
+
+			if (dest.rows() == src.rows()) {
+				//just copying src to dest
+				const auto b = src.copy_data_skip_bias(dest);
+				NNTL_ASSERT(b);
+			} else {
+				get_self()._imExtractRowsByIdx_st(src, pIdxs, dest, elms_range(0, src.cols_no_bias()));
+			}
+		}
+		static void _imExtractRowsByIdx_st(const realmtx_t& src, const vec_len_t*const pIdxs, realmtx_t& dest, const elms_range& er)noexcept {
+			NNTL_ASSERT(dest.rows() < src.rows() && dest.rows());
+			NNTL_ASSERT(src.cols_no_bias() >= er.elmEnd);
+
+			const numel_cnt_t sr = src.rows(), dr = dest.rows(), tc = er.totalElements();
+			NNTL_ASSERT(tc);
+			auto pS = src.colDataAsVec(static_cast<vec_len_t>(er.elmBegin));
+			auto pD = dest.colDataAsVec(static_cast<vec_len_t>(er.elmBegin));
+			for (numel_cnt_t ci = 0; ci < tc; ++ci) {
+				for (numel_cnt_t i = 0; i < dr; ++i) {
+					NNTL_ASSERT(pIdxs[i] < sr && (!i || pIdxs[i - 1] < pIdxs[i]));
+					pD[i] = pS[pIdxs[i]];
+				}
+				pS += sr;
+				pD += dr;
+			}
+		}
+		void mExtractRowsByIdx_mt(const realmtx_t& src, const vec_len_t*const pIdxs, realmtx_t& dest)noexcept {
+			NNTL_ASSERT(!src.empty() && pIdxs && !dest.empty() && src.cols_no_bias() == dest.cols_no_bias());
+			NNTL_ASSERT(dest.rows() <= src.rows() && dest.rows());
+
+			if (dest.rows() == src.rows()) {
+				//just copying src to dest
+				const auto b = src.copy_data_skip_bias(dest);
+				NNTL_ASSERT(b);
+			} else {
+				m_threads.run([&src, pIdxs, &dest, this](const par_range_t& r) noexcept{
+					get_self()._imExtractRowsByIdx_st(src, pIdxs, dest, elms_range(r));
+				}, src.cols_no_bias());
+			}
+		}
+
+		//src.rows() is the number of indexes in pIdxs. Rows of dest that aren't referenced by pIdxs are zeroed.
+		//biases are ignored!
+		void mFillRowsByIdx(const realmtx_t& src, const vec_len_t*const pIdxs, realmtx_t& dest)noexcept {
+			if (dest.numel_no_bias() < Thresholds_t::mFillRowsByIdx) {
+				get_self().mFillRowsByIdx_st(src, pIdxs, dest);
+			} else get_self().mFillRowsByIdx_mt(src, pIdxs, dest);
+		}
+		void mFillRowsByIdx_st(const realmtx_t& src, const vec_len_t*const pIdxs, realmtx_t& dest)noexcept {
+			NNTL_ASSERT(!src.empty() && pIdxs && !dest.empty() && src.cols_no_bias() == dest.cols_no_bias());
+			NNTL_ASSERT(src.rows() <= dest.rows() && src.rows());
+
+			if (dest.rows() == src.rows()) {
+				//just copying src to dest
+				const auto b = src.copy_data_skip_bias(dest);
+				NNTL_ASSERT(b);
+			} else {
+				get_self()._imFillRowsByIdx_st(src, pIdxs, dest, elms_range(0, dest.cols_no_bias()));
+			}
+		}
+		static void _imFillRowsByIdx_st(const realmtx_t& src, const vec_len_t*const pIdxs, realmtx_t& dest, const elms_range& er)noexcept {
+			NNTL_ASSERT(dest.cols_no_bias() >= er.elmEnd);
+			NNTL_ASSERT(src.rows() < dest.rows() && src.rows());
+
+			const vec_len_t sr = src.rows(), dr = dest.rows();
+			const numel_cnt_t tc = er.totalElements();
+			NNTL_ASSERT(tc);
+			auto pS = src.colDataAsVec(static_cast<vec_len_t>(er.elmBegin));
+			auto pD = dest.colDataAsVec(static_cast<vec_len_t>(er.elmBegin));
+			for (numel_cnt_t ci = 0; ci < tc; ++ci) {
+				vec_len_t r = 0;
+				for (vec_len_t i = 0; i < sr; ++i) {
+					const auto ri = pIdxs[i];
+					NNTL_ASSERT(ri >= r && ri < dr);
+					//zeroing the gap before the next referenced row
+					while (r < ri) pD[r++] = real_t(0);
+					pD[r++] = pS[i];
+				}
+				while (r < dr) pD[r++] = real_t(0);
+
+				pS += sr;
+				pD += dr;
+			}
+		}
+		void mFillRowsByIdx_mt(const realmtx_t& src, const vec_len_t*const pIdxs, realmtx_t& dest)noexcept {
+			NNTL_ASSERT(!src.empty() && pIdxs && !dest.empty() && src.cols_no_bias() == dest.cols_no_bias());
+			NNTL_ASSERT(src.rows() <= dest.rows() && src.rows());
+
+			if (dest.rows() == src.rows()) {
+				//just copying src to dest
+				const auto b = src.copy_data_skip_bias(dest);
+				NNTL_ASSERT(b);
+			} else {
+				m_threads.run([&src, pIdxs, &dest, this](const par_range_t& r) noexcept{
+					get_self()._imFillRowsByIdx_st(src, pIdxs, dest, elms_range(r));
+				}, dest.cols_no_bias());
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// Column versions for the sparse weights update (see _grad_works::apply_grad_sparse()). Columns are contiguous,
+		// so these are just a bunch of memcpy()s. pIdxs mustn't contain duplicates, but needn't be sorted.
+		// dest.cols() (src.cols() for Put/Sub) is the number of indexes in pIdxs. Biases are not expected.
+		static void mExtractColsByIdx(const realmtx_t& src, const vec_len_t*const pIdxs, realmtx_t& dest)noexcept {
+			NNTL_ASSERT(!src.empty() && pIdxs && !dest.empty() && !src.emulatesBiases() && !dest.emulatesBiases());
+			NNTL_ASSERT(src.rows() == dest.rows() && dest.cols() <= src.cols());
+			const vec_len_t dc = dest.cols(), sc = src.cols();
+			const size_t colBytes = sizeof(real_t)*static_cast<size_t>(src.rows());
+			NNTL_UNREF(sc);
+			for (vec_len_t i = 0; i < dc; ++i) {
+				NNTL_ASSERT(pIdxs[i] < sc);
+				::std::memcpy(dest.colDataAsVec(i), src.colDataAsVec(pIdxs[i]), colBytes);
+			}
+		}
+		//columns of dest that aren't referenced by pIdxs are left untouched
+		static void mPutColsByIdx(const realmtx_t& src, const vec_len_t*const pIdxs, realmtx_t& dest)noexcept {
+			NNTL_ASSERT(!src.empty() && pIdxs && !dest.empty() && !src.emulatesBiases() && !dest.emulatesBiases());
+			NNTL_ASSERT(src.rows() == dest.rows() && src.cols() <= dest.cols());
+			const vec_len_t sc = src.cols(), dc = dest.cols();
+			const size_t colBytes = sizeof(real_t)*static_cast<size_t>(src.rows());
+			NNTL_UNREF(dc);
+			for (vec_len_t i = 0; i < sc; ++i) {
+				NNTL_ASSERT(pIdxs[i] < dc);
+				::std::memcpy(dest.colDataAsVec(pIdxs[i]), src.colDataAsVec(i), colBytes);
+			}
+		}
+		//dest(:,pIdxs(i)) -= src(:,i)
+		static void mSubColsByIdx_ip(realmtx_t& dest, const vec_len_t*const pIdxs, const realmtx_t& src)noexcept {
+			NNTL_ASSERT(!src.empty() && pIdxs && !dest.empty() && !src.emulatesBiases() && !dest.emulatesBiases());
+			NNTL_ASSERT(src.rows() == dest.rows() && src.cols() <= dest.cols());
+			const vec_len_t sc = src.cols(), dc = dest.cols();
+			const numel_cnt_t rc = src.rows();
+			NNTL_UNREF(dc);
+			const real_t* pS = src.data();
+			for (vec_len_t i = 0; i < sc; ++i) {
+				NNTL_ASSERT(pIdxs[i] < dc);
+				real_t*const pD = dest.colDataAsVec(pIdxs[i]);
+				for (numel_cnt_t r = 0; r < rc; ++r) pD[r] -= pS[r];
+				pS += rc;
+			}
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// Embedding lookup (see layer/embedding.h). ids is a [batchSize, C] matrix of category ids (stored as real_t values,
+		// biases are ignored), W is a [D, V] table of embedding vectors (one per column) and act is [batchSize, C*D] (biases are
+		// ignored). act(r, c*D+d) = W(d, ids(r,c))
+		void mGatherEmbeddings(const realmtx_t& ids, const realmtx_t& W, realmtx_t& act)noexcept {
+			if (act.numel_no_bias() < Thresholds_t::mGatherEmbeddings) {
+				get_self().mGatherEmbeddings_st(ids, W, act);
+			} else get_self().mGatherEmbeddings_mt(ids, W, act);
+		}
+		void mGatherEmbeddings_st(const realmtx_t& ids, const realmtx_t& W, realmtx_t& act)noexcept {
+			get_self()._imGatherEmbeddings_st(ids, W, act, elms_range(0, act.rows()));
+		}
+		//the work is split over the rows of act
+		static void _imGatherEmbeddings_st(const realmtx_t& ids, const realmtx_t& W, realmtx_t& act, const elms_range& er)noexcept {
+			NNTL_ASSERT(!ids.empty() && !W.empty() && !act.empty() && !W.emulatesBiases());
+			NNTL_ASSERT(ids.bBatchInColumn() && act.bBatchInColumn() && ids.rows() == act.rows());
+			NNTL_ASSERT(act.cols_no_bias() == ids.cols_no_bias()*W.rows());
+
+			const numel_cnt_t br = act.rows(), D = W.rows(), C = ids.cols_no_bias();
+			const vec_len_t V = W.cols();
+			NNTL_UNREF(V);
+			const auto pIds = ids.data();
+			const auto pW = W.data();
+			const auto pA = act.data();
+			for (numel_cnt_t c = 0; c < C; ++c) {
+				const auto pIdsCol = pIds + c*br;
+				const auto pACol = pA + c*D*br;
+				for (numel_cnt_t r = er.elmBegin; r < er.elmEnd; ++r) {
+					const auto id = static_cast<vec_len_t>(pIdsCol[r]);
+					NNTL_ASSERT(real_t(id) == pIdsCol[r] && id < V);
+					const auto pE = pW + D*id;
+					auto pDst = pACol + r;
+					for (numel_cnt_t d = 0; d < D; ++d) {
+						*pDst = pE[d];
+						pDst += br;
+					}
+				}
+			}
+		}
+		void mGatherEmbeddings_mt(const realmtx_t& ids, const realmtx_t& W, realmtx_t& act)noexcept {
+			NNTL_ASSERT(!act.empty());
+			m_threads.run([&ids, &W, &act, this](const par_range_t& r) noexcept{
+				get_self()._imGatherEmbeddings_st(ids, W, act, elms_range(r));
+			}, act.rows());
+		}
+
+		//Backward pass of the embedding lookup: computes the compact gradient dLdWc [D, U] of the U distinct embedding vectors
+		// used in the batch. pSlots is a [batchSize, C] column-major array that maps each ids(r,c) to the column of dLdWc
+		// (see _LE::_le_make_slots()). dLdWc(d, pSlots(r,c)) = sc * Sum( dLdA(r, c*D+d) ) over all (r,c) that map to the column.
+		// Biases of dLdA are ignored. dLdWc is overwritten.
+		void mScatterAddEmbeddingsGrad(const real_t sc, const realmtx_t& dLdA, const vec_len_t*const pSlots, realmtx_t& dLdWc)noexcept {
+			if (dLdA.numel_no_bias() < Thresholds_t::mScatterAddEmbeddingsGrad) {
+				get_self().mScatterAddEmbeddingsGrad_st(sc, dLdA, pSlots, dLdWc);
+			} else get_self().mScatterAddEmbeddingsGrad_mt(sc, dLdA, pSlots, dLdWc);
+		}
+		void mScatterAddEmbeddingsGrad_st(const real_t sc, const realmtx_t& dLdA, const vec_len_t*const pSlots, realmtx_t& dLdWc)noexcept {
+			get_self()._imScatterAddEmbeddingsGrad_st(sc, dLdA, pSlots, dLdWc, elms_range(0, dLdWc.rows()));
+		}
+		//the work is split over the embedding dimensions (rows of dLdWc), so the threads never write to the same element
+		static void _imScatterAddEmbeddingsGrad_st(const real_t sc, const realmtx_t& dLdA, const vec_len_t*const pSlots
+			, realmtx_t& dLdWc, const elms_range& er)noexcept
+		{
+			NNTL_ASSERT(!dLdA.empty() && pSlots && !dLdWc.empty() && !dLdWc.emulatesBiases() && dLdA.bBatchInColumn());
+			NNTL_ASSERT(dLdA.cols_no_bias() % dLdWc.rows() == 0 && er.elmEnd <= static_cast<numel_cnt_t>(dLdWc.rows()));
+
+			const numel_cnt_t br = dLdA.rows(), D = dLdWc.rows(), U = dLdWc.cols();
+			const numel_cnt_t C = dLdA.cols_no_bias() / D;
+			const auto pG = dLdWc.data();
+			for (numel_cnt_t u = 0; u < U; ++u) {
+				const auto pGc = pG + u*D;
+				for (numel_cnt_t d = er.elmBegin; d < er.elmEnd; ++d) pGc[d] = real_t(0);
+			}
+
+			const auto pdA = dLdA.data();
+			for (numel_cnt_t c = 0; c < C; ++c) {
+				const auto pSlotsCol = pSlots + c*br;
+				for (numel_cnt_t d = er.elmBegin; d < er.elmEnd; ++d) {
+					const auto pdACol = pdA + (c*D + d)*br;
+					const auto pGd = pG + d;
+					for (numel_cnt_t r = 0; r < br; ++r) {
+						NNTL_ASSERT(pSlotsCol[r] < U);
+						pGd[D*pSlotsCol[r]] += pdACol[r];
+					}
+				}
+			}
+
+			if (sc != real_t(1)) {
+				for (numel_cnt_t u = 0; u < U; ++u) {
+					const auto pGc = pG + u*D;
+					for (numel_cnt_t d = er.elmBegin; d < er.elmEnd; ++d) pGc[d] *= sc;
+				}
+			}
+		}
+		void mScatterAddEmbeddingsGrad_mt(const real_t sc, const realmtx_t& dLdA, const vec_len_t*const pSlots, realmtx_t& dLdWc)noexcept {
+			NNTL_ASSERT(!dLdWc.empty());
+			m_threads.run([sc, &dLdA, pSlots, &dLdWc, this](const par_range_t& r) noexcept{
+				get_self()._imScatterAddEmbeddingsGrad_st(sc, dLdA, pSlots, dLdWc, elms_range(r));
+			}, dLdWc.rows());
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// Magnitude pruning support (see layer/fully_connected_pruned.h)
+		// 
+		// Updates the mask of [n, p+1] weight matrix W so that for every neuron (row) exactly floor(sparsity*p) of its
+		// p non-bias weights with the smallest magnitudes are masked out (mask==0). Weights that are already masked out are
+		// treated as the smallest ones, so the mask never grows back (it must be filled with ones before the first call).
+		// The bias column of the mask is always 1.
+		// Masked out weights of W are zeroed.
+		//		Restrictions: MUST NOT use the math object's local storage (it's called outside of fprop()/bprop())
+		static void mMakePruneMaskByMagnitude(realmtx_t& W, const real_t sparsity, realmtx_t& mask)noexcept {
+			NNTL_ASSERT(!W.empty() && !W.emulatesBiases() && W.size() == mask.size() && W.cols() > 1);
+			NNTL_ASSERT(sparsity >= real_t(0) && sparsity < real_t(1));
+
+			const numel_cnt_t n = W.rows();
+			const vec_len_t p = W.cols() - 1;
+			const auto k = static_cast<vec_len_t>(sparsity*p);
+			mask.fill_column_with(p, real_t(1));
+			if (k <= 0) return;
+
+			::std::vector<vec_len_t> idxs(p);
+			::std::vector<real_t> mag(p);
+			const auto pW = W.data();
+			const auto pM = mask.data();
+			for (numel_cnt_t r = 0; r < n; ++r) {
+				for (vec_len_t c = 0; c < p; ++c) {
+					idxs[c] = c;
+					mag[c] = pM[r + n*c] == real_t(0) ? real_t(-1) : ::std::abs(pW[r + n*c]);
+				}
+				::std::nth_element(idxs.begin(), idxs.begin() + k, idxs.end(), [&mag](const vec_len_t a, const vec_len_t b)noexcept {
+					return mag[a] < mag[b];
+				});
+				for (vec_len_t i = 0; i < k; ++i) {
+					pM[r + n*idxs[i]] = real_t(0);
+					pW[r + n*idxs[i]] = real_t(0);
+				}
+				for (vec_len_t i = k; i < p; ++i) pM[r + n*idxs[i]] = real_t(1);
+			}
+		}
+
+		// C = A*B' for a sparse B (see smatrix_csr.h). A is [m, B.cols()] (it may have biases, they are treated as an ordinary
+		// column), C is [m, B.rows()] (biases, if any, are left untouched). Used as the SpMM replacement of
+		// mMul_prevAct_weights_2_act() (B is the CSR of weights) and of mMul_dLdZ_weights_2_dLdAPrev() (B is the transposed
+		// CSR of weights without the bias column).
+		void mMulABt_sparseB(const realmtx_t& A, const smatrix_csr<real_t>& B, realmtx_t& C)noexcept {
+			if (B.nnz()*A.rows() < Thresholds_t::mMulABt_sparseB) {
+				get_self().mMulABt_sparseB_st(A, B, C);
+			} else get_self().mMulABt_sparseB_mt(A, B, C);
+		}
+		void mMulABt_sparseB_st(const realmtx_t& A, const smatrix_csr<real_t>& B, realmtx_t& C)noexcept {
+			get_self()._imMulABt_sparseB_st(A, B, C, elms_range(0, B.rows()));
+		}
+		//the work is split over the columns of C (rows of B)
+		static void _imMulABt_sparseB_st(const realmtx_t& A, const smatrix_csr<real_t>& B, realmtx_t& C, const elms_range& er)noexcept {
+			NNTL_ASSERT(!A.empty() && !B.empty() && !C.empty() && A.bBatchInColumn() && C.bBatchInColumn());
+			NNTL_ASSERT(A.rows() == C.rows() && A.cols() == B.cols() && C.cols_no_bias() == B.rows());
+
+			const numel_cnt_t m = A.rows();
+			const auto pA = A.data();
+			const auto pRP = B.rowPtr();
+			const auto pCI = B.colIdx();
+			const auto pV = B.vals();
+			for (numel_cnt_t i = er.elmBegin; i < er.elmEnd; ++i) {
+				const auto pC = C.colDataAsVec(static_cast<vec_len_t>(i));
+				for (numel_cnt_t r = 0; r < m; ++r) pC[r] = real_t(0);
+
+				const auto kEnd = pRP[i + 1];
+				for (auto k = pRP[i]; k < kEnd; ++k) {
+					const real_t v = pV[k];
+					const auto pACol = pA + m*pCI[k];
+					for (numel_cnt_t r = 0; r < m; ++r) pC[r] += v*pACol[r];
+				}
+			}
+		}
+		void mMulABt_sparseB_mt(const realmtx_t& A, const smatrix_csr<real_t>& B, realmtx_t& C)noexcept {
+			NNTL_ASSERT(!B.empty());
+			m_threads.run([&A, &B, &C, this](const par_range_t& r) noexcept{
+				get_self()._imMulABt_sparseB_st(A, B, C, elms_range(r));
+			}, B.rows());
+		}
+
 		//////////////////////////////////////////////////////////////////////////
 		//////////////////////////////////////////////////////////////////////////
 		// Extract whole submatrix dest from source matrix src starting at rowOfs.
@@ -1056,6 +1401,24 @@ namespace math {
 			return nz;
 		}
 
+		//Stores indexes of non-zero elements of pVec into pIdxs (it must have room for ne elements) and returns their count,
+		// i.e. it's vCountNonZeros() that also produces the index list for mExtractRowsByIdx()/mFillRowsByIdx()
+		// Don't expect big n here, so no _mt version
+		template<typename T>
+		static ::std::enable_if_t<::std::is_floating_point<T>::value, vec_len_t> vMakeIdxsOfNonZeros(const T* pVec, const vec_len_t ne
+			, vec_len_t*const pIdxs)noexcept
+		{
+			NNTL_ASSERT(pVec && ne > 0 && pIdxs);
+			vec_len_t nz = 0;
+			for (vec_len_t i = 0; i < ne; ++i) {
+				const auto v = pVec[i];
+				//writing unconditionally, the index is kept only if the element is non zero
+				pIdxs[nz] = i;
+				nz += (v > T(+0.)) + (v < T(-0.));
+			}
+			return nz;
+		}
+
 		//Strict version counts only a positive zero as a zero. Works about a twice as fast as vCountNonZeros
 		template<typename T>
 		static ::std::enable_if_t<::std::is_floating_point<T>::value, numel_cnt_t> vCountNonZerosStrict(const T* pVec, const numel_cnt_t ne)noexcept {
@@ -2636,6 +2999,183 @@ namespace math {
 		}
 
 
+		//////////////////////////////////////////////////////////////////////////
+		// member-wise (block-diagonal) variants of the three functions above. They're used by the ensemble-packed layers
+		// (see layer/fully_connected_ensemble.h), that stack the weights of K same-shaped members into a single matrix.
+		// The incoming activations prevAct [bs, K*p+1] consist of K contiguous column blocks of p columns each (one block per
+		// member) plus the shared bias column; the weights are [K*n, p+1], rows k*n..k*n+n-1 belong to member k; act/dLdZ are
+		// [bs, K*n] (act may have a bias column). Member k sees only its own input block, so it's K GEMMs with proper strides
+		// (OpenBLAS has no batched gemm), but no data copying at all.
+		// Only the standard bBatchInColumn() layout is supported.
+		template<typename T>
+		static void mMul_prevAct_weights_2_act_mw(const vec_len_t K, const smatrix<T>& prevAct, const smatrix<T>& weights, smatrix<T>& act)noexcept {
+			NNTL_ASSERT(K > 0 && prevAct.emulatesBiases() && !weights.emulatesBiases());
+			NNTL_ASSERT(prevAct.bBatchInColumn() && weights.bBatchInColumn() && act.bBatchInColumn());
+			NNTL_ASSERT(act.cols_no_bias() == weights.rows() && prevAct.cols_no_bias() == K*(weights.cols() - 1));
+			NNTL_ASSERT(0 == weights.rows() % K && prevAct.rows() == act.rows());
+			prevAct.assert_storage_does_not_intersect(act);
+			weights.assert_storage_does_not_intersect(act);
+
+			const auto bs = act.rows(), n = weights.rows() / K, p = weights.cols() - 1;
+			const auto ldP = prevAct.ldimAsVecLen(), ldW = weights.ldimAsVecLen(), ldA = act.ldimAsVecLen();
+
+			//bias weights of all members at once: Ac[m,K*n] = 1[m,1] * Wb'[1,K*n]
+			b_BLAS_t::gemm(false, true, bs, weights.rows(), 1, real_t(1.), prevAct.bias_column(), ldP
+				, weights.colDataAsVec(p), ldW, real_t(0), act.data(), ldA);
+
+			//Ac_k[m,n] += Pc_k[m,p] * Wc_k[n,p]'
+			for (vec_len_t k = 0; k < K; ++k) {
+				b_BLAS_t::gemm(false, true, bs, n, p, real_t(1.), prevAct.colDataAsVec(k*p), ldP
+					, weights.data() + k*n, ldW, real_t(1.), act.colDataAsVec(k*n), ldA);
+			}
+
+		#if NNTL_DEBUGBREAK_ON_OPENBLAS_DENORMALS
+			act._breakWhenDenormal();
+		#endif
+		}
+
+		template<typename T>
+		static void mMul_dLdZ_weights_2_dLdAPrev_mw(const vec_len_t K, const smatrix<T>& dLdZ, const smatrix<T>& weights, smatrix<T>& dLdAPrev)noexcept {
+			NNTL_ASSERT(K > 0 && !dLdZ.emulatesBiases() && !weights.emulatesBiases() && !dLdAPrev.emulatesBiases());
+			NNTL_ASSERT(dLdZ.bBatchInColumn() && weights.bBatchInColumn() && dLdAPrev.bBatchInColumn());
+			NNTL_ASSERT(dLdZ.cols() == weights.rows() && dLdAPrev.cols() == K*(weights.cols() - 1));
+			NNTL_ASSERT(0 == weights.rows() % K && dLdZ.rows() == dLdAPrev.rows());
+			dLdZ.assert_storage_does_not_intersect(dLdAPrev);
+
+			const auto bs = dLdZ.rows(), n = weights.rows() / K, p = weights.cols() - 1;
+			const auto ldZ = dLdZ.ldimAsVecLen(), ldW = weights.ldimAsVecLen(), ldP = dLdAPrev.ldimAsVecLen();
+
+			//dLdAPrev_k[m,p] = dLdZ_k[m,n] * W_k[n,p] (bias column of W is skipped by p)
+			for (vec_len_t k = 0; k < K; ++k) {
+				b_BLAS_t::gemm(false, false, bs, p, n, real_t(1.), dLdZ.colDataAsVec(k*n), ldZ
+					, weights.data() + k*n, ldW, real_t(0), dLdAPrev.colDataAsVec(k*p), ldP);
+			}
+
+		#if NNTL_DEBUGBREAK_ON_OPENBLAS_DENORMALS
+			dLdAPrev._breakWhenDenormal();
+		#endif
+		}
+
+		template<typename T>
+		static void mMulScaled_dLdZ_prevAct_2_dLdW_mw(const vec_len_t K, const T Sc, const smatrix<T>& dLdZ, const smatrix<T>& prevAct
+			, smatrix<T>& dLdW)noexcept
+		{
+			NNTL_ASSERT(K > 0 && !dLdZ.emulatesBiases() && prevAct.emulatesBiases() && !dLdW.emulatesBiases());
+			NNTL_ASSERT(dLdZ.bBatchInColumn() && prevAct.bBatchInColumn() && dLdW.bBatchInColumn());
+			NNTL_ASSERT(dLdZ.cols() == dLdW.rows() && prevAct.cols_no_bias() == K*(dLdW.cols() - 1));
+			NNTL_ASSERT(0 == dLdW.rows() % K && dLdZ.rows() == prevAct.rows());
+			dLdZ.assert_storage_does_not_intersect(dLdW);
+			prevAct.assert_storage_does_not_intersect(dLdW);
+
+			const auto bs = dLdZ.rows(), n = dLdW.rows() / K, p = dLdW.cols() - 1;
+			const auto ldZ = dLdZ.ldimAsVecLen(), ldP = prevAct.ldimAsVecLen(), ldW = dLdW.ldimAsVecLen();
+
+			//dLdW_k[n,p] = Sc * dLdZ_k'[n,m] * Pc_k[m,p]
+			for (vec_len_t k = 0; k < K; ++k) {
+				b_BLAS_t::gemm(true, false, n, p, bs, Sc, dLdZ.colDataAsVec(k*n), ldZ
+					, prevAct.colDataAsVec(k*p), ldP, real_t(0), dLdW.data() + k*n, ldW);
+			}
+			//bias weights of all members at once: dLdWb[K*n,1] = Sc * dLdZ'[K*n,m] * 1[m,1]
+			b_BLAS_t::gemm(true, false, dLdW.rows(), 1, bs, Sc, dLdZ.data(), ldZ
+				, prevAct.bias_column(), ldP, real_t(0), dLdW.colDataAsVec(p), ldW);
+
+		#if NNTL_DEBUGBREAK_ON_OPENBLAS_DENORMALS
+			dLdW._breakWhenDenormal();
+		#endif
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// tiled (shared weights) variants of the three functions above. They're used by a fully connected layer that is
+		// tiled inplace by the layer_pack_tile (see layer/pack_tile.h): the same weights [n, p+1] are applied to each of K
+		// contiguous column blocks of prevAct [m, K*p+1] (the last column is the shared bias column).
+		// act/dLdZ are the tiled layer's own [K*m, n] matrices (act may have a bias column), however, their memory is treated
+		// as K consecutive [m,n] blocks (tile k starts at data()+k*m*n and has ldim==m). That's exactly the layout of a
+		// [m, K*n] matrix, i.e. of the LPT activations/dLdA, so no data rolling/unrolling is required at all.
+		// dLdAPrev is [m, K*p] and dLdW accumulates contributions of all tiles.
+		// It's K strided GEMMs, because OpenBLAS has no batched gemm.
+		// Only the standard bBatchInColumn() layout is supported.
+		template<typename T>
+		static void mMul_prevAct_weights_2_act_tiled(const vec_len_t K, const smatrix<T>& prevAct, const smatrix<T>& weights, smatrix<T>& act)noexcept {
+			NNTL_ASSERT(K > 0 && prevAct.emulatesBiases() && !weights.emulatesBiases());
+			NNTL_ASSERT(prevAct.bBatchInColumn() && weights.bBatchInColumn() && act.bBatchInColumn());
+			NNTL_ASSERT(act.cols_no_bias() == weights.rows() && prevAct.cols_no_bias() == K*(weights.cols() - 1));
+			NNTL_ASSERT(act.rows() == K*prevAct.rows());
+			prevAct.assert_storage_does_not_intersect(act);
+			weights.assert_storage_does_not_intersect(act);
+
+			const auto m = prevAct.rows(), n = weights.rows(), p = weights.cols() - 1;
+			const auto ldP = prevAct.ldimAsVecLen(), ldW = weights.ldimAsVecLen();
+			const numel_cnt_t tileNumel = smatrix_td::sNumel(m, n);
+
+			for (vec_len_t k = 0; k < K; ++k) {
+				const auto pA = act.data() + k*tileNumel;
+				//bias weights: Ac_k[m,n] = 1[m,1] * Wb'[1,n]
+				b_BLAS_t::gemm(false, true, m, n, 1, real_t(1.), prevAct.bias_column(), ldP
+					, weights.colDataAsVec(p), ldW, real_t(0), pA, m);
+				//Ac_k[m,n] += Pc_k[m,p] * Wc[n,p]'
+				b_BLAS_t::gemm(false, true, m, n, p, real_t(1.), prevAct.colDataAsVec(k*p), ldP
+					, weights.data(), ldW, real_t(1.), pA, m);
+			}
+
+		#if NNTL_DEBUGBREAK_ON_OPENBLAS_DENORMALS
+			act._breakWhenDenormal();
+		#endif
+		}
+
+		template<typename T>
+		static void mMul_dLdZ_weights_2_dLdAPrev_tiled(const vec_len_t K, const smatrix<T>& dLdZ, const smatrix<T>& weights, smatrix<T>& dLdAPrev)noexcept {
+			NNTL_ASSERT(K > 0 && !dLdZ.emulatesBiases() && !weights.emulatesBiases() && !dLdAPrev.emulatesBiases());
+			NNTL_ASSERT(dLdZ.bBatchInColumn() && weights.bBatchInColumn() && dLdAPrev.bBatchInColumn());
+			NNTL_ASSERT(dLdZ.cols() == weights.rows() && dLdAPrev.cols() == K*(weights.cols() - 1));
+			NNTL_ASSERT(dLdZ.rows() == K*dLdAPrev.rows());
+			dLdZ.assert_storage_does_not_intersect(dLdAPrev);
+
+			const auto m = dLdAPrev.rows(), n = weights.rows(), p = weights.cols() - 1;
+			const auto ldW = weights.ldimAsVecLen(), ldP = dLdAPrev.ldimAsVecLen();
+			const numel_cnt_t tileNumel = smatrix_td::sNumel(m, n);
+
+			//dLdAPrev_k[m,p] = dLdZ_k[m,n] * W[n,p] (bias column of W is skipped by p)
+			for (vec_len_t k = 0; k < K; ++k) {
+				b_BLAS_t::gemm(false, false, m, p, n, real_t(1.), dLdZ.data() + k*tileNumel, m
+					, weights.data(), ldW, real_t(0), dLdAPrev.colDataAsVec(k*p), ldP);
+			}
+
+		#if NNTL_DEBUGBREAK_ON_OPENBLAS_DENORMALS
+			dLdAPrev._breakWhenDenormal();
+		#endif
+		}
+
+		template<typename T>
+		static void mMulScaled_dLdZ_prevAct_2_dLdW_tiled(const vec_len_t K, const T Sc, const smatrix<T>& dLdZ, const smatrix<T>& prevAct
+			, smatrix<T>& dLdW)noexcept
+		{
+			NNTL_ASSERT(K > 0 && !dLdZ.emulatesBiases() && prevAct.emulatesBiases() && !dLdW.emulatesBiases());
+			NNTL_ASSERT(dLdZ.bBatchInColumn() && prevAct.bBatchInColumn() && dLdW.bBatchInColumn());
+			NNTL_ASSERT(dLdZ.cols() == dLdW.rows() && prevAct.cols_no_bias() == K*(dLdW.cols() - 1));
+			NNTL_ASSERT(dLdZ.rows() == K*prevAct.rows());
+			dLdZ.assert_storage_does_not_intersect(dLdW);
+			prevAct.assert_storage_does_not_intersect(dLdW);
+
+			const auto m = prevAct.rows(), n = dLdW.rows(), p = dLdW.cols() - 1;
+			const auto ldP = prevAct.ldimAsVecLen(), ldW = dLdW.ldimAsVecLen();
+			const numel_cnt_t tileNumel = smatrix_td::sNumel(m, n);
+
+			for (vec_len_t k = 0; k < K; ++k) {
+				const auto pZ = dLdZ.data() + k*tileNumel;
+				const real_t beta = k ? real_t(1.) : real_t(0);
+				//dLdW[n,p] += Sc * dLdZ_k'[n,m] * Pc_k[m,p]
+				b_BLAS_t::gemm(true, false, n, p, m, Sc, pZ, m
+					, prevAct.colDataAsVec(k*p), ldP, beta, dLdW.data(), ldW);
+				//dLdWb[n,1] += Sc * dLdZ_k'[n,m] * 1[m,1]
+				b_BLAS_t::gemm(true, false, n, 1, m, Sc, pZ, m
+					, prevAct.bias_column(), ldP, beta, dLdW.colDataAsVec(p), ldW);
+			}
+
+		#if NNTL_DEBUGBREAK_ON_OPENBLAS_DENORMALS
+			dLdW._breakWhenDenormal();
+		#endif
+		}
+
 		//////////////////////////////////////////////////////////////////////////
 		//////////////////////////////////////////////////////////////////////////
 		// Computes a symmetrical matrix C = 1/ARowsCnt  A' * A.
@@ -2716,6 +3256,50 @@ namespace math {
 			return 0 == r;
 		}
 
+		// mSVD_Factorize_ss(A, U, V) makes the best (in Frobenius norm sense) rank r approximation of m*n matrix A by the
+		// product of U[m,r] and V[r,n], where r==U.cols()==V.rows()<=min(m,n). Singular values are split evenly between the factors,
+		// i.e. U=Ur*sqrt(Sr) and V=sqrt(Sr)*Vr'. A is destroyed during the computation!
+		//		returns true if SVD was successful
+		//		Uses the math object's local storage. Since it's intended for the weights initialization (when the storage
+		//		is generally not initialized yet), call preinit(mSVD_Factorize_needTempMem(m,n)) and init() first.
+		static numel_cnt_t mSVD_Factorize_needTempMem(const vec_len_t m, const vec_len_t n)noexcept {
+			const numel_cnt_t k = ::std::min(m, n);
+			return k*(static_cast<numel_cnt_t>(m) + n + 2);
+		}
+		bool mSVD_Factorize_ss(realmtx_t& A, realmtx_t& U, realmtx_t& V)noexcept {
+			NNTL_ASSERT(!A.empty() && !U.empty() && !V.empty());
+			NNTL_ASSERT(!A.emulatesBiases() && !U.emulatesBiases() && !V.emulatesBiases());
+			A.assert_storage_does_not_intersect(U);
+			A.assert_storage_does_not_intersect(V);
+			const vec_len_t m = A.rows(), n = A.cols(), k = ::std::min(m, n), rank = U.cols();
+			NNTL_ASSERT(U.rows() == m && V.cols() == n && V.rows() == rank && rank <= k);
+
+			const numel_cnt_t tUNumel = realmtx_t::sNumel(m, k), tVtNumel = realmtx_t::sNumel(k, n);
+			const auto tmemSize = get_self().mSVD_Factorize_needTempMem(m, n);
+			NNTL_ASSERT(tmemSize == tUNumel + tVtNumel + 2 * k);
+			real_t*const pU = get_self()._istor_alloc(tmemSize);
+			real_t*const pVt = pU + tUNumel;
+			real_t*const pS = pVt + tVtNumel;
+
+			const auto r = b_BLAS_t::gesvd('S', 'S', m, n, A.data(), m, pS, pU, m, pVt, k, pS + k);
+			NNTL_ASSERT(0 == r || !"b_BLAS_t::gesvd failed!");
+			if (0 == r) {
+				const numel_cnt_t _m = m, _n = n, _k = k, _r = rank;
+				for (vec_len_t i = 0; i < rank; ++i) {
+					const real_t sq = ::std::sqrt(pS[i]);
+					const auto pSrcU = pU + _m*i;
+					const auto pDstU = U.colDataAsVec(i);
+					for (numel_cnt_t j = 0; j < _m; ++j) pDstU[j] = pSrcU[j] * sq;
+
+					const auto pSrcV = pVt + i;
+					const auto pDstV = V.data() + i;
+					for (numel_cnt_t j = 0; j < _n; ++j) pDstV[j*_r] = pSrcV[j*_k] * sq;
+				}
+			}
+			get_self()._istor_free(pU, tmemSize);
+			return 0 == r;
+		}
+
 
 
 		//////////////////////////////////////////////////////////////////////////
@@ -2794,6 +3378,17 @@ namespace math {
 		}
 		*/
 
+	protected:
+		//the blocked version loses to the scalar loops on thin matrices and when the leading dimension of dest is a multiple
+		// of 1KB (stores of a tile hit the same cache set then)
+		template<typename T>
+		static bool _mTranspose_useBlocked(const smatrix<T>& src, const smatrix<T>& dest, const bool bIgnoreBias)noexcept {
+			return src.numel() >= Thresholds_t::mTranspose_blocked
+				&& ::std::min(src.rows(bIgnoreBias), src.cols(bIgnoreBias)) >= Thresholds_t::mTranspose_blocked_minDim
+				&& 0 != (static_cast<size_t>(dest.ldim())*sizeof(T)) % 1024;
+		}
+
+	public:
 		//////////////////////////////////////////////////////////////////////////
 		// matrix transposition. Bias row/column (if any in src or dest) is treated just like any other row/column (also transposed).
 		// Destination matrix as always must be properly sized
@@ -2802,6 +3397,10 @@ namespace math {
 		template<typename T>
 		void mTranspose(const smatrix<T>& src, smatrix<T>& dest, const bool bIgnoreBias = false)noexcept {
 			NNTL_ASSERT(src.bBatchInRow() == !dest.bBatchInRow());
+			if (_mTranspose_useBlocked(src, dest, bIgnoreBias)) {
+				get_self().mTranspose_blocked_st(src, dest, bIgnoreBias);
+				return;
+			}
 			const bool bIsWide = (src.rows() < src.cols());
 			//#TODO: that threshold below depends on hw architecture and current use-case (esp. cache cleanliness; and libxsmm could be better)
 			//but it's insanity to try to hardcode them all.
@@ -2819,6 +3418,10 @@ namespace math {
 		template<typename T>
 		void mTranspose_ignore_bias(const smatrix<T>& src, smatrix<T>& dest)noexcept {
 			NNTL_ASSERT(src.bBatchInRow() == !dest.bBatchInRow());
+			if (_mTranspose_useBlocked(src, dest, true)) {
+				get_self().mTranspose_blocked_st(src, dest, true);
+				return;
+			}
 			const bool bIsWide = (src.rows_no_bias() < src.cols_no_bias());
 			//#TODO: that threshold below depends on hw architecture and current use-case (esp. cache cleanliness; and libxsmm could be better)
 			//but it's insanity to try to hardcode them all.
@@ -2888,6 +3491,51 @@ namespace math {
 			NNTL_ASSERT(dest.if_biases_test_strict());
 		}
 
+		// cache blocked transposition with SIMD tiles, see _impl::transpose_blocked
+		// #supportsBatchInRow
+		// dest matrix MUST be properly sized and src.bBatchInRow() == !dest.bBatchInRow() must eval to TRUE on entry
+		template<typename T>
+		static void mTranspose_blocked_st(const smatrix<T>& src, smatrix<T>& dest, const bool bIgnoreBias) noexcept {
+			NNTL_ASSERT(src.bBatchInRow() == !dest.bBatchInRow());
+			NNTL_ASSERT(src.rows(bIgnoreBias) == dest.cols(bIgnoreBias) && src.cols(bIgnoreBias) == dest.rows(bIgnoreBias));
+			NNTL_ASSERT(src.if_biases_test_strict() && dest.if_biases_test_strict());
+
+			_impl::transpose_blocked<T>::block(src.data(), src.ldim(), dest.data(), dest.ldim(), src.rows(bIgnoreBias), src.cols(bIgnoreBias));
+
+			NNTL_ASSERT(dest.if_biases_test_strict());
+		}
+		// #supportsBatchInRow
+		// dest matrix MUST be properly sized and src.bBatchInRow() == !dest.bBatchInRow() must eval to TRUE on entry
+		template<typename T>
+		void mTranspose_blocked_mt(const smatrix<T>& src, smatrix<T>& dest, const bool bIgnoreBias) noexcept {
+			NNTL_ASSERT(src.bBatchInRow() == !dest.bBatchInRow());
+			NNTL_ASSERT(src.rows(bIgnoreBias) == dest.cols(bIgnoreBias) && src.cols(bIgnoreBias) == dest.rows(bIgnoreBias));
+			NNTL_ASSERT(src.if_biases_test_strict() && dest.if_biases_test_strict());
+
+			typedef _impl::transpose_blocked<T> tb_t;
+			constexpr ptrdiff_t blk = tb_t::sBlock;
+			const ptrdiff_t sRows = src.rows(bIgnoreBias), sCols = src.cols(bIgnoreBias), ldSrc = src.ldim(), ldDest = dest.ldim();
+			const T* pSrc = src.data();
+			T* pDest = dest.data();
+
+			//threads get stripes of whole blocks along the bigger dimension, so they write disjoint sets of dest rows/columns
+			if (sRows >= sCols) {
+				m_threads.run([pSrc, pDest, sRows, sCols, ldSrc, ldDest](const par_range_t& pr) noexcept {
+					const ptrdiff_t r0 = static_cast<ptrdiff_t>(pr.offset())*tb_t::sBlock
+						, r1 = ::std::min(sRows, static_cast<ptrdiff_t>(pr.offset() + pr.cnt())*tb_t::sBlock);
+					tb_t::block(pSrc + r0, ldSrc, pDest + r0*ldDest, ldDest, r1 - r0, sCols);
+				}, (sRows + blk - 1) / blk);
+			} else {
+				m_threads.run([pSrc, pDest, sRows, sCols, ldSrc, ldDest](const par_range_t& pr) noexcept {
+					const ptrdiff_t c0 = static_cast<ptrdiff_t>(pr.offset())*tb_t::sBlock
+						, c1 = ::std::min(sCols, static_cast<ptrdiff_t>(pr.offset() + pr.cnt())*tb_t::sBlock);
+					tb_t::block(pSrc + c0*ldSrc, ldSrc, pDest + c0, ldDest, sRows, c1 - c0);
+				}, (sCols + blk - 1) / blk);
+			}
+
+			NNTL_ASSERT(dest.if_biases_test_strict());
+		}
+
 		//////////////////////////////////////////////////////////////////////////
 		//full matrix transposition in-place
 		// MUST #supportsBatchInRow if changed
@@ -4491,7 +5139,7 @@ namespace math {
 					ql += math::log1p_eps(-a);
 #endif
 				}
-				NNTL_ASSERT(!isnan(ql));
+				NNTL_ASSERT(!::std::isnan(ql));
 			}
 			return ql;
 		}
@@ -4537,7 +5185,7 @@ namespace math {
 				T = sum + Y;
 				C = T - sum - Y;
 				sum = T;
-				NNTL_ASSERT(!isnan(sum));
+				NNTL_ASSERT(!::std::isnan(sum));
 			}
 			return sum;
 		}
@@ -4569,7 +5217,7 @@ namespace math {
 				NNTL_ASSERT(y <= real_t(0.0) && y >= real_t(-1.0));
 				a = a > real_t(0.0) ? ::std::log(a) : math::real_t_limits<real_t>::log_almost_zero;
 				ret += y*a;
-				NNTL_ASSERT(!isnan(ret));
+				NNTL_ASSERT(!::std::isnan(ret));
 			}
 			return ret;
 		}
@@ -4587,6 +5235,129 @@ namespace math {
 			}, _reduce_vec_sum<real_t>, activations.numel()) /*/ activations.rows()*/;
 		}
 
+		//////////////////////////////////////////////////////////////////////////
+		// fused softmax + cross entropy. Both functions take preactivations Z (no biases) and in a single sweep over
+		// cache-resident blocks of rows compute rowwise max, exp(Z-max) and the normalization.
+		// softmax_xentropy_dLdZ() also subtracts data_y, i.e. Z2dLdZ = softmax(Z) - y on return. It's used by bprop() and
+		// doesn't compute the loss at all.
+		// softmax_xentropy_loss() leaves softmax(Z) in Z2act and returns the same (non-normalized) value as
+		// loss_softmax_xentropy() does, however it's computed as sum(y)*log(sum(exp(Z-max))) - sum(y*(Z-max)), so there's
+		// no need to clamp log(0). Temporary memory is not required.
+		void softmax_xentropy_dLdZ(realmtx_t& Z2dLdZ, const realmtx_t& data_y)noexcept {
+			if (Z2dLdZ.numel() < Thresholds_t::softmax_xentropy_fused) {
+				get_self().softmax_xentropy_dLdZ_st(Z2dLdZ, data_y);
+			} else get_self().softmax_xentropy_dLdZ_mt(Z2dLdZ, data_y);
+		}
+		static void softmax_xentropy_dLdZ_st(realmtx_t& Z2dLdZ, const realmtx_t& data_y, const rowcol_range*const pRCR = nullptr)noexcept {
+			_isoftmax_xentropy_fused_st<true>(Z2dLdZ, data_y, pRCR ? *pRCR : rowcol_range(Z2dLdZ));
+		}
+		void softmax_xentropy_dLdZ_mt(realmtx_t& Z2dLdZ, const realmtx_t& data_y)noexcept {
+			NNTL_ASSERT(!Z2dLdZ.empty() && !data_y.empty() && Z2dLdZ.size() == data_y.size());
+			m_threads.run([&Z2dLdZ, &data_y](const par_range_t& pr)noexcept {
+				const auto ofs = static_cast<vec_len_t>(pr.offset());
+				_isoftmax_xentropy_fused_st<true>(Z2dLdZ, data_y, rowcol_range(ofs, ofs + static_cast<vec_len_t>(pr.cnt()), Z2dLdZ));
+			}, Z2dLdZ.rows());
+		}
+
+		real_t softmax_xentropy_loss(realmtx_t& Z2act, const realmtx_t& data_y)noexcept {
+			if (Z2act.numel() < Thresholds_t::softmax_xentropy_fused) {
+				return get_self().softmax_xentropy_loss_st(Z2act, data_y);
+			} else return get_self().softmax_xentropy_loss_mt(Z2act, data_y);
+		}
+		static real_t softmax_xentropy_loss_st(realmtx_t& Z2act, const realmtx_t& data_y, const rowcol_range*const pRCR = nullptr)noexcept {
+			return _isoftmax_xentropy_fused_st<false>(Z2act, data_y, pRCR ? *pRCR : rowcol_range(Z2act));
+		}
+		real_t softmax_xentropy_loss_mt(realmtx_t& Z2act, const realmtx_t& data_y)noexcept {
+			NNTL_ASSERT(!Z2act.empty() && !data_y.empty() && Z2act.size() == data_y.size());
+			return m_threads.reduce([&Z2act, &data_y](const par_range_t& pr)noexcept->reduce_data_t {
+				const auto ofs = static_cast<vec_len_t>(pr.offset());
+				return converter_reduce_data_tpl<real_t>::to(
+					_isoftmax_xentropy_fused_st<false>(Z2act, data_y, rowcol_range(ofs, ofs + static_cast<vec_len_t>(pr.cnt()), Z2act))
+				);
+			}, _reduce_vec_sum<real_t>, Z2act.rows());
+		}
+
+	protected:
+		static constexpr vec_len_t _softmax_fused_maxBlockRows = 64;
+		//rows of a block are processed 3 times, so the block should fit into L1 (~4K elements), but shouldn't be too
+		//short to let the compiler vectorize over the rows
+		static vec_len_t _softmax_fused_blockRows(const vec_len_t cols)noexcept {
+			return ::std::max(vec_len_t(4), ::std::min(_softmax_fused_maxBlockRows, static_cast<vec_len_t>(4096 / cols)));
+		}
+
+		//bDLDZ==true makes dL/dZ and returns 0, bDLDZ==false makes softmax and returns the loss
+		template<bool bDLDZ>
+		static real_t _isoftmax_xentropy_fused_st(realmtx_t& A, const realmtx_t& Y, const rowcol_range& RCR)noexcept {
+			NNTL_ASSERT(!A.empty() && !Y.empty() && A.size() == Y.size());
+			NNTL_ASSERT(!A.emulatesBiases() && !Y.emulatesBiases() && A.bBatchInColumn() && Y.bBatchInColumn());
+			const ptrdiff_t ldA = A.ldim(), ldY = Y.ldim();
+			const vec_len_t tc = A.cols(), blkRows = _softmax_fused_blockRows(tc);
+
+			real_t rMax[_softmax_fused_maxBlockRows], rSum[_softmax_fused_maxBlockRows];
+			real_t rSumY[_softmax_fused_maxBlockRows], rSumYZ[_softmax_fused_maxBlockRows];
+			real_t ret(0.0);
+
+			for (vec_len_t rb = RCR.rowBegin; rb < RCR.rowEnd; rb += blkRows) {
+				const vec_len_t br = ::std::min(blkRows, RCR.rowEnd - rb);
+				const auto pA = A.data() + rb;
+				const auto pY = Y.data() + rb;
+
+				//1. rowwise max
+				::std::copy(pA, pA + br, rMax);
+				for (vec_len_t c = 1; c < tc; ++c) {
+					const auto pC = pA + c*ldA;
+					for (vec_len_t r = 0; r < br; ++r) rMax[r] = ::std::max(rMax[r], pC[r]);
+				}
+
+				//2. numerators, denominators and loss parts
+				::std::fill(rSum, rSum + br, real_t(0.0));
+				if (bDLDZ) {
+					for (vec_len_t c = 0; c < tc; ++c) {
+						const auto pC = pA + c*ldA;
+						for (vec_len_t r = 0; r < br; ++r) {
+							const auto e = ::std::exp(pC[r] - rMax[r]);
+							pC[r] = e;
+							rSum[r] += e;
+						}
+					}
+				} else {
+					::std::fill(rSumY, rSumY + br, real_t(0.0));
+					::std::fill(rSumYZ, rSumYZ + br, real_t(0.0));
+					for (vec_len_t c = 0; c < tc; ++c) {
+						const auto pC = pA + c*ldA;
+						const auto pYC = pY + c*ldY;
+						for (vec_len_t r = 0; r < br; ++r) {
+							const auto z = pC[r] - rMax[r];
+							const auto y = pYC[r];
+							NNTL_ASSERT(y >= real_t(0.0) && y <= real_t(1.0));
+							const auto e = ::std::exp(z);
+							pC[r] = e;
+							rSum[r] += e;
+							rSumY[r] += y;
+							rSumYZ[r] += y*z;
+						}
+					}
+				}
+
+				//3. the loss (if required) and normalization (+ dL/dZ)
+				for (vec_len_t r = 0; r < br; ++r) {
+					NNTL_ASSERT(rSum[r] >= real_t(1.0));
+					if (!bDLDZ) ret += rSumY[r] * ::std::log(rSum[r]) - rSumYZ[r];
+					rSum[r] = real_t(1.0) / rSum[r];
+				}
+				for (vec_len_t c = 0; c < tc; ++c) {
+					const auto pC = pA + c*ldA;
+					const auto pYC = pY + c*ldY;
+					for (vec_len_t r = 0; r < br; ++r) {
+						pC[r] = bDLDZ ? pC[r] * rSum[r] - pYC[r] : pC[r] * rSum[r];
+					}
+				}
+			}
+			NNTL_ASSERT(!::std::isnan(ret));
+			return ret;
+		}
+
+	public:
 
 		//////////////////////////////////////////////////////////////////////////
 		//gradient application procedures
@@ -5036,16 +5807,42 @@ namespace math {
 		// 
 		//////////////////////////////////////////////////////////////////////////
 		// deCov
+		// Both the loss and its derivative are computed over blocks of Thresholds_t::deCov_blockCols columns. For each
+		// block I only its de-meaned copy DM_I is made and the covariance matrix is never materialized: it's computed
+		// block by block as C_IJ = DM_I'*A_J/N, J<=I (that's exact, because columns of DM_I sum to zero), i.e. only the
+		// lower block triangle is visited and diagonal blocks are made with syrk() that writes a single triangle.
+		// 
 		// returns how much internal temporarily memory must be available to the to calculate loss_deCov() and dLoss_deCov
 		static numel_cnt_t loss_DeCov_needTempMem(const bool bWillDoTraining, const smatrix_td::mtx_size_t biggestMtx)noexcept {
 			NNTL_UNREF(bWillDoTraining);
-			// we'll need some temporary memory to compute covariation and derivative correctly.
 			// In general, we'll need memory for:
-			// - vector of colwise means of biggestMtx, size == biggestMtx.cols_no_bias() 
-			// - de-mean'ed matrix of the same size as biggestMtx
-			// - covariance matrix of size (biggestMtx.cols_no_bias(), biggestMtx.cols_no_bias()). Will be used after means-vector are freed
-			return realmtx_t::sNumel(biggestMtx) + realmtx_t::sNumel(biggestMtx.second, biggestMtx.second);
+			// - vector of colwise means of biggestMtx, size == biggestMtx.cols_no_bias()
+			// - de-mean'ed block of columns, size == biggestMtx.rows()*blockCols
+			// - a block of covariance matrix, size == blockCols*blockCols
+			// - a correction vector for the derivative, size == blockCols
+			const auto blkCols = _deCov_blockCols(biggestMtx.second);
+			return biggestMtx.second + realmtx_t::sNumel(biggestMtx.first, blkCols) + realmtx_t::sNumel(blkCols, blkCols + 1);
 		}
+		// dLoss_deCov_ip() needs additionally a copy of the whole source matrix
+		static numel_cnt_t dLoss_deCov_ip_needTempMem(const smatrix_td::mtx_size_t biggestMtx)noexcept {
+			return loss_DeCov_needTempMem(true, biggestMtx) + realmtx_t::sNumel(biggestMtx);
+		}
+
+	protected:
+		static vec_len_t _deCov_blockCols(const vec_len_t cols)noexcept {
+			return ::std::min(cols, static_cast<vec_len_t>(Thresholds_t::deCov_blockCols));
+		}
+
+		//makes a de-meaned copy of columns [c0, c0+DM.cols()) of Vals in DM and stores their means into pMeans[c0...]
+		template<bool bNumStab>
+		void _deCov_demeaned_block(const realmtx_t& Vals, const vec_len_t c0, realmtx_t& DM, real_t*const pMeans)noexcept {
+			NNTL_ASSERT(!DM.emulatesBiases() && DM.rows() == Vals.rows() && c0 + DM.cols() <= Vals.cols_no_bias());
+			memcpy(DM.data(), Vals.colDataAsVec(c0), DM.byte_size());
+			get_self().mcwMean<bNumStab>(DM, pMeans + c0);
+			get_self().mcwSub_ip(DM, pMeans + c0);
+		}
+
+	public:
 		// Implements DeCov regularizer from the paper "Reducing Overfitting in Deep Neural Networks by Decorrelating Representations", 2015, ArXiv:1511.06068
 		// (similar to “Discovering Hidden Factors of Variation in Deep Networks”, ArXiv:1412.6583)
 		// BTW, there's wrong derivative presented in "Reducing Overfitting...". Actual derivative must be 2 times greater, than printed in paper.
@@ -5057,131 +5854,425 @@ namespace math {
 		// L = (norm(C, 'fro'). ^ 2 - norm(diag(C)). ^ 2). / 2;
 		template<bool bLowerTriangl, bool bNumStab>
 		real_t loss_deCov(const realmtx_t& Vals)noexcept {
+			return get_self()._ideCov<bLowerTriangl, bNumStab, true, false>(Vals, nullptr, real_t(1.0));
+		}
+
+		// dL = (DM*C - diag(C)'.*DM).*2./N;
+		template<bool bLowerTriangl, bool bNumStab>
+		void dLoss_deCov(const realmtx_t& Vals, realmtx_t& dLossdVals, const real_t deCov_scale = real_t(1.0))noexcept {
+			get_self()._ideCov<bLowerTriangl, bNumStab, false, true>(Vals, &dLossdVals, deCov_scale);
+		}
+
+		//computes both the loss (the return value, it's not scaled by deCov_scale) and its derivative in a single sweep
+		template<bool bLowerTriangl, bool bNumStab>
+		real_t loss_dLoss_deCov(const realmtx_t& Vals, realmtx_t& dLossdVals, const real_t deCov_scale = real_t(1.0))noexcept {
+			return get_self()._ideCov<bLowerTriangl, bNumStab, true, true>(Vals, &dLossdVals, deCov_scale);
+		}
+
+	protected:
+		// Each computed block C_IJ (J<I) contributes sum(C_IJ.^2) to the loss, DM_I*C_IJ to columns J of dL and
+		// DM_J*C_IJ' = A_J*C_IJ' - 1*(C_IJ*mean(A_J))' to columns I of dL, the latter correction is accumulated for the whole
+		// block row I and subtracted once. The diagonal block contributes the sum over its single triangle to the loss (the
+		// sum over a single triangle of a symmetric matrix is a half of the sum over the whole matrix excluding the main
+		// diagonal, therefore there's no need to divide it by 2 to fit the formula) and DM_I*(C_II with zeroed diagonal)
+		// to dL via symm().
+		template<bool bLowerTriangl, bool bNumStab, bool bLoss, bool bDLoss>
+		real_t _ideCov(const realmtx_t& Vals, realmtx_t*const pdLossdVals, const real_t deCov_scale)noexcept {
+			static_assert(bLoss || bDLoss, "Nothing to do");
+			NNTL_ASSERT(!bDLoss || (pdLossdVals && Vals.cols_no_bias() == pdLossdVals->cols() && Vals.rows() == pdLossdVals->rows()));
+
+		#ifndef NNTL_DECOV_DONT_CARE_ON_HOLEY_BIASES
 			NNTL_ASSERT(!Vals.emulatesBiases() || !Vals.isHoleyBiases() || !"Current deCov algorithm does not support holey biases!");
 			//to support holey biases algorithm must ignore rows with zeroed biases. Looks like the easiest (and probably the
 			//fastest to run) way to do it is to make a something like a Vals.clone_to_droping_holes(DeMeaned) and then proceed as normal
+		#endif // !NNTL_DECOV_DONT_CARE_ON_HOLEY_BIASES
+
 			NNTL_ASSERT(Vals.cols_no_bias() > 1);
+			NNTL_ASSERT(!bDLoss || !pdLossdVals->emulatesBiases());
+			if (bDLoss) Vals.assert_storage_does_not_intersect(*pdLossdVals);
 
-			const auto valsNumelNoBias = Vals.numel_no_bias();
-			real_t*const pDeMeaned = get_self()._istor_alloc(valsNumelNoBias);
-			realmtx_t DeMeaned(pDeMeaned, Vals, realmtx_t::tag_noBias());
-			NNTL_ASSERT(!DeMeaned.emulatesBiases());
-			const auto _clone_result = Vals.clone_to_no_bias(DeMeaned);
-			NNTL_ASSERT(_clone_result);
+			const auto vRows = Vals.rows(), vCols = Vals.cols_no_bias(), blkCols = _deCov_blockCols(vCols);
+			const auto ldV = Vals.ldimAsVecLen();
+			const auto ldL = bDLoss ? pdLossdVals->ldimAsVecLen() : vec_len_t(0);
+			const real_t invN = real_t(1.) / static_cast<real_t>(vRows);
 
-// 			real_t*const pVecMeans = get_self()._istor_alloc(DeMeaned.cols());
-// 
-// 			get_self().mcwMean<bNumStab>(DeMeaned, pVecMeans);
-// 			get_self().mcwSub_ip(DeMeaned, pVecMeans);
-// 
-// 			get_self()._istor_free(pVecMeans, DeMeaned.cols());
- 			get_self().mcwDeMean<bNumStab>(DeMeaned);
-
-			const auto covMtxNumel = realmtx_t::sNumel(DeMeaned.cols(), DeMeaned.cols());
-			real_t*const pCovMtx = get_self()._istor_alloc(covMtxNumel);
-			realmtx_t CovMtx(pCovMtx, DeMeaned.cols(), DeMeaned.cols());
+			//const real_t cmnScale = (real_t(2.)*deCov_scale) / static_cast<real_t>(vRows);
+			const real_t cmnScale = static_cast<real_t>((ext_real_t(2.)* static_cast<ext_real_t>(deCov_scale))
+				/ static_cast<ext_real_t>(realmtx_t::sNumel(vRows, vCols) - vRows));
 
-			get_self().mColumnsCov<bLowerTriangl>(DeMeaned, CovMtx);
-			//sum over a single triangle of a symmetric matrix is a half smaller than the sum over the whole matrix (excluding the main diagonal)
-			//therefore we shouldn't divide it by 2 to fit the formula.
-			//const auto ret = get_self().ewSumSquaresTriang<bLowerTriangl, bNumStab>(CovMtx);
+		#if NNTL_DEBUGBREAK_ON_OPENBLAS_DENORMALS
+			if (bDLoss && ::std::fpclassify(cmnScale) == FP_SUBNORMAL) {
+				__debugbreak();
+			}
+		#endif
 
-			const auto ret = static_cast<real_t>(static_cast<ext_real_t>(get_self().ewSumSquaresTriang<bLowerTriangl, bNumStab>(CovMtx))
-				/ static_cast<ext_real_t>(Vals.cols_no_bias() - 1));
-			
-			// - and to the amount of active neurons
-			//const auto ret = get_self().ewSumSquaresTriang<bLowerTriangl, bNumStab>(CovMtx) / (valsNumelNoBias * (DeMeaned.cols() - 1));
+			const auto tmemSize = loss_DeCov_needTempMem(bDLoss, mtx_size_t(vRows, vCols));
+			real_t*const pTmp = get_self()._istor_alloc(tmemSize);
+			real_t*const pMeans = pTmp;
+			real_t*const pDM = pMeans + vCols;
+			real_t*const pC = pDM + realmtx_t::sNumel(vRows, blkCols);
+			real_t*const pCorr = pC + realmtx_t::sNumel(blkCols, blkCols);
+
+			if (bDLoss) pdLossdVals->zeros();
+
+			ext_real_t sumSq(0);
+			for (vec_len_t i0 = 0; i0 < vCols; i0 += blkCols) {
+				const vec_len_t bi = ::std::min(blkCols, vCols - i0);
+				realmtx_t DM(pDM, vRows, bi);
+				get_self()._deCov_demeaned_block<bNumStab>(Vals, i0, DM, pMeans);
+				real_t*const pdL_I = bDLoss ? pdLossdVals->colDataAsVec(i0) : nullptr;
+
+				//off-diagonal blocks C_IJ, J<I
+				if (bDLoss) ::std::fill(pCorr, pCorr + bi, real_t(0.));
+				for (vec_len_t j0 = 0; j0 < i0; j0 += blkCols) {
+					const vec_len_t bj = ::std::min(blkCols, i0 - j0);
+					const auto pA_J = Vals.colDataAsVec(j0);
+					//C_IJ = DM_I'*A_J/N
+					b_BLAS_t::gemm(true, false, bi, bj, vRows, invN, DM.data(), vRows, pA_J, ldV, real_t(0.), pC, bi);
+					if (bLoss) {
+						sumSq += static_cast<ext_real_t>(bNumStab ? get_self().ewSumSquares_ns(pC, realmtx_t::sNumel(bi, bj))
+							: get_self().ewSumSquares(pC, realmtx_t::sNumel(bi, bj)));
+					}
+					if (bDLoss) {
+						//dL_J += s*DM_I*C_IJ
+						b_BLAS_t::gemm(false, false, vRows, bj, bi, cmnScale, DM.data(), vRows, pC, bi, real_t(1.), pdLossdVals->colDataAsVec(j0), ldL);
+						//dL_I += s*A_J*C_IJ'
+						b_BLAS_t::gemm(false, true, vRows, bi, bj, cmnScale, pA_J, ldV, pC, bi, real_t(1.), pdL_I, ldL);
+						//corr += C_IJ*mean(A_J)
+						b_BLAS_t::gemm(false, false, bi, 1, bj, real_t(1.), pC, bi, pMeans + j0, bj, real_t(1.), pCorr, bi);
+					}
+				}
 
-			get_self()._istor_free(pCovMtx, covMtxNumel);
+				//diagonal block C_II
+				if (bi > 1) {
+					realmtx_t C(pC, bi, bi);
+					get_self().mColumnsCov<bLowerTriangl>(DM, C);
+					if (bLoss) sumSq += static_cast<ext_real_t>(get_self().ewSumSquaresTriang<bLowerTriangl, bNumStab>(C));
+					if (bDLoss) {
+						for (vec_len_t c = 0; c < bi; ++c) pC[c*(bi + 1)] = real_t(0.);
+						b_BLAS_t::symm(false, bLowerTriangl, vRows, bi, cmnScale, pC, bi, DM.data(), vRows, real_t(1.), pdL_I, ldL);
+					}
 
-			get_self()._istor_free(pDeMeaned, valsNumelNoBias);
-			return ret;
-		}
+				#if NNTL_DEBUGBREAK_ON_OPENBLAS_DENORMALS
+					enable_denormals();
+					C._breakWhenDenormal();
+					DM._breakWhenDenormal();
+					global_denormalized_floats_mode();
+				#endif
+				}
 
-		template<bool bLowerTriangl, bool bNumStab>
-		void dLoss_deCov(const realmtx_t& Vals, realmtx_t& dLossdVals, const real_t deCov_scale = real_t(1.0))noexcept {
-			NNTL_ASSERT(Vals.cols_no_bias() == dLossdVals.cols() && Vals.rows() == dLossdVals.rows());
+				if (bDLoss && i0) {
+					for (vec_len_t c = 0; c < bi; ++c) {
+						const real_t v = cmnScale*pCorr[c];
+						const auto pCol = pdL_I + c*ldL;
+						for (vec_len_t r = 0; r < vRows; ++r) pCol[r] -= v;
+					}
+				}
+			}
 
-		#ifndef NNTL_DECOV_DONT_CARE_ON_HOLEY_BIASES
-			NNTL_ASSERT(!Vals.emulatesBiases() || !Vals.isHoleyBiases() || !"Current deCov algorithm does not support holey biases!");
-			//to support holey biases algorithm must ignore rows with zeroed biases. Looks like the easiest (and probably the
-			//fastest to run) way to do it is to make a something like a Vals.clone_to_droping_holes(DeMeaned) and then proceed as normal
-		#endif // !NNTL_DECOV_DONT_CARE_ON_HOLEY_BIASES
+		#if NNTL_DEBUGBREAK_ON_OPENBLAS_DENORMALS
+			if (bDLoss) {
+				enable_denormals();
+				pdLossdVals->_breakWhenDenormal();
+				global_denormalized_floats_mode();
+			}
+		#endif
 
-			NNTL_ASSERT(Vals.cols_no_bias() > 1);
-			NNTL_ASSERT(!dLossdVals.emulatesBiases());
+			get_self()._istor_free(pTmp, tmemSize);
 
-			const auto bCr = Vals.clone_to_no_bias(dLossdVals);
-			NNTL_ASSERT(bCr);
-			get_self().dLoss_deCov_ip<bLowerTriangl, bNumStab>(dLossdVals, deCov_scale);
+			// - and to the amount of active neurons
+			return bLoss ? static_cast<real_t>(sumSq / static_cast<ext_real_t>(vCols - 1)) : real_t(0.);
 		}
 
-		// N=size(A,1);
-		// actCnt = size(A, 2);
-		// DM = A - mean(A);
-		// C = DM'*DM./N;
-		// dL = (DM*C - diag(C)'.*DM).*2./N;
+	public:
+		//requires dLoss_deCov_ip_needTempMem() temporary memory
 		template<bool bLowerTriangl, bool bNumStab>
 		void dLoss_deCov_ip(realmtx_t& Vals_dLossdVals, const real_t deCov_scale = real_t(1.0))noexcept {
 			NNTL_ASSERT(!Vals_dLossdVals.emulatesBiases());
 
-			const auto vRows = Vals_dLossdVals.rows(), vCols = Vals_dLossdVals.cols();
-
-			const auto valsNumelNoBias = Vals_dLossdVals.numel();
-			real_t*const pDeMeaned = get_self()._istor_alloc(valsNumelNoBias);
-			realmtx_t DeMeaned(pDeMeaned, Vals_dLossdVals, realmtx_t::tag_noBias());
-			NNTL_ASSERT(!DeMeaned.emulatesBiases());
-			const auto _clone_result = Vals_dLossdVals.clone_to_no_bias(DeMeaned);
+			const auto valsNumel = Vals_dLossdVals.numel();
+			real_t*const pVals = get_self()._istor_alloc(valsNumel);
+			realmtx_t Vals(pVals, Vals_dLossdVals.size());
+			const auto _clone_result = Vals_dLossdVals.clone_to(Vals);
 			NNTL_ASSERT(_clone_result);
 
-			get_self().mcwDeMean<bNumStab>(DeMeaned);
+			get_self().dLoss_deCov<bLowerTriangl, bNumStab>(Vals, Vals_dLossdVals, deCov_scale);
 
-			const auto covMtxNumel = realmtx_t::sNumel(vCols, vCols);
-			real_t*const pCovMtx = get_self()._istor_alloc(covMtxNumel);
-			realmtx_t CovMtx(pCovMtx, vCols, vCols);
+			get_self()._istor_free(pVals, valsNumel);
+		}
 
-			get_self().mColumnsCov<bLowerTriangl>(DeMeaned, CovMtx);
-			
-			DeMeaned.clone_to(Vals_dLossdVals);
-			get_self().mcwMulDiag_ip(Vals_dLossdVals, CovMtx);
+		//////////////////////////////////////////////////////////////////////////
+		//////////////////////////////////////////////////////////////////////////
 
-			//dL = (DM*C - diag(C)'.*DM).*2./N;
-			
-			//const real_t cmnScale = (real_t(2.)*deCov_scale) / static_cast<real_t>(vRows);
-			
-			const real_t cmnScale = static_cast<real_t>( (ext_real_t(2.)* static_cast<ext_real_t>(deCov_scale))
-				/ static_cast<ext_real_t>(valsNumelNoBias - vRows));
+	protected:
+		//mcwFindKOrdered() scans source rows in chunks of this size, skipping a whole chunk if none of its elements
+		//passes a threshold test.
+		static constexpr vec_len_t _mcwFindKOrdered_chunkLen = 16;
 
-#if NNTL_DEBUGBREAK_ON_OPENBLAS_DENORMALS
-			enable_denormals();
-			Vals_dLossdVals._breakWhenDenormal();
-			CovMtx._breakWhenDenormal();
-			DeMeaned._breakWhenDenormal();
-			if (::std::fpclassify(cmnScale) == FP_SUBNORMAL) {
-				__debugbreak();
+		//inserts a value that is known to be better than pCache[0] into the cache. Returns new pCache[0]
+		template<typename HelperT>
+		static typename HelperT::src_value_t _mcwFindKOrdered_insert(const typename HelperT::src_value_t v
+			, const typename HelperT::idxs_t idx, typename HelperT::src_value_t*__restrict const pCache
+			, typename HelperT::idxs_t*__restrict const pI, const vec_len_t k)noexcept
+		{
+			typedef typename HelperT::OrderFunctor_t OrderFunctor_t;
+			NNTL_ASSERT(OrderFunctor_t::first_better(v, pCache[0]));
+
+			//v should be placed into cache. Looking for proper place
+			vec_len_t hi = 1;
+			for (; hi < k; ++hi) {
+				//if (pCache[hi] > v) break; //we must put v to position hi-1
+				if (OrderFunctor_t::first_better(pCache[hi], v)) break;
 			}
-			global_denormalized_floats_mode();
-#endif
+			const auto insertPos = hi - 1;
+			//if (v > pCache[insertPos]) {
+		#pragma warning(push,3)
+			if (HelperT::bNonStrictComparision || OrderFunctor_t::first_better(v, pCache[insertPos])) {
+				//elements with indexes 0..hi-1 are smaller than v. We should move them one step up and put v to [vi]
+				for (vec_len_t hj = 0; hj < insertPos; ++hj) {
+					pCache[hj] = pCache[hj + 1];
+					pI[hj] = pI[hj + 1];
+				}
+				pCache[insertPos] = v;
+				pI[insertPos] = idx;
+			} else NNTL_ASSERT(HelperT::bNonStrictComparision || v == pCache[insertPos]); //leaving old value in place!
+		#pragma warning(pop)
+			return pCache[0];
+		}
 
-			b_BLAS_t::symm(false, bLowerTriangl, vRows, vCols, cmnScale, CovMtx.data(), vCols
-				, DeMeaned.data(), vRows, -cmnScale, Vals_dLossdVals.data(), vRows);
+		//elements with radix key less than returned value can't be among k best elements of [pS, pSE) and could be
+		//skipped without changing the result (ties are kept). Valid for non-distinct orders only, because the
+		//histogram counts equal values as many times as they appear
+		template<typename HelperT>
+		static typename HelperT::radix_key_t _mcwFindKOrdered_radixFloor(const typename HelperT::src_value_t*__restrict pS
+			, const typename HelperT::src_value_t*__restrict const pSE, const vec_len_t k)noexcept
+		{
+			typedef typename HelperT::OrderFunctor_t OrderFunctor_t;
+			typedef typename HelperT::radix_key_t radix_key_t;
+			typedef _impl::fp_radix_key<typename HelperT::src_value_t> fp_radix_key_t;
+			static_assert(HelperT::bNonStrictComparision, "Radix selection doesn't work with distinct orders");
+			static constexpr unsigned histBuckets = 1u << fp_radix_key_t::histBits;
+
+			vec_len_t hist[histBuckets] = {};
+			while (pS != pSE) {
+				++hist[static_cast<size_t>(OrderFunctor_t::radix_key(*pS++) >> fp_radix_key_t::histShift)];
+			}
+			vec_len_t cnt = 0;
+			for (unsigned b = histBuckets; b > 0; --b) {
+				cnt += hist[b - 1];
+				if (cnt >= k) return static_cast<radix_key_t>(b - 1) << fp_radix_key_t::histShift;
+			}
+			return radix_key_t(0);
+		}
 
-#if NNTL_DEBUGBREAK_ON_OPENBLAS_DENORMALS
-			Vals_dLossdVals._breakWhenDenormal();
-#endif
+		template<typename HelperT, bool bRadix>
+		static bool _mcwFindKOrdered_passes(const typename HelperT::src_value_t v, const typename HelperT::src_value_t cache0
+			, const typename HelperT::radix_key_t radixFloor)noexcept
+		{
+			typedef typename HelperT::OrderFunctor_t OrderFunctor_t;
+			return OrderFunctor_t::first_better(v, cache0) & (!bRadix || (OrderFunctor_t::radix_key(v) >= radixFloor));
+		}
 
-			get_self()._istor_free(pCovMtx, covMtxNumel);
-			get_self()._istor_free(pDeMeaned, valsNumelNoBias);
+		//single pass over src rows [rBeg, rEnd) with updating of the cache. Row indexes are counted from pSrc
+		template<typename HelperT, bool bRadix>
+		static void _mcwFindKOrdered_scan(const typename HelperT::src_value_t*__restrict const pSrc
+			, const vec_len_t rBeg, const vec_len_t rEnd, typename HelperT::src_value_t*__restrict const pCache
+			, typename HelperT::idxs_t*__restrict const pI, const vec_len_t k, const typename HelperT::radix_key_t radixFloor)noexcept
+		{
+			typedef typename HelperT::src_value_t src_value_t;
+			typedef typename HelperT::idxs_t idxs_t;
+
+			const src_value_t*__restrict pS = pSrc + rBeg;
+			const auto pSE = pSrc + rEnd;
+			const auto pSCE = pS + ((rEnd - rBeg) / _mcwFindKOrdered_chunkLen) * _mcwFindKOrdered_chunkLen;
+			auto cache0 = pCache[0];
+			while (pS != pSCE) {
+				//cache0 only gets better, so if no element of the chunk passes the test against the current cache0,
+				//none of them would pass it later. Branchless loop to let the compiler vectorize it
+				unsigned bAny = 0;
+				for (vec_len_t j = 0; j < _mcwFindKOrdered_chunkLen; ++j) {
+					bAny |= static_cast<unsigned>(_mcwFindKOrdered_passes<HelperT, bRadix>(pS[j], cache0, radixFloor));
+				}
+				if (bAny) {
+					for (vec_len_t j = 0; j < _mcwFindKOrdered_chunkLen; ++j) {
+						const auto v = pS[j];
+						if (_mcwFindKOrdered_passes<HelperT, bRadix>(v, cache0, radixFloor)) {
+							cache0 = _mcwFindKOrdered_insert<HelperT>(v, static_cast<idxs_t>(pS - pSrc + j), pCache, pI, k);
+						}
+					}
+				}
+				pS += _mcwFindKOrdered_chunkLen;
+			}
+			while (pS != pSE) {
+				const auto v = *pS;
+				if (_mcwFindKOrdered_passes<HelperT, bRadix>(v, cache0, radixFloor)) {
+					cache0 = _mcwFindKOrdered_insert<HelperT>(v, static_cast<idxs_t>(pS - pSrc), pCache, pI, k);
+				}
+				++pS;
+			}
 		}
 
-		//////////////////////////////////////////////////////////////////////////
-		//////////////////////////////////////////////////////////////////////////
+		template<typename HelperT, bool bNS = HelperT::bNonStrictComparision>
+		static ::std::enable_if_t<bNS> _mcwFindKOrdered_range(const typename HelperT::src_value_t*__restrict const pSrc
+			, const vec_len_t rBeg, const vec_len_t rEnd, typename HelperT::src_value_t*__restrict const pCache
+			, typename HelperT::idxs_t*__restrict const pI, const vec_len_t k)noexcept
+		{
+			//for a big k and only a few rows per k most of time is spent in insertions, so selecting
+			//a threshold first with a single histogram pass pays off. Otherwise the chunk prefilter is faster
+			if (k >= Thresholds_t::mcwFindKOrdered_radix_k && (rEnd - rBeg) / k <= Thresholds_t::mcwFindKOrdered_radix_maxRowsPerK) {
+				_mcwFindKOrdered_scan<HelperT, true>(pSrc, rBeg, rEnd, pCache, pI, k
+					, _mcwFindKOrdered_radixFloor<HelperT>(pSrc + rBeg, pSrc + rEnd, k));
+			} else _mcwFindKOrdered_scan<HelperT, false>(pSrc, rBeg, rEnd, pCache, pI, k, typename HelperT::radix_key_t(0));
+		}
+		template<typename HelperT, bool bNS = HelperT::bNonStrictComparision>
+		static ::std::enable_if_t<!bNS> _mcwFindKOrdered_range(const typename HelperT::src_value_t*__restrict const pSrc
+			, const vec_len_t rBeg, const vec_len_t rEnd, typename HelperT::src_value_t*__restrict const pCache
+			, typename HelperT::idxs_t*__restrict const pI, const vec_len_t k)noexcept
+		{
+			_mcwFindKOrdered_scan<HelperT, false>(pSrc, rBeg, rEnd, pCache, pI, k, typename HelperT::radix_key_t(0));
+		}
+
+		template<typename HelperT>
+		static void _mcwFindKOrdered_initCache(typename HelperT::src_value_t*__restrict const pCache
+			, typename HelperT::idxs_t*__restrict const pI, const vec_len_t k, const bool bResetValues)noexcept
+		{
+			// pCache will contain top-K biggest values in ascending order
+			// and pI will contain their indexes within current batch/matrix.
+			// on function exit an invalid index (>=0 is valid by def) mean that the corresponding value in cache
+			// is not from current source matrix
+			for (vec_len_t i = 0; i < k; ++i) pI[i] = -1;
+
+			if (bResetValues) {
+				//reinitializing the values to lowest possible to start from the beginning
+				for (vec_len_t i = 0; i < k; ++i) {
+					pCache[i] = HelperT::OrderFunctor_t::most_extreme();
+				}
+			}//if it is next batch, just leave cached values to compare against intact
+		}
+
+		//row-split mode keeps per thread data in real_t temporary storage using the same layout as hlprmtx_t column
+		template<typename HelperT>
+		using _mcwFindKOrdered_canSplit = ::std::integral_constant<bool, sizeof(typename HelperT::value_t) == sizeof(real_t)>;
+
+		//count of real_t elements of temporary storage for a single thread in row-split mode
+		template<typename HelperT>
+		static numel_cnt_t _mcwFindKOrdered_slotNumel(const vec_len_t k)noexcept {
+			static_assert(_mcwFindKOrdered_canSplit<HelperT>::value, "");
+			return base_class_t::template _istor_round_count_to_cache_line_size<real_t>(
+				static_cast<numel_cnt_t>(HelperT::hlprmtx_numel_for_k(k)));
+		}
+
+		template<typename HelperT, bool b = _mcwFindKOrdered_canSplit<HelperT>::value>
+		::std::enable_if_t<b, bool> _mcwFindKOrdered_tryRowsplit(const smatrix<typename HelperT::src_value_t>& src
+			, typename HelperT::hlprmtx_t& mHlpr, const bool bNextBatch)noexcept
+		{
+			const bool bSplit = src.cols_no_bias() < static_cast<vec_len_t>(get_self().ithreads().cur_workers_count())
+				&& src.rows_no_bias() >= Thresholds_t::mcwFindKOrdered_mt_rows
+				&& get_self()._istor_available() >= get_self().mcwFindKOrdered_needTempMem<HelperT>(HelperT::get_k(mHlpr));
+			if (bSplit) get_self()._mcwFindKOrdered_rowsplit<HelperT>(src, mHlpr, bNextBatch);
+			return bSplit;
+		}
+		template<typename HelperT, bool b = _mcwFindKOrdered_canSplit<HelperT>::value>
+		constexpr ::std::enable_if_t<!b, bool> _mcwFindKOrdered_tryRowsplit(const smatrix<typename HelperT::src_value_t>&
+			, typename HelperT::hlprmtx_t&, const bool)const noexcept
+		{
+			return false;
+		}
+
+		// Each column is processed by all threads. Every thread finds k best elements of its rows range, then
+		// the results are merged in rows order. Since the global k best of a range are always among k best of
+		// its part, that gives exactly the same result (including the ties) as a single pass over the column
+		template<typename HelperT>
+		void _mcwFindKOrdered_rowsplit(const smatrix<typename HelperT::src_value_t>& src
+			, typename HelperT::hlprmtx_t& mHlpr, const bool bNextBatch)noexcept
+		{
+			typedef HelperT mcwFindKOrdered_hlpr_t;
+			typedef typename HelperT::src_value_t src_value_t;
+			typedef typename mcwFindKOrdered_hlpr_t::value_t hlpr_value_t;
+			typedef typename mcwFindKOrdered_hlpr_t::idxs_t idxs_t;
+			typedef typename mcwFindKOrdered_hlpr_t::OrderFunctor_t OrderFunctor_t;
+
+			const vec_len_t k = mcwFindKOrdered_hlpr_t::get_k(mHlpr);
+			const vec_len_t r = src.rows_no_bias(), cols = mHlpr.cols();
+			const auto nSlots = get_self().ithreads().cur_workers_count();
+			const auto slotNumel = _mcwFindKOrdered_slotNumel<HelperT>(k);
+			const auto tmemSize = slotNumel * nSlots;
+			real_t*const pTmem = get_self()._istor_alloc(tmemSize);
+
+			for (vec_len_t c = 0; c < cols; ++c) {
+				const src_value_t*__restrict const pSrc = src.colDataAsVec(c);
+				//marking all slots as unused, because scheduler may use less threads than available
+				for (thread_id_t s = 0; s < nSlots; ++s) {
+					const auto pSlot = reinterpret_cast<hlpr_value_t*>(pTmem + slotNumel*s);
+					_mcwFindKOrdered_initCache<HelperT>(mcwFindKOrdered_hlpr_t::get_cache_ptr_from_column_ptr(pSlot, k)
+						, mcwFindKOrdered_hlpr_t::get_idxs_ptr_from_column_ptr(pSlot, k), k, true);
+				}
+
+				get_self().ithreads().run([this, pTmem, slotNumel, pSrc, k](const auto& pr)noexcept {
+					const auto pSlot = reinterpret_cast<hlpr_value_t*>(pTmem + slotNumel*pr.tid());
+					idxs_t*__restrict const pI = mcwFindKOrdered_hlpr_t::get_idxs_ptr_from_column_ptr(pSlot, k);
+					_mcwFindKOrdered_range<HelperT>(pSrc, static_cast<vec_len_t>(pr.offset()), static_cast<vec_len_t>(pr.end())
+						, mcwFindKOrdered_hlpr_t::get_cache_ptr_from_column_ptr(pSlot, k), pI, k);
+					//only indexes are needed to merge, values are in pSrc. Unused entries (-1) go first
+					::std::sort(pI, pI + k);
+				}, r);
+
+				hlpr_value_t*__restrict const pHlprVals = mHlpr.colDataAsVec(c);
+				idxs_t*__restrict const pI = mcwFindKOrdered_hlpr_t::get_idxs_ptr_from_column_ptr(pHlprVals, k);
+				src_value_t*__restrict const pCache = mcwFindKOrdered_hlpr_t::get_cache_ptr_from_column_ptr(pHlprVals, k);
+				_mcwFindKOrdered_initCache<HelperT>(pCache, pI, k, !bNextBatch);
+
+				//slots hold disjoint rows ranges, so feeding slots ordered by their first index gives rows order
+				idxs_t prevLast = -1;
+				while (true) {
+					idxs_t*__restrict pBest = nullptr;
+					idxs_t*__restrict pBestE = nullptr;
+					for (thread_id_t s = 0; s < nSlots; ++s) {
+						const auto pSlot = reinterpret_cast<hlpr_value_t*>(pTmem + slotNumel*s);
+						idxs_t*__restrict pSI = mcwFindKOrdered_hlpr_t::get_idxs_ptr_from_column_ptr(pSlot, k);
+						const auto pSIE = pSI + k;
+						pSI = ::std::upper_bound(pSI, pSIE, prevLast);
+						if (pSI != pSIE && (!pBest || *pSI < *pBest)) {
+							pBest = pSI;
+							pBestE = pSIE;
+						}
+					}
+					if (!pBest) break;
+					prevLast = *(pBestE - 1);
+
+					auto cache0 = pCache[0];
+					for (; pBest != pBestE; ++pBest) {
+						const auto v = pSrc[*pBest];
+						if (OrderFunctor_t::first_better(v, cache0)) {
+							cache0 = _mcwFindKOrdered_insert<HelperT>(v, *pBest, pCache, pI, k);
+						}
+					}
+				}
+			}
+			get_self()._istor_free(pTmem, tmemSize);
+		}
+
+	public:
+		//returns the size of temporary storage that mcwFindKOrdered() could use to process a matrix having
+		//less columns than threads. Without it all the columns are processed in parallel
+		template<typename HelperT, bool b = _mcwFindKOrdered_canSplit<HelperT>::value>
+		::std::enable_if_t<b, numel_cnt_t> mcwFindKOrdered_needTempMem(const vec_len_t k)const noexcept {
+			return _mcwFindKOrdered_slotNumel<HelperT>(k) * m_threads.cur_workers_count();
+		}
+		template<typename HelperT, bool b = _mcwFindKOrdered_canSplit<HelperT>::value>
+		constexpr ::std::enable_if_t<!b, numel_cnt_t> mcwFindKOrdered_needTempMem(const vec_len_t)const noexcept {
+			return 0;
+		}
 
 		// MUCH faster than partial_sort on datasizes bigger than 100000 rows. The more rows, the bigger the difference
 		// Also it returns k biggest DISTINCT values/indexes.. See use-case in tests
 		// Biases if any are ignored.
 		// Didn't do _st() version as it's generally _mt only
 		// #supportsBatchInRow, note that actual flag is irrelevant here, b/c it's always columnwise, hence "mcw" func.name prefix
+		// Every column is scanned in chunks that are skipped as a whole when no element could get into the cache.
+		// For non-distinct orders, a big k and a few rows per k a radix histogram of the column is used to skip elements, that can't be among
+		// the k best, from the very beginning. Matrices with less columns than threads have each column split over threads
+		// if there's enough temporary memory, see mcwFindKOrdered_needTempMem()
 		template<typename HelperT>
 		void mcwFindKOrdered(const smatrix<typename HelperT::src_value_t>& src
 			, typename HelperT::hlprmtx_t& mHlpr
@@ -5191,79 +6282,36 @@ namespace math {
 			typedef typename HelperT::src_value_t src_value_t;
 			typedef typename mcwFindKOrdered_hlpr_t::value_t hlpr_value_t;
 			typedef typename mcwFindKOrdered_hlpr_t::idxs_t idxs_t;
-			typedef typename mcwFindKOrdered_hlpr_t::OrderFunctor_t OrderFunctor_t;
 			NNTL_ASSERT(mcwFindKOrdered_hlpr_t::is_hlprmtx_fine_for(mHlpr, src));
 			NNTL_ASSERT(!bNextBatch || mcwFindKOrdered_hlpr_t::is_hlprmtx_ok(mHlpr));
 
-			static constexpr bool bNonStrictComparision = OrderFunctor_t::first_better(OrderFunctor_t::most_extreme(), OrderFunctor_t::most_extreme());
+			if (!get_self()._mcwFindKOrdered_tryRowsplit<HelperT>(src, mHlpr, bNextBatch)) {
+				get_self().ithreads().run([this, &mHlpr, &src, bNextBatch](const auto& pr)noexcept {
+					const auto ldH = mHlpr.ldim(), ldS = src.ldim();
+					const vec_len_t r = src.rows_no_bias();
 
-			get_self().ithreads().run([&mHlpr, &src, bNextBatch](const auto& pr)noexcept {
-				const auto ldH = mHlpr.ldim(), ldS = src.ldim();
-				const ptrdiff_t r = src.rows_no_bias();
+					hlpr_value_t*__restrict pHlprVals = mHlpr.colDataAsVec(static_cast<vec_len_t>(pr.offset()));
+					const src_value_t*__restrict pSrc = src.colDataAsVec(static_cast<vec_len_t>(pr.offset()));
+					const auto pHlprE = pHlprVals + ldH * pr.cnt();
 
-				hlpr_value_t*__restrict pHlprVals = mHlpr.colDataAsVec(static_cast<vec_len_t>(pr.offset()));
-				const src_value_t*__restrict pSrc = src.colDataAsVec(static_cast<vec_len_t>(pr.offset()));
-				const auto pHlprE = pHlprVals + ldH * pr.cnt();
+					const vec_len_t k = mcwFindKOrdered_hlpr_t::get_k(mHlpr);
 
-				const vec_len_t k = mcwFindKOrdered_hlpr_t::get_k(mHlpr);
+					while (pHlprVals != pHlprE) {
+						//initializing cache
+						idxs_t*__restrict const pI = mcwFindKOrdered_hlpr_t::get_idxs_ptr_from_column_ptr(pHlprVals, k);
+						src_value_t*__restrict const pCache = mcwFindKOrdered_hlpr_t::get_cache_ptr_from_column_ptr(pHlprVals, k);
+						NNTL_ASSERT(pI + k <= reinterpret_cast<idxs_t*>(pHlprVals + ldH));
+						NNTL_ASSERT(pCache + k <= reinterpret_cast<src_value_t*>(pHlprVals + ldH));
 
-				while (pHlprVals != pHlprE) {
-					//initializing cache
-					idxs_t*__restrict const pI = mcwFindKOrdered_hlpr_t::get_idxs_ptr_from_column_ptr(pHlprVals, k);
-					src_value_t*__restrict const pCache = mcwFindKOrdered_hlpr_t::get_cache_ptr_from_column_ptr(pHlprVals, k);
-					NNTL_ASSERT(pI + k <= reinterpret_cast<idxs_t*>(pHlprVals + ldH));
-					NNTL_ASSERT(pCache + k <= reinterpret_cast<src_value_t*>(pHlprVals + ldH));
-					
-					// pCache will contain top-K biggest values in ascending order
-					// and pI will contain their indexes within current batch/matrix.
-					// on function exit an invalid index (>=0 is valid by def) mean that the corresponding value in cache
-					// is not from current source matrix
-					for (vec_len_t i = 0; i < k; ++i) pI[i] = -1;
-
-					if (!bNextBatch) {
-						//reinitializing the values to lowest possible to start from the beginning
-						for (vec_len_t i = 0; i < k; ++i) {
-							//pCache[i] = ::std::numeric_limits<src_value_t>::lowest();
-							pCache[i] = OrderFunctor_t::most_extreme();
-						}
-					}//if it is next batch, just leave cached values to compare against intact
+						_mcwFindKOrdered_initCache<HelperT>(pCache, pI, k, !bNextBatch);
+						//doing single pass over src and filling the values and indexes
+						_mcwFindKOrdered_range<HelperT>(pSrc, 0, r, pCache, pI, k);
 
-					//doing single pass over src and filling the values and indexes
-					const src_value_t*__restrict pS = pSrc;
-					const auto pSE = pS + r;
-					auto cache0 = pCache[0];
-					while (pS != pSE) {
-						const auto v = *pS++;
-						//walk over max k prestored values to find if v is bigger
-						//if (v > cache0) {
-						if (OrderFunctor_t::first_better(v, cache0)) {
-							//v should be placed into cache. Looking for proper place
-							vec_len_t hi = 1;
-							for (; hi < k; ++hi) {
-								//if (pCache[hi] > v) break; //we must put v to position hi-1
-								if (OrderFunctor_t::first_better(pCache[hi], v)) break;
-							}
-							const auto insertPos = hi - 1;
-							//if (v > pCache[insertPos]) {
-						#pragma warning(push,3)
-							if (bNonStrictComparision || OrderFunctor_t::first_better(v, pCache[insertPos])) {
-								//elements with indexes 0..hi-1 are smaller than v. We should move them one step up and put v to [vi]
-								for (vec_len_t hj = 0; hj < insertPos; ++hj) {
-									pCache[hj] = pCache[hj + 1];
-									pI[hj] = pI[hj + 1];
-								}
-								pCache[insertPos] = v;
-								pI[insertPos] = static_cast<idxs_t>(pS - pSrc - 1);
-								cache0 = pCache[0];
-							} else NNTL_ASSERT(bNonStrictComparision || v == pCache[insertPos]); //leaving old value in place!
-						#pragma warning(pop)
-						}
+						pSrc += ldS;
+						pHlprVals += ldH;
 					}
-
-					pSrc += ldS;
-					pHlprVals += ldH;
-				}
-			}, mHlpr.cols());
+				}, mHlpr.cols());
+			}
 
 			NNTL_ASSERT(mcwFindKOrdered_hlpr_t::is_hlprmtx_ok(mHlpr));
 		}
@@ -5295,6 +6343,8 @@ namespace math {
 	public:
 		~MathN()noexcept {}
 		MathN()noexcept : _MathN<RealT, iThreadsT, iMemmgrT, ThresholdsT, MathN<RealT, iThreadsT, iMemmgrT, ThresholdsT>>() {}
+		explicit MathN(const thread_id_t nThreads)noexcept
+			: _MathN<RealT, iThreadsT, iMemmgrT, ThresholdsT, MathN<RealT, iThreadsT, iMemmgrT, ThresholdsT>>(nThreads) {}
 	};
 
 }
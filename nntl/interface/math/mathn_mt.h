@@ -417,6 +417,13 @@ namespace math {
 			return loss_softmax_xentropy_mt(activations, data_y);
 		}
 
+		void softmax_xentropy_dLdZ(realmtx_t& Z2dLdZ, const realmtx_t& data_y)noexcept {
+			softmax_xentropy_dLdZ_mt(Z2dLdZ, data_y);
+		}
+		real_t softmax_xentropy_loss(realmtx_t& Z2act, const realmtx_t& data_y)noexcept {
+			return softmax_xentropy_loss_mt(Z2act, data_y);
+		}
+
 		//////////////////////////////////////////////////////////////////////////
 		//gradient application procedures
 		void RMSProp_Hinton(realmtx_t& dW, realmtx_t& rmsF, const real_t learningRate,
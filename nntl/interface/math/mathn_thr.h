@@ -61,8 +61,18 @@ namespace _impl {
 		static constexpr numel_cnt_t mExtractRowsSeq = 6000;//nt
 
 		static constexpr numel_cnt_t mTransposeTrsh = 90000/2;
+		//src.numel() and the smallest src dimension to switch from scalar loops to cache blocked SIMD transposition.
+		// Measured single threaded: mostly 1.5x..8x faster above these, but up to 2x slower on thinner matrices
+		// (the edges are scalar there). MT version isn't dispatched automatically until it's measured
+		static constexpr numel_cnt_t mTranspose_blocked = 1000;
+		static constexpr vec_len_t mTranspose_blocked_minDim = 16;
 
 		static constexpr vec_len_t mFillRowsByMask = 100;//nt
+		static constexpr numel_cnt_t mExtractRowsByIdx = 10000;//nt
+		static constexpr numel_cnt_t mFillRowsByIdx = 10000;//nt
+		static constexpr numel_cnt_t mGatherEmbeddings = 20000;//nt
+		static constexpr numel_cnt_t mScatterAddEmbeddingsGrad = 25000;//nt
+		static constexpr numel_cnt_t mMulABt_sparseB = 30000;//nt
 
 		static constexpr numel_cnt_t mrwL2NormSquared = 124000;
 		static constexpr vec_len_t mrwL2NormSquared_mt_cw_ColsPerThread = 3;
@@ -176,6 +186,21 @@ namespace _impl {
 		static constexpr numel_cnt_t loss_xentropy = 1000;// 800;
 		static constexpr numel_cnt_t loss_xentropy_ns = 1000;
 		static constexpr numel_cnt_t loss_softmax_xentropy = 1100;
+		//per element the st kernel costs ~1.3x (float) .. ~1.4x (double) of loss_softmax_xentropy_st(), the mt overhead is the same
+		static constexpr numel_cnt_t softmax_xentropy_fused = 800;
+
+		//columns block width of loss_deCov()/dLoss_deCov(). 256 was within noise of the best of 64..2048 (OpenBLAS, 100..500 rows,
+		// 256..2048 cols), the unblocked version (the block covers all columns) was never faster
+		static constexpr vec_len_t deCov_blockCols = 256;
+
+		//mcwFindKOrdered(): smallest k and biggest rows/k ratio to pick candidates of non-distinct orders with a radix histogram.
+		// The histogram pass costs more than the whole plain scan unless the cache gets a lot of insertions, i.e. k is big
+		// and rows/k is small. k=32 never won, rows/k=62 lost up to 1.7x, rows/k<=32 with k>=64 won 1.2x..2.3x
+		static constexpr vec_len_t mcwFindKOrdered_radix_k = 64;
+		static constexpr vec_len_t mcwFindKOrdered_radix_maxRowsPerK = 32;
+		//mcwFindKOrdered(): smallest rows count to split a column over threads when there are less columns than threads.
+		// Derived from mrwL2NormSquared: per element the scan with a small k costs ~1.0x..1.2x of mrwL2NormSquared_st()
+		static constexpr vec_len_t mcwFindKOrdered_mt_rows = 110000;
 
 		static constexpr numel_cnt_t RMSProp_Hinton = 2940;
 		static constexpr numel_cnt_t RMSProp_Graves = 2970;
@@ -208,8 +233,16 @@ namespace _impl {
 
 		static constexpr vec_len_t mExtractRowsByMask = 12000;//*
 		static constexpr vec_len_t mFillRowsByMask = 10000;//*
+		static constexpr numel_cnt_t mExtractRowsByIdx = 12000;//nt
+		static constexpr numel_cnt_t mFillRowsByIdx = 12000;//nt
+		static constexpr numel_cnt_t mGatherEmbeddings = 25000;//nt
+		static constexpr numel_cnt_t mScatterAddEmbeddingsGrad = 30000;//nt
+		static constexpr numel_cnt_t mMulABt_sparseB = 35000;//nt
 
 		static constexpr numel_cnt_t mTransposeTrsh = 90000;
+		//see the double version. The SSE kernel was faster at every shape with both dimensions >= 8
+		static constexpr numel_cnt_t mTranspose_blocked = 1000;
+		static constexpr vec_len_t mTranspose_blocked_minDim = 8;
 
 		static constexpr numel_cnt_t mrwL2NormSquared = 250000;
 		static constexpr vec_len_t mrwL2NormSquared_mt_cw_ColsPerThread = 3;
@@ -322,6 +355,21 @@ namespace _impl {
 		static constexpr numel_cnt_t loss_xentropy = 850;//750;
 		static constexpr numel_cnt_t loss_xentropy_ns = 850;//750;
 		static constexpr numel_cnt_t loss_softmax_xentropy = 1100;
+		//per element the st kernel costs ~1.3x (float) .. ~1.4x (double) of loss_softmax_xentropy_st(), the mt overhead is the same
+		static constexpr numel_cnt_t softmax_xentropy_fused = 800;
+
+		//columns block width of loss_deCov()/dLoss_deCov(). 256 was within noise of the best of 64..2048 (OpenBLAS, 100..500 rows,
+		// 256..2048 cols), the unblocked version (the block covers all columns) was never faster
+		static constexpr vec_len_t deCov_blockCols = 256;
+
+		//mcwFindKOrdered(): smallest k and biggest rows/k ratio to pick candidates of non-distinct orders with a radix histogram.
+		// The histogram pass costs more than the whole plain scan unless the cache gets a lot of insertions, i.e. k is big
+		// and rows/k is small. k=32 never won, rows/k=62 lost up to 1.7x, rows/k<=32 with k>=64 won 1.2x..2.3x
+		static constexpr vec_len_t mcwFindKOrdered_radix_k = 64;
+		static constexpr vec_len_t mcwFindKOrdered_radix_maxRowsPerK = 32;
+		//mcwFindKOrdered(): smallest rows count to split a column over threads when there are less columns than threads.
+		// Derived from mrwL2NormSquared: per element the scan with a small k costs ~1.4x..2.3x of mrwL2NormSquared_st()
+		static constexpr vec_len_t mcwFindKOrdered_mt_rows = 140000;
 
 		static constexpr numel_cnt_t RMSProp_Hinton = 8100;
 		static constexpr numel_cnt_t RMSProp_Graves = 8000;
@@ -39,6 +39,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "smatrix.h"
 #include "smath_thr.h"
 #include <algorithm>
+#include <cstring>
 #include <numeric>
 #include "../../utils/denormal_floats.h"
 
@@ -114,13 +115,13 @@ namespace math {
 		static_assert(::std::is_same<numel_cnt_t, typename iThreadsT::range_t>::value, "iThreads::range_t should be the same as realmtx_t::numel_cnt_t");
 
 		//ALL branching functions require refactoring
-		typedef typename ThresholdsT Thresholds_t;
+		typedef ThresholdsT Thresholds_t;
 
 		//TODO: probably don't need this assert
 		static_assert(::std::is_base_of<_impl::SMATH_THR<real_t>, Thresholds_t>::value, "Thresholds_t must be derived from _impl::SMATH_THR<real_t>");
 
 	protected:
-		typedef ::std::vector<real_t> thread_temp_storage_t;
+		typedef utils::raw_buffer<real_t, NNTL_CFG_ALLOCATOR> thread_temp_storage_t;
 
 		//////////////////////////////////////////////////////////////////////////
 		// members
@@ -137,6 +138,12 @@ namespace math {
 		_SMath()noexcept : m_minTempStorageSize(0), m_curStorElementsAllocated(0){
 			global_denormalized_floats_mode();
 		}
+		//nThreads is passed to iThreads_t constructor (total count of threads to use)
+		explicit _SMath(const thread_id_t nThreads)noexcept
+			: m_threads(nThreads), m_minTempStorageSize(0), m_curStorElementsAllocated(0)
+		{
+			global_denormalized_floats_mode();
+		}
 
 		iThreads_t& ithreads()noexcept { return m_threads; }
 		const iThreads_t& ithreads()const noexcept { return m_threads; }
@@ -196,6 +203,11 @@ namespace math {
 			}
 		}
 
+		// count of real_t elements that still could be obtained with _istor_alloc()
+		numel_cnt_t _istor_available()const noexcept {
+			return m_minTempStorageSize - m_curStorElementsAllocated;
+		}
+
 		// math internal mem storage preinitialization,
 		// should be called before any code will call _istor_alloc().
 		// n - total maximum data length (in real_t), that can simultaneuisly used by _istor_alloc().
@@ -229,22 +241,46 @@ namespace math {
 		//real math initialization, used to allocate necessary temporary storage of size max(preinit::n)
 		// #note that init() as well as preinit() MUST allow subsequent calls without doing deinit() first.
 		bool init()noexcept {
-			if (conform_sign(m_threadTempRawStorage.size()) < m_minTempStorageSize) {
-				//TODO: memory allocation exception handling here!
-				m_threadTempRawStorage.resize(m_minTempStorageSize);
-			}
 			NNTL_ASSERT(m_curStorElementsAllocated == 0 || !"WTF?! Internal storage MUST NOT be in use at this moment!");
 			m_curStorElementsAllocated = 0;
+			if (conform_sign(m_threadTempRawStorage.size()) < m_minTempStorageSize) {
+				if (!m_threadTempRawStorage.resize(static_cast<size_t>(m_minTempStorageSize))) return false;
+				get_self().first_touch(m_threadTempRawStorage.data(), m_threadTempRawStorage.byte_size());
+			}
 			return true;
 		}
 		void deinit()noexcept {
 			NNTL_ASSERT(m_curStorElementsAllocated == 0 || !"WTF?! Internal storage MUST NOT be in use at this moment!");
 			m_threadTempRawStorage.clear();
-			m_threadTempRawStorage.shrink_to_fit();
 			m_minTempStorageSize = 0;
 			m_curStorElementsAllocated = 0;
 		}
 
+		//zeroes the memory from worker threads page by page, splitting it the same way elementwise operations split
+		// data. Memory obtained from the OS (see utils::huge_page_allocator) gets physical pages on the first write,
+		// so with the default first-touch NUMA policy every page lands on the node of the thread that will work with it.
+		void first_touch(void*const ptr, const size_t bytes)noexcept {
+			if (!ptr || !bytes) return;
+			static constexpr size_t pageSize = utils::huge_page_allocator::sSmallPage;
+			const auto pagesCnt = static_cast<numel_cnt_t>((bytes + pageSize - 1) / pageSize);
+			const auto pB = static_cast<char*>(ptr);
+			if (pagesCnt < 2 * static_cast<numel_cnt_t>(m_threads.cur_workers_count())) {
+				::std::memset(pB, 0, bytes);
+				return;
+			}
+			m_threads.run([pB, bytes](const par_range_t& pr) noexcept {
+				const auto ofs = static_cast<size_t>(pr.offset())*pageSize;
+				const auto e = ::std::min(bytes, ofs + static_cast<size_t>(pr.cnt())*pageSize);
+				::std::memset(pB + ofs, 0, e - ofs);
+			}, pagesCnt);
+		}
+		//the same for a freshly allocated matrix that owns its storage. Biases (if emulated) are restored afterwards.
+		void first_touch(realmtx_t& m)noexcept {
+			if (m.empty() || !m.bOwnStorage()) return;
+			get_self().first_touch(m.data(), static_cast<size_t>(m.byte_size()));
+			if (m.emulatesBiases()) m.set_biases();
+		}
+
 		//////////////////////////////////////////////////////////////////////////
 		//////////////////////////////////////////////////////////////////////////
 		// Math Methods
@@ -447,8 +483,8 @@ namespace math {
 			NNTL_ASSERT(er.elmEnd <= A.numel_triangl());
 
 			vec_len_t ri, ci, endRi, endCi;
-			A.triangl_coords_from_idx<bLowerTriangl>(er.elmBegin, ri, ci);
-			A.triangl_coords_from_idx<bLowerTriangl>(er.elmEnd, endRi, endCi);
+			A.template triangl_coords_from_idx<bLowerTriangl>(er.elmBegin, ri, ci);
+			A.template triangl_coords_from_idx<bLowerTriangl>(er.elmEnd, endRi, endCi);
 			NNTL_ASSERT(ci < endCi || (ci == endCi && ri < endRi));
 
 			const auto n = A.rows();
@@ -730,7 +766,7 @@ namespace math {
 					//static call-style mrwOperationT::op() vs. object call-style F.op() doesn't make any difference in asm 
 					// code (at the moment of testing), but object call-style permits far more generic algorithms creation
 					//::std::forward<mrwOperationT>(F).op<mrw_cw>(*pElm, *pV, r, c, rm);
-					F.op<mrw_cw>(*pElm, *pV, r, c, ldA);
+					F.template op<mrw_cw>(*pElm, *pV, r, c, ldA);
 				}
 				pA += ldA;
 				//::std::forward<mrwOperationT>(F).cw_toNextCol(rm);
@@ -756,11 +792,11 @@ namespace math {
 				auto v = F.rw_initVecElm(*pV, pElm, rm, RCR.colBegin, r);
 				for (numel_cnt_t c = RCR.colBegin + mrwOperationT::rw_FirstColumnIdx; c < ce; ++c) {
 					//::std::forward<mrwOperationT>(F).op<mrw_rw>(*pElm, v, r, c, rm);
-					F.op<mrw_rw>(*pElm, v, r, c, rm);
+					F.template op<mrw_rw>(*pElm, v, r, c, rm);
 					pElm += rm;
 				}
 				//::std::forward<mrwOperationT>(F).rw_updVecElm<VecValueT>(*pV, v, r);
-				F.rw_updVecElm<VecValueT>(*pV, v, r);
+				F.template rw_updVecElm<VecValueT>(*pV, v, r);
 			}
 		}
 
@@ -1810,20 +1846,20 @@ namespace math {
 		// pVec must address at least A.cols() elements
 		template<bool bNumStab, typename _T>
 		void mcwMean(const smatrix<_T>& A, _T*const pVec)noexcept{
-			if (A.numel() < Thresholds_t::mcwMean<bNumStab>::v) {
-				get_self().mcwMean_st<bNumStab>(A, pVec);
-			} else get_self().mcwMean_mt<bNumStab>(A, pVec);
+			if (A.numel() < Thresholds_t::template mcwMean<bNumStab>::v) {
+				get_self().template mcwMean_st<bNumStab>(A, pVec);
+			} else get_self().template mcwMean_mt<bNumStab>(A, pVec);
 		}
 
 		template<bool bNumStab, typename _T>
 		void mcwMean_st(const smatrix<_T>& A, _T*const pVec, const rowcol_range*const pRCR = nullptr)noexcept {
-			get_self()._imcwMean_st<bNumStab>(A, pVec, pRCR ? *pRCR : rowcol_range(A));
+			get_self().template _imcwMean_st<bNumStab>(A, pVec, pRCR ? *pRCR : rowcol_range(A));
 		}
 
 		template<bool bNumStab, typename _T>
 		void mcwMean_mt(const smatrix<_T>& A, _T*const pVec)noexcept {
 			_processMtx_cw(A, [&A, &pVec, this](const rowcol_range& rcr) noexcept {
-				get_self()._imcwMean_st<bNumStab>(A, pVec, rcr);
+				get_self().template _imcwMean_st<bNumStab>(A, pVec, rcr);
 			});
 		}
 
@@ -2239,7 +2275,7 @@ namespace math {
 
 			auto pD = dest.colDataAsVec(firstCol);
 			//const auto pDE = pD + static_cast<numel_cnt_t>(dest.rows())*(lastCol - firstCol);
-			const auto pDE = pD + __emulu(dest.rows(), lastCol - firstCol);
+			const auto pDE = pD + static_cast<numel_cnt_t>(dest.rows())*(lastCol - firstCol);
 
 			auto pSFirst = src.colDataAsVec(firstCol);
 			auto pS = pSFirst;
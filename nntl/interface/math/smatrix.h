@@ -32,6 +32,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include <utility>
+#include <vector>
 //#include <intrin.h>
 
 #include "../../_defs.h"
@@ -249,6 +250,9 @@ namespace math {
 		typedef T_ value_type;
 		typedef value_type*__restrict value_ptr_t;
 		typedef const value_type*__restrict cvalue_ptr_t;
+
+		//see NNTL_CFG_ALLOCATOR
+		typedef NNTL_CFG_ALLOCATOR allocator_t;
 		
 		//////////////////////////////////////////////////////////////////////////
 		//members
@@ -300,12 +304,12 @@ namespace math {
 				abort();
 			} else {
 				//delete[] m_pData;
-				_aligned_free(m_pData);
+				allocator_t::deallocate(m_pData);
 				if (m_rows > 0 && m_cols > 0) {
 					//m_pData = new(::std::nothrow) value_type[numel()];
 					//#todo for C++17 must change to ::std::launder(reinterpret_cast< ... 
 					//#TODO: NNTL_CFG_DEFAULT_FP_PTR_ALIGN is too strict for non-floating point data
-					m_pData = reinterpret_cast<value_type*__restrict>(_aligned_malloc(byte_size(), utils::mem_align_for<value_type>()));
+					m_pData = reinterpret_cast<value_type*__restrict>(allocator_t::allocate(byte_size(), utils::mem_align_for<value_type>()));
 					NNTL_ASSERT(m_pData);
 				} else {
 					m_rows = 0;
@@ -317,7 +321,7 @@ namespace math {
 		void _free()noexcept {
 			if (!m_bDontManageStorage) {
 				//delete[] m_pData;
-				_aligned_free(m_pData);
+				allocator_t::deallocate(m_pData);
 			}
 			m_pData = nullptr;
 			m_rows = 0;
@@ -871,8 +875,7 @@ namespace math {
 		// triangular matrix support
 		//returns the number of elements in a triangular matrix of size N. (Elements of the main diagonal are excluded)
 		static constexpr numel_cnt_t sNumelTriangl(const vec_len_t n)noexcept {
-			//return (static_cast<numel_cnt_t>(n)*(n-1)) / 2;
-			return __emulu(n, n - 1) / 2;
+			return (static_cast<numel_cnt_t>(n)*(n - 1)) / 2;
 		}
 		numel_cnt_t numel_triangl()const noexcept {
 			NNTL_ASSERT(rows() == cols());
@@ -1369,7 +1372,7 @@ namespace math {
 
 		//////////////////////////////////////////////////////////////////////////
 		// #supportsBatchInRow
-		smatrix_deform(smatrix&& src)noexcept : _base_class(::std::move(src)) {
+		smatrix_deform(_base_class&& src)noexcept : _base_class(::std::move(src)) {
 #ifdef NNTL_DEBUG
 			m_maxSize = numel();
 #endif // NNTL_DEBUG
@@ -1385,7 +1388,7 @@ namespace math {
 		smatrix_deform& operator=(const smatrix_deform& rhs) noexcept; // = delete; //-it should be `delete`d, but factory function won't work if it is
 
 		// #supportsBatchInRow
-		smatrix_deform& operator=(smatrix&& rhs) noexcept {
+		smatrix_deform& operator=(_base_class&& rhs) noexcept {
 			if (this != &rhs) {
 				_base_class::operator =(::std::move(rhs));
 #ifdef NNTL_DEBUG
@@ -1423,7 +1426,7 @@ namespace math {
 		}
 
 		// #supportsBatchInRow
-		bool cloneFrom(const smatrix& src)noexcept {
+		bool cloneFrom(const _base_class& src)noexcept {
 			_free();
 			const auto r = src.clone_to(*this);
 #ifdef NNTL_DEBUG
@@ -1440,8 +1443,9 @@ namespace math {
 		}
 
 		// #supportsBatchInRow
+		//resizing to the current size keeps the storage (no reallocation), the same way smatrix::resize() does
 		bool resize(const vec_len_t _rows, vec_len_t _cols)noexcept {
-			_free();
+			if (m_bDontManageStorage) _free();
 			const auto r = _base_class::resize(_rows, _cols);
 #ifdef NNTL_DEBUG
 			if (r) m_maxSize = numel();
@@ -1451,7 +1455,7 @@ namespace math {
 
 		// #supportsBatchInRow
 		bool resize_as_dataset(vec_len_t batchSiz, vec_len_t sampleWidt) noexcept {
-			_free();
+			if (m_bDontManageStorage) _free();
 			const auto r = _base_class::resize_as_dataset(batchSiz, sampleWidt);
 		#ifdef NNTL_DEBUG
 			if (r) m_maxSize = numel();
@@ -1460,8 +1464,8 @@ namespace math {
 		}
 
 		// #supportsBatchInRow
-		bool resize(const smatrix& m)noexcept {
-			_free();
+		bool resize(const _base_class& m)noexcept {
+			if (m_bDontManageStorage) _free();
 			const auto r = _base_class::resize(m);
 #ifdef NNTL_DEBUG
 			if (r) m_maxSize = numel();
@@ -1484,7 +1488,7 @@ namespace math {
 			_free();
 			//auto ptr = new(::std::nothrow) value_type[ne];
 			//#todo for C++17 must change to ::std::launder(reinterpret_cast< ... 
-			value_type* ptr = reinterpret_cast<value_type*>(_aligned_malloc(sizeof(value_type)*ne, utils::mem_align_for<value_type>()));
+			value_type* ptr = reinterpret_cast<value_type*>(allocator_t::allocate(sizeof(value_type)*ne, utils::mem_align_for<value_type>()));
 			if (nullptr == ptr) {
 				NNTL_ASSERT(!"Memory allocation failed!");
 				return false;
@@ -1505,7 +1509,7 @@ namespace math {
 #endif // NNTL_DEBUG
 		}
 		// #supportsBatchInRow
-		inline void useExternalStorage(value_ptr_t ptr, const smatrix& propsLikeThis, bool bHBiases = false)noexcept {
+		inline void useExternalStorage(value_ptr_t ptr, const _base_class& propsLikeThis, bool bHBiases = false)noexcept {
 			useExternalStorage(ptr, propsLikeThis.rows(), propsLikeThis.cols(), propsLikeThis.emulatesBiases()
 				, bHBiases, propsLikeThis.bBatchInRow());
 		}
@@ -1543,7 +1547,7 @@ namespace math {
 #endif // NNTL_DEBUG
 		}
 		// #supportsBatchInRow
-		inline void useExternalStorage(smatrix& src)noexcept {
+		inline void useExternalStorage(_base_class& src)noexcept {
 			_base_class::useExternalStorage(src);
 #ifdef NNTL_DEBUG
 			m_maxSize = numel();
@@ -1551,7 +1555,7 @@ namespace math {
 		}
 
 		// DOES NOT SUPPORT non-default m_bBatchInRow when emulatesBiases()
-		inline void useExternalStorage_no_bias(smatrix& src)noexcept {
+		inline void useExternalStorage_no_bias(_base_class& src)noexcept {
 			_base_class::useExternalStorage_no_bias(src);
 #ifdef NNTL_DEBUG
 			m_maxSize = numel();
@@ -0,0 +1,147 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <vector>
+#include "smatrix.h"
+
+// smatrix_csr is a minimal compressed sparse row matrix that is used to store pruned weights (see
+// layer/fully_connected_pruned.h). It never owns the sparsity pattern on its own - the pattern is made from a dense mask
+// matrix (nonzero elements of the mask define the structure) and the values are gathered from a dense matrix of the same
+// shape. That allows to keep the structure intact while the values are updated by the optimizer.
+//
+// When made with bTransposed==true, the object stores the transposed dense matrix (i.e. its rows correspond to the
+// columns of the dense matrix), that's the layout of a compressed sparse column matrix.
+
+namespace nntl {
+namespace math {
+
+	template <typename T_>
+	class smatrix_csr : public smatrix_td {
+	public:
+		typedef T_ value_type;
+		typedef smatrix<value_type> dense_t;
+
+	protected:
+		//m_rowPtr[i]..m_rowPtr[i+1]-1 are the indexes of the i-th row elements in m_colIdx and m_vals
+		::std::vector<numel_cnt_t> m_rowPtr;
+		::std::vector<vec_len_t> m_colIdx;
+		::std::vector<value_type> m_vals;
+		vec_len_t m_rows{ 0 }, m_cols{ 0 };
+		bool m_bTransposed{ false };
+
+	public:
+		~smatrix_csr()noexcept {}
+		smatrix_csr()noexcept {}
+
+		vec_len_t rows()const noexcept { return m_rows; }
+		vec_len_t cols()const noexcept { return m_cols; }
+		numel_cnt_t nnz()const noexcept { return static_cast<numel_cnt_t>(m_vals.size()); }
+		bool empty()const noexcept { return m_rowPtr.empty(); }
+		bool bTransposed()const noexcept { return m_bTransposed; }
+
+		const numel_cnt_t* rowPtr()const noexcept { return m_rowPtr.data(); }
+		const vec_len_t* colIdx()const noexcept { return m_colIdx.data(); }
+		const value_type* vals()const noexcept { return m_vals.data(); }
+
+		void clear()noexcept {
+			m_rowPtr.clear(); m_rowPtr.shrink_to_fit();
+			m_colIdx.clear(); m_colIdx.shrink_to_fit();
+			m_vals.clear(); m_vals.shrink_to_fit();
+			m_rows = m_cols = 0;
+			m_bTransposed = false;
+		}
+
+		//makes the structure from the first denseCols columns of the mask and fills values from W (same shape as the mask)
+		bool make_from(const dense_t& W, const dense_t& mask, const vec_len_t denseCols, const bool bTransposed)noexcept {
+			NNTL_ASSERT(!W.empty() && !W.emulatesBiases() && W.size() == mask.size() && W.bBatchInColumn() && mask.bBatchInColumn());
+			NNTL_ASSERT(denseCols > 0 && denseCols <= W.cols());
+			clear();
+
+			const vec_len_t dr = W.rows();
+			m_bTransposed = bTransposed;
+			m_rows = bTransposed ? denseCols : dr;
+			m_cols = bTransposed ? dr : denseCols;
+
+			numel_cnt_t nz = 0;
+			const auto pM = mask.data();
+			const numel_cnt_t dne = sNumel(dr, denseCols);
+			for (numel_cnt_t i = 0; i < dne; ++i) nz += (pM[i] != value_type(0));
+
+			try {
+				m_rowPtr.resize(static_cast<size_t>(m_rows) + 1);
+				m_colIdx.resize(static_cast<size_t>(nz));
+				m_vals.resize(static_cast<size_t>(nz));
+			} catch (const ::std::exception&) {
+				clear();
+				return false;
+			}
+
+			numel_cnt_t k = 0;
+			for (vec_len_t r = 0; r < m_rows; ++r) {
+				m_rowPtr[r] = k;
+				for (vec_len_t c = 0; c < m_cols; ++c) {
+					if (pM[bTransposed ? dr*numel_cnt_t(r) + c : dr*numel_cnt_t(c) + r] != value_type(0)) {
+						m_colIdx[static_cast<size_t>(k++)] = c;
+					}
+				}
+			}
+			m_rowPtr[m_rows] = k;
+			NNTL_ASSERT(k == nz);
+
+			update_values(W);
+			return true;
+		}
+
+		//gathers values of the structural nonzeros from W (it must have the same shape as during make_from())
+		void update_values(const dense_t& W)noexcept {
+			NNTL_ASSERT(!empty() && W.rows() == (m_bTransposed ? m_cols : m_rows));
+			const numel_cnt_t dr = W.rows();
+			const auto pW = W.data();
+			const auto pRP = m_rowPtr.data();
+			const auto pCI = m_colIdx.data();
+			const auto pV = m_vals.data();
+			for (vec_len_t r = 0; r < m_rows; ++r) {
+				const auto kEnd = pRP[r + 1];
+				if (m_bTransposed) {
+					const auto pWc = pW + dr*r;
+					for (auto k = pRP[r]; k < kEnd; ++k) pV[k] = pWc[pCI[k]];
+				} else {
+					const auto pWr = pW + r;
+					for (auto k = pRP[r]; k < kEnd; ++k) pV[k] = pWr[dr*pCI[k]];
+				}
+			}
+		}
+	};
+
+}
+}
@@ -449,10 +449,10 @@ namespace rng {
 	{
 		typedef _AFRand_mt<FCT, RealT, AgnerFogRNG, iThreadsT> _base_class_t;
 	public:
-		using _base_class_t::real_t;
-		using _base_class_t::base_rng_t;
-		using _base_class_t::Thresholds_t;
-		using _base_class_t::rng_vector_t;
+		using typename _base_class_t::real_t;
+		using typename _base_class_t::base_rng_t;
+		using typename _base_class_t::Thresholds_t;
+		using typename _base_class_t::rng_vector_t;
 
 		typedef as::AsynchRng<RealT, AgnerFogRNG> asynch_rng_t;
 		typedef _base_class_t mt_rng_t;
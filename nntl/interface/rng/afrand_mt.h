@@ -38,7 +38,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../_i_rng.h"
 #include "../_i_threads.h"
 
-#include "AFRAND_MT_THR.h"
+#include "afrand_mt_thr.h"
 
 namespace nntl {
 	namespace rng {
@@ -355,6 +355,7 @@ namespace threads {
 				::std::unique_lock<MutexT> lk(l);
 				cv.wait(lk, ::std::forward<Predicate>(p));
 			}
+		#if NNTL_HAS_NATIVE_SRWLOCKS_AND_CODITIONALS
 			//::std::unique_lock could be used with win_srwlock, however special handling works faster
 			template<typename Predicate>
 			static void lock_wait_unlock(win_srwlock& l, win_condition_var& cv, Predicate&& p)noexcept
@@ -363,6 +364,7 @@ namespace threads {
 				cv.wait(l, ::std::forward<Predicate>(p));
 				l.unlock();
 			}
+		#endif
 
 			//////////////////////////////////////////////////////////////////////////
 
@@ -32,6 +32,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include "../_i_bgworkers.h"
+#include "telemetry.h"
 #include <vector>
 #include <algorithm>
 
@@ -140,6 +141,13 @@ namespace threads {
 		::std::vector<char> m_threadHasSmth2Exec;
 		func_exec_t m_execFn;
 
+	#if NNTL_CFG_THREADS_TELEMETRY
+		//the main thread doesn't execute anything, so worker tId uses slot tId
+		telemetry m_telemetry;
+	public:
+		telemetry& get_telemetry()noexcept { return m_telemetry; }
+	#endif
+
 
 	private:
 		void _ctor(const thread_id_t nThreads, const PriorityClass pc)noexcept {
@@ -182,13 +190,13 @@ namespace threads {
 
 		BgWorkers(const thread_id_t nThreads
 			, const PriorityClass pc = PriorityClass::threads_priority_below_current)noexcept 
+			NNTL_THREADS_TELEMETRY_DO(: m_telemetry(nThreads, false))
 		{
 			_ctor(nThreads, pc);
 		}
 		BgWorkers(const PriorityClass pc = PriorityClass::threads_priority_below_current)noexcept
-		{
-			_ctor(::std::thread::hardware_concurrency() - 1, pc);
-		}
+			: BgWorkers(::std::thread::hardware_concurrency() - 1, pc)
+		{}
 
 		thread_id_t workers_count()noexcept {
 			return static_cast<thread_id_t>(m_threads.size());
@@ -227,7 +235,7 @@ namespace threads {
 		//in general, func must have a duration greater than duration of the task
 		template<typename FTask>
 		self_t& add_task(FTask&& func, int priority = 0) noexcept {
-			typedef decltype(CallH_t::wrap<FTask>(::std::forward<FTask>(func))) stored_f_t;
+			typedef decltype(CallH_t::template wrap<FTask>(::std::forward<FTask>(func))) stored_f_t;
 			
 			//S<decltype(CallH_t::wrap<FTask>(func))>();
 			//S<decltype(CallH_t::wrap<FTask>(::std::forward<FTask>(func)))>();
@@ -240,7 +248,7 @@ namespace threads {
 				);
 
 			disperse_locker_t d(m_mutexTasks, m_bGo2Waiting);
-			m_tasks.emplace_back(CallH_t::wrap<FTask>(::std::forward<FTask>(func)), priority);
+			m_tasks.emplace_back(CallH_t::template wrap<FTask>(::std::forward<FTask>(func)), priority);
 			::std::sort(m_tasks.begin(), m_tasks.end(), _impl::TaskDescrComp_t());
 			return *this;
 		}
@@ -254,17 +262,20 @@ namespace threads {
 		//never call recursively or from non-main thread
 		template<typename FExec>
 		self_t& exec(FExec&& func) noexcept {
+			NNTL_THREADS_TELEMETRY_DO(m_telemetry.job_begin<FExec>(0));
 			m_bGo2Waiting = true;
 			m_mutexTasks.lock();
 
-			m_execFn = CallH_t::wrap<FExec>(::std::forward<FExec>(func));
+			m_execFn = CallH_t::template wrap<FExec>(::std::forward<FExec>(func));
 			for (auto& e : m_threadHasSmth2Exec) e = char(true);
 			m_workingCnt = m_threadHasSmth2Exec.size();
 
 			m_bGo2Waiting = false;
 			m_mutexTasks.unlock();
+			NNTL_THREADS_TELEMETRY_DO(m_telemetry.job_dispatched());
 
 			Sync_t::lock_wait_unlock(m_mutexTasks, m_orderDone, [&wc = m_workingCnt]() {return wc <= 0; });
+			NNTL_THREADS_TELEMETRY_DO(m_telemetry.job_end(static_cast<thread_id_t>(m_threadHasSmth2Exec.size())));
 
 			m_execFn.reset();//shouldn't harm when done here while outside of mutex
 			return *this;
@@ -276,7 +287,9 @@ namespace threads {
 			const auto b = threads::Funcs::AllowCurrentThreadPriorityBoost(false);
 			NNTL_ASSERT(b);
 			global_denormalized_floats_mode();
+			NNTL_THREADS_TELEMETRY_DO(p->m_telemetry.thread_attach(tId));
 			p->_worker(tId);
+			NNTL_THREADS_TELEMETRY_DO(p->m_telemetry.thread_detach(tId));
 		}
 
 		void _worker(const thread_id_t id)noexcept {
@@ -289,6 +302,7 @@ namespace threads {
 			while (true) {
 				::std::atomic_thread_fence(::std::memory_order_acquire);//for m_taskWaitTO usage before mutex acquisition.
 				const auto sleepUntil = ::std::chrono::steady_clock::now() + m_taskWaitTO;
+				NNTL_THREADS_TELEMETRY_DO(const auto telWaitBegin = telemetry::now());
 				Sync_t::lockShared_waitFor_unlock(m_mutexTasks, m_waitingOrders, m_taskWaitTO
 					, [&bStop = m_bStop, &bGo2Waiting = m_bGo2Waiting
 					, &tasks = m_tasks, &utime = sleepUntil, &h2e = bHas2Exec]()noexcept
@@ -296,9 +310,12 @@ namespace threads {
 					return bStop || (::std::chrono::steady_clock::now() > utime && !bGo2Waiting && tasks.size() > 0) || h2e;
 				});
 				if (m_bStop) break;
+				NNTL_THREADS_TELEMETRY_DO(m_telemetry.bg_idle(id, telemetry::now() - telWaitBegin));
 
 				if (bHas2Exec) {
+					NNTL_THREADS_TELEMETRY_DO(m_telemetry.thread_begin(id));
 					m_execFn(id);
+					NNTL_THREADS_TELEMETRY_DO(m_telemetry.thread_end(id));
 
 					m_mutexTasks.lock_shared();
 					
@@ -308,6 +325,7 @@ namespace threads {
 
 					m_mutexTasks.unlock_shared();
 				} else {
+					NNTL_THREADS_TELEMETRY_DO(const auto telBusyBegin = telemetry::now());
 					m_mutexTasks.lock_shared();
 
 					auto itCur = m_tasks.cbegin();
@@ -318,6 +336,7 @@ namespace threads {
 					}
 
 					m_mutexTasks.unlock_shared();
+					NNTL_THREADS_TELEMETRY_DO(m_telemetry.bg_tasks(id, telemetry::now() - telBusyBegin));
 				}
 			}
 		}
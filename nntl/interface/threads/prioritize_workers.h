@@ -258,7 +258,7 @@ namespace threads {
 		}
 	};
 
-#pragma message( __FILE__ "[" STRING(__LINE__) "]: *** prioritize_workers was not implemented for current OS, using dummy class")
+#pragma message("*** prioritize_workers was not implemented for current OS, using dummy class")
 
 #endif
 
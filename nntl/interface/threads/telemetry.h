@@ -0,0 +1,404 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//per-thread busy/idle and load imbalance telemetry of threads::Workers and threads::BgWorkers.
+// Compiled in only when NNTL_CFG_THREADS_TELEMETRY is set (see math.h), otherwise only empty macros are defined here
+// and thread pools contain no telemetry code or data at all.
+//
+// A job is a single Workers::run()/reduce() call or BgWorkers::exec() call. For every job the telemetry records:
+// - dispatch latency: time from the job request to the moment a worker thread starts executing its part;
+// - execution time of every participating thread and its idle time within the job (job duration minus own execution);
+// - wait time of the requesting thread: time it spends waiting for the workers after it has finished its own part
+//		of the job (Workers) or after it has dispatched the job (BgWorkers);
+// - load imbalance ratio max(exec)/mean(exec) over the participating threads (1 is perfect balance) and the thread
+//		that was the slowest.
+// Jobs are aggregated per call site tag. The tag is set with NNTL_THREADS_TAG("name") scoped object in the thread that
+// makes the request. When there's no tag, the name of the functor type is used (typeid().name()), which for lambdas
+// contains the name of the enclosing function, i.e. the name of the iMath kernel (mangled with gcc/clang).
+// Background tasks of BgWorkers are accounted per thread as busy (executing tasks) and idle (waiting) time.
+//
+// When NNTL_CFG_THREADS_TELEMETRY_PERF is also set, on Linux every thread opens perf_event_open() counters of CPU cycles
+// and last level cache read misses of itself and they are accumulated per tag and thread. If the counters couldn't be
+// opened (see /proc/sys/kernel/perf_event_paranoid) they just read zeros, perf_available() tells that.
+//
+// The telemetry never allocates after construction. Stats must be read and reset from the thread that makes requests
+// to the pool, while the pool is idle.
+
+#if NNTL_CFG_THREADS_TELEMETRY
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <typeinfo>
+
+#include "../../utils/call_site_tag.h"
+
+#if NNTL_CFG_THREADS_TELEMETRY_PERF && defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define NNTL_THREADS_TELEMETRY_HAS_PERF 1
+#else
+#define NNTL_THREADS_TELEMETRY_HAS_PERF 0
+#endif
+
+namespace nntl {
+namespace threads {
+
+	class telemetry {
+		telemetry(const telemetry& other) = delete;
+		telemetry(telemetry&& other) = delete;
+		telemetry& operator=(const telemetry& rhs) = delete;
+
+	public:
+		typedef ::std::chrono::steady_clock clock_t;
+		typedef ::std::uint64_t counter_t;
+
+		//jobs with tags that don't fit into the table are accounted under tags_table_t::szOtherTags
+		typedef utils::call_site_tags_table<64> tags_table_t;
+		typedef utils::call_site_tag<telemetry> call_site_tag_t;
+		typedef call_site_tag_t::scoped scoped_tag;
+
+		struct tag_stats {
+			const char* szTag;
+			counter_t jobs;
+			counter_t elements;//total count of elements (range_t cnt) processed
+			counter_t wallNs;//total duration of jobs as seen by the requesting thread
+			counter_t dispatchNs, dispatchMaxNs;//sum over all jobs and workers and the max
+			counter_t dispatchCnt;//count of dispatch latency samples
+			counter_t waitNs;//total wait time of the requesting thread
+			double imbalanceSum, imbalanceMax;
+
+			double dispatch_mean_ns()const noexcept { return dispatchCnt ? double(dispatchNs) / dispatchCnt : 0.; }
+			double imbalance_mean()const noexcept { return jobs ? imbalanceSum / jobs : 1.; }
+			double wall_mean_ns()const noexcept { return jobs ? double(wallNs) / jobs : 0.; }
+			double wait_mean_ns()const noexcept { return jobs ? double(waitNs) / jobs : 0.; }
+		};
+
+		//stats of a single thread within a tag. Thread index is the same as par_range_t::tid() for Workers
+		// (0 is the requesting thread) and the worker id for BgWorkers
+		struct thread_stats {
+			counter_t jobs;//count of jobs the thread participated in
+			counter_t execNs, idleNs;
+			counter_t slowestCnt;//how many times the thread was the last to finish
+			counter_t cycles, llcMisses;
+		};
+
+		struct bg_tasks_stats {
+			counter_t busyNs, idleNs;
+			counter_t sweeps;//how many times the thread has woken up to run background tasks
+		};
+
+	protected:
+		struct _thread_slot_data {
+			//timestamps and perf counters of the current job. Written by the owning thread only and read by the
+			// requesting thread after the job is done (the pool's mutex provides the ordering)
+			::std::int64_t tStart, tEnd;
+			counter_t cycStart, cycEnd, llcStart, llcEnd;
+			int fdCycles, fdLlc;
+			::std::atomic<counter_t> bgBusyNs, bgIdleNs, bgSweeps;
+		};
+		//padded to prevent false sharing between threads
+		struct _thread_slot : public _thread_slot_data {
+			char _pad[(sizeof(_thread_slot_data) / 64 + 2) * 64 - sizeof(_thread_slot_data)];
+		};
+
+	protected:
+		const thread_id_t m_threadsCnt;
+		//the requesting thread executes a part of a job itself in slot 0 (Workers)
+		const bool m_bRequesterWorks;
+
+		::std::vector<_thread_slot> m_slots;
+		::std::vector<thread_stats> m_thrStats;//tags_table_t::sSlots x m_threadsCnt
+		tags_table_t m_tags;
+		tag_stats m_tagStats[tags_table_t::sSlots];
+
+		const char* m_szJobTag;
+		counter_t m_jobElements;
+		::std::int64_t m_tJobBegin, m_tDispatched;
+
+	protected:
+		static counter_t _ns(const ::std::int64_t d)noexcept { return d > 0 ? static_cast<counter_t>(d) : 0; }
+
+	#if NNTL_THREADS_TELEMETRY_HAS_PERF
+		static int _perf_open(const ::std::uint32_t type, const ::std::uint64_t config)noexcept {
+			perf_event_attr pe;
+			::std::memset(&pe, 0, sizeof(pe));
+			pe.type = type;
+			pe.size = sizeof(pe);
+			pe.config = config;
+			pe.exclude_kernel = 1;
+			pe.exclude_hv = 1;
+			//pid==0 && cpu==-1 means the calling thread on any cpu
+			return static_cast<int>(::syscall(__NR_perf_event_open, &pe, 0, -1, -1, 0));
+		}
+		static counter_t _perf_read(const int fd)noexcept {
+			counter_t v = 0;
+			if (fd >= 0 && sizeof(v) != ::read(fd, &v, sizeof(v))) v = 0;
+			return v;
+		}
+	#endif
+
+	public:
+		~telemetry()noexcept {}
+
+		telemetry(const thread_id_t threadsCnt, const bool bRequesterWorks)noexcept
+			: m_threadsCnt(threadsCnt), m_bRequesterWorks(bRequesterWorks), m_slots(threadsCnt)
+			, m_thrStats(tags_table_t::sSlots*threadsCnt)
+		{
+			NNTL_ASSERT(threadsCnt > 0);
+			for (auto& s : m_slots) {
+				s.fdCycles = s.fdLlc = -1;
+			}
+			reset();
+		}
+
+		thread_id_t threads_count()const noexcept { return m_threadsCnt; }
+
+		//timestamp in nanoseconds
+		static ::std::int64_t now()noexcept {
+			return ::std::chrono::duration_cast<::std::chrono::nanoseconds>(clock_t::now().time_since_epoch()).count();
+		}
+
+		//must be called only while the pool is idle
+		void reset()noexcept {
+			m_tags.reset();
+			::std::memset(m_tagStats, 0, sizeof(m_tagStats));
+			::std::memset(&m_thrStats[0], 0, sizeof(thread_stats)*m_thrStats.size());
+			for (auto& s : m_slots) {
+				s.tStart = s.tEnd = 0;
+				s.cycStart = s.cycEnd = s.llcStart = s.llcEnd = 0;
+				s.bgBusyNs.store(0, ::std::memory_order_relaxed);
+				s.bgIdleNs.store(0, ::std::memory_order_relaxed);
+				s.bgSweeps.store(0, ::std::memory_order_release);
+			}
+			m_szJobTag = tags_table_t::szOtherTags;
+			m_jobElements = 0;
+			m_tJobBegin = m_tDispatched = 0;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		//thread lifetime. Must be called by the thread that will be using the slot tId
+		void thread_attach(const thread_id_t tId)noexcept {
+			NNTL_ASSERT(tId < m_threadsCnt);
+		#if NNTL_THREADS_TELEMETRY_HAS_PERF
+			auto& s = m_slots[tId];
+			s.fdCycles = _perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+			s.fdLlc = _perf_open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL
+				| (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+		#else
+			NNTL_UNREF(tId);
+		#endif
+		}
+		void thread_detach(const thread_id_t tId)noexcept {
+			NNTL_ASSERT(tId < m_threadsCnt);
+		#if NNTL_THREADS_TELEMETRY_HAS_PERF
+			auto& s = m_slots[tId];
+			if (s.fdCycles >= 0) ::close(s.fdCycles);
+			if (s.fdLlc >= 0) ::close(s.fdLlc);
+			s.fdCycles = s.fdLlc = -1;
+		#else
+			NNTL_UNREF(tId);
+		#endif
+		}
+		bool perf_available()const noexcept {
+			for (const auto& s : m_slots) {
+				if (s.fdCycles >= 0) return true;
+			}
+			return false;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		//job lifetime. job_*() functions are called by the requesting thread, thread_*() by the executing thread
+		template<typename FuncT>
+		void job_begin(const counter_t elements)noexcept {
+			m_tJobBegin = now();
+			const char* szTag = call_site_tag_t::current();
+			m_szJobTag = szTag ? szTag : typeid(FuncT).name();
+			m_jobElements = elements;
+		}
+		void job_dispatched()noexcept { m_tDispatched = now(); }
+
+		void thread_begin(const thread_id_t tId)noexcept {
+			NNTL_ASSERT(tId < m_threadsCnt);
+			auto& s = m_slots[tId];
+		#if NNTL_THREADS_TELEMETRY_HAS_PERF
+			s.cycStart = _perf_read(s.fdCycles);
+			s.llcStart = _perf_read(s.fdLlc);
+		#endif
+			s.tStart = now();
+		}
+		void thread_end(const thread_id_t tId)noexcept {
+			NNTL_ASSERT(tId < m_threadsCnt);
+			auto& s = m_slots[tId];
+			s.tEnd = now();
+		#if NNTL_THREADS_TELEMETRY_HAS_PERF
+			s.cycEnd = _perf_read(s.fdCycles);
+			s.llcEnd = _perf_read(s.fdLlc);
+		#endif
+		}
+
+		//participants are slots [0, participants), all of them must have done thread_begin()/thread_end() for the job
+		void job_end(const thread_id_t participants)noexcept {
+			NNTL_ASSERT(participants > 0 && participants <= m_threadsCnt);
+			const auto tDone = now();
+			const auto tagIdx = m_tags.find(m_szJobTag);
+			auto& st = m_tagStats[tagIdx];
+			st.szTag = m_tags.tag(tagIdx);
+			thread_stats*const pThr = &m_thrStats[tagIdx*m_threadsCnt];
+
+			++st.jobs;
+			st.elements += m_jobElements;
+			st.wallNs += _ns(tDone - m_tJobBegin);
+			st.waitNs += _ns(tDone - (m_bRequesterWorks ? m_slots[0].tEnd : m_tDispatched));
+
+			const auto jobNs = _ns(tDone - m_tJobBegin);
+			counter_t sumExec = 0, maxExec = 0;
+			thread_id_t slowest = 0;
+			::std::int64_t lastEnd = m_slots[0].tEnd;
+			for (thread_id_t i = 0; i < participants; ++i) {
+				const auto& s = m_slots[i];
+				auto& ts = pThr[i];
+				const auto e = _ns(s.tEnd - s.tStart);
+				sumExec += e;
+				maxExec = ::std::max(maxExec, e);
+				if (s.tEnd > lastEnd) {
+					lastEnd = s.tEnd;
+					slowest = i;
+				}
+
+				++ts.jobs;
+				ts.execNs += e;
+				ts.idleNs += jobNs > e ? jobNs - e : 0;
+				ts.cycles += s.cycEnd - s.cycStart;
+				ts.llcMisses += s.llcEnd - s.llcStart;
+
+				if (i > 0 || !m_bRequesterWorks) {
+					const auto d = _ns(s.tStart - m_tJobBegin);
+					st.dispatchNs += d;
+					st.dispatchMaxNs = ::std::max(st.dispatchMaxNs, d);
+					++st.dispatchCnt;
+				}
+			}
+			++pThr[slowest].slowestCnt;
+
+			const double imb = sumExec ? double(maxExec)*participants / sumExec : 1.;
+			st.imbalanceSum += imb;
+			st.imbalanceMax = ::std::max(st.imbalanceMax, imb);
+		}
+
+		//background tasks accounting of BgWorkers. Called by the worker thread
+		void bg_idle(const thread_id_t tId, const ::std::int64_t idleNs)noexcept {
+			NNTL_ASSERT(tId < m_threadsCnt);
+			m_slots[tId].bgIdleNs.fetch_add(_ns(idleNs), ::std::memory_order_relaxed);
+		}
+		void bg_tasks(const thread_id_t tId, const ::std::int64_t busyNs)noexcept {
+			NNTL_ASSERT(tId < m_threadsCnt);
+			auto& s = m_slots[tId];
+			s.bgBusyNs.fetch_add(_ns(busyNs), ::std::memory_order_relaxed);
+			s.bgSweeps.fetch_add(1, ::std::memory_order_release);
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		//calls f(const tag_stats&, const thread_stats* pThreads) for every tag with jobs. pThreads has threads_count() elements
+		template<typename F>
+		void for_each_tag(F&& f)const noexcept {
+			for (unsigned i = 0; i < tags_table_t::sSlots; ++i) {
+				if (m_tagStats[i].jobs) f(m_tagStats[i], &m_thrStats[i*m_threadsCnt]);
+			}
+		}
+
+		//returns stats for the tag or zeros if there were no jobs with it
+		tag_stats get_tag(const char* szTag)const noexcept {
+			const auto i = m_tags.lookup(szTag);
+			if (i < tags_table_t::sSlots) return m_tagStats[i];
+			tag_stats r;
+			::std::memset(&r, 0, sizeof(r));
+			r.szTag = szTag;
+			return r;
+		}
+
+		bg_tasks_stats get_bg_tasks(const thread_id_t tId)const noexcept {
+			NNTL_ASSERT(tId < m_threadsCnt);
+			const auto& s = m_slots[tId];
+			return bg_tasks_stats{ s.bgBusyNs.load(::std::memory_order_relaxed), s.bgIdleNs.load(::std::memory_order_relaxed)
+				, s.bgSweeps.load(::std::memory_order_acquire) };
+		}
+
+		void report()const noexcept {
+			const bool bPerf = perf_available();
+			STDCOUTL("Threads telemetry, " << m_threadsCnt << " threads:");
+			for_each_tag([this, bPerf](const tag_stats& ts, const thread_stats* pThr) {
+				STDCOUTL("  " << ts.szTag << ": " << ts.jobs << " jobs, " << ts.elements / ts.jobs << " elements/job, wall "
+					<< ts.wall_mean_ns() / 1000 << "us/job, dispatch " << ts.dispatch_mean_ns() / 1000 << "us (max "
+					<< double(ts.dispatchMaxNs) / 1000 << "us), wait " << ts.wait_mean_ns() / 1000 << "us/job, imbalance "
+					<< ts.imbalance_mean() << " (max " << ts.imbalanceMax << ")");
+				for (thread_id_t i = 0; i < m_threadsCnt; ++i) {
+					const auto& t = pThr[i];
+					if (!t.jobs) continue;
+					if (bPerf) {
+						STDCOUTL("    #" << i << ": " << t.jobs << " jobs, busy " << double(t.execNs) / 1000 << "us, idle "
+							<< double(t.idleNs) / 1000 << "us, slowest " << t.slowestCnt << " times, " << t.cycles
+							<< " cycles, " << t.llcMisses << " LLC misses");
+					} else {
+						STDCOUTL("    #" << i << ": " << t.jobs << " jobs, busy " << double(t.execNs) / 1000 << "us, idle "
+							<< double(t.idleNs) / 1000 << "us, slowest " << t.slowestCnt << " times");
+					}
+				}
+			});
+			for (thread_id_t i = 0; i < m_threadsCnt; ++i) {
+				const auto bt = get_bg_tasks(i);
+				if (bt.sweeps) {
+					STDCOUTL("  background tasks #" << i << ": " << bt.sweeps << " sweeps, busy " << double(bt.busyNs) / 1000
+						<< "us, idle " << double(bt.idleNs) / 1000 << "us");
+				}
+			}
+		}
+	};
+
+}
+}
+
+#define NNTL_THREADS_TAG(szTag) ::nntl::threads::telemetry::scoped_tag NNTL_CONCAT(_nntl_threads_tag_, __LINE__)(szTag)
+//wraps telemetry related statements inside thread pools
+#define NNTL_THREADS_TELEMETRY_DO(...) __VA_ARGS__
+
+#else //NNTL_CFG_THREADS_TELEMETRY
+
+#define NNTL_THREADS_TAG(szTag)
+#define NNTL_THREADS_TELEMETRY_DO(...)
+
+#endif //NNTL_CFG_THREADS_TELEMETRY
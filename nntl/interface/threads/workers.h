@@ -32,6 +32,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include "../_i_threads.h"
+#include "telemetry.h"
 
 namespace nntl {
 namespace threads {
@@ -90,6 +91,17 @@ namespace threads {
 		threads_cont_t m_threads;
 		::std::atomic<bool> m_bStop;
 
+		//total count of threads (including the main thread) to use when a caller doesn't specify useNThreads explicitly.
+		// Could be changed at any time from any thread by set_active_workers()
+		::std::atomic<thread_id_t> m_activeWorkersCnt;
+
+	#if NNTL_CFG_THREADS_TELEMETRY
+		//slot 0 is the main thread, worker i uses slot i+1 (the same as par_range_t::tid())
+		telemetry m_telemetry;
+	public:
+		telemetry& get_telemetry()noexcept { return m_telemetry; }
+	#endif
+
 	public:
 		~Workers()noexcept {
 			m_bStop = true;
@@ -99,10 +111,19 @@ namespace threads {
 			//m_mutex.unlock();
 
 			for (auto& t : m_threads)  t.join();
+			NNTL_THREADS_TELEMETRY_DO(m_telemetry.thread_detach(0));
 		}
 
-		Workers()noexcept : m_bStop(false), m_workersCnt(workers_count() - 1), m_workingCnt(0) {
-			NNTL_ASSERT(m_workersCnt > 0);
+		Workers()noexcept : Workers(workers_count()) {}
+
+		//nThreads is the total count of threads to use including the main thread. nThreads==1 is allowed and means
+		//single threaded processing (helpful when a lot of small independent models run simultaneously, see population_trainer)
+		explicit Workers(const thread_id_t nThreads)noexcept
+			: m_bStop(false), m_workersCnt(nThreads - 1), m_workingCnt(0), m_activeWorkersCnt(nThreads)
+			NNTL_THREADS_TELEMETRY_DO(, m_telemetry(nThreads, true))
+		{
+			NNTL_ASSERT(m_workersCnt >= 0);
+			NNTL_THREADS_TELEMETRY_DO(m_telemetry.thread_attach(0));
 
 			m_ranges.reserve(m_workersCnt);
 			m_threads.resize(m_workersCnt);
@@ -129,6 +150,16 @@ namespace threads {
 		}
 		//non static cached version of workers_count(), use it when possible instead of workers_count()
 		thread_id_t cur_workers_count()const noexcept { return m_workersCnt + 1; }
+
+		//limits the number of threads (including the main thread) used by default (when useNThreads isn't specified) to
+		//serve run() and reduce() requests. The value is clamped to [1, cur_workers_count()].
+		//Idle threads just sleep on a condition variable, so this is a cheap way to lend cores to somebody else.
+		//Thread safe, takes effect with the next request.
+		void set_active_workers(const thread_id_t n)noexcept {
+			m_activeWorkersCnt.store(::std::max(thread_id_t(1), ::std::min(n, m_workersCnt + 1)), ::std::memory_order_relaxed);
+		}
+		thread_id_t active_workers()const noexcept { return m_activeWorkersCnt.load(::std::memory_order_relaxed); }
+
 		auto get_worker_threads(thread_id_t& threadsCnt)noexcept ->ThreadObjIterator_t {
 			threadsCnt = m_workersCnt;
 			return m_threads.begin();
@@ -166,7 +197,8 @@ namespace threads {
 				if (pThreadsUsed) *pThreadsUsed = 1;
 				::std::forward<Func>(F)(par_range_t(cnt));
 			} else {
-				_run(CallH_t::wrap<Func>(::std::forward<Func>(F)), cnt, useNThreads, pThreadsUsed);
+				NNTL_THREADS_TELEMETRY_DO(m_telemetry.job_begin<Func>(cnt));
+				_run(CallH_t::template wrap<Func>(::std::forward<Func>(F)), cnt, useNThreads, pThreadsUsed);
 			}
 		}
 
@@ -183,17 +215,21 @@ namespace threads {
 			const auto prevOfs = partition_count_to_workers(cnt, useNThreads);
 			NNTL_ASSERT(prevOfs < cnt);
 			if (pThreadsUsed) *pThreadsUsed = static_cast<thread_id_t>(m_workingCnt) + 1;
+			NNTL_THREADS_TELEMETRY_DO(const auto telParticipants = static_cast<thread_id_t>(m_workingCnt) + 1);
 
 			m_waitingOrders.notify_all();
 			m_mutex.unlock();
+			NNTL_THREADS_TELEMETRY_DO(m_telemetry.job_dispatched(); m_telemetry.thread_begin(0));
 
 			//::std::forward<Func>(F)(par_range_t(prevOfs, cnt - prevOfs, 0));
 			//we mustn't forward F here, because we're using it in this function multiple times as normal lvalue
 			F(par_range_t(prevOfs, cnt - prevOfs, 0));
+			NNTL_THREADS_TELEMETRY_DO(m_telemetry.thread_end(0));
 
 			if (m_workingCnt > 0) {
 				Sync_t::lock_wait_unlock(m_mutex, m_orderDone, [&wc = m_workingCnt]() {return wc <= 0; });
 			}
+			NNTL_THREADS_TELEMETRY_DO(m_telemetry.job_end(telParticipants));
 		}
 
 	public:
@@ -215,15 +251,16 @@ namespace threads {
 			static_assert(::std::is_same<reduce_data_t, decltype(::std::forward<Func>(FRed)(par_range_t(cnt)))>::value, "");
 
 			typedef decltype(::std::forward<FinalReduceFunc>(FRF)(static_cast<const reduce_data_t*>(nullptr), range_t(0))) type_t;
-			typedef converter_reduce_data_t<type_t> converter_t;
+			typedef typename _i_threads<RealT, RangeT>::template converter_reduce_data_t<type_t> converter_t;
 
 			type_t ret;
 			if (cnt <= 1 || 1 == useNThreads) {
 				ret = converter_t::from(::std::forward<Func>(FRed)(par_range_t(cnt)));
 			} else {
+				NNTL_THREADS_TELEMETRY_DO(m_telemetry.job_begin<Func>(cnt));
 				ret = (::std::forward<FinalReduceFunc>(FRF))(
 					&m_reduceCache[0]
-					, _reduce(CallH_t::wrap<Func>(::std::forward<Func>(FRed)), cnt, useNThreads)
+					, _reduce(CallH_t::template wrap<Func>(::std::forward<Func>(FRed)), cnt, useNThreads)
 					);
 			}
 			return ret;
@@ -247,13 +284,16 @@ namespace threads {
 
 			m_waitingOrders.notify_all();
 			m_mutex.unlock();
+			NNTL_THREADS_TELEMETRY_DO(m_telemetry.job_dispatched(); m_telemetry.thread_begin(0));
 
 			//*rc = (::std::forward<Func>(FRed))(par_range_t(prevOfs, cnt - prevOfs, 0));
 			*rc = FRed(par_range_t(prevOfs, cnt - prevOfs, 0));
+			NNTL_THREADS_TELEMETRY_DO(m_telemetry.thread_end(0));
 
 			if (m_workingCnt > 0) {
 				Sync_t::lock_wait_unlock(m_mutex, m_orderDone, [&wc = m_workingCnt]() {return wc <= 0; });
 			}
+			NNTL_THREADS_TELEMETRY_DO(m_telemetry.job_end(static_cast<thread_id_t>(workersOnReduce)));
 			//return (::std::forward<FinalReduceFunc>(FRF))(rc, workersOnReduce);//OK to forward as we don't care if rvalue-qualified operator spoils it
 			return workersOnReduce;
 		}
@@ -263,7 +303,9 @@ namespace threads {
 		//returns an offset after last partitioned item
 		range_t partition_count_to_workers(const range_t cnt, const thread_id_t _useNThreads)noexcept {
 			//TODO: need cache friendly partitioning here
-			const thread_id_t useNThreads = _useNThreads > 1 && _useNThreads <= m_workersCnt + 1 ? _useNThreads - 1 : m_workersCnt;
+			//explicitly requested threads count has a priority over active_workers()
+			const thread_id_t useNThreads = _useNThreads > 1 && _useNThreads <= m_workersCnt + 1
+				? _useNThreads - 1 : m_activeWorkersCnt.load(::std::memory_order_relaxed) - 1;
 			const thread_id_t _workingCnt = cnt > useNThreads ? useNThreads : static_cast<thread_id_t>(cnt - 1);
 			m_workingCnt = _workingCnt;
 			const range_t totalWorkers = _workingCnt + 1;
@@ -285,7 +327,9 @@ namespace threads {
 
 		static void _s_worker(Workers* p, const thread_id_t id)noexcept {
 			global_denormalized_floats_mode();
+			NNTL_THREADS_TELEMETRY_DO(p->m_telemetry.thread_attach(id + 1));
 			p->_worker(id);
+			NNTL_THREADS_TELEMETRY_DO(p->m_telemetry.thread_detach(id + 1));
 		}
 
 		void _worker(const thread_id_t id)noexcept {
@@ -301,6 +345,7 @@ namespace threads {
 				});
 				if (m_bStop) break;
 
+				NNTL_THREADS_TELEMETRY_DO(m_telemetry.thread_begin(id + 1));
 				switch (m_jobType) {
 				case JobType::Run:
 					m_fnRun(thrdRange);
@@ -312,6 +357,7 @@ namespace threads {
 					NNTL_ASSERT(!"WTF???");
 					abort();
 				}
+				NNTL_THREADS_TELEMETRY_DO(m_telemetry.thread_end(id + 1));
 
 				//must set lock here to prevent deadlock during lk.lock();while (m_workingCnt > 0)  m_orderDone.wait(lk);...
 
@@ -0,0 +1,212 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//single producer single consumer lock-free byte ring that lives in a caller-provided memory block. The block may be
+//a private heap memory (for in-process transport) or a shared memory mapping (for inter-process transport) - the
+//only requirement is that ::std::atomic<::std::uint64_t> must be lock-free (and therefore address-free), which is the case
+//for any x64 platform.
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+#include "../_i_transport.h"
+
+namespace nntl {
+namespace distributed {
+namespace _impl {
+
+	class spsc_byte_ring {
+	public:
+		static constexpr ::std::uint64_t s_magic = 0x4e4e544c52494e47ull;//"NNTLRING"
+		static constexpr size_t s_cacheLine = 64;
+
+		struct header_t {
+			::std::atomic<::std::uint64_t> magic;//set by the creator last, when the ring is ready to use
+			::std::uint64_t capacity;
+
+			alignas(s_cacheLine) ::std::atomic<::std::uint64_t> head;//total bytes ever written. Modified by producer only
+			alignas(s_cacheLine) ::std::atomic<::std::uint64_t> tail;//total bytes ever read. Modified by consumer only
+		};
+		static_assert(sizeof(header_t) % s_cacheLine == 0, "");
+
+	protected:
+		header_t* m_pHdr{ nullptr };
+		char* m_pData{ nullptr };
+		::std::uint64_t m_capacity{ 0 };
+
+	public:
+		static constexpr size_t required_bytes(const size_t capacity)noexcept {
+			return sizeof(header_t) + capacity;
+		}
+
+		bool empty()const noexcept { return !m_pHdr; }
+
+		//pMem must be zero initialized and at least required_bytes(capacity) long
+		void create(void* pMem, const size_t capacity)noexcept {
+			static_assert(::std::atomic<::std::uint64_t>::is_always_lock_free, "");
+			NNTL_ASSERT(pMem && capacity > 0 && 0 == (reinterpret_cast<uintptr_t>(pMem) % s_cacheLine));
+			m_pHdr = static_cast<header_t*>(pMem);
+			m_pData = static_cast<char*>(pMem) + sizeof(header_t);
+			m_capacity = capacity;
+
+			m_pHdr->capacity = capacity;
+			m_pHdr->head.store(0, ::std::memory_order_relaxed);
+			m_pHdr->tail.store(0, ::std::memory_order_relaxed);
+			m_pHdr->magic.store(s_magic, ::std::memory_order_release);
+		}
+
+		//returns false if the ring in pMem hasn't been created yet
+		bool attach(void* pMem)noexcept {
+			NNTL_ASSERT(pMem);
+			auto pH = static_cast<header_t*>(pMem);
+			if (s_magic != pH->magic.load(::std::memory_order_acquire)) return false;
+			m_pHdr = pH;
+			m_pData = static_cast<char*>(pMem) + sizeof(header_t);
+			m_capacity = pH->capacity;
+			return true;
+		}
+
+		void detach()noexcept {
+			m_pHdr = nullptr;
+			m_pData = nullptr;
+			m_capacity = 0;
+		}
+
+		//producer side. Writes as much as possible and returns the number of bytes written
+		size_t push(const void* pSrc, const size_t bytes)noexcept {
+			NNTL_ASSERT(m_pHdr);
+			const auto head = m_pHdr->head.load(::std::memory_order_relaxed);
+			const auto tail = m_pHdr->tail.load(::std::memory_order_acquire);
+			const size_t n = static_cast<size_t>(::std::min<::std::uint64_t>(m_capacity - (head - tail), bytes));
+			if (n) {
+				const size_t ofs = static_cast<size_t>(head % m_capacity);
+				const size_t n1 = ::std::min(n, static_cast<size_t>(m_capacity) - ofs);
+				::std::memcpy(m_pData + ofs, pSrc, n1);
+				if (n1 < n) ::std::memcpy(m_pData, static_cast<const char*>(pSrc) + n1, n - n1);
+				m_pHdr->head.store(head + n, ::std::memory_order_release);
+			}
+			return n;
+		}
+
+		//consumer side. Reads as much as possible and returns the number of bytes read
+		size_t pop(void* pDest, const size_t bytes)noexcept {
+			NNTL_ASSERT(m_pHdr);
+			const auto tail = m_pHdr->tail.load(::std::memory_order_relaxed);
+			const auto head = m_pHdr->head.load(::std::memory_order_acquire);
+			const size_t n = static_cast<size_t>(::std::min<::std::uint64_t>(head - tail, bytes));
+			if (n) {
+				const size_t ofs = static_cast<size_t>(tail % m_capacity);
+				const size_t n1 = ::std::min(n, static_cast<size_t>(m_capacity) - ofs);
+				::std::memcpy(pDest, m_pData + ofs, n1);
+				if (n1 < n) ::std::memcpy(static_cast<char*>(pDest) + n1, m_pData, n - n1);
+				m_pHdr->tail.store(tail + n, ::std::memory_order_release);
+			}
+			return n;
+		}
+	};
+
+	//implements _i_transport::exchange() over a pair of rings. FinalT must provide out_ring() and in_ring()
+	template<typename FinalT>
+	class _spsc_ring_transport : public _ring_transport_base<FinalT> {
+		typedef _ring_transport_base<FinalT> _base_class_t;
+
+	protected:
+		typedef FinalT self_t;
+		NNTL_METHODS_SELF();
+
+		//how long to spin before starting to yield the CPU
+		unsigned m_spinsBeforeYield{ 256 };
+		::std::chrono::milliseconds m_timeout{ 120000 };
+
+		_spsc_ring_transport(const int r, const int ws)noexcept : _base_class_t(r, ws) {}
+
+	public:
+		template<class Rep, class Period>
+		self_ref_t set_timeout(const ::std::chrono::duration<Rep, Period>& to)noexcept {
+			m_timeout = ::std::chrono::duration_cast<::std::chrono::milliseconds>(to);
+			return get_self();
+		}
+
+		bool exchange(const void* pSend, const size_t sendBytes, void* pRecv, const size_t recvBytes)noexcept {
+			NNTL_ASSERT((pSend || !sendBytes) && (pRecv || !recvBytes));
+			if (1 == this->m_worldSize) {
+				//degenerate ring - sending to self
+				NNTL_ASSERT(sendBytes == recvBytes);
+				if (pRecv != pSend) ::std::memcpy(pRecv, pSend, ::std::min(sendBytes, recvBytes));
+				return true;
+			}
+			auto& outR = get_self().out_ring();
+			auto& inR = get_self().in_ring();
+
+			size_t sent = 0, rcvd = 0;
+			unsigned idle = 0;
+			::std::chrono::steady_clock::time_point idleSince;
+			while (sent < sendBytes || rcvd < recvBytes) {
+				size_t progress = 0;
+				if (sent < sendBytes) {
+					const auto n = outR.push(static_cast<const char*>(pSend) + sent, sendBytes - sent);
+					sent += n;
+					progress += n;
+				}
+				if (rcvd < recvBytes) {
+					const auto n = inR.pop(static_cast<char*>(pRecv) + rcvd, recvBytes - rcvd);
+					rcvd += n;
+					progress += n;
+				}
+
+				if (progress) {
+					idle = 0;
+				} else {
+					if (idle == m_spinsBeforeYield) {
+						idleSince = ::std::chrono::steady_clock::now();
+					} else if (idle > m_spinsBeforeYield) {
+						if (0 == (idle & 1023) && ::std::chrono::steady_clock::now() - idleSince > m_timeout) {
+							NNTL_ASSERT(!"Transport timeout!");
+							return false;
+						}
+						::std::this_thread::yield();
+					}
+					++idle;
+				}
+			}
+			return true;
+		}
+	};
+
+}
+}
+}
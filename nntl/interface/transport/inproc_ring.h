@@ -0,0 +1,117 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//in-process ring transport: participants are threads of the same process.
+//Usage:
+//	distributed::inproc_ring_hub hub(worldSize);
+//	//in thread with rank r:
+//	distributed::inproc_ring_transport transport(hub, r);
+//
+//The hub owns all the memory and must outlive every transport object that uses it.
+
+#include <vector>
+#include <memory>
+
+#include "_spsc_ring.h"
+
+namespace nntl {
+namespace distributed {
+
+	class inproc_ring_hub {
+		inproc_ring_hub(const inproc_ring_hub& other)noexcept = delete;
+		inproc_ring_hub& operator=(const inproc_ring_hub& rhs) noexcept = delete;
+
+	public:
+		static constexpr size_t defaultRingCapacity = 1 << 22;
+
+	protected:
+		typedef _impl::spsc_byte_ring ring_t;
+
+		struct alignas(ring_t::s_cacheLine) block_t { char d[ring_t::s_cacheLine]; };
+
+		//ring r connects rank r (producer) with rank r+1 (consumer)
+		::std::vector<ring_t> m_rings;
+		::std::unique_ptr<block_t[]> m_pMem;
+		int m_worldSize;
+
+	public:
+		~inproc_ring_hub()noexcept {}
+		inproc_ring_hub(const int worldSize, const size_t ringCapacity = defaultRingCapacity)noexcept
+			: m_rings(static_cast<size_t>(worldSize)), m_worldSize(worldSize)
+		{
+			NNTL_ASSERT(worldSize > 0 && ringCapacity > 0);
+			const size_t ringBlocks = (ring_t::required_bytes(ringCapacity) + sizeof(block_t) - 1) / sizeof(block_t);
+			m_pMem.reset(new(::std::nothrow) block_t[ringBlocks*worldSize]());
+			if (!m_pMem) {
+				NNTL_ASSERT(!"Failed to allocate memory for inproc_ring_hub");
+				m_rings.clear();
+				return;
+			}
+			for (int i = 0; i < worldSize; ++i) {
+				m_rings[i].create(m_pMem.get() + ringBlocks*i, ringCapacity);
+			}
+		}
+
+		bool empty()const noexcept { return m_rings.empty(); }
+		int world_size()const noexcept { return m_worldSize; }
+
+		ring_t& ring(const int idx)noexcept {
+			NNTL_ASSERT(idx >= 0 && idx < m_worldSize && !m_rings.empty());
+			return m_rings[idx];
+		}
+	};
+
+	class inproc_ring_transport final : public _impl::_spsc_ring_transport<inproc_ring_transport> {
+		typedef _impl::_spsc_ring_transport<inproc_ring_transport> _base_class_t;
+
+		inproc_ring_transport(const inproc_ring_transport& other)noexcept = delete;
+		inproc_ring_transport& operator=(const inproc_ring_transport& rhs) noexcept = delete;
+
+	public:
+		typedef _impl::spsc_byte_ring ring_t;
+
+	protected:
+		inproc_ring_hub& m_hub;
+
+	public:
+		~inproc_ring_transport()noexcept {}
+		inproc_ring_transport(inproc_ring_hub& hub, const int r)noexcept : _base_class_t(r, hub.world_size()), m_hub(hub) {
+			NNTL_ASSERT(!hub.empty());
+		}
+
+		ring_t& out_ring()noexcept { return m_hub.ring(m_rank); }
+		ring_t& in_ring()noexcept { return m_hub.ring(prev_rank()); }
+	};
+
+}
+}
@@ -0,0 +1,196 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//POSIX shared memory ring transport: participants are processes on the same machine.
+//Each rank r creates a shared memory object "/<jobName>_<r>" holding the ring r -> r+1 and opens the object of the
+// rank r-1 to receive data from it. jobName must be the same for every participant of the job and it must be unique
+// for concurrently running jobs (include something like the launcher PID into it). Segments are unlinked in destructor;
+// if a job crashed, use shm_ring_transport::cleanup() to remove leftovers before the next run with the same jobName.
+//
+//The constructor blocks until the whole ring is connected (or the timeout expires). Check empty() afterwards.
+//
+//Launching a job is the caller's business. The simplest way is just to start worldSize processes passing them their
+// rank and worldSize (and the jobName) in command line (or to fork() them).
+
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "_spsc_ring.h"
+
+#define NNTL_HAS_SHM_RING_TRANSPORT 1
+
+namespace nntl {
+namespace distributed {
+
+	class shm_ring_transport final : public _impl::_spsc_ring_transport<shm_ring_transport> {
+		typedef _impl::_spsc_ring_transport<shm_ring_transport> _base_class_t;
+
+		shm_ring_transport(const shm_ring_transport& other)noexcept = delete;
+		shm_ring_transport& operator=(const shm_ring_transport& rhs) noexcept = delete;
+
+	public:
+		typedef _impl::spsc_byte_ring ring_t;
+		static constexpr size_t defaultRingCapacity = 1 << 22;
+
+	protected:
+		struct mapping {
+			void* ptr{ nullptr };
+			size_t bytes{ 0 };
+
+			void unmap()noexcept {
+				if (ptr) {
+					::munmap(ptr, bytes);
+					ptr = nullptr;
+					bytes = 0;
+				}
+			}
+		};
+
+		::std::string m_jobName;
+		mapping m_outMap, m_inMap;
+		ring_t m_outRing, m_inRing;
+
+	protected:
+		static ::std::string _seg_name(const ::std::string& jobName, const int r) {
+			return "/" + jobName + "_" + ::std::to_string(r);
+		}
+
+		bool _create_out(const size_t cap)noexcept {
+			const auto name = _seg_name(m_jobName, m_rank);
+			::shm_unlink(name.c_str());//removing possible leftovers with the same name
+
+			const int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+			if (fd < 0) return false;
+
+			const size_t bytes = ring_t::required_bytes(cap);
+			bool bOk = (0 == ::ftruncate(fd, static_cast<off_t>(bytes)));
+			if (bOk) {
+				//fresh memory obtained by ftruncate() is zeroed, just as ring_t wants
+				void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+				if (MAP_FAILED == p) {
+					bOk = false;
+				} else {
+					m_outMap.ptr = p;
+					m_outMap.bytes = bytes;
+					m_outRing.create(p, cap);
+				}
+			}
+			::close(fd);
+			if (!bOk) ::shm_unlink(name.c_str());
+			return bOk;
+		}
+
+		//polls for the segment of the previous rank to appear
+		bool _open_in()noexcept {
+			const auto name = _seg_name(m_jobName, prev_rank());
+			const auto startedAt = ::std::chrono::steady_clock::now();
+
+			while (true) {
+				const int fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+				if (fd >= 0) {
+					struct stat st;
+					if (0 == ::fstat(fd, &st) && st.st_size >= static_cast<off_t>(sizeof(ring_t::header_t))) {
+						const size_t bytes = static_cast<size_t>(st.st_size);
+						void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+						::close(fd);
+						if (MAP_FAILED == p) return false;
+						if (m_inRing.attach(p)) {
+							m_inMap.ptr = p;
+							m_inMap.bytes = bytes;
+							return true;
+						}
+						::munmap(p, bytes);
+					} else ::close(fd);
+				}
+
+				if (::std::chrono::steady_clock::now() - startedAt > m_timeout) return false;
+				::std::this_thread::sleep_for(::std::chrono::milliseconds(1));
+			}
+		}
+
+		void _close()noexcept {
+			m_outRing.detach();
+			m_inRing.detach();
+			m_outMap.unmap();
+			m_inMap.unmap();
+			if (!m_jobName.empty()) ::shm_unlink(_seg_name(m_jobName, m_rank).c_str());
+		}
+
+	public:
+		~shm_ring_transport()noexcept {
+			_close();
+		}
+
+		shm_ring_transport(const char* jobName, const int r, const int ws, const size_t ringCapacity = defaultRingCapacity
+			, const ::std::chrono::milliseconds connectTimeout = ::std::chrono::milliseconds(60000)
+		)noexcept : _base_class_t(r, ws), m_jobName(jobName)
+		{
+			NNTL_ASSERT(jobName && *jobName && ringCapacity > 0);
+			if (1 == ws) return;//nothing to connect to
+
+			const auto origTO = m_timeout;
+			m_timeout = connectTimeout;
+			//barrier() here is required, because otherwise the first rank to finish the constructor may start sending
+			// data before its peer has been connected (it's harmless), but more importantly the destructor of a quick
+			// participant could unlink its segment before the peer has opened it.
+			if (!_create_out(ringCapacity) || !_open_in() || !barrier()) {
+				STDCOUTL("*** shm_ring_transport: failed to connect rank " << r << " of " << ws << " for job " << jobName);
+				_close();
+			}
+			m_timeout = origTO;
+		}
+
+		bool empty()const noexcept { return m_worldSize > 1 && (m_outRing.empty() || m_inRing.empty()); }
+
+		ring_t& out_ring()noexcept { return m_outRing; }
+		ring_t& in_ring()noexcept { return m_inRing; }
+
+		//removes shared memory objects that might be left by a crashed job
+		static void cleanup(const char* jobName, const int worldSize)noexcept {
+			for (int i = 0; i < worldSize; ++i) ::shm_unlink(_seg_name(jobName, i).c_str());
+		}
+	};
+
+}
+}
+
+#else
+
+#define NNTL_HAS_SHM_RING_TRANSPORT 0
+
+#endif
@@ -105,6 +105,9 @@ namespace _impl {
 			} else {
 				if (!m_activations.resize_as_dataset(biggestOutgBS, neurons_cnt))
 					return ErrorCode::CantAllocateMemoryForActivations;
+				//activations are mostly written by worker threads, so let their pages be on the workers NUMA nodes.
+				// LPH allocates them before _layer_base::layer_init() binds the common data and touches them itself
+				if (has_common_data()) get_iMath().first_touch(m_activations);
 			}
 			return ErrorCode::Success;
 		}
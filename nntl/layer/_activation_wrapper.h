@@ -53,9 +53,9 @@ namespace nntl {
 			typedef _act_stor<FinalPolymorphChild, InterfacesT> _base_class_t;
 
 		public:
-			using _base_class_t::real_t;
-			using _base_class_t::realmtx_t;
-			using _base_class_t::realmtxdef_t;
+			using typename _base_class_t::real_t;
+			using typename _base_class_t::realmtx_t;
+			using typename _base_class_t::realmtxdef_t;
 			
 			static_assert(::std::is_same<typename InterfacesT::real_t, typename ActivFuncT::real_t>::value, "Invalid real_t");
 
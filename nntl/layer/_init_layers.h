@@ -61,6 +61,9 @@ namespace nntl {
 	// See LI for an example
 	struct m_layer_autoneurons_cnt {};
 
+	//marks an ensemble-packed layer (see layer/fully_connected_ensemble.h). It must provide ensemble_members_count() function.
+	struct m_layer_ensemble {};
+
 	//////////////////////////////////////////////////////////////////////////
 
 	template<typename LayerT>
@@ -77,6 +80,9 @@ namespace nntl {
 
 	template<typename LayerT>
 	using is_layer_stops_bprop = ::std::is_base_of<m_layer_stops_bprop, LayerT>;
+
+	template<typename LayerT>
+	using is_layer_ensemble = ::std::is_base_of<m_layer_ensemble, LayerT>;
 	template<typename LayerT>
 	using is_layer_with_bprop = ::std::negation<::std::is_base_of<m_layer_stops_bprop, LayerT>>;
 
@@ -94,6 +94,77 @@ namespace nntl {
 	template< class T >
 	struct layer_has_gradworks<T, ::std::void_t<typename T::grad_works_t>> : ::std::true_type {};
 
+	// recognizes layers that store their weights in a single matrix available via get_weights() & has_weights()
+	template< class, class = ::std::void_t<> >
+	struct layer_has_weights_mtx : ::std::false_type { };
+	template< class T >
+	struct layer_has_weights_mtx<T, ::std::void_t<decltype(::std::declval<T&>().get_weights())
+		, decltype(::std::declval<const T&>().has_weights())>> : ::std::true_type {};
+
+	// recognizes layers with a single weights matrix that keep a mask of weights left after pruning (such as LFCP, see
+	// layer/fully_connected_pruned.h). Zero elements of the mask are weights that are fixed to zero and aren't learned.
+	//		const realmtx_t& get_prune_mask()const; - the mask of the weights size, empty if nothing is pruned
+	//		bool set_weights(const realmtx_t& W, const realmtx_t& mask); - sets both, an empty mask drops the mask
+	// Generic code that copies weights between layers must copy the mask too, because the layer doesn't derive it from W.
+	template< class, class = ::std::void_t<> >
+	struct layer_has_prune_mask : ::std::false_type { };
+	template< class T >
+	struct layer_has_prune_mask<T, ::std::void_t<decltype(::std::declval<const T&>().get_prune_mask())>> : ::std::true_type {};
+
+	// Layers that keep their weights in several matrices, each updated by its own grad_works object (such as LFCLR, see
+	// layer/fully_connected_lowrank.h), expose them as numbered weights blocks instead of get_weights():
+	//		static constexpr unsigned weights_blocks_cnt;
+	//		realmtx_t& get_weights_block(const unsigned b); (and const version) - [rows, cols+1] layout, the last column is biases
+	//		grad_works_t& get_gradWorks_block(const unsigned b); (and const version)
+	//		bool set_weights_blocks(const realmtx_t* pW); - pW points to weights_blocks_cnt matrices
+	// Generic code (checkpoints, data parallel training, gradient check) should use the layer_*_block() helpers below, that
+	// treat a layer with a single weights matrix (get_weights(), get_gradWorks() and set_weights()) as the block 0.
+	template< class, class = ::std::void_t<> >
+	struct layer_has_weights_blocks : ::std::false_type { };
+	template< class T >
+	struct layer_has_weights_blocks<T, ::std::void_t<decltype(T::weights_blocks_cnt)>> : ::std::true_type {};
+
+	template<class T, bool = layer_has_weights_blocks<::std::remove_const_t<T>>::value>
+	struct layer_weights_blocks_cnt : ::std::integral_constant<unsigned, 1> {};
+	template<class T>
+	struct layer_weights_blocks_cnt<T, true> : ::std::integral_constant<unsigned, ::std::remove_const_t<T>::weights_blocks_cnt> {};
+
+	template<typename LayerT> inline auto layer_weights_block(LayerT& l, const unsigned b)noexcept
+		-> ::std::enable_if_t<!layer_has_weights_blocks<::std::remove_const_t<LayerT>>::value, decltype(l.get_weights())>
+	{
+		NNTL_ASSERT(0 == b); NNTL_UNREF(b);
+		return l.get_weights();
+	}
+	template<typename LayerT> inline auto layer_weights_block(LayerT& l, const unsigned b)noexcept
+		-> ::std::enable_if_t<layer_has_weights_blocks<::std::remove_const_t<LayerT>>::value, decltype(l.get_weights_block(b))>
+	{
+		return l.get_weights_block(b);
+	}
+
+	template<typename LayerT> inline auto layer_gradWorks_block(LayerT& l, const unsigned b)noexcept
+		-> ::std::enable_if_t<!layer_has_weights_blocks<::std::remove_const_t<LayerT>>::value, decltype(l.get_gradWorks())>
+	{
+		NNTL_ASSERT(0 == b); NNTL_UNREF(b);
+		return l.get_gradWorks();
+	}
+	template<typename LayerT> inline auto layer_gradWorks_block(LayerT& l, const unsigned b)noexcept
+		-> ::std::enable_if_t<layer_has_weights_blocks<::std::remove_const_t<LayerT>>::value, decltype(l.get_gradWorks_block(b))>
+	{
+		return l.get_gradWorks_block(b);
+	}
+
+	//pW points to layer_weights_blocks_cnt<LayerT> matrices that are copied to the layer
+	template<typename LayerT> inline ::std::enable_if_t<!layer_has_weights_blocks<LayerT>::value, bool>
+		layer_set_weights_blocks(LayerT& l, const typename LayerT::realmtx_t* pW)noexcept
+	{
+		return l.set_weights(*pW);
+	}
+	template<typename LayerT> inline ::std::enable_if_t<layer_has_weights_blocks<LayerT>::value, bool>
+		layer_set_weights_blocks(LayerT& l, const typename LayerT::realmtx_t* pW)noexcept
+	{
+		return l.set_weights_blocks(pW);
+	}
+
 
 	//////////////////////////////////////////////////////////////////////////
 	//////////////////////////////////////////////////////////////////////////
@@ -526,7 +597,7 @@ namespace nntl {
 		//typedefs		
 		typedef _impl::_layer_init_data<common_data_t> _layer_init_data_t;
 
-		using _base_class_t::real_t;
+		using typename _base_class_t::real_t;
 
 	protected:
 		NNTL_DEBUG_DECLARE(BatchSizes m_incBS);
@@ -619,15 +690,16 @@ namespace nntl {
 		static constexpr bool hasLossAddendum()noexcept { return false; }
 		
 		//////////////////////////////////////////////////////////////////////////
+		// self_t is incomplete when _layer_base is instantiated, SelfT defers is_layer_learnable<> until a call
 
-		template<bool c = is_layer_learnable<self_t>::value >
+		template<typename SelfT = self_t, bool c = is_layer_learnable<SelfT>::value >
 		::std::enable_if_t<c, bool> bIgnoreActivation()const noexcept { return m_bIgnoreActivation; }
 
 		//for a layer that is not learnable we should return false to make activation function work
-		template<bool c = is_layer_learnable<self_t>::value >
+		template<typename SelfT = self_t, bool c = is_layer_learnable<SelfT>::value >
 		::std::enable_if_t<!c, bool> constexpr bIgnoreActivation()const noexcept { return false; }
 
-		template<bool c = is_layer_learnable<self_t>::value >
+		template<typename SelfT = self_t, bool c = is_layer_learnable<SelfT>::value >
 		::std::enable_if_t<c> setIgnoreActivation(const bool b)noexcept { m_bIgnoreActivation = b; }
 
 		//////////////////////////////////////////////////////////////////////////
@@ -50,6 +50,9 @@ namespace nntl {
 			typedef _base_class_t _pre_LPH_base_class_t;
 
 		public:
+			using typename _base_class_t::realmtx_t;
+			typedef typename _base_class_t::ErrorCode ErrorCode;
+
 			//LayerPack_t is used to distinguish ordinary layers from layer packs (for example, to implement call_F_for_each_layer())
 			typedef self_t LayerPack_t;
 
@@ -295,6 +298,7 @@ namespace nntl {
 				//first initializing this layer's activations
 				auto ec = get_self()._lph_act_stor_init_activations(lid.biggest_incoming_batch_size(), pNewActivationStorage);
 				if (ErrorCode::Success != ec) return ec;
+				if (!pNewActivationStorage) lid.commonData.iMath().first_touch(m_activations);
 
 				bool bSuccessfullyInitialized = false;
 				utils::scope_exit onExit([&bSuccessfullyInitialized, this]() {
@@ -226,6 +226,35 @@ namespace nntl {
 
 		template<typename LayerT>
 		using wrap_part_trainable_layer = _trainable_partial_layer_wrapper< m_propagate_markers<LayerT> >;
+
+		template<typename T> struct is_trainable_partial_layer_wrapper : ::std::false_type {};
+		template<typename PIMLT>
+		struct is_trainable_partial_layer_wrapper<_trainable_partial_layer_wrapper<PIMLT>> : ::std::true_type {};
+
+		//////////////////////////////////////////////////////////////////////////
+		// Layers that might make their activations a view of the lower layer activations (see LI) must be fed with
+		// a matrix that stays valid until their bprop(), i.e. not with a temporary _trainable_partial_layer_wrapper
+		template<class, class = ::std::void_t<>>
+		struct layer_may_alias_activations : ::std::false_type {};
+		template<class LayerT>
+		struct layer_may_alias_activations<LayerT, ::std::void_t<decltype(::std::declval<const LayerT&>().is_aliasing_activations())>>
+			: ::std::true_type {};
+
+		template<typename LayerT>
+		::std::enable_if_t<layer_may_alias_activations<LayerT>::value, bool> is_layer_aliasing_activations(const LayerT& l)noexcept {
+			return l.is_aliasing_activations();
+		}
+		template<typename LayerT>
+		constexpr ::std::enable_if_t<!layer_may_alias_activations<LayerT>::value, bool> is_layer_aliasing_activations(const LayerT&)noexcept {
+			return false;
+		}
+
+		template<typename LayerT>
+		::std::enable_if_t<layer_may_alias_activations<LayerT>::value> forbid_activations_aliasing(LayerT& l)noexcept {
+			l.alias_activations(false);
+		}
+		template<typename LayerT>
+		::std::enable_if_t<!layer_may_alias_activations<LayerT>::value> forbid_activations_aliasing(LayerT&)noexcept {}
 		
 
 		//////////////////////////////////////////////////////////////////////////
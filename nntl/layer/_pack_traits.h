@@ -73,4 +73,13 @@ namespace nntl {
 	struct is_layer_LPH: ::std::false_type { };
 	template< class T >
 	struct is_layer_LPH<T, ::std::void_t<typename T::_phl_tuple>> : ::std::true_type {};
+
+	//////////////////////////////////////////////////////////////////////////
+	// Tests if a layer could be tiled by LPT inplace, i.e. it's able to consume K tiles of incoming data without data rolling
+	// (see layer/pack_tile.h). Such layer defines static constexpr bool bTileableInplace and _lpt_tile_inplace(K) member function
+	template< class, class = ::std::void_t<> >
+	struct is_layer_tileable_inplace : ::std::false_type { };
+	template< class T >
+	struct is_layer_tileable_inplace<T, ::std::void_t<decltype(T::bTileableInplace)>>
+		: ::std::integral_constant<bool, T::bTileableInplace> {};
 }
\ No newline at end of file
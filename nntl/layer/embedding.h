@@ -0,0 +1,381 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+// LE (layer_embedding) is a lookup table layer for categorical features. Every incoming neuron holds an integer category id
+// (stored as a real_t value, so ids must be exactly representable with real_t, i.e. less than 2^24 for float) and the layer
+// outputs a learnable dense vector of embeddingDim values for each of them. It's mathematically the same as a linear LFC
+// without biases applied to a one-hot encoded data, but it's done by gathering columns of the table instead of doing GEMM
+// with a mostly-zero matrix, so it scales to vocabularies with millions of categories.
+//
+// During bprop() only the columns of the table that were used in the batch get the gradient (accumulated into a compact
+// [embeddingDim, used ids count] matrix) and only these columns are updated, as well as the corresponding part of the optimizer
+// state (see _grad_works::apply_grad_sparse() for what's supported there, other settings make layer_init() return
+// ErrorCode::UnsupportedGradWorksSettings). Data-parallel training isn't supported:
+// distributed::dp_grad_works rejects the sparse mode at compile time.
+//
+// The layer doesn't compute dL/dAPrev since ids aren't differentiable. It's expected to sit right above the input layer or,
+// more commonly, to be a part of the layer_pack_horizontal, that feeds some columns of the data to the LE and the other
+// (dense) columns to other layers, for example:
+//		layer_input<> Li(dataColumns);
+//		LE<> Le(vocabSize, embeddingDim, idsColumns);
+//		LFC<> Ldense(100);
+//		auto Lph = make_layer_pack_horizontal(make_PHL(Le, 0, idsColumns), make_PHL(Ldense, idsColumns, dataColumns - idsColumns));
+//
+// Note that the layer isn't marked with m_layer_learnable, because everything that uses that marker (gradient checking,
+// LSUV and so on) assume the [neurons_cnt, incoming_neurons_cnt+1] weights matrix layout.
+
+#include <memory>
+#include <limits>
+
+#include "_activation_storage.h"
+#include "../interface/rng/distr_normal_naive.h"
+
+namespace nntl {
+
+	template<typename FinalPolymorphChild, typename GradWorks>
+	class _LE : public _impl::_act_stor<FinalPolymorphChild, typename GradWorks::interfaces_t> {
+	private:
+		typedef _impl::_act_stor<FinalPolymorphChild, typename GradWorks::interfaces_t> _base_class_t;
+
+	public:
+		typedef GradWorks grad_works_t;
+		static_assert(::std::is_base_of<_impl::_i_grad_works<real_t>, grad_works_t>::value, "GradWorks template parameter should be derived from _i_grad_works");
+
+		static constexpr const char _defName[] = "le";
+
+		static constexpr vec_len_t invalid_slot = ::std::numeric_limits<vec_len_t>::max();
+
+		//////////////////////////////////////////////////////////////////////////
+		//members
+	protected:
+		// embeddings table: <m_embeddingDim rows> x <m_vocabSize cols>, i.e. each embedding vector is a contiguous column
+		realmtx_t m_weights;
+
+		// compact dL/dW of the embeddings used in a batch <m_embeddingDim rows> x <at most min(m_vocabSize, maxTrainBS*idsCnt) cols>
+		realmtx_t m_dLdWc;
+
+		grad_works_t m_gradientWorks;
+
+		// m_id2slot maps an id to a column of m_dLdWc (invalid_slot if the id isn't used in the current batch). It's restored
+		// to all invalid_slot after each bprop(). m_slots stores a column of m_dLdWc for each element of the incoming ids
+		// matrix and m_cols is the inverse of m_id2slot for the used ids.
+		::std::unique_ptr<vec_len_t[]> m_id2slot, m_slots, m_cols;
+
+		const vec_len_t m_vocabSize;
+		const neurons_count_t m_embeddingDim;
+		const neurons_count_t m_idsCnt;
+
+		//this flag controls the weights matrix initialization and prevents reinitialization on next nnet.train() calls
+		bool m_bWeightsInitialized{ false };
+
+		//////////////////////////////////////////////////////////////////////////
+		//Serialization support
+	private:
+		friend class ::boost::serialization::access;
+		template<class Archive>
+		void save(Archive & ar, const unsigned int version) const {
+			NNTL_UNREF(version);
+			if (utils::binary_option<true>(ar, serialization::serialize_activations)) ar & NNTL_SERIALIZATION_NVP(m_activations);
+			if (utils::binary_option<true>(ar, serialization::serialize_weights)) ar & NNTL_SERIALIZATION_NVP(m_weights);
+			if (utils::binary_option<true>(ar, serialization::serialize_grad_works)) ar & m_gradientWorks;
+		}
+
+		template<class Archive>
+		void load(Archive & ar, const unsigned int version) {
+			NNTL_UNREF(version);
+			if (utils::binary_option<true>(ar, serialization::serialize_weights)) {
+				realmtx_t M;
+				ar & serialization::make_nvp("m_weights", M);
+				if (ar.success()) {
+					if (!get_self().set_weights(::std::move(M))) {
+						STDCOUTL("*** Failed to absorb read weights for layer " << get_self().get_layer_name_str());
+						ar.mark_invalid_var();
+					}
+				} else {
+					STDCOUTL("*** Failed to read weights for layer " << get_self().get_layer_name_str()
+						<< ", " << ar.get_last_error_str());
+				}
+			}
+		}
+		BOOST_SERIALIZATION_SPLIT_MEMBER();
+
+	protected:
+		friend class _impl::_preinit_layers;
+		void _preinit_layer(_impl::init_layer_index& ili, const neurons_count_t inc_neurons_cnt)noexcept {
+			NNTL_ASSERT(inc_neurons_cnt == m_idsCnt || !"Incoming neurons count must be equal to the number of ids columns!");
+			if (inc_neurons_cnt != m_idsCnt) {
+				STDCOUTL("*** Layer " << get_self().get_layer_name_str() << " expects " << m_idsCnt << " incoming neurons, but got "
+					<< inc_neurons_cnt);
+				abort();
+			}
+			_base_class_t::_preinit_layer(ili, inc_neurons_cnt);
+			NNTL_ASSERT(get_layer_idx() > 0);
+		}
+
+	public:
+		~_LE() noexcept {};
+		_LE(const char* pCustomName, const vec_len_t vocabSize, const neurons_count_t embeddingDim, const neurons_count_t idsCnt = 1
+			, const real_t learningRate = real_t(.01))noexcept
+			: _base_class_t(embeddingDim*idsCnt, pCustomName), m_gradientWorks(learningRate)
+			, m_vocabSize(vocabSize), m_embeddingDim(embeddingDim), m_idsCnt(idsCnt)
+		{
+			NNTL_ASSERT(vocabSize > 0 && embeddingDim > 0 && idsCnt > 0);
+			NNTL_ASSERT(m_activations.emulatesBiases());
+		};
+		_LE(const vec_len_t vocabSize, const neurons_count_t embeddingDim, const neurons_count_t idsCnt = 1
+			, const real_t learningRate = real_t(.01), const char* pCustomName = nullptr)noexcept
+			: _LE(pCustomName, vocabSize, embeddingDim, idsCnt, learningRate)
+		{};
+
+		vec_len_t vocab_size()const noexcept { return m_vocabSize; }
+		neurons_count_t embedding_dim()const noexcept { return m_embeddingDim; }
+		neurons_count_t ids_count()const noexcept { return m_idsCnt; }
+
+		grad_works_t& get_gradWorks()noexcept { return m_gradientWorks; }
+		const grad_works_t& get_gradWorks()const noexcept { return m_gradientWorks; }
+
+		//////////////////////////////////////////////////////////////////////////
+
+		const realmtx_t& get_weights()const noexcept { NNTL_ASSERT(m_bWeightsInitialized); return m_weights; }
+		realmtx_t& get_weights() noexcept { NNTL_ASSERT(m_bWeightsInitialized); return m_weights; }
+		bool has_weights()const noexcept { return m_bWeightsInitialized; }
+
+		bool isWeightsSuitable(const realmtx_t& W)const noexcept {
+			if (W.empty() || W.bBatchInRow() || W.emulatesBiases() || W.size() != mtx_size_t(m_embeddingDim, m_vocabSize)) {
+				NNTL_ASSERT(!"Wrong weight matrix passed!");
+				return false;
+			}
+			NNTL_ASSERT(W.test_noNaNs());
+			return true;
+		}
+
+		bool set_weights(realmtx_t&& W)noexcept {
+			if (!get_self().isWeightsSuitable(W)) return false;
+			get_self().drop_weights();
+
+			m_weights = ::std::move(W);
+			m_bWeightsInitialized = true;
+			return true;
+		}
+		bool set_weights(const realmtx_t& W)noexcept {
+			if (!get_self().isWeightsSuitable(W)) return false;
+			get_self().drop_weights();
+
+			if (!m_weights.cloneFrom(W)) return false;
+			m_bWeightsInitialized = true;
+			return true;
+		}
+
+		//embeddings are initialized with N(0, 1/embeddingDim), so the expected norm of an embedding vector is about 1
+		bool reinit_weights()noexcept {
+			NNTL_ASSERT(m_bWeightsInitialized || !"reinit_weights() can only be called after layer_init()!");
+			NNTL_ASSERT(get_self().isWeightsSuitable(m_weights) || !"WTF?! Wrong state of weight matrix");
+			rng::distr_normal_naive<iRng_t> d(get_iRng(), real_t(0), real_t(1) / ::std::sqrt(real_t(m_embeddingDim)));
+			d.gen_matrix(m_weights);
+			return true;
+		}
+
+		void drop_weights()noexcept {
+			m_weights.clear();
+			m_bWeightsInitialized = false;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		ErrorCode layer_init(_layer_init_data_t& lid, real_t*const pNewActivationStorage = nullptr)noexcept {
+			bool bSuccessfullyInitialized = false;
+			utils::scope_exit onExit([&bSuccessfullyInitialized, this]() {
+				if (!bSuccessfullyInitialized) get_self().layer_deinit();
+			});
+
+			auto ec = _base_class_t::layer_init(lid, pNewActivationStorage);
+			if (ErrorCode::Success != ec) return ec;
+
+			NNTL_ASSERT(!m_weights.emulatesBiases());
+			if (m_bWeightsInitialized) {
+				if (!get_self().isWeightsSuitable(m_weights)) {
+					NNTL_ASSERT(!"WTF? Wrong weight matrix!");
+					STDCOUTL("WTF? Wrong weight matrix @layer " << get_self().get_layer_idx() << " " << get_self().get_layer_name_str());
+					abort();
+				}
+			} else {
+				m_weights.clear();
+				if (!m_weights.resize(m_embeddingDim, m_vocabSize)) return ErrorCode::CantAllocateMemoryForWeights;
+				get_iMath().first_touch(m_weights);
+
+				m_bWeightsInitialized = true;//MUST be set prior call to reinit_weights()
+				if (!get_self().reinit_weights()) {
+					m_weights.clear();
+					m_bWeightsInitialized = false;
+					return ErrorCode::CantInitializeWeights;
+				}
+			}
+
+			lid.nParamsToLearn = get_self().bUpdateWeights() ? m_weights.numel() : 0;
+			if (get_common_data().is_training_possible()) {
+				NNTL_ASSERT(lid.outgBS.maxTrainBS > 0);
+				lid.max_dLdA_numel = realmtx_t::sNumel(lid.outgBS.maxTrainBS, get_neurons_cnt());
+			}
+
+			if (get_common_data().is_training_possible() && get_self().bUpdateWeights()) {
+				NNTL_ASSERT(lid.incBS.maxTrainBS > 0);
+				if (!get_self().get_gradWorks().is_sparse_mode_supported()) return ErrorCode::UnsupportedGradWorksSettings;
+
+				const numel_cnt_t idsNumel = realmtx_t::sNumel(lid.incBS.maxTrainBS, m_idsCnt);
+				const vec_len_t maxUsed = static_cast<vec_len_t>(::std::min(idsNumel, static_cast<numel_cnt_t>(m_vocabSize)));
+
+				if (!m_dLdWc.resize(m_embeddingDim, maxUsed)) return ErrorCode::CantAllocateMemoryForTempData;
+				m_id2slot.reset(new(::std::nothrow) vec_len_t[m_vocabSize]);
+				m_slots.reset(new(::std::nothrow) vec_len_t[idsNumel]);
+				m_cols.reset(new(::std::nothrow) vec_len_t[maxUsed]);
+				if (!m_id2slot || !m_slots || !m_cols) return ErrorCode::CantAllocateMemoryForTempData;
+				::std::fill(m_id2slot.get(), m_id2slot.get() + m_vocabSize, static_cast<vec_len_t>(invalid_slot));
+
+				if (!get_self().get_gradWorks().gw_init_sparse(get_common_data(), m_weights)) return ErrorCode::CantInitializeGradWorks;
+				get_iMath().preinit(grad_works_t::apply_grad_sparse_needTempMem(m_embeddingDim, maxUsed));
+			}
+
+			bSuccessfullyInitialized = true;
+			return ec;
+		}
+
+		void layer_deinit() noexcept {
+			get_gradWorks().gw_deinit();
+			m_dLdWc.clear();
+			m_id2slot.reset();
+			m_slots.reset();
+			m_cols.reset();
+			_base_class_t::layer_deinit();
+		}
+
+		template <typename LowerLayer>
+		void fprop(const LowerLayer& lowerLayer)noexcept {
+			static_assert(::std::is_base_of<_i_layer_fprop<real_t>, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_fprop");
+			get_self()._le_fprop(lowerLayer.get_activations());
+		}
+
+		template <typename LowerLayer>
+		unsigned bprop(realmtxdef_t& dLdA, const LowerLayer& lowerLayer, realmtx_t& dLdAPrev)noexcept {
+			static_assert(::std::is_base_of<_i_layer_trainable<real_t>, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_trainable");
+			return get_self()._le_bprop(dLdA, lowerLayer.get_activations(), is_layer_with_bprop<LowerLayer>::value, dLdAPrev);
+		}
+
+	protected:
+		void _le_fprop(const realmtx_t& ids)noexcept {
+			NNTL_ASSERT(ids.bBatchInColumn() && ids.sample_size() == m_idsCnt);
+			NNTL_ASSERT(is_activations_shared() || m_activations.test_biases_strict());
+			NNTL_ASSERT(ids.batch_size() == m_activations.batch_size());
+
+			auto& _iI = get_iInspect();
+			_iI.fprop_begin(get_layer_idx(), ids, get_common_data().is_training_mode());
+
+			get_iMath().mGatherEmbeddings(ids, m_weights, m_activations);
+
+			_iI.fprop_activations(m_activations);
+			_iI.fprop_end(m_activations);
+			m_bActivationsValid = true;
+		}
+
+		//fills m_slots/m_cols for the ids matrix and returns the number of distinct ids in it
+		vec_len_t _le_make_slots(const realmtx_t& ids)noexcept {
+			NNTL_ASSERT(ids.bBatchInColumn());
+			const numel_cnt_t ne = ids.numel_no_bias();
+			const auto pIds = ids.data();
+			const auto pId2Slot = m_id2slot.get();
+			const auto pSlots = m_slots.get();
+			const auto pCols = m_cols.get();
+
+			vec_len_t nUsed = 0;
+			for (numel_cnt_t i = 0; i < ne; ++i) {
+				const auto id = static_cast<vec_len_t>(pIds[i]);
+				NNTL_ASSERT(real_t(id) == pIds[i] && id < m_vocabSize);
+				auto& s = pId2Slot[id];
+				if (invalid_slot == s) {
+					s = nUsed;
+					pCols[nUsed++] = id;
+				}
+				pSlots[i] = s;
+			}
+			//restoring m_id2slot for the next batch
+			for (vec_len_t i = 0; i < nUsed; ++i) pId2Slot[pCols[i]] = invalid_slot;
+			return nUsed;
+		}
+
+		unsigned _le_bprop(realmtxdef_t& dLdA, const realmtx_t& ids, const bool bPrevLayerWBprop, realmtx_t& dLdAPrev)noexcept {
+			NNTL_ASSERT(m_bActivationsValid);
+			m_bActivationsValid = false;
+
+			NNTL_ASSERT(get_common_data().is_training_mode());
+			NNTL_ASSERT(ids.batch_size() == m_activations.batch_size() && ids.sample_size() == m_idsCnt);
+			NNTL_ASSERT(m_activations.size_no_bias() == dLdA.size());
+			NNTL_ASSERT(!bPrevLayerWBprop || dLdAPrev.size() == ids.size_no_bias());
+			NNTL_ASSERT_MTX_NO_NANS(dLdA);
+
+			auto& _iI = get_iInspect();
+			_iI.bprop_begin(get_layer_idx(), dLdA);
+			_iI.bprop_finaldLdA(dLdA);
+
+			//ids aren't differentiable
+			if (bPrevLayerWBprop) dLdAPrev.zeros();
+
+			if (get_self().bUpdateWeights()) {
+				NNTL_ASSERT(m_id2slot && m_slots && m_cols && !m_dLdWc.empty());
+				const auto nUsed = get_self()._le_make_slots(ids);
+				NNTL_ASSERT(nUsed > 0 && nUsed <= m_dLdWc.cols());
+
+				realmtx_t dLdWc(m_dLdWc.data(), m_embeddingDim, nUsed);
+				auto& iM = get_iMath();
+				iM.mScatterAddEmbeddingsGrad(real_t(1) / real_t(m_activations.batch_size()), dLdA, m_slots.get(), dLdWc);
+
+				get_gradWorks().apply_grad_sparse(m_weights, dLdWc, m_cols.get());
+			}
+
+			_iI.bprop_end(dLdAPrev);
+			return 1;
+		}
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	// final implementation of layer with all functionality of _LE
+	// If you need to derive a new class, derive it from _LE (to make static polymorphism work)
+	template <typename GradWorks = grad_works_noILR_LA<d_interfaces>>
+	class LE final : public _LE<LE<GradWorks>, GradWorks> {
+		typedef _LE<LE<GradWorks>, GradWorks> _base_class_t;
+	public:
+		template<typename...ArgsT>
+		LE(ArgsT&&... ar)noexcept : _base_class_t(::std::forward<ArgsT>(ar)...) {}
+	};
+
+	template <typename GradWorks = grad_works_noILR_LA<d_interfaces>>
+	using layer_embedding = typename LE<GradWorks>;
+}
@@ -105,6 +105,9 @@ namespace nntl {
 		static constexpr bool bDropoutAvailable = !is_dummy_dropout<Dropout_t>::value;
 		static_assert(bActivationPenalizationAvailable || bDropoutAvailable, "What for?");
 
+		//activation penalizers may depend on the activation matrix columns layout, that is different for the inplace tiled layer
+		static constexpr bool bTileableInplace = is_layer_tileable_inplace<_base_class_t>::value && !bActivationPenalizationAvailable;
+
 		//////////////////////////////////////////////////////////////////////////
 		//Serialization support
 	private:
@@ -126,6 +129,10 @@ namespace nntl {
 
 		static constexpr const char _defName[] = "lex";
 
+		//LI aliases its activations to the lower layer activations, dropout mustn't modify them (used by _LI only)
+		template<typename T = _base_class_t>
+		static constexpr bool _li_can_alias()noexcept { return !bDropoutAvailable && T::_li_can_alias(); }
+
 		//////////////////////////////////////////////////////////////////////////
 		//should return true, if the layer has a value to add to Loss function value (there's some regularizer attached)
 		template<bool c = bActivationPenalizationAvailable>
@@ -325,7 +332,7 @@ namespace nntl {
 	public:
 		template <typename LowerLayerT>
 		unsigned bprop(realmtxdef_t& dLdA, const LowerLayerT& lowerLayer, realmtxdef_t& dLdAPrev)noexcept {
-			static_assert(::std::is_base_of<_i_layer_trainable, LowerLayerT>::value, "Template parameter LowerLayer must implement _i_layer_trainable");
+			static_assert(::std::is_base_of<_i_layer_trainable<real_t>, LowerLayerT>::value, "Template parameter LowerLayer must implement _i_layer_trainable");
 			//NNTL_ASSERT(get_self().bDoBProp());
 
 			auto& iI = get_iInspect();
@@ -47,7 +47,8 @@ namespace nntl {
 		typedef _impl::_act_wrap<FinalPolymorphChild, InterfacesT, ActivFunc> _base_class_t;
 
 	public:
-		static_assert(bActivationForHidden, "ActivFunc template parameter should be derived from activations::_i_activation");
+		static_assert(_base_class_t::bActivationForHidden || _base_class_t::bActivationForOutput
+			, "ActivFunc template parameter should be derived from activations::_i_activation or activations::_i_activation_loss");
 
 		static constexpr const char _defName[] = "fclFP";
 		static constexpr bool bAssumeFPropOnly = bFPropOnlyInDerived;
@@ -63,6 +64,10 @@ namespace nntl {
 		//this flag controls the weights matrix initialization and prevents reinitialization on next nnet.train() calls
 		bool m_bWeightsInitialized{ false };
 
+		//number of tiles the layer processes at once when it's tiled inplace by the layer_pack_tile (see layer/pack_tile.h).
+		// When it's >1, prevAct is [m, K*p+1] and the layer's own activations are [K*m, n+1] with K [m,n] blocks layout.
+		neurons_count_t m_inplaceTiles{ 1 };
+
 		//////////////////////////////////////////////////////////////////////////
 		//Serialization support
 	private:
@@ -117,14 +122,21 @@ namespace nntl {
 			: _LFC_FProp(pCustomName, _neurons_cnt) 
 		{};
 
+		//to be called by the layer_pack_tile only, before layer initialization
+		void _lpt_tile_inplace(const neurons_count_t K)noexcept {
+			NNTL_ASSERT(K > 0);
+			m_inplaceTiles = K;
+		}
+		neurons_count_t _lpt_inplace_tiles()const noexcept { return m_inplaceTiles; }
+
 		//////////////////////////////////////////////////////////////////////////
 
 		const realmtx_t& get_weights()const noexcept { NNTL_ASSERT(m_bWeightsInitialized); return m_weights; }
 		realmtx_t& get_weights() noexcept { NNTL_ASSERT(m_bWeightsInitialized); return m_weights; }
+		bool has_weights()const noexcept { return m_bWeightsInitialized; }
 
 		bool isWeightsSuitable(const realmtx_t& W)const noexcept {
-			if (W.empty() || W.bBatchInRow() || W.emulatesBiases()
-				|| (W.cols() != get_incoming_neurons_cnt() + 1) || W.rows() != get_neurons_cnt())
+			if (W.empty() || W.bBatchInRow() || W.emulatesBiases() || W.size() != get_self()._lfc_weights_size())
 			{
 				NNTL_ASSERT(!"Wrong weight matrix passed!");
 				return false;
@@ -180,8 +192,6 @@ namespace nntl {
 			auto ec = _base_class_t::layer_init(lid, pNewActivationStorage);
 			if (ErrorCode::Success != ec) return ec;
 
-			const auto neurons_cnt = get_neurons_cnt(), incoming_neurons_cnt = get_incoming_neurons_cnt();
-
 			NNTL_ASSERT(!m_weights.emulatesBiases());
 			if (m_bWeightsInitialized) {
 				//just double check everything is fine
@@ -199,7 +209,9 @@ namespace nntl {
 				m_weights.clear();
 
 				// initializing
-				if (!m_weights.resize(neurons_cnt, incoming_neurons_cnt + 1)) return ErrorCode::CantAllocateMemoryForWeights;
+				if (!m_weights.resize(get_self()._lfc_weights_size())) return ErrorCode::CantAllocateMemoryForWeights;
+				//weights are initialized by a single thread below, but used by worker threads
+				get_iMath().first_touch(m_weights);
 
 				m_bWeightsInitialized = true;//MUST be set prior call to reinit_weights()
 				if (!get_self().reinit_weights()) {
@@ -231,7 +243,7 @@ namespace nntl {
 
 		template <typename LowerLayer>
 		void fprop(const LowerLayer& lowerLayer)noexcept {
-			static_assert(::std::is_base_of<_i_layer_fprop, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_fprop");
+			static_assert(::std::is_base_of<_i_layer_fprop<real_t>, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_fprop");
 			get_self()._lfc_fprop(lowerLayer.get_activations());
 		}
 
@@ -241,7 +253,7 @@ namespace nntl {
 		void _lfc_fprop(const realmtx_t& prevAct, const bool bWillProcessActivationsLater = false)noexcept {
 			NNTL_ASSERT(prevAct.test_biases_strict());
 			NNTL_ASSERT_MTX_NO_NANS(prevAct);
-			NNTL_ASSERT(get_incoming_neurons_cnt() == prevAct.sample_size());
+			NNTL_ASSERT(get_incoming_neurons_cnt()*m_inplaceTiles == prevAct.sample_size());
 
 			//just don't even check biases if the flag forbids it
 			NNTL_ASSERT(is_activations_shared() || bActivationForOutput != m_activations.emulatesBiases());
@@ -252,7 +264,7 @@ namespace nntl {
 			NNTL_ASSERT(prevAct.batch_size() <= m_incBS.max_bs4mode(bTrainingMode));
 			//max() here b/c we don't know how the function is used in a derived class (which BS structure to apply)
 			NNTL_ASSERT(m_activations.batch_size() <= ::std::max(m_incBS.max_bs4mode(bTrainingMode), m_outgBS.max_bs4mode(bTrainingMode)));
-			NNTL_ASSERT(prevAct.batch_size() == m_activations.batch_size());
+			NNTL_ASSERT(prevAct.batch_size()*m_inplaceTiles == m_activations.batch_size());
 
 			auto& _iI = get_iInspect();
 			_iI.fprop_begin(get_layer_idx(), prevAct, bTrainingMode);
@@ -260,7 +272,7 @@ namespace nntl {
 			//might be necessary for Nesterov momentum application
 		#pragma warning(push)
 		#pragma warning(disable : 4127) //C4127: conditional expression is constant
-			if (!bAssumeFPropOnly && bTrainingMode) get_self()._on_fprop_in_training_mode();
+			if (!bAssumeFPropOnly && bTrainingMode && !get_common_data().is_recomputing_fprop()) get_self()._on_fprop_in_training_mode();
 		#pragma warning(pop)
 
 			_iI.fprop_makePreActivations(m_weights, prevAct);
@@ -268,11 +280,11 @@ namespace nntl {
 			auto& iM = get_iMath();
 			//iM.mMulABt_Cnb(prevAct, m_weights, m_activations);
 			//note, mMul_prevAct_weights_2_act() supports bBatchInRow() for prevAct and doesn't support it for m_activations
-			iM.mMul_prevAct_weights_2_act(prevAct, m_weights, m_activations);
+			get_self()._lfc_mMul_prevAct_weights_2_act(iM, prevAct, m_weights, m_activations);
 
 			_iI.fprop_preactivations(m_activations);
 
-			_activation_fprop(iM);
+			get_self()._activation_fprop(iM);
 			_iI.fprop_activations(m_activations);
 
 			NNTL_ASSERT(prevAct.test_biases_strict());
@@ -285,6 +297,34 @@ namespace nntl {
 
 		static void _on_fprop_in_training_mode() noexcept {}
 
+		//the following functions define the shape of the weight matrix and how it's applied to the data. Derived classes
+		// may redefine them to use some other connectivity scheme (see layer/fully_connected_ensemble.h)
+		mtx_size_t _lfc_weights_size()const noexcept {
+			return mtx_size_t(get_neurons_cnt(), get_incoming_neurons_cnt() + 1);
+		}
+		// The default implementation also handles the inplace tiling (m_inplaceTiles>1), in that case the same weights are
+		// applied to each of the tiles with strided GEMMs.
+		template<typename iMathT>
+		void _lfc_mMul_prevAct_weights_2_act(iMathT& iM, const realmtx_t& prevAct, realmtxdef_t& W, realmtx_t& act)const noexcept {
+			if (m_inplaceTiles > 1) {
+				iM.mMul_prevAct_weights_2_act_tiled(m_inplaceTiles, prevAct, W, act);
+			} else iM.mMul_prevAct_weights_2_act(prevAct, W, act);
+		}
+		template<typename iMathT>
+		void _lfc_mMul_dLdZ_weights_2_dLdAPrev(iMathT& iM, const realmtx_t& dLdZ, realmtxdef_t& W, realmtx_t& dLdAPrev)const noexcept {
+			if (m_inplaceTiles > 1) {
+				iM.mMul_dLdZ_weights_2_dLdAPrev_tiled(m_inplaceTiles, dLdZ, W, dLdAPrev);
+			} else iM.mMul_dLdZ_weights_2_dLdAPrev(dLdZ, W, dLdAPrev);
+		}
+		template<typename iMathT>
+		void _lfc_mMulScaled_dLdZ_prevAct_2_dLdW(iMathT& iM, const real_t sc, const realmtx_t& dLdZ, const realmtx_t& prevAct
+			, realmtx_t& dLdW)const noexcept
+		{
+			if (m_inplaceTiles > 1) {
+				iM.mMulScaled_dLdZ_prevAct_2_dLdW_tiled(m_inplaceTiles, sc, dLdZ, prevAct, dLdW);
+			} else iM.mMulScaled_dLdZ_prevAct_2_dLdW(sc, dLdZ, prevAct, dLdW);
+		}
+
 	public:
 		template <typename LowerLayer>
 		unsigned bprop(realmtxdef_t& dLdA, const LowerLayer& lowerLayer, realmtx_t& dLdAPrev)noexcept {
@@ -313,6 +353,9 @@ namespace nntl {
 
 		static constexpr const char _defName[] = "fcl";
 
+		//the layer could be tiled by the layer_pack_tile without data rolling (see is_layer_tileable_inplace<>)
+		static constexpr bool bTileableInplace = true;
+
 		//////////////////////////////////////////////////////////////////////////
 		//members
 	protected:
@@ -399,6 +442,8 @@ namespace nntl {
 		void _on_fprop_in_training_mode()noexcept {
 			get_self().get_gradWorks().pre_training_fprop(m_weights);
 		}
+		//called right after the gradient has been applied to the weights (see layer/fully_connected_pruned.h)
+		static void _lfc_on_weights_updated()noexcept {}
 
 	protected:
 
@@ -413,7 +458,7 @@ namespace nntl {
 			NNTL_ASSERT(get_common_data().is_training_mode());
 			NNTL_ASSERT(prevAct.batch_size() <= m_incBS.maxTrainBS);
 			NNTL_ASSERT(m_activations.batch_size() <= m_outgBS.maxTrainBS);
-			NNTL_ASSERT(prevAct.batch_size() == m_activations.batch_size());
+			NNTL_ASSERT(prevAct.batch_size()*m_inplaceTiles == m_activations.batch_size());
 
 			NNTL_ASSERT_MTX_NO_NANS(dLdA);
 			NNTL_ASSERT_MTX_NO_NANS(prevAct);
@@ -422,7 +467,7 @@ namespace nntl {
 			dLdA.assert_storage_does_not_intersect(dLdAPrev);
 			NNTL_ASSERT(prevAct.emulatesBiases() && (is_activations_shared() || bActivationForOutput != m_activations.emulatesBiases()));
 			NNTL_ASSERT(m_activations.size_no_bias() == dLdA.size());
-			NNTL_ASSERT(get_incoming_neurons_cnt() == prevAct.sample_size());
+			NNTL_ASSERT(get_incoming_neurons_cnt()*m_inplaceTiles == prevAct.sample_size());
 			NNTL_ASSERT(!bPrevLayerWBprop || dLdAPrev.size() == prevAct.size_no_bias());//in vanilla simple BP we shouldn't calculate dLdAPrev for the first layer			
 			NNTL_ASSERT(!bPrevLayerWBprop || dLdAPrev.bBatchInRow() == prevAct.bBatchInRow());
 
@@ -442,7 +487,7 @@ namespace nntl {
 			//     in a fastest way possible... Anyway, it's not the main issue now and just having bBatchInRow() for previous
 			//     activations only is fine.
 			NNTL_ASSERT(m_activations.bBatchInColumn() && dLdA.bBatchInColumn());
-			realmtx_t dLdZ(m_activations.data(), m_activations, realmtx_t::tag_noBias());
+			realmtx_t dLdZ(m_activations.data(), m_activations, math::tag_noBias());
 
 			auto& iM = get_iMath();
 
@@ -481,7 +526,7 @@ namespace nntl {
 				// m_weights.hide_last_col();
 				// iM.mMulAB_C(dLdZ, m_weights, dLdAPrev);
 				// m_weights.restore_last_col();//restore weights back
-				iM.mMul_dLdZ_weights_2_dLdAPrev(dLdZ, m_weights, dLdAPrev);
+				get_self()._lfc_mMul_dLdZ_weights_2_dLdAPrev(iM, dLdZ, m_weights, dLdAPrev);
 			}
 
 			if (get_self().bUpdateWeights()) {
@@ -499,7 +544,7 @@ namespace nntl {
 				// that we've set to fit m_weights during layer_init()
 				
 				// #TODO support bBatchInRow for dLdZ!!!
-				iM.mMulScaled_dLdZ_prevAct_2_dLdW(
+				get_self()._lfc_mMulScaled_dLdZ_prevAct_2_dLdW(iM,
 					//(inspector::is_gradcheck_inspector<iInspect_t>::value ? real_t(1) : m_nTiledTimes) / real_t(m_activations.batch_size())
 					real_t(1) / real_t(m_activations.batch_size())
 					, dLdZ, prevAct, dLdW);
@@ -508,6 +553,7 @@ namespace nntl {
 
 				//now we can apply gradient to the weights
 				get_gradWorks().apply_grad(m_weights, dLdW);
+				get_self()._lfc_on_weights_updated();
 				//and restoring dLdA==dLdW size back (probably we can even skip this step, however, it's cheap and it's better to make it)
 				dLdW.deform_like_no_bias(m_activations);
 			}
@@ -522,7 +568,7 @@ namespace nntl {
 
 		template <typename LowerLayer>
 		unsigned bprop(realmtxdef_t& dLdA, const LowerLayer& lowerLayer, realmtx_t& dLdAPrev)noexcept {
-			static_assert(::std::is_base_of<_i_layer_trainable, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_trainable");
+			static_assert(::std::is_base_of<_i_layer_trainable<real_t>, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_trainable");
 			//NNTL_ASSERT(get_self().bDoBProp());
 			return get_self()._lfc_bprop(dLdA, lowerLayer.get_activations(), is_layer_with_bprop<LowerLayer>::value, dLdAPrev);
 		}
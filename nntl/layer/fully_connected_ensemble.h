@@ -0,0 +1,321 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "output.h"
+
+//Ensemble-packed variants of the fully connected and output layers.
+//
+//Training K same-shaped small nets one after another (or even simultaneously, see population_trainer.h) uses the hardware
+// poorly, because their matrices are too small for BLAS to be efficient. The layers here stack the weights of K members
+// of an ensemble into a single weight matrix [K*n, p+1] (rows k*n..k*n+n-1 belong to member k) and the activations of all
+// members into a single activation matrix [bs, K*n] (columns k*n..k*n+n-1 belong to member k), so the whole ensemble
+// becomes a single (though wider) nnet:
+//	- an ensemble layer on top of an ordinary layer (the input layer, for example) feeds the same input to every member.
+//		That's exactly the plain LFC with K*n neurons, so fprop() as well as each of bprop() products are single GEMMs.
+//	- an ensemble layer constructed with bMemberwiseInput==true must be placed on top of another ensemble layer with the
+//		same members count. It connects member k only to the k-th block of the lower layer activations (that's a
+//		block-diagonal weight matrix stored densely as [K*n, p+1]). OpenBLAS has no batched gemm, so it's K GEMMs issued
+//		with proper strides and no data copying (see iMath::mMul_*_mw() functions).
+//	- layer_output_ensemble applies the activation and the loss function to each member's block separately against the
+//		same data_y. Loss value reported to nnet is the average of the members losses.
+//		Use eval_ensemble from nnet_evaluator.h to get both the per-member and the averaged predictions quality.
+//
+//Every element of grad_works state (momentums, RMSProp accumulators and so on) corresponds to a single element of the
+// weight matrix and the rest of grad_works machinery (max-norm, etc) works per neuron (i.e. per row), therefore a single
+// grad_works object effectively keeps an independent state for every member. Hyperparameters however are common for all
+// members (use population_trainer if you need members with different hyperparameters). Loss addendums of regularizers
+// are summed over all members.
+//Activation function of a hidden ensemble layer is applied to the whole activation matrix at once, so it must be an
+// elementwise one. The output layer processes members separately, so softmax is fine there.
+//
+//Usage:
+//	layer_input<> inp(td.train_x().cols_no_bias());
+//	LFCE<activation::relu<real_t>> fcl1(K, 100, learningRate);
+//	LFCE<activation::relu<real_t>> fcl2(K, 50, learningRate, true);
+//	layer_output_ensemble<activation::softmax_xentropy_loss<real_t>> outp(K, td.train_y().cols(), learningRate, true);
+
+namespace nntl {
+
+	namespace _impl {
+
+		//adds an ensemble packing to _LFC or _layer_output based layers
+		template<typename BaseT>
+		class _ensemble_packed
+			: public m_layer_ensemble
+			, public BaseT
+		{
+		private:
+			typedef BaseT _base_class_t;
+
+		public:
+			using typename _base_class_t::real_t;
+			using typename _base_class_t::realmtx_t;
+			using typename _base_class_t::realmtxdef_t;
+			using typename _base_class_t::mtx_size_t;
+			using typename _base_class_t::_layer_init_data_t;
+			typedef typename _base_class_t::ErrorCode ErrorCode;
+
+			//ensemble members have own weights, so the layer can't be tiled inplace
+			static constexpr bool bTileableInplace = false;
+
+		protected:
+			const vec_len_t m_membersCnt;
+			//when set, member k is connected only to the k-th part of the lower layer activations
+			const bool m_bMemberwiseInput;
+
+		protected:
+			~_ensemble_packed()noexcept {}
+
+			_ensemble_packed(const char* pCustomName, const vec_len_t membersCnt, const neurons_count_t neuronsPerMember
+				, const real_t learningRate, const bool bMemberwiseInput)noexcept
+				: _base_class_t(pCustomName, membersCnt*neuronsPerMember, learningRate)
+				, m_membersCnt(membersCnt), m_bMemberwiseInput(bMemberwiseInput)
+			{
+				NNTL_ASSERT(membersCnt > 0 && neuronsPerMember > 0);
+			}
+
+			template<typename LayerT>
+			static ::std::enable_if_t<is_layer_ensemble<LayerT>::value, vec_len_t> _members_of(const LayerT& l)noexcept {
+				return l.ensemble_members_count();
+			}
+			template<typename LayerT>
+			static ::std::enable_if_t<!is_layer_ensemble<LayerT>::value, vec_len_t> _members_of(const LayerT&)noexcept { return 0; }
+
+			template<typename LowerLayer>
+			void _check_lower_layer(const LowerLayer& lowerLayer)const noexcept {
+				NNTL_UNREF(lowerLayer);
+				NNTL_ASSERT(!m_bMemberwiseInput || _members_of(lowerLayer) == m_membersCnt
+					|| !"Member-wise input requires the lower layer to be an ensemble layer with the same members count");
+			}
+
+			//makes a view of member's part of activations (or dLdZ) matrix
+			realmtx_t _member_view(const realmtx_t& A, const vec_len_t k)const noexcept {
+				NNTL_ASSERT(A.bBatchInColumn() && k < m_membersCnt);
+				const auto n = member_neurons_cnt();
+				return realmtx_t(const_cast<real_t*>(A.colDataAsVec(k*n)), A.rows(), n);
+			}
+
+		public:
+			vec_len_t ensemble_members_count()const noexcept { return m_membersCnt; }
+			neurons_count_t member_neurons_cnt()const noexcept { return get_neurons_cnt() / m_membersCnt; }
+			bool is_memberwise_input()const noexcept { return m_bMemberwiseInput; }
+
+			//every member gets its weights initialized independently as if it was a standalone layer (that's
+			// important for initialization schemes that depend on the fan-in/fan-out)
+			bool reinit_weights()noexcept {
+				NNTL_ASSERT(m_bWeightsInitialized || !"reinit_weights() can only be called after layer_init()!");
+				NNTL_ASSERT(get_self().isWeightsSuitable(m_weights) || !"WTF?! Wrong state of weight matrix");
+
+				const auto n = member_neurons_cnt();
+				const auto wCols = m_weights.cols();
+				realmtx_t W(n, wCols);
+				if (W.isAllocationFailed()) return false;
+
+				auto& wInit = get_self().get_activation_obj().get_weightsInit();
+				for (vec_len_t k = 0; k < m_membersCnt; ++k) {
+					if (!wInit.make_weights(W, get_iRng(), get_iMath())) return false;
+					for (vec_len_t c = 0; c < wCols; ++c) {
+						const auto pSrc = W.colDataAsVec(c);
+						::std::copy(pSrc, pSrc + n, m_weights.colDataAsVec(c) + k*n);
+					}
+				}
+				return true;
+			}
+
+			ErrorCode layer_init(_layer_init_data_t& lid)noexcept {
+				if (m_bMemberwiseInput && 0 != get_incoming_neurons_cnt() % m_membersCnt) {
+					STDCOUTL("Incoming neurons count of member-wise ensemble layer " << get_self().get_layer_name_str()
+						<< " must be divisible by the members count!");
+					return ErrorCode::InvalidEnsembleIncomingNeuronsCount;
+				}
+				return _base_class_t::layer_init(lid);
+			}
+
+			template <typename LowerLayer>
+			void fprop(const LowerLayer& lowerLayer)noexcept {
+				_check_lower_layer(lowerLayer);
+				_base_class_t::fprop(lowerLayer);
+			}
+
+			//////////////////////////////////////////////////////////////////////////
+			// _LFC_FProp hooks
+			mtx_size_t _lfc_weights_size()const noexcept {
+				return mtx_size_t(get_neurons_cnt()
+					, (m_bMemberwiseInput ? get_incoming_neurons_cnt() / m_membersCnt : get_incoming_neurons_cnt()) + 1);
+			}
+			template<typename iMathT>
+			void _lfc_mMul_prevAct_weights_2_act(iMathT& iM, const realmtx_t& prevAct, realmtxdef_t& W, realmtx_t& act)const noexcept {
+				if (m_bMemberwiseInput) {
+					iM.mMul_prevAct_weights_2_act_mw(m_membersCnt, prevAct, W, act);
+				} else iM.mMul_prevAct_weights_2_act(prevAct, W, act);
+			}
+			template<typename iMathT>
+			void _lfc_mMul_dLdZ_weights_2_dLdAPrev(iMathT& iM, const realmtx_t& dLdZ, realmtxdef_t& W, realmtx_t& dLdAPrev)const noexcept {
+				if (m_bMemberwiseInput) {
+					iM.mMul_dLdZ_weights_2_dLdAPrev_mw(m_membersCnt, dLdZ, W, dLdAPrev);
+				} else iM.mMul_dLdZ_weights_2_dLdAPrev(dLdZ, W, dLdAPrev);
+			}
+			template<typename iMathT>
+			void _lfc_mMulScaled_dLdZ_prevAct_2_dLdW(iMathT& iM, const real_t sc, const realmtx_t& dLdZ, const realmtx_t& prevAct
+				, realmtx_t& dLdW)const noexcept
+			{
+				if (m_bMemberwiseInput) {
+					iM.mMulScaled_dLdZ_prevAct_2_dLdW_mw(m_membersCnt, sc, dLdZ, prevAct, dLdW);
+				} else iM.mMulScaled_dLdZ_prevAct_2_dLdW(sc, dLdZ, prevAct, dLdW);
+			}
+		};
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// hidden ensemble-packed fully connected layer
+	template<typename FinalPolymorphChild, typename ActivFunc, typename GradWorks>
+	class _LFCE : public _impl::_ensemble_packed<_LFC<FinalPolymorphChild, ActivFunc, GradWorks>> {
+	private:
+		typedef _impl::_ensemble_packed<_LFC<FinalPolymorphChild, ActivFunc, GradWorks>> _base_class_t;
+
+	public:
+		static constexpr const char _defName[] = "fcle";
+
+		~_LFCE()noexcept {}
+		_LFCE(const char* pCustomName, const vec_len_t membersCnt, const neurons_count_t neuronsPerMember
+			, const real_t learningRate = real_t(.01), const bool bMemberwiseInput = false)noexcept
+			: _base_class_t(pCustomName, membersCnt, neuronsPerMember, learningRate, bMemberwiseInput)
+		{}
+		_LFCE(const vec_len_t membersCnt, const neurons_count_t neuronsPerMember, const real_t learningRate = real_t(.01)
+			, const bool bMemberwiseInput = false, const char* pCustomName = nullptr)noexcept
+			: _LFCE(pCustomName, membersCnt, neuronsPerMember, learningRate, bMemberwiseInput)
+		{}
+
+		ErrorCode layer_init(_layer_init_data_t& lid, real_t*const pNewActivationStorage = nullptr)noexcept {
+			NNTL_ASSERT(!pNewActivationStorage || !"Ensemble layers doesn't support external activation storage");
+			NNTL_UNREF(pNewActivationStorage);
+			return _base_class_t::layer_init(lid);
+		}
+	};
+
+	template <typename ActivFunc = activation::sigm<d_interfaces::real_t>
+		, typename GradWorks = grad_works<d_interfaces>
+	> class LFCE final : public _LFCE<LFCE<ActivFunc, GradWorks>, ActivFunc, GradWorks>
+	{
+		typedef _LFCE<LFCE<ActivFunc, GradWorks>, ActivFunc, GradWorks> _base_class_t;
+	public:
+		template<typename...ArgsT>
+		LFCE(ArgsT&&... ar)noexcept : _base_class_t(::std::forward<ArgsT>(ar)...) {}
+	};
+
+	template <typename ActivFunc = activation::sigm<d_interfaces::real_t>,
+		typename GradWorks = grad_works<d_interfaces>
+	> using layer_fully_connected_ensemble = typename LFCE<ActivFunc, GradWorks>;
+
+	//////////////////////////////////////////////////////////////////////////
+	// ensemble-packed output layer. Every member is trained against the same data_y, so the layer expects data_y of
+	// member_neurons_cnt() width, while its activations are ensemble_members_count() times wider.
+	template<typename FinalPolymorphChild, typename ActivFunc, typename GradWorks>
+	class _layer_output_ensemble : public _impl::_ensemble_packed<_layer_output<FinalPolymorphChild, ActivFunc, GradWorks>> {
+	private:
+		typedef _impl::_ensemble_packed<_layer_output<FinalPolymorphChild, ActivFunc, GradWorks>> _base_class_t;
+
+	public:
+		static constexpr const char _defName[] = "outpe";
+
+		~_layer_output_ensemble()noexcept {}
+		_layer_output_ensemble(const char* pCustomName, const vec_len_t membersCnt, const neurons_count_t neuronsPerMember
+			, const real_t learningRate = real_t(.01), const bool bMemberwiseInput = false)noexcept
+			: _base_class_t(pCustomName, membersCnt, neuronsPerMember, learningRate, bMemberwiseInput)
+		{}
+		_layer_output_ensemble(const vec_len_t membersCnt, const neurons_count_t neuronsPerMember, const real_t learningRate = real_t(.01)
+			, const bool bMemberwiseInput = false, const char* pCustomName = nullptr)noexcept
+			: _layer_output_ensemble(pCustomName, membersCnt, neuronsPerMember, learningRate, bMemberwiseInput)
+		{}
+
+		neurons_count_t get_data_y_width()const noexcept { return member_neurons_cnt(); }
+
+		//returns a view of k-th member's predictions (valid while the activations are valid)
+		realmtx_t get_member_activations(const vec_len_t k)const noexcept {
+			NNTL_ASSERT(m_bActivationsValid);
+			return _member_view(m_activations, k);
+		}
+
+		//the average of members losses
+		template<typename YT>
+		real_t calc_loss(const math::smatrix<YT>& data_y)const noexcept {
+			NNTL_ASSERT(data_y.cols() == member_neurons_cnt());
+			real_t l(0);
+			for (vec_len_t k = 0; k < m_membersCnt; ++k) {
+				l += get_self().get_activation_obj().loss(_member_view(m_activations, k), data_y, get_iMath());
+			}
+			return l / m_membersCnt;
+		}
+
+		//the following two functions are called by base classes instead of _act_wrap versions to process each member
+		// separately
+		template<typename iMathT>
+		void _activation_fprop(iMathT& iM)noexcept {
+			NNTL_ASSERT_MTX_NO_NANS(m_activations);
+			if (!get_self().bIgnoreActivation()) {
+				for (vec_len_t k = 0; k < m_membersCnt; ++k) {
+					auto mAct = _member_view(m_activations, k);
+					get_self().get_activation_obj().f(mAct, iM);
+				}
+				NNTL_ASSERT_MTX_NO_NANS(m_activations);
+			}
+		}
+
+		template<typename YT, typename iMathT>
+		void _activation_bprop_output(const math::smatrix<YT>& data_y, iMathT& iM)noexcept {
+			NNTL_ASSERT(!m_activations.emulatesBiases() && !data_y.emulatesBiases());
+			NNTL_ASSERT(data_y.cols() == member_neurons_cnt() && data_y.rows() == m_activations.rows());
+			const bool bIgnore = get_self().bIgnoreActivation();
+			for (vec_len_t k = 0; k < m_membersCnt; ++k) {
+				auto mAct = _member_view(m_activations, k);
+				if (bIgnore) {
+					get_self().get_activation_obj().dLdZIdentity(data_y, mAct, iM);
+				} else {
+					get_self().get_activation_obj().dLdZ(data_y, mAct, iM);
+				}
+			}
+			NNTL_ASSERT(m_activations.test_noNaNs());
+		}
+	};
+
+	template <typename ActivFunc = activation::sigm_quad_loss<d_interfaces::real_t>,
+		typename GradWorks = grad_works<d_interfaces>
+	> class layer_output_ensemble final : public _layer_output_ensemble<layer_output_ensemble<ActivFunc, GradWorks>, ActivFunc, GradWorks>
+	{
+		typedef _layer_output_ensemble<layer_output_ensemble<ActivFunc, GradWorks>, ActivFunc, GradWorks> _base_class_t;
+	public:
+		template<typename...ArgsT>
+		layer_output_ensemble(ArgsT&&... ar)noexcept : _base_class_t(::std::forward<ArgsT>(ar)...) {}
+	};
+
+}
@@ -0,0 +1,495 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+// LFCLR is a fully connected layer with a weight matrix W[n,p+1] parameterized by a product of two low rank factors W=U*V,
+// where U is [n,r+1] and V is [r,p+1] (n is the neurons count, p is the incoming neurons count and r is the rank).
+// W is never materialized: preactivations are computed as Z = [(A*V')|1]*U', i.e. the layer is just the same as two stacked
+// LFCs where the lower one has r neurons with identity activation, and the bias of the original layer is the last column of U.
+// The bottleneck biases (the last column of V) start from zeros and are learned as any other weight. They are redundant
+// (U's bias column could absorb them), but that keeps both products in the LFC layout.
+// For a square layer of n neurons it takes 2*r*(2n+1) flops per sample instead of 2*n*(n+1) (~8x less for n=4096 and r=256)
+// and the same holds for the weights memory and the bprop() costs.
+//
+// U and V have their own grad_works objects (and therefore their own optimizer states). get_gradWorks() returns the one of U,
+// that defines the learning rate for both factors (so the usual learning rate schedules work), other settings of the second
+// one should be set with get_gradWorksV().
+// U and V are also available as weights blocks wb_U and wb_V (see layer_has_weights_blocks in layer/_layer_base.h), so
+// checkpoints, data parallel training and the numeric gradient check process both factors and their optimizer states.
+//
+// Weights can be initialized from an existing (trained) weights matrix of the same shape LFC would have with
+// set_weights_factorized(), that computes the best rank r approximation of it with the SVD (it uses iMath's temporary
+// storage, so call iM.preinit(set_weights_factorized_needTempMem()) and iM.init() first).
+// By default the factors are drawn directly (see reinit_weights()): V is a random projection that preserves the scale of
+// the input and U is gaussian with the variance chosen to make U*V entries have the same second moment, as the
+// activation's weights initialization scheme gives to the LFC weights (it's estimated on a few rows made by the scheme, so a scheme that depends
+// on the neurons count, such as Xavier, sees at most 32 of them).
+// The scheme's bias value goes to the bias column of U.
+//
+// The layer isn't marked with m_layer_learnable for the same reasons as LE (see layer/embedding.h)
+
+#include "_activation_wrapper.h"
+#include "../interface/rng/distr_normal_naive.h"
+
+namespace nntl {
+
+	template<typename FinalPolymorphChild, typename ActivFunc, typename GradWorks>
+	class _LFCLR : public _impl::_act_wrap<FinalPolymorphChild, typename GradWorks::interfaces_t, ActivFunc> {
+	private:
+		typedef _impl::_act_wrap<FinalPolymorphChild, typename GradWorks::interfaces_t, ActivFunc> _base_class_t;
+
+	public:
+		static_assert(_base_class_t::bActivationForHidden, "ActivFunc template parameter should be derived from activations::_i_activation");
+
+		typedef GradWorks grad_works_t;
+		static_assert(::std::is_base_of<_impl::_i_grad_works<real_t>, grad_works_t>::value, "GradWorks template parameter should be derived from _i_grad_works");
+
+		static constexpr const char _defName[] = "fclr";
+
+		//weights blocks
+		enum WeightsBlocks { wb_U = 0, wb_V };
+		static constexpr unsigned weights_blocks_cnt = 2;
+
+		//////////////////////////////////////////////////////////////////////////
+		//members
+	protected:
+		// U: <neurons_cnt rows> x <rank + 1(bias) cols>, V: <rank rows> x <incoming_neurons_cnt + 1(bias) cols>
+		realmtxdef_t m_U, m_V;
+
+		// activations of the bottleneck (A*V') with biases: <batch_size rows> x <rank+1 cols>
+		realmtxdef_t m_H;
+		// dL/dH storage for bprop(): <max train batch_size rows> x <rank cols>
+		realmtxdef_t m_dLdH;
+
+		grad_works_t m_gradientWorks, m_gradientWorksV;
+
+		const neurons_count_t m_rank;
+
+		//rows of the weights matrix reinit_weights() makes with the activation's scheme to estimate the weights scale
+		static constexpr neurons_count_t _lfclr_probe_rows = 32;
+
+		bool m_bWeightsInitialized{ false };
+
+		//////////////////////////////////////////////////////////////////////////
+		//Serialization support
+	private:
+		friend class ::boost::serialization::access;
+		template<class Archive>
+		void save(Archive & ar, const unsigned int version) const {
+			NNTL_UNREF(version);
+			if (utils::binary_option<true>(ar, serialization::serialize_activations)) ar & NNTL_SERIALIZATION_NVP(m_activations);
+			if (utils::binary_option<true>(ar, serialization::serialize_weights)) {
+				ar & NNTL_SERIALIZATION_NVP(m_U);
+				ar & NNTL_SERIALIZATION_NVP(m_V);
+			}
+			if (utils::binary_option<true>(ar, serialization::serialize_grad_works)) {
+				ar & m_gradientWorks;
+				ar & m_gradientWorksV;
+			}
+		}
+
+		template<class Archive>
+		void load(Archive & ar, const unsigned int version) {
+			NNTL_UNREF(version);
+			if (utils::binary_option<true>(ar, serialization::serialize_weights)) {
+				realmtx_t U, V;
+				ar & serialization::make_nvp("m_U", U);
+				if (ar.success()) ar & serialization::make_nvp("m_V", V);
+				if (ar.success()) {
+					if (!get_self().set_weights(::std::move(U), ::std::move(V))) {
+						STDCOUTL("*** Failed to absorb read weights for layer " << get_self().get_layer_name_str());
+						ar.mark_invalid_var();
+					}
+				} else {
+					STDCOUTL("*** Failed to read weights for layer " << get_self().get_layer_name_str()
+						<< ", " << ar.get_last_error_str());
+				}
+			}
+		}
+		BOOST_SERIALIZATION_SPLIT_MEMBER();
+
+	protected:
+		friend class _impl::_preinit_layers;
+		void _preinit_layer(_impl::init_layer_index& ili, const neurons_count_t inc_neurons_cnt)noexcept {
+			NNTL_ASSERT(0 < inc_neurons_cnt);
+			_base_class_t::_preinit_layer(ili, inc_neurons_cnt);
+			NNTL_ASSERT(get_layer_idx() > 0);
+			NNTL_ASSERT(m_rank <= ::std::min(get_neurons_cnt(), inc_neurons_cnt) || !"Rank is too big for the layer");
+		}
+
+	public:
+		~_LFCLR() noexcept {};
+		_LFCLR(const char* pCustomName, const neurons_count_t _neurons_cnt, const neurons_count_t _rank
+			, const real_t learningRate = real_t(.01))noexcept
+			: _base_class_t(_neurons_cnt, pCustomName), m_gradientWorks(learningRate), m_gradientWorksV(learningRate), m_rank(_rank)
+		{
+			NNTL_ASSERT(_neurons_cnt > 0 && _rank > 0);
+			NNTL_ASSERT(m_activations.emulatesBiases());
+			m_H.emulate_biases(true);
+		};
+		_LFCLR(const neurons_count_t _neurons_cnt, const neurons_count_t _rank, const real_t learningRate = real_t(.01)
+			, const char* pCustomName = nullptr)noexcept
+			: _LFCLR(pCustomName, _neurons_cnt, _rank, learningRate)
+		{};
+
+		neurons_count_t get_rank()const noexcept { return m_rank; }
+
+		grad_works_t& get_gradWorks()noexcept { return m_gradientWorks; }
+		const grad_works_t& get_gradWorks()const noexcept { return m_gradientWorks; }
+		grad_works_t& get_gradWorksV()noexcept { return m_gradientWorksV; }
+		const grad_works_t& get_gradWorksV()const noexcept { return m_gradientWorksV; }
+
+		grad_works_t& get_gradWorks_block(const unsigned b)noexcept {
+			NNTL_ASSERT(b < weights_blocks_cnt);
+			return wb_U == b ? m_gradientWorks : m_gradientWorksV;
+		}
+		const grad_works_t& get_gradWorks_block(const unsigned b)const noexcept {
+			NNTL_ASSERT(b < weights_blocks_cnt);
+			return wb_U == b ? m_gradientWorks : m_gradientWorksV;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		const realmtx_t& get_U()const noexcept { NNTL_ASSERT(m_bWeightsInitialized); return m_U; }
+		const realmtx_t& get_V()const noexcept { NNTL_ASSERT(m_bWeightsInitialized); return m_V; }
+		bool has_weights()const noexcept { return m_bWeightsInitialized; }
+
+		const realmtx_t& get_weights_block(const unsigned b)const noexcept {
+			NNTL_ASSERT(m_bWeightsInitialized && b < weights_blocks_cnt);
+			return wb_U == b ? m_U : m_V;
+		}
+		realmtx_t& get_weights_block(const unsigned b)noexcept {
+			NNTL_ASSERT(m_bWeightsInitialized && b < weights_blocks_cnt);
+			return wb_U == b ? m_U : m_V;
+		}
+
+		mtx_size_t _lfclr_U_size()const noexcept { return mtx_size_t(get_neurons_cnt(), m_rank + 1); }
+		mtx_size_t _lfclr_V_size()const noexcept { return mtx_size_t(m_rank, get_incoming_neurons_cnt() + 1); }
+
+		bool isWeightsSuitable(const realmtx_t& U, const realmtx_t& V)const noexcept {
+			if (U.empty() || U.bBatchInRow() || U.emulatesBiases() || U.size() != get_self()._lfclr_U_size()
+				|| V.empty() || V.bBatchInRow() || V.emulatesBiases() || V.size() != get_self()._lfclr_V_size())
+			{
+				NNTL_ASSERT(!"Wrong weight matrices passed!");
+				return false;
+			}
+			NNTL_ASSERT(U.test_noNaNs() && V.test_noNaNs());
+			return true;
+		}
+
+		//note: it should be called after assembling layers into a layer_pack, b/c it requires _incoming_neurons_cnt
+		bool set_weights(realmtx_t&& U, realmtx_t&& V)noexcept {
+			if (!get_self().isWeightsSuitable(U, V)) return false;
+			get_self().drop_weights();
+
+			m_U = ::std::move(U);
+			m_V = ::std::move(V);
+			m_bWeightsInitialized = true;
+			return true;
+		}
+		//pW[wb_U] and pW[wb_V] are copied
+		bool set_weights_blocks(const realmtx_t* pW)noexcept {
+			NNTL_ASSERT(pW);
+			realmtx_t U, V;
+			if (!pW[wb_U].clone_to(U) || !pW[wb_V].clone_to(V)) return false;
+			return get_self().set_weights(::std::move(U), ::std::move(V));
+		}
+
+		//the size of iMath's temporary storage set_weights_factorized() needs
+		numel_cnt_t set_weights_factorized_needTempMem()const noexcept {
+			return iMath_t::mSVD_Factorize_needTempMem(get_neurons_cnt(), get_incoming_neurons_cnt());
+		}
+
+		//makes the factors from the weights matrix W of the LFC layout [neurons_cnt, incoming_neurons_cnt+1] with the truncated
+		// SVD. The bias column of W goes to the bias column of U as is.
+		//note: it should be called after assembling layers into a layer_pack, b/c it requires _incoming_neurons_cnt
+		//It's the caller's responsibility to execute iM.preinit(set_weights_factorized_needTempMem()) and iM.init() first.
+		bool set_weights_factorized(const realmtx_t& W, iMath_t& iM)noexcept {
+			const auto nc = get_neurons_cnt(), inc = get_incoming_neurons_cnt();
+			if (W.empty() || W.bBatchInRow() || W.emulatesBiases() || W.size() != mtx_size_t(nc, inc + 1)) {
+				NNTL_ASSERT(!"Wrong weight matrix passed!");
+				return false;
+			}
+
+			realmtx_t U(get_self()._lfclr_U_size()), V(get_self()._lfclr_V_size()), Wc(nc, inc);
+			if (U.isAllocationFailed() || V.isAllocationFailed() || Wc.isAllocationFailed()) return false;
+			::std::memcpy(Wc.data(), W.data(), sizeof(real_t)*Wc.numel());
+
+			//the first columns of U and V are contiguous, so the factors could be made in place. Bottleneck biases are zeros.
+			realmtx_t Ur(U.data(), nc, m_rank), Vr(V.data(), m_rank, inc);
+			if (!iM.mSVD_Factorize_ss(Wc, Ur, Vr)) return false;
+			V.fill_column_with(inc, real_t(0));
+			::std::memcpy(U.colDataAsVec(m_rank), W.colDataAsVec(inc), sizeof(real_t)*nc);
+
+			return get_self().set_weights(::std::move(U), ::std::move(V));
+		}
+		//works only after layer_init()
+		bool set_weights_factorized(const realmtx_t& W)noexcept {
+			return get_self().set_weights_factorized(W, get_iMath());
+		}
+
+		bool reinit_weights()noexcept {
+			NNTL_ASSERT(m_bWeightsInitialized || !"reinit_weights() can only be called after layer_init()!");
+			const auto nc = get_neurons_cnt(), inc = get_incoming_neurons_cnt();
+
+			//the second moment of weights and the mean bias the activation's scheme makes for the LFC of the same shape.
+			// A few rows are enough, the full matrix is never made
+			realmtx_t probe(::std::min(nc, _lfclr_probe_rows), inc + 1);
+			if (probe.isAllocationFailed()) return false;
+			if (!get_self().get_activation_obj().get_weightsInit().make_weights(probe, get_iRng(), get_iMath())) return false;
+			ext_real_t sqSum = 0, bSum = 0;
+			const auto pP = probe.data();
+			const numel_cnt_t wNumel = realmtx_t::sNumel(probe.rows(), inc);
+			for (numel_cnt_t i = 0; i < wNumel; ++i) sqSum += static_cast<ext_real_t>(pP[i])*pP[i];
+			for (numel_cnt_t i = wNumel; i < probe.numel(); ++i) bSum += pP[i];
+
+			realmtx_t U(get_self()._lfclr_U_size()), V(get_self()._lfclr_V_size());
+			if (U.isAllocationFailed() || V.isAllocationFailed()) return false;
+
+			//V: N(0,1/inc), so the bottleneck keeps the scale of the input. Bottleneck biases are zeros
+			if (!weights_init::He_Zhang2<1000000>::make_weights(V, get_iRng(), get_iMath())) return false;
+
+			//U: Var(U*V) = rank*Var(U)/inc must be equal to the scheme's second moment
+			const real_t stdDev = static_cast<real_t>(::std::sqrt(sqSum*inc / (static_cast<ext_real_t>(wNumel)*m_rank)));
+			rng::distr_normal_naive<iRng_t> d(get_iRng(), real_t(0), stdDev);
+			d.gen_vector(U.data(), realmtx_t::sNumel(nc, m_rank));
+			U.fill_column_with(m_rank, static_cast<real_t>(bSum / probe.rows()));
+
+			return get_self().set_weights(::std::move(U), ::std::move(V));
+		}
+
+		void drop_weights()noexcept {
+			m_U.clear();
+			m_V.clear();
+			m_bWeightsInitialized = false;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+
+		ErrorCode layer_init(_layer_init_data_t& lid, real_t*const pNewActivationStorage = nullptr)noexcept {
+			bool bSuccessfullyInitialized = false;
+			utils::scope_exit onExit([&bSuccessfullyInitialized, this]() {
+				if (!bSuccessfullyInitialized) get_self().layer_deinit();
+			});
+
+			auto ec = _base_class_t::layer_init(lid, pNewActivationStorage);
+			if (ErrorCode::Success != ec) return ec;
+
+			if (m_bWeightsInitialized) {
+				if (!get_self().isWeightsSuitable(m_U, m_V)) {
+					NNTL_ASSERT(!"WTF? Wrong weight matrices!");
+					STDCOUTL("WTF? Wrong weight matrices @layer " << get_self().get_layer_idx() << " " << get_self().get_layer_name_str());
+					abort();
+				}
+			} else {
+				m_bWeightsInitialized = true;//MUST be set prior call to reinit_weights()
+				if (!get_self().reinit_weights()) {
+					get_self().drop_weights();
+					return ErrorCode::CantInitializeWeights;
+				}
+			}
+
+			if (!m_H.resize_as_dataset(lid.incBS.biggest(), m_rank)) return ErrorCode::CantAllocateMemoryForInnerActivations;
+			get_iMath().first_touch(m_H);
+
+			const numel_cnt_t prmsNumel = get_self().bUpdateWeights() ? m_U.numel() + m_V.numel() : 0;
+			lid.nParamsToLearn = prmsNumel;
+
+			if (get_common_data().is_training_possible()) {
+				NNTL_ASSERT(lid.outgBS.maxTrainBS > 0);
+				//dLdA is reused to compute dL/dU and dL/dV
+				lid.max_dLdA_numel = ::std::max({ realmtx_t::sNumel(lid.outgBS.maxTrainBS, get_neurons_cnt())
+					, get_self().bUpdateWeights() ? m_U.numel() : 0, get_self().bUpdateWeights() ? m_V.numel() : 0 });
+
+				if (!m_dLdH.resize(lid.incBS.maxTrainBS, m_rank)) return ErrorCode::CantAllocateMemoryForTempData;
+			}
+
+			if (!get_self().get_gradWorks().gw_init(get_common_data(), m_U)) return ErrorCode::CantInitializeGradWorks;
+			if (!get_self().get_gradWorksV().gw_init(get_common_data(), m_V)) return ErrorCode::CantInitializeGradWorks;
+
+			lid.bLossAddendumDependsOnWeights = get_self().hasLossAddendum();
+
+			bSuccessfullyInitialized = true;
+			return ec;
+		}
+
+		void layer_deinit() noexcept {
+			get_gradWorksV().gw_deinit();
+			get_gradWorks().gw_deinit();
+			m_dLdH.clear();
+			m_H.clear();
+			_base_class_t::layer_deinit();
+		}
+
+		vec_len_t on_batch_size_change(const vec_len_t incBatchSize, real_t*const pNewActivationStorage = nullptr)noexcept {
+			const auto outgBs = _base_class_t::on_batch_size_change(incBatchSize, pNewActivationStorage);
+			NNTL_ASSERT(m_H.emulatesBiases() && m_H.bOwnStorage());
+			m_H.deform_batch_size_with_biases(incBatchSize);
+			return outgBs;
+		}
+
+		template <typename LowerLayer>
+		void fprop(const LowerLayer& lowerLayer)noexcept {
+			static_assert(::std::is_base_of<_i_layer_fprop<real_t>, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_fprop");
+			get_self()._lfclr_fprop(lowerLayer.get_activations());
+		}
+
+		template <typename LowerLayer>
+		unsigned bprop(realmtxdef_t& dLdA, const LowerLayer& lowerLayer, realmtx_t& dLdAPrev)noexcept {
+			static_assert(::std::is_base_of<_i_layer_trainable<real_t>, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_trainable");
+			return get_self()._lfclr_bprop(dLdA, lowerLayer.get_activations(), is_layer_with_bprop<LowerLayer>::value, dLdAPrev);
+		}
+
+		real_t lossAddendum()const noexcept {
+			return get_gradWorks().lossAddendum(m_U) + get_gradWorksV().lossAddendum(m_V);
+		}
+		bool hasLossAddendum()const noexcept { return get_gradWorks().hasLossAddendum() || get_gradWorksV().hasLossAddendum(); }
+
+	protected:
+		void _lfclr_fprop(const realmtx_t& prevAct)noexcept {
+			NNTL_ASSERT(prevAct.test_biases_strict() && prevAct.bBatchInColumn());
+			NNTL_ASSERT_MTX_NO_NANS(prevAct);
+			NNTL_ASSERT(get_incoming_neurons_cnt() == prevAct.sample_size());
+			NNTL_ASSERT(is_activations_shared() || m_activations.test_biases_strict());
+			NNTL_ASSERT(prevAct.batch_size() == m_activations.batch_size() && prevAct.batch_size() == m_H.batch_size());
+			NNTL_ASSERT(m_H.test_biases_strict());
+
+			const auto bTrainingMode = get_common_data().is_training_mode();
+			auto& _iI = get_iInspect();
+			_iI.fprop_begin(get_layer_idx(), prevAct, bTrainingMode);
+
+			if (bTrainingMode && !get_common_data().is_recomputing_fprop()) {
+				get_self().get_gradWorksV().pre_training_fprop(m_V);
+				get_self().get_gradWorks().pre_training_fprop(m_U);
+			}
+
+			auto& iM = get_iMath();
+			_iI.fprop_makePreActivations(m_V, prevAct, wb_V);
+			iM.mMul_prevAct_weights_2_act(prevAct, m_V, m_H);
+
+			_iI.fprop_makePreActivations(m_U, m_H, wb_U);
+			iM.mMul_prevAct_weights_2_act(m_H, m_U, m_activations);
+			_iI.fprop_preactivations(m_activations);
+
+			get_self()._activation_fprop(iM);
+			_iI.fprop_activations(m_activations);
+
+			NNTL_ASSERT(is_activations_shared() || m_activations.test_biases_strict());
+			_iI.fprop_end(m_activations);
+			m_bActivationsValid = true;
+		}
+
+		unsigned _lfclr_bprop(realmtxdef_t& dLdA, const realmtx_t& prevAct, const bool bPrevLayerWBprop, realmtx_t& dLdAPrev)noexcept {
+			NNTL_ASSERT(prevAct.test_biases_strict());
+			NNTL_ASSERT(is_activations_shared() || m_activations.test_biases_strict());
+			NNTL_ASSERT(m_bActivationsValid);
+			m_bActivationsValid = false;
+
+			NNTL_ASSERT(get_common_data().is_training_mode());
+			NNTL_ASSERT(prevAct.batch_size() == m_activations.batch_size() && prevAct.batch_size() == m_H.batch_size());
+			NNTL_ASSERT(m_activations.size_no_bias() == dLdA.size());
+			NNTL_ASSERT(!bPrevLayerWBprop || dLdAPrev.size() == prevAct.size_no_bias());
+			dLdA.assert_storage_does_not_intersect(dLdAPrev);
+			NNTL_ASSERT_MTX_NO_NANS(dLdA);
+
+			auto& _iI = get_iInspect();
+			_iI.bprop_begin(get_layer_idx(), dLdA);
+			_iI.bprop_finaldLdA(dLdA);
+			_iI.bprop_predAdZ(m_activations);
+
+			NNTL_ASSERT(m_activations.bBatchInColumn() && dLdA.bBatchInColumn());
+			realmtx_t dLdZ(m_activations.data(), m_activations, math::tag_noBias());
+
+			auto& iM = get_iMath();
+			if (activation::is_activation_identity<Activation_t>::value) {
+				const auto b = dLdA.copy_to(dLdZ);
+				NNTL_ASSERT(b);
+			} else {
+				_activation_bprop(dLdZ, iM);
+				_iI.bprop_dAdZ(dLdZ);
+				iM.evMul_ip(dLdZ, dLdA);
+			}
+			//dLdA is free to be used since now
+			_iI.bprop_dLdZ(dLdZ);
+
+			//dL/dH must be computed with U that was used during fprop()
+			m_dLdH.deform_rows(m_activations.batch_size());
+			iM.mMul_dLdZ_weights_2_dLdAPrev(dLdZ, m_U, m_dLdH);
+
+			const bool bUpdateWeights = get_self().bUpdateWeights();
+			const real_t sc = real_t(1) / real_t(m_activations.batch_size());
+			realmtxdef_t& dLdW = dLdA;
+
+			if (bUpdateWeights) {
+				dLdW.deform_like(m_U);
+				iM.mMulScaled_dLdZ_prevAct_2_dLdW(sc, dLdZ, m_H, dLdW);
+				_iI.bprop_dLdW(dLdZ, m_H, dLdW, wb_U);
+				get_gradWorks().apply_grad(m_U, dLdW);
+			}
+
+			//same for dL/dAPrev and V
+			if (bPrevLayerWBprop) {
+				iM.mMul_dLdZ_weights_2_dLdAPrev(m_dLdH, m_V, dLdAPrev);
+			}
+
+			if (bUpdateWeights) {
+				dLdW.deform_like(m_V);
+				iM.mMulScaled_dLdZ_prevAct_2_dLdW(sc, m_dLdH, prevAct, dLdW);
+				_iI.bprop_dLdW(m_dLdH, prevAct, dLdW, wb_V);
+				get_gradWorksV().learning_rate(get_gradWorks().learning_rate());
+				get_gradWorksV().apply_grad(m_V, dLdW);
+
+				dLdW.deform_like_no_bias(m_activations);
+			}
+
+			NNTL_ASSERT(prevAct.test_biases_strict());
+			_iI.bprop_end(dLdAPrev);
+			return 1;
+		}
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	// final implementation of layer with all functionality of _LFCLR
+	// If you need to derive a new class, derive it from _LFCLR (to make static polymorphism work)
+	template <typename ActivFunc = activation::sigm<d_interfaces::real_t>
+		, typename GradWorks = grad_works<d_interfaces>
+	> class LFCLR final : public _LFCLR<LFCLR<ActivFunc, GradWorks>, ActivFunc, GradWorks>
+	{
+		typedef _LFCLR<LFCLR<ActivFunc, GradWorks>, ActivFunc, GradWorks> _base_class_t;
+	public:
+		template<typename...ArgsT>
+		LFCLR(ArgsT&&... ar)noexcept : _base_class_t(::std::forward<ArgsT>(ar)...) {}
+	};
+
+	template <typename ActivFunc = activation::sigm<d_interfaces::real_t>,
+		typename GradWorks = grad_works<d_interfaces>
+	> using layer_fully_connected_lowrank = typename LFCLR<ActivFunc, GradWorks>;
+}
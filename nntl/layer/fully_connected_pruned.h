@@ -0,0 +1,295 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+// LFCP is a fully connected layer that supports magnitude pruning of its weights.
+//
+// prune_weights(sparsity) zeros floor(sparsity*p) non-bias weights with the smallest magnitudes of every neuron
+// (p is the incoming neurons count) and remembers the mask of the weights left, so neither apply_grad() nor the momentum
+// or the Nesterov momentum of grad_works could revive the pruned weights (dL/dW is masked before apply_grad() and the
+// weights are masked right after it). Sparsity could only grow, i.e. once a weight is pruned it's pruned forever.
+// Use pruning_schedule (see layers.h) from the onEpochEndCB of nnet::train() to make a gradual pruning schedule.
+//
+// Once the sparsity reaches the sparse_threshold(), the layer makes compressed sparse row copies of the weights (see
+// math/smatrix_csr.h) and switches fprop() and the dL/dAPrev product of bprop() to SpMM kernels (see
+// iMath::mMulABt_sparseB()). Dense weights are still kept as the master copy, because grad_works need them, and dL/dW
+// is still computed with the dense GEMM (it's a dense product by its nature). The compressed copies are refreshed
+// lazily, before the first fprop() that follows a weights update, that takes O(nnz). The refresh can't be done right
+// after apply_grad(), because grad_works may defer the update itself (gradient accumulation, distributed::dp_grad_works).
+//
+// The pruned layer is saved as an ordinary LFC with the pruned weights set to zero, but the mask isn't derived from the
+// weights (a weight that isn't pruned could be zero too). Pass it along to restore a pruned layer: set_weights(W, mask)
+// (that's the way to move a pruned layer to an inference only nnet; checkpoints of _supp/io/checkpoint.h store the mask
+// for that). set_weights(W) keeps the current mask of the layer. Loading the weights into LFC works too, but it would
+// be a dense layer then.
+//
+// Pruned weights aren't parameters of the layer, so the numeric gradient check skips them (see layer_has_prune_mask).
+
+#include "fully_connected.h"
+
+namespace nntl {
+
+	template<typename FinalPolymorphChild, typename ActivFunc, typename GradWorks>
+	class _LFCP : public _LFC<FinalPolymorphChild, ActivFunc, GradWorks> {
+	private:
+		typedef _LFC<FinalPolymorphChild, ActivFunc, GradWorks> _base_class_t;
+
+	public:
+		static constexpr const char _defName[] = "fcp";
+
+		//SpMM kernels don't support the inplace tiling
+		static constexpr bool bTileableInplace = false;
+
+		typedef math::smatrix_csr<real_t> sparse_weights_t;
+
+		//////////////////////////////////////////////////////////////////////////
+		//members
+	protected:
+		//the mask of weights left, same size as m_weights. Empty when nothing is pruned
+		realmtx_t m_pruneMask;
+
+		//compressed copies of m_weights. m_spW is used in fprop() and m_spWt (transposed, no bias column) is for
+		// dL/dAPrev computation. Empty until the sparsity reaches m_sparseThreshold
+		sparse_weights_t m_spW, m_spWt;
+
+		real_t m_sparsity{ real_t(0) };
+		real_t m_sparseThreshold{ real_t(.7) };
+
+		//set when the weights might have been changed and the compressed copies must be refreshed before the next use
+		bool m_bWeightsDirty{ false };
+
+	public:
+		~_LFCP() noexcept {};
+		_LFCP(const char* pCustomName, const neurons_count_t _neurons_cnt, const real_t learningRate = real_t(.01))noexcept
+			: _base_class_t(pCustomName, _neurons_cnt, learningRate)
+		{}
+		_LFCP(const neurons_count_t _neurons_cnt, const real_t learningRate = real_t(.01), const char* pCustomName = nullptr)noexcept
+			: _LFCP(pCustomName, _neurons_cnt, learningRate)
+		{}
+
+		real_t sparsity()const noexcept { return m_sparsity; }
+		bool is_sparse()const noexcept { return !m_spW.empty(); }
+
+		real_t sparse_threshold()const noexcept { return m_sparseThreshold; }
+		self_ref_t sparse_threshold(const real_t t)noexcept {
+			NNTL_ASSERT(t > real_t(0) && t <= real_t(1));
+			m_sparseThreshold = t;
+			if (m_bWeightsInitialized && !m_pruneMask.empty()) get_self()._lfcp_update_sparse();
+			return get_self();
+		}
+
+		const realmtx_t& get_prune_mask()const noexcept { return m_pruneMask; }
+		const sparse_weights_t& get_sparse_weights()const noexcept { return m_spW; }
+
+		//////////////////////////////////////////////////////////////////////////
+
+		//prunes the weights to the given per neuron sparsity. Sparsity never decreases, so passing a smaller value is a no-op
+		bool prune_weights(const real_t s)noexcept {
+			NNTL_ASSERT(m_bWeightsInitialized || !"prune_weights() requires the weights to be initialized");
+			NNTL_ASSERT(s >= real_t(0) && s < real_t(1));
+			if (!m_bWeightsInitialized) return false;
+			if (s <= m_sparsity) return true;
+
+			if (m_pruneMask.empty()) {
+				if (!m_pruneMask.resize(m_weights.size())) return false;
+				m_pruneMask.ones();
+			}
+			iMath_t::mMakePruneMaskByMagnitude(m_weights, s, m_pruneMask);
+			m_sparsity = get_self()._lfcp_mask_sparsity();
+			return get_self()._lfcp_update_sparse();
+		}
+
+		//drops the mask and returns the layer to the dense mode. Pruned weights stay zero until updated
+		void unprune_weights()noexcept {
+			m_pruneMask.clear();
+			m_spW.clear();
+			m_spWt.clear();
+			m_sparsity = real_t(0);
+		}
+
+		//the current mask (if any) is kept and applied to W
+		bool set_weights(realmtx_t&& W)noexcept {
+			return get_self()._lfcp_set_weights_keep_mask(::std::move(W));
+		}
+		bool set_weights(const realmtx_t& W)noexcept {
+			return get_self()._lfcp_set_weights_keep_mask(W);
+		}
+		//sets the weights together with the mask of weights left (see get_prune_mask()). An empty mask makes the layer dense
+		bool set_weights(const realmtx_t& W, const realmtx_t& mask)noexcept {
+			get_self().unprune_weights();
+			if (!_base_class_t::set_weights(W)) return false;
+			return get_self().set_prune_mask(mask);
+		}
+
+		//replaces the mask of the initialized weights. Zero elements of the mask are pruned weights, the bias column
+		// is never pruned. An empty mask makes the layer dense
+		bool set_prune_mask(const realmtx_t& mask)noexcept {
+			NNTL_ASSERT(m_bWeightsInitialized || !"set_prune_mask() requires the weights to be initialized");
+			NNTL_ASSERT(mask.empty() || (mask.size() == m_weights.size() && mask.bBatchInColumn()));
+			if (&mask == &m_pruneMask) return true;
+			get_self().unprune_weights();
+			if (mask.empty()) return true;
+			if (!m_bWeightsInitialized || mask.size() != m_weights.size()) return false;
+
+			if (!mask.clone_to(m_pruneMask)) return false;
+			m_pruneMask.fill_column_with(m_pruneMask.cols() - 1, real_t(1));
+			m_sparsity = get_self()._lfcp_mask_sparsity();
+			get_self()._lfcp_mask_weights();
+			return get_self()._lfcp_update_sparse();
+		}
+
+		void drop_weights()noexcept {
+			get_self().unprune_weights();
+			_base_class_t::drop_weights();
+		}
+
+		void _on_fprop_in_training_mode()noexcept {
+			_base_class_t::_on_fprop_in_training_mode();
+			//grad_works may update the weights here (Nesterov momentum)
+			get_self()._lfcp_sync_weights();
+		}
+
+		//the update might be deferred (see the header), so just marking the compressed copies as stale
+		void _lfc_on_weights_updated()noexcept {
+			m_bWeightsDirty = true;
+		}
+
+	protected:
+		void _lfcp_sync_weights()noexcept {
+			m_bWeightsDirty = false;
+			if (m_pruneMask.empty()) return;
+			get_iMath().evMul_ip(m_weights, m_pruneMask);
+			if (is_sparse()) {
+				m_spW.update_values(m_weights);
+				if (!m_spWt.empty()) m_spWt.update_values(m_weights);
+			}
+		}
+
+		//base class set_weights() calls drop_weights(), that drops the mask, so it's moved away and then set back
+		template<typename WT>
+		bool _lfcp_set_weights_keep_mask(WT&& W)noexcept {
+			realmtx_t mask(::std::move(m_pruneMask));
+			if (!_base_class_t::set_weights(::std::forward<WT>(W))) {
+				//the layer is intact if W is just unsuitable
+				if (m_bWeightsInitialized) m_pruneMask = ::std::move(mask);
+				return false;
+			}
+			if (mask.empty()) return true;
+			m_pruneMask = ::std::move(mask);
+			m_sparsity = get_self()._lfcp_mask_sparsity();
+			get_self()._lfcp_mask_weights();
+			return get_self()._lfcp_update_sparse();
+		}
+
+		//might be called before layer_init(), so doesn't use iMath
+		void _lfcp_mask_weights()noexcept {
+			NNTL_ASSERT(m_pruneMask.size() == m_weights.size());
+			const auto pW = m_weights.data();
+			const auto pM = m_pruneMask.data();
+			const auto ne = m_weights.numel();
+			for (numel_cnt_t i = 0; i < ne; ++i) pW[i] *= pM[i];
+		}
+
+		real_t _lfcp_mask_sparsity()const noexcept {
+			NNTL_ASSERT(!m_pruneMask.empty());
+			const vec_len_t p = m_pruneMask.cols() - 1;
+			const numel_cnt_t tot = m_pruneMask.rows()*static_cast<numel_cnt_t>(p);
+			numel_cnt_t nz = 0;
+			const auto pM = m_pruneMask.data();
+			for (numel_cnt_t i = 0; i < tot; ++i) nz += (pM[i] != real_t(0));
+			return real_t(1) - real_t(nz) / real_t(tot);
+		}
+
+		//makes or drops the compressed copies of weights according to the current sparsity
+		bool _lfcp_update_sparse()noexcept {
+			if (m_sparsity < m_sparseThreshold) {
+				m_spW.clear();
+				m_spWt.clear();
+				return true;
+			}
+			NNTL_ASSERT(!m_pruneMask.empty());
+			if (!m_spW.make_from(m_weights, m_pruneMask, m_weights.cols(), false)) return false;
+			//the transposed copy is required for bprop() only, however the common data might not be available yet
+			if (!m_spWt.make_from(m_weights, m_pruneMask, m_weights.cols() - 1, true)) {
+				m_spW.clear();
+				return false;
+			}
+			return true;
+		}
+
+	public:
+		//////////////////////////////////////////////////////////////////////////
+		// _LFC_FProp hooks
+		template<typename iMathT>
+		void _lfc_mMul_prevAct_weights_2_act(iMathT& iM, const realmtx_t& prevAct, realmtxdef_t& W, realmtx_t& act)noexcept {
+			NNTL_ASSERT(m_inplaceTiles == 1);
+			//the gradient check changes W in iInspect::fprop_makePreActivations() right before the product
+			if (m_bWeightsDirty || inspector::is_gradcheck_inspector<iInspect_t>::value) get_self()._lfcp_sync_weights();
+			if (is_sparse() && prevAct.bBatchInColumn()) {
+				iM.mMulABt_sparseB(prevAct, m_spW, act);
+			} else iM.mMul_prevAct_weights_2_act(prevAct, W, act);
+		}
+		template<typename iMathT>
+		void _lfc_mMul_dLdZ_weights_2_dLdAPrev(iMathT& iM, const realmtx_t& dLdZ, realmtxdef_t& W, realmtx_t& dLdAPrev)const noexcept {
+			NNTL_ASSERT(m_inplaceTiles == 1);
+			if (is_sparse() && dLdAPrev.bBatchInColumn()) {
+				iM.mMulABt_sparseB(dLdZ, m_spWt, dLdAPrev);
+			} else iM.mMul_dLdZ_weights_2_dLdAPrev(dLdZ, W, dLdAPrev);
+		}
+		template<typename iMathT>
+		void _lfc_mMulScaled_dLdZ_prevAct_2_dLdW(iMathT& iM, const real_t sc, const realmtx_t& dLdZ, const realmtx_t& prevAct
+			, realmtx_t& dLdW)const noexcept
+		{
+			NNTL_ASSERT(m_inplaceTiles == 1);
+			iM.mMulScaled_dLdZ_prevAct_2_dLdW(sc, dLdZ, prevAct, dLdW);
+			//pruned weights must not get any gradient, so the optimizer state for them stays clean
+			if (!m_pruneMask.empty()) iM.evMul_ip(dLdW, m_pruneMask);
+		}
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	// final implementation of layer with all functionality of _LFCP
+	// If you need to derive a new class, derive it from _LFCP (to make static polymorphism work)
+	template <typename ActivFunc = activation::sigm<d_interfaces::real_t>
+		, typename GradWorks = grad_works<d_interfaces>
+	> class LFCP final : public _LFCP<LFCP<ActivFunc, GradWorks>, ActivFunc, GradWorks>
+	{
+		typedef _LFCP<LFCP<ActivFunc, GradWorks>, ActivFunc, GradWorks> _base_class_t;
+	public:
+		template<typename...ArgsT>
+		LFCP(ArgsT&&... ar)noexcept : _base_class_t(::std::forward<ArgsT>(ar)...) {}
+	};
+
+	template <typename ActivFunc = activation::sigm<d_interfaces::real_t>,
+		typename GradWorks = grad_works<d_interfaces>
+	> using layer_fully_connected_pruned = typename LFCP<ActivFunc, GradWorks>;
+}
@@ -35,10 +35,21 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // Can be used to pass a source data unmodified to some upper feature detectors.
 // 
 // LIG can also serve as a gating source for the layer_pack*gated.
+//
+// With alias_activations(true) (must be set before the initialization) LI that owns its activation storage (i.e. it's
+// not an inner layer of a layer_pack_horizontal, that provides the storage) doesn't copy anything at all: its activations
+// matrix is just a view of the lower layer activations (including the bias column). Therefore the lower layer activations
+// must stay valid until LI's bprop() is done. That's true for any ordinary layer stack, but not for temporary column views
+// made by layer_pack_horizontal* wrappers (the bias column there is a temporary replacement of the next column data).
+// Packs that might feed LI with such a view check is_aliasing_activations() and use a persistent matrix instead.
+// Aliasing is off by default, because anything that modifies LI activations would modify the lower layer activations
+// (or even the training data) then. LIG that binarizes the gate and LI wrapped into LEx with dropout (see _LEx::_li_can_alias())
+// never alias. Inside LPH the pack output is a single contiguous matrix, so one copy there is inherent.
 
 #include <type_traits>
 
 #include "_activation_storage.h"
+#include "_pack_.h"
 
 namespace nntl {
 
@@ -50,6 +61,11 @@ namespace nntl {
 	public:
 		static constexpr bool bLayerToleratesNoBiases = true;
 		static constexpr bool bLayerHasTrivialBProp = true;
+
+	protected:
+		bool m_bAliasActivations{ false };//setting
+		//set when m_activations is just a view of the lower layer activations (no own activation storage)
+		bool m_bActivationsAliased{ false };
 		
 	public:
 		~_LI()noexcept {}
@@ -57,18 +73,73 @@ namespace nntl {
 		
 		static constexpr const char _defName[] = "li";
 
+		//must be set before the initialization
+		self_ref_t alias_activations(const bool b)noexcept {
+			NNTL_ASSERT(!m_bActivationsAliased || !"alias_activations() must be set before the initialization");
+			m_bAliasActivations = b;
+			return get_self();
+		}
+		bool alias_activations()const noexcept { return m_bAliasActivations; }
+		bool is_aliasing_activations()const noexcept { return m_bActivationsAliased; }
+
+		//aliased activations belong to the lower layer
+		realmtxdef_t& _get_activations_mutable() noexcept {
+			NNTL_ASSERT(!m_bActivationsAliased || !"Aliased activations mustn't be modified! Check _li_can_alias()");
+			return _base_class_t::_get_activations_mutable();
+		}
+
 		//////////////////////////////////////////////////////////////////////////
+		//redefining callback for base class to skip allocation of activations when they are going to be aliased
+		ErrorCode _act_stor_init_activations(const vec_len_t biggestOutgBS, real_t*const pNewActivationStorage)noexcept {
+			m_bActivationsAliased = m_bAliasActivations && get_self()._li_can_alias() && !pNewActivationStorage;
+			if (!m_bActivationsAliased) return _base_class_t::_act_stor_init_activations(biggestOutgBS, pNewActivationStorage);
+
+			_set_activations_shared(false);
+			return ErrorCode::Success;
+		}
+
+		void layer_deinit() noexcept {
+			m_bActivationsAliased = false;
+			_base_class_t::layer_deinit();
+		}
+
+		vec_len_t on_batch_size_change(const vec_len_t incBatchSize, real_t*const pNewActivationStorage = nullptr)noexcept {
+			if (!m_bActivationsAliased) return _base_class_t::on_batch_size_change(incBatchSize, pNewActivationStorage);
+
+			NNTL_ASSERT(!pNewActivationStorage);
+			NNTL_ASSERT(incBatchSize > 0 && incBatchSize <= m_incBS.max_bs4mode(get_common_data().is_training_mode()));
+			m_bActivationsValid = false;
+			//m_activations will be pointed to the lower layer activations during fprop()
+			return get_self().incoming2outgoing_batch_size(incBatchSize);
+		}
+
+		//redefine in derived class if the layer modifies its activations
+		static constexpr bool _li_can_alias()noexcept { return true; }
+
 	protected:
 
 		void _li_fprop(const realmtx_t& prevActivations)noexcept {
-			NNTL_ASSERT(is_activations_shared() || m_activations.test_biases_strict());
-			NNTL_ASSERT(prevActivations.size_no_bias() == m_activations.size_no_bias());
+			NNTL_ASSERT(m_bActivationsAliased || is_activations_shared() || m_activations.test_biases_strict());
+			NNTL_ASSERT(m_bActivationsAliased || prevActivations.size_no_bias() == m_activations.size_no_bias());
 
 			auto& iI = get_iInspect();
 			iI.fprop_begin(get_layer_idx(), prevActivations, get_common_data().is_training_mode());
 
+			if (m_bActivationsAliased) {
+				NNTL_ASSERT(prevActivations.test_biases_strict() && prevActivations.bBatchInColumn());
+				NNTL_ASSERT(prevActivations.cols_no_bias() == get_neurons_cnt());
+				//prevActivations are NOT expected to be changed, therefore trick with const_cast<> should do no harm
+				m_activations.useExternalStorage(const_cast<real_t*>(prevActivations.data()), prevActivations
+					, prevActivations.isHoleyBiases());
+
+				m_bActivationsValid = true;
+				iI.fprop_activations(m_activations);
+				iI.fprop_end(m_activations);
+				return;
+			}
+
 			// just copying the data from prevActivations to m_activations
-			// We must copy the data, because layer_pack_horizontal uses its own storage for activations, therefore
+			// We must copy the data here, because layer_pack_horizontal uses its own storage for activations, therefore
 			// we can't just use the m_activations as an alias to prevActivations - we have to physically copy the data
 			// to a new storage within layer_pack_horizontal activations
 			//const bool r = prevActivations.clone_to(m_activations);
@@ -100,7 +171,9 @@ namespace nntl {
 	public:
 		template <typename LowerLayerT>
 		void fprop(const LowerLayerT& lowerLayer)noexcept {
-			static_assert(::std::is_base_of<_i_layer_fprop, LowerLayerT>::value, "Template parameter LowerLayerT must implement _i_layer_fprop");
+			static_assert(::std::is_base_of<_i_layer_fprop<real_t>, LowerLayerT>::value, "Template parameter LowerLayerT must implement _i_layer_fprop");
+			NNTL_ASSERT(!m_bActivationsAliased || !_impl::is_trainable_partial_layer_wrapper<LowerLayerT>::value
+				|| !"Temporary column views can't be aliased!");
 			get_self()._li_fprop(lowerLayer.get_activations());
 		}
 
@@ -145,6 +218,9 @@ namespace nntl {
 		static constexpr real_t sBinarizeFrac = real_t(iBinarize1e6) / real_t(1e6);
 		static constexpr bool sbBinarizeGate = bDoBinarizeGate;
 
+		//binarization is done inplace and must not spoil the lower layer activations
+		static constexpr bool _li_can_alias()noexcept { return !sbBinarizeGate; }
+
 		//////////////////////////////////////////////////////////////////////////
 		//members section (in "biggest first" order)
 	protected:
@@ -45,10 +45,12 @@ namespace nntl {
 	{
 	private:
 		typedef _LFC_FProp<FinalPolymorphChild, typename GradWorks::interfaces_t, ActivFunc, false> _base_class_t;
+		//_LFC_FProp::_lfc_fprop() calls our protected _activation_fprop() via get_self()
+		friend _base_class_t;
 
 	public:
-		static_assert(bActivationForOutput && bActivationForHidden, "ActivFunc template parameter must be derived from "
-			"activation::_i_activation_loss<> and activation::_i_activation<>");
+		//output only activations such as softmax_xentropy_loss don't derive from _i_activation<>, the layer needs only the loss
+		static_assert(_base_class_t::bActivationForOutput, "ActivFunc template parameter must be derived from activation::_i_activation_loss<>");
 
 		typedef GradWorks grad_works_t;
 		static_assert(::std::is_base_of<_impl::_i_grad_works<real_t>, grad_works_t>::value, "GradWorks template parameter should be derived from _i_grad_works");
@@ -65,6 +67,17 @@ namespace nntl {
 		
 		real_t m_dLdZRestrictLowerBnd, m_dLdZRestrictUpperBnd;
 		bool m_bRestrictdLdZ;//restriction flag should be permanent for layer_init/layer_deinit calls and changed only by explicit calls to respective functions
+
+		//when the activation has fused versions of f()+dLdZ() and f()+loss() (see activation::has_fused_loss<>), the
+		//fprop() may leave preactivations in m_activations and the f() will be computed later in a single pass with
+		//dL/dZ in bprop() or with the loss value in calc_loss(). During the training it's done always, during evaluation
+		//only when m_bFuseActivationWithLoss is set (nnet::calcLossAndReport() does it).
+		//Inspectors must see real activations, so the fused path is used only with the dummy inspector.
+		static constexpr bool bFusedLossPossible = activation::has_fused_loss<ActivFunc>::value
+			&& inspector::is_dummy_inspector<typename GradWorks::interfaces_t::iInspect_t>::value;
+
+		bool m_bFuseActivationWithLoss;
+		bool m_bActivationDeferred;//m_activations contains preactivations
 						
 		//////////////////////////////////////////////////////////////////////////
 		//Serialization support
@@ -106,6 +119,7 @@ namespace nntl {
 		_layer_output(const char* pCustomName, const neurons_count_t _neurons_cnt, real_t learningRate = real_t(.01)) noexcept
 			: _base_class_t(pCustomName, _neurons_cnt), m_dLdW(), m_gradientWorks(learningRate)
 			, m_bRestrictdLdZ(false), m_dLdZRestrictLowerBnd(.0), m_dLdZRestrictUpperBnd(.0)
+			, m_bFuseActivationWithLoss(false), m_bActivationDeferred(false)
 		{
 			NNTL_ASSERT(!m_activations.emulatesBiases());
 		};
@@ -116,6 +130,9 @@ namespace nntl {
 		grad_works_t& get_gradWorks()noexcept { return m_gradientWorks; }
 		const grad_works_t& get_gradWorks()const noexcept { return m_gradientWorks; }
 
+		//returns the width of data_y the layer expects to get (nnet checks it against the train data)
+		neurons_count_t get_data_y_width()const noexcept { return get_neurons_cnt(); }
+
 		ErrorCode layer_init(_layer_init_data_t& lid)noexcept {
 			bool bSuccessfullyInitialized = false;
 			utils::scope_exit onExit([&bSuccessfullyInitialized, this]() {
@@ -169,8 +186,53 @@ namespace nntl {
 			get_self().get_gradWorks().pre_training_fprop(m_weights);
 		}
 
+		//allows the next fprop() in inference mode to postpone the activation until calc_loss() is called.
+		//Does nothing if the activation doesn't support it
+		void fuse_activation_with_loss(const bool b)noexcept { m_bFuseActivationWithLoss = b; }
+
+		template<typename YT, bool _b = bFusedLossPossible>
+		::std::enable_if_t<_b, real_t> calc_loss(const math::smatrix<YT>& data_y)noexcept {
+			if (!m_bActivationDeferred) return _base_class_t::calc_loss(data_y);
+			NNTL_ASSERT(!m_activations.emulatesBiases() && !data_y.emulatesBiases());
+			m_bActivationDeferred = false;
+			//real activations are made by the call and are available after it
+			const auto l = get_self().get_activation_obj().f_loss(m_activations, data_y, get_iMath());
+			NNTL_ASSERT_MTX_NO_NANS(m_activations);
+			return l;
+		}
+		template<typename YT>
+		real_t calc_loss(const math::smatrix<YT>& data_y)const noexcept {
+			NNTL_ASSERT(!m_bActivationDeferred);
+			return _base_class_t::calc_loss(data_y);
+		}
+
 	protected:
 
+		template<typename iMathT, bool _b = bFusedLossPossible>
+		::std::enable_if_t<_b> _activation_fprop(iMathT& iM)noexcept {
+			m_bActivationDeferred = !get_self().bIgnoreActivation()
+				&& (m_bFuseActivationWithLoss || get_common_data().is_training_mode());
+			if (!m_bActivationDeferred) _base_class_t::_activation_fprop(iM);
+		}
+		template<typename iMathT, bool _b = bFusedLossPossible>
+		::std::enable_if_t<!_b> _activation_fprop(iMathT& iM)noexcept {
+			_base_class_t::_activation_fprop(iM);
+		}
+
+		template<typename YT, typename iMathT, bool _b = bFusedLossPossible>
+		::std::enable_if_t<_b> _outp_activation_dLdZ(const math::smatrix<YT>& data_y, iMathT& iM)noexcept {
+			if (m_bActivationDeferred) {
+				NNTL_ASSERT(!m_activations.emulatesBiases() && !data_y.emulatesBiases());
+				m_bActivationDeferred = false;
+				get_self().get_activation_obj().f_dLdZ(data_y, m_activations, iM);
+				NNTL_ASSERT(m_activations.test_noNaNs());
+			} else get_self()._activation_bprop_output(data_y, iM);
+		}
+		template<typename YT, typename iMathT, bool _b = bFusedLossPossible>
+		::std::enable_if_t<!_b> _outp_activation_dLdZ(const math::smatrix<YT>& data_y, iMathT& iM)noexcept {
+			get_self()._activation_bprop_output(data_y, iM);
+		}
+
 		void _cust_inspect(const realmtx_t&)const noexcept { }
 
 		// #supportsBatchInRow for prevAct, data_y and m_activations (iif the dLdZ, obtained from
@@ -205,7 +267,7 @@ namespace nntl {
 			//compute dL/dZ into m_activations. Note that there's no requirement to make layout of dLdZ the same as m_activations, therefore
 			//remembering it to restore later (this is not necessary now, but will be in future)
 			const auto bActBatchesInRows = m_activations.bBatchInRow();
-			_activation_bprop_output(data_y, iM);
+			get_self()._outp_activation_dLdZ(data_y, iM);
 			//now dLdZ is calculated into m_activations
 
 			//#todo: once upgrade finished, remove the following assert
@@ -228,7 +290,7 @@ namespace nntl {
 				//iM.mMulAB_C(dLdZ, m_weights, dLdAPrev);
 				//m_weights.restore_last_col();//restore weights back
 				// #TODO support bBatchInRow for dLdZ!!!
-				iM.mMul_dLdZ_weights_2_dLdAPrev(dLdZ, m_weights, dLdAPrev);
+				get_self()._lfc_mMul_dLdZ_weights_2_dLdAPrev(iM, dLdZ, m_weights, dLdAPrev);
 			}
 
 			if (get_self().bUpdateWeights()) {
@@ -237,7 +299,7 @@ namespace nntl {
 				NNTL_ASSERT(m_dLdW.size() == m_weights.size());
 
 				// #TODO support bBatchInRow for dLdZ!!!
-				iM.mMulScaled_dLdZ_prevAct_2_dLdW(real_t(1.) / real_t(dLdZ.rows()), dLdZ, prevAct, m_dLdW);
+				get_self()._lfc_mMulScaled_dLdZ_prevAct_2_dLdW(iM, real_t(1.) / real_t(dLdZ.rows()), dLdZ, prevAct, m_dLdW);
 
 				_iI.bprop_dLdW(dLdZ, prevAct, m_dLdW);
 
@@ -254,7 +316,7 @@ namespace nntl {
 		
 		template <typename YT, typename LowerLayer>
 		unsigned bprop(const math::smatrix<YT>& data_y, const LowerLayer& lowerLayer, realmtx_t& dLdAPrev)noexcept {
-			static_assert(::std::is_base_of<_i_layer_trainable, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_trainable");
+			static_assert(::std::is_base_of<_i_layer_trainable<real_t>, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_trainable");
 			//NNTL_ASSERT(get_self().bDoBProp());
 			return get_self()._outp_bprop(data_y, lowerLayer.get_activations(), is_layer_with_bprop<LowerLayer>::value, dLdAPrev);
 		}
@@ -54,6 +54,8 @@ namespace nntl {
 		typedef _impl::_LPH_base<FinalPolymorphChild, PHLsTuple> _base_class_t;
 
 	public:
+		using typename _base_class_t::realmtx_t;
+
 		~_LPH()noexcept {}
 		_LPH(const char* pCustomName, const PHLsTuple& phls)noexcept : _base_class_t(pCustomName, phls)	{}
 		_LPH(const char* pCustomName, PHLsTuple&& phls)noexcept : _base_class_t(pCustomName, ::std::move(phls))	{}
@@ -136,11 +138,20 @@ namespace nntl {
 				NNTL_ASSERT(firstNeuronOfs >= lyr.get_neurons_cnt());
 				firstNeuronOfs -= lyr.get_neurons_cnt();
 
-				//setting up the _innerdLdA
-				_innerdLdA.deform_like_no_bias(lyr.get_activations());
-				NNTL_ASSERT(firstNeuronOfs + _innerdLdA.cols() <= dLdA.cols());
-				NNTL_ASSERT(_innerdLdA.rows() == dLdA.rows());
-				::std::memcpy(_innerdLdA.data(), dLdA.colDataAsVec(firstNeuronOfs), _innerdLdA.byte_size());
+				//setting up the _innerdLdA. Layers with trivial bprop() (LI) don't modify dLdA, so they could be given just
+				// a view of the corresponding columns of dLdA instead of a copy
+				static constexpr bool bTrivialBProp = layer_has_trivial_bprop<::std::decay_t<decltype(lyr)>>::value;
+				realmtxdef_t dLdAView;
+				if (bTrivialBProp) {
+					NNTL_ASSERT(firstNeuronOfs + lyr.get_neurons_cnt() <= dLdA.cols());
+					dLdAView.useExternalStorage(dLdA.colDataAsVec(firstNeuronOfs), dLdA.rows(), lyr.get_neurons_cnt());
+				} else {
+					_innerdLdA.deform_like_no_bias(lyr.get_activations());
+					NNTL_ASSERT(firstNeuronOfs + _innerdLdA.cols() <= dLdA.cols());
+					NNTL_ASSERT(_innerdLdA.rows() == dLdA.rows());
+					::std::memcpy(_innerdLdA.data(), dLdA.colDataAsVec(firstNeuronOfs), _innerdLdA.byte_size());
+				}
+				realmtxdef_t& curdLdA = bTrivialBProp ? dLdAView : _innerdLdA;
 
 				//#consider       max_dLdA_numel,     _innerdLdA.numel() 
 				//_innerdLdAPrev.numel,     dLdA  _innerdLdA   , 
@@ -154,11 +165,11 @@ namespace nntl {
 					_innerdLdAPrev.deform(dLdAPrev.rows(), phl.coord.m_count);
 				} else _innerdLdAPrev.deform(0, 0);
 
-				const auto switchMtxs = lyr.bprop(_innerdLdA, LLWrapT(prevAct, _pTmpBiasStorage, phl.coord), _innerdLdAPrev);
+				const auto switchMtxs = lyr.bprop(curdLdA, LLWrapT(prevAct, _pTmpBiasStorage, phl.coord), _innerdLdAPrev);
 
 				if (bPrevLayerWBprop) {
-					const auto& curdLdAPrev = switchMtxs ? _innerdLdAPrev : _innerdLdA;
-					NNTL_ASSERT(curdLdAPrev.size() == realmtx_t::mtx_size_t(dLdAPrev.rows(), phl.coord.m_count));
+					const auto& curdLdAPrev = switchMtxs ? _innerdLdAPrev : curdLdA;
+					NNTL_ASSERT(curdLdAPrev.size() == typename realmtx_t::mtx_size_t(dLdAPrev.rows(), phl.coord.m_count));
 
 					//saving curdLdAPrev to dLdAPrev
 					_Math.vAdd_ip(dLdAPrev.colDataAsVec(phl.coord.m_offset)
@@ -181,7 +192,7 @@ namespace nntl {
 
 		template <typename LowerLayer>
 		unsigned bprop(realmtxdef_t& dLdA, const LowerLayer& lowerLayer, realmtxdef_t& dLdAPrev)noexcept {
-			static_assert(::std::is_base_of<_i_layer_trainable, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_trainable");
+			static_assert(::std::is_base_of<_i_layer_trainable<real_t>, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_trainable");
 			static_assert(!bAssumeFPropOnly, "");
 			//NNTL_ASSERT(get_self().bDoBProp());
 			return get_self()._lph_bprop<_impl::wrap_part_trainable_layer<LowerLayer>>(dLdA, dLdAPrev, lowerLayer.get_activations());
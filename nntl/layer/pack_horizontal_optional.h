@@ -59,7 +59,10 @@ namespace nntl {
 		typedef _impl::_LPH_base<FinalPolymorphChild, PHLsTuple> _base_class_t;
 
 	public:
-		static constexpr size_t gated_layers_count = phl_count - 1;
+		using typename _base_class_t::realmtx_t;
+		typedef typename _base_class_t::ErrorCode ErrorCode;
+
+		static constexpr size_t gated_layers_count = _base_class_t::phl_count - 1;
 		//neurons of the gate always take the first columns of activations matrix
 		static constexpr neurons_count_t gate_neurons_count = static_cast<neurons_count_t>(gated_layers_count*(1 + bAddDataNotPresentFeature));
 
@@ -73,6 +76,10 @@ namespace nntl {
 		//storage for matrices of m_aPrevActs
 		::std::unique_ptr<real_t[]> m_prevActsStor;
 
+		//indexes of batch rows passed through the gate to each gated layer (m_biggestIncBS elements per layer).
+		// They're computed once per batch in fprop() and reused for gathering/scattering in bprop()
+		::std::unique_ptr<vec_len_t[]> m_gatedRowsIdxs;
+
 		//////////////////////////////////////////////////////////////////////////
 	public:
 		~_LPHO()noexcept {}
@@ -163,6 +170,10 @@ namespace nntl {
 			//a gate might be completely open (all ones), and have to add +1 to neurons count to account bias column
 			// for the last/rightmost layer
 			const auto biggestIncBS = lid.incBS.biggest();
+			NNTL_ASSERT(biggestIncBS == m_biggestIncBS);
+			m_gatedRowsIdxs.reset(new(::std::nothrow) vec_len_t[gated_layers_count*static_cast<size_t>(biggestIncBS)]);
+			if (!m_gatedRowsIdxs) return ErrorCode::CantAllocateMemoryForGatedRowsIdxs;
+
 			real_t* ptr = new(::std::nothrow) real_t[realmtx_t::sNumel(biggestIncBS, totalIncomingNC + 1)];
 
 			if (ptr) {
@@ -185,6 +196,7 @@ namespace nntl {
 		void layer_deinit() noexcept {
 			for (auto& e : m_aPrevActs) e.clear();
 			m_prevActsStor.reset(::std::nullptr_t());
+			m_gatedRowsIdxs.reset(::std::nullptr_t());
 			_base_class_t::layer_deinit();
 		}
 
@@ -239,12 +251,14 @@ namespace nntl {
 
 			//1. we must calculate batch sizes for inner layers (they depends on a corresponding gating neuron value),
 			// prepare individual activations and call on_batch_size_change() for layers
+			// Indexes of rows passing the gate are computed here once and then reused by the bprop()
 			neurons_count_t ofs = gate_neurons_count, lIdx=0;
 			tuple_utils::for_each_exc_first_up(m_phl_tuple, [&prevAct, &act = m_activations, &iM = get_iMath()
-				, &ofs, &lIdx, &aPA = m_aPrevActs, &gate = gating_layer().get_activations()](const auto& phl)noexcept
+				, &ofs, &lIdx, &aPA = m_aPrevActs, &gate = gating_layer().get_activations()
+				, pIdxsStor = m_gatedRowsIdxs.get(), bbs = m_biggestIncBS, pTBS = m_pTmpBiasStorage](const auto& phl)noexcept
 			{
-				const real_t*const pG = gate.colDataAsVec(lIdx);
-				const vec_len_t nzc = static_cast<vec_len_t>(iM.vCountNonZeros(pG, gate.rows()));
+				vec_len_t*const pIdxs = pIdxsStor + static_cast<numel_cnt_t>(lIdx)*bbs;
+				const vec_len_t nzc = iM.vMakeIdxsOfNonZeros(gate.colDataAsVec(lIdx), gate.rows(), pIdxs);
 
 				//updating the storage of rows extracted from curPrevAct
 				realmtxdef_t& gatedPrevAct = aPA[lIdx];
@@ -259,22 +273,30 @@ namespace nntl {
 					//changing the batch size and notifying the layer about it
 					phl.l.on_batch_size_change(nzc, nullptr);
 
-					//constructing alias to relevant columns of prevAct
 					NNTL_ASSERT(phl.coord.m_offset + phl.coord.m_count <= prevAct.cols_no_bias());
 					NNTL_ASSERT(phl.coord.m_count == phl.l.get_incoming_neurons_cnt());
-					//const_cast here is just a trick to get necessary pointer. We won't modify the data under it
-					const realmtx_t curPrevAct(const_cast<real_t*>(prevAct.colDataAsVec(phl.coord.m_offset))
-						, prevAct.rows(), phl.coord.m_count, false);
-
-					// fetching relevant rows into gatedPrevAct
-					iM.mExtractRowsByMask(curPrevAct, pG, gatedPrevAct);
-					gatedPrevAct.set_biases();
-
-					//doing fprop with gatedPrevAct
-					phl.l.fprop(_impl::wrap_trainable_layer<LLWrapT>(gatedPrevAct));
+					if (nzc == prevAct.rows() && !_impl::is_layer_aliasing_activations(phl.l)) {
+						//the gate is completely open, so the layer could be fed directly with the relevant columns of prevAct
+						// as it is done in an ordinary LPH. No rows copying is required.
+						// Layers aliasing their activations (LI) need a persistent matrix, so they take the other branch
+						// (it's still a single copy, that they would have done themselves otherwise)
+						phl.l.fprop(LLWrapT(prevAct, pTBS, phl.coord));
+					} else {
+						//constructing alias to relevant columns of prevAct
+						//const_cast here is just a trick to get necessary pointer. We won't modify the data under it
+						const realmtx_t curPrevAct(const_cast<real_t*>(prevAct.colDataAsVec(phl.coord.m_offset))
+							, prevAct.rows(), phl.coord.m_count, false);
+
+						// fetching relevant rows into gatedPrevAct
+						iM.mExtractRowsByIdx(curPrevAct, pIdxs, gatedPrevAct);
+						gatedPrevAct.set_biases();
+
+						//doing fprop with gatedPrevAct
+						phl.l.fprop(_impl::wrap_trainable_layer<LLWrapT>(gatedPrevAct));
+					}
 
 					//pushing the layer's activations to our's activations				
-					iM.mFillRowsByMask(phl.l.get_activations(), pG, curAct);
+					iM.mFillRowsByIdx(phl.l.get_activations(), pIdxs, curAct);
 				} else {
 					//just zeroing current activations
 					curAct.zeros();
@@ -314,8 +336,8 @@ namespace nntl {
 			NNTL_ASSERT(!m_innerdLdA.emulatesBiases() && !m_innerdLdAPrev.emulatesBiases());
 
 			neurons_count_t firstNeuronOfs = get_neurons_cnt(), lIdx = gated_layers_count;
-			tuple_utils::for_each_exc_first_down(m_phl_tuple, [&firstNeuronOfs, &dLdA, &dLdAPrev
-				, &lIdx, &aPA = m_aPrevActs, &gate = gating_layer().get_activations()
+			tuple_utils::for_each_exc_first_down(m_phl_tuple, [&firstNeuronOfs, &dLdA, &dLdAPrev, &prevAct
+				, &lIdx, &aPA = m_aPrevActs, &gate = gating_layer().get_activations(), pIdxsStor = m_gatedRowsIdxs.get()
 				, &_innerdLdA = m_innerdLdA, &_innerdLdAPrev = m_innerdLdAPrev, _pTmpBiasStorage = m_pTmpBiasStorage
 				, &_Math = get_iMath(), bbs = m_biggestIncBS](const auto& phl)
 			{
@@ -323,7 +345,9 @@ namespace nntl {
 				auto& lyr = phl.l;
 
 				NNTL_ASSERT(lIdx > 0);
-				const real_t*const pG = gate.colDataAsVec(--lIdx);
+				--lIdx;
+				//row indexes were made by the fprop()
+				const vec_len_t*const pIdxs = pIdxsStor + static_cast<numel_cnt_t>(lIdx)*bbs;
 
 				NNTL_ASSERT(firstNeuronOfs >= lyr.get_neurons_cnt());
 				firstNeuronOfs -= lyr.get_neurons_cnt();
@@ -331,7 +355,7 @@ namespace nntl {
 
 				const auto& prA = aPA[lIdx];
 				NNTL_ASSERT(prA.emulatesBiases());
-				NNTL_ASSERT(prA.rows() == _Math.vCountNonZeros(pG, gate.rows()));
+				NNTL_ASSERT(prA.rows() == _Math.vCountNonZeros(gate.colDataAsVec(lIdx), gate.rows()));
 
 				if (prA.rows()) {
 					//setting up the _innerdLdA
@@ -340,7 +364,7 @@ namespace nntl {
 					NNTL_ASSERT(_innerdLdA.rows() == prA.rows());
 					NNTL_ASSERT(prA.size_no_bias() == mtx_size_t(_innerdLdA.rows(), lyr.get_incoming_neurons_cnt()));
 					auto curdLdA = dLdA.submatrix_cols_no_bias(firstNeuronOfs, _innerdLdA.cols());
-					_Math.mExtractRowsByMask(curdLdA, pG, _innerdLdA);
+					_Math.mExtractRowsByIdx(curdLdA, pIdxs, _innerdLdA);
 
 					//we also must upscale dLdA to reflect the proper batch size --- should we?
 					//_Math.evMulC_ip(_innerdLdA, real_t(dLdA.rows()) / real_t(_innerdLdA.rows()));
@@ -350,8 +374,11 @@ namespace nntl {
 						_innerdLdAPrev.deform(_innerdLdA.rows(), phl.coord.m_count);
 					} else _innerdLdAPrev.deform(0, 0);
 
-					const auto switchMtxs = lyr.bprop(_innerdLdA
-						, LLWrapT(prA, _pTmpBiasStorage, realmtx_t::sNumel(bbs, lyr.get_incoming_neurons_cnt())), _innerdLdAPrev);
+					//the layer must be given the same previous activations as in fprop()
+					const auto switchMtxs = prA.rows() == prevAct.rows() && !_impl::is_layer_aliasing_activations(lyr)
+						? lyr.bprop(_innerdLdA, LLWrapT(prevAct, _pTmpBiasStorage, phl.coord), _innerdLdAPrev)
+						: lyr.bprop(_innerdLdA
+							, LLWrapT(prA, _pTmpBiasStorage, realmtx_t::sNumel(bbs, lyr.get_incoming_neurons_cnt())), _innerdLdAPrev);
 
 					if (bPrevLayerWBprop) {
 						const auto& gatedCurdLdAPrev = switchMtxs ? _innerdLdAPrev : _innerdLdA;
@@ -360,7 +387,7 @@ namespace nntl {
 						//saving curdLdAPrev to dLdAPrev
 						auto curdLdAPrev = dLdAPrev.submatrix_cols_no_bias(phl.coord.m_offset, phl.coord.m_count);
 
-						_Math.mFillRowsByMask(gatedCurdLdAPrev, pG, curdLdAPrev);
+						_Math.mFillRowsByIdx(gatedCurdLdAPrev, pIdxs, curdLdAPrev);
 					}
 				} else {
 					//gate is completely closed and nothing to do here except for zeroing corresponding region of dLdAPrev
@@ -410,7 +437,7 @@ namespace nntl {
 
 		template <typename LowerLayer>
 		unsigned bprop(realmtxdef_t& dLdA, const LowerLayer& lowerLayer, realmtxdef_t& dLdAPrev)noexcept {
-			static_assert(::std::is_base_of<_i_layer_trainable, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_trainable");
+			static_assert(::std::is_base_of<_i_layer_trainable<real_t>, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_trainable");
 			static_assert(!bAssumeFPropOnly, "");
 			return get_self()._lpho_bprop<_impl::wrap_part_trainable_layer<LowerLayer>>(dLdA, dLdAPrev, lowerLayer.get_activations());
 		}
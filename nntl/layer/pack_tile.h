@@ -100,6 +100,16 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //			In that case we don't modify the data_x and therefore shouldn't do anything else on fprop()/bprop() beginning and
 //			ending. So it's a preferred solution, though it'd require more memory.
 //
+// 3. However, when the tiled layer is a plain fully connected layer (or anything else that reports
+//		is_layer_tileable_inplace<>), there's no need to transform anything at all. Such layer is told how many tiles it
+//		processes and applies its weights to each of k column blocks of the original data_x with strided GEMMs, accumulating
+//		dL/dW over the tiles. Its [k*m, a+1] activation matrix is filled as k consecutive [m,a] blocks, which is exactly the
+//		memory layout of the LPT [m, k*a+1] activations (bias columns coincide too, because the first m elements of the tiled
+//		layer's bias column are the ones). Therefore LPT activations are just a view of the tiled layer activations (they are
+//		copied only when LPT activation storage is provided by an upper layer), dLdA needs only a resize and the tiled layer
+//		produces dLdAPrev of the proper [m,k*n] shape directly. That's the default mode for such layers; pass
+//		bTryInplace=false to the LPT template to force the data rolling approach.
+//
 
 #include "_activation_storage.h"
 #include "_pack_.h"
@@ -121,7 +131,8 @@ namespace nntl {
 	// note, that by this time bExpectSpecialDataX is buggy and can not be used, so always pass false for this parameter
 	// moreover, deprecated bExpectSpecialDataX until clarification
 	
-	template<typename FinalPolymorphChild, typename LayerT /*, bool bExpectSpecialDataX*/>
+	// bTryInplace - set to false to prohibit the inplace tiling (#3 above) for is_layer_tileable_inplace<> layers
+	template<typename FinalPolymorphChild, typename LayerT, bool bTryInplace /*, bool bExpectSpecialDataX*/>
 	class _LPT : public _impl::_act_stor<FinalPolymorphChild, typename LayerT::interfaces_t>
 		, public _impl::m_prop_stops_bprop_marker<LayerT>
 	{
@@ -149,6 +160,9 @@ namespace nntl {
 		typedef typename LayerT tiled_layer_t;
 
 		static constexpr bool bAssumeFPropOnly = is_layer_stops_bprop<tiled_layer_t>::value;
+
+		//when set, the tiled layer consumes incoming data directly, see data_x scenario #3 above
+		static constexpr bool bTileInplace = bTryInplace && !bExpectSpecialDataX && is_layer_tileable_inplace<tiled_layer_t>::value;
 		
 	protected:
 		tiled_layer_t& m_tiledLayer;
@@ -164,6 +178,9 @@ namespace nntl {
 		//can't be const, or serialization will not work
 		/*const*/ neurons_count_t m_tiles_count{ 0 };
 
+		//set when m_activations is just a view of m_tiledLayer activations (inplace tiling without external activation storage)
+		bool m_bActivationsAliased{ false };
+
 		//////////////////////////////////////////////////////////////////////////
 		//
 	protected:
@@ -196,6 +213,7 @@ namespace nntl {
 		{
 			NNTL_ASSERT(KTiles > 0 || !"Hey, KTiles MUST be positive!");
 			m_innerLowerLayerActivations.will_emulate_biases();
+			_lpt_setup_tiled_layer();
 		}
 		static constexpr const char _defName[] = "lpt";
 
@@ -223,6 +241,31 @@ namespace nntl {
 			return m_tiledLayer.lossAddendum();
 		}
 
+	protected:
+		template<bool b = bTileInplace>
+		::std::enable_if_t<b> _lpt_setup_tiled_layer()noexcept { m_tiledLayer._lpt_tile_inplace(m_tiles_count); }
+		template<bool b = bTileInplace>
+		::std::enable_if_t<!b> _lpt_setup_tiled_layer()noexcept {}
+
+		void _lpt_alias_activations(const vec_len_t outgBatchSize)noexcept {
+			NNTL_ASSERT(bTileInplace && m_bActivationsAliased);
+			NNTL_ASSERT(m_tiledLayer.get_activations_storage()->numel() >= realmtx_t::sNumel(outgBatchSize, get_neurons_cnt() + 1));
+			//the first outgBatchSize elements of the tiled layer bias column are our biases
+			m_activations.useExternalStorage(outgBatchSize, get_neurons_cnt() + 1
+				, m_tiledLayer.get_activations_storage_mutable()->data(), true);
+		}
+
+	public:
+		//redefining callback for base class to make m_activations a view of the tiled layer activations when possible
+		ErrorCode _act_stor_init_activations(const vec_len_t biggestOutgBS, real_t*const pNewActivationStorage)noexcept {
+			m_bActivationsAliased = bTileInplace && !pNewActivationStorage;
+			if (!m_bActivationsAliased) return _base_class_t::_act_stor_init_activations(biggestOutgBS, pNewActivationStorage);
+
+			_set_activations_shared(false);
+			_lpt_alias_activations(biggestOutgBS);
+			return ErrorCode::Success;
+		}
+
 		//////////////////////////////////////////////////////////////////////////
 		ErrorCode layer_init(_layer_init_data_t& lid, real_t* pNewActivationStorage = nullptr)noexcept {
 			//we must first initialize tiled layer to obtain correct outgoing batch sizes
@@ -246,7 +289,7 @@ namespace nntl {
 
 			//allocating m_innerLowerLayerActivations matrix
 			NNTL_ASSERT(m_innerLowerLayerActivations.emulatesBiases());
-			if (!bExpectSpecialDataX) {
+			if (!bExpectSpecialDataX && !bTileInplace) {
 				//we'll use transformed matrix only if an incoming data is in the non-specialized format
 				if (!m_innerLowerLayerActivations.resize(initD.outgBS.biggest(), m_tiledLayer.get_incoming_neurons_cnt()))
 					return ErrorCode::CantAllocateMemoryForInnerLLActivations;
@@ -278,6 +321,7 @@ namespace nntl {
 		void layer_deinit() noexcept {
 			m_tiledLayer.layer_deinit();
 			m_innerLowerLayerActivations.clear();
+			m_bActivationsAliased = false;
 			//m_innerCD.deinit();
 			_base_class_t::layer_deinit();
 		}
@@ -293,10 +337,19 @@ namespace nntl {
 			const auto tiledOutgBS = m_tiledLayer.on_batch_size_change(tiledIncBS, nullptr);
 			NNTL_ASSERT(tiledOutgBS > 0 && 0 == tiledOutgBS%m_tiles_count);
 
+			if (m_bActivationsAliased) {
+				NNTL_ASSERT(!pNewActivationStorage);
+				//the tiled layer has just restored the biases if necessary
+				m_bActivationsValid = false;
+				const auto outBs = tiledOutgBS / m_tiles_count;
+				_lpt_alias_activations(outBs);
+				return outBs;
+			}
+
 			const auto outBs = _base_class_t::on_batch_size_change(tiledOutgBS / m_tiles_count, pNewActivationStorage);
 
 			//updating supplemental matrices
-			if (!bExpectSpecialDataX)
+			if (!bExpectSpecialDataX && !bTileInplace)
 				m_innerLowerLayerActivations.deform_batch_size_with_biases(tiledIncBS);
 			return outBs;
 		}
@@ -326,12 +379,37 @@ namespace nntl {
 			NNTL_ASSERT(prevAct.test_biases_strict());
 			NNTL_ASSERT(m_innerLowerLayerActivations.emulatesBiases());
 			NNTL_ASSERT(m_innerLowerLayerActivations.size()
-				== realmtx_t::mtx_size_t(m_tiles_count*prevAct.rows(), m_tiledLayer.get_incoming_neurons_cnt() + 1));
+				== typename realmtx_t::mtx_size_t(m_tiles_count*prevAct.rows(), m_tiledLayer.get_incoming_neurons_cnt() + 1));
 			NNTL_ASSERT(m_innerLowerLayerActivations.test_biases_strict());
 
 			get_iMath().mTilingRoll(prevAct, m_innerLowerLayerActivations);
 		}
 		
+		template<typename LLWrapT, bool b = bTileInplace>
+		::std::enable_if_t<!b> _lpt_fprop_tiled(const realmtx_t& prevAct)noexcept {
+			_lpt_fprop_prepareInnerLLAct<LLWrapT>(prevAct);
+			NNTL_ASSERT(m_innerLowerLayerActivations.test_biases_strict());
+
+			m_tiledLayer.fprop(LLWrapT(m_innerLowerLayerActivations));
+
+			get_iMath().mTilingUnroll(m_tiledLayer.get_activations(), m_activations);
+		}
+
+		template<typename LLWrapT, bool b = bTileInplace>
+		::std::enable_if_t<b> _lpt_fprop_tiled(const realmtx_t& prevAct)noexcept {
+			NNTL_ASSERT(prevAct.bBatchInColumn() && prevAct.test_biases_strict());
+			NNTL_ASSERT(prevAct.sample_size() == m_tiles_count*m_tiledLayer.get_incoming_neurons_cnt());
+
+			m_tiledLayer.fprop(LLWrapT(prevAct));
+
+			//the tiled layer activations are k [m,a] blocks, i.e. they are already in the layout of m_activations
+			if (!m_bActivationsAliased) {
+				const auto& tAct = m_tiledLayer.get_activations();
+				NNTL_ASSERT(tAct.numel_no_bias() == m_activations.numel_no_bias());
+				::std::memcpy(m_activations.data(), tAct.data(), tAct.byte_size_no_bias());
+			} else NNTL_ASSERT(m_activations.data() == m_tiledLayer.get_activations().data());
+		}
+
 		template<typename LLWrapT>
 		void _lpt_fprop(const realmtx_t& prevAct)noexcept {
 			NNTL_ASSERT(is_activations_shared() || m_activations.test_biases_strict());
@@ -339,12 +417,7 @@ namespace nntl {
 			auto& iI = get_iInspect();
 			iI.fprop_begin(get_layer_idx(), prevAct, get_common_data().is_training_mode());
 
-			_lpt_fprop_prepareInnerLLAct<LLWrapT>(prevAct);
-			NNTL_ASSERT(m_innerLowerLayerActivations.test_biases_strict());
-
-			m_tiledLayer.fprop(LLWrapT(m_innerLowerLayerActivations));
-
-			get_iMath().mTilingUnroll(m_tiledLayer.get_activations(), m_activations);
+			_lpt_fprop_tiled<LLWrapT>(prevAct);
 
 			NNTL_ASSERT(is_activations_shared() || m_activations.test_biases_strict());
 
@@ -354,8 +427,8 @@ namespace nntl {
 		}
 
 		// in order to implement backprop for the m_tiledLayer, we must provide it with a correct dLdA and dLdAPrev
-		template<typename LLWrapT>
-		unsigned _lpt_bprop(realmtxdef_t& dLdA, realmtxdef_t& dLdAPrev, const realmtx_t& prevAct)noexcept {
+		template<typename LLWrapT, bool b = bTileInplace>
+		::std::enable_if_t<!b, unsigned> _lpt_bprop(realmtxdef_t& dLdA, realmtxdef_t& dLdAPrev, const realmtx_t& prevAct)noexcept {
 			NNTL_ASSERT(is_activations_shared() || m_activations.test_biases_strict());
 			NNTL_ASSERT(prevAct.test_biases_strict());
 
@@ -414,18 +487,47 @@ namespace nntl {
 			return ret;
 		}
 
+		// inplace tiling: dLdA [m,k*a] already has the layout of [k*m,a] dLdA for the m_tiledLayer and the m_tiledLayer
+		// produces [m,k*n] dLdAPrev itself, so there's nothing to transform
+		template<typename LLWrapT, bool b = bTileInplace>
+		::std::enable_if_t<b, unsigned> _lpt_bprop(realmtxdef_t& dLdA, realmtxdef_t& dLdAPrev, const realmtx_t& prevAct)noexcept {
+			NNTL_ASSERT(is_activations_shared() || m_activations.test_biases_strict());
+			NNTL_ASSERT(prevAct.test_biases_strict());
+
+			NNTL_ASSERT(m_bActivationsValid);
+			m_bActivationsValid = false;
+
+			NNTL_ASSERT(get_common_data().is_training_mode());
+			NNTL_ASSERT(dLdA.size() == m_activations.size_no_bias());
+			NNTL_ASSERT((!is_layer_with_bprop<LLWrapT>::value) || dLdAPrev.size() == prevAct.size_no_bias());
+
+			auto& iI = get_iInspect();
+			iI.bprop_begin(get_layer_idx(), dLdA);
+			iI.bprop_finaldLdA(dLdA);
+
+			NNTL_ASSERT(!dLdA.emulatesBiases() && !dLdAPrev.emulatesBiases());
+			dLdA.deform_like_no_bias(m_tiledLayer.get_activations());
+			constexpr bool bProducedLdAPrev = is_layer_with_bprop<LLWrapT>::value;
+			if (!bProducedLdAPrev) dLdAPrev.deform(0, 0);
+
+			const unsigned ret = m_tiledLayer.bprop(dLdA, LLWrapT(prevAct), dLdAPrev);
+
+			iI.bprop_end(ret ? dLdAPrev : dLdA);
+			return ret;
+		}
+
 	public:
 		////////////////////////////////////////////////////////////////////////////
 		
 		template <typename LowerLayer>
 		void fprop(const LowerLayer& lowerLayer)noexcept {
-			static_assert(::std::is_base_of<_i_layer_fprop, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_fprop");
+			static_assert(::std::is_base_of<_i_layer_fprop<real_t>, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_fprop");
 			get_self()._lpt_fprop<_impl::wrap_trainable_layer<LowerLayer>>(lowerLayer.get_activations());
 		}
 
 		template <typename LowerLayer>
 		unsigned bprop(realmtxdef_t& dLdA, const LowerLayer& lowerLayer, realmtxdef_t& dLdAPrev)noexcept {
-			static_assert(::std::is_base_of<_i_layer_trainable, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_trainable");
+			static_assert(::std::is_base_of<_i_layer_trainable<real_t>, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_trainable");
 			static_assert(!bAssumeFPropOnly, "");
 			return get_self()._lpt_bprop<_impl::wrap_trainable_layer<LowerLayer>>(dLdA, dLdAPrev, lowerLayer.get_activations());
 		}
@@ -451,20 +553,20 @@ namespace nntl {
 	// If you need to derive a new class, derive it from _LPT (to make static polymorphism work)
 
 	//to shorten class name to get rid of C4503
-	template <typename LayerT>
-	class LPT final : public _LPT<LPT<LayerT>, LayerT> {
+	template <typename LayerT, bool bTryInplace = true>
+	class LPT final : public _LPT<LPT<LayerT, bTryInplace>, LayerT, bTryInplace> {
 	public:
 		~LPT() noexcept {};
 		LPT(LayerT& tl, neurons_count_t KTiles, const char* pCustomName=nullptr) noexcept
-			: _LPT<LPT<LayerT>, LayerT>(pCustomName, tl, KTiles)
+			: _LPT<LPT<LayerT, bTryInplace>, LayerT, bTryInplace>(pCustomName, tl, KTiles)
 		{};
 
 		LPT(const char* pCustomName, LayerT& tl, neurons_count_t KTiles) noexcept
-			: _LPT<LPT<LayerT>, LayerT>(pCustomName, tl, KTiles)
+			: _LPT<LPT<LayerT, bTryInplace>, LayerT, bTryInplace>(pCustomName, tl, KTiles)
 		{};
 	};
 
-	template <typename LayerT>
-	using layer_pack_tile = typename LPT<LayerT>;
+	template <typename LayerT, bool bTryInplace = true>
+	using layer_pack_tile = typename LPT<LayerT, bTryInplace>;
 
 }
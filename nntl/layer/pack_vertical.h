@@ -49,6 +49,17 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //
 // layer_pack_vertical uses all neurons of the last layer as its activation units and passes all of its input
 // to the input of the first layer.
+//
+// Activations checkpointing. By default every inner layer keeps its activations for the whole fprop()->bprop() window,
+// so the memory required for activations grows linearly with the layers count. With checkpoint_every(k) set (k>1)
+// before the initialization, only every k-th inner layer (and the topmost one) keeps own activations (checkpoints),
+// while the rest of layers of each segment of k layers share k-1 activation buffers owned by the pack. The topmost
+// segment is computed last during fprop(), so its activations are ready for bprop(), and each lower segment is
+// recomputed from its lower checkpoint right before its bprop(). For L layers and k~sqrt(L) that's about 2*sqrt(L)
+// activation buffers instead of L at the cost of one more fprop() of L-L/k layers.
+// During recomputation the common data is_recomputing_fprop() flag is set, so the layers reproduce exactly the same
+// activations (dropout masks are reused, grad_works don't apply the Nesterov momentum again). Other per layer
+// storage (such as dropout masks) is not affected. Inner layers of segments must not change the batch size.
 // 
 #include "_pack_.h"
 #include "_tuple_utils.h"
@@ -104,6 +115,10 @@ namespace nntl {
 
 	protected:
 		_layers m_layers;
+
+		//k-1 shared activation buffers (one per column) for non checkpoint layers, see checkpoint_every()
+		realmtx_t m_ckptPool;
+		unsigned m_checkpointEvery{ 0 };
 		
 	protected:
 		
@@ -141,6 +156,81 @@ namespace nntl {
 		{}
 
 		static constexpr const char _defName[] = "lpv";
+
+		//////////////////////////////////////////////////////////////////////////
+		//activations checkpointing. Must be set before the initialization, 0 or 1 turns it off
+		self_ref_t checkpoint_every(const unsigned k)noexcept {
+			NNTL_ASSERT(m_ckptPool.empty() || !"checkpoint_every() must be set before the initialization");
+			m_checkpointEvery = k;
+			return get_self();
+		}
+		unsigned checkpoint_every()const noexcept { return m_checkpointEvery; }
+		bool is_checkpointing()const noexcept { return m_checkpointEvery > 1; }
+
+	protected:
+		//true for inner layers that use the shared activation buffers
+		bool _lpv_is_ckpt_shared(const size_t i)const noexcept {
+			return is_checkpointing() && i < layers_count - 1 && (i + 1) % m_checkpointEvery;
+		}
+		real_t* _lpv_ckpt_storage(const size_t i)noexcept {
+			if (!_lpv_is_ckpt_shared(i)) return nullptr;
+			NNTL_ASSERT(!m_ckptPool.empty() && (i % m_checkpointEvery) < static_cast<size_t>(m_ckptPool.cols()));
+			return m_ckptPool.colDataAsVec(static_cast<vec_len_t>(i % m_checkpointEvery));
+		}
+		//the shared buffer could be spoiled by another layer, so biases must be restored before the fprop()
+		template<typename LayerT>
+		void _lpv_ckpt_prepare(LayerT& l, const size_t i)const noexcept {
+			if (_lpv_is_ckpt_shared(i)) l.get_activations_storage_mutable()->set_biases();
+		}
+
+		//the pack is initialized before its layers, so iMath must be taken from the init data, not from get_iMath()
+		ErrorCode _lpv_ckpt_init(const BatchSizes& incBS, iMath_t& iM)noexcept {
+			m_ckptPool.clear();
+			if (!is_checkpointing()) return ErrorCode::Success;
+
+			//inner layers of segments must not change the batch size, so the biggest incoming batch size is enough
+			const auto bs = incBS.biggest();
+			numel_cnt_t slotNumel = 0;
+			size_t idx = 0;
+			tuple_utils::for_each_up(m_layers, [&slotNumel, &idx, bs, this](auto& l)noexcept {
+				if (_lpv_is_ckpt_shared(idx)) {
+					slotNumel = ::std::max(slotNumel, realmtx_t::sNumel(bs, l.get_neurons_cnt() + 1));
+				} else if (idx < layers_count - 1) {
+					//a checkpoint must keep its own copy of activations, a view of a shared buffer would be overwritten
+					_impl::forbid_activations_aliasing(l);
+				}
+				++idx;
+			});
+			if (!slotNumel) return ErrorCode::Success;
+			if (!m_ckptPool.resize(static_cast<vec_len_t>(slotNumel), static_cast<vec_len_t>(m_checkpointEvery - 1)))
+				return ErrorCode::CantAllocateMemoryForActivations;
+			iM.first_touch(m_ckptPool);
+			return ErrorCode::Success;
+		}
+
+		//recomputes fprop() of inner layers [first, last] to restore their activations spoiled by upper segments
+		template<typename LLWrapT>
+		void _lpv_recompute(const size_t first, const size_t last, const realmtx_t& prevAct)noexcept {
+			NNTL_ASSERT(first <= last && last < layers_count - 1);
+			const auto& CD = get_common_data();
+			CD._set_recomputing_fprop(true);
+
+			if (0 == first) {
+				_lpv_ckpt_prepare(lowmost_layer(), 0);
+				lowmost_layer().fprop(LLWrapT(prevAct));
+			}
+			size_t idx = 1;
+			tuple_utils::for_eachwp_up(m_layers, [&idx, first, last, this](auto& lcur, auto& lprev, const bool)noexcept {
+				if (idx >= first && idx <= last) {
+					_lpv_ckpt_prepare(lcur, idx);
+					lcur.fprop(lprev);
+				}
+				++idx;
+			});
+
+			CD._set_recomputing_fprop(false);
+		}
+	public:
 				
 		//////////////////////////////////////////////////////////////////////////
 		//and apply function _Func(auto& layer) to each underlying (non-pack) layer here
@@ -199,15 +289,24 @@ namespace nntl {
 			// - we'll be passing dLdA and dLdAPrev arguments of bprop() down to layer stack, therefore we must
 			//		propagate/return max() of layer's max_dLdA_numel as ours lid.max_dLdA_numel.
 			// - layers will be called sequentially, therefore they are safe to use a shared memory.
+			ec = get_self()._lpv_ckpt_init(lid.incBS, lid.commonData.iMath());
+			if (ErrorCode::Success != ec) return ec;
+
 			auto initD = lid.dupe();
-			tuple_utils::for_each_exc_last_up(m_layers, [&ec, &initD, &lid, &failedLayerIdx](auto& l)noexcept {
+			size_t idx = 0;
+			tuple_utils::for_each_exc_last_up(m_layers, [&ec, &initD, &lid, &failedLayerIdx, &idx, this](auto& l)noexcept {
 				if (ErrorCode::Success == ec) {
 					initD.pass_to_upper_layer();
-					ec = l.layer_init(initD);
+					ec = l.layer_init(initD, _lpv_ckpt_storage(idx));
 					if (ErrorCode::Success == ec) {
-						lid.aggregate_from(initD);
+						if (_lpv_is_ckpt_shared(idx) && initD.biggest_outgoing_batch_size() > lid.biggest_incoming_batch_size()) {
+							STDCOUTL("Checkpointed layer " << l.get_layer_name_str() << " must not change the batch size!");
+							ec = ErrorCode::CantAllocateMemoryForActivations;
+							failedLayerIdx = l.get_layer_idx();
+						} else lid.aggregate_from(initD);
 					} else failedLayerIdx = l.get_layer_idx();
 				}
+				++idx;
 			});
 			//separate initialization for the top layer.
 			//doubling the code by intention, because some layers can be incompatible with pNewActivationStorage specification
@@ -230,6 +329,7 @@ namespace nntl {
 
 		void layer_deinit() noexcept {
 			for_each_packed_layer([](auto& l) {l.layer_deinit(); });
+			m_ckptPool.clear();
 			_base_class_t::layer_deinit();
 		}
 
@@ -239,8 +339,9 @@ namespace nntl {
 		}
 
 		vec_len_t on_batch_size_change(vec_len_t incBatchSize, real_t*const pNewActivationStorage = nullptr)noexcept {
-			tuple_utils::for_each_exc_last_up(m_layers, [&incBatchSize](auto& lyr)noexcept {
-				incBatchSize = lyr.on_batch_size_change(incBatchSize);
+			size_t idx = 0;
+			tuple_utils::for_each_exc_last_up(m_layers, [&incBatchSize, &idx, this](auto& lyr)noexcept {
+				incBatchSize = lyr.on_batch_size_change(incBatchSize, _lpv_ckpt_storage(idx++));
 			});
 			return topmost_layer().on_batch_size_change(incBatchSize, pNewActivationStorage);
 		}
@@ -252,9 +353,12 @@ namespace nntl {
 			auto& iI = get_iInspect();
 			iI.fprop_begin(get_layer_idx(), prevAct, get_common_data().is_training_mode());
 
+			_lpv_ckpt_prepare(lowmost_layer(), 0);
 			lowmost_layer().fprop(LLWrapT(prevAct));
 
-			tuple_utils::for_eachwp_up(m_layers, [](auto& lcur, auto& lprev, const bool)noexcept {
+			size_t idx = 1;
+			tuple_utils::for_eachwp_up(m_layers, [&idx, this](auto& lcur, auto& lprev, const bool)noexcept {
+				_lpv_ckpt_prepare(lcur, idx++);
 				lcur.fprop(lprev);
 			});
 			
@@ -278,8 +382,16 @@ namespace nntl {
 			//bool bContBprop = true;
 
 			//tuple_utils::for_eachwn_downfullbp(m_layers, [&mtxIdx, &a_dLdA/*, &bContBprop*/](auto& lcur, auto& lprev, const bool)noexcept {
-			tuple_utils::for_each_down4bprop(m_layers, [&mtxIdx, &a_dLdA/*, &bContBprop*/](auto& lcur, auto& lprev)noexcept {
+			//the topmost segment is the last one computed during fprop(), the others must be recomputed from their checkpoints
+			const size_t k = m_checkpointEvery, topSegment = is_checkpointing() ? (layers_count - 1) / k : 0;
+			size_t idx = layers_count - 1;
+			tuple_utils::for_each_down4bprop(m_layers, [&mtxIdx, &a_dLdA, &idx, k, topSegment, &prevAct, this/*, &bContBprop*/](auto& lcur, auto& lprev)noexcept {
 				//if (bContBprop && lcur.bDoBProp()) {
+					if (is_checkpointing() && idx % k == k - 1 && idx / k < topSegment) {
+						get_self()._lpv_recompute<LLWrapT>(idx + 1 - k, idx - 1, prevAct);
+					}
+					--idx;
+
 					const unsigned nextMtxIdx = mtxIdx ^ 1;
 					a_dLdA[nextMtxIdx]->deform_like_no_bias(lprev.get_activations());
 					NNTL_ASSERT(lprev.get_activations().test_biases_strict());
@@ -314,13 +426,13 @@ namespace nntl {
 		//variation of fprop for normal layer
 		template <typename LowerLayer>
 		void fprop(const LowerLayer& lowerLayer)noexcept {
-			static_assert(::std::is_base_of<_i_layer_fprop, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_fprop");
+			static_assert(::std::is_base_of<_i_layer_fprop<real_t>, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_fprop");
 			get_self()._lpv_fprop<_impl::wrap_trainable_layer<LowerLayer>>(lowerLayer.get_activations());
 		}
 
 		template <typename LowerLayer>
 		unsigned bprop(realmtxdef_t& dLdA, const LowerLayer& lowerLayer, realmtxdef_t& dLdAPrev)noexcept {
-			static_assert(::std::is_base_of<_i_layer_trainable, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_trainable");
+			static_assert(::std::is_base_of<_i_layer_trainable<real_t>, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_trainable");
 			static_assert(!bAssumeFPropOnly, "");
 			return get_self()._lpv_bprop<_impl::wrap_trainable_layer<LowerLayer>>(dLdA, dLdAPrev, lowerLayer.get_activations());
 		}
@@ -93,8 +93,8 @@ namespace nntl {
 		typedef typename output_layer_t::common_data_t common_data_t;
 		typedef typename output_layer_t::_layer_init_data_t _layer_init_data_t;
 
-		typedef typename iMath_t::realmtx_t realmtx_t;
-		typedef typename iMath_t::realmtxdef_t realmtxdef_t;
+		typedef typename output_layer_t::iMath_t::realmtx_t realmtx_t;
+		typedef typename output_layer_t::iMath_t::realmtxdef_t realmtxdef_t;
 
 		typedef _nnet_errs::ErrorCode ErrorCode;
 		typedef ::std::pair<ErrorCode, layer_index_t> layer_error_t;
@@ -418,6 +418,104 @@ namespace nntl {
 		template<typename _L> ::std::enable_if_t<!nntl::layer_has_gradworks<_L>::value> operator()(_L&, const typename _L::real_t)const noexcept {}
 	};
 
+	//magnitude pruning support (see layer/fully_connected_pruned.h)
+	template<typename L, class = ::std::void_t<>>
+	struct layer_has_prune_weights : ::std::false_type {};
+	template<typename L>
+	struct layer_has_prune_weights<L, ::std::void_t<decltype(::std::declval<L&>().prune_weights(typename L::real_t(0)))>> : ::std::true_type {};
+
+	struct hlpr_layer_prune_weights {
+		template<typename _L> ::std::enable_if_t<layer_has_prune_weights<_L>::value> operator()(_L& l, const typename _L::real_t s)const noexcept {
+			const auto b = l.prune_weights(s);
+			NNTL_ASSERT(b || !"prune_weights() failed!");
+			if (!b) STDCOUTL("*** Failed to prune weights of layer " << l.get_layer_name_str());
+		}
+		template<typename _L> ::std::enable_if_t<!layer_has_prune_weights<_L>::value> operator()(_L&, const typename _L::real_t)const noexcept {}
+	};
+
+	//gradual pruning schedule s(t) = s_f*(1 - (1 - (t-t0)/(t1-t0))^3) (Zhu & Gupta, 2017) that's applied every epochsStep
+	// epochs from the beginEpoch to the endEpoch. Call it from the onEpochEndCB of nnet::train():
+	//		pruning_schedule<real_t> ps(real_t(.9), 2, 20);
+	//		nn.train(td, opts, [&lp, &ps](const size_t epochIdx) { ps(lp, epochIdx); return true; });
+	template<typename RealT>
+	struct pruning_schedule {
+		const RealT finalSparsity;
+		const size_t beginEpoch, endEpoch, epochsStep;
+
+		pruning_schedule(const RealT fs, const size_t be, const size_t ee, const size_t es = 1)noexcept
+			: finalSparsity(fs), beginEpoch(be), endEpoch(ee), epochsStep(es)
+		{
+			NNTL_ASSERT(fs > RealT(0) && fs < RealT(1) && be <= ee && es > 0);
+		}
+
+		RealT sparsity_at(const size_t epochIdx)const noexcept {
+			if (epochIdx < beginEpoch) return RealT(0);
+			if (epochIdx >= endEpoch) return finalSparsity;
+			const RealT f = RealT(1) - RealT(epochIdx - beginEpoch) / RealT(endEpoch - beginEpoch);
+			return finalSparsity*(RealT(1) - f*f*f);
+		}
+
+		template<typename LayersT>
+		void operator()(LayersT& lp, const size_t epochIdx)const noexcept {
+			if (epochIdx < beginEpoch || ((epochIdx - beginEpoch) % epochsStep && epochIdx < endEpoch)) return;
+			const RealT s = sparsity_at(epochIdx);
+			if (s <= RealT(0)) return;
+			lp.for_each_layer([s](auto& l) {
+				hlpr_layer_prune_weights()(l, static_cast<typename ::std::remove_reference_t<decltype(l)>::real_t>(s));
+			});
+		}
+	};
+
+	//some grad_works (see distributed/data_parallel.h) defer the weights update from apply_grad() until the whole bprop()
+	// is done. nnet::train() uses this helper to finish the update.
+	template<typename GW, class = ::std::void_t<>>
+	struct gw_has_sync_batch_grad : ::std::false_type {};
+	template<typename GW>
+	struct gw_has_sync_batch_grad<GW, ::std::void_t<decltype(::std::declval<GW&>().sync_batch_grad())>> : ::std::true_type {};
+
+	template<typename L, class = ::std::void_t<>>
+	struct layer_has_gw_sync_batch_grad : ::std::false_type {};
+	template<typename L>
+	struct layer_has_gw_sync_batch_grad<L, ::std::void_t<typename L::grad_works_t>> : gw_has_sync_batch_grad<typename L::grad_works_t> {};
+
+	//every layer must be synced even if some exchange has failed, so there's no pending jobs left. Every weights block of
+	// a layer (see layer_has_weights_blocks) has its own grad_works to sync.
+	struct hlpr_layer_gw_sync_batch_grad {
+		bool bOk{ true };
+
+		template<typename _L> ::std::enable_if_t<layer_has_gw_sync_batch_grad<_L>::value> operator()(_L& l)noexcept {
+			for (unsigned b = 0; b < layer_weights_blocks_cnt<_L>::value; ++b) {
+				if (!layer_gradWorks_block(l, b).sync_batch_grad()) bOk = false;
+			}
+		}
+		template<typename _L> ::std::enable_if_t<!layer_has_gw_sync_batch_grad<_L>::value> operator()(_L&)const noexcept {}
+	};
+
+	//gradient accumulation: nnet::train() marks the boundaries of every effective batch for each grad_works (of each weights
+	// block) with these helpers (see _grad_works::grad_accum_begin() and grad_accum_end())
+	template<typename GW, class = ::std::void_t<>>
+	struct gw_has_grad_accum : ::std::false_type {};
+	template<typename GW>
+	struct gw_has_grad_accum<GW, ::std::void_t<decltype(::std::declval<GW&>().grad_accum_end())>> : ::std::true_type {};
+
+	template<typename L, class = ::std::void_t<>>
+	struct layer_has_gw_grad_accum : ::std::false_type {};
+	template<typename L>
+	struct layer_has_gw_grad_accum<L, ::std::void_t<typename L::grad_works_t>> : gw_has_grad_accum<typename L::grad_works_t> {};
+
+	struct hlpr_layer_gw_grad_accum_begin {
+		template<typename _L> ::std::enable_if_t<layer_has_gw_grad_accum<_L>::value> operator()(_L& l)const noexcept {
+			for (unsigned b = 0; b < layer_weights_blocks_cnt<_L>::value; ++b) layer_gradWorks_block(l, b).grad_accum_begin();
+		}
+		template<typename _L> ::std::enable_if_t<!layer_has_gw_grad_accum<_L>::value> operator()(_L&)const noexcept {}
+	};
+	struct hlpr_layer_gw_grad_accum_end {
+		template<typename _L> ::std::enable_if_t<layer_has_gw_grad_accum<_L>::value> operator()(_L& l)const noexcept {
+			for (unsigned b = 0; b < layer_weights_blocks_cnt<_L>::value; ++b) layer_gradWorks_block(l, b).grad_accum_end();
+		}
+		template<typename _L> ::std::enable_if_t<!layer_has_gw_grad_accum<_L>::value> operator()(_L&)const noexcept {}
+	};
+
 	struct hlpr_layer_apply_func2gradworks_layer {
 		template<typename _L, typename F> ::std::enable_if_t<nntl::layer_has_gradworks<_L>::value> operator()(_L& l, F&& f)noexcept {
 			(::std::forward<F>(f))(l);
@@ -77,7 +77,7 @@ namespace nntl {
 				return m_scale* CD.iMath().loss_deCov<bLowerTriangl, bNumStab>(Vals);
 			}
 
-			template <typename CommonDataT, bool c = calcOnFprop>
+			template <typename CommonDataT, bool c = bCalcOnFProp>
 			::std::enable_if_t<c> on_fprop(const realmtx_t& Vals, const CommonDataT& CD) noexcept {
 				NNTL_ASSERT(!Vals.emulatesBiases());
 				m_Mtx.deform_like(Vals);
@@ -85,7 +85,7 @@ namespace nntl {
 			}
 
 		public:
-			template <typename CommonDataT, bool c = calcOnFprop>
+			template <typename CommonDataT, bool c = bCalcOnFProp>
 			::std::enable_if_t<c> dLossAdd(const realmtx_t& Vals, realmtx_t& dLossdVals, const CommonDataT& CD) const noexcept {
 				NNTL_UNREF(Vals);
 				NNTL_ASSERT(m_Mtx.size() == Vals.size() && Vals.size() == dLossdVals.size());
@@ -97,7 +97,7 @@ namespace nntl {
 
 			// \frac{\partial L}{\partial h_a^m} = \frac{2}{N} \sum_{j\neq a} C_{aj} (h_j^m - \mu_j)
 			// Contrary to what's posted in the paper, correct derivative has 2 in the numerator (instead of 1), because C is symmetrical matrix.
-			template <typename CommonDataT, bool c = calcOnFprop>
+			template <typename CommonDataT, bool c = bCalcOnFProp>
 			::std::enable_if_t<!c> dLossAdd(const realmtx_t& Vals, realmtx_t& dLossdVals, const CommonDataT& CD) const noexcept {
 				NNTL_ASSERT(!Vals.emulatesBiases() && !dLossdVals.emulatesBiases());
 
@@ -50,14 +50,14 @@ namespace loss_addendum {
 			return m_scale* CD.iMath().vSumAbs(Vals);
 		}
 
-		template <typename CommonDataT, bool c = calcOnFprop>
+		template <typename CommonDataT, bool c = bCalcOnFProp>
 		::std::enable_if_t<c> on_fprop(const realmtx_t& Vals, const CommonDataT& CD) noexcept {
 			NNTL_ASSERT(!Vals.emulatesBiases());
 			m_Mtx.deform_like(Vals);
 			CD.iMath().evSign(m_Mtx, Vals);
 		}
 
-		template <typename CommonDataT, bool c = calcOnFprop>
+		template <typename CommonDataT, bool c = bCalcOnFProp>
 		::std::enable_if_t<c> dLossAdd(const realmtx_t& Vals, realmtx_t& dLossdVals, const CommonDataT& CD) const noexcept {
 			NNTL_ASSERT(m_Mtx.size() == Vals.size() && Vals.size() == dLossdVals.size());
 			NNTL_ASSERT(!Vals.emulatesBiases() && !dLossdVals.emulatesBiases());
@@ -65,7 +65,7 @@ namespace loss_addendum {
 			_appendGradient(CD.iMath(), dLossdVals, m_Mtx);
 		}
 
-		template <typename CommonDataT, bool c = calcOnFprop>
+		template <typename CommonDataT, bool c = bCalcOnFProp>
 		::std::enable_if_t<!c> dLossAdd(const realmtx_t& Vals, realmtx_t& dLossdVals, const CommonDataT& CD) const noexcept {
 			NNTL_ASSERT(!Vals.emulatesBiases() && !dLossdVals.emulatesBiases());
 			// yeah, there should be a matrix of sign(Vals), but lets pretend we'll handle it later when we'll read the inspector dump
@@ -74,11 +74,11 @@ namespace loss_addendum {
 		}
 
 	protected:
-		template<typename iMathT, bool c = appendToNZGrad>
+		template<typename iMathT, bool c = bAppendToNZGrad>
 		::std::enable_if_t<c> _appendGradientSign(iMathT& iM, realmtx_t& dLossdVals, const realmtx_t& newGrad)const noexcept {
 			iM.evNZAddScaledSign_ip(dLossdVals, m_scale, newGrad);
 		}
-		template<typename iMathT, bool c = appendToNZGrad>
+		template<typename iMathT, bool c = bAppendToNZGrad>
 		::std::enable_if_t<!c> _appendGradientSign(iMathT& iM, realmtx_t& dLossdVals, const realmtx_t& newGrad)const noexcept {
 			iM.evAddScaledSign_ip(dLossdVals, m_scale, newGrad);
 		}
@@ -50,14 +50,14 @@ namespace loss_addendum {
 			return m_scale*real_t(.5)* CD.iMath().ewSumSquares(Vals);
 		}
 
-		template <typename CommonDataT, bool c = calcOnFprop>
+		template <typename CommonDataT, bool c = bCalcOnFProp>
 		::std::enable_if_t<c> on_fprop(const realmtx_t& Vals, const CommonDataT& CD) noexcept {
 			NNTL_ASSERT(!Vals.emulatesBiases());
 			m_Mtx.deform_like(Vals);
 			Vals.copy_to(m_Mtx);
 		}
 
-		template <typename CommonDataT, bool c = calcOnFprop>
+		template <typename CommonDataT, bool c = bCalcOnFProp>
 		::std::enable_if_t<c> dLossAdd(const realmtx_t& Vals, realmtx_t& dLossdVals, const CommonDataT& CD) const noexcept {
 			NNTL_ASSERT(m_Mtx.size() == Vals.size() && Vals.size() == dLossdVals.size());
 			NNTL_ASSERT(!Vals.emulatesBiases() && !dLossdVals.emulatesBiases());
@@ -65,7 +65,7 @@ namespace loss_addendum {
 			_appendGradient(CD.iMath(), dLossdVals, m_Mtx);
 		}
 
-		template <typename CommonDataT, bool c = calcOnFprop>
+		template <typename CommonDataT, bool c = bCalcOnFProp>
 		::std::enable_if_t<!c> dLossAdd(const realmtx_t& Vals, realmtx_t& dLossdVals, const CommonDataT& CD) const noexcept {
 			NNTL_ASSERT(!Vals.emulatesBiases() && !dLossdVals.emulatesBiases());
 			//CD.iInspect().dLossAddendumScaled(dLossdVals, Vals, m_scale, getName());
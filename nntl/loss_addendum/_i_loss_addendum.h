@@ -63,7 +63,8 @@ namespace loss_addendum {
 
 		//must provide a static constexpr bool calcOnFprop 
 		//static constexpr bool calcOnFprop = false/true;
-		template <typename CommonDataT, bool c = calcOnFprop>
+		//and the default value of c must be calcOnFprop
+		template <typename CommonDataT, bool c>
 		nntl_interface ::std::enable_if_t<c> on_fprop(const realmtx_t& Vals, const CommonDataT& CD) noexcept;
 
 		template <typename CommonDataT>
@@ -180,7 +181,7 @@ namespace loss_addendum {
 
 		public:
 			template <typename CommonDataT>
-			bool init(const mtx_size_t biggestMtx, const CommonDataT& CD) noexcept {
+			bool init(const typename _base_class_t::mtx_size_t biggestMtx, const CommonDataT& CD) noexcept {
 				if (!_base_class_t::init(biggestMtx, CD))return false;
 				return m_Mtx.resize(biggestMtx);
 			}
@@ -158,6 +158,37 @@ namespace nntl {
 //////////////////////////////////////////////////////////////////////////
 
 #include "_defs.h"
+
+//if NNTL_CFG_TRACK_ALLOCATIONS is set, nnet::train() reports heap allocations made during each epoch (between
+// train_epochBegin() and train_epochEnd() of the inspector). Steady state training must not allocate anything.
+// See utils/alloc_tracker.h
+//MUST be the same in all compilation units, DEFINE ON PROJECT-LEVEL
+#if !defined(NNTL_CFG_TRACK_ALLOCATIONS) || 1!=NNTL_CFG_TRACK_ALLOCATIONS
+#define NNTL_CFG_TRACK_ALLOCATIONS 0
+#endif
+#include "utils/alloc_tracker.h"
+
+//if NNTL_CFG_THREADS_TELEMETRY is set, threads::Workers and threads::BgWorkers measure dispatch latency, per-thread
+// busy/idle time and load imbalance of every job and aggregate it per call site tag. Access it with get_telemetry()
+// of the thread pool. NNTL_CFG_THREADS_TELEMETRY_PERF additionally reads per-thread CPU cycles and LLC misses counters
+// with perf_event_open() (Linux only). See interface/threads/telemetry.h
+//MUST be the same in all compilation units, DEFINE ON PROJECT-LEVEL
+#if !defined(NNTL_CFG_THREADS_TELEMETRY) || 1!=NNTL_CFG_THREADS_TELEMETRY
+#define NNTL_CFG_THREADS_TELEMETRY 0
+#endif
+#if !NNTL_CFG_THREADS_TELEMETRY || !defined(NNTL_CFG_THREADS_TELEMETRY_PERF) || 1!=NNTL_CFG_THREADS_TELEMETRY_PERF
+#undef NNTL_CFG_THREADS_TELEMETRY_PERF
+#define NNTL_CFG_THREADS_TELEMETRY_PERF 0
+#endif
+
+//memory allocation policy for smatrix storage, iMath internal storage and nnet temporary storage.
+// Use ::nntl::utils::huge_page_allocator to back big buffers with huge pages. See utils/allocator.h
+//MUST be the same in all compilation units, DEFINE ON PROJECT-LEVEL
+#include "utils/allocator.h"
+#ifndef NNTL_CFG_ALLOCATOR
+#define NNTL_CFG_ALLOCATOR ::nntl::utils::aligned_allocator
+#endif
+
 #include "interface/math/_base.h"
 #include "interface/math/smatrix.h"
 
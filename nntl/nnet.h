@@ -33,6 +33,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <type_traits>
 #include <algorithm>
+#include <atomic>
+#include <thread>
+#include <random>
+#include <sstream>
 #include <filesystem>//for weights persistence
 
 #include "common.h"
@@ -48,7 +52,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "interface/inspectors/gradcheck.h"
 
 //we're using .mat files as a storage for weight saving/loading
-#include "../../nntl/nntl/_supp/io/matfile.h"
+#include "_supp/io/matfile.h"
 
 namespace nntl {
 
@@ -80,6 +84,9 @@ namespace nntl {
 	public:
 		typedef LayersPack layers_pack_t;
 
+		using typename _base_class::iMath_t;
+		using typename _base_class::iThreads_t;
+
  		typedef typename iMath_t::realmtx_t realmtx_t;
  		typedef typename iMath_t::realmtxdef_t realmtxdef_t;
 
@@ -112,7 +119,7 @@ namespace nntl {
 
 		_impl::layers_mem_requirements m_LMR;
 
-		::std::vector<real_t> m_pTmpStor;
+		utils::raw_buffer<real_t, NNTL_CFG_ALLOCATOR> m_pTmpStor;
 
 		//realmtx_t m_batch_x, m_batch_y;
 
@@ -250,6 +257,17 @@ namespace nntl {
 			return trainLoss;
 		}
 		
+#if NNTL_CFG_TRACK_ALLOCATIONS
+		static void _report_allocations(const numel_cnt_t epochIdx)noexcept {
+			const auto& at = utils::alloc_tracker::instance();
+			if (!at.count()) return;
+			STDCOUTL("*** " << at.count() << " heap allocations (" << at.bytes() << " bytes) during epoch " << epochIdx + 1 << ":");
+			at.for_each_tag([](const utils::alloc_tracker::tag_stats& ts) {
+				STDCOUTL("    " << ts.szTag << ": " << ts.count << " allocations, " << ts.bytes << " bytes, biggest " << ts.maxBytes);
+			});
+		}
+#endif//NNTL_CFG_TRACK_ALLOCATIONS
+
 		void _fprop(const realmtx_t& data_x)noexcept {
 			//preparing for evaluation
 			_set_mode_and_batch_size(data_x.batch_size());
@@ -282,6 +300,11 @@ namespace nntl {
 
 			obs.report_results_begin(dataSetId, batchesCnt);
 
+			//the output layer may compute its activations together with the loss value in a single pass
+			auto& outpLayer = m_Layers.output_layer();
+			outpLayer.fuse_activation_with_loss(true);
+			const auto _unfuse = utils::make_scope_exit([&outpLayer]()noexcept { outpLayer.fuse_activation_with_loss(false); });
+
 			for (numel_cnt_t bi = 0; bi < batchesCnt; ++bi) {
 				td.next_subset(bi, cd);
 				lossVal += _calcLoss4batch(td.batchX(), td.batchY());
@@ -401,9 +424,9 @@ namespace nntl {
 			//#BUGBUG ??
 
 			const numel_cnt_t totalTempMemSize = _totalTrainingMemSize(bMiniBatch, batchSize);
-			//m_pTmpStor.reset(new(::std::nothrow)real_t[totalTempMemSize]);
-			//if (nullptr == m_pTmpStor.get()) return ErrorCode::CantAllocateMemoryForTempData;
-			m_pTmpStor.resize(totalTempMemSize);
+			if (!m_pTmpStor.resize(static_cast<size_t>(totalTempMemSize))) return ErrorCode::CantAllocateMemoryForTempData;
+			//dL/dA matrices and layers' temporary memory are processed by worker threads
+			get_iMath().first_touch(m_pTmpStor.data(), m_pTmpStor.byte_size());
 
 			const auto _memUsed = _processTmpStor(bMiniBatch, batchSize);
 			NNTL_ASSERT(totalTempMemSize == _memUsed);
@@ -510,7 +533,6 @@ namespace nntl {
 			//m_batch_x.clear();
 			//m_batch_y.clear();
 			m_pTmpStor.clear();
-			m_pTmpStor.shrink_to_fit();
 		}
 
 		// note that TrainDataT& td doesn't have a const modifier. That's because actually it has to be a statefull modifiable
@@ -533,10 +555,12 @@ namespace nntl {
 
 			if (td.empty()) return _set_last_error(ErrorCode::InvalidTD);
 			if (td.xWidth() != m_Layers.input_layer().get_neurons_cnt()) return _set_last_error(ErrorCode::InvalidInputLayerNeuronsCount);
-			if (!td.isSuitableForOutputOf(m_Layers.output_layer().get_neurons_cnt())) return _set_last_error(ErrorCode::InvalidOutputLayerNeuronsCount);
+			if (!td.isSuitableForOutputOf(m_Layers.output_layer().get_data_y_width())) return _set_last_error(ErrorCode::InvalidOutputLayerNeuronsCount);
 
 			//scheduling deinitialization with scope_exit to forget about return statements
 			utils::scope_exit nnet_deinit([this, &opts, &td, bOrigInspectorActive = get_iInspect().isInspectorActive()]()noexcept {
+				//any fprop()/bprop() outside of train() must update weights immediately
+				get_common_data()._set_grad_accum_step(0, 1);
 				if (opts.ImmediatelyDeinit()) {
 					td.deinit4all();
 					deinit();
@@ -555,6 +579,14 @@ namespace nntl {
 
 			m_bCalcFullLossValue = opts.calcFullLossValue();
 
+			const numel_cnt_t gradAccumSteps = opts.gradAccumSteps();
+			NNTL_ASSERT(gradAccumSteps > 0);
+			if (get_common_data().grad_accum_steps() != opts.gradAccumSteps()) {
+				//grad_works allocate gradient accumulators during initialization
+				get_common_data()._set_grad_accum_steps(opts.gradAccumSteps());
+				require_reinit();
+			}
+
 			//////////////////////////////////////////////////////////////////////////
 			// perform layers initialization, gather temp memory requirements, then allocate and spread temp buffers
 			auto ec = _init4train(td, maxFPropSize, maxBatchSize, bMiniBatch, maxEpoch, opts.bForceReinitTD());
@@ -598,11 +630,24 @@ namespace nntl {
 					const numel_cnt_t numBatches = td.on_next_epoch(epochIdx, get_const_common_data());
 					NNTL_ASSERT(numBatches > 0);
 					iI.train_epochBegin(epochIdx, numBatches);
+#if NNTL_CFG_TRACK_ALLOCATIONS
+					utils::alloc_tracker::instance().reset();
+					utils::alloc_tracker::instance().arm();
+#endif//NNTL_CFG_TRACK_ALLOCATIONS
 
 					for (numel_cnt_t batchIdx = 0; batchIdx < numBatches; ++batchIdx) {
 						iI.train_batchBegin(batchIdx);
 
-						td.on_next_batch(batchIdx, get_const_common_data());
+						{
+							NNTL_ALLOC_TAG("td.on_next_batch");
+							td.on_next_batch(batchIdx, get_const_common_data());
+						}
+
+						//the last effective batch of an epoch might contain less micro-batches
+						const auto gradAccumIdx = batchIdx % gradAccumSteps;
+						get_common_data()._set_grad_accum_step(static_cast<unsigned>(gradAccumIdx)
+							, static_cast<unsigned>(::std::min(gradAccumSteps, numBatches - batchIdx + gradAccumIdx)));
+						if (gradAccumSteps > 1 && 0 == gradAccumIdx) m_Layers.for_each_layer(hlpr_layer_gw_grad_accum_begin());
 
 						const auto& batch_x = td.batchX();
 						const auto& batch_y = td.batchY();
@@ -613,10 +658,29 @@ namespace nntl {
 						NNTL_ASSERT(batch_x.batch_size() == maxBatchSize);
 
 						iI.train_preFprop(batch_x);
-						m_Layers.fprop(batch_x);
+						{
+							NNTL_ALLOC_TAG("fprop");
+							m_Layers.fprop(batch_x);
+						}
 
 						iI.train_preBprop(batch_y);
-						m_Layers.bprop(batch_y);
+						{
+							NNTL_ALLOC_TAG("bprop");
+							m_Layers.bprop(batch_y);
+							//applying accumulated gradients that weren't applied during bprop() (the layer skipped the last
+							// micro-batch of the effective batch)
+							if (gradAccumSteps > 1 && get_const_common_data().is_last_grad_accum_step())
+								m_Layers.for_each_layer_down(hlpr_layer_gw_grad_accum_end());
+							//finishing deferred weight updates (if any), top layers first, because they were deferred first
+							hlpr_layer_gw_sync_batch_grad sbg;
+							m_Layers.for_each_layer_down(sbg);
+							if (!sbg.bOk) {
+							#if NNTL_CFG_TRACK_ALLOCATIONS
+								utils::alloc_tracker::instance().disarm();
+							#endif//NNTL_CFG_TRACK_ALLOCATIONS
+								return _set_last_error(ErrorCode::GradientExchangeFailed);
+							}
+						}
 
 						iI.train_batchEnd();
 					}
@@ -638,12 +702,21 @@ namespace nntl {
 							STDCOUTL(szRep);
 						} else {
 							// #note should depend on bPrioritizeThreads value to relax priorities for callbacks?
+							NNTL_ALLOC_TAG("report_training_progress");
 							const auto trainLoss = _report_training_progress(epochIdx, td, periodTime, opts.observer());
-							if (bCheckForDivergence && trainLoss >= opts.divergenceCheckThreshold())
+							if (bCheckForDivergence && trainLoss >= opts.divergenceCheckThreshold()) {
+							#if NNTL_CFG_TRACK_ALLOCATIONS
+								utils::alloc_tracker::instance().disarm();
+							#endif//NNTL_CFG_TRACK_ALLOCATIONS
 								return _set_last_error(ErrorCode::NNDiverged);
+							}
 						}
 					}
 
+#if NNTL_CFG_TRACK_ALLOCATIONS
+					utils::alloc_tracker::instance().disarm();
+					_report_allocations(epochIdx);
+#endif//NNTL_CFG_TRACK_ALLOCATIONS
 					iI.train_epochEnd();
 
 #if NNTL_DEBUG_CHECK_DENORMALS_ON_EACH_EPOCH
@@ -749,6 +822,20 @@ namespace nntl {
 
 			const layer_index_t m_outputLayerIdx;
 
+			//parallel mode: the check is split between m_workersCnt nnet replicas and this one checks only every
+			// m_workersCnt-th entry starting from m_workerIdx. Entries must be selected the same way by every replica,
+			// therefore m_selRng is seeded identically in all of them and is used instead of nnet's iRng for selection.
+			const thread_id_t m_workerIdx, m_workersCnt;
+			::std::atomic<bool>*const m_pStop;
+			//replicas report problems here instead of ::std::cout, otherwise messages of different threads are interleaved
+			::std::ostringstream*const m_pLog;
+			::std::mt19937_64 m_selRng;
+			numel_cnt_t m_entryIdx;
+			const bool m_bVerbose;
+
+			//directional mode buffers
+			realmtx_t m_direction, m_WBackup;
+
 			//////////////////////////////////////////////////////////////////////////
 			//affected state vars
 			const vec_len_t m__origBatchSize;
@@ -765,8 +852,12 @@ namespace nntl {
 					m_nn.m_Layers.on_batch_size_change(m__origBatchSize);
 				m_nn._unblockLearning();
 			}
-			GradCheckFunctor(nnet& n, const gradcheck_settings<real_t>& ngcSetts)noexcept
+			GradCheckFunctor(nnet& n, const gradcheck_settings<real_t>& ngcSetts, const thread_id_t workerIdx = 0
+				, const thread_id_t workersCnt = 1, const uint64_t selSeed = 0, ::std::atomic<bool>* pStop = nullptr
+				, ::std::ostringstream* pLog = nullptr)noexcept
 				: m_nn(n), m_ngcSetts(ngcSetts), m_outputLayerIdx(n.m_Layers.output_layer().get_layer_idx())
+				, m_workerIdx(workerIdx), m_workersCnt(workersCnt), m_pStop(pStop), m_pLog(pLog), m_selRng(selSeed), m_entryIdx(0)
+				, m_bVerbose(ngcSetts.bVerbose && 0 == workerIdx), m_failedLayerIdx(0)
 				//saving nnet mode & affected state
 				, m__bOrigInTraining(n.get_common_data().is_training_mode())
 				, m__bOrigCalcFullLossValue(n.m_bCalcFullLossValue)
@@ -774,6 +865,7 @@ namespace nntl {
 			{
 				NNTL_ASSERT(m_ngcSetts.evalSetts.dLdA_setts.relErrWarnThrsh <= m_ngcSetts.evalSetts.dLdA_setts.relErrFailThrsh);
 				NNTL_ASSERT(m_ngcSetts.evalSetts.dLdW_setts.relErrWarnThrsh <= m_ngcSetts.evalSetts.dLdW_setts.relErrFailThrsh);
+				NNTL_ASSERT(workersCnt > 0 && workerIdx < workersCnt);
 				m_nn.get_iInspect().gc_init(m_ngcSetts.stepSize);
 
 				m_nn._blockLearning();
@@ -785,39 +877,51 @@ namespace nntl {
 				const vec_len_t biggestBatch = ::std::max(batchSize, m_ngcSetts.onlineBatchSize);
 				m_data.init(biggestBatch == data_x.batch_size() ? 0 : biggestBatch, data_x, &data_y);
 				
-				bool bRet = false;
-				NNTL_ASSERT(m_ngcSetts.onlineBatchSize > 0);
-				if (m_ngcSetts.bVerbose) {
-					STDCOUT(::std::endl << "Performing layerwise gradient check in online mode (check dL/dA and so on)");
-					if (m_ngcSetts.onlineBatchSize > 1) {
-						STDCOUTL(" with a custom batchSize = " << m_ngcSetts.onlineBatchSize);
-					} else STDCOUT(::std::endl);
+				bool bRet = true;
+				if (m_ngcSetts.directionalCnt > 0) {
+					if (m_bVerbose) {
+						STDCOUTL(::std::endl << "Performing directional dL/dW pre-check with a batchSize = " << batchSize);
+					}
+					_launchCheck(_impl::gradcheck_mode::directional, batchSize);
+					bRet = !_bStop();
 				}
-				_launchCheck(_impl::gradcheck_mode::online, m_ngcSetts.onlineBatchSize);
-				if (!m_failedLayerIdx) {
-					if (m_ngcSetts.bVerbose) {
-						STDCOUTL(::std::endl << "Performing layerwise gradient check in batch mode (check dL/dW and so on) with a batchSize = " << batchSize);
+
+				if (bRet && !m_ngcSetts.bDirectionalOnly) {
+					NNTL_ASSERT(m_ngcSetts.onlineBatchSize > 0);
+					if (m_bVerbose) {
+						STDCOUT(::std::endl << "Performing layerwise gradient check in online mode (check dL/dA and so on)");
+						if (m_ngcSetts.onlineBatchSize > 1) {
+							STDCOUTL(" with a custom batchSize = " << m_ngcSetts.onlineBatchSize);
+						} else STDCOUT(::std::endl);
+					}
+					_launchCheck(_impl::gradcheck_mode::online, m_ngcSetts.onlineBatchSize);
+					if (!_bStop()) {
+						if (m_bVerbose) {
+							STDCOUTL(::std::endl << "Performing layerwise gradient check in batch mode (check dL/dW and so on) with a batchSize = " << batchSize);
+						}
+						_launchCheck(_impl::gradcheck_mode::batch, batchSize);
 					}
-					_launchCheck(_impl::gradcheck_mode::batch, batchSize);
-					bRet = !m_failedLayerIdx;
+					bRet = !_bStop();
 				}
 
 				m_data.deinit();
+				m_direction.clear();
+				m_WBackup.clear();
 				return bRet;
 			}
 
 			layer_index_t getFailedLayerIdx()const noexcept { return m_failedLayerIdx; }
 
 			template<typename LayerT> void operator()(LayerT& lyr) noexcept {
-				if (m_failedLayerIdx) return;//do nothing, check has already been failed.
+				if (_bStop()) return;//do nothing, check has already been failed.
 
 				//calling internal layers at first if applicable
 				_checkInnerLayers(lyr);
 
-				if (m_failedLayerIdx) return;//do nothing, check has already been failed.
+				if (_bStop()) return;//do nothing, check has already been failed.
 
 				if (_isLayerIdInList(m_ngcSetts.ignoreLayerIds, lyr.get_layer_idx())) {
-					if (m_ngcSetts.bVerbose) STDCOUTL("*** Skipping layer " << lyr.get_layer_name_str() << " by request.");
+					if (m_bVerbose) STDCOUTL("*** Skipping layer " << lyr.get_layer_name_str() << " by request.");
 					return;
 				}
 
@@ -826,6 +930,10 @@ namespace nntl {
 					_doCheckdLdW(lyr);
 					break;
 
+				case nntl::_impl::gradcheck_mode::directional:
+					_doCheckdLdW_directional(lyr);
+					break;
+
 				case nntl::_impl::gradcheck_mode::online:
 					//we should skip output_layer dLdA checks, because actually we don't compute dL/dA for it. We proceed
 					//straight to the dL/dZ in output_layer...
@@ -833,10 +941,10 @@ namespace nntl {
 					// we most likely encounter wrong dL/dA in underlying layers, therefore it seems acceptable solution.
 					
 					if (lyr.get_layer_idx() != m_outputLayerIdx) {
-						if (m_ngcSetts.bVerbose) STDCOUT(lyr.get_layer_name_str() << ": ");
+						if (m_bVerbose) STDCOUT(lyr.get_layer_name_str() << ": ");
 						//_doCheckdLdA(lyr);
 						_checkdLdA(lyr.get_layer_idx(), lyr.get_neurons_cnt());
-					} else if (m_ngcSetts.bVerbose) STDCOUTL("*** NB: output layer dL/dA check is skipped by design. Assuming "
+					} else if (m_bVerbose) STDCOUTL("*** NB: output layer dL/dA check is skipped by design. Assuming "
 						"it's bugs (if any) will be caught by lower layers dL/dA check");
 					break;
 
@@ -853,16 +961,72 @@ namespace nntl {
 
 			template<typename LayerT>
 			::std::enable_if_t<is_layer_learnable<LayerT>::value> _doCheckdLdW(LayerT& lyr) noexcept {
-				if (m_ngcSetts.bVerbose) STDCOUT(lyr.get_layer_name_str() << ": ");
-				_checkdLdW(lyr.get_layer_idx(), lyr.get_neurons_cnt(), lyr.get_incoming_neurons_cnt());
+				if (m_bVerbose) STDCOUT(lyr.get_layer_name_str() << ": ");
+				_checkdLdW(lyr.get_layer_idx(), lyr.get_neurons_cnt(), lyr.get_incoming_neurons_cnt(), 0, _s_prune_mask(lyr));
+			}
+			//every weights block of a layer with several weights matrices is checked as a separate [rows, cols+1] matrix
+			template<typename LayerT>
+			::std::enable_if_t<!is_layer_learnable<LayerT>::value && layer_has_weights_blocks<LayerT>::value> _doCheckdLdW(LayerT& lyr) noexcept {
+				for (unsigned b = 0; b < LayerT::weights_blocks_cnt && !_bStop(); ++b) {
+					const auto& W = lyr.get_weights_block(b);
+					if (m_bVerbose) STDCOUT(lyr.get_layer_name_str() << ", weights block " << b << ": ");
+					_checkdLdW(lyr.get_layer_idx(), W.rows(), W.cols() - 1, b);
+				}
+			}
+			template<typename LayerT>
+			::std::enable_if_t<!is_layer_learnable<LayerT>::value && !layer_has_weights_blocks<LayerT>::value> _doCheckdLdW(LayerT& ) const noexcept {}
+
+			//the direction must have the shape of the W that the layer passes to iInspect::fprop_makePreActivations()
+			template<typename LayerT>
+			::std::enable_if_t<is_layer_learnable<LayerT>::value> _doCheckdLdW_directional(LayerT& lyr) noexcept {
+				if (m_bVerbose) STDCOUT(lyr.get_layer_name_str() << ": ");
+				_checkdLdW_directional(lyr.get_layer_idx(), lyr.get_weights(), 0, _s_prune_mask(lyr));
+			}
+			template<typename LayerT>
+			::std::enable_if_t<!is_layer_learnable<LayerT>::value && layer_has_weights_blocks<LayerT>::value> _doCheckdLdW_directional(LayerT& lyr) noexcept {
+				for (unsigned b = 0; b < LayerT::weights_blocks_cnt && !_bStop(); ++b) {
+					if (m_bVerbose) STDCOUT(lyr.get_layer_name_str() << ", weights block " << b << ": ");
+					_checkdLdW_directional(lyr.get_layer_idx(), lyr.get_weights_block(b), b);
+				}
 			}
 			template<typename LayerT>
-			::std::enable_if_t<!is_layer_learnable<LayerT>::value> _doCheckdLdW(LayerT& ) const noexcept {}
+			::std::enable_if_t<!is_layer_learnable<LayerT>::value && !layer_has_weights_blocks<LayerT>::value> _doCheckdLdW_directional(LayerT&) const noexcept {}
+
+			//pruned weights (zeros of the mask) are constants, not parameters, so they are left out of dL/dW checks
+			template<typename LayerT>
+			static ::std::enable_if_t<layer_has_prune_mask<LayerT>::value, const realmtx_t*> _s_prune_mask(const LayerT& lyr)noexcept {
+				const auto& m = lyr.get_prune_mask();
+				return m.empty() ? nullptr : &m;
+			}
+			template<typename LayerT>
+			static ::std::enable_if_t<!layer_has_prune_mask<LayerT>::value, const realmtx_t*> _s_prune_mask(const LayerT&)noexcept {
+				return nullptr;
+			}
 
 			void _reset()noexcept {
 				m_failedLayerIdx = 0;
+				m_entryIdx = 0;
 				m_nn.get_iInspect().gc_reset();
 			}
+
+			//true when the check has failed here or in another replica
+			bool _bStop()const noexcept {
+				return m_failedLayerIdx || (m_pStop && m_pStop->load(::std::memory_order_relaxed));
+			}
+			//every replica walks over the same sequence of entries to check and takes only its own part of them
+			bool _isMyEntry()noexcept {
+				return m_workerIdx == static_cast<thread_id_t>((m_entryIdx++) % m_workersCnt);
+			}
+			//a replica sees about 1/m_workersCnt of entries, so it gets the same share of allowed zeroed derivatives
+			neurons_count_t _myShare(const neurons_count_t v)const noexcept {
+				return static_cast<neurons_count_t>((v + m_workersCnt - 1) / m_workersCnt);
+			}
+			template<typename VecT>
+			void _shuffle(VecT& v)noexcept {
+				if (m_workersCnt > 1) {
+					::std::shuffle(v.begin(), v.end(), m_selRng);
+				} else ::std::random_shuffle(v.begin(), v.end(), m_nn.get_iRng());
+			}
 			void _setMode(_impl::gradcheck_mode mode)noexcept {
 				_reset();
 				m_mode = mode;
@@ -896,14 +1060,14 @@ namespace nntl {
 				//NNTL_ASSERT(!pDropoutMask || !pDropoutMask->emulatesBiases());
 
 				const auto checkNeuronsCnt = m_ngcSetts.groupSetts.countToCheck(neuronsCnt);
-				if (m_ngcSetts.bVerbose) STDCOUTL( checkNeuronsCnt << " dL/dA values out of total " << neuronsCnt << "... ");
+				if (m_bVerbose) STDCOUTL( checkNeuronsCnt << " dL/dA values out of total " << neuronsCnt << "... ");
 
 				m_grpIdx.resize(neuronsCnt);
 				::std::iota(m_grpIdx.begin(), m_grpIdx.end(), neurons_count_t(0));
-				::std::random_shuffle(m_grpIdx.begin(), m_grpIdx.end(), m_nn.get_iRng());
+				_shuffle(m_grpIdx);
 				//m_nn.get_iRng().gen_vector_gtz(&m_grpIdx[0], checkNeuronsCnt, neuronsCnt - 1);
 				
-				const neurons_count_t maxZerodLdA = (checkNeuronsCnt*m_ngcSetts.evalSetts.dLdA_setts.percOfZeros) / 100;
+				const neurons_count_t maxZerodLdA = _myShare((checkNeuronsCnt*m_ngcSetts.evalSetts.dLdA_setts.percOfZeros) / 100);
 				neurons_count_t zerodLdA = 0;
 
 				//const auto doubleSs = m_ngcSetts.stepSize * 2;
@@ -913,7 +1077,8 @@ namespace nntl {
 
 				auto& iI = m_nn.get_iInspect();
 				for (neurons_count_t i = 0; i < checkNeuronsCnt; ++i) {
-					if (m_failedLayerIdx) break;
+					if (_bStop()) break;
+					if (!_isMyEntry()) continue;
 
 					auto neurIdx = m_grpIdx[i];
 
@@ -947,19 +1112,21 @@ namespace nntl {
 
 					_checkErr(lIdx, dLan, dLnum, coords, maxZerodLdA, zerodLdA);
 				}
-				if (!m_failedLayerIdx){
+				if (!_bStop()){
 					if (maxZerodLdA && zerodLdA) {
-						STDCOUTL("Note: "<< zerodLdA << " values were zeroed (acceptable up to " << maxZerodLdA << ")");
+						::std::ostringstream os;
+						os << "Note: " << zerodLdA << " values were zeroed (acceptable up to " << maxZerodLdA << ")" << ::std::endl;
+						_say(os);
 					}
 					if (m_ngcSetts.evalSetts.dLdA_setts.percOfZeros >= 100 && maxZerodLdA <= zerodLdA) {
-						STDCOUTL("Warning: all dL/dA was zeroed. It's normal for a setups with LPHG, but error for others");
+						_say("Warning: all dL/dA was zeroed. It's normal for a setups with LPHG, but error for others\n");
 					}
-					if(m_ngcSetts.bVerbose) STDCOUTL("Passed.");
+					if(m_bVerbose) STDCOUTL("Passed.");
 				}
 			}
 
 			void _checkWeight(const layer_index_t lIdx, const mtx_coords_t& coords
-				, const neurons_count_t& maxZerodLdW, neurons_count_t& zerodLdW) noexcept
+				, const neurons_count_t& maxZerodLdW, neurons_count_t& zerodLdW, const unsigned wBlock) noexcept
 			{
 				const auto doubleSs = m_ngcSetts.stepSize * 2;
 				auto& iI = m_nn.get_iInspect();
@@ -969,7 +1136,7 @@ namespace nntl {
 				const bool bLayerMayBeExcluded = _isLayerIdInList(m_ngcSetts.layerCanSkipExecIds, lIdx);
 				const size_t s = m_ngcSetts.bForceSeed ? ::std::time(0) : 0;
 
-				iI.gc_prep_check_layer(lIdx, _impl::gradcheck_paramsGroup::dLdW, coords, bLayerMayBeExcluded);
+				iI.gc_prep_check_layer(lIdx, _impl::gradcheck_paramsGroup::dLdW, coords, bLayerMayBeExcluded, wBlock);
 
 				//_prepNetToBatchSize(false, m_data.batchX().batch_size());
 
@@ -993,66 +1160,110 @@ namespace nntl {
 				_checkErr(lIdx, dLan, dLnum, coords, maxZerodLdW, zerodLdW);
 			}
 
-			void _checkdLdW(const layer_index_t lIdx, const neurons_count_t neuronsCnt, const neurons_count_t incNeuronsCnt)noexcept
+			void _checkdLdW(const layer_index_t lIdx, const neurons_count_t neuronsCnt, const neurons_count_t incNeuronsCnt
+				, const unsigned wBlock = 0, const realmtx_t* pMask = nullptr)noexcept
 			{
 				const auto checkNeuronsCnt = m_ngcSetts.groupSetts.countToCheck(neuronsCnt);
 				const auto checkIncWeightsCnt = m_ngcSetts.subgroupSetts.countToCheck(incNeuronsCnt);
-				if (m_ngcSetts.bVerbose) STDCOUTL("dL/dW: " << checkNeuronsCnt << " neurons (out of total " << neuronsCnt
+				if (m_bVerbose) STDCOUTL("dL/dW: " << checkNeuronsCnt << " neurons (out of total " << neuronsCnt
 					<< ") with " << checkIncWeightsCnt << " incoming weights (total " << incNeuronsCnt << ")...");
 				
 				m_grpIdx.resize(neuronsCnt);
 				::std::iota(m_grpIdx.begin(), m_grpIdx.end(), neurons_count_t(0));
-				::std::random_shuffle(m_grpIdx.begin(), m_grpIdx.end(), m_nn.get_iRng());
+				_shuffle(m_grpIdx);
 				//m_nn.get_iRng().gen_vector_gtz(&m_grpIdx[0], checkNeuronsCnt, neuronsCnt - 1);
 
 				m_subgrpIdxs.resize(incNeuronsCnt);
 				::std::iota(m_subgrpIdxs.begin(), m_subgrpIdxs.end(), neurons_count_t(0));
 
-				const neurons_count_t maxZerodLdW = (checkNeuronsCnt*(checkIncWeightsCnt + 1)*m_ngcSetts.evalSetts.dLdW_setts.percOfZeros) / 100;
+				const neurons_count_t maxZerodLdW = _myShare((checkNeuronsCnt*(checkIncWeightsCnt + 1)*m_ngcSetts.evalSetts.dLdW_setts.percOfZeros) / 100);
 				neurons_count_t zerodLdW = 0;
 
 				//prev layer neurons weights
 				for (neurons_count_t i = 0; i < checkNeuronsCnt; ++i) {
-					if (m_failedLayerIdx) break;
+					if (_bStop()) break;
 					auto neurIdx = m_grpIdx[i];
 
-					::std::random_shuffle(m_subgrpIdxs.begin(), m_subgrpIdxs.end(), m_nn.get_iRng());
+					_shuffle(m_subgrpIdxs);
 					//m_nn.get_iRng().gen_vector_gtz(&m_subgrpIdxs[0], checkIncWeightsCnt, incNeuronsCnt - 1);
 
 					for (neurons_count_t j = 0; j < checkIncWeightsCnt; ++j) {
-						if (m_failedLayerIdx) break;
-						_checkWeight(lIdx, mtx_coords_t(neurIdx, m_subgrpIdxs[j]), maxZerodLdW, zerodLdW);
+						if (_bStop()) break;
+						const mtx_coords_t coords(neurIdx, m_subgrpIdxs[j]);
+						//every replica has the same mask, so it doesn't break the entries selection
+						if (pMask && real_t(0) == pMask->get(coords)) continue;
+						if (_isMyEntry()) _checkWeight(lIdx, coords, maxZerodLdW, zerodLdW, wBlock);
 					}
-// 					if (m_ngcSetts.bVerbose && zerodLdW > 0) STDCOUTL("Note, that there was " << zerodLdW << "/" << maxZerodLdW
+// 					if (m_bVerbose && zerodLdW > 0) STDCOUTL("Note, that there was " << zerodLdW << "/" << maxZerodLdW
 // 						<< " zeroed dL/dW's out of total " << checkIncWeightsCnt << " tested.");
 				}
-				if (!m_failedLayerIdx){
-					if (m_ngcSetts.bVerbose) STDCOUTL("Bias weights in dL/dW: " << checkNeuronsCnt 
+				if (!_bStop()){
+					if (m_bVerbose) STDCOUTL("Bias weights in dL/dW: " << checkNeuronsCnt 
 						<< " biases (out of total " << neuronsCnt << ")...");
 
 					//const auto curZeroed = zerodLdW;
 					//bias weights
 					//m_nn.get_iRng().gen_vector_gtz(&m_grpIdx[0], checkNeuronsCnt, neuronsCnt - 1);
-					::std::random_shuffle(m_grpIdx.begin(), m_grpIdx.end(), m_nn.get_iRng());
+					_shuffle(m_grpIdx);
 					for (neurons_count_t i = 0; i < checkNeuronsCnt; ++i) {
-						if (m_failedLayerIdx) break;
-						_checkWeight(lIdx, mtx_coords_t(m_grpIdx[i], incNeuronsCnt), maxZerodLdW, zerodLdW);
+						if (_bStop()) break;
+						if (_isMyEntry()) _checkWeight(lIdx, mtx_coords_t(m_grpIdx[i], incNeuronsCnt), maxZerodLdW, zerodLdW, wBlock);
 					}
 // 					const auto zDiff = curZeroed - zerodLdW;
-// 					if (m_ngcSetts.bVerbose && zDiff > 0) STDCOUTL("Note, that there was " << zDiff
+// 					if (m_bVerbose && zDiff > 0) STDCOUTL("Note, that there was " << zDiff
 // 						<< " zeroed bias's dL/dW's out of total " << checkNeuronsCnt << " tested.");
 				}				
 
-				if (!m_failedLayerIdx){
+				if (!_bStop()){
 					if (maxZerodLdW && zerodLdW) {
-						STDCOUTL("Note: " << zerodLdW << " values were zeroed (acceptable up to " << maxZerodLdW << ")");
+						::std::ostringstream os;
+						os << "Note: " << zerodLdW << " values were zeroed (acceptable up to " << maxZerodLdW << ")" << ::std::endl;
+						_say(os);
 					}
 
 					if (m_ngcSetts.evalSetts.dLdW_setts.percOfZeros >= 100 && maxZerodLdW == zerodLdW) {
-						STDCOUTL("Warning: all dL/dW was zeroed. It can be OK for a setups with LPHG, but it's an error for others");
+						_say("Warning: all dL/dW was zeroed. It can be OK for a setups with LPHG, but it's an error for others\n");
+					}
+					if( m_bVerbose) STDCOUTL("Passed.");
+				}
+			}
+
+			//statistical pre-check: instead of a single weight a whole W is perturbed along a random direction v (each
+			// element is +1 or -1) and the numeric directional derivative is compared with <dL/dW, v>. A single direction
+			// costs the same as a single weight check, but covers every weight of the layer.
+			void _checkdLdW_directional(const layer_index_t lIdx, const realmtx_t& W, const unsigned wBlock = 0
+				, const realmtx_t* pMask = nullptr)noexcept
+			{
+				const auto dirCnt = m_ngcSetts.directionalCnt;
+				if (m_bVerbose) STDCOUTL("dL/dW along " << dirCnt << " random directions...");
+
+				NNTL_ASSERT(!W.emulatesBiases());
+				if (!m_direction.resize(W.size()) || !m_WBackup.resize(W.size())) {
+					_fail(lIdx, "Failed to allocate memory for the directional check", mtx_coords_t(0, 0));
+					return;
+				}
+
+				//there's no reason to allow zeroed directional derivatives
+				const neurons_count_t maxZerodLdW = 0;
+				neurons_count_t zerodLdW = 0;
+
+				auto& iI = m_nn.get_iInspect();
+				for (unsigned d = 0; d < dirCnt; ++d) {
+					if (_bStop()) break;
+					if (!_isMyEntry()) continue;
+
+					m_nn.get_iRng().bernoulli_matrix(m_direction, real_t(.5), real_t(1.), real_t(-1.));
+					if (pMask) {
+						NNTL_ASSERT(pMask->size() == m_direction.size());
+						m_nn.get_iMath().evMul_ip(m_direction, *pMask);
 					}
-					if( m_ngcSetts.bVerbose) STDCOUTL("Passed.");
+
+					iI.gc_set_direction(&m_direction, &m_WBackup);
+					//coordinates are meaningless here, the second one is just a direction index for a report
+					_checkWeight(lIdx, mtx_coords_t(0, static_cast<vec_len_t>(d)), maxZerodLdW, zerodLdW, wBlock);
+					iI.gc_set_direction(nullptr, nullptr);
 				}
+				if (!_bStop() && m_bVerbose) STDCOUTL("Passed.");
 			}
 
 			void _checkErr(const layer_index_t lIdx, const real_t& dLan, const real_t& dLnum, const mtx_coords_t& coords
@@ -1107,25 +1318,36 @@ namespace nntl {
 				}
 			}
 
-			void _say_final(const mtx_coords_t& coords)const noexcept {
-				STDCOUT(" coordinates: (" << coords.first << ", " << coords.second << "). Following data batches were used: ");
+			void _say(const char* s)const noexcept {
+				if (m_pLog) {
+					*m_pLog << s;
+				} else STDCOUT(s);
+			}
+			void _say(const ::std::ostringstream& os)const noexcept { _say(os.str().c_str()); }
+
+			void _say_final(::std::ostringstream& os, const mtx_coords_t& coords)const noexcept {
+				os << " coordinates: (" << coords.first << ", " << coords.second << "). Following data batches were used: ";
 				auto it = m_data.curBatchIdxs();
 				const auto itE = m_data.curBatchIdxsEnd();
 				while (it < itE) {
-					STDCOUT(*it++ << ",");
+					os << *it++ << ",";
 				}
-				STDCOUT(::std::endl);
+				os << ::std::endl;
+				_say(os);
 			}
 
 			void _warn(const char* reason, const mtx_coords_t& coords)const noexcept {
-				STDCOUT("Warning: " << reason << ::std::endl << "Entry");
-				_say_final(coords);
+				::std::ostringstream os;
+				os << "Warning: " << reason << ::std::endl << "Entry";
+				_say_final(os, coords);
 			}
 
 			void _fail(const layer_index_t lIdx, const char* reason, const mtx_coords_t& coords)noexcept {
 				m_failedLayerIdx = lIdx;
-				STDCOUT("FAILED!" << ::std::endl << reason << ::std::endl << "Failed entry ");
-				_say_final(coords);
+				if (m_pStop) m_pStop->store(true, ::std::memory_order_relaxed);
+				::std::ostringstream os;
+				os << "FAILED!" << ::std::endl << reason << ::std::endl << "Failed entry ";
+				_say_final(os, coords);
 			}
 
 			real_t _calcLossF(const size_t s)noexcept {
@@ -1165,6 +1387,87 @@ namespace nntl {
 		bool gradcheck(const realmtx_t& data_x, const realmtx_t& data_y
 			, const vec_len_t batchSize = 5
 			, const gradcheck_settings<real_t>& ngcSetts = gradcheck_settings<real_t>())noexcept
+		{
+			if (!_gradcheck_init(data_x, data_y, batchSize, ngcSetts)) return false;
+			
+			//walking over each and every layer in the stack and checking the gradients
+			GradCheckFunctor gcf(*this, ngcSetts);
+
+			bool bOk = gcf.performCheck(batchSize, data_x, data_y);
+			if (bOk) {
+				STDCOUTL("Gradient checks passed!");
+			}else{
+				STDCOUTL("**** Gradient check failed within a layer with idx = " << gcf.getFailedLayerIdx());
+			}
+			return bOk;
+		}
+
+		// Parallel version of gradcheck(). The check is split between this nnet and nnets from the replicas vector, each
+		// of them checks its own disjoint set of entries in a dedicated thread (this nnet works in the calling thread).
+		// Replicas must be distinct objects of the same type (i.e. the same architecture built once more) with their own
+		// layers and iMath object. For the time of the check every nnet is limited to an equal share of its iMath's
+		// threads via iThreads_t::set_active_workers(), so replicas running at the same time don't oversubscribe cores.
+		// Weights of layers exposing get_weights() or weights blocks (see layer_has_weights_blocks) are copied from this nnet
+		// to replicas, weights of other layers must be made identical by the caller. RNG-dependent layers (dropout) are fine, as long as every check is
+		// consistent with itself.
+		bool gradcheck_parallel(const ::std::vector<nnet*>& replicas, const realmtx_t& data_x, const realmtx_t& data_y
+			, const vec_len_t batchSize = 5
+			, const gradcheck_settings<real_t>& ngcSetts = gradcheck_settings<real_t>())noexcept
+		{
+			if (!_gradcheck_init(data_x, data_y, batchSize, ngcSetts)) return false;
+			for (auto pNn : replicas) {
+				NNTL_ASSERT(pNn && pNn != this && &pNn->get_iMath() != &get_iMath());
+				if (!pNn->_gradcheck_init(data_x, data_y, batchSize, ngcSetts)) return false;
+				if (!_copy_weights_to(*pNn)) {
+					STDCOUTL("Failed to copy weights to a replica, probably it has a different architecture");
+					return false;
+				}
+			}
+
+			const auto workersCnt = static_cast<thread_id_t>(replicas.size() + 1);
+			//every replica must select the same entries to check
+			const uint64_t selSeed = (static_cast<uint64_t>(get_iRng()()) << 32) ^ static_cast<uint64_t>(get_iRng()());
+			::std::atomic<bool> bStop(false);
+			::std::vector<layer_index_t> failedIdx(workersCnt, 0);
+			::std::vector<::std::ostringstream> logs(workersCnt);
+
+			auto fnWorker = [&](nnet& nn, const thread_id_t wIdx)noexcept {
+				auto& thr = nn.get_iMath().ithreads();
+				const auto origActive = thr.active_workers();
+				thr.set_active_workers(::std::max(thread_id_t(1), thr.cur_workers_count() / workersCnt));
+				{
+					GradCheckFunctor gcf(nn, ngcSetts, wIdx, workersCnt, selSeed, &bStop, &logs[wIdx]);
+					gcf.performCheck(batchSize, data_x, data_y);
+					failedIdx[wIdx] = gcf.getFailedLayerIdx();
+				}
+				thr.set_active_workers(origActive);
+			};
+
+			::std::vector<::std::thread> thrds;
+			thrds.reserve(replicas.size());
+			for (thread_id_t i = 1; i < workersCnt; ++i) {
+				thrds.emplace_back(fnWorker, ::std::ref(*replicas[i - 1]), i);
+			}
+			fnWorker(*this, 0);
+			for (auto& t : thrds) t.join();
+
+			for (thread_id_t i = 0; i < workersCnt; ++i) {
+				const auto s = logs[i].str();
+				if (!s.empty()) STDCOUT("Replica " << i << ":" << ::std::endl << s);
+			}
+
+			const auto it = ::std::find_if(failedIdx.cbegin(), failedIdx.cend(), [](const layer_index_t i)noexcept { return i != 0; });
+			if (it == failedIdx.cend()) {
+				STDCOUTL("Gradient checks passed (" << workersCnt << " replicas)!");
+				return true;
+			}
+			STDCOUTL("**** Gradient check failed within a layer with idx = " << *it);
+			return false;
+		}
+
+	protected:
+		bool _gradcheck_init(const realmtx_t& data_x, const realmtx_t& data_y
+			, const vec_len_t batchSize, const gradcheck_settings<real_t>& ngcSetts)noexcept
 		{
 			static_assert(inspector::is_gradcheck_inspector<iInspect_t>::value
 				, "In order to perform numeric gradient check derive nnet's inspector from inspectors::GradCheck!");
@@ -1177,11 +1480,11 @@ namespace nntl {
 			const auto biggestBatchSize = ::std::max(batchSize, ngcSetts.onlineBatchSize);
 
 			NNTL_ASSERT(data_x.sample_size() == m_Layers.input_layer().get_neurons_cnt() && data_x.batch_size() >= biggestBatchSize);
-			NNTL_ASSERT(data_y.sample_size() == m_Layers.output_layer().get_neurons_cnt() && data_y.batch_size() >= biggestBatchSize);
+			NNTL_ASSERT(data_y.sample_size() == m_Layers.output_layer().get_data_y_width() && data_y.batch_size() >= biggestBatchSize);
 			NNTL_ASSERT(data_x.batch_size() == data_y.batch_size());
 			if (
 				!(data_x.sample_size() == m_Layers.input_layer().get_neurons_cnt() && data_x.batch_size() >= biggestBatchSize)
-				|| !(data_y.sample_size() == m_Layers.output_layer().get_neurons_cnt() && data_y.batch_size() >= biggestBatchSize)
+				|| !(data_y.sample_size() == m_Layers.output_layer().get_data_y_width() && data_y.batch_size() >= biggestBatchSize)
 				|| !(data_x.batch_size() == data_y.batch_size())
 				)
 			{
@@ -1197,19 +1500,84 @@ namespace nntl {
 			if (ErrorCode::Success != ec) {
 				STDCOUTL("Failed to init nnet object for gradcheck. Reason: " << get_error_str(ec));
 				return false;
-			}			
-			
-			//walking over each and every layer in the stack and checking the gradients
-			GradCheckFunctor gcf(*this, ngcSetts);
+			}
+			return true;
+		}
 
-			bool bOk = gcf.performCheck(batchSize, data_x, data_y);
-			if (bOk) {
-				STDCOUTL("Gradient checks passed!");
-			}else{
-				STDCOUTL("**** Gradient check failed within a layer with idx = " << gcf.getFailedLayerIdx());
+		//copies weights of every layer with weights matrices into the same layers of the other nnet of the same type.
+		// Weights are set with set_weights(), so the layers refresh whatever they derive from them (e.g. compressed copies
+		// of LFCP). Masks of pruned weights (see layer_has_prune_mask) are copied along with the weights.
+		bool _copy_weights_to(nnet& dest)noexcept {
+			::std::vector<const realmtx_t*> srcW;
+			m_Layers.for_each_layer([&srcW](auto& l)noexcept {
+				_s_collect_weights(l, srcW);
+			});
+			size_t i = 0;
+			bool bOk = true;
+			dest.m_Layers.for_each_layer([&srcW, &i, &bOk](auto& l)noexcept {
+				_s_restore_weights(l, srcW, i, bOk);
+			});
+			return bOk && i == srcW.size();
+		}
+		template<typename _L>
+		using _has_weights_to_copy = ::std::integral_constant<bool, layer_has_weights_mtx<_L>::value || layer_has_weights_blocks<_L>::value>;
+
+		template<typename _L>
+		static ::std::enable_if_t<_has_weights_to_copy<_L>::value> _s_collect_weights(_L& l, ::std::vector<const realmtx_t*>& v)noexcept {
+			if (!l.has_weights()) return;
+			for (unsigned b = 0; b < layer_weights_blocks_cnt<_L>::value; ++b) v.push_back(&layer_weights_block(l, b));
+			_s_collect_mask(l, v);
+		}
+		//the mask goes right after the weights
+		template<typename _L>
+		static ::std::enable_if_t<layer_has_prune_mask<_L>::value> _s_collect_mask(_L& l, ::std::vector<const realmtx_t*>& v)noexcept {
+			v.push_back(&l.get_prune_mask());
+		}
+		template<typename _L>
+		static ::std::enable_if_t<!layer_has_prune_mask<_L>::value> _s_collect_mask(_L&, ::std::vector<const realmtx_t*>&)noexcept {}
+		template<typename _L>
+		static ::std::enable_if_t<!_has_weights_to_copy<_L>::value> _s_collect_weights(_L&, ::std::vector<const realmtx_t*>&)noexcept {}
+
+		template<typename _L>
+		static ::std::enable_if_t<_has_weights_to_copy<_L>::value> _s_restore_weights(_L& l
+			, const ::std::vector<const realmtx_t*>& v, size_t& i, bool& bOk)noexcept
+		{
+			if (!bOk || !l.has_weights()) return;
+			static constexpr unsigned nBlocks = layer_weights_blocks_cnt<_L>::value;
+			if (i + nBlocks > v.size()) {
+				bOk = false;
+				return;
 			}
-			return bOk;
+			//set_weights() copies the source, views are enough
+			realmtx_t W[nBlocks];
+			for (unsigned b = 0; b < nBlocks; ++b) {
+				const auto& srcW = *v[i + b];
+				if (srcW.size() != layer_weights_block(l, b).size()) {
+					bOk = false;
+					return;
+				}
+				W[b].useExternalStorage(const_cast<real_t*>(srcW.data()), srcW);
+			}
+			i += nBlocks;
+			bOk = _s_set_weights(l, W, v, i);
+		}
+		template<typename _L>
+		static ::std::enable_if_t<layer_has_prune_mask<_L>::value, bool> _s_set_weights(_L& l, const realmtx_t* pW
+			, const ::std::vector<const realmtx_t*>& v, size_t& i)noexcept
+		{
+			return i < v.size() && l.set_weights(*pW, *v[i++]);
 		}
+		template<typename _L>
+		static ::std::enable_if_t<!layer_has_prune_mask<_L>::value, bool> _s_set_weights(_L& l, const realmtx_t* pW
+			, const ::std::vector<const realmtx_t*>&, size_t&)noexcept
+		{
+			return layer_set_weights_blocks(l, pW);
+		}
+		template<typename _L>
+		static ::std::enable_if_t<!_has_weights_to_copy<_L>::value> _s_restore_weights(_L&
+			, const ::std::vector<const realmtx_t*>&, size_t&, bool&)noexcept {}
+
+	public:
 
 
 		//////////////////////////////////////////////////////////////////////////
@@ -83,9 +83,9 @@ namespace nntl {
 		y_data_class_idx_t m_predictionsPP_orYData;//NN predictions and not preprocessed ground truth
 		
 		//data sets id used as indexes in m_ydataPP
-		static_assert(0 <= train_set_id && train_set_id <= 1, "");
-		static_assert(0 <= test_set_id && test_set_id <= 1, "");
-		static_assert(train_set_id != test_set_id, "");
+		static_assert(0 <= DataSetsId::train_set_id && DataSetsId::train_set_id <= 1, "");
+		static_assert(0 <= DataSetsId::test_set_id && DataSetsId::test_set_id <= 1, "");
+		static_assert(DataSetsId::train_set_id != DataSetsId::test_set_id, "");
 
 		real_t m_binarizeThreshold;
 		vec_len_t m_curYOfs;
@@ -204,14 +204,14 @@ namespace nntl {
 	struct eval_classification_one_hot_cached : public i_nnet_evaluator<RealT> {
 	protected:
 		//for each element of Y data (training/testing) contains index of true element class (column number of biggest element in a row)
-		typedef ::std::vector<vec_len_t> idxVec_t;
-		//typedef math::smatrix_deform<vec_len_t> idxVec_t;
+		//Column vectors are preallocated in init() and then only deformed, so correctlyClassified() never allocates
+		typedef math::smatrix_deform<vec_len_t> idxVec_t;
 		typedef ::std::array<idxVec_t, 2> y_data_class_idx_t;
 
 		//data sets id used as indexes in y_data_class_idx_t
-		static_assert(0 <= train_set_id && train_set_id <= 1, "");
-		static_assert(0 <= test_set_id && test_set_id <= 1, "");
-		static_assert(train_set_id != test_set_id, "");
+		static_assert(0 <= DataSetsId::train_set_id && DataSetsId::train_set_id <= 1, "");
+		static_assert(0 <= DataSetsId::test_set_id && DataSetsId::test_set_id <= 1, "");
+		static_assert(DataSetsId::train_set_id != DataSetsId::test_set_id, "");
 
 	protected:
 		y_data_class_idx_t m_ydataClassIdxs;//preprocessed ground truth for train&test sets
@@ -248,13 +248,12 @@ namespace nntl {
 			iM.preinit(iM.mrwIdxsOfMax_needTempMem<real_t>(biggestOutpBatch));
 			iM.init();
 
-			try {
-				m_ydataClassIdxs[train_set_id].resize(trainSamples);
-				m_ydataClassIdxs[test_set_id].resize(testSamples);
-				m_predictionClassOrYDataIdxs[0].resize(biggestOutpBatch);
-				if (td.datasets_count() > 2) m_predictionClassOrYDataIdxs[1].resize(biggestOutpBatch);
-			}catch(const ::std::exception&){
-				NNTL_ASSERT(!"Exception caught while resizing vectors in eval_classification_one_hot_cached::init");
+			if (!m_ydataClassIdxs[train_set_id].resize(static_cast<vec_len_t>(trainSamples), 1)
+				|| !m_ydataClassIdxs[test_set_id].resize(static_cast<vec_len_t>(testSamples), 1)
+				|| !m_predictionClassOrYDataIdxs[0].resize(biggestOutpBatch, 1)
+				|| (td.datasets_count() > 2 && !m_predictionClassOrYDataIdxs[1].resize(biggestOutpBatch, 1)))
+			{
+				NNTL_ASSERT(!"Failed to allocate memory in eval_classification_one_hot_cached::init");
 				deinit();
 				return false;
 			}
@@ -266,7 +265,7 @@ namespace nntl {
 
 		template<typename TrainDataT, typename CommonDataT>
 		void maxYOfDataset(const data_set_id_t dataSetId, TrainDataT& td, idxVec_t& dest, const CommonDataT& cd)const noexcept {
-			NNTL_ASSERT(conform_sign(dest.size()) == td.dataset_samples_count(dataSetId));
+			NNTL_ASSERT(dest.numel() == td.dataset_samples_count(dataSetId));
 
 			auto& iM = cd.iMath();
 			const auto maxBatches = td.walk_over_set(dataSetId, cd, -1, td.flag_exclude_dataX);
@@ -274,7 +273,7 @@ namespace nntl {
 			for (numel_cnt_t bi = 0; bi < maxBatches; ++bi) {
 				td.next_subset(bi, cd);
 
-				iM.mrwIdxsOfMax(td.batchY(), &dest[rOfs]);
+				iM.mrwIdxsOfMax(td.batchY(), dest.data() + rOfs);
 				rOfs += td.batchY().rows();
 			}
 			NNTL_ASSERT(rOfs == td.dataset_samples_count(dataSetId));
@@ -283,9 +282,7 @@ namespace nntl {
 		void deinit()noexcept {
 			for (int i = 0; i <= 1; ++i) {
 				m_ydataClassIdxs[i].clear();
-				m_ydataClassIdxs[i].shrink_to_fit();
 				m_predictionClassOrYDataIdxs[i].clear();
-				m_predictionClassOrYDataIdxs[i].shrink_to_fit();
 			}
 		}
 
@@ -299,20 +296,18 @@ namespace nntl {
 			NNTL_ASSERT(data_y.size() == activations.size());
 			NNTL_ASSERT(data_y.batch_size() <= m_biggestBatch);
 
-			NNTL_ASSERT(conform_sign(m_predictionClassOrYDataIdxs[0].capacity()) >= activations.batch_size());
-			m_predictionClassOrYDataIdxs[0].resize(activations.rows());
-			iM.mrwIdxsOfMax(activations, &m_predictionClassOrYDataIdxs[0][0]);
+			m_predictionClassOrYDataIdxs[0].deform_rows(activations.rows());
+			iM.mrwIdxsOfMax(activations, m_predictionClassOrYDataIdxs[0].data());
 
 			numel_cnt_t ret;
 			if (dataSetId <= 1) {
 				ret = iM.vCountSame(m_ydataClassIdxs[dataSetId], m_predictionClassOrYDataIdxs[0], m_curYOfs);
 				m_curYOfs += activations.rows();
-				NNTL_ASSERT(m_curYOfs <= m_ydataClassIdxs[dataSetId].size());
+				NNTL_ASSERT(m_curYOfs <= m_ydataClassIdxs[dataSetId].rows());
 			} else {
 				//processing data_y into m_predictionsPP_orYData[1]
-				NNTL_ASSERT(conform_sign(m_predictionClassOrYDataIdxs[1].capacity()) >= data_y.rows());
-				m_predictionClassOrYDataIdxs[1].resize(data_y.rows());
-				iM.mrwIdxsOfMax(data_y, &m_predictionClassOrYDataIdxs[1][0]);
+				m_predictionClassOrYDataIdxs[1].deform_rows(data_y.rows());
+				iM.mrwIdxsOfMax(data_y, m_predictionClassOrYDataIdxs[1].data());
 				ret = iM.vCountSame(m_predictionClassOrYDataIdxs[1], m_predictionClassOrYDataIdxs[0]);
 			}
 			return ret;
@@ -324,4 +319,113 @@ namespace nntl {
 		}
 	};
 
+	//////////////////////////////////////////////////////////////////////////
+	// evaluator for ensemble-packed output layers (see layer/fully_connected_ensemble.h). Activations consist of
+	// K == activations.cols()/data_y.cols() blocks of members predictions. correctlyClassified() returns the count for
+	// the averaged over members prediction (as evaluated by BaseEvalT) and also evaluates the prediction of every member.
+	// The latter is available via member_correctly_classified() once the whole dataset has been processed.
+	// The members count must be set with members_count() before the training starts.
+	// Note that every member gets its own BaseEvalT object, so _cached evaluators cache Y data K+1 times.
+	template<typename BaseEvalT>
+	struct eval_ensemble : public i_nnet_evaluator<typename BaseEvalT::real_t> {
+		typedef BaseEvalT base_evaluator_t;
+
+	protected:
+		typedef math::smatrix_deform<real_t> realmtxdef_t;
+
+	protected:
+		base_evaluator_t m_avgEval;
+		::std::vector<base_evaluator_t> m_membersEval;
+		::std::vector<numel_cnt_t> m_membersCorrect;//for the current dataset
+		realmtxdef_t m_avgPrediction;
+
+		vec_len_t m_membersCnt;
+
+	public:
+		~eval_ensemble()noexcept {}
+		//evaluator must be default constructible, so it's possible to set the members count later (but before init())
+		eval_ensemble(const vec_len_t membersCnt = 0)noexcept : m_membersCnt(membersCnt) {}
+
+		vec_len_t members_count()const noexcept { return m_membersCnt; }
+		eval_ensemble& members_count(const vec_len_t membersCnt)noexcept {
+			NNTL_ASSERT(membersCnt > 0 && m_membersEval.empty());
+			m_membersCnt = membersCnt;
+			return *this;
+		}
+
+		base_evaluator_t& averaged_evaluator()noexcept { return m_avgEval; }
+		base_evaluator_t& member_evaluator(const vec_len_t k)noexcept { NNTL_ASSERT(k < m_membersCnt); return m_membersEval[k]; }
+
+		//count of correct predictions of k-th member for the dataset processed last
+		numel_cnt_t member_correctly_classified(const vec_len_t k)const noexcept {
+			NNTL_ASSERT(k < m_membersCnt);
+			return m_membersCorrect[k];
+		}
+
+		template<typename TrainDataT, typename CommonDataT>
+		bool init(TrainDataT& td, const CommonDataT& cd)noexcept {
+			if (m_membersCnt <= 0) {
+				NNTL_ASSERT(!"Set members count first!");
+				return false;
+			}
+			try {
+				m_membersEval.resize(m_membersCnt);
+				m_membersCorrect.assign(m_membersCnt, 0);
+			} catch (const ::std::exception&) {
+				NNTL_ASSERT(!"Exception caught while resizing vectors in eval_ensemble::init");
+				deinit();
+				return false;
+			}
+
+			if (!m_avgPrediction.resize(cd.get_outBatchSizes().biggest(), td.yWidth()) || !m_avgEval.init(td, cd)) {
+				deinit();
+				return false;
+			}
+			for (auto& e : m_membersEval) {
+				if (!e.init(td, cd)) {
+					deinit();
+					return false;
+				}
+			}
+			return true;
+		}
+
+		void deinit()noexcept {
+			m_avgEval.deinit();
+			for (auto& e : m_membersEval) e.deinit();
+			m_membersEval.clear();
+			m_membersEval.shrink_to_fit();
+			m_avgPrediction.clear();
+		}
+
+		void prepare_to_dataset(const data_set_id_t dataSetId, const numel_cnt_t totalBatches)noexcept {
+			m_avgEval.prepare_to_dataset(dataSetId, totalBatches);
+			for (auto& e : m_membersEval) e.prepare_to_dataset(dataSetId, totalBatches);
+			::std::fill(m_membersCorrect.begin(), m_membersCorrect.end(), numel_cnt_t(0));
+		}
+
+		template<typename iMath>
+		numel_cnt_t correctlyClassified(const data_set_id_t dataSetId, const realmtx_t& data_y, const realmtx_t& activations, iMath& iM)noexcept {
+			const auto nOut = data_y.cols(), bs = activations.rows();
+			NNTL_ASSERT(activations.bBatchInColumn() && !activations.emulatesBiases());
+			NNTL_ASSERT(activations.cols() == m_membersCnt*nOut && data_y.rows() == bs);
+
+			m_avgPrediction.deform(bs, nOut);
+			for (vec_len_t k = 0; k < m_membersCnt; ++k) {
+				const realmtx_t mAct(const_cast<real_t*>(activations.colDataAsVec(k*nOut)), bs, nOut);
+				m_membersCorrect[k] += m_membersEval[k].correctlyClassified(dataSetId, data_y, mAct, iM);
+
+				if (0 == k) {
+					const auto b = mAct.copy_to(m_avgPrediction);
+					NNTL_ASSERT(b); NNTL_UNREF(b);
+				} else iM.evAdd_ip(m_avgPrediction, mAct);
+			}
+			if (m_membersCnt > 1) iM.evMulC_ip(m_avgPrediction, real_t(1) / m_membersCnt);
+
+			return m_avgEval.correctlyClassified(dataSetId, data_y, m_avgPrediction, iM);
+		}
+
+		numel_cnt_t totalSamples(const realmtx_t& data_y)noexcept { return m_avgEval.totalSamples(data_y); }
+	};
+
 }
\ No newline at end of file
@@ -116,6 +116,11 @@ namespace nntl {
 		// fit into memory at once. Note that if set, it MUST be >= m_BatchSize
 		vec_len_t m_BatchSize, m_maxFpropSize;
 
+		// gradient accumulation: weights are updated once per m_gradAccumSteps consecutive batches (micro-batches) with
+		// the mean gradient over them, i.e. the effective batch size is m_gradAccumSteps*m_BatchSize, while every
+		// activation and dL/dA buffer is still sized by m_BatchSize (and could fit into a cache). 1 turns it off
+		unsigned m_gradAccumSteps;
+
 		int16_t m_DivergenceCheckLastEpoch;//set to zero to turn off divergence check
 
 		bool m_bCalcFullLossValue;//if set to false, then only the main part of loss function will be calculated 
@@ -137,6 +142,7 @@ namespace nntl {
 
 		void _ctor()noexcept {
 			m_BatchSize = m_maxFpropSize = 0;
+			m_gradAccumSteps = 1;
 			m_DivergenceCheckLastEpoch = 5;
 			m_DivergenceCheckThreshold = real_t(1e5);
 			m_bCalcFullLossValue = true;
@@ -212,6 +218,16 @@ namespace nntl {
 			return *this;
 		}
 
+		//number of micro-batches of batchSize() samples to accumulate gradient over before updating weights. If the number of
+		// batches per epoch isn't a multiple of it, the last effective batch of the epoch will be smaller. The gradient is
+		// averaged over micro-batches that reached the layer's bprop() (see _grad_works::grad_accum_begin()).
+		unsigned gradAccumSteps()const noexcept { return m_gradAccumSteps; }
+		self_t& gradAccumSteps(const unsigned n)noexcept {
+			NNTL_ASSERT(n > 0);
+			m_gradAccumSteps = n ? n : 1;
+			return *this;
+		}
+
 		training_observer_t& observer() noexcept { return m_trainingObserver; }
 
 		bool calcFullLossValue()const noexcept { return m_bCalcFullLossValue; }
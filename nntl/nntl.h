@@ -48,10 +48,14 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "layer/input.h"
 #include "layer/output.h"
 #include "layer/fully_connected.h"
+#include "layer/fully_connected_ensemble.h"
+#include "layer/fully_connected_lowrank.h"
+#include "layer/fully_connected_pruned.h"
 #include "layer/pack_vertical.h"
 #include "layer/pack_horizontal.h"
 #include "layer/identity.h"
 #include "layer/pack_horizontal_optional.h"
 #include "layer/pack_tile.h"
+#include "layer/embedding.h"
 #include "layer/extensions.h"
 #include "nnet.h"
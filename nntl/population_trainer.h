@@ -0,0 +1,242 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//population_trainer trains many small independent nnets simultaneously (hyperparameter sweeps, ensembles, etc).
+//
+//A small net (a few hundred neurons per layer) can't load a lot of cores, because most of iMath kernels fall below their
+// multithreading thresholds. Running such nets one after another (or as independent processes, each reloading the data)
+// wastes either cores or memory. population_trainer owns nothing but a reference to a single read-only
+// inmem_train_data_stor and runs every member of the population in its own thread with its own iMath/iRng and a private
+// iThreads (Workers) object of at most maxThreadsPerMember threads.
+//
+//Cores scheduling: there're totalCores cores to share. Each running member gets at least a single core and the rest
+// are evenly spread among running members (up to maxThreadsPerMember each). As many members as there are cores are
+// running at the same time. When a member finishes (for example, due to early stopping) its cores are either given to
+// a new pending member, or (if there's none left) are handed out to members that are still running, so that the tail of
+// the population finishes faster. Cores are lent via Workers::set_active_workers(), so no threads are created or
+// destroyed for that.
+//
+//Usage:
+//	population_trainer<d_interfaces, real_t> pt(td, 2);
+//	pt.run(membersCount, [&](auto& env) {
+//		//build layers for member env.idx
+//		auto nn = make_nnet(lp, env.iMath, env.iRng);
+//		return nn.train(env.td, opts);
+//	});
+//Note that the functor is called simultaneously from different threads, so it must be thread-safe (for example,
+// STDCOUTL output of different members may interleave).
+
+#include <algorithm>
+#include <ctime>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+#include "interfaces.h"
+#include "_nnet_errs.h"
+#include "train_data/shared_train_data.h"
+
+namespace nntl {
+
+	template<typename InterfacesT, typename XT, typename YT = XT>
+	class population_trainer : public interfaces_td<InterfacesT> {
+		population_trainer(const population_trainer& other)noexcept = delete;
+		population_trainer& operator=(const population_trainer& rhs) noexcept = delete;
+
+		typedef interfaces_td<InterfacesT> _base_class_t;
+
+	public:
+		using typename _base_class_t::iMath_t;
+		using typename _base_class_t::iRng_t;
+		using typename _base_class_t::iThreads_t;
+
+		typedef shared_train_data<XT, YT> member_td_t;
+		typedef typename member_td_t::const_TD_stor_t const_TD_stor_t;
+		typedef _nnet_errs::ErrorCode ErrorCode;
+		typedef typename iRng_t::seed_t seed_t;
+
+		//everything a member of the population needs to train its nnet. The object lives in the member's thread
+		struct member_env {
+			iMath_t iMath;
+			iRng_t iRng;
+			member_td_t td;
+			const numel_cnt_t idx;//index of the member in population
+
+			member_env(const_TD_stor_t& tds, const thread_id_t nThreads, const numel_cnt_t _idx, const seed_t s)noexcept
+				: iMath(nThreads), iRng(), td(tds), idx(_idx)
+			{
+				if (iRng_t::is_multithreaded) {
+					iRng.init_ithreads(iMath.ithreads(), s);
+				} else iRng.seed(s);
+			}
+		};
+
+	protected:
+		struct member_slot {
+			iThreads_t* pThreads{ nullptr };//set only while the member is training
+			thread_id_t cores{ 0 };
+			bool bDone{ false };
+		};
+
+	protected:
+		const_TD_stor_t& m_tdStor;
+		const thread_id_t m_totalCores, m_maxThreadsPerMember;
+
+		::std::mutex m_mtx;
+		::std::condition_variable m_cvDone;
+
+		//all following members are guarded by m_mtx
+		::std::vector<member_slot> m_slots;
+		::std::vector<numel_cnt_t> m_running;
+		::std::vector<ErrorCode> m_results;
+
+	public:
+		~population_trainer()noexcept {}
+
+		population_trainer(const_TD_stor_t& tds, const thread_id_t maxThreadsPerMember = 4
+			, const thread_id_t totalCores = iThreads_t::workers_count())noexcept
+			: m_tdStor(tds), m_totalCores(::std::max(totalCores, thread_id_t(1)))
+			, m_maxThreadsPerMember(::std::max(thread_id_t(1), ::std::min(maxThreadsPerMember, totalCores)))
+		{
+			NNTL_ASSERT(!tds.empty() && maxThreadsPerMember > 0);
+		}
+
+		thread_id_t total_cores()const noexcept { return m_totalCores; }
+		thread_id_t max_threads_per_member()const noexcept { return m_maxThreadsPerMember; }
+
+		//error codes returned by members during the last run()
+		const ::std::vector<ErrorCode>& results()const noexcept { return m_results; }
+
+		//Trains membersCount members and returns when all of them are done. MemberFuncT is ErrorCode(member_env&) functor,
+		// it's called for every member in a dedicated thread. Member #i gets iRng seeded with baseSeed+i.
+		//Returns the number of members that have finished with ErrorCode::Success. See results() for details.
+		template<typename MemberFuncT>
+		numel_cnt_t run(const numel_cnt_t membersCount, MemberFuncT&& fn
+			, const seed_t baseSeed = static_cast<seed_t>(s64to32(::std::time(0))))noexcept
+		{
+			NNTL_ASSERT(membersCount > 0);
+			::std::vector<::std::thread> thrds(static_cast<size_t>(membersCount));
+			::std::vector<numel_cnt_t> finished;
+			finished.reserve(m_totalCores);
+
+			::std::unique_lock<::std::mutex> lk(m_mtx);
+			m_slots.assign(static_cast<size_t>(membersCount), member_slot());
+			m_results.assign(static_cast<size_t>(membersCount), ErrorCode::Success);
+			m_running.clear();
+			m_running.reserve(m_totalCores);
+
+			numel_cnt_t nextIdx = 0;
+			while (true) {
+				//starting pending members while there're free cores. New threads will block on m_mtx until we
+				//call _rebalance() and start waiting
+				while (nextIdx < membersCount && static_cast<thread_id_t>(m_running.size()) < m_totalCores) {
+					m_running.push_back(nextIdx);
+					thrds[nextIdx] = ::std::thread([this, &fn, nextIdx, baseSeed]()noexcept {
+						_member_proc(nextIdx, fn, static_cast<seed_t>(baseSeed + nextIdx));
+					});
+					++nextIdx;
+				}
+				if (m_running.empty()) break;
+
+				_rebalance();
+				m_cvDone.wait(lk, [this]() {
+					for (const auto i : m_running) if (m_slots[i].bDone) return true;
+					return false;
+				});
+
+				finished.clear();
+				m_running.erase(::std::remove_if(m_running.begin(), m_running.end(), [this, &finished](const numel_cnt_t i) {
+					if (m_slots[i].bDone) {
+						finished.push_back(i);
+						return true;
+					}
+					return false;
+				}), m_running.end());
+
+				lk.unlock();
+				for (const auto i : finished) thrds[i].join();
+				lk.lock();
+			}
+
+			NNTL_ASSERT(nextIdx == membersCount);
+			return static_cast<numel_cnt_t>(::std::count(m_results.begin(), m_results.end(), ErrorCode::Success));
+		}
+
+	protected:
+		//must be called under the lock
+		void _rebalance()noexcept {
+			const auto nRunning = static_cast<thread_id_t>(m_running.size());
+			if (!nRunning) return;
+			NNTL_ASSERT(nRunning <= m_totalCores);
+
+			const thread_id_t each = ::std::min(m_maxThreadsPerMember, m_totalCores / nRunning);
+			NNTL_ASSERT(each > 0);
+			thread_id_t extra = m_totalCores - each*nRunning;
+			for (const auto i : m_running) {
+				auto& s = m_slots[i];
+				s.cores = each;
+				if (extra > 0 && each < m_maxThreadsPerMember) {
+					++s.cores;
+					--extra;
+				}
+				if (s.pThreads) s.pThreads->set_active_workers(s.cores);
+			}
+		}
+
+		template<typename MemberFuncT>
+		void _member_proc(const numel_cnt_t idx, MemberFuncT& fn, const seed_t s)noexcept {
+			ErrorCode ec;
+			{
+				member_env env(m_tdStor, m_maxThreadsPerMember, idx, s);
+				{
+					::std::lock_guard<::std::mutex> lk(m_mtx);
+					auto& slot = m_slots[idx];
+					slot.pThreads = &env.iMath.ithreads();
+					slot.pThreads->set_active_workers(slot.cores);
+				}
+
+				ec = fn(env);
+
+				::std::lock_guard<::std::mutex> lk(m_mtx);
+				m_slots[idx].pThreads = nullptr;
+			}
+
+			::std::lock_guard<::std::mutex> lk(m_mtx);
+			m_results[idx] = ec;
+			m_slots[idx].bDone = true;
+			m_cvDone.notify_one();
+		}
+	};
+
+}
@@ -69,9 +69,9 @@ namespace serialization {
 	template<typename T>
 	struct named_struct : public nvp<T> {
 		~named_struct(){};
-		named_struct(const named_struct & rhs) : nvp(static_cast<const nvp&>(rhs)) {}
-		named_struct(const nvp & rhs) : nvp(rhs) {}
-		explicit named_struct(const char * name_, T & t) : nvp(name_, t) {};
+		named_struct(const named_struct & rhs) : nvp<T>(static_cast<const nvp<T>&>(rhs)) {}
+		named_struct(const nvp<T> & rhs) : nvp<T>(rhs) {}
+		explicit named_struct(const char * name_, T & t) : nvp<T>(name_, t) {};
 	};
 
 	template<class T>
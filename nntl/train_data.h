@@ -32,6 +32,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include "train_data/inmem_train_data.h"
+#include "train_data/shared_train_data.h"
 
 #include "train_data/seq_data.h"
 
@@ -43,7 +43,7 @@ namespace _impl {
 	class _td_base : public _i_train_data<XT, YT> {
 	public:
 		typedef FinalPolymorphChild self_t;
-		NNTL_METHODS_SELF_CHECKED((::std::is_base_of<_i_train_data, FinalPolymorphChild>::value)
+		NNTL_METHODS_SELF_CHECKED((::std::is_base_of<_i_train_data<XT, YT>, FinalPolymorphChild>::value)
 			, "FinalPolymorphChild must derive from _i_train_data<FinalPolymorphChild>");
 
 	protected:
@@ -145,8 +145,10 @@ namespace _impl {
 		template<typename ST, typename StatsFuncT>
 		using NormalizerF_tpl = _impl::td_norm<x_t, ST, StatsFuncT>;
 		
-		template<typename StatsT, typename CommonDataT, typename StatsFuncT = typename self_t::default_StatsFuncT
-			, typename NormF = self_t::template NormalizerF_tpl<StatsT, StatsFuncT>>
+		//self_t is incomplete when _td_base is instantiated, so the lookup is made dependent on CommonDataT to defer it
+		template<typename StatsT, typename CommonDataT
+			, typename StatsFuncT = typename ::std::conditional_t<true, self_t, CommonDataT>::default_StatsFuncT
+			, typename NormF = typename ::std::conditional_t<true, self_t, CommonDataT>::template NormalizerF_tpl<StatsT, StatsFuncT>>
 		bool normalize_data(const CommonDataT& cd, const typename NormF::NormalizationSettings_t& Setts, const NormF& n = NormF())noexcept {
 			static_assert(::std::is_same<StatsT, typename NormF::stats_t>::value, "");
 			NNTL_ASSERT(!get_self().empty());
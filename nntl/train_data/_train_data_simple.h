@@ -308,7 +308,7 @@ namespace nntl {
 			//////////////////////////////////////////////////////////////////////////
 			template<typename CommonDataT>
 			numel_cnt_t walk_over_set(const data_set_id_t dataSetId, const CommonDataT& cd
-				, vec_len_t batchSize = -1, const unsigned excludeDataFlag = flag_exclude_nothing)noexcept
+				, vec_len_t batchSize = -1, const unsigned excludeDataFlag = DataSetsId::flag_exclude_nothing)noexcept
 			{
 				NNTL_ASSERT(dataSetId >= 0 && dataSetId < get_self().datasets_count());
 				NNTL_ASSERT(get_self().samplesYStorageCoherent() && get_self().samplesXStorageCoherent());
@@ -50,12 +50,12 @@ namespace nntl {
 
 	public:
 		//resolving definitions clash
-		using base_class_t::x_t;
-		using base_class_t::y_t;
-		using base_class_t::x_mtx_t;
-		using base_class_t::y_mtx_t;
-		using base_class_t::x_mtxdef_t;
-		using base_class_t::y_mtxdef_t;
+		using typename base_class_t::x_t;
+		using typename base_class_t::y_t;
+		using typename base_class_t::x_mtx_t;
+		using typename base_class_t::y_mtx_t;
+		using typename base_class_t::x_mtxdef_t;
+		using typename base_class_t::y_mtxdef_t;
 
 
 	public:
@@ -84,14 +84,14 @@ namespace nntl {
 		// If it was called more than 1 time, effect must be cumulative
 		template<typename MtxUpdT, typename CommonDataT, typename StatsT>
 		void _fix_trainX_whole(const CommonDataT& cd, const typename MtxUpdT::template ScaleCentralData_tpl<StatsT>& st
-			, const data_set_id_t dsId = train_set_id)noexcept
+			, const data_set_id_t dsId = DataSetsId::train_set_id)noexcept
 		{
 			MtxUpdT::whole(cd.get_iMath(), get_self().X_mutable(dsId), st);
 		}
 
 		template<typename MtxUpdT, typename CommonDataT, typename StatsT>
 		void _fix_trainX_cw(const CommonDataT& cd, const typename MtxUpdT::template ScaleCentralVector_tpl<StatsT>& allSt
-			, const data_set_id_t dsId = train_set_id)noexcept
+			, const data_set_id_t dsId = DataSetsId::train_set_id)noexcept
 		{
 			MtxUpdT::batchwise(cd.get_iMath(), get_self().X_mutable(dsId), allSt);
 		}
@@ -0,0 +1,114 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "_train_data_simple.h"
+#include "inmem_train_data_stor.h"
+
+namespace nntl {
+
+	//shared_train_data is an _i_train_data implementation that doesn't own the data, but just references an existing
+	// inmem_train_data_stor object. Every shared_train_data object has its own batch buffers and walking state, so any
+	// number of them may use the same storage simultaneously from different threads (that's what population_trainer does).
+	//
+	//The storage is treated as read-only. Note however, that _train_data_simple hands out non-const pointers to complete
+	// dataset matrices in full-batch mode (X_mutable()/Y_mutable()), so the nnet must not modify its input data
+	// (no standard layer does it).
+	//Normalization isn't supported (normalize the storage once before sharing it).
+	template<typename XT, typename YT = XT>
+	class shared_train_data final : public _impl::_train_data_simple<shared_train_data<XT, YT>, XT, YT> {
+		typedef _impl::_train_data_simple<shared_train_data<XT, YT>, XT, YT> _base_class_t;
+
+	public:
+		using typename _base_class_t::x_t;
+		using typename _base_class_t::y_t;
+		using typename _base_class_t::x_mtx_t;
+		using typename _base_class_t::y_mtx_t;
+		using typename _base_class_t::x_mtxdef_t;
+		using typename _base_class_t::y_mtxdef_t;
+
+		typedef inmem_train_data_stor<XT, YT> TD_stor_t;
+		typedef const TD_stor_t const_TD_stor_t;
+
+	protected:
+		const_TD_stor_t& m_tdStor;
+
+	public:
+		~shared_train_data()noexcept {}
+		shared_train_data(const_TD_stor_t& tds)noexcept : _base_class_t(), m_tdStor(tds) {
+			NNTL_ASSERT(!tds.empty());
+		}
+
+		const_TD_stor_t& get_TDStor()const noexcept { return m_tdStor; }
+
+		//////////////////////////////////////////////////////////////////////////
+		// _i_train_data<> interface
+
+		bool empty()const noexcept { return m_tdStor.empty(); }
+
+		numel_cnt_t dataset_samples_count(data_set_id_t dataSetId)const noexcept {
+			NNTL_ASSERT(!empty());
+			NNTL_ASSERT(dataSetId >= 0 && dataSetId <= 1);
+			return X(dataSetId).batch_size();
+		}
+
+		vec_len_t xWidth()const noexcept { NNTL_ASSERT(!empty()); return X(train_set_id).sample_size(); }
+		vec_len_t yWidth()const noexcept { NNTL_ASSERT(!empty()); return Y(train_set_id).sample_size(); }
+
+		//////////////////////////////////////////////////////////////////////////
+		// functions required by _train_data_simple
+		// #supportsBatchInRow
+		const x_mtxdef_t& X(data_set_id_t dataSetId)const noexcept { return m_tdStor.X(dataSetId); }
+		const y_mtxdef_t& Y(data_set_id_t dataSetId)const noexcept { return m_tdStor.Y(dataSetId); }
+
+		x_mtxdef_t& X_mutable(data_set_id_t dataSetId) noexcept { return const_cast<x_mtxdef_t&>(m_tdStor.X(dataSetId)); }
+		y_mtxdef_t& Y_mutable(data_set_id_t dataSetId) noexcept { return const_cast<y_mtxdef_t&>(m_tdStor.Y(dataSetId)); }
+
+		bool samplesXStorageCoherent()const noexcept { return m_tdStor.samplesXStorageCoherent(); }
+		bool samplesYStorageCoherent()const noexcept { return m_tdStor.samplesYStorageCoherent(); }
+
+		//////////////////////////////////////////////////////////////////////////
+		template<typename MtxUpdT, typename CommonDataT, typename StatsT>
+		void _fix_trainX_whole(const CommonDataT&, const typename MtxUpdT::template ScaleCentralData_tpl<StatsT>&
+			, const data_set_id_t = DataSetsId::train_set_id)noexcept
+		{
+			static_assert(false, "shared_train_data doesn't support normalization, normalize the shared storage instead");
+		}
+		template<typename MtxUpdT, typename CommonDataT, typename StatsT>
+		void _fix_trainX_cw(const CommonDataT&, const typename MtxUpdT::template ScaleCentralVector_tpl<StatsT>&
+			, const data_set_id_t = DataSetsId::train_set_id)noexcept
+		{
+			static_assert(false, "shared_train_data doesn't support normalization, normalize the shared storage instead");
+		}
+	};
+
+}
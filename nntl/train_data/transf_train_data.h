@@ -110,12 +110,12 @@ namespace nntl {
 			typedef _td_base<FinalPolymorphChild, typename TFuncT::x_t, typename TFuncT::y_t> _base_class_t;
 		public:
 			//resolving definitions clash
-			using _base_class_t::x_t;
-			using _base_class_t::y_t;
-			using _base_class_t::x_mtx_t;
-			using _base_class_t::y_mtx_t;
-			using _base_class_t::x_mtxdef_t;
-			using _base_class_t::y_mtxdef_t;
+			using typename _base_class_t::x_t;
+			using typename _base_class_t::y_t;
+			using typename _base_class_t::x_mtx_t;
+			using typename _base_class_t::y_mtx_t;
+			using typename _base_class_t::x_mtxdef_t;
+			using typename _base_class_t::y_mtxdef_t;
 		
 			static_assert(::std::is_base_of<_i_td_transformer<x_t, y_t>, TFuncT>::value, "TFuncT must implement _i_td_transformer");
 			typedef TFuncT TransFunctor_t;
@@ -415,7 +415,7 @@ namespace nntl {
 			//////////////////////////////////////////////////////////////////////////
 			template<typename CommonDataT>
 			numel_cnt_t walk_over_set(const data_set_id_t dataSetId, const CommonDataT& cd
-				, vec_len_t batchSize = -1, const unsigned excludeDataFlag = flag_exclude_nothing)noexcept
+				, vec_len_t batchSize = -1, const unsigned excludeDataFlag = DataSetsId::flag_exclude_nothing)noexcept
 			{
 				NNTL_ASSERT(dataSetId >= 0 && dataSetId < get_self().datasets_count());
 				NNTL_ASSERT(m_tdStor.samplesYStorageCoherent() && m_tdStor.samplesXStorageCoherent());
@@ -520,7 +520,7 @@ namespace nntl {
 			// redefining normalize_data<>() without StatsFuncT parameter. We now have the only global one.
 			// Note that base normalization algo works only in bBatchInColumn() mode, so TransFunctor_t must return
 			// batch matrices in that mode.
-			template<typename StatsT, typename CommonDataT, typename NormF = self_t::template NormalizerF_tpl<StatsT, StatsFunctor_t>>
+			template<typename StatsT, typename CommonDataT, typename NormF = typename ::std::conditional_t<true, self_t, CommonDataT>::template NormalizerF_tpl<StatsT, StatsFunctor_t>>
 			bool normalize_data(const CommonDataT& cd, const typename NormF::NormalizationSettings_t& Setts, const NormF& n = NormF())noexcept {
 				static_assert(::std::is_same<StatsFunctor_t, typename NormF::StatsFunctor_t>::value, "NormF class must have the same StatsFunctor_t");
 				get_self().reset_normalization();
@@ -179,9 +179,9 @@ namespace nntl {
 		typedef ::std::vector<CLASSIFICATION_RESULTS> classif_results_t;
 
 		//data sets id used as indexes in classif_results_t
-		static_assert(0 <= train_set_id && train_set_id <= 1, "");
-		static_assert(0 <= test_set_id && test_set_id <= 1, "");
-		static_assert(train_set_id != test_set_id, "");
+		static_assert(0 <= DataSetsId::train_set_id && DataSetsId::train_set_id <= 1, "");
+		static_assert(0 <= DataSetsId::test_set_id && DataSetsId::test_set_id <= 1, "");
+		static_assert(DataSetsId::train_set_id != DataSetsId::test_set_id, "");
 
 	public:
 		typedef Evaluator evaluator_t;
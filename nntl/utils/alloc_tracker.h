@@ -0,0 +1,177 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//heap allocations tracking instrumentation. Steady state training (and inference) is expected to perform no heap
+// allocations at all, everything must be preallocated during init(). The tracker helps to verify that.
+// When NNTL_CFG_TRACK_ALLOCATIONS is set (see math.h), nnet::train() arms the tracker right after
+// iInspect::train_epochBegin() and disarms it right before iInspect::train_epochEnd(). If any allocation happened in
+// between, a report with allocation counts and sizes per call site tag is printed with STDCOUTL.
+// - allocations made with NNTL_CFG_ALLOCATOR (smatrix storage, iMath and nnet temporary storage) are always counted
+//		when the tracking is on.
+// - to catch ::std::vector growth and any other operator new calls, #include "utils/alloc_tracker_new.h" in exactly one
+//		translation unit. It replaces global operator new/delete.
+// - call sites are identified with NNTL_ALLOC_TAG("name") scoped objects. The tag is thread local, so allocations
+//		done by worker threads are reported as untagged.
+// - alloc_tracker::instance().hard_fail(true) makes an allocation in the armed state to trigger NNTL_ASSERT right at
+//		the allocation point (debug builds only).
+// The tracker itself never allocates.
+
+#include <atomic>
+#include <cstddef>
+
+#include "call_site_tag.h"
+
+namespace nntl {
+namespace utils {
+
+	class alloc_tracker {
+		alloc_tracker(const alloc_tracker& other) = delete;
+		alloc_tracker(alloc_tracker&& other) = delete;
+		alloc_tracker& operator=(const alloc_tracker& rhs) = delete;
+
+	public:
+		//allocations with tags that don't fit into the table are accounted under tags_table_t::szOtherTags
+		typedef call_site_tags_table<64> tags_table_t;
+		typedef call_site_tag<alloc_tracker> call_site_tag_t;
+		typedef call_site_tag_t::scoped scoped_tag;
+
+		static constexpr const char* szUntagged = "<untagged>";
+
+		struct tag_stats {
+			const char* szTag;
+			size_t count;
+			size_t bytes;
+			size_t maxBytes;//the biggest single allocation
+		};
+
+	protected:
+		struct _slot {
+			::std::atomic<size_t> count, bytes, maxBytes;
+		};
+
+		tags_table_t m_tags;
+		_slot m_slots[tags_table_t::sSlots];
+		::std::atomic<size_t> m_count, m_bytes;
+		::std::atomic<bool> m_bArmed, m_bHardFail;
+
+	protected:
+		alloc_tracker()noexcept : m_count(0), m_bytes(0), m_bArmed(false), m_bHardFail(false) {
+			reset();
+		}
+
+		static void _update_max(::std::atomic<size_t>& m, const size_t v)noexcept {
+			auto c = m.load(::std::memory_order_relaxed);
+			while (c < v && !m.compare_exchange_weak(c, v, ::std::memory_order_relaxed)) {}
+		}
+
+		_slot& _find_slot(const char* szTag)noexcept {
+			return m_slots[m_tags.find(szTag ? szTag : szUntagged)];
+		}
+
+	public:
+		static alloc_tracker& instance()noexcept {
+			static alloc_tracker s_tracker;
+			return s_tracker;
+		}
+
+		//to be called from allocation functions
+		void on_alloc(const size_t bytes)noexcept {
+			if (!m_bArmed.load(::std::memory_order_relaxed)) return;
+
+			m_count.fetch_add(1, ::std::memory_order_relaxed);
+			m_bytes.fetch_add(bytes, ::std::memory_order_relaxed);
+
+			auto& s = _find_slot(call_site_tag_t::current());
+			s.count.fetch_add(1, ::std::memory_order_relaxed);
+			s.bytes.fetch_add(bytes, ::std::memory_order_relaxed);
+			_update_max(s.maxBytes, bytes);
+
+			NNTL_ASSERT(!m_bHardFail.load(::std::memory_order_relaxed) || !"Heap allocation while alloc_tracker is armed!");
+		}
+
+		//stats are accumulated over all armed periods until reset()
+		void arm()noexcept { m_bArmed.store(true, ::std::memory_order_release); }
+		void disarm()noexcept { m_bArmed.store(false, ::std::memory_order_release); }
+		bool armed()const noexcept { return m_bArmed.load(::std::memory_order_acquire); }
+
+		//must not be called concurrently with on_alloc() in the armed state
+		void reset()noexcept {
+			m_tags.reset();
+			for (auto& s : m_slots) {
+				s.count.store(0, ::std::memory_order_relaxed);
+				s.bytes.store(0, ::std::memory_order_relaxed);
+				s.maxBytes.store(0, ::std::memory_order_relaxed);
+			}
+			m_count.store(0, ::std::memory_order_relaxed);
+			m_bytes.store(0, ::std::memory_order_release);
+		}
+
+		bool hard_fail()const noexcept { return m_bHardFail.load(::std::memory_order_relaxed); }
+		void hard_fail(const bool b)noexcept { m_bHardFail.store(b, ::std::memory_order_relaxed); }
+
+		size_t count()const noexcept { return m_count.load(::std::memory_order_acquire); }
+		size_t bytes()const noexcept { return m_bytes.load(::std::memory_order_acquire); }
+
+		//calls f(const tag_stats&) for every tag that has allocations
+		template<typename F>
+		void for_each_tag(F&& f)const noexcept {
+			for (unsigned i = 0; i < tags_table_t::sSlots; ++i) {
+				const auto& s = m_slots[i];
+				const auto c = s.count.load(::std::memory_order_acquire);
+				if (c) {
+					f(tag_stats{ m_tags.tag(i), c, s.bytes.load(::std::memory_order_relaxed)
+						, s.maxBytes.load(::std::memory_order_relaxed) });
+				}
+			}
+		}
+
+		//returns stats for the tag or zeros if there were no allocations with it
+		tag_stats get_tag(const char* szTag)const noexcept {
+			const auto i = m_tags.lookup(szTag);
+			if (i >= tags_table_t::sSlots) return tag_stats{ szTag, 0, 0, 0 };
+			const auto& s = m_slots[i];
+			return tag_stats{ szTag, s.count.load(::std::memory_order_acquire), s.bytes.load(::std::memory_order_relaxed)
+				, s.maxBytes.load(::std::memory_order_relaxed) };
+		}
+	};
+
+}
+}
+
+#if NNTL_CFG_TRACK_ALLOCATIONS
+#define NNTL_ALLOC_TAG(szTag) ::nntl::utils::alloc_tracker::scoped_tag NNTL_CONCAT(_nntl_alloc_tag_, __LINE__)(szTag)
+#define NNTL_ALLOC_TRACK(bytes) ::nntl::utils::alloc_tracker::instance().on_alloc(bytes)
+#else
+#define NNTL_ALLOC_TAG(szTag)
+#define NNTL_ALLOC_TRACK(bytes)
+#endif
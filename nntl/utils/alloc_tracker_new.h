@@ -0,0 +1,74 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//replacement of global operator new/delete that reports every allocation to utils::alloc_tracker (see alloc_tracker.h).
+// #include it in EXACTLY ONE translation unit of the executable (after nntl headers).
+// Does nothing unless NNTL_CFG_TRACK_ALLOCATIONS is set.
+
+#if NNTL_CFG_TRACK_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+
+#include "alloc_tracker.h"
+
+namespace nntl {
+namespace utils {
+namespace _impl {
+	inline void* _tracked_malloc(size_t bytes)noexcept {
+		if (!bytes) bytes = 1;
+		NNTL_ALLOC_TRACK(bytes);
+		return ::std::malloc(bytes);
+	}
+	inline void* _tracked_new(const size_t bytes) {
+		const auto p = _tracked_malloc(bytes);
+		if (!p) throw ::std::bad_alloc();
+		return p;
+	}
+}
+}
+}
+
+void* operator new(size_t bytes) { return ::nntl::utils::_impl::_tracked_new(bytes); }
+void* operator new[](size_t bytes) { return ::nntl::utils::_impl::_tracked_new(bytes); }
+void* operator new(size_t bytes, const ::std::nothrow_t&)noexcept { return ::nntl::utils::_impl::_tracked_malloc(bytes); }
+void* operator new[](size_t bytes, const ::std::nothrow_t&)noexcept { return ::nntl::utils::_impl::_tracked_malloc(bytes); }
+
+void operator delete(void* p)noexcept { ::std::free(p); }
+void operator delete[](void* p)noexcept { ::std::free(p); }
+void operator delete(void* p, const ::std::nothrow_t&)noexcept { ::std::free(p); }
+void operator delete[](void* p, const ::std::nothrow_t&)noexcept { ::std::free(p); }
+void operator delete(void* p, size_t)noexcept { ::std::free(p); }
+void operator delete[](void* p, size_t)noexcept { ::std::free(p); }
+
+#endif //NNTL_CFG_TRACK_ALLOCATIONS
@@ -0,0 +1,280 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//memory allocation policies for big buffers: smatrix storage, iMath internal storage (_istor) and nnet temporary
+// storage. The policy is selected with NNTL_CFG_ALLOCATOR (see math.h) and must provide two static functions:
+//		static void* allocate(const size_t bytes, const size_t align)noexcept; //returns nullptr on failure
+//		static void deallocate(void* ptr)noexcept; //ptr may be nullptr
+// Note that only a pointer is available to deallocate().
+// Both allocators report to utils::alloc_tracker when NNTL_CFG_TRACK_ALLOCATIONS is set.
+//
+// - aligned_allocator (default) is a plain aligned heap allocation.
+// - huge_page_allocator maps buffers of at least settings().minBytes bytes directly from the OS using huge pages, which
+//		reduces TLB misses on multi-GB weight and activation buffers. Smaller buffers are allocated from the heap.
+//		Modes (settings().mode):
+//		- Transparent: on Linux the mapping is 2Mb aligned and madvise(MADV_HUGEPAGE)'d, so transparent huge pages are used
+//			when THP is enabled in "madvise" or "always" mode. On Windows it's a plain VirtualAlloc().
+//		- Explicit2M / Explicit1G: explicit huge pages (MAP_HUGETLB on Linux, must be reserved by vm.nr_hugepages or
+//			hugepagesz/hugepages kernel params; MEM_LARGE_PAGES on Windows, requires SeLockMemoryPrivilege). Falls back to
+//			Transparent if the OS refuses.
+//		Mapped memory is untouched, so with the default first-touch NUMA policy pages are placed on the node of a thread
+//		that writes them first. Use iMath's first_touch() to spread pages of a buffer over worker threads the same
+//		way elementwise operations split data.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+
+#include "alloc_tracker.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace nntl {
+namespace utils {
+
+	//////////////////////////////////////////////////////////////////////////
+	// plain aligned heap allocation. align must be a power of 2
+	struct aligned_allocator {
+		static void* allocate(const size_t bytes, const size_t align)noexcept {
+			NNTL_ASSERT(bytes > 0 && align > 0 && !(align & (align - 1)));
+			NNTL_ALLOC_TRACK(bytes);
+#if defined(_WIN32)
+			return _aligned_malloc(bytes, align);
+#else
+			void* p = nullptr;
+			return posix_memalign(&p, align < sizeof(void*) ? sizeof(void*) : align, bytes) ? nullptr : p;
+#endif
+		}
+		static void deallocate(void* ptr)noexcept {
+#if defined(_WIN32)
+			_aligned_free(ptr);
+#else
+			::std::free(ptr);
+#endif
+		}
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	enum class huge_pages {
+		Transparent,
+		Explicit2M,
+		Explicit1G
+	};
+
+	struct huge_page_allocator {
+		struct settings_t {
+			huge_pages mode{ huge_pages::Transparent };
+			//buffers smaller than this are allocated from the heap with aligned_allocator
+			size_t minBytes{ size_t(2) << 20 };
+			//align buffers to the OS base page size instead of the requested alignment. Costs one base page per buffer
+			bool bAlignToPage{ false };
+		};
+
+		//global settings. Change them before allocating anything, they are not thread safe
+		static settings_t& settings()noexcept {
+			static settings_t s;
+			return s;
+		}
+
+		static constexpr size_t sSmallPage = 4096;
+		static constexpr size_t s2M = size_t(2) << 20;
+		static constexpr size_t s1G = size_t(1) << 30;
+
+	protected:
+		enum AllocKind : size_t {
+			heap = 0,
+			mapped,
+			mapped_huge
+		};
+
+		//placed right before the pointer returned to the user
+		struct header {
+			void* pBase;
+			size_t mappedBytes;
+			size_t kind;
+		};
+
+		static size_t _round_up(const size_t v, const size_t to)noexcept { return ((v + to - 1) / to)*to; }
+
+		static void* _finalize(void*const pBase, const size_t mappedBytes, const AllocKind kind, const size_t offs)noexcept {
+			const auto p = static_cast<char*>(pBase) + offs;
+			header*const pH = reinterpret_cast<header*>(p) - 1;
+			pH->pBase = pBase;
+			pH->mappedBytes = mappedBytes;
+			pH->kind = kind;
+			return p;
+		}
+
+	public:
+		static void* allocate(const size_t bytes, const size_t align)noexcept {
+			NNTL_ASSERT(bytes > 0 && align > 0 && !(align & (align - 1)));
+			const auto& S = settings();
+			//the header must fit into the offset and the offset must keep the alignment
+			size_t offs = S.bAlignToPage && align < sSmallPage ? sSmallPage : align;
+			while (offs < sizeof(header)) offs <<= 1;
+
+			if (bytes < S.minBytes) {
+				//reported to the tracker by aligned_allocator
+				const auto pBase = aligned_allocator::allocate(bytes + offs, offs);
+				return pBase ? _finalize(pBase, 0, AllocKind::heap, offs) : nullptr;
+			}
+
+			const size_t total = bytes + offs;
+			NNTL_ALLOC_TRACK(bytes);
+			if (S.mode != huge_pages::Transparent) {
+				const bool b1G = huge_pages::Explicit1G == S.mode;
+			#if defined(_WIN32)
+				NNTL_UNREF(b1G);//Windows decides the large page size itself
+				const size_t lpSize = ::GetLargePageMinimum();
+				if (lpSize) {
+					const size_t mb = _round_up(total, lpSize);
+					const auto pBase = ::VirtualAlloc(nullptr, mb, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+					if (pBase) return _finalize(pBase, mb, AllocKind::mapped_huge, offs);
+				}
+			#else
+				#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+				const size_t hpSize = b1G ? s1G : s2M;
+				const size_t mb = _round_up(total, hpSize);
+				const int hpFlag = MAP_HUGETLB | ((b1G ? 30 : 21) << MAP_HUGE_SHIFT);
+				const auto pBase = ::mmap(nullptr, mb, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | hpFlag, -1, 0);
+				if (MAP_FAILED != pBase) return _finalize(pBase, mb, AllocKind::mapped_huge, offs);
+				#else
+				NNTL_UNREF(b1G);
+				#endif
+			#endif
+			}
+
+		#if defined(_WIN32)
+			const auto pBase = ::VirtualAlloc(nullptr, total, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+			return pBase ? _finalize(pBase, total, AllocKind::mapped, offs) : nullptr;
+		#else
+			//over-allocating to align the start of the buffer to 2Mb, so THP could back it from the beginning
+			const size_t mb = _round_up(total, sSmallPage) + s2M;
+			const auto pMap = ::mmap(nullptr, mb, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (MAP_FAILED == pMap) return nullptr;
+			const auto pAligned = reinterpret_cast<void*>(_round_up(reinterpret_cast<::std::uintptr_t>(pMap), s2M));
+			#if defined(MADV_HUGEPAGE)
+			::madvise(pAligned, mb - static_cast<size_t>(static_cast<char*>(pAligned) - static_cast<char*>(pMap)), MADV_HUGEPAGE);
+			#endif
+			//pMap is kept as the base for munmap(), the buffer starts at the aligned address
+			return _finalize(pMap, mb, AllocKind::mapped
+				, static_cast<size_t>(static_cast<char*>(pAligned) - static_cast<char*>(pMap)) + offs);
+		#endif
+		}
+
+		static void deallocate(void* ptr)noexcept {
+			if (!ptr) return;
+			const header*const pH = static_cast<const header*>(ptr) - 1;
+			switch (pH->kind) {
+			case AllocKind::heap:
+				aligned_allocator::deallocate(pH->pBase);
+				break;
+
+			case AllocKind::mapped:
+			case AllocKind::mapped_huge:
+			#if defined(_WIN32)
+				::VirtualFree(pH->pBase, 0, MEM_RELEASE);
+			#else
+				::munmap(pH->pBase, pH->mappedBytes);
+			#endif
+				break;
+
+			default:
+				NNTL_ASSERT(!"WTF? Corrupted allocation header");
+				::std::abort();
+			}
+		}
+
+		//returns true if the ptr is backed by explicit huge pages
+		static bool is_explicit_huge(const void* ptr)noexcept {
+			return ptr && AllocKind::mapped_huge == (static_cast<const header*>(ptr) - 1)->kind;
+		}
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	// minimalistic owning buffer of trivial T allocated with AllocT. Unlike ::std::vector it neither throws, nor
+	// initializes (and therefore touches) the memory.
+	template<typename T, typename AllocT>
+	class raw_buffer {
+		static_assert(::std::is_trivial<T>::value, "T must be trivial");
+
+		raw_buffer(const raw_buffer& other)noexcept = delete;
+		raw_buffer& operator=(const raw_buffer& rhs) noexcept = delete;
+
+	public:
+		typedef AllocT allocator_t;
+
+	protected:
+		T* m_ptr{ nullptr };
+		size_t m_size{ 0 };
+
+	public:
+		~raw_buffer()noexcept { clear(); }
+		raw_buffer()noexcept {}
+
+		//old content is lost if the size changes. Returns false if allocation failed (the buffer is empty then)
+		bool resize(const size_t n, const size_t align = alignof(T) < 64 ? 64 : alignof(T))noexcept {
+			if (n == m_size) return true;
+			clear();
+			if (n) {
+				m_ptr = static_cast<T*>(allocator_t::allocate(n * sizeof(T), align));
+				if (!m_ptr) return false;
+				m_size = n;
+			}
+			return true;
+		}
+		void clear()noexcept {
+			allocator_t::deallocate(m_ptr);
+			m_ptr = nullptr;
+			m_size = 0;
+		}
+
+		T* data()noexcept { return m_ptr; }
+		const T* data()const noexcept { return m_ptr; }
+		size_t size()const noexcept { return m_size; }
+		bool empty()const noexcept { return !m_size; }
+		size_t byte_size()const noexcept { return m_size * sizeof(T); }
+
+		T& operator[](const size_t i)noexcept { NNTL_ASSERT(i < m_size); return m_ptr[i]; }
+		const T& operator[](const size_t i)const noexcept { NNTL_ASSERT(i < m_size); return m_ptr[i]; }
+	};
+
+}
+}
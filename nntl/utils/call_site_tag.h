@@ -0,0 +1,130 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//call site tags: string labels that attribute the work done by the current thread (heap allocations for
+// utils::alloc_tracker, thread pool jobs for threads::telemetry) to a named place in code, and a fixed size table of
+// distinct tags that instrumentation uses to aggregate its stats. Both never allocate.
+
+#include <atomic>
+#include <cstring>
+
+namespace nntl {
+namespace utils {
+
+	//thread local current tag of an instrumentation domain. Each DomainT has its own tag, so tags of different
+	// instrumentation don't interfere
+	template<typename DomainT>
+	class call_site_tag {
+	protected:
+		static const char*& _cur()noexcept {
+			static thread_local const char* s_szTag = nullptr;
+			return s_szTag;
+		}
+
+	public:
+		static const char* current()noexcept { return _cur(); }
+
+		//sets the call site tag for the current thread, restores the previous on destruction
+		class scoped {
+			scoped(const scoped& other) = delete;
+			scoped& operator=(const scoped& rhs) = delete;
+
+			const char* m_szPrev;
+
+		public:
+			//szTag must be a string with static storage duration
+			scoped(const char* szTag)noexcept : m_szPrev(_cur()) { _cur() = szTag; }
+			~scoped()noexcept { _cur() = m_szPrev; }
+		};
+	};
+
+	//maps tags to slot indexes [0, sSlots). Tags that don't fit into sMaxTags slots share the last slot named szOtherTags.
+	// find() is lock free and may be called concurrently from any threads.
+	template<unsigned MaxTags>
+	class call_site_tags_table {
+		call_site_tags_table(const call_site_tags_table& other) = delete;
+		call_site_tags_table& operator=(const call_site_tags_table& rhs) = delete;
+
+	public:
+		static constexpr unsigned sMaxTags = MaxTags;
+		static constexpr unsigned sSlots = MaxTags + 1;
+		static constexpr const char* szOtherTags = "<other tags>";
+
+	protected:
+		::std::atomic<const char*> m_tags[sSlots];
+
+	public:
+		call_site_tags_table()noexcept { reset(); }
+
+		//must not be called concurrently with find()
+		void reset()noexcept {
+			for (auto& t : m_tags) t.store(nullptr, ::std::memory_order_relaxed);
+			m_tags[sMaxTags].store(szOtherTags, ::std::memory_order_release);
+		}
+
+		//returns the slot of the tag, occupies a free slot if the tag is new
+		unsigned find(const char* szTag)noexcept {
+			NNTL_ASSERT(szTag);
+			for (unsigned i = 0; i < sMaxTags; ++i) {
+				auto& t = m_tags[i];
+				const char* st = t.load(::std::memory_order_acquire);
+				if (!st) {
+					if (t.compare_exchange_strong(st, szTag, ::std::memory_order_acq_rel)) return i;
+					//st now contains a tag that was stored concurrently
+				}
+				//the same literal may have different addresses in different translation units
+				if (st == szTag || !::std::strcmp(st, szTag)) return i;
+			}
+			return sMaxTags;
+		}
+
+		//returns the slot of the tag or sSlots if there's no such tag
+		unsigned lookup(const char* szTag)const noexcept {
+			NNTL_ASSERT(szTag);
+			for (unsigned i = 0; i < sSlots; ++i) {
+				const char* st = m_tags[i].load(::std::memory_order_acquire);
+				if (!st) break;
+				if (st == szTag || !::std::strcmp(st, szTag)) return i;
+			}
+			return sSlots;
+		}
+
+		//returns the tag of the slot or nullptr if the slot is free
+		const char* tag(const unsigned i)const noexcept {
+			NNTL_ASSERT(i < sSlots);
+			return m_tags[i].load(::std::memory_order_acquire);
+		}
+	};
+
+}
+}
@@ -65,7 +65,7 @@ namespace utils {
 		typedef CircBufferRange<RealT> _base_class_t;
 		
 	public:
-		using _base_class_t::real_t;
+		using typename _base_class_t::real_t;
 		
 		static constexpr unsigned int Scale1e6 = _Scale1e6 ? _Scale1e6 : 1000000;
 		static constexpr real_t scaleCoeff = real_t(Scale1e6) / real_t(1e6);
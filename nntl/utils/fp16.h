@@ -0,0 +1,177 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//conversion routines between float and reduced precision 16bit floating point formats:
+// - IEEE 754 binary16 (aka fp16 or half): 1 sign bit, 5 exponent bits, 10 mantissa bits. Narrow range (max ~65504), so
+//		suitable only for data with known bounded magnitude (such as gradients with some care).
+// - bfloat16 (aka bf16): 1 sign bit, 8 exponent bits, 7 mantissa bits. It's just a truncated float, so has the same range
+//		as float, but only ~2-3 significant decimal digits.
+// Both conversions to 16bit use round-to-nearest-even. No hardware support (F16C and so on) is assumed here, however
+// the code is simple enough for a compiler to vectorize loops over it.
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace nntl {
+namespace utils {
+
+	typedef ::std::uint16_t fp16_t;
+	typedef ::std::uint16_t bf16_t;
+
+	namespace _impl {
+		inline ::std::uint32_t float_as_uint(const float v)noexcept {
+			::std::uint32_t r;
+			::std::memcpy(&r, &v, sizeof(r));
+			return r;
+		}
+		inline float uint_as_float(const ::std::uint32_t v)noexcept {
+			float r;
+			::std::memcpy(&r, &v, sizeof(r));
+			return r;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// bfloat16
+
+	inline bf16_t float2bf16(const float v)noexcept {
+		const auto u = _impl::float_as_uint(v);
+		if ((u & 0x7fffffffu) > 0x7f800000u) {
+			//NaN must stay NaN (rounding might turn it into inf), so just setting the quiet bit
+			return static_cast<bf16_t>((u >> 16) | 0x40u);
+		}
+		//round to nearest even
+		const ::std::uint32_t roundingBias = 0x7fffu + ((u >> 16) & 1u);
+		return static_cast<bf16_t>((u + roundingBias) >> 16);
+	}
+
+	inline float bf162float(const bf16_t v)noexcept {
+		return _impl::uint_as_float(static_cast<::std::uint32_t>(v) << 16);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// IEEE binary16
+
+	inline fp16_t float2fp16(const float v)noexcept {
+		const auto u = _impl::float_as_uint(v);
+		const ::std::uint32_t sign = (u >> 16) & 0x8000u;
+		const ::std::uint32_t absU = u & 0x7fffffffu;
+
+		if (absU >= 0x7f800000u) {
+			//inf or NaN
+			return static_cast<fp16_t>(sign | 0x7c00u | (absU > 0x7f800000u ? 0x200u : 0u));
+		}
+		if (absU >= 0x477ff000u) {
+			//it would round to a value >= 65520, that's out of binary16 range -> inf
+			return static_cast<fp16_t>(sign | 0x7c00u);
+		}
+		if (absU < 0x38800000u) {
+			//the result is a binary16 subnormal (or zero). Exponent of v is less than -14
+			if (absU < 0x33000000u) return static_cast<fp16_t>(sign);//less than half of the smallest subnormal -> zero
+
+			const ::std::uint32_t e = absU >> 23;
+			const ::std::uint32_t mant = (absU & 0x7fffffu) | 0x800000u;
+			//the value is mant * 2^(e-150), while the subnormal unit is 2^-24, so shift by (126-e) (in range [14,24])
+			const ::std::uint32_t shift = 126u - e;
+			const ::std::uint32_t halfMant = mant >> shift;
+			const ::std::uint32_t rem = mant & ((1u << shift) - 1u);
+			const ::std::uint32_t halfway = 1u << (shift - 1);
+			const ::std::uint32_t r = halfMant + ((rem > halfway || (rem == halfway && (halfMant & 1u))) ? 1u : 0u);
+			return static_cast<fp16_t>(sign | r);
+		}
+
+		//normal number: rebias exponent (127 -> 15) and round mantissa 23 -> 10 bits to nearest even
+		const ::std::uint32_t rebased = absU - 0x38000000u;
+		const ::std::uint32_t r = (rebased + 0xfffu + ((rebased >> 13) & 1u)) >> 13;
+		return static_cast<fp16_t>(sign | r);
+	}
+
+	inline float fp162float(const fp16_t v)noexcept {
+		const ::std::uint32_t sign = (static_cast<::std::uint32_t>(v) & 0x8000u) << 16;
+		const ::std::uint32_t e = (v >> 10) & 0x1fu;
+		const ::std::uint32_t m = v & 0x3ffu;
+
+		if (0 == e) {
+			if (0 == m) return _impl::uint_as_float(sign);
+			//subnormal binary16 is exactly representable as a normal float: m * 2^-24
+			const float r = static_cast<float>(m) * 5.9604644775390625e-8f;
+			return sign ? -r : r;
+		}
+		if (0x1fu == e) {
+			return _impl::uint_as_float(sign | 0x7f800000u | (m << 13));
+		}
+		return _impl::uint_as_float(sign | ((e + 112u) << 23) | (m << 13));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// tag types to select conversion at compile time
+
+	struct fp16_format {
+		typedef fp16_t storage_t;
+		static storage_t from_float(const float v)noexcept { return float2fp16(v); }
+		static float to_float(const storage_t v)noexcept { return fp162float(v); }
+		static constexpr const char* name = "fp16";
+	};
+	struct bf16_format {
+		typedef bf16_t storage_t;
+		static storage_t from_float(const float v)noexcept { return float2bf16(v); }
+		static float to_float(const storage_t v)noexcept { return bf162float(v); }
+		static constexpr const char* name = "bf16";
+	};
+
+	//bulk conversions. RealT may be float or double (double is converted via float)
+	template<typename FmtT, typename RealT>
+	inline void to_16bit(typename FmtT::storage_t*__restrict pDest, const RealT*__restrict pSrc, const size_t n)noexcept {
+		static_assert(::std::is_floating_point<RealT>::value, "");
+		for (size_t i = 0; i < n; ++i) pDest[i] = FmtT::from_float(static_cast<float>(pSrc[i]));
+	}
+	template<typename FmtT, typename RealT>
+	inline void from_16bit(RealT*__restrict pDest, const typename FmtT::storage_t*__restrict pSrc, const size_t n)noexcept {
+		static_assert(::std::is_floating_point<RealT>::value, "");
+		for (size_t i = 0; i < n; ++i) pDest[i] = static_cast<RealT>(FmtT::to_float(pSrc[i]));
+	}
+	template<typename FmtT, typename RealT>
+	inline void add_from_16bit(RealT*__restrict pDest, const typename FmtT::storage_t*__restrict pSrc, const size_t n)noexcept {
+		static_assert(::std::is_floating_point<RealT>::value, "");
+		for (size_t i = 0; i < n; ++i) pDest[i] += static_cast<RealT>(FmtT::to_float(pSrc[i]));
+	}
+	//rounds values inplace to the nearest representable in FmtT format
+	template<typename FmtT, typename RealT>
+	inline void round_to_16bit(RealT* p, const size_t n)noexcept {
+		static_assert(::std::is_floating_point<RealT>::value, "");
+		for (size_t i = 0; i < n; ++i) p[i] = static_cast<RealT>(FmtT::to_float(FmtT::from_float(static_cast<float>(p[i]))));
+	}
+
+}
+}
@@ -43,8 +43,10 @@ namespace nntl {
 
 		enum class gradcheck_mode {
 			batch,//use batch mode to check parameters that affects a whole batch, e.g. single neuron weight gradient (dL/dW)
-			online//online (single sample) mode should be used to check parameters, that affects a loss function value
+			online,//online (single sample) mode should be used to check parameters, that affects a loss function value
 				  // on only a single sample, e.g. activation value gradient (dL/dA)
+			directional//statistical pre-check of dL/dW: a whole W is perturbed along a random direction v and the numeric
+				  // directional derivative is compared against <dL/dW, v>. Costs 2 fprops per direction instead of per weight
 		};
 
 		enum class gradcheck_phase {
@@ -204,11 +206,17 @@ namespace nntl {
 		const bool bForceSeed;
 		vec_len_t onlineBatchSize;
 
+		//number of random directions to check for every learnable layer during a directional pre-check (see
+		// _impl::gradcheck_mode::directional). Pre-check is done before the usual elementwise checks and is skipped if 0.
+		unsigned directionalCnt;
+		//set to true to perform the directional pre-check only
+		bool bDirectionalOnly;
+
 		//////////////////////////////////////////////////////////////////////////
 		//gradcheck_settings()noexcept : stepSize(_impl::gradcheck_def_stepSize<real_t>::value), bVerbose(true), onlineBatchSize(1){}
 
 		gradcheck_settings(bool vb=true, bool bFS=false, real_t ss = _impl::gradcheck_def_stepSize<real_t>::value)noexcept 
-			: stepSize(ss), bVerbose(vb), onlineBatchSize(1), bForceSeed(bFS)
+			: stepSize(ss), bVerbose(vb), onlineBatchSize(1), bForceSeed(bFS), directionalCnt(0), bDirectionalOnly(false)
 		{}
 	};
 
@@ -49,14 +49,14 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define NNTL_METHODS_MIXIN_OPTIONS(mixinIdx) \
 static_assert(mixinIdx > 0, "MixinIdx must be positive! Zero is reserved for a root class"); \
 private: \
-const bool get_opt(const size_t& oIdx)const { return get_self().m_opts.get<mixinIdx>(oIdx); 	} \
-auto& set_opt(const size_t& oIdx, const bool& b) { get_self().m_opts.set<mixinIdx>(oIdx, b); return *this; }
+const bool get_opt(const size_t& oIdx)const { return get_self().m_opts.template get<mixinIdx>(oIdx); 	} \
+auto& set_opt(const size_t& oIdx, const bool& b) { get_self().m_opts.template set<mixinIdx>(oIdx, b); return *this; }
 
 //set_opt() (for mixins and for the root) MUST return *this, and not a get_self()!
 
 #define NNTL_METHODS_MIXIN_ROOT_OPTIONS() protected: \
-const bool get_opt(const size_t& oIdx)const { return get_self().m_opts.get<0>(oIdx); } \
-auto& set_opt(const size_t& oIdx, const bool& b) { get_self().m_opts.set<0>(oIdx, b); return *this; } \
+const bool get_opt(const size_t& oIdx)const { return get_self().m_opts.template get<0>(oIdx); } \
+auto& set_opt(const size_t& oIdx, const bool& b) { get_self().m_opts.template set<0>(oIdx, b); return *this; } \
 private:
 
 //////////////////////////////////////////////////////////////////////////
@@ -329,7 +329,7 @@ namespace mtx2Normal {
 		typedef _impl::make_acc<statsdata_t, interm_statsdata_t, StatsFunctor_t> Accum_t;
 
 		//raising some necessary StatsFunctor_t definitions into this class context
-		using StatsFunctor_t::mtx_update_t;
+		using typename StatsFunctor_t::mtx_update_t;
 		using StatsFunctor_t::get_scale;
 		using StatsFunctor_t::get_central;
 
@@ -32,6 +32,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include <functional>
+#include <type_traits>
 
 namespace nntl {
 namespace utils {
@@ -48,5 +49,28 @@ namespace utils {
 		::std::function<void(void)> f_;
 	};
 
+	//allocation free variant for hot code paths (::std::function may allocate). Create it with make_scope_exit()
+	template<typename FuncF>
+	class scope_exit_tpl {
+		scope_exit_tpl(const scope_exit_tpl& other) = delete;
+		scope_exit_tpl& operator=(const scope_exit_tpl& rhs) = delete;
+
+		FuncF f_;
+		bool bActive_;
+
+	public:
+		template<typename F>
+		explicit scope_exit_tpl(F&& f)noexcept : f_(::std::forward<F>(f)), bActive_(true) {}
+		scope_exit_tpl(scope_exit_tpl&& other)noexcept : f_(::std::move(other.f_)), bActive_(other.bActive_) {
+			other.bActive_ = false;
+		}
+		~scope_exit_tpl()noexcept { if (bActive_) f_(); }
+	};
+
+	template<typename FuncF>
+	scope_exit_tpl<::std::decay_t<FuncF>> make_scope_exit(FuncF&& f)noexcept {
+		return scope_exit_tpl<::std::decay_t<FuncF>>(::std::forward<FuncF>(f));
+	}
+
 }
 }
\ No newline at end of file
@@ -41,7 +41,7 @@ namespace utils {
 	class tictoc {
 	public:
 		typedef ::std::chrono::nanoseconds duration_t;
-		typedef ::std::chrono::high_resolution_clock clock_t;
+		typedef ::std::chrono::steady_clock clock_t;
 		static_assert(clock_t::is_steady, "Only a steady clock should be used. Change clock_t definition above to steady_clock");
 
 		typedef clock_t::time_point time_point_t;
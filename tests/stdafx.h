@@ -65,6 +65,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 //#define NNTL_RELEASE_WITH_DEBUG
 
+//NNTL_CFG_TRACK_ALLOCATIONS and NNTL_CFG_THREADS_TELEMETRY must be the same in all compilation units, so they are set
+// project-wide by the Debug-Instrumented configuration only. It runs TestAllocator.SteadyStateTraining* and
+// TestThreading.WorkersTelemetry (global operator new is replaced in test_allocator.cpp)
+
 //////////////////////////////////////////////////////////////////////////
 // special externals, necessary only for tests, but not nntl
 
@@ -0,0 +1,350 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "stdafx.h"
+
+#include "../nntl/nntl.h"
+#include "../nntl/train_data/transf_train_data.h"
+//does nothing unless NNTL_CFG_TRACK_ALLOCATIONS is set
+#include "../nntl/utils/alloc_tracker_new.h"
+
+#include "asserts.h"
+#include "common_routines.h"
+
+using namespace nntl;
+
+typedef d_interfaces::real_t real_t;
+typedef math::smatrix<real_t> realmtx_t;
+typedef d_interfaces::iThreads_t iThreads_t;
+typedef d_interfaces::iMemmgr_t iMemmgr_t;
+typedef math::MathN<real_t, iThreads_t, iMemmgr_t> imath_basic_t;
+
+template<typename AllocT>
+void test_allocator_align(const size_t bytes) {
+	for (size_t align = 8; align <= 4096; align <<= 1) {
+		const auto p = static_cast<char*>(AllocT::allocate(bytes, align));
+		ASSERT_TRUE(p) << "bytes=" << bytes << ", align=" << align;
+		ASSERT_EQ(0u, reinterpret_cast<::std::uintptr_t>(p) % align) << "bytes=" << bytes << ", align=" << align;
+		::std::memset(p, 0x5a, bytes);
+		ASSERT_EQ(0x5a, p[bytes - 1]);
+		AllocT::deallocate(p);
+	}
+}
+
+TEST(TestAllocator, AlignedAllocator) {
+	ASSERT_NO_FATAL_FAILURE(test_allocator_align<utils::aligned_allocator>(100));
+	ASSERT_NO_FATAL_FAILURE(test_allocator_align<utils::aligned_allocator>(size_t(3) << 20));
+	utils::aligned_allocator::deallocate(nullptr);
+}
+
+TEST(TestAllocator, HugePageAllocator) {
+	typedef utils::huge_page_allocator hpa_t;
+	const auto oldSettings = hpa_t::settings();
+
+	for (auto m : { utils::huge_pages::Transparent, utils::huge_pages::Explicit2M, utils::huge_pages::Explicit1G }) {
+		hpa_t::settings().mode = m;
+		for (bool bPA : {false, true}) {
+			hpa_t::settings().bAlignToPage = bPA;
+			//heap allocation, OS mapping of a single huge page and of a few of them
+			for (size_t bytes : { size_t(100), size_t(2) << 20, size_t(9) << 20 }) {
+				ASSERT_NO_FATAL_FAILURE(test_allocator_align<hpa_t>(bytes));
+				if (bPA) {
+					const auto p = hpa_t::allocate(bytes, 32);
+					ASSERT_TRUE(p);
+					ASSERT_EQ(0u, reinterpret_cast<::std::uintptr_t>(p) % hpa_t::sSmallPage);
+					hpa_t::deallocate(p);
+				}
+			}
+		}
+	}
+	hpa_t::deallocate(nullptr);
+
+	hpa_t::settings() = oldSettings;
+}
+
+TEST(TestAllocator, RawBufferAndFirstTouch) {
+	utils::raw_buffer<real_t, utils::huge_page_allocator> buf;
+	ASSERT_TRUE(buf.empty());
+	const size_t n = (size_t(5) << 20) / sizeof(real_t) + 3;
+	ASSERT_TRUE(buf.resize(n));
+	ASSERT_EQ(n, buf.size());
+	ASSERT_EQ(0u, reinterpret_cast<::std::uintptr_t>(buf.data()) % 64);
+	::std::fill(buf.data(), buf.data() + n, real_t(1));
+
+	imath_basic_t iM;
+	iM.first_touch(buf.data(), buf.byte_size());
+	for (size_t i = 0; i < n; ++i) {
+		ASSERT_EQ(real_t(0), buf[i]) << "i=" << i;
+	}
+
+	ASSERT_TRUE(buf.resize(10));
+	ASSERT_EQ(10u, buf.size());
+	buf.clear();
+	ASSERT_TRUE(buf.empty() && !buf.data());
+}
+
+TEST(TestAllocator, SmatrixStorage) {
+	//smatrix allocates through NNTL_CFG_ALLOCATOR
+	realmtx_t A(1000, 700), B(3, 5);
+	ASSERT_TRUE(!A.isAllocationFailed() && !B.isAllocationFailed());
+	ASSERT_TRUE(utils::is_ptr_aligned(A.data()) && utils::is_ptr_aligned(B.data()));
+	A.zeros();
+	ASSERT_TRUE(A.resize(10, 20));
+	ASSERT_TRUE(utils::is_ptr_aligned(A.data()));
+	A.clear();
+}
+
+TEST(TestAllocator, AllocTracker) {
+	auto& at = utils::alloc_tracker::instance();
+	const bool bWasArmed = at.armed();
+	at.disarm();
+	at.reset();
+
+	at.on_alloc(100);//not armed, not counted
+	ASSERT_EQ(0u, at.count());
+
+	//the thread is started before arming, because ::std::thread may allocate its state with operator new
+	::std::atomic<bool> bGo(false);
+	::std::thread th([&at, &bGo]() {
+		while (!bGo.load(::std::memory_order_acquire)) ::std::this_thread::yield();
+		at.on_alloc(7);
+	});
+
+	at.arm();
+	at.on_alloc(10);
+	{
+		utils::alloc_tracker::scoped_tag t1("outer");
+		at.on_alloc(20);
+		{
+			utils::alloc_tracker::scoped_tag t2("inner");
+			at.on_alloc(30);
+			at.on_alloc(5);
+		}
+		at.on_alloc(40);
+		//tags are thread local
+		bGo.store(true, ::std::memory_order_release);
+		th.join();
+	}
+	at.disarm();
+	at.on_alloc(1000);
+
+	ASSERT_EQ(6u, at.count());
+	ASSERT_EQ(112u, at.bytes());
+
+	auto ts = at.get_tag("outer");
+	ASSERT_EQ(2u, ts.count);
+	ASSERT_EQ(60u, ts.bytes);
+	ASSERT_EQ(40u, ts.maxBytes);
+	ts = at.get_tag("inner");
+	ASSERT_EQ(2u, ts.count);
+	ASSERT_EQ(35u, ts.bytes);
+	ASSERT_EQ(30u, ts.maxBytes);
+	ts = at.get_tag(utils::alloc_tracker::szUntagged);
+	ASSERT_EQ(2u, ts.count);
+	ASSERT_EQ(17u, ts.bytes);
+
+	size_t tagsCnt = 0;
+	at.for_each_tag([&tagsCnt](const utils::alloc_tracker::tag_stats&) { ++tagsCnt; });
+	ASSERT_EQ(3u, tagsCnt);
+
+	//tags that don't fit into the table are accounted together
+	at.reset();
+	at.arm();
+	char tags[utils::alloc_tracker::tags_table_t::sMaxTags + 2][8];
+	for (unsigned i = 0; i < utils::alloc_tracker::tags_table_t::sMaxTags + 2; ++i) {
+		sprintf_s(tags[i], "t%u", i);
+		utils::alloc_tracker::scoped_tag t(tags[i]);
+		at.on_alloc(1);
+	}
+	at.disarm();
+	ASSERT_EQ(2u, at.get_tag(utils::alloc_tracker::tags_table_t::szOtherTags).count);
+
+	at.reset();
+	if (bWasArmed) at.arm();
+}
+
+#if NNTL_CFG_TRACK_ALLOCATIONS
+//collects classification results like training_observer_stdcout does and exposes them
+class observer_collecting : public training_observer_stdcout<real_t> {
+public:
+	numel_cnt_t total(const data_set_id_t dsId)const noexcept { return m_classifRes[dsId].totalElements; }
+	numel_cnt_t correct(const data_set_id_t dsId)const noexcept { return m_classifRes[dsId].correctlyClassif; }
+};
+
+//inverts pixel intensities (X=1-X) of every sample. Batches are extracted into matrices preallocated in init()
+class td_transf_invert : public _i_td_transformer<real_t, real_t> {
+protected:
+	x_mtxdef_t m_x;
+	y_mtxdef_t m_y;
+
+	static void _invert(x_mtx_t& x)noexcept {
+		const auto p = x.data();
+		const auto ne = x.numel_no_bias();
+		for (numel_cnt_t i = 0; i < ne; ++i) p[i] = real_t(1) - p[i];
+	}
+
+	void _deform(const vec_len_t baseBatchSize)noexcept {
+		m_x.deform_batch_size_with_biases(baseBatchSize);
+		m_y.deform_batch_size(baseBatchSize);
+	}
+
+public:
+	static constexpr vec_len_t samplesInBaseSample()noexcept { return 1; }
+
+	vec_len_t xWidth(const_TD_stor_t& tds)const noexcept { return tds.X(train_set_id).sample_size(); }
+	vec_len_t yWidth(const_TD_stor_t& tds)const noexcept { return tds.Y(train_set_id).sample_size(); }
+
+	numel_cnt_t base_dataset_samples_count(const_TD_stor_t& tds, const data_set_id_t dataSetId)const noexcept {
+		return tds.X(dataSetId).batch_size();
+	}
+
+	void deinit()noexcept {
+		m_x.clear();
+		m_y.clear();
+	}
+
+	template<typename iMathT>
+	bool init(iMathT& iM, const_TD_stor_t& tds, const vec_len_t baseBatchSize)noexcept {
+		NNTL_UNREF(iM);
+		NNTL_ASSERT(tds.X(train_set_id).bBatchInColumn() && tds.Y(train_set_id).bBatchInColumn());
+		m_x.will_emulate_biases();
+		m_y.dont_emulate_biases();
+		return m_x.resize_as_dataset(baseBatchSize, xWidth(tds)) && m_y.resize_as_dataset(baseBatchSize, yWidth(tds));
+	}
+
+	template<typename CommonDataT>
+	void next_epoch(const_TD_stor_t& tds, const numel_cnt_t epochIdx, const CommonDataT& cd
+		, const vec_len_t baseBatchSize, x_mtx_t** ppBatchX, y_mtx_t** ppBatchY) noexcept
+	{
+		NNTL_UNREF(tds); NNTL_UNREF(epochIdx); NNTL_UNREF(cd);
+		_deform(baseBatchSize);
+		*ppBatchX = &m_x;
+		*ppBatchY = &m_y;
+	}
+
+	template<typename CommonDataT>
+	void next_batch(const_TD_stor_t& tds, const numel_cnt_t batchIdx, const CommonDataT& cd
+		, const vec_len_t* pSampleIdxs, const vec_len_t baseBatchSize)noexcept
+	{
+		NNTL_UNREF(batchIdx);
+		NNTL_ASSERT(m_x.batch_size() == baseBatchSize);
+		NNTL_UNREF(baseBatchSize);
+		cd.iMath().mExtractRows(tds.Y(train_set_id), pSampleIdxs, m_y);
+		cd.iMath().mExtractRows(tds.X(train_set_id), pSampleIdxs, m_x);
+		_invert(m_x);
+	}
+
+	template<typename CommonDataT>
+	void walk(const_TD_stor_t& tds, const data_set_id_t dataSetId, const CommonDataT& cd
+		, const vec_len_t baseBatchSize, const unsigned excludeDataFlag, x_mtx_t** ppBatchX, y_mtx_t** ppBatchY)noexcept
+	{
+		NNTL_UNREF(tds); NNTL_UNREF(dataSetId); NNTL_UNREF(cd);
+		_deform(baseBatchSize);
+		*ppBatchX = exclude_dataX(excludeDataFlag) ? nullptr : &m_x;
+		*ppBatchY = exclude_dataY(excludeDataFlag) ? nullptr : &m_y;
+	}
+
+	template<typename CommonDataT>
+	void walk_next(const_TD_stor_t& tds, const data_set_id_t dataSetId, const numel_cnt_t batchIdx
+		, const CommonDataT& cd, const vec_len_t baseBatchSize, const vec_len_t ofs, const unsigned excludeDataFlag)noexcept
+	{
+		NNTL_UNREF(batchIdx);
+		_deform(baseBatchSize);
+		if (!exclude_dataY(excludeDataFlag)) cd.iMath().mExtractRowsSeq(tds.Y(dataSetId), ofs, m_y);
+		if (!exclude_dataX(excludeDataFlag)) {
+			cd.iMath().mExtractRowsSeq(tds.X(dataSetId), ofs, m_x);
+			_invert(m_x);
+		}
+	}
+};
+
+template<typename TdT>
+void check_observer_results(const observer_collecting& obs, const TdT& td) {
+	//the observer has evaluated complete datasets at the end of the last epoch
+	for (const DataSetsId::data_set_id_t dsId : { DataSetsId::train_set_id, DataSetsId::test_set_id }) {
+		ASSERT_EQ(td.dataset_samples_count(dsId), obs.total(dsId)) << "dataset " << dsId;
+		ASSERT_LE(obs.correct(dsId), obs.total(dsId)) << "dataset " << dsId;
+	}
+}
+//eval_classification_one_hot_cached can't be used with transf_train_data, it prohibits caching
+template<typename TdT>
+void check_observer_results(const training_observer_simple_stdcout<real_t>&, const TdT&) {}
+
+//trains a small nnet over td and checks that neither training nor inference over inferX allocate
+template<typename ObserverT, typename TdT>
+void test_steady_state_training(TdT& td, const realmtx_t& inferX) {
+	const real_t learningRate = real_t(.01);
+
+	layer_input<> inp(td.xWidth());
+	layer_fully_connected<> fcl(30, learningRate);
+	layer_output<> outp(td.yWidth(), learningRate);
+
+	auto lp = make_layers(inp, fcl, outp);
+	nnet_train_opts<real_t, ObserverT> opts(3);
+	opts.calcFullLossValue(true).batchSize(100);
+
+	auto nn = make_nnet(lp);
+	nn.get_iRng().seed64(0);
+	const auto ec = nn.train(td, opts);
+	ASSERT_EQ(decltype(nn)::ErrorCode::Success, ec) << "Error code description: " << nn.get_last_error_string();
+
+	//the tracker keeps stats of the last epoch
+	auto& at = utils::alloc_tracker::instance();
+	ASSERT_FALSE(at.armed());
+	ASSERT_EQ(0u, at.count()) << "Steady state training must not allocate";
+	ASSERT_NO_FATAL_FAILURE(check_observer_results(opts.observer(), td));
+
+	//inference on the held-out set. The first call may (re)initialize the nnet for the new batch size
+	ASSERT_EQ(decltype(nn)::ErrorCode::Success, nn.fprop(inferX)) << "Error code description: " << nn.get_last_error_string();
+	at.reset();
+	at.arm();
+	const auto ec2 = nn.fprop(inferX);
+	at.disarm();
+	ASSERT_EQ(decltype(nn)::ErrorCode::Success, ec2) << "Error code description: " << nn.get_last_error_string();
+	ASSERT_EQ(0u, at.count()) << "Steady state inference must not allocate";
+	at.reset();
+}
+
+TEST(TestAllocator, SteadyStateTraining) {
+	inmem_train_data<real_t> td;
+	readTd(td, MNIST_FILE_DEBUG);
+	ASSERT_NO_FATAL_FAILURE(test_steady_state_training<observer_collecting>(td, td.test_x()));
+}
+
+TEST(TestAllocator, SteadyStateTrainingTransformed) {
+	inmem_train_data<real_t> tds;
+	readTd(tds, MNIST_FILE_DEBUG);
+
+	td_transf_invert tf;
+	transf_train_data<td_transf_invert> td(tf, tds);
+	ASSERT_NO_FATAL_FAILURE(test_steady_state_training<training_observer_simple_stdcout<real_t>>(td, tds.test_x()));
+}
+#endif //NNTL_CFG_TRACK_ALLOCATIONS
@@ -0,0 +1,302 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "stdafx.h"
+
+#include <fstream>
+
+#include "../nntl/nntl.h"
+#include "../nntl/_supp/io/checkpoint.h"
+
+#include "asserts.h"
+#include "common_routines.h"
+
+using namespace nntl;
+
+typedef d_interfaces::real_t real_t;
+typedef math::smatrix<real_t> realmtx_t;
+typedef nntl_supp::checkpoint_writer<real_t> ckpt_writer_t;
+typedef nntl_supp::checkpoint_reader<real_t> ckpt_reader_t;
+
+static constexpr const char* ckptFile = "./test_checkpoint.ckpt";
+
+template<typename LpT>
+void set_optimizer(LpT& lp) {
+	lp.for_each_layer_exc_input([](auto& lyr) {
+		lyr.get_gradWorks().set_type(::std::decay_t<decltype(lyr.get_gradWorks())>::Adam).nesterov_momentum(real_t(.9));
+	});
+}
+
+TEST(TestCheckpoint, SaveRestore) {
+	inmem_train_data<real_t> td;
+	readTd(td, MNIST_FILE_DEBUG);
+
+	layer_input<> inp(td.train_x().cols_no_bias());
+	layer_fully_connected<activation::sigm<real_t>> fcl(30, real_t(.001));
+	layer_output<activation::sigm_xentropy_loss<real_t>> outp(td.train_y().cols(), real_t(.001));
+	auto lp = make_layers(inp, fcl, outp);
+	set_optimizer(lp);
+	typedef decltype(fcl)::grad_works_t gw_t;
+
+	nnet_train_opts<real_t, training_observer_silent<real_t>> opts(3);
+	opts.batchSize(100);
+
+	ckpt_writer_t cw;
+	realmtx_t savedW, savedVw, savedA;
+	auto nn = make_nnet(lp);
+	auto ec = nn.train(td, opts, [&](size_t epochEnded) {
+		EXPECT_EQ(ckpt_writer_t::ErrorCode::Success, cw.snapshot(lp, ckptFile, epochEnded));
+		//the snapshot must hold the state as of the moment of the call, whatever happens after it
+		EXPECT_TRUE(fcl.get_weights().clone_to(savedW));
+		EXPECT_TRUE(fcl.get_gradWorks().get_state_mtx(gw_t::state_Vw).clone_to(savedVw));
+		EXPECT_TRUE(fcl.get_gradWorks().get_state_mtx(gw_t::state_optMtxA).clone_to(savedA));
+		return true;
+	});
+	ASSERT_EQ(decltype(nn)::ErrorCode::Success, ec) << "Error code description: " << nn.get_last_error_string();
+	ASSERT_EQ(ckpt_writer_t::ErrorCode::Success, cw.wait()) << cw.get_last_error_str();
+	ASSERT_TRUE(!savedVw.empty() && !savedA.empty());
+
+	ckpt_reader_t cr;
+	ASSERT_EQ(ckpt_reader_t::ErrorCode::Success, cr.open(ckptFile)) << cr.get_last_error_str();
+	ASSERT_EQ(2, cr.epoch());
+	//weights + Vw + optMtxA + optMtxB for each of two layers
+	ASSERT_EQ(8, cr.entries_count());
+
+	//restoring into a fresh nnet of the same structure
+	layer_input<> inp2(td.train_x().cols_no_bias());
+	layer_fully_connected<activation::sigm<real_t>> fcl2(30, real_t(.001));
+	layer_output<activation::sigm_xentropy_loss<real_t>> outp2(td.train_y().cols(), real_t(.001));
+	auto lp2 = make_layers(inp2, fcl2, outp2);
+	set_optimizer(lp2);
+
+	//weights could be restored before nnet::train()
+	ASSERT_EQ(ckpt_reader_t::ErrorCode::Success, cr.restore(lp2)) << cr.get_last_error_str();
+	ASSERT_EQ(savedW, fcl2.get_weights());
+	ASSERT_EQ(outp.get_weights(), outp2.get_weights());
+
+	//and the optimizer state could only be restored inside it
+	nnet_train_opts<real_t, training_observer_silent<real_t>> opts2(1);
+	opts2.batchSize(100);
+	bool bChecked = false;
+	auto restorer = nntl_supp::make_checkpoint_restorer(lp2, cr);
+	auto nn2 = make_nnet(lp2);
+	ec = nn2.train(td, opts2, NNetCB_OnEpochEnd_Dummy(), [&]() {
+		const auto r = restorer();
+		const auto& gw = fcl2.get_gradWorks();
+		bChecked = savedW == fcl2.get_weights() && savedVw == gw.get_state_mtx(gw_t::state_Vw)
+			&& savedA == gw.get_state_mtx(gw_t::state_optMtxA) && !gw.isFirstRun();
+		return r;
+	});
+	ASSERT_EQ(decltype(nn2)::ErrorCode::Success, ec) << "Error code description: " << nn2.get_last_error_string();
+	ASSERT_TRUE(bChecked);
+
+	//a checkpoint can't be restored into a nnet of a different structure
+	layer_input<> inp3(td.train_x().cols_no_bias());
+	layer_fully_connected<activation::sigm<real_t>> fcl3(20, real_t(.001));
+	layer_output<activation::sigm_xentropy_loss<real_t>> outp3(td.train_y().cols(), real_t(.001));
+	auto lp3 = make_layers(inp3, fcl3, outp3);
+	//the size check needs existing weights; a fresh layer would just assert on the wrong matrix in set_weights()
+	realmtx_t W3(fcl3.get_neurons_cnt(), fcl3.get_incoming_neurons_cnt() + 1);
+	ASSERT_TRUE(!W3.isAllocationFailed());
+	W3.ones();
+	ASSERT_TRUE(fcl3.set_weights(::std::move(W3)));
+	ASSERT_EQ(ckpt_reader_t::ErrorCode::WeightsSizeMismatch, cr.restore(lp3));
+
+	cr.close();
+	::std::remove(ckptFile);
+}
+
+//both weights blocks of LFCLR and their optimizer states must be saved and restored
+TEST(TestCheckpoint, WeightsBlocks) {
+	inmem_train_data<real_t> td;
+	readTd(td, MNIST_FILE_DEBUG);
+
+	typedef LFCLR<activation::sigm<real_t>> lfclr_t;
+	typedef lfclr_t::grad_works_t gw_t;
+
+	layer_input<> inp(td.train_x().cols_no_bias());
+	lfclr_t fcl(30, 5, real_t(.001));
+	layer_output<activation::sigm_xentropy_loss<real_t>> outp(td.train_y().cols(), real_t(.001));
+	auto lp = make_layers(inp, fcl, outp);
+	set_optimizer(lp);
+	fcl.get_gradWorksV().set_type(gw_t::Adam).nesterov_momentum(real_t(.9));
+
+	nnet_train_opts<real_t, training_observer_silent<real_t>> opts(2);
+	opts.batchSize(100);
+
+	ckpt_writer_t cw;
+	realmtx_t savedU, savedV, savedVA;
+	auto nn = make_nnet(lp);
+	auto ec = nn.train(td, opts, [&](size_t epochEnded) {
+		EXPECT_EQ(ckpt_writer_t::ErrorCode::Success, cw.snapshot(lp, ckptFile, epochEnded));
+		EXPECT_TRUE(fcl.get_U().clone_to(savedU));
+		EXPECT_TRUE(fcl.get_V().clone_to(savedV));
+		EXPECT_TRUE(fcl.get_gradWorksV().get_state_mtx(gw_t::state_optMtxA).clone_to(savedVA));
+		return true;
+	});
+	ASSERT_EQ(decltype(nn)::ErrorCode::Success, ec) << "Error code description: " << nn.get_last_error_string();
+	ASSERT_EQ(ckpt_writer_t::ErrorCode::Success, cw.wait()) << cw.get_last_error_str();
+	ASSERT_TRUE(!savedVA.empty());
+
+	ckpt_reader_t cr;
+	ASSERT_EQ(ckpt_reader_t::ErrorCode::Success, cr.open(ckptFile)) << cr.get_last_error_str();
+	//weights + Vw + optMtxA + optMtxB for each of U, V and the output layer
+	ASSERT_EQ(12, cr.entries_count());
+
+	layer_input<> inp2(td.train_x().cols_no_bias());
+	lfclr_t fcl2(30, 5, real_t(.001));
+	layer_output<activation::sigm_xentropy_loss<real_t>> outp2(td.train_y().cols(), real_t(.001));
+	auto lp2 = make_layers(inp2, fcl2, outp2);
+	set_optimizer(lp2);
+	fcl2.get_gradWorksV().set_type(gw_t::Adam).nesterov_momentum(real_t(.9));
+
+	ASSERT_EQ(ckpt_reader_t::ErrorCode::Success, cr.restore(lp2)) << cr.get_last_error_str();
+	ASSERT_EQ(savedU, fcl2.get_U());
+	ASSERT_EQ(savedV, fcl2.get_V());
+
+	nnet_train_opts<real_t, training_observer_silent<real_t>> opts2(1);
+	opts2.batchSize(100);
+	bool bChecked = false;
+	auto restorer = nntl_supp::make_checkpoint_restorer(lp2, cr);
+	auto nn2 = make_nnet(lp2);
+	ec = nn2.train(td, opts2, NNetCB_OnEpochEnd_Dummy(), [&]() {
+		const auto r = restorer();
+		const auto& gwV = fcl2.get_gradWorksV();
+		bChecked = savedU == fcl2.get_U() && savedV == fcl2.get_V()
+			&& savedVA == gwV.get_state_mtx(gw_t::state_optMtxA) && !gwV.isFirstRun();
+		return r;
+	});
+	ASSERT_EQ(decltype(nn2)::ErrorCode::Success, ec) << "Error code description: " << nn2.get_last_error_string();
+	ASSERT_TRUE(bChecked);
+
+	cr.close();
+	::std::remove(ckptFile);
+}
+
+//restoring LFCP must rebuild its mask and compressed weights, even when the layer already has (dense) weights
+TEST(TestCheckpoint, PrunedLayer) {
+	inmem_train_data<real_t> td;
+	readTd(td, MNIST_FILE_DEBUG);
+
+	typedef LFCP<activation::sigm<real_t>> lfcp_t;
+	static constexpr real_t sparsity = real_t(.8);
+
+	layer_input<> inp(td.train_x().cols_no_bias());
+	lfcp_t fcl(30, real_t(.001));
+	layer_output<activation::sigm_xentropy_loss<real_t>> outp(td.train_y().cols(), real_t(.001));
+	auto lp = make_layers(inp, fcl, outp);
+	set_optimizer(lp);
+
+	nnet_train_opts<real_t, training_observer_silent<real_t>> opts(2);
+	opts.batchSize(100);
+
+	ckpt_writer_t cw;
+	realmtx_t savedW, savedMask;
+	auto nn = make_nnet(lp);
+	auto ec = nn.train(td, opts, [&](size_t epochEnded) {
+		EXPECT_TRUE(fcl.prune_weights(sparsity));
+		EXPECT_TRUE(fcl.is_sparse());
+		EXPECT_EQ(ckpt_writer_t::ErrorCode::Success, cw.snapshot(lp, ckptFile, epochEnded));
+		EXPECT_TRUE(fcl.get_weights().clone_to(savedW));
+		EXPECT_TRUE(fcl.get_prune_mask().clone_to(savedMask));
+		return true;
+	});
+	ASSERT_EQ(decltype(nn)::ErrorCode::Success, ec) << "Error code description: " << nn.get_last_error_string();
+	ASSERT_EQ(ckpt_writer_t::ErrorCode::Success, cw.wait()) << cw.get_last_error_str();
+	ASSERT_TRUE(!savedMask.empty());
+
+	ckpt_reader_t cr;
+	ASSERT_EQ(ckpt_reader_t::ErrorCode::Success, cr.open(ckptFile)) << cr.get_last_error_str();
+
+	layer_input<> inp2(td.train_x().cols_no_bias());
+	lfcp_t fcl2(30, real_t(.001));
+	layer_output<activation::sigm_xentropy_loss<real_t>> outp2(td.train_y().cols(), real_t(.001));
+	auto lp2 = make_layers(inp2, fcl2, outp2);
+	set_optimizer(lp2);
+
+	//dense weights of the layer must be replaced along with the derived state
+	realmtx_t W0(fcl2.get_neurons_cnt(), fcl2.get_incoming_neurons_cnt() + 1);
+	ASSERT_TRUE(!W0.isAllocationFailed());
+	W0.ones();
+	ASSERT_TRUE(fcl2.set_weights(W0));
+	ASSERT_FALSE(fcl2.is_sparse());
+
+	ASSERT_EQ(ckpt_reader_t::ErrorCode::Success, cr.restore(lp2)) << cr.get_last_error_str();
+	ASSERT_EQ(savedW, fcl2.get_weights());
+	ASSERT_TRUE(fcl2.is_sparse());
+	ASSERT_MTX_EQ(savedMask, fcl2.get_prune_mask(), "Mask wasn't restored");
+
+	//the same inside nnet::train()
+	nnet_train_opts<real_t, training_observer_silent<real_t>> opts2(1);
+	opts2.batchSize(100);
+	bool bChecked = false;
+	auto restorer = nntl_supp::make_checkpoint_restorer(lp2, cr);
+	auto nn2 = make_nnet(lp2);
+	ec = nn2.train(td, opts2, NNetCB_OnEpochEnd_Dummy(), [&]() {
+		const auto r = restorer();
+		bChecked = savedW == fcl2.get_weights() && savedMask == fcl2.get_prune_mask() && fcl2.is_sparse();
+		//the compressed copy must hold the restored weights
+		const auto& spW = fcl2.get_sparse_weights();
+		for (vec_len_t row = 0; bChecked && row < spW.rows(); ++row) {
+			for (auto k = spW.rowPtr()[row]; k < spW.rowPtr()[row + 1]; ++k) {
+				bChecked = bChecked && savedW.get(row, spW.colIdx()[k]) == spW.vals()[k];
+			}
+		}
+		return r;
+	});
+	ASSERT_EQ(decltype(nn2)::ErrorCode::Success, ec) << "Error code description: " << nn2.get_last_error_string();
+	ASSERT_TRUE(bChecked);
+
+	cr.close();
+	::std::remove(ckptFile);
+}
+
+TEST(TestCheckpoint, CorruptedFile) {
+	ckpt_reader_t cr;
+	::std::remove(ckptFile);
+	ASSERT_EQ(ckpt_reader_t::ErrorCode::FailedToMapFile, cr.open(ckptFile));
+
+	{
+		::std::ofstream f(ckptFile, ::std::ios::binary);
+		f << "garbage";
+	}
+	ASSERT_EQ(ckpt_reader_t::ErrorCode::FailedToReadHeader, cr.open(ckptFile));
+
+	{
+		::std::ofstream f(ckptFile, ::std::ios::binary);
+		const ::std::vector<char> zeros(sizeof(nntl_supp::ckpt_file::HEADER), 0);
+		f.write(zeros.data(), zeros.size());
+	}
+	ASSERT_EQ(ckpt_reader_t::ErrorCode::WrongHeaderSignature, cr.open(ckptFile));
+	ASSERT_TRUE(cr.empty());
+
+	::std::remove(ckptFile);
+}
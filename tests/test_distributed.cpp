@@ -0,0 +1,285 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "stdafx.h"
+
+#include "../nntl/nntl.h"
+#include "../nntl/distributed.h"
+
+#include <random>
+
+#include "asserts.h"
+#include "common_routines.h"
+
+using namespace nntl;
+using namespace nntl::distributed;
+
+typedef d_interfaces::real_t real_t;
+typedef math::smatrix<real_t> realmtx_t;
+
+namespace {
+	void _fill_rank_data(::std::vector<real_t>& d, const int rank)noexcept {
+		::std::mt19937 g(1234 + rank);
+		::std::uniform_real_distribution<real_t> u(real_t(-1), real_t(1));
+		for (auto& v : d) v = u(g);
+	}
+
+	//runs allreduce in worldSize threads over inproc transport and checks results
+	void _test_allreduce(const int worldSize, const numel_cnt_t n, const GradCompression gc) {
+		inproc_ring_hub hub(worldSize, 1 << 12);//small capacity to stress the ring wrap-around
+		ASSERT_TRUE(!hub.empty());
+
+		::std::vector<::std::vector<real_t>> res(worldSize);
+		::std::vector<char> oks(worldSize, 0);
+		::std::vector<::std::thread> thr;
+		for (int r = 0; r < worldSize; ++r) {
+			thr.emplace_back([&, r]() {
+				inproc_ring_transport t(hub, r);
+				ring_collectives<real_t> coll;
+				auto& d = res[r];
+				d.resize(n);
+				_fill_rank_data(d, r);
+				if (GradCompression::topK == gc) {
+					::std::vector<real_t> resid(n, real_t(0));
+					oks[r] = coll.allreduce_mean_topK(t, d.data(), resid.data(), n, real_t(.1));
+				} else oks[r] = coll.allreduce_mean(t, d.data(), n, GradCompression::fp16 == gc);
+			});
+		}
+		for (auto& t : thr) t.join();
+
+		::std::vector<real_t> etalon(n, real_t(0)), tmp(n);
+		for (int r = 0; r < worldSize; ++r) {
+			ASSERT_TRUE(oks[r]) << "allreduce failed for rank " << r;
+			//every rank must get exactly the same data
+			ASSERT_TRUE(0 == ::std::memcmp(res[r].data(), res[0].data(), sizeof(real_t)*n)) << "rank " << r << " differs!";
+			_fill_rank_data(tmp, r);
+			for (numel_cnt_t i = 0; i < n; ++i) etalon[i] += tmp[i];
+		}
+
+		if (GradCompression::topK == gc) return;
+		const real_t maxDiff = GradCompression::fp16 == gc ? real_t(1e-3) : real_t(1e-5);
+		for (numel_cnt_t i = 0; i < n; ++i) {
+			ASSERT_NEAR(etalon[i] / worldSize, res[0][i], maxDiff) << "wrong value @" << i;
+		}
+	}
+}
+
+TEST(TestDistributed, FP16Conversion) {
+	//every finite fp16 value must survive the round trip
+	for (unsigned h = 0; h < 0x7c00u; ++h) {
+		const auto f = utils::fp162float(static_cast<utils::fp16_t>(h));
+		ASSERT_EQ(h, utils::float2fp16(f));
+		ASSERT_EQ(h | 0x8000u, utils::float2fp16(-f));
+	}
+	ASSERT_EQ(0x7c00u, utils::float2fp16(70000.f));
+	ASSERT_EQ(1.f, utils::fp162float(utils::float2fp16(1.f)));
+	ASSERT_EQ(-2.5f, utils::bf162float(utils::float2bf16(-2.5f)));
+}
+
+TEST(TestDistributed, RingAllReduce) {
+	for (int ws : {1, 2, 3, 5}) {
+		for (numel_cnt_t n : {1, 7, 1000, 100003}) {
+			_test_allreduce(ws, n, GradCompression::none);
+			_test_allreduce(ws, n, GradCompression::fp16);
+			_test_allreduce(ws, n, GradCompression::topK);
+		}
+	}
+}
+
+TEST(TestDistributed, RingBroadcast) {
+	constexpr int worldSize = 4;
+	constexpr numel_cnt_t n = 50001;
+	inproc_ring_hub hub(worldSize, 1 << 12);
+
+	::std::vector<char> oks(worldSize, 0);
+	::std::vector<::std::thread> thr;
+	for (int r = 0; r < worldSize; ++r) {
+		thr.emplace_back([&, r]() {
+			inproc_ring_transport t(hub, r);
+			::std::vector<real_t> d(n, real_t(0));
+			if (0 == r) _fill_rank_data(d, 0);
+			bool b = ring_collectives<real_t>::broadcast(t, d.data(), n, 0) && t.barrier();
+			::std::vector<real_t> et(n);
+			_fill_rank_data(et, 0);
+			oks[r] = b && 0 == ::std::memcmp(et.data(), d.data(), sizeof(real_t)*n);
+		});
+	}
+	for (auto& t : thr) t.join();
+	for (int r = 0; r < worldSize; ++r) ASSERT_TRUE(oks[r]) << "rank " << r;
+}
+
+TEST(TestDistributed, Communicator) {
+	constexpr int worldSize = 3;
+	constexpr numel_cnt_t n = 1003;
+	inproc_ring_hub hub(worldSize);
+
+	::std::vector<char> oks(worldSize, 0);
+	::std::vector<::std::thread> thr;
+	for (int r = 0; r < worldSize; ++r) {
+		thr.emplace_back([&, r]() {
+			inproc_ring_transport t(hub, r);
+			dp_communicator<real_t> comm(t);
+			//posting several jobs at once, like bprop() does
+			::std::vector<real_t> d1(n), d2(2 * n);
+			_fill_rank_data(d1, r);
+			_fill_rank_data(d2, r + worldSize);
+			dp_communicator<real_t>::job_t j1, j2;
+			j1.pData = d1.data(); j1.numel = n;
+			j2.pData = d2.data(); j2.numel = 2 * n;
+			comm.post(j1);
+			comm.post(j2);
+			oks[r] = comm.wait(j1) && comm.wait(j2) && comm.barrier();
+		});
+	}
+	for (auto& t : thr) t.join();
+	for (int r = 0; r < worldSize; ++r) ASSERT_TRUE(oks[r]) << "rank " << r;
+}
+
+namespace {
+	typedef dp_grad_works<d_interfaces> dpgw_t;
+
+	//transport with a dead peer: every exchange fails
+	class dead_peer_transport final : public distributed::_impl::_ring_transport_base<dead_peer_transport> {
+		typedef distributed::_impl::_ring_transport_base<dead_peer_transport> _base_class_t;
+	public:
+		dead_peer_transport()noexcept : _base_class_t(0, 2) {}
+		bool exchange(const void*, const size_t, void*, const size_t)noexcept { return false; }
+	};
+
+	//trains a small nnet replica with nnet::train() and returns its final weights
+	template<typename TransportT>
+	_nnet_errs::ErrorCode _dp_train(TransportT& t, inmem_train_data<real_t>& td, const GradCompression gc
+		, const bool bBroadcastWeights, realmtx_t& fclW, realmtx_t& outpW)
+	{
+		dp_communicator<real_t> comm(t, gc);
+		layer_input<> inp(td.train_x().cols_no_bias());
+		LFC<activation::sigm<real_t>, dpgw_t> fcl(30, real_t(.1));
+		layer_output<activation::sigm_xentropy_loss<real_t>, dpgw_t> outp(td.train_y().cols(), real_t(.1));
+		auto lp = make_layers(inp, fcl, outp);
+		attach_communicator(lp, comm);
+
+		nnet_train_opts<real_t, rank0_observer<training_observer_silent<real_t>>> opts(2);
+		opts.batchSize(100);
+		opts.observer().set_rank(comm.rank());
+
+		auto nn = make_nnet(lp);
+		//different ranks see different batches and start from different weights
+		nn.get_iRng().seed64(1000 + comm.rank());
+		const auto ec = bBroadcastWeights
+			? nn.train(td, opts, NNetCB_OnEpochEnd_Dummy(), make_weights_broadcaster(lp, comm))
+			: nn.train(td, opts);
+		fcl.get_weights().clone_to(fclW);
+		outp.get_weights().clone_to(outpW);
+		return ec;
+	}
+}
+
+TEST(TestDistributed, TrainReplicasStayIdentical) {
+	constexpr int worldSize = 3;
+	inmem_train_data<real_t> td[worldSize];
+	for (auto& d : td) readTd(d, MNIST_FILE_DEBUG);
+
+	for (const auto gc : { GradCompression::none, GradCompression::fp16, GradCompression::topK }) {
+		inproc_ring_hub hub(worldSize);
+		ASSERT_TRUE(!hub.empty());
+
+		realmtx_t fclW[worldSize], outpW[worldSize];
+		_nnet_errs::ErrorCode ecs[worldSize];
+		::std::vector<::std::thread> thr;
+		for (int r = 0; r < worldSize; ++r) {
+			thr.emplace_back([&, r]() {
+				inproc_ring_transport t(hub, r);
+				ecs[r] = _dp_train(t, td[r], gc, true, fclW[r], outpW[r]);
+			});
+		}
+		for (auto& t : thr) t.join();
+
+		for (int r = 0; r < worldSize; ++r) {
+			ASSERT_EQ(_nnet_errs::ErrorCode::Success, ecs[r]) << "rank " << r << ": " << _nnet_errs::get_error_str(ecs[r]);
+			ASSERT_EQ(fclW[0], fclW[r]) << "rank " << r << " diverged, gc=" << static_cast<int>(gc);
+			ASSERT_EQ(outpW[0], outpW[r]) << "rank " << r << " diverged, gc=" << static_cast<int>(gc);
+		}
+	}
+}
+
+TEST(TestDistributed, TrainFailedExchange) {
+	inmem_train_data<real_t> td;
+	readTd(td, MNIST_FILE_DEBUG);
+
+	dead_peer_transport t;
+	realmtx_t fclW, outpW;
+	//the process must survive and nnet::train() must report the failure
+	ASSERT_EQ(_nnet_errs::ErrorCode::GradientExchangeFailed, _dp_train(t, td, GradCompression::none, false, fclW, outpW));
+}
+
+#if NNTL_HAS_SHM_RING_TRANSPORT
+#include <sys/wait.h>
+
+TEST(TestDistributed, ShmTransport) {
+	constexpr int worldSize = 3;
+	constexpr numel_cnt_t n = 10001;
+	const ::std::string jobName = "nntl_test_" + ::std::to_string(::getpid());
+
+	::std::vector<pid_t> children;
+	for (int r = 1; r < worldSize; ++r) {
+		const pid_t p = ::fork();
+		ASSERT_TRUE(p >= 0);
+		if (0 == p) {
+			shm_ring_transport t(jobName.c_str(), r, worldSize, 1 << 12);
+			if (t.empty()) ::_exit(2);
+			ring_collectives<real_t> coll;
+			::std::vector<real_t> d(n);
+			_fill_rank_data(d, r);
+			::_exit(coll.allreduce_mean(t, d.data(), n) && t.barrier() ? 0 : 1);
+		}
+		children.push_back(p);
+	}
+
+	shm_ring_transport t(jobName.c_str(), 0, worldSize, 1 << 12);
+	ASSERT_TRUE(!t.empty());
+	ring_collectives<real_t> coll;
+	::std::vector<real_t> d(n), et(n, real_t(0)), tmp(n);
+	_fill_rank_data(d, 0);
+	ASSERT_TRUE(coll.allreduce_mean(t, d.data(), n) && t.barrier());
+
+	for (auto p : children) {
+		int st = 0;
+		::waitpid(p, &st, 0);
+		ASSERT_TRUE(WIFEXITED(st) && 0 == WEXITSTATUS(st));
+	}
+
+	for (int r = 0; r < worldSize; ++r) {
+		_fill_rank_data(tmp, r);
+		for (numel_cnt_t i = 0; i < n; ++i) et[i] += tmp[i];
+	}
+	for (numel_cnt_t i = 0; i < n; ++i) ASSERT_NEAR(et[i] / worldSize, d[i], real_t(1e-5));
+}
+#endif
@@ -0,0 +1,158 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "stdafx.h"
+
+#include "../nntl/nntl.h"
+#include "../nntl/_supp/io/dumpfile.h"
+
+#include "asserts.h"
+#include "common_routines.h"
+
+using namespace nntl;
+
+typedef d_interfaces::real_t real_t;
+typedef math::smatrix<real_t> realmtx_t;
+typedef nntl_supp::adumpfile<> dumpfile_t;
+typedef nntl_supp::dumpfile_reader dumpreader_t;
+
+static constexpr const char* dumpFile = "./test_dumpfile.ndmp";
+
+TEST(TestDumpfile, LzCodec) {
+	using namespace nntl_supp::dump_file;
+	::std::mt19937_64 rg(0);
+	::std::vector<DWORD> tbl(size_t(1) << lz_hashLog);
+
+	for (unsigned t = 0; t < 3; ++t) {
+		const size_t n = 100000;
+		::std::vector<BYTE> src(n), dest(n + n / 8 + 64), dec(n);
+		for (auto& b : src) {
+			switch (t) {
+			case 0: b = (rg() % 10) < 8 ? BYTE(0) : static_cast<BYTE>(rg()); break;//sparse
+			case 1: b = static_cast<BYTE>(rg() % 4); break;//low entropy
+			default: b = static_cast<BYTE>(rg()); break;//incompressible
+			}
+		}
+		const auto cb = lz_compress(src.data(), n, dest.data(), dest.size(), tbl.data());
+		ASSERT_TRUE(cb > 0) << "test #" << t;
+		if (t < 2) ASSERT_LT(cb, n) << "test #" << t;
+		ASSERT_TRUE(lz_decompress(dest.data(), cb, dec.data(), n)) << "test #" << t;
+		ASSERT_TRUE(src == dec) << "test #" << t;
+
+		//must refuse to compress into a too small buffer
+		ASSERT_EQ(0u, lz_compress(src.data(), n, dest.data(), 10, tbl.data()));
+	}
+}
+
+void test_dumpfile_roundtrip(const bool bCompress) {
+	::std::mt19937_64 rg(0);
+	::std::uniform_real_distribution<real_t> distr(real_t(-5), real_t(5));
+
+	realmtx_t A(100, 30), Sp(200, 40);
+	ASSERT_TRUE(!A.isAllocationFailed() && !Sp.isAllocationFailed());
+	::std::generate(A.begin(), A.end(), [&]() { return distr(rg); });
+	//sparse matrix, like ReLU activations
+	::std::generate(Sp.begin(), Sp.end(), [&]() { const auto v = distr(rg); return v > real_t(2) ? v : real_t(0); });
+	const real_t scalar = real_t(3.25);
+	const int iv = -17;
+
+	{
+		dumpfile_t df(2);
+		df.compression(bCompress);
+		ASSERT_EQ(dumpfile_t::ErrorCode::Success, df.open(dumpFile));
+		df & serialization::make_nvp("A", A);
+		ASSERT_EQ(dumpfile_t::ErrorCode::Success, df.save_struct_begin("lyr", false, false));
+		df & serialization::make_nvp("Sp", Sp);
+		df & serialization::make_nvp("scalar", scalar);
+		ASSERT_EQ(dumpfile_t::ErrorCode::Success, df.save_struct_end());
+		df & NNTL_SERIALIZATION_NVP(iv);
+		ASSERT_EQ(dumpfile_t::ErrorCode::Success, df.close()) << df.get_last_error_str();
+		ASSERT_EQ(dumpfile_t::ErrorCode::Success, df.wait());
+	}
+
+	dumpreader_t rd;
+	ASSERT_EQ(dumpreader_t::ErrorCode::Success, rd.read(dumpFile)) << rd.get_last_error_str();
+	ASSERT_EQ(4u, rd.size());
+
+	realmtx_t t;
+	ASSERT_EQ(dumpreader_t::ErrorCode::Success, rd.get("A", t));
+	ASSERT_EQ(A, t);
+	ASSERT_EQ(dumpreader_t::ErrorCode::Success, rd.get("lyr.Sp", t));
+	ASSERT_EQ(Sp, t);
+	ASSERT_EQ(dumpreader_t::ErrorCode::Success, rd.get("lyr.scalar", t));
+	ASSERT_EQ(scalar, t.get(0, 0));
+	ASSERT_EQ(dumpreader_t::ErrorCode::NoSuchRecord, rd.get("scalar", t));
+
+	const auto pIv = rd.find("iv");
+	ASSERT_TRUE(pIv && sizeof(int) == pIv->data.size());
+	ASSERT_EQ(nntl_supp::dump_file::data_type<int>::value, pIv->dataType);
+	ASSERT_EQ(iv, *reinterpret_cast<const int*>(pIv->data.data()));
+
+	::std::remove(dumpFile);
+}
+
+TEST(TestDumpfile, WriteRead) {
+	ASSERT_NO_FATAL_FAILURE(test_dumpfile_roundtrip(false));
+	ASSERT_NO_FATAL_FAILURE(test_dumpfile_roundtrip(true));
+}
+
+TEST(TestDumpfile, DropPolicy) {
+	realmtx_t A(1000, 100);
+	ASSERT_TRUE(!A.isAllocationFailed());
+	A.zeros();
+
+	constexpr unsigned filesCnt = 20;
+	dumpfile_t df(1);
+	df.policy(dumpfile_t::QueueFullPolicy::Drop);
+	char n[64];
+	for (unsigned i = 0; i < filesCnt; ++i) {
+		sprintf_s(n, "./test_dumpfile_%u.ndmp", i);
+		ASSERT_EQ(dumpfile_t::ErrorCode::Success, df.open(n));
+		df & serialization::make_nvp("A", A);
+		ASSERT_EQ(dumpfile_t::ErrorCode::Success, df.close());
+	}
+	ASSERT_EQ(dumpfile_t::ErrorCode::Success, df.wait());
+
+	//every file was either written completely or dropped
+	dumpreader_t rd;
+	unsigned written = 0;
+	for (unsigned i = 0; i < filesCnt; ++i) {
+		sprintf_s(n, "./test_dumpfile_%u.ndmp", i);
+		if (dumpreader_t::ErrorCode::Success == rd.read(n)) {
+			++written;
+			ASSERT_EQ(1u, rd.size());
+			::std::remove(n);
+		}
+	}
+	ASSERT_TRUE(written > 0);
+	ASSERT_EQ(filesCnt, written + df.dropped_count());
+	STDCOUTL("Files written: " << written << ", dropped: " << df.dropped_count());
+}
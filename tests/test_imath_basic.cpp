@@ -188,6 +188,14 @@ void test_dLoss_deCov(vec_len_t rowsCnt, vec_len_t colsCnt = 10) {
 		ASSERT_MTX_EQ(A, A2, "() has changed const A!!");
 		ASSERT_REALMTX_NEAR(dL_ET, dL, "() failed!", dLoss_deCov_EPS<real_t>::eps);
 		//ASSERT_NEAR(etLoss, loss, dLoss_deCov_EPS<real_t>::eps) << "<" << bLowerTriangl << "," << bNumStab << "> failed";
+
+		//the fused version must give the same loss as loss_deCov() and the same derivative
+		const real_t etLoss = iM.loss_deCov<bLowerTriangl, bNumStab>(A);
+		dL.ones();
+		const real_t loss = iM.loss_dLoss_deCov<bLowerTriangl, bNumStab>(A, dL);
+		ASSERT_MTX_EQ(A, A2, "loss_dLoss_deCov() has changed const A!!");
+		ASSERT_REALMTX_NEAR(dL_ET, dL, "loss_dLoss_deCov() failed!", dLoss_deCov_EPS<real_t>::eps);
+		ASSERT_NEAR(etLoss, loss, ::std::abs(etLoss)*real_t(1e-12)) << "loss_dLoss_deCov<" << bLowerTriangl << "," << bNumStab << "> failed";
 	}
 }
 
@@ -212,6 +220,10 @@ TEST(TestMathN, dLoss_deCov) {
 			ASSERT_NO_FATAL_FAILURE((test_dLoss_deCov<double, true, true>(r, c)));
 		}
 	}
+	//wide matrices are processed in several blocks of columns
+	const vec_len_t wideCols = 2 * static_cast<vec_len_t>(imath_basic_t::Thresholds_t::deCov_blockCols) + 37;
+	ASSERT_NO_FATAL_FAILURE((test_dLoss_deCov<double, false, false>(rowsCnt, wideCols)));
+	ASSERT_NO_FATAL_FAILURE((test_dLoss_deCov<double, true, true>(rowsCnt, wideCols)));
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -285,6 +297,10 @@ TEST(TestMathN, loss_deCov) {
 			ASSERT_NO_FATAL_FAILURE((test_loss_deCov<double, true, true>(r, c)));
 		}
 	}
+	//wide matrices are processed in several blocks of columns
+	const vec_len_t wideCols = 2 * static_cast<vec_len_t>(imath_basic_t::Thresholds_t::deCov_blockCols) + 37;
+	ASSERT_NO_FATAL_FAILURE((test_loss_deCov<double, false, false>(rowsCnt, wideCols)));
+	ASSERT_NO_FATAL_FAILURE((test_loss_deCov<double, true, true>(rowsCnt, wideCols)));
 }
 
 TEST(TestMathN, loss_deCovVisually) {
@@ -822,6 +838,68 @@ TEST(TestMathN, LossSoftmaxXentropy) {
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 
+template<typename base_t> struct softmax_xentropy_fused_EPS {};
+template<> struct softmax_xentropy_fused_EPS<double> { static constexpr double eps = 1e-10; };
+template<> struct softmax_xentropy_fused_EPS<float> { static constexpr float eps = 4e-5f; };
+//fused versions must give the same result as softmax() + loss_softmax_xentropy() + evSub_ip()
+void test_softmax_xentropy_fused(vec_len_t rowsCnt, vec_len_t colsCnt) {
+	MTXSIZE_SCOPED_TRACE(rowsCnt, colsCnt, "softmax_xentropy_fused");
+	constexpr vec_len_t testCorrRepCnt = TEST_CORRECTN_REPEATS_COUNT;
+	constexpr real_t eps = softmax_xentropy_fused_EPS<real_t>::eps;
+	realmtxdef_t Z(rowsCnt, colsCnt), A_ET(rowsCnt, colsCnt), dLdZ_ET(rowsCnt, colsCnt), A(rowsCnt, colsCnt);
+	realmtx_t Y(rowsCnt, colsCnt);
+	ASSERT_TRUE(!Z.isAllocationFailed() && !A_ET.isAllocationFailed() && !dLdZ_ET.isAllocationFailed()
+		&& !A.isAllocationFailed() && !Y.isAllocationFailed());
+
+	iM.preinit(iM.softmax_needTempMem<real_t>(Z.size()));
+	ASSERT_TRUE(iM.init());
+	d_interfaces::iRng_t rg;
+	rg.init_ithreads(iM.ithreads());
+
+	for (vec_len_t rr = 0; rr < testCorrRepCnt; ++rr) {
+		rg.gen_matrix(Z, 5);
+		rg.gen_matrix_norm(Y);
+
+		Z.clone_to(A_ET);
+		iM.softmax(A_ET);
+		const real_t et = iM.loss_softmax_xentropy(A_ET, Y) / rowsCnt;
+		A_ET.clone_to(dLdZ_ET);
+		iM.evSub_ip(dLdZ_ET, Y);
+
+		Z.clone_to(A);
+		ASSERT_NEAR(et, iM.softmax_xentropy_loss_st(A, Y) / rowsCnt, eps) << "loss_st failed";
+		ASSERT_REALMTX_NEAR(A_ET, A, "loss_st() failed", eps);
+		Z.clone_to(A);
+		ASSERT_NEAR(et, iM.softmax_xentropy_loss_mt(A, Y) / rowsCnt, eps) << "loss_mt failed";
+		ASSERT_REALMTX_NEAR(A_ET, A, "loss_mt() failed", eps);
+		Z.clone_to(A);
+		ASSERT_NEAR(et, iM.softmax_xentropy_loss(A, Y) / rowsCnt, eps) << "loss() failed";
+		ASSERT_REALMTX_NEAR(A_ET, A, "loss() failed", eps);
+
+		Z.clone_to(A);
+		iM.softmax_xentropy_dLdZ_st(A, Y);
+		ASSERT_REALMTX_NEAR(dLdZ_ET, A, "dLdZ_st() failed", eps);
+		Z.clone_to(A);
+		iM.softmax_xentropy_dLdZ_mt(A, Y);
+		ASSERT_REALMTX_NEAR(dLdZ_ET, A, "dLdZ_mt() failed", eps);
+		Z.clone_to(A);
+		iM.softmax_xentropy_dLdZ(A, Y);
+		ASSERT_REALMTX_NEAR(dLdZ_ET, A, "dLdZ() failed", eps);
+	}
+}
+TEST(TestMathN, SoftmaxXentropyFused) {
+	constexpr vec_len_t rowsCnt = _baseRowsCnt;
+	const vec_len_t maxCols = g_MinDataSizeDelta, maxRows = rowsCnt + g_MinDataSizeDelta;
+	for (vec_len_t r = rowsCnt; r < maxRows; ++r) {
+		for (vec_len_t c = 1; c < maxCols; ++c) ASSERT_NO_FATAL_FAILURE(test_softmax_xentropy_fused(r, c));
+	}
+	//wide matrices are processed in shorter row blocks
+	ASSERT_NO_FATAL_FAILURE(test_softmax_xentropy_fused(rowsCnt, 1000));
+}
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+
 
 template<typename base_t> struct vSumAbs_EPS {};
 template<> struct vSumAbs_EPS<double> { static constexpr double eps = 3e-8; };
@@ -4518,6 +4596,235 @@ TEST(TestMathN, mFillRowsByMask) {
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 
+void test_mRowsByIdx_corr(vec_len_t rowsCnt, vec_len_t colsCnt = 10) {
+	constexpr vec_len_t testCorrRepCnt = TEST_CORRECTN_REPEATS_COUNT;
+
+	realmtx_t src(rowsCnt, colsCnt), mask(rowsCnt, 1), fillDest(rowsCnt, colsCnt), fillDestET(rowsCnt, colsCnt);
+	realmtxdef_t dest(rowsCnt, colsCnt), destET(rowsCnt, colsCnt);
+	::std::vector<vec_len_t> idxs(rowsCnt);
+
+	d_interfaces::iRng_t rg;
+	rg.init_ithreads(iM.ithreads());
+
+	for (vec_len_t r = 0; r < testCorrRepCnt; ++r) {
+		vec_len_t nzc;
+		do {
+			rg.gen_matrix_norm(mask);
+			iM.ewBinarize_ip(mask, real_t(0.3), real_t(0), real_t(1));
+			nzc = iM.vMakeIdxsOfNonZeros(mask.data(), mask.rows(), &idxs[0]);
+		} while (0 == nzc);
+		ASSERT_EQ(static_cast<vec_len_t>(iM.vCountNonZeros(mask.data(), mask.rows())), nzc) << "vMakeIdxsOfNonZeros failed!";
+		dest.deform_rows(nzc);
+		destET.deform_rows(nzc);
+
+		rg.gen_matrix(src, real_t(5));
+
+		destET.zeros();
+		mExtractRowsByMask_ET(src, mask.data(), destET);
+
+		dest.zeros();
+		iM.mExtractRowsByIdx_st(src, &idxs[0], dest);
+		ASSERT_EQ(destET, dest) << "mExtractRowsByIdx_st failed!";
+
+		dest.zeros();
+		iM.mExtractRowsByIdx_mt(src, &idxs[0], dest);
+		ASSERT_EQ(destET, dest) << "mExtractRowsByIdx_mt failed!";
+
+		dest.zeros();
+		iM.mExtractRowsByIdx(src, &idxs[0], dest);
+		ASSERT_EQ(destET, dest) << "mExtractRowsByIdx() failed!";
+
+		//using destET as the source for filling
+		fillDestET.ones();
+		mFillRowsByMask_ET(destET, mask.data(), fillDestET);
+
+		fillDest.ones();
+		iM.mFillRowsByIdx_st(destET, &idxs[0], fillDest);
+		ASSERT_EQ(fillDestET, fillDest) << "mFillRowsByIdx_st failed!";
+
+		fillDest.ones();
+		iM.mFillRowsByIdx_mt(destET, &idxs[0], fillDest);
+		ASSERT_EQ(fillDestET, fillDest) << "mFillRowsByIdx_mt failed!";
+
+		fillDest.ones();
+		iM.mFillRowsByIdx(destET, &idxs[0], fillDest);
+		ASSERT_EQ(fillDestET, fillDest) << "mFillRowsByIdx() failed!";
+	}
+}
+
+TEST(TestMathN, mRowsByIdx) {
+	for (vec_len_t r = 1; r < g_MinDataSizeDelta; ++r) {
+		for (vec_len_t c = 1; c < g_MinDataSizeDelta; ++c) {
+			ASSERT_NO_FATAL_FAILURE((test_mRowsByIdx_corr(r, c)));
+		}
+	}
+
+	constexpr vec_len_t rowsCnt = _baseRowsCnt;
+	const vec_len_t maxCols = g_MinDataSizeDelta, maxRows = rowsCnt + g_MinDataSizeDelta;
+	for (vec_len_t r = rowsCnt; r < maxRows; ++r) {
+		for (vec_len_t c = 1; c < maxCols; ++c) {
+			ASSERT_NO_FATAL_FAILURE((test_mRowsByIdx_corr(r, c)));
+		}
+	}
+}
+
+void test_mEmbeddings_corr(const vec_len_t rowsCnt, const vec_len_t vocabSize, const vec_len_t embDim, const vec_len_t idsCnt) {
+	d_interfaces::iRng_t rg;
+	rg.init_ithreads(iM.ithreads());
+
+	realmtx_t ids(rowsCnt, idsCnt, true), W(embDim, vocabSize, false), dLdA(rowsCnt, idsCnt*embDim, false);
+	realmtx_t act_st(rowsCnt, idsCnt*embDim, true), act_mt(rowsCnt, idsCnt*embDim, true);
+	ASSERT_TRUE(!ids.isAllocationFailed() && !W.isAllocationFailed() && !dLdA.isAllocationFailed()
+		&& !act_st.isAllocationFailed() && !act_mt.isAllocationFailed());
+
+	//every id maps to the column of dLdWc with the same index
+	::std::vector<vec_len_t> slots(realmtx_t::sNumel(rowsCnt, idsCnt));
+	realmtx_t dLdWc_et(embDim, vocabSize, false), dLdWc_st(embDim, vocabSize, false), dLdWc_mt(embDim, vocabSize, false);
+	ASSERT_TRUE(!dLdWc_et.isAllocationFailed() && !dLdWc_st.isAllocationFailed() && !dLdWc_mt.isAllocationFailed());
+
+	const real_t sc = real_t(.3);
+	for (unsigned tr = 0; tr < TEST_CORRECTN_REPEATS_COUNT; ++tr) {
+		for (numel_cnt_t i = 0, ne = ids.numel_no_bias(); i < ne; ++i) {
+			const auto id = static_cast<vec_len_t>(rg(vocabSize));
+			ids.data()[i] = real_t(id);
+			slots[i] = id;
+		}
+		rg.gen_matrix(W, real_t(5));
+		rg.gen_matrix(dLdA, real_t(5));
+
+		dLdWc_et.zeros();
+		for (vec_len_t c = 0; c < idsCnt; ++c) {
+			for (vec_len_t r = 0; r < rowsCnt; ++r) {
+				const auto id = static_cast<vec_len_t>(ids.get(r, c));
+				for (vec_len_t d = 0; d < embDim; ++d) dLdWc_et.get(d, id) += dLdA.get(r, c*embDim + d);
+			}
+		}
+		iM.evMulC_ip(dLdWc_et, sc);
+
+		iM.mGatherEmbeddings_st(ids, W, act_st);
+		iM.mGatherEmbeddings_mt(ids, W, act_mt);
+		ASSERT_TRUE(act_st.test_biases_strict() && act_mt.test_biases_strict());
+		ASSERT_EQ(act_st, act_mt) << "_st and _mt versions of mGatherEmbeddings differ";
+		for (vec_len_t c = 0; c < idsCnt; ++c) {
+			for (vec_len_t r = 0; r < rowsCnt; ++r) {
+				const auto id = static_cast<vec_len_t>(ids.get(r, c));
+				for (vec_len_t d = 0; d < embDim; ++d) ASSERT_EQ(W.get(d, id), act_st.get(r, c*embDim + d));
+			}
+		}
+
+		iM.mScatterAddEmbeddingsGrad_st(sc, dLdA, &slots[0], dLdWc_st);
+		ASSERT_MTX_EQ(dLdWc_et, dLdWc_st, "mScatterAddEmbeddingsGrad_st() failed correctness test");
+		iM.mScatterAddEmbeddingsGrad_mt(sc, dLdA, &slots[0], dLdWc_mt);
+		ASSERT_MTX_EQ(dLdWc_et, dLdWc_mt, "mScatterAddEmbeddingsGrad_mt() failed correctness test");
+	}
+}
+
+TEST(TestMathN, mEmbeddings) {
+	for (vec_len_t r = 1; r < g_MinDataSizeDelta; ++r) {
+		ASSERT_NO_FATAL_FAILURE(test_mEmbeddings_corr(r, 31, 7, 3));
+	}
+
+	constexpr vec_len_t rowsCnt = _baseRowsCnt;
+	const vec_len_t maxRows = rowsCnt + g_MinDataSizeDelta;
+	for (vec_len_t r = rowsCnt; r < maxRows; ++r) {
+		for (vec_len_t d = 1; d < g_MinDataSizeDelta; ++d) {
+			ASSERT_NO_FATAL_FAILURE(test_mEmbeddings_corr(r, 100, d, 4));
+		}
+	}
+}
+
+template<typename base_t> struct mMulABt_sparseB_EPS {};
+template<> struct mMulABt_sparseB_EPS<double> { static constexpr double eps = 1e-10; };
+template<> struct mMulABt_sparseB_EPS<float> { static constexpr float eps = 1e-3f; };
+
+void test_mPruneSparse_corr(const vec_len_t rowsCnt, const vec_len_t incCnt, const vec_len_t neurCnt, const real_t sparsity) {
+	d_interfaces::iRng_t rg;
+	rg.init_ithreads(iM.ithreads());
+
+	realmtxdef_t W(neurCnt, incCnt + 1, false);
+	realmtx_t mask(neurCnt, incCnt + 1, false), prevAct(rowsCnt, incCnt, true), dLdZ(rowsCnt, neurCnt, false);
+	realmtx_t act_et(rowsCnt, neurCnt, true), act_st(rowsCnt, neurCnt, true), act_mt(rowsCnt, neurCnt, true);
+	realmtx_t dLdAPrev_et(rowsCnt, incCnt, false), dLdAPrev_st(rowsCnt, incCnt, false), dLdAPrev_mt(rowsCnt, incCnt, false);
+	ASSERT_TRUE(!W.isAllocationFailed() && !mask.isAllocationFailed() && !prevAct.isAllocationFailed() && !dLdZ.isAllocationFailed()
+		&& !act_et.isAllocationFailed() && !act_st.isAllocationFailed() && !act_mt.isAllocationFailed()
+		&& !dLdAPrev_et.isAllocationFailed() && !dLdAPrev_st.isAllocationFailed() && !dLdAPrev_mt.isAllocationFailed());
+
+	const auto k = static_cast<vec_len_t>(sparsity*incCnt);
+	realmtx_t W0;
+	math::smatrix_csr<real_t> spW, spWt;
+	for (unsigned tr = 0; tr < TEST_CORRECTN_REPEATS_COUNT; ++tr) {
+		rg.gen_matrix(W, real_t(5));
+		rg.gen_matrix_no_bias(prevAct, real_t(5));
+		rg.gen_matrix(dLdZ, real_t(5));
+
+		ASSERT_TRUE(W.clone_to(W0));
+		mask.ones();
+		iM.mMakePruneMaskByMagnitude(W, sparsity / 2, mask);
+		iM.mMakePruneMaskByMagnitude(W, sparsity, mask);
+		for (vec_len_t r = 0; r < neurCnt; ++r) {
+			ASSERT_EQ(real_t(1), mask.get(r, incCnt)) << "Bias must never be pruned";
+			vec_len_t zc = 0;
+			real_t maxPruned(0), minLeft(::std::numeric_limits<real_t>::max());
+			for (vec_len_t c = 0; c < incCnt; ++c) {
+				if (mask.get(r, c) == real_t(0)) {
+					++zc;
+					ASSERT_EQ(real_t(0), W.get(r, c)) << "Pruned weight must be zeroed";
+					maxPruned = ::std::max(maxPruned, ::std::abs(W0.get(r, c)));
+				} else {
+					ASSERT_EQ(real_t(1), mask.get(r, c));
+					ASSERT_EQ(W0.get(r, c), W.get(r, c)) << "Weight left must be intact";
+					minLeft = ::std::min(minLeft, ::std::abs(W0.get(r, c)));
+				}
+			}
+			ASSERT_EQ(k, zc) << "Wrong number of pruned weights @ row " << r;
+			ASSERT_LE(maxPruned, minLeft) << "Not the smallest weights were pruned @ row " << r;
+		}
+
+		ASSERT_TRUE(spW.make_from(W, mask, W.cols(), false));
+		ASSERT_TRUE(spWt.make_from(W, mask, W.cols() - 1, true));
+		ASSERT_EQ(realmtx_t::sNumel(neurCnt, incCnt - k) + neurCnt, spW.nnz());
+		ASSERT_EQ(realmtx_t::sNumel(neurCnt, incCnt - k), spWt.nnz());
+
+		iM.mMul_prevAct_weights_2_act(prevAct, W, act_et);
+		iM.mMulABt_sparseB_st(prevAct, spW, act_st);
+		ASSERT_TRUE(act_st.test_biases_strict());
+		ASSERT_REALMTX_NEAR(act_et, act_st, "mMulABt_sparseB_st() fprop failed correctness test", mMulABt_sparseB_EPS<real_t>::eps);
+		iM.mMulABt_sparseB_mt(prevAct, spW, act_mt);
+		ASSERT_TRUE(act_mt.test_biases_strict());
+		ASSERT_REALMTX_NEAR(act_et, act_mt, "mMulABt_sparseB_mt() fprop failed correctness test", mMulABt_sparseB_EPS<real_t>::eps);
+
+		iM.mMul_dLdZ_weights_2_dLdAPrev(dLdZ, W, dLdAPrev_et);
+		iM.mMulABt_sparseB_st(dLdZ, spWt, dLdAPrev_st);
+		ASSERT_REALMTX_NEAR(dLdAPrev_et, dLdAPrev_st, "mMulABt_sparseB_st() bprop failed correctness test", mMulABt_sparseB_EPS<real_t>::eps);
+		iM.mMulABt_sparseB_mt(dLdZ, spWt, dLdAPrev_mt);
+		ASSERT_REALMTX_NEAR(dLdAPrev_et, dLdAPrev_mt, "mMulABt_sparseB_mt() bprop failed correctness test", mMulABt_sparseB_EPS<real_t>::eps);
+
+		//values must follow the dense matrix
+		iM.evMulC_ip(W, real_t(2));
+		spW.update_values(W);
+		iM.mMul_prevAct_weights_2_act(prevAct, W, act_et);
+		iM.mMulABt_sparseB_st(prevAct, spW, act_st);
+		ASSERT_REALMTX_NEAR(act_et, act_st, "smatrix_csr::update_values() failed correctness test", mMulABt_sparseB_EPS<real_t>::eps);
+	}
+}
+
+TEST(TestMathN, mPruneSparse) {
+	for (vec_len_t r = 1; r < g_MinDataSizeDelta; ++r) {
+		ASSERT_NO_FATAL_FAILURE(test_mPruneSparse_corr(r, 37, 11, real_t(.8)));
+	}
+
+	constexpr vec_len_t rowsCnt = _baseRowsCnt;
+	const vec_len_t maxRows = rowsCnt + g_MinDataSizeDelta;
+	for (vec_len_t r = rowsCnt; r < maxRows; ++r) {
+		for (vec_len_t n = 1; n < g_MinDataSizeDelta; ++n) {
+			ASSERT_NO_FATAL_FAILURE(test_mPruneSparse_corr(r, 100, n, real_t(.9)));
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+
 //NOTE: libxsmm code below are fine, but I see no sense in integrating it in the project, b/c
 //it helps (on my hw-architecture) mostly in very narrow case of small matrices (see below a perf check) and unclogged cache
 // Don't want to delete the code here, may be helpful later, so leaving it commented out
@@ -4616,6 +4923,24 @@ void mTranspose_corr(const CommonDataT& cd, vec_len_t batchSiz, vec_len_t sample
 			ASSERT_MTX_EQ(srcET, src2, "mTranspose_seq_read() failed double application!");
 		}
 
+		destT.ones();
+		iM.mTranspose_blocked_st(srcET, destT, bIgnoreBias);
+		ASSERT_MTX_EQ(destTET, destT, "mTranspose_blocked_st() failed!");
+		if (bSameBias) {
+			src2.ones();
+			iM.mTranspose_blocked_st(destT, src2, bIgnoreBias);
+			ASSERT_MTX_EQ(srcET, src2, "mTranspose_blocked_st() failed double application!");
+		}
+
+		destT.ones();
+		iM.mTranspose_blocked_mt(srcET, destT, bIgnoreBias);
+		ASSERT_MTX_EQ(destTET, destT, "mTranspose_blocked_mt() failed!");
+		if (bSameBias) {
+			src2.ones();
+			iM.mTranspose_blocked_mt(destT, src2, bIgnoreBias);
+			ASSERT_MTX_EQ(srcET, src2, "mTranspose_blocked_mt() failed double application!");
+		}
+
 		destT.ones();
 		iM.mTranspose(srcET, destT, bIgnoreBias);
 		ASSERT_MTX_EQ(destTET, destT, "mTranspose(bIgnoreBias) failed!");
@@ -4697,6 +5022,8 @@ TEST(TestMathN, mTranspose) {
 	for (int bin = 0; bin < (1 << 4); ++bin) {
 		ASSERT_NO_FATAL_FAILURE(mTranspose_corr(cd, 17, 1291, !(bin & 1), !(bin & 2), !(bin & 4), !(bin & 8)));
 		ASSERT_NO_FATAL_FAILURE(mTranspose_corr(cd, 1291, 17, !(bin & 1), !(bin & 2), !(bin & 4), !(bin & 8)));
+		//several levels of blocks in both dimensions with partial edge blocks and tiles
+		ASSERT_NO_FATAL_FAILURE(mTranspose_corr(cd, 301, 267, !(bin & 1), !(bin & 2), !(bin & 4), !(bin & 8)));
 	}
 #endif
 
@@ -5637,3 +5964,96 @@ TEST(TestMathN, mMul_prevAct_weights_2_act) {
 
 }
 
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+//straightforward single pass over each column, the original mcwFindKOrdered() algorithm
+template<typename HelperT>
+void mcwFindKOrdered_ET(const math::smatrix<typename HelperT::src_value_t>& src, typename HelperT::hlprmtx_t& mHlpr, const bool bNextBatch) {
+	typedef typename HelperT::OrderFunctor_t OrderFunctor_t;
+	const vec_len_t k = HelperT::get_k(mHlpr), r = src.rows_no_bias();
+	for (vec_len_t c = 0; c < mHlpr.cols(); ++c) {
+		const auto pS = src.colDataAsVec(c);
+		const auto pI = HelperT::get_idxs_ptr_from_column_ptr(mHlpr.colDataAsVec(c), k);
+		const auto pCache = HelperT::get_cache_ptr_from_column_ptr(mHlpr.colDataAsVec(c), k);
+		for (vec_len_t i = 0; i < k; ++i) {
+			pI[i] = -1;
+			if (!bNextBatch) pCache[i] = OrderFunctor_t::most_extreme();
+		}
+		for (vec_len_t i = 0; i < r; ++i) {
+			const auto v = pS[i];
+			if (!OrderFunctor_t::first_better(v, pCache[0])) continue;
+			vec_len_t hi = 1;
+			while (hi < k && !OrderFunctor_t::first_better(pCache[hi], v)) ++hi;
+			const auto insertPos = hi - 1;
+			if (HelperT::bNonStrictComparision || OrderFunctor_t::first_better(v, pCache[insertPos])) {
+				for (vec_len_t hj = 0; hj < insertPos; ++hj) {
+					pCache[hj] = pCache[hj + 1];
+					pI[hj] = pI[hj + 1];
+				}
+				pCache[insertPos] = v;
+				pI[insertPos] = i;
+			}
+		}
+	}
+}
+
+template<template<class>class OrderTpl>
+void test_mcwFindKOrdered_corr(const vec_len_t rowsCnt, const vec_len_t colsCnt, const vec_len_t k) {
+	typedef math::mcwFindKOrdered_hlpr<real_t, OrderTpl> hlpr_t;
+	typedef typename hlpr_t::hlprmtx_t hlprmtx_t;
+	MTXSIZE_SCOPED_TRACE(rowsCnt, colsCnt, "mcwFindKOrdered");
+
+	realmtx_t src(rowsCnt, colsCnt);
+	hlprmtx_t hlpr(hlpr_t::hlprmtx_size_for(k, colsCnt)), hlpr_ET(hlpr_t::hlprmtx_size_for(k, colsCnt));
+	ASSERT_TRUE(!src.isAllocationFailed() && !hlpr.isAllocationFailed() && !hlpr_ET.isAllocationFailed());
+
+	iM.preinit(iM.mcwFindKOrdered_needTempMem<hlpr_t>(k));
+	ASSERT_TRUE(iM.init());
+	d_interfaces::iRng_t rg;
+	rg.init_ithreads(iM.ithreads());
+
+	for (vec_len_t rr = 0; rr < TEST_CORRECTN_REPEATS_COUNT; ++rr) {
+		for (int b = 0; b < 2; ++b) {
+			const bool bNextBatch = (b > 0);
+			rg.gen_matrix(src, 50);
+			//lots of equal values to check ties handling
+			for (auto p = src.data(), pE = src.end(); p != pE; ++p) *p = ::std::round(*p);
+
+			mcwFindKOrdered_ET<hlpr_t>(src, hlpr_ET, bNextBatch);
+			iM.mcwFindKOrdered<hlpr_t>(src, hlpr, bNextBatch);
+
+			for (vec_len_t c = 0; c < colsCnt; ++c) {
+				const auto pI = hlpr_t::get_idxs_ptr_from_column_ptr(hlpr.colDataAsVec(c), k);
+				const auto pI_ET = hlpr_t::get_idxs_ptr_from_column_ptr(hlpr_ET.colDataAsVec(c), k);
+				const auto pC = hlpr_t::get_cache_ptr_from_column_ptr(hlpr.colDataAsVec(c), k);
+				const auto pC_ET = hlpr_t::get_cache_ptr_from_column_ptr(hlpr_ET.colDataAsVec(c), k);
+				for (vec_len_t i = 0; i < k; ++i) {
+					ASSERT_EQ(pC_ET[i], pC[i]) << "wrong value, k=" << k << " bNextBatch=" << bNextBatch << " col=" << c << " i=" << i;
+					ASSERT_EQ(pI_ET[i], pI[i]) << "wrong index, k=" << k << " bNextBatch=" << bNextBatch << " col=" << c << " i=" << i;
+				}
+			}
+		}
+	}
+}
+
+template<template<class>class OrderTpl>
+void test_mcwFindKOrdered_corr_all() {
+	for (vec_len_t c = 1; c < g_MinDataSizeDelta; c += 3) {
+		ASSERT_NO_FATAL_FAILURE(test_mcwFindKOrdered_corr<OrderTpl>(_baseRowsCnt * 5, c, 5));
+	}
+	//radix histogram prefiltering
+	const vec_len_t bigK = imath_basic_t::Thresholds_t::mcwFindKOrdered_radix_k;
+	ASSERT_NO_FATAL_FAILURE(test_mcwFindKOrdered_corr<OrderTpl>(bigK * imath_basic_t::Thresholds_t::mcwFindKOrdered_radix_maxRowsPerK, 3, bigK));
+	//splitting columns over threads
+	const vec_len_t mtRows = imath_basic_t::Thresholds_t::mcwFindKOrdered_mt_rows + 37;
+	ASSERT_NO_FATAL_FAILURE(test_mcwFindKOrdered_corr<OrderTpl>(mtRows, 1, 10));
+	ASSERT_NO_FATAL_FAILURE(test_mcwFindKOrdered_corr<OrderTpl>(mtRows, 2, bigK));
+}
+
+TEST(TestMathN, mcwFindKOrdered) {
+	ASSERT_NO_FATAL_FAILURE(test_mcwFindKOrdered_corr_all<math::Order_BiggestDistinct>());
+	ASSERT_NO_FATAL_FAILURE(test_mcwFindKOrdered_corr_all<math::Order_Biggest>());
+	ASSERT_NO_FATAL_FAILURE(test_mcwFindKOrdered_corr_all<math::Order_SmallestDistinct>());
+	ASSERT_NO_FATAL_FAILURE(test_mcwFindKOrdered_corr_all<math::Order_Smallest>());
+}
@@ -36,6 +36,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "../nntl/nntl.h"
 #include "../nntl/_supp/io/matfile.h"
+#include "../nntl/_supp/io/dumpfile.h"
 
 #include "../nntl/interface/inspectors/stdcout.h"
 #include "../nntl/interface/inspectors/dumper.h"
@@ -148,4 +149,66 @@ TEST(TestInspectors, DumperMat) {
 #else
 	STDCOUTL("###To run the test compile a code with NNTL_MATLAB_AVAILABLE 1");
 #endif
+}
+
+TEST(TestInspectors, DumperAsync) {
+	inmem_train_data<real_t> td;
+	readTd(td, MNIST_FILE_DEBUG);
+
+	size_t epochs = 2, seedVal = 0;
+	const real_t learningRate = real_t(.01);
+
+	typedef inspector::dumper<real_t, nntl_supp::adumpfile<>> myInspector;
+	struct myIntf : public d_int_nI<real_t> {
+		typedef myInspector iInspect_t;
+	};
+	typedef grad_works<myIntf> myGW;
+	typedef activation::sigm<real_t, weights_init::XavierFour> myAct;
+	typedef activation::sigm_quad_loss<real_t, weights_init::XavierFour> myActO;
+
+	layer_input<myIntf> inp(td.train_x().cols_no_bias(), "Source");
+	layer_fully_connected<myAct, myGW> ifcl1(20, learningRate, "First");
+	layer_output<myActO, myGW> outp(td.train_y().cols(), learningRate, "Predictor");
+
+	auto lp = make_layers(inp, ifcl1, outp);
+
+	nnet_train_opts<real_t> opts(epochs);
+	opts.calcFullLossValue(false).batchSize(100);
+
+	myInspector Insp("./test_data");
+	Insp.blacklist(inp.get_layer_type_id());
+	Insp.getArchive().compression(true);
+
+	auto nn = make_nnet(lp, Insp);
+	nn.get_iRng().seed64(seedVal);
+
+	auto ec = nn.train(td, opts);
+	ASSERT_EQ(decltype(nn)::ErrorCode::Success, ec) << "Error code description: " << nn.get_last_error_string();
+	ASSERT_EQ(nntl_supp::adumpfile<>::ErrorCode::Success, Insp.getArchive().wait());
+
+	//the first batch of the last epoch is dumped by default
+	nntl_supp::dumpfile_reader rd;
+	ASSERT_EQ(nntl_supp::dumpfile_reader::ErrorCode::Success, rd.read("./test_data/ep002_000_f.ndmp"))
+		<< rd.get_last_error_str();
+	ASSERT_EQ(4, rd.size());
+
+	//records must survive the compression and be consistent with each other: A2 = sigm([A1|1]*W2')
+	realmtx_t W1, A1, W2, A2;
+	ASSERT_EQ(nntl_supp::dumpfile_reader::ErrorCode::Success, rd.get("First_1.W", W1)) << rd.get_last_error_str();
+	ASSERT_EQ(nntl_supp::dumpfile_reader::ErrorCode::Success, rd.get("First_1.A", A1)) << rd.get_last_error_str();
+	ASSERT_EQ(nntl_supp::dumpfile_reader::ErrorCode::Success, rd.get("Predictor_2.W", W2)) << rd.get_last_error_str();
+	ASSERT_EQ(nntl_supp::dumpfile_reader::ErrorCode::Success, rd.get("Predictor_2.A", A2)) << rd.get_last_error_str();
+	ASSERT_EQ(realmtx_t::mtx_size_t(20, td.train_x().cols()), W1.size());
+	ASSERT_EQ(realmtx_t::mtx_size_t(100, 21), A1.size());
+	ASSERT_EQ(realmtx_t::mtx_size_t(td.train_y().cols(), 21), W2.size());
+	ASSERT_EQ(realmtx_t::mtx_size_t(100, td.train_y().cols()), A2.size());
+
+	for (vec_len_t r = 0; r < A1.rows(); ++r) {
+		ASSERT_EQ(real_t(1), A1.get(r, 20)) << "Wrong bias @ r=" << r;
+		for (vec_len_t n = 0; n < A2.cols(); ++n) {
+			real_t z = 0;
+			for (vec_len_t c = 0; c < A1.cols(); ++c) z += A1.get(r, c)*W2.get(n, c);
+			ASSERT_NEAR(real_t(1) / (real_t(1) + ::std::exp(-z)), A2.get(r, n), real_t(1e-5)) << "@ r=" << r << ", n=" << n;
+		}
+	}
 }
\ No newline at end of file
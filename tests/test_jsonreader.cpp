@@ -40,8 +40,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../nntl/math.h"
 #include "../nntl/common.h"
 #include "../nntl/_supp/io/jsonreader.h"
+#include "../nntl/_supp/io/jsonreader_mt.h"
 #include "../nntl/interfaces.h"
 #include <array>
+#include <random>
 
 using namespace nntl;
 
@@ -125,4 +127,86 @@ TEST(TestJsonreader, ReadingAndParsingTrainData) {
 			EXPECT_EQ(test_y_data[i][j], td.test_y().get(j, i));
 	}
 	
-}
\ No newline at end of file
+}
+
+TEST(TestJsonreader, MultithreadedReaderMatchesDOMReader) {
+	using namespace nntl_supp;
+	typedef inmem_train_data<real_t> train_data_t;
+	typedef math::smatrix<real_t> realmtx_t;
+
+	d_interfaces::iMath_t iM;
+	jsonreader reader;
+	jsonreader_mt readerMt;
+
+	realmtx_t m, mMt;
+	ASSERT_EQ(jsonreader::ErrorCode::Success, reader.read(NNTL_STRING("./test_data/mtx4-2.json"), m));
+	ASSERT_EQ(jsonreader_mt::ErrorCode::Success, readerMt.read(NNTL_STRING("./test_data/mtx4-2.json"), mMt, iM.ithreads()))
+		<< "Error code description: " << readerMt.get_last_error_string();
+	ASSERT_EQ(m, mMt);
+
+	train_data_t td, tdMt;
+	ASSERT_EQ(jsonreader::ErrorCode::Success, reader.read(NNTL_STRING("./test_data/traindata.json"), td));
+	ASSERT_EQ(jsonreader_mt::ErrorCode::Success, readerMt.read(NNTL_STRING("./test_data/traindata.json"), tdMt, iM.ithreads()))
+		<< "Error code description: " << readerMt.get_last_error_string();
+	ASSERT_TRUE(td == tdMt);
+}
+
+TEST(TestJsonreader, MultithreadedReaderChunks) {
+	using namespace nntl_supp;
+	typedef inmem_train_data<real_t> train_data_t;
+	const char* jsonFile = "./test_data/_tmp_big.json";
+	const char* binFile = "./test_data/_tmp_big.bin";
+
+	//a file big enough to be split into many chunks. Numbers are of different kinds to test both parsing paths
+	::std::mt19937 rng(17);
+	::std::uniform_real_distribution<double> distr(-100, 100);
+	{
+		FILE* fp = nullptr;
+		ASSERT_TRUE(0 == fopen_s(&fp, jsonFile, "wb") && fp);
+		const auto writeMtx = [&rng, &distr, fp](const char* name, const int rows, const int cols, const bool bLast) {
+			fprintf(fp, "\"%s\": [", name);
+			for (int c = 0; c < cols; ++c) {
+				if (cols > 1) fprintf(fp, c ? ",\n[" : "[");
+				for (int r = 0; r < rows; ++r) {
+					const double v = distr(rng);
+					if (r % 3 == 0) fprintf(fp, r ? ", %.17g" : "%.17g", v);
+					else if (r % 3 == 1) fprintf(fp, ",%.6g", v);
+					else fprintf(fp, ",%de-2", static_cast<int>(v * 100));
+				}
+				if (cols > 1) fprintf(fp, "]");
+			}
+			fprintf(fp, bLast ? "]\n" : "],\n");
+		};
+		fprintf(fp, "{\"comment\": \"skipped [member]\", \"nested\": {\"a\":[1,2,{\"b\":null}]},\n");
+		writeMtx("train_x", 1000, 17, false);
+		writeMtx("train_y", 1000, 1, false);
+		writeMtx("test_x", 300, 17, false);
+		writeMtx("test_y", 300, 1, false);
+		fprintf(fp, "\"bColMajor\": true}");
+		fclose(fp);
+	}
+
+	d_interfaces::iMath_t iM;
+	jsonreader reader;
+	jsonreader_mt readerMt;
+	readerMt.m_minChunkBytes = 64;
+
+	train_data_t td, tdMt;
+	ASSERT_EQ(jsonreader::ErrorCode::Success, reader.read(jsonFile, td)) << reader.get_last_error_string();
+	ASSERT_EQ(jsonreader_mt::ErrorCode::Success, readerMt.read(jsonFile, tdMt, iM.ithreads()))
+		<< "Error code description: " << readerMt.get_last_error_string();
+	ASSERT_EQ(1000, tdMt.train_x().rows());
+	ASSERT_EQ(17, tdMt.train_x().cols_no_bias());
+	ASSERT_TRUE(td == tdMt);
+
+	//conversion to binfile
+	ASSERT_EQ(jsonreader_mt::ErrorCode::Success, readerMt.convert2bin<real_t>(jsonFile, binFile, iM.ithreads()))
+		<< "Error code description: " << readerMt.get_last_error_string();
+	binfile bf;
+	train_data_t tdBin;
+	ASSERT_EQ(binfile::ErrorCode::Success, bf.read(binFile, tdBin)) << bf.get_last_error_str();
+	ASSERT_TRUE(td == tdBin);
+
+	::std::remove(jsonFile);
+	::std::remove(binFile);
+}
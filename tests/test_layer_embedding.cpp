@@ -0,0 +1,309 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "stdafx.h"
+
+//to get rid of '... decorated name length exceeded, name was truncated'
+#pragma warning( disable : 4503 )
+
+#include "../nntl/math.h"
+#include "../nntl/nntl.h"
+#include "asserts.h"
+#include "common_routines.h"
+
+using namespace nntl;
+
+typedef d_interfaces::real_t real_t;
+typedef math::smatrix<real_t> realmtx_t;
+typedef math::smatrix_deform<real_t> realmtxdef_t;
+
+template<typename base_t> struct TestLayerEmbedding_EPS {};
+template<> struct TestLayerEmbedding_EPS <double> { static constexpr double eps = 1e-12; };
+template<> struct TestLayerEmbedding_EPS <float> { static constexpr float eps = 1e-5f; };
+
+//LE must behave exactly like a linear LFC without biases fed with one-hot encoded ids, where the same table is used for each
+// of the ids columns
+TEST(TestLayerEmbedding, ComparativeOneHot) {
+	constexpr vec_len_t samplesCount = 97, vocabSize = 23, unusedIds = 4;
+	constexpr neurons_count_t embDim = 7, idsCnt = 3;
+	const real_t lr = real_t(.5);
+
+	realmtx_t ids(samplesCount, idsCnt, true), onehot(samplesCount, idsCnt*vocabSize, true), _train_y(samplesCount, 1, false);
+	ASSERT_TRUE(!ids.isAllocationFailed() && !onehot.isAllocationFailed() && !_train_y.isAllocationFailed());
+
+	typedef layer_output<activation::sigm_quad_loss<real_t>> LO;
+
+	//////////////////////////////////////////////////////////////////////////
+	layer_input<> Ainp(idsCnt);
+	LE<> Ale(vocabSize, embDim, idsCnt, lr);
+	LO Aoutp(_train_y.cols(), lr);
+
+	auto Alp = make_layers(Ainp, Ale, Aoutp);
+	auto Ann = make_nnet(Alp);
+
+	//the last unusedIds ids are never used, so their embeddings must stay intact
+	auto& rg = Ann.get_iRng();
+	onehot.zeros();
+	for (vec_len_t c = 0; c < idsCnt; ++c) {
+		for (vec_len_t r = 0; r < samplesCount; ++r) {
+			const auto id = static_cast<vec_len_t>(rg(vocabSize - unusedIds));
+			ids.get(r, c) = real_t(id);
+			onehot.get(r, c*vocabSize + id) = real_t(1);
+		}
+	}
+	rg.gen_matrix_norm(_train_y);
+
+	auto ec = Ann.___init(samplesCount, samplesCount, false);
+	ASSERT_EQ(decltype(Ann)::ErrorCode::Success, ec);
+
+	realmtx_t E, AoutpW, AleAct;
+	ASSERT_TRUE(Ale.get_weights().clone_to(E));
+	ASSERT_TRUE(Aoutp.get_weights().clone_to(AoutpW));
+
+	Ann.___get_common_data().set_mode_and_batch_size(true, samplesCount);
+	Alp.on_batch_size_change(samplesCount);
+	Alp.fprop(ids);
+	ASSERT_TRUE(Ale.get_activations().clone_to(AleAct));
+	Alp.bprop(_train_y);
+
+	//////////////////////////////////////////////////////////////////////////
+	layer_input<> Binp(idsCnt*vocabSize);
+	LFC<activation::identity<real_t>> Bfc(idsCnt*embDim, lr);
+	LO Boutp(_train_y.cols(), lr);
+
+	auto Blp = make_layers(Binp, Bfc, Boutp);
+	auto Bnn = make_nnet(Blp);
+
+	ec = Bnn.___init(samplesCount, samplesCount, false);
+	ASSERT_EQ(decltype(Bnn)::ErrorCode::Success, ec);
+
+	//block diagonal weights with the same table in each block and zero biases
+	realmtx_t W(idsCnt*embDim, idsCnt*vocabSize + 1, false);
+	ASSERT_TRUE(!W.isAllocationFailed());
+	W.zeros();
+	for (vec_len_t c = 0; c < idsCnt; ++c) {
+		for (vec_len_t v = 0; v < vocabSize; ++v) {
+			for (vec_len_t d = 0; d < embDim; ++d) W.get(c*embDim + d, c*vocabSize + v) = E.get(d, v);
+		}
+	}
+	realmtx_t W0;
+	ASSERT_TRUE(W.clone_to(W0));
+	ASSERT_TRUE(Bfc.set_weights(::std::move(W)));
+	ASSERT_TRUE(Boutp.set_weights(::std::move(AoutpW)));
+
+	Bnn.___get_common_data().set_mode_and_batch_size(true, samplesCount);
+	Blp.on_batch_size_change(samplesCount);
+	Blp.fprop(onehot);
+
+	ASSERT_REALMTX_NEAR(AleAct, static_cast<const realmtx_t&>(Bfc.get_activations()),
+		"Post-fprop activations comparison failed!", TestLayerEmbedding_EPS<real_t>::eps);
+	Blp.bprop(_train_y);
+
+	ASSERT_REALMTX_NEAR(Aoutp.get_weights(), Boutp.get_weights(),
+		"Output layer post-bprop weights comparison failed!", TestLayerEmbedding_EPS<real_t>::eps);
+
+	//the embedding update must be equal to the sum of the updates of the diagonal blocks
+	const auto& Ae = Ale.get_weights();
+	const auto& Bw = Bfc.get_weights();
+	for (vec_len_t v = 0; v < vocabSize; ++v) {
+		for (vec_len_t d = 0; d < embDim; ++d) {
+			real_t upd = real_t(0);
+			for (vec_len_t c = 0; c < idsCnt; ++c) {
+				upd += Bw.get(c*embDim + d, c*vocabSize + v) - W0.get(c*embDim + d, c*vocabSize + v);
+			}
+			ASSERT_NEAR(E.get(d, v) + upd, Ae.get(d, v), TestLayerEmbedding_EPS<real_t>::eps) << "Wrong embedding @ d=" << d << ", v=" << v;
+			if (v >= vocabSize - unusedIds) {
+				ASSERT_EQ(E.get(d, v), Ae.get(d, v)) << "Unused embedding has been changed @ d=" << d << ", v=" << v;
+			}
+		}
+	}
+}
+
+//apply_grad_sparse() must give the same result as the dense optimizer for the touched columns and leave the rest intact
+template<typename GwT>
+void test_le_lazy_optimizer(const typename GwT::GradType gt) {
+	constexpr vec_len_t embDim = 16, vocabSize = 17;
+	const real_t lr = real_t(.01), eps = real_t(1e-6);
+	const vec_len_t S1[] = { 1, 4, 5, 9, 16 }, S2[] = { 4, 7 };
+	constexpr vec_len_t n1 = sizeof(S1) / sizeof(S1[0]), n2 = sizeof(S2) / sizeof(S2[0]);
+
+	layer_input<> inp(1);
+	LE<GwT> le(vocabSize, embDim, 1, lr);
+	layer_output<activation::sigm_quad_loss<real_t>> outp(1, lr);
+	auto lp = make_layers(inp, le, outp);
+	auto nn = make_nnet(lp);
+	ASSERT_EQ(decltype(nn)::ErrorCode::Success, nn.___init(10, 10, false));
+	auto& iM = nn.get_iMath();
+	auto& rg = nn.get_iRng();
+
+	realmtx_t W(embDim, vocabSize, false), Wr, A(embDim, vocabSize, false), B(embDim, vocabSize, false), Gd(embDim, vocabSize, false)
+		, G(embDim, n1, false), Gc, Wprev;
+	ASSERT_TRUE(!W.isAllocationFailed() && !A.isAllocationFailed() && !B.isAllocationFailed() && !Gd.isAllocationFailed() && !G.isAllocationFailed());
+	rg.gen_matrix(W, real_t(1));
+	ASSERT_TRUE(W.clone_to(Wr));
+	A.zeros();
+	B.zeros();
+	real_t beta1t = real_t(1), beta2t = real_t(1);
+
+	GwT gw(lr);
+	gw.set_type(gt).numeric_stabilizer(eps);
+	ASSERT_TRUE(gw.gw_init_sparse(nn.___get_common_data(), W));
+	iM.preinit(GwT::apply_grad_sparse_needTempMem(embDim, n1));
+	ASSERT_TRUE(iM.init());
+
+	//dense reference, untouched columns have zero gradient
+	auto stepRef = [&](const vec_len_t*const pCols, const vec_len_t n) {
+		Gd.zeros();
+		for (vec_len_t i = 0; i < n; ++i) ::std::copy(G.colDataAsVec(i), G.colDataAsVec(i + 1), Gd.colDataAsVec(pCols[i]));
+		if (GwT::Adam == gt) {
+			iM.Adam(Gd, A, B, beta1t, beta2t, lr, gw.beta1(), gw.beta2(), eps);
+		} else iM.RMSProp_Hinton(Gd, A, lr, gw.beta1(), eps);
+		iM.evSub_ip(Wr, Gd);
+	};
+
+	//while the same columns are touched, the lazy update is exactly the dense one
+	for (int t = 0; t < 3; ++t) {
+		rg.gen_matrix(G, real_t(1));
+		ASSERT_TRUE(G.clone_to(Gc));
+		gw.apply_grad_sparse(W, Gc, S1);
+		stepRef(S1, n1);
+		ASSERT_REALMTX_NEAR(Wr, W, "Lazy optimizer differs from the dense one!", TestLayerEmbedding_EPS<real_t>::eps);
+	}
+
+	//columns that aren't touched keep their weights (and optimizer state), the touched ones must be the same as the dense version,
+	// because column 4 was touched on every step and column 7 was never touched before
+	ASSERT_TRUE(W.clone_to(Wprev));
+	realmtx_t G2(G.data(), embDim, n2);
+	rg.gen_matrix(G2, real_t(1));
+	ASSERT_TRUE(G2.clone_to(Gc));
+	gw.apply_grad_sparse(W, Gc, S2);
+	stepRef(S2, n2);
+	for (vec_len_t v = 0; v < vocabSize; ++v) {
+		const bool bTouched = ::std::find(S2, S2 + n2, v) != S2 + n2;
+		for (vec_len_t d = 0; d < embDim; ++d) {
+			if (bTouched) {
+				ASSERT_NEAR(Wr.get(d, v), W.get(d, v), TestLayerEmbedding_EPS<real_t>::eps) << "Wrong lazy update @ d=" << d << ", v=" << v;
+			} else ASSERT_EQ(Wprev.get(d, v), W.get(d, v)) << "Untouched column has been changed @ d=" << d << ", v=" << v;
+		}
+	}
+	gw.gw_deinit();
+}
+
+TEST(TestLayerEmbedding, LazyOptimizers) {
+	typedef LE<>::grad_works_t gw_t;
+	ASSERT_NO_FATAL_FAILURE(test_le_lazy_optimizer<gw_t>(gw_t::Adam));
+	ASSERT_NO_FATAL_FAILURE(test_le_lazy_optimizer<gw_t>(gw_t::RMSProp_Hinton));
+}
+
+//grad_works settings the sparse mode can't handle must fail the nnet initialization, not just trigger an assert
+TEST(TestLayerEmbedding, UnsupportedSettings) {
+	layer_input<> inp(1);
+	LE<> le(17, 16, 1, real_t(.01));
+	layer_output<activation::sigm_quad_loss<real_t>> outp(1, real_t(.01));
+	auto lp = make_layers(inp, le, outp);
+	auto nn = make_nnet(lp);
+
+	le.get_gradWorks().nesterov_momentum(real_t(.9));
+	ASSERT_EQ(decltype(nn)::ErrorCode::UnsupportedGradWorksSettings, nn.___init(10, 10, false));
+	le.get_gradWorks().nesterov_momentum(real_t(0)).max_norm(real_t(1));
+	ASSERT_EQ(decltype(nn)::ErrorCode::UnsupportedGradWorksSettings, nn.___init(10, 10, false));
+	le.get_gradWorks().max_norm(real_t(0));
+	ASSERT_EQ(decltype(nn)::ErrorCode::Success, nn.___init(10, 10, false));
+}
+
+//LE as a part of LPH must get only its own columns of the data and must work with the rest of the nnet
+TEST(TestLayerEmbedding, LayerPackHorizontal) {
+	constexpr vec_len_t samplesCount = 120, vocabSize = 31, unusedIds = 5;
+	constexpr neurons_count_t embDim = 4, idsCnt = 2, denseCnt = 16;
+	const real_t lr = real_t(.1);
+
+	layer_input<> inp(idsCnt + denseCnt);
+	LE<> le(vocabSize, embDim, idsCnt, lr);
+	LFC<activation::sigm<real_t>> fcl(7, lr);
+	auto lph = make_layer_pack_horizontal(make_PHL(le, 0, idsCnt), make_PHL(fcl, idsCnt, denseCnt));
+	layer_output<activation::sigm_quad_loss<real_t>> outp(1, lr);
+	auto lp = make_layers(inp, lph, outp);
+	auto nn = make_nnet(lp);
+	auto& rg = nn.get_iRng();
+
+	//dense columns are far out of the ids range, so a wrong split would be caught by the ids check of LE
+	realmtxdef_t trX(samplesCount, idsCnt + denseCnt, true), trY(samplesCount, 1, false), tX(2, idsCnt + denseCnt, true), tY(2, 1, false);
+	ASSERT_TRUE(!trX.isAllocationFailed() && !trY.isAllocationFailed() && !tX.isAllocationFailed() && !tY.isAllocationFailed());
+	for (auto pX : { &trX, &tX }) {
+		rg.gen_matrix_no_bias(*pX, real_t(100));
+		for (vec_len_t c = 0; c < idsCnt; ++c) {
+			for (vec_len_t r = 0; r < pX->rows(); ++r) pX->get(r, c) = real_t(rg(vocabSize - unusedIds));
+		}
+	}
+	rg.binary_matrix(trY);
+	rg.binary_matrix(tY);
+
+	ASSERT_EQ(decltype(nn)::ErrorCode::Success, nn.___init(samplesCount, samplesCount, false));
+	realmtx_t E0;
+	ASSERT_TRUE(le.get_weights().clone_to(E0));
+
+	nn.___get_common_data().set_mode_and_batch_size(true, samplesCount);
+	lp.on_batch_size_change(samplesCount);
+	lp.fprop(trX);
+	const auto& act = le.get_activations();
+	for (vec_len_t c = 0; c < idsCnt; ++c) {
+		for (vec_len_t r = 0; r < samplesCount; ++r) {
+			const auto id = static_cast<vec_len_t>(trX.get(r, c));
+			for (neurons_count_t d = 0; d < embDim; ++d) {
+				ASSERT_EQ(E0.get(d, id), act.get(r, c*embDim + d)) << "Wrong embedding @ r=" << r << ", c=" << c << ", d=" << d;
+			}
+		}
+	}
+	lp.bprop(trY);
+
+	const auto& E = le.get_weights();
+	for (vec_len_t v = 0; v < vocabSize; ++v) {
+		for (neurons_count_t d = 0; d < embDim; ++d) {
+			if (v >= vocabSize - unusedIds) {
+				ASSERT_EQ(E0.get(d, v), E.get(d, v)) << "Unused embedding has been changed @ d=" << d << ", v=" << v;
+			}
+		}
+	}
+	ASSERT_NE(E0, E);
+
+	//the whole training cycle
+	nn.deinit();
+	inmem_train_data<real_t> td;
+	ASSERT_TRUE(td.absorb(::std::move(trX), ::std::move(trY), ::std::move(tX), ::std::move(tY)));
+	nnet_train_opts<real_t, training_observer_silent<real_t>> opts(3);
+	opts.batchSize(40);
+	ASSERT_EQ(decltype(nn)::ErrorCode::Success, nn.train(td, opts)) << nn.get_last_error_string();
+	for (vec_len_t v = vocabSize - unusedIds; v < vocabSize; ++v) {
+		for (neurons_count_t d = 0; d < embDim; ++d) {
+			ASSERT_EQ(E0.get(d, v), le.get_weights().get(d, v)) << "Unused embedding has been changed @ d=" << d << ", v=" << v;
+		}
+	}
+}
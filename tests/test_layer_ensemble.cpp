@@ -0,0 +1,179 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "stdafx.h"
+
+//to get rid of '... decorated name length exceeded, name was truncated'
+#pragma warning( disable : 4503 )
+
+#include "../nntl/nntl.h"
+#include "../nntl/_supp/io/binfile.h"
+#include "asserts.h"
+#include "common_routines.h"
+
+using namespace nntl;
+typedef nntl_supp::binfile reader_t;
+
+typedef d_interfaces::real_t real_t;
+typedef math::smatrix<real_t> realmtx_t;
+typedef math::smatrix_deform<real_t> realmtxdef_t;
+
+//checks member-wise iMath functions against the usual versions applied to each member separately
+TEST(TestLayerEnsemble, MemberwiseGemm) {
+	constexpr vec_len_t K = 3, bs = 17, p = 5, n = 4;
+	d_interfaces::iMath_t iM;
+	d_interfaces::iRng_t iR;
+	iR.init_ithreads(iM.ithreads());
+
+	realmtx_t prevAct(bs, K*p, true), act(bs, K*n, true), dLdZ(bs, K*n), dLdAPrev(bs, K*p), dLdW(K*n, p + 1);
+	realmtxdef_t W(K*n, p + 1);
+	realmtx_t prevAct_k(bs, p, true), act_k(bs, n, true), dLdZ_k(bs, n), dLdAPrev_k(bs, p), dLdW_k(n, p + 1);
+	realmtxdef_t W_k(n, p + 1);
+	ASSERT_TRUE(!prevAct.isAllocationFailed() && !act.isAllocationFailed() && !dLdZ.isAllocationFailed()
+		&& !dLdAPrev.isAllocationFailed() && !dLdW.isAllocationFailed() && !W.isAllocationFailed()
+		&& !prevAct_k.isAllocationFailed() && !act_k.isAllocationFailed() && !dLdZ_k.isAllocationFailed()
+		&& !dLdAPrev_k.isAllocationFailed() && !dLdW_k.isAllocationFailed() && !W_k.isAllocationFailed());
+
+	iR.gen_matrixAny(prevAct, real_t(2));
+	iR.gen_matrixAny(W, real_t(1));
+	iR.gen_matrixAny(dLdZ, real_t(1));
+	const real_t sc = real_t(1) / bs;
+
+	iM.mMul_prevAct_weights_2_act_mw(K, prevAct, W, act);
+	iM.mMul_dLdZ_weights_2_dLdAPrev_mw(K, dLdZ, W, dLdAPrev);
+	iM.mMulScaled_dLdZ_prevAct_2_dLdW_mw(K, sc, dLdZ, prevAct, dLdW);
+
+	constexpr real_t eps = real_t(1e-5);
+	for (vec_len_t k = 0; k < K; ++k) {
+		for (vec_len_t c = 0; c < p; ++c) {
+			::std::copy(prevAct.colDataAsVec(k*p + c), prevAct.colDataAsVec(k*p + c + 1), prevAct_k.colDataAsVec(c));
+		}
+		for (vec_len_t c = 0; c < n; ++c) {
+			::std::copy(dLdZ.colDataAsVec(k*n + c), dLdZ.colDataAsVec(k*n + c + 1), dLdZ_k.colDataAsVec(c));
+		}
+		for (vec_len_t c = 0; c <= p; ++c) {
+			::std::copy(W.colDataAsVec(c) + k*n, W.colDataAsVec(c) + (k + 1)*n, W_k.colDataAsVec(c));
+		}
+
+		iM.mMul_prevAct_weights_2_act(prevAct_k, W_k, act_k);
+		iM.mMul_dLdZ_weights_2_dLdAPrev(dLdZ_k, W_k, dLdAPrev_k);
+		iM.mMulScaled_dLdZ_prevAct_2_dLdW(sc, dLdZ_k, prevAct_k, dLdW_k);
+
+		for (vec_len_t r = 0; r < bs; ++r) {
+			for (vec_len_t c = 0; c < n; ++c) ASSERT_NEAR(act_k.get(r, c), act.get(r, k*n + c), eps) << "act, member " << k;
+			for (vec_len_t c = 0; c < p; ++c) ASSERT_NEAR(dLdAPrev_k.get(r, c), dLdAPrev.get(r, k*p + c), eps) << "dLdAPrev, member " << k;
+		}
+		for (vec_len_t r = 0; r < n; ++r) {
+			for (vec_len_t c = 0; c <= p; ++c) ASSERT_NEAR(dLdW_k.get(r, c), dLdW.get(k*n + r, c), eps) << "dLdW, member " << k;
+		}
+	}
+}
+
+TEST(TestLayerEnsemble, GradCheck) {
+#pragma warning(disable:4459)
+	typedef double real_t;
+#pragma warning(default:4459)
+	struct myInterfaces_t : public d_int_nI<real_t> {
+		typedef inspector::GradCheck<real_t> iInspect_t;
+	};
+	typedef grad_works<myInterfaces_t> myGW;
+	constexpr vec_len_t K = 3;
+
+	inmem_train_data<real_t> td;
+	readTd(td, MNIST_FILE_DEBUG);
+
+	layer_input<myInterfaces_t> inp(td.train_x().cols_no_bias());
+	LFCE<activation::softsign<real_t>, myGW> fcl1(K, 11, real_t(.001), false, "fcl1");
+	LFCE<activation::softsign<real_t>, myGW> fcl2(K, 7, real_t(.001), true, "fcl2");
+	layer_output_ensemble<activation::sigm_xentropy_loss<real_t>, myGW> outp(K, td.train_y().cols(), real_t(.001), true);
+	auto lp = make_layers(inp, fcl1, fcl2, outp);
+	auto nn = make_nnet(lp);
+
+	gradcheck_settings<real_t> ngcSetts;
+	ngcSetts.evalSetts.dLdW_setts.relErrFailThrsh = real_t(1e-2);//numeric errors may stacks up significantly
+	ASSERT_TRUE(nn.gradcheck(td.train_x(), td.train_y(), 5, ngcSetts));
+}
+
+TEST(TestLayerEnsemble, MemberwiseInputCheck) {
+	constexpr vec_len_t K = 3;
+	inmem_train_data<real_t> td;
+	readTd(td, MNIST_FILE_DEBUG);
+	ASSERT_NE(0, td.train_x().cols_no_bias() % K);
+
+	layer_input<> inp(td.train_x().cols_no_bias());
+	LFCE<activation::sigm<real_t>> fcl(K, 10, real_t(.1), true);
+	layer_output_ensemble<activation::sigm_xentropy_loss<real_t>> outp(K, td.train_y().cols(), real_t(.1), true);
+	auto lp = make_layers(inp, fcl, outp);
+
+	nnet_train_opts<real_t, training_observer_silent<real_t>> opts(1);
+	opts.batchSize(100);
+	auto nn = make_nnet(lp);
+	ASSERT_EQ(decltype(nn)::ErrorCode::InvalidEnsembleIncomingNeuronsCount, nn.train(td, opts));
+}
+
+TEST(TestLayerEnsemble, TrainAndEvaluate) {
+	constexpr vec_len_t K = 4;
+	inmem_train_data<real_t> td;
+	reader_t reader;
+
+	const auto srcFile = MNIST_FILE_DEBUG;
+	STDCOUTL("Reading datafile '" << srcFile << "'...");
+	reader_t::ErrorCode rec = reader.read(srcFile, td);
+	ASSERT_EQ(reader_t::ErrorCode::Success, rec) << "Error code description: " << reader.get_last_error_str();
+
+	layer_input<> inp(td.train_x().cols_no_bias());
+	LFCE<activation::sigm<real_t>> fcl(K, 30, real_t(.1));
+	layer_output_ensemble<activation::sigm_xentropy_loss<real_t>> outp(K, td.train_y().cols(), real_t(.1), true);
+	auto lp = make_layers(inp, fcl, outp);
+
+	ASSERT_EQ(K * 30, fcl.get_neurons_cnt());
+	ASSERT_EQ(td.train_y().cols(), outp.get_data_y_width());
+
+	typedef eval_ensemble<eval_classification_one_hot_cached<real_t>> evaluator_t;
+	nnet_train_opts<real_t, training_observer_stdcout<real_t, evaluator_t>> opts(5);
+	opts.batchSize(100);
+	auto& ev = opts.observer().m_evaluator;
+	ev.members_count(K);
+
+	auto nn = make_nnet(lp);
+	auto ec = nn.train(td, opts);
+	ASSERT_EQ(decltype(nn)::ErrorCode::Success, ec) << "Error code description: " << nn.get_last_error_string();
+
+	//members are initialized differently, so their weights must differ
+	const auto& W = fcl.get_weights();
+	ASSERT_NE(W.get(0, 0), W.get(30, 0));
+
+	//the last dataset evaluated is the test set
+	for (vec_len_t k = 0; k < K; ++k) {
+		STDCOUTL("member #" << k << " correctly classified " << ev.member_correctly_classified(k) << " test samples");
+		ASSERT_GT(ev.member_correctly_classified(k), 0);
+	}
+}
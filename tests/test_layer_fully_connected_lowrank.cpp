@@ -0,0 +1,185 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "stdafx.h"
+
+//to get rid of '... decorated name length exceeded, name was truncated'
+#pragma warning( disable : 4503 )
+
+#include "../nntl/math.h"
+#include "../nntl/nntl.h"
+#include "asserts.h"
+#include "common_routines.h"
+#include "nn_base_arch.h"
+
+using namespace nntl;
+
+typedef d_interfaces::real_t real_t;
+typedef math::smatrix<real_t> realmtx_t;
+
+template<typename base_t> struct TestLayerFCLR_EPS {};
+template<> struct TestLayerFCLR_EPS <double> { static constexpr double eps = 1e-9; };
+template<> struct TestLayerFCLR_EPS <float> { static constexpr float eps = 1e-4f; };
+
+//LFCLR of the full rank initialized with set_weights_factorized() must produce the same activations as the LFC with
+// the original weights. dL/dAPrev = dL/dZ*U*V must also be the same, so the lower layer must get the same update
+TEST(TestLayerFCLR, ComparativeFullRank) {
+	constexpr vec_len_t samplesCount = 83;
+	constexpr neurons_count_t incCnt = 16, lowerCnt = 17, neurCnt = 15, rank = neurCnt;
+	const real_t lr = real_t(.5);
+
+	realmtx_t _train_x(samplesCount, incCnt, true), _train_y(samplesCount, 1, false);
+	ASSERT_TRUE(!_train_x.isAllocationFailed() && !_train_y.isAllocationFailed());
+
+	typedef activation::sigm<real_t> Act_t;
+	typedef layer_output<activation::sigm_quad_loss<real_t>> LO;
+
+	//////////////////////////////////////////////////////////////////////////
+	layer_input<> Ainp(incCnt);
+	LFC<Act_t> Alow(lowerCnt, lr);
+	LFC<Act_t> Afc(neurCnt, lr);
+	LO Aoutp(_train_y.cols(), lr);
+
+	auto Alp = make_layers(Ainp, Alow, Afc, Aoutp);
+	auto Ann = make_nnet(Alp);
+
+	auto& rg = Ann.get_iRng();
+	rg.gen_matrix_no_bias(_train_x, real_t(5));
+	rg.gen_matrix_norm(_train_y);
+
+	auto ec = Ann.___init(samplesCount, samplesCount, false);
+	ASSERT_EQ(decltype(Ann)::ErrorCode::Success, ec);
+
+	realmtx_t AlowW, AfcW, AoutpW, AfcAct;
+	ASSERT_TRUE(Alow.get_weights().clone_to(AlowW));
+	ASSERT_TRUE(Afc.get_weights().clone_to(AfcW));
+	ASSERT_TRUE(Aoutp.get_weights().clone_to(AoutpW));
+
+	Ann.___get_common_data().set_mode_and_batch_size(true, samplesCount);
+	Alp.on_batch_size_change(samplesCount);
+	Alp.fprop(_train_x);
+	ASSERT_TRUE(Afc.get_activations().clone_to(AfcAct));
+	Alp.bprop(_train_y);
+
+	//////////////////////////////////////////////////////////////////////////
+	layer_input<> Binp(incCnt);
+	LFC<Act_t> Blow(lowerCnt, lr);
+	LFCLR<Act_t> Bfc(neurCnt, rank, lr);
+	LO Boutp(_train_y.cols(), lr);
+
+	auto Blp = make_layers(Binp, Blow, Bfc, Boutp);
+	auto Bnn = make_nnet(Blp);
+
+	ASSERT_TRUE(Blow.set_weights(::std::move(AlowW)));
+	Bnn.get_iMath().preinit(Bfc.set_weights_factorized_needTempMem());
+	ASSERT_TRUE(Bnn.get_iMath().init());
+	ASSERT_TRUE(Bfc.set_weights_factorized(AfcW, Bnn.get_iMath()));
+	ASSERT_TRUE(Boutp.set_weights(::std::move(AoutpW)));
+
+	ec = Bnn.___init(samplesCount, samplesCount, false);
+	ASSERT_EQ(decltype(Bnn)::ErrorCode::Success, ec);
+
+	Bnn.___get_common_data().set_mode_and_batch_size(true, samplesCount);
+	Blp.on_batch_size_change(samplesCount);
+	Blp.fprop(_train_x);
+
+	ASSERT_REALMTX_NEAR(AfcAct, static_cast<const realmtx_t&>(Bfc.get_activations()),
+		"Post-fprop activations comparison failed!", TestLayerFCLR_EPS<real_t>::eps);
+	Blp.bprop(_train_y);
+
+	ASSERT_REALMTX_NEAR(Aoutp.get_weights(), Boutp.get_weights(),
+		"Output layer post-bprop weights comparison failed!", TestLayerFCLR_EPS<real_t>::eps);
+	ASSERT_REALMTX_NEAR(Alow.get_weights(), Blow.get_weights(),
+		"Lower layer post-bprop weights comparison failed!", TestLayerFCLR_EPS<real_t>::eps);
+}
+
+//the default initialization draws U and V directly. U*V must get the second moment of weights that the activation's scheme
+// (Martens_SI_sigm<15> for sigm: 15 unit gaussians per row) gives to the LFC, and the bottleneck biases must be zeros
+TEST(TestLayerFCLR, DirectInit) {
+	constexpr vec_len_t samplesCount = 10;
+	constexpr neurons_count_t incCnt = 100, neurCnt = 60, rank = 5;
+
+	layer_input<> inp(incCnt);
+	LFCLR<activation::sigm<real_t>> fc(neurCnt, rank);
+	layer_output<activation::sigm_quad_loss<real_t>> outp(1);
+
+	auto lp = make_layers(inp, fc, outp);
+	auto nn = make_nnet(lp);
+	auto ec = nn.___init(samplesCount, samplesCount, false);
+	ASSERT_EQ(decltype(nn)::ErrorCode::Success, ec);
+
+	const auto& U = fc.get_U();
+	const auto& V = fc.get_V();
+	for (neurons_count_t k = 0; k < rank; ++k) ASSERT_EQ(real_t(0), V.get(k, incCnt));
+	for (neurons_count_t i = 0; i < neurCnt; ++i) ASSERT_EQ(real_t(0), U.get(i, rank));
+
+	double sqSum = 0;
+	for (neurons_count_t i = 0; i < neurCnt; ++i) {
+		for (neurons_count_t j = 0; j < incCnt; ++j) {
+			double w = 0;
+			for (neurons_count_t k = 0; k < rank; ++k) w += static_cast<double>(U.get(i, k))*V.get(k, j);
+			sqSum += w*w;
+		}
+	}
+	const double m2 = sqSum / (static_cast<double>(neurCnt)*incCnt), expectedM2 = 15. / incCnt;
+	EXPECT_NEAR(expectedM2, m2, expectedM2*.4);
+}
+
+template<typename ArchPrmsT>
+struct GC_LFCLR : public nntl_tests::NN_base_arch_td<ArchPrmsT> {
+	LFCLR<myActivation, myGradWorks> lFinal;
+
+	~GC_LFCLR()noexcept {}
+	GC_LFCLR(const ArchPrms_t& Prms)noexcept : lFinal(50, 10, Prms.learningRate, "lFinal") {}
+};
+//both weights blocks (U and V) are checked as separate matrices, the directional pre-check covers every weight of both
+TEST(TestLayerFCLR, GradCheck) {
+#pragma warning(disable:4459)
+	typedef double real_t;
+	typedef nntl_tests::NN_base_params<real_t, nntl::inspector::GradCheck<real_t>> ArchPrms_t;
+#pragma warning(default:4459)
+
+	nntl::inmem_train_data<real_t> td;
+	readTd(td);
+
+	ArchPrms_t Prms(td);
+	Prms.lUnderlay_nc = 100;
+	nntl_tests::NN_arch<GC_LFCLR<ArchPrms_t>> nnArch(Prms);
+
+	auto ec = nnArch.warmup(td, 5, 100);
+	ASSERT_EQ(decltype(nnArch)::ErrorCode_t::Success, ec) << "Reason: " << nnArch.NN.get_error_str(ec);
+
+	gradcheck_settings<real_t> ngcSetts;
+	ngcSetts.evalSetts.bIgnoreZerodLdWInUndelyingLayer = true;
+	ngcSetts.evalSetts.dLdW_setts.relErrFailThrsh = real_t(5e-3);//numeric errors stacks up through two products
+	ngcSetts.directionalCnt = 3;
+	ASSERT_TRUE(nnArch.NN.gradcheck(td.train_x(), td.train_y(), 5, ngcSetts));
+}
@@ -0,0 +1,209 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "stdafx.h"
+
+//to get rid of '... decorated name length exceeded, name was truncated'
+#pragma warning( disable : 4503 )
+
+#include "../nntl/math.h"
+#include "../nntl/nntl.h"
+#include "asserts.h"
+#include "common_routines.h"
+#include "nn_base_arch.h"
+
+using namespace nntl;
+
+typedef d_interfaces::real_t real_t;
+typedef math::smatrix<real_t> realmtx_t;
+typedef math::smatrix_deform<real_t> realmtxdef_t;
+
+template<typename base_t> struct TestLayerFCP_EPS {};
+template<> struct TestLayerFCP_EPS <double> { static constexpr double eps = 1e-10; };
+template<> struct TestLayerFCP_EPS <float> { static constexpr float eps = 1e-4f; };
+
+//LFCP working in the sparse mode must give the same results as LFC with the same (pruned) weights, except that the pruned
+// weights must stay zero after the update
+TEST(TestLayerFCP, ComparativeSparse) {
+	constexpr vec_len_t samplesCount = 91;
+	constexpr neurons_count_t incCnt = 17, lowerCnt = 40, neurCnt = 16;
+	const real_t lr = real_t(.5), sparsity = real_t(.8);
+
+	realmtx_t _train_x(samplesCount, incCnt, true), _train_y(samplesCount, 1, false);
+	ASSERT_TRUE(!_train_x.isAllocationFailed() && !_train_y.isAllocationFailed());
+
+	typedef activation::sigm<real_t> Act_t;
+	typedef layer_output<activation::sigm_quad_loss<real_t>> LO;
+
+	//////////////////////////////////////////////////////////////////////////
+	layer_input<> Binp(incCnt);
+	LFC<Act_t> Blow(lowerCnt, lr);
+	LFCP<Act_t> Bfc(neurCnt, lr);
+	LO Boutp(_train_y.cols(), lr);
+
+	auto Blp = make_layers(Binp, Blow, Bfc, Boutp);
+	auto Bnn = make_nnet(Blp);
+
+	auto& rg = Bnn.get_iRng();
+	rg.gen_matrix_no_bias(_train_x, real_t(5));
+	rg.gen_matrix_norm(_train_y);
+
+	auto ec = Bnn.___init(samplesCount, samplesCount, false);
+	ASSERT_EQ(decltype(Bnn)::ErrorCode::Success, ec);
+	ASSERT_FALSE(Bfc.is_sparse());
+
+	ASSERT_TRUE(Bfc.prune_weights(sparsity));
+	ASSERT_TRUE(Bfc.is_sparse());
+	ASSERT_NEAR(real_t(static_cast<vec_len_t>(sparsity*lowerCnt)) / real_t(lowerCnt), Bfc.sparsity(), real_t(1e-6));
+
+	realmtx_t mask;
+	ASSERT_TRUE(Bfc.get_prune_mask().clone_to(mask));
+
+	//////////////////////////////////////////////////////////////////////////
+	//the reference nnet gets the same (pruned) weights
+	layer_input<> Ainp(incCnt);
+	LFC<Act_t> Alow(lowerCnt, lr);
+	LFC<Act_t> Afc(neurCnt, lr);
+	LO Aoutp(_train_y.cols(), lr);
+
+	auto Alp = make_layers(Ainp, Alow, Afc, Aoutp);
+	auto Ann = make_nnet(Alp);
+
+	ASSERT_TRUE(Alow.set_weights(Blow.get_weights()));
+	ASSERT_TRUE(Afc.set_weights(Bfc.get_weights()));
+	ASSERT_TRUE(Aoutp.set_weights(Boutp.get_weights()));
+
+	ec = Ann.___init(samplesCount, samplesCount, false);
+	ASSERT_EQ(decltype(Ann)::ErrorCode::Success, ec);
+
+	Ann.___get_common_data().set_mode_and_batch_size(true, samplesCount);
+	Alp.on_batch_size_change(samplesCount);
+	Alp.fprop(_train_x);
+	Bnn.___get_common_data().set_mode_and_batch_size(true, samplesCount);
+	Blp.on_batch_size_change(samplesCount);
+	Blp.fprop(_train_x);
+
+	ASSERT_REALMTX_NEAR(Afc.get_activations(), Bfc.get_activations(),
+		"Post-fprop activations comparison failed!", TestLayerFCP_EPS<real_t>::eps);
+
+	Alp.bprop(_train_y);
+	Blp.bprop(_train_y);
+
+	ASSERT_REALMTX_NEAR(Aoutp.get_weights(), Boutp.get_weights(),
+		"Output layer post-bprop weights comparison failed!", TestLayerFCP_EPS<real_t>::eps);
+	ASSERT_REALMTX_NEAR(Alow.get_weights(), Blow.get_weights(),
+		"Lower layer post-bprop weights comparison failed!", TestLayerFCP_EPS<real_t>::eps);
+
+	realmtx_t AfcWm;
+	ASSERT_TRUE(Afc.get_weights().clone_to(AfcWm));
+	for (vec_len_t c = 0; c < AfcWm.cols(); ++c) {
+		for (vec_len_t r = 0; r < AfcWm.rows(); ++r) AfcWm.get(r, c) *= mask.get(r, c);
+	}
+	ASSERT_REALMTX_NEAR(AfcWm, Bfc.get_weights(), "Pruned layer post-bprop weights comparison failed!", TestLayerFCP_EPS<real_t>::eps);
+
+	//the compressed copy must follow the updated weights, inference fprop() included
+	Bnn.___get_common_data().set_mode_and_batch_size(false, samplesCount);
+	Blp.on_batch_size_change(samplesCount);
+	Blp.fprop(_train_x);
+	const auto& spW = Bfc.get_sparse_weights();
+	const auto& Bw = Bfc.get_weights();
+	for (vec_len_t r = 0; r < spW.rows(); ++r) {
+		for (auto k = spW.rowPtr()[r]; k < spW.rowPtr()[r + 1]; ++k) {
+			ASSERT_EQ(Bw.get(r, spW.colIdx()[k]), spW.vals()[k]);
+		}
+	}
+
+	//the mask isn't derived from the weights: zero weights of a dense layer aren't pruned...
+	layer_input<> Cinp(lowerCnt);
+	LFCP<Act_t> Cfc(neurCnt, lr);
+	LO Coutp(_train_y.cols(), lr);
+	auto Clp = make_layers(Cinp, Cfc, Coutp);
+	ASSERT_TRUE(Cfc.set_weights(Bfc.get_weights()));
+	ASSERT_FALSE(Cfc.is_sparse());
+	ASSERT_TRUE(Cfc.get_prune_mask().empty());
+
+	//...the mask must be passed explicitly
+	ASSERT_TRUE(Cfc.set_weights(Bfc.get_weights(), mask));
+	ASSERT_TRUE(Cfc.is_sparse());
+	ASSERT_MTX_EQ(mask, Cfc.get_prune_mask(), "Mask wasn't set");
+
+	//and set_weights() without a mask keeps the current one
+	realmtx_t W;
+	ASSERT_TRUE(Bfc.get_weights().clone_to(W));
+	W.ones();
+	ASSERT_TRUE(Cfc.set_weights(W));
+	ASSERT_TRUE(Cfc.is_sparse());
+	ASSERT_MTX_EQ(mask, Cfc.get_prune_mask(), "Mask wasn't kept");
+	ASSERT_MTX_EQ(mask, Cfc.get_weights(), "Weights weren't masked");
+}
+
+template<typename ArchPrmsT>
+struct GC_LFCP : public nntl_tests::NN_base_arch_td<ArchPrmsT> {
+	LFCP<myActivation, myGradWorks> lFinal;
+
+	~GC_LFCP()noexcept {}
+	GC_LFCP(const ArchPrms_t& Prms)noexcept : lFinal(50, Prms.learningRate, "lFinal") {}
+};
+
+//pruned weights are constants, so the check must skip them, and the sparse mode must see the weights perturbed by the check
+void test_lfcp_gradcheck(const bool bSparse) {
+#pragma warning(disable:4459)
+	typedef double real_t;
+	typedef nntl_tests::NN_base_params<real_t, nntl::inspector::GradCheck<real_t>> ArchPrms_t;
+#pragma warning(default:4459)
+
+	nntl::inmem_train_data<real_t> td;
+	readTd(td);
+
+	ArchPrms_t Prms(td);
+	nntl_tests::NN_arch<GC_LFCP<ArchPrms_t>> nnArch(Prms);
+
+	auto ec = nnArch.warmup(td, 5, 100);
+	ASSERT_EQ(decltype(nnArch)::ErrorCode_t::Success, ec) << "Reason: " << nnArch.NN.get_error_str(ec);
+
+	auto& lfcp = nnArch.ArchObj.lFinal;
+	//the threshold above the sparsity leaves the layer in the dense (masked) mode
+	lfcp.sparse_threshold(bSparse ? real_t(.7) : real_t(1));
+	ASSERT_TRUE(lfcp.prune_weights(real_t(.8)));
+	ASSERT_EQ(bSparse, lfcp.is_sparse());
+
+	gradcheck_settings<real_t> ngcSetts;
+	ngcSetts.evalSetts.bIgnoreZerodLdWInUndelyingLayer = true;
+	ngcSetts.directionalCnt = 3;
+	ASSERT_TRUE(nnArch.NN.gradcheck(td.train_x(), td.train_y(), 5, ngcSetts));
+}
+
+TEST(TestLayerFCP, GradCheckSparse) {
+	test_lfcp_gradcheck(true);
+}
+TEST(TestLayerFCP, GradCheckMasked) {
+	test_lfcp_gradcheck(false);
+}
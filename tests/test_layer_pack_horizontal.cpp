@@ -471,6 +471,122 @@ TEST(TestLayerPackHorizontal, GradCheck_overlapping) {
 	ngcSetts.evalSetts.bIgnoreZerodLdWInUndelyingLayer = true;
 	ASSERT_TRUE(nnArch.NN.gradcheck(td.train_x(), td.train_y(), 10, ngcSetts));
 }
+
+//LPH with an identity layer inside. LI has a trivial bprop, so LPH passes it a view into dLdA instead of copying
+template<typename ArchPrmsT>
+struct GC_LPH_LI : public nntl_tests::NN_base_arch_td<ArchPrmsT> {
+	myLFC l1;
+	LI<myInterfaces_t> l2;
+	LPH<PHL<decltype(l1)>, PHL<decltype(l2)>> lFinal;
+
+	~GC_LPH_LI()noexcept {}
+	GC_LPH_LI(const ArchPrms_t& Prms)noexcept
+		: l1(50, Prms.learningRate, "l1")
+		, l2("l2")
+		, lFinal("lFinal"
+			, make_PHL(l1, 0, Prms.lUnderlay_nc)
+			, make_PHL(l2, Prms.lUnderlay_nc / 2, Prms.lUnderlay_nc - (Prms.lUnderlay_nc / 2))
+		)
+	{}
+};
+TEST(TestLayerPackHorizontal, GradCheck_identity) {
+#pragma warning(disable:4459)
+	typedef double real_t;
+	typedef nntl_tests::NN_base_params<real_t, nntl::inspector::GradCheck<real_t>> ArchPrms_t;
+#pragma warning(default:4459)
+
+	nntl::inmem_train_data<real_t> td;
+	readTd(td);
+
+	ArchPrms_t Prms(td);
+	nntl_tests::NN_arch<GC_LPH_LI<ArchPrms_t>> nnArch(Prms);
+
+	auto ec = nnArch.warmup(td, 5, 200);
+	ASSERT_EQ(decltype(nnArch)::ErrorCode_t::Success, ec) << "Reason: " << nnArch.NN.get_error_str(ec);
+
+	//inner layers of LPH must never alias activations, the pack output has to be contiguous
+	ASSERT_FALSE(nnArch.ArchObj.l2.is_aliasing_activations());
+
+	gradcheck_settings<real_t> ngcSetts;
+	ngcSetts.evalSetts.dLdW_setts.relErrFailThrsh = real_t(5e-3);
+	ngcSetts.evalSetts.bIgnoreZerodLdWInUndelyingLayer = true;
+	ASSERT_TRUE(nnArch.NN.gradcheck(td.train_x(), td.train_y(), 10, ngcSetts));
+}
+
+//standalone LI aliases activations of the lower layer when asked to
+template<typename ArchPrmsT>
+struct GC_LI_alias : public nntl_tests::NN_base_arch_td<ArchPrmsT> {
+	LI<myInterfaces_t> lFinal;
+
+	~GC_LI_alias()noexcept {}
+	GC_LI_alias(const ArchPrms_t& )noexcept : lFinal("lFinal") {
+		lFinal.alias_activations(true);
+	}
+};
+TEST(TestLayerPackHorizontal, GradCheck_identityAliased) {
+#pragma warning(disable:4459)
+	typedef double real_t;
+	typedef nntl_tests::NN_base_params<real_t, nntl::inspector::GradCheck<real_t>> ArchPrms_t;
+#pragma warning(default:4459)
+
+	nntl::inmem_train_data<real_t> td;
+	readTd(td);
+
+	ArchPrms_t Prms(td);
+	nntl_tests::NN_arch<GC_LI_alias<ArchPrms_t>> nnArch(Prms);
+
+	auto ec = nnArch.warmup(td, 5, 200);
+	ASSERT_EQ(decltype(nnArch)::ErrorCode_t::Success, ec) << "Reason: " << nnArch.NN.get_error_str(ec);
+
+	ASSERT_TRUE(nnArch.ArchObj.lFinal.is_aliasing_activations());
+	ASSERT_EQ(nnArch.lUnderlay.get_activations_storage()->data(), nnArch.ArchObj.lFinal.get_activations_storage()->data());
+
+	gradcheck_settings<real_t> ngcSetts;
+	ngcSetts.evalSetts.bIgnoreZerodLdWInUndelyingLayer = true;
+	ASSERT_TRUE(nnArch.NN.gradcheck(td.train_x(), td.train_y(), 10, ngcSetts));
+}
+
+//dropout modifies activations inplace, so LI under it must never alias the lower layer activations
+template<typename ArchPrmsT>
+struct LI_DO_noalias : public nntl_tests::NN_base_arch_td<ArchPrmsT> {
+	typedef typename ArchPrmsT::real_t real_t;
+
+	template<typename FpcT>
+	using _MyLI_tpl = _LI<FpcT, myInterfaces_t>;
+
+	LI<myInterfaces_t> l1;
+	LDO<_MyLI_tpl, Dropout<real_t>> lFinal;
+
+	~LI_DO_noalias()noexcept {}
+	LI_DO_noalias(const ArchPrms_t&)noexcept : l1("l1"), lFinal("lFinal") {
+		l1.alias_activations(true);
+		lFinal.alias_activations(true);
+		lFinal.dropoutPercentActive(real_t(.8));
+	}
+};
+TEST(TestLayerPackHorizontal, identityAliasingOptIn) {
+#pragma warning(disable:4459)
+	typedef double real_t;
+	typedef nntl_tests::NN_base_params<real_t, nntl::inspector::GradCheck<real_t>> ArchPrms_t;
+#pragma warning(default:4459)
+
+	nntl::inmem_train_data<real_t> td;
+	readTd(td);
+
+	ArchPrms_t Prms(td);
+	nntl_tests::NN_arch<LI_DO_noalias<ArchPrms_t>> nnArch(Prms);
+
+	auto ec = nnArch.warmup(td, 5, 200);
+	ASSERT_EQ(decltype(nnArch)::ErrorCode_t::Success, ec) << "Reason: " << nnArch.NN.get_error_str(ec);
+
+	ASSERT_TRUE(nnArch.ArchObj.l1.is_aliasing_activations());
+	ASSERT_FALSE(nnArch.ArchObj.lFinal.is_aliasing_activations());
+	ASSERT_NE(nnArch.ArchObj.l1.get_activations_storage()->data(), nnArch.ArchObj.lFinal.get_activations_storage()->data());
+
+	//aliasing is off by default
+	decltype(nnArch.ArchObj.l1) li("li");
+	ASSERT_FALSE(li.alias_activations());
+}
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 /*
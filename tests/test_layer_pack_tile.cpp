@@ -246,3 +246,88 @@ TEST(TestLayerPackTile, ComparativeNonSpecialX) {
 	//ASSERT_REALMTX_NEAR(Atlfc.get_weights(), Blfc1.get_weights(), "! must fail at the first element", TestLayerPackTile_EPS<real_t>::eps);
 
 }
+
+TEST(TestLayerPackTile, ComparativeInplace) {
+	constexpr vec_len_t samplesCount = 109;
+	realmtx_t _train_x(samplesCount, 31, true), _train_y(samplesCount, 1, false);
+
+	const vec_len_t batchSize = _train_x.rows();
+
+	constexpr neurons_count_t K = 3, tiledLayerNeurons = 37, tiledLayerIncomingNeurons = 43;
+	const real_t lr = 1 * K;
+
+	typedef LFC<activation::sigm<real_t, weights_init::XavierFour>> FCL;
+	typedef layer_output<activation::sigm_quad_loss<real_t, weights_init::XavierFour>> LO;
+
+	//////////////////////////////////////////////////////////////////////////
+	// inplace tiling
+	layer_input<> Ainp(_train_x.cols_no_bias());
+	FCL Aund(tiledLayerIncomingNeurons * K, lr);//underlying layer to test dLdAPrev correctness
+
+	FCL Atlfc(tiledLayerNeurons, lr);
+	LPT<decltype(Atlfc)> Alpt(Atlfc, K);
+	static_assert(decltype(Alpt)::bTileInplace, "LFC must be tiled inplace by default");
+
+	LO Aoutp(_train_y.cols(), lr);
+
+	auto Alp = make_layers(Ainp, Aund, Alpt, Aoutp);
+	auto Ann = make_nnet(Alp);
+
+	Ann.get_iRng().gen_matrix_no_bias_norm(_train_x);
+	Ann.get_iRng().gen_matrix_norm(_train_y);
+
+	auto ec = Ann.___init(batchSize, batchSize, false);
+	ASSERT_EQ(decltype(Ann)::ErrorCode::Success, ec);
+
+	realmtx_t AundW, AtlfcW, AoutpW, AlptAct, AoutpAct;
+	Aund.get_weights().clone_to(AundW);
+	Atlfc.get_weights().clone_to(AtlfcW);
+	Aoutp.get_weights().clone_to(AoutpW);
+
+	Ann.___get_common_data().set_mode_and_batch_size(true, batchSize);
+	Alp.on_batch_size_change(batchSize);
+	Alp.fprop(_train_x);
+
+	ASSERT_TRUE(Alpt.get_activations().clone_to(AlptAct));
+	ASSERT_TRUE(Aoutp.get_activations().clone_to(AoutpAct));
+
+	Alp.bprop(_train_y);
+
+	//////////////////////////////////////////////////////////////////////////
+	// the same architecture with data rolling
+	layer_input<> Binp(_train_x.cols_no_bias());
+	FCL Bund(tiledLayerIncomingNeurons * K, lr);
+
+	FCL Btlfc(tiledLayerNeurons, lr);
+	LPT<decltype(Btlfc), false> Blpt(Btlfc, K);
+	static_assert(!decltype(Blpt)::bTileInplace, "Inplace tiling must be disabled");
+
+	LO Boutp(_train_y.cols(), lr);
+
+	auto Blp = make_layers(Binp, Bund, Blpt, Boutp);
+	auto Bnn = make_nnet(Blp);
+
+	ec = Bnn.___init(batchSize, batchSize, false);
+	ASSERT_EQ(decltype(Bnn)::ErrorCode::Success, ec);
+
+	ASSERT_TRUE(Bund.set_weights(::std::move(AundW)));
+	ASSERT_TRUE(Btlfc.set_weights(::std::move(AtlfcW)));
+	ASSERT_TRUE(Boutp.set_weights(::std::move(AoutpW)));
+
+	Bnn.___get_common_data().set_mode_and_batch_size(true, batchSize);
+	Blp.on_batch_size_change(batchSize);
+	Blp.fprop(_train_x);
+
+	ASSERT_REALMTX_NEAR(AlptAct, static_cast<const realmtx_t&>(Blpt.get_activations()),
+		"Tiled layer post-fprop activations comparison failed!", TestLayerPackTile_EPS<real_t>::eps);
+	ASSERT_REALMTX_NEAR(AoutpAct, static_cast<const realmtx_t&>(Boutp.get_activations()),
+		"Output layer post-fprop activations comparison failed!", TestLayerPackTile_EPS<real_t>::eps);
+
+	Blp.bprop(_train_y);
+
+	//dL/dW is summed over the tiles in a different order, so allowing a bit bigger error here
+	ASSERT_REALMTX_NEAR(Atlfc.get_weights(), Btlfc.get_weights(),
+		"Tiled layer post-bprop weights comparison failed!", 10 * TestLayerPackTile_EPS<real_t>::eps);
+	ASSERT_REALMTX_NEAR(Aund.get_weights(), Bund.get_weights(),
+		"Underlying layer post-bprop weights comparison failed!", 10 * TestLayerPackTile_EPS<real_t>::eps);
+}
@@ -279,6 +279,79 @@ TEST(TestLPV, LayerPackVertical) {
 	ASSERT_NO_FATAL_FAILURE(test_LayerPackVertical4(td, ::std::time(0)));
 }
 
+//checkpointed LPV must do exactly the same as the ordinary one
+void test_LayerPackVerticalCheckpointing(inmem_train_data<real_t>& td, uint64_t rngSeed, const unsigned ckptEvery)noexcept {
+	SCOPED_TRACE("test_LayerPackVerticalCheckpointing");
+	STDCOUTL("checkpoint_every = " << ckptEvery);
+	size_t epochs = 3;
+	const real_t learningRate = real_t(.01), dpa = real_t(.8);
+
+	typedef LFC_DO<> testedLFC;
+
+	layer_input<> Ainp(td.train_x().cols_no_bias());
+	testedLFC Aifcl1(100, learningRate), Aifcl2(90, learningRate), Aifcl3(80, learningRate)
+		, Aifcl4(70, learningRate), Aifcl5(60, learningRate), Aifcl6(50, learningRate);
+	Aifcl2.dropoutPercentActive(dpa);
+	Aifcl4.dropoutPercentActive(dpa);
+	auto AlpVert = make_layer_pack_vertical(Aifcl1, Aifcl2, Aifcl3, Aifcl4, Aifcl5, Aifcl6);
+	layer_output<> Aoutp(td.train_y().cols(), learningRate);
+
+	auto Alp = make_layers(Ainp, AlpVert, Aoutp);
+
+	nnet_train_opts<real_t> Aopts(epochs);
+	Aopts.calcFullLossValue(true).batchSize(100).ImmediatelyDeinit(false);
+
+	auto Ann = make_nnet(Alp);
+	Ann.get_iRng().seed64(rngSeed);
+	auto ec = Ann.train(td, Aopts);
+	ASSERT_EQ(decltype(Ann)::ErrorCode::Success, ec) << "Error code description: " << Ann.get_last_error_string();
+
+	//we must deinit td to make sure it'll be in the same state after reseeding RNG for B as it was for A when it was initialized first
+	td.deinit4all();
+
+	layer_input<> Binp(td.train_x().cols_no_bias());
+	testedLFC Bifcl1(100, learningRate), Bifcl2(90, learningRate), Bifcl3(80, learningRate)
+		, Bifcl4(70, learningRate), Bifcl5(60, learningRate), Bifcl6(50, learningRate);
+	Bifcl2.dropoutPercentActive(dpa);
+	Bifcl4.dropoutPercentActive(dpa);
+	auto BlpVert = make_layer_pack_vertical(Bifcl1, Bifcl2, Bifcl3, Bifcl4, Bifcl5, Bifcl6);
+	BlpVert.checkpoint_every(ckptEvery);
+	ASSERT_TRUE(BlpVert.is_checkpointing());
+	layer_output<> Boutp(td.train_y().cols(), learningRate);
+
+	auto Blp = make_layers(Binp, BlpVert, Boutp);
+
+	nnet_train_opts<real_t> Bopts(epochs);
+	Bopts.calcFullLossValue(true).batchSize(100).ImmediatelyDeinit(false);
+
+	auto Bnn = make_nnet(Blp);
+	Bnn.get_iRng().seed64(rngSeed);
+	auto Bec = Bnn.train(td, Bopts);
+	ASSERT_EQ(decltype(Bnn)::ErrorCode::Success, Bec) << "Error code description: " << Bnn.get_last_error_string();
+
+	ASSERT_MTX_EQ(Aifcl1.get_weights(), Bifcl1.get_weights(), "First layer weights differ");
+	ASSERT_MTX_EQ(Aifcl2.get_weights(), Bifcl2.get_weights(), "Second layer weights differ");
+	ASSERT_MTX_EQ(Aifcl3.get_weights(), Bifcl3.get_weights(), "Third layer weights differ");
+	ASSERT_MTX_EQ(Aifcl4.get_weights(), Bifcl4.get_weights(), "Fourth layer weights differ");
+	ASSERT_MTX_EQ(Aifcl5.get_weights(), Bifcl5.get_weights(), "Fifth layer weights differ");
+	ASSERT_MTX_EQ(Aifcl6.get_weights(), Bifcl6.get_weights(), "Sixth layer weights differ");
+	ASSERT_MTX_EQ(Aoutp.get_weights(), Boutp.get_weights(), "Output layer weights differ");
+}
+
+TEST(TestLPV, Checkpointing) {
+	inmem_train_data<real_t> td;
+	reader_t reader;
+
+	STDCOUTL("Reading datafile '" << MNIST_FILE << "'...");
+	reader_t::ErrorCode rec = reader.read(NNTL_STRING(MNIST_FILE), td);
+	ASSERT_EQ(reader_t::ErrorCode::Success, rec) << "Error code description: " << reader.get_last_error_str();
+
+	for (unsigned k = 2; k <= 4; ++k) {
+		ASSERT_NO_FATAL_FAILURE(test_LayerPackVerticalCheckpointing(td, ::std::time(0), k));
+		td.deinit4all();
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 
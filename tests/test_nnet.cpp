@@ -350,5 +350,402 @@ TEST(TestNnet, GradCheck_dropout) {
 	ASSERT_TRUE(nnArch.NN.gradcheck(td.train_x(), td.train_y(), 5, ngcSetts));
 }
 
+template<typename ArchPrmsT>
+struct GC_PARALLEL : public nntl_tests::NN_base_arch_td<ArchPrmsT> {
+	myLFC lFinal;
+
+	~GC_PARALLEL()noexcept {}
+	GC_PARALLEL(const ArchPrms_t& Prms)noexcept : lFinal(70, Prms.learningRate, "lFinal") {}
+};
+TEST(TestNnet, GradCheck_parallelAndDirectional) {
+#pragma warning(disable:4459)
+	typedef double real_t;
+	typedef nntl_tests::NN_base_params<real_t, nntl::inspector::GradCheck<real_t>> ArchPrms_t;
+#pragma warning(default:4459)
+
+	nntl::inmem_train_data<real_t> td;
+	readTd(td);
+
+	ArchPrms_t Prms(td);
+	//replicas get their weights from nnArch.NN during the check
+	nntl_tests::NN_arch<GC_PARALLEL<ArchPrms_t>> nnArch(Prms), nnRepl1(Prms), nnRepl2(Prms);
+
+	auto ec = nnArch.warmup(td, 3, 200);
+	ASSERT_EQ(decltype(nnArch)::ErrorCode_t::Success, ec) << "Reason: " << nnArch.NN.get_error_str(ec);
+
+	gradcheck_settings<real_t> ngcSetts;
+	ngcSetts.evalSetts.bIgnoreZerodLdWInUndelyingLayer = true;
+	ngcSetts.directionalCnt = 4;
+	ngcSetts.bDirectionalOnly = true;
+	ASSERT_TRUE(nnArch.NN.gradcheck(td.train_x(), td.train_y(), 10, ngcSetts));
+
+	ngcSetts.bDirectionalOnly = false;
+	ASSERT_TRUE(nnArch.NN.gradcheck_parallel({ &nnRepl1.NN, &nnRepl2.NN }, td.train_x(), td.train_y(), 10, ngcSetts));
+}
+
+template<typename base_t> struct TestNnetGA_EPS {};
+template<> struct TestNnetGA_EPS <double> { static constexpr double eps = 1e-10; };
+template<> struct TestNnetGA_EPS <float> { static constexpr float eps = 1e-5f; };
+
+//updating weights once per two micro-batches with accumulated gradient must give the same result as training on
+//the batch of twice the size (including momentum and L2 loss addendum, that must be applied once per effective batch)
+TEST(TestNnet, GradAccumulation) {
+	constexpr vec_len_t microBatch = 50, steps = 2, batchSize = microBatch*steps;
+	constexpr neurons_count_t incCnt = 17, lowerCnt = 19, neurCnt = 16;
+	const real_t lr = real_t(.5), momentum = real_t(.9), l2 = real_t(.01);
+	constexpr unsigned epochs = 2;
+
+	realmtx_t _train_x(batchSize, incCnt, true), _train_y(batchSize, 1, false);
+	ASSERT_TRUE(!_train_x.isAllocationFailed() && !_train_y.isAllocationFailed());
+
+	realmtx_t mb_x[steps], mb_y[steps];
+	for (unsigned s = 0; s < steps; ++s) {
+		mb_x[s].will_emulate_biases();
+		ASSERT_TRUE(mb_x[s].resize(microBatch, incCnt) && mb_y[s].resize(microBatch, 1));
+	}
+
+	typedef activation::sigm<real_t> Act_t;
+	typedef layer_output<activation::sigm_quad_loss<real_t>> LO;
+
+	auto setGW = [momentum, l2](auto& lyr) {
+		lyr.get_gradWorks().nesterov_momentum(momentum).L2(l2);
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	layer_input<> Ainp(incCnt);
+	LFC<Act_t> Alow(lowerCnt, lr);
+	LFC<Act_t> Afc(neurCnt, lr);
+	LO Aoutp(_train_y.cols(), lr);
+
+	auto Alp = make_layers(Ainp, Alow, Afc, Aoutp);
+	auto Ann = make_nnet(Alp);
+	Alp.for_each_layer_exc_input(setGW);
+
+	auto& rg = Ann.get_iRng();
+	rg.gen_matrix_no_bias(_train_x, real_t(5));
+	rg.gen_matrix_norm(_train_y);
+	for (unsigned s = 0; s < steps; ++s) {
+		for (vec_len_t r = 0; r < microBatch; ++r) {
+			for (vec_len_t c = 0; c < incCnt; ++c) mb_x[s].set(r, c, _train_x.get(s*microBatch + r, c));
+			mb_y[s].set(r, 0, _train_y.get(s*microBatch + r, 0));
+		}
+	}
+
+	auto ec = Ann.___init(batchSize, batchSize, false);
+	ASSERT_EQ(decltype(Ann)::ErrorCode::Success, ec);
+
+	realmtx_t AlowW, AfcW, AoutpW;
+	ASSERT_TRUE(Alow.get_weights().clone_to(AlowW));
+	ASSERT_TRUE(Afc.get_weights().clone_to(AfcW));
+	ASSERT_TRUE(Aoutp.get_weights().clone_to(AoutpW));
+
+	Ann.___get_common_data().set_mode_and_batch_size(true, batchSize);
+	Alp.on_batch_size_change(batchSize);
+	for (unsigned e = 0; e < epochs; ++e) {
+		Alp.fprop(_train_x);
+		Alp.bprop(_train_y);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	layer_input<> Binp(incCnt);
+	LFC<Act_t> Blow(lowerCnt, lr);
+	LFC<Act_t> Bfc(neurCnt, lr);
+	LO Boutp(_train_y.cols(), lr);
+
+	auto Blp = make_layers(Binp, Blow, Bfc, Boutp);
+	auto Bnn = make_nnet(Blp);
+	Blp.for_each_layer_exc_input(setGW);
+
+	ASSERT_TRUE(Blow.set_weights(::std::move(AlowW)));
+	ASSERT_TRUE(Bfc.set_weights(::std::move(AfcW)));
+	ASSERT_TRUE(Boutp.set_weights(::std::move(AoutpW)));
+
+	//normally it's done by nnet::train() according to nnet_train_opts::gradAccumSteps()
+	Bnn.___get_common_data()._set_grad_accum_steps(steps);
+	ec = Bnn.___init(microBatch, microBatch, false);
+	ASSERT_EQ(decltype(Bnn)::ErrorCode::Success, ec);
+
+	Bnn.___get_common_data().set_mode_and_batch_size(true, microBatch);
+	Blp.on_batch_size_change(microBatch);
+	for (unsigned e = 0; e < epochs; ++e) {
+		for (unsigned s = 0; s < steps; ++s) {
+			Bnn.___get_common_data()._set_grad_accum_step(s, steps);
+			Blp.fprop(mb_x[s]);
+			Blp.bprop(mb_y[s]);
+		}
+	}
+
+	ASSERT_REALMTX_NEAR(Aoutp.get_weights(), Boutp.get_weights(), "Output layer weights comparison failed!", TestNnetGA_EPS<real_t>::eps);
+	ASSERT_REALMTX_NEAR(Afc.get_weights(), Bfc.get_weights(), "Hidden layer weights comparison failed!", TestNnetGA_EPS<real_t>::eps);
+	ASSERT_REALMTX_NEAR(Alow.get_weights(), Blow.get_weights(), "Lower layer weights comparison failed!", TestNnetGA_EPS<real_t>::eps);
+}
+
+//a layer behind a closed gate of LPHO skips fprop()/bprop() of a micro-batch. The accumulated gradient must be reset
+//at the beginning of an effective batch, averaged over micro-batches that contributed to it only and applied even if
+//the last micro-batch was skipped. Here every effective batch of two micro-batches gets a single contribution, so it
+//must be the same as training without accumulation
+TEST(TestNnet, GradAccumulationSkippedMicroBatch) {
+	constexpr vec_len_t microBatch = 50;
+	constexpr unsigned steps = 2, epochs = 2;
+	constexpr neurons_count_t incCnt = 17, lowerCnt = 19, neurCnt = 16;
+	const real_t lr = real_t(.5), momentum = real_t(.9), l2 = real_t(.01);
+
+	realmtx_t mb_x[steps], mb_y[steps];
+	for (unsigned s = 0; s < steps; ++s) {
+		mb_x[s].will_emulate_biases();
+		ASSERT_TRUE(mb_x[s].resize(microBatch, incCnt) && mb_y[s].resize(microBatch, 1));
+	}
+
+	typedef activation::sigm<real_t> Act_t;
+	typedef layer_output<activation::sigm_quad_loss<real_t>> LO;
+
+	auto setGW = [momentum, l2](auto& lyr) {
+		lyr.get_gradWorks().nesterov_momentum(momentum).L2(l2);
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	layer_input<> Ainp(incCnt);
+	LFC<Act_t> Alow(lowerCnt, lr);
+	LFC<Act_t> Afc(neurCnt, lr);
+	LO Aoutp(mb_y[0].cols(), lr);
+
+	auto Alp = make_layers(Ainp, Alow, Afc, Aoutp);
+	auto Ann = make_nnet(Alp);
+	Alp.for_each_layer_exc_input(setGW);
+
+	auto& rg = Ann.get_iRng();
+	for (unsigned s = 0; s < steps; ++s) {
+		rg.gen_matrix_no_bias(mb_x[s], real_t(5));
+		rg.gen_matrix_norm(mb_y[s]);
+	}
+
+	auto ec = Ann.___init(microBatch, microBatch, false);
+	ASSERT_EQ(decltype(Ann)::ErrorCode::Success, ec);
+
+	realmtx_t AlowW, AfcW, AoutpW;
+	ASSERT_TRUE(Alow.get_weights().clone_to(AlowW));
+	ASSERT_TRUE(Afc.get_weights().clone_to(AfcW));
+	ASSERT_TRUE(Aoutp.get_weights().clone_to(AoutpW));
+
+	Ann.___get_common_data().set_mode_and_batch_size(true, microBatch);
+	Alp.on_batch_size_change(microBatch);
+	for (unsigned e = 0; e < epochs; ++e) {
+		for (unsigned s = 0; s < steps; ++s) {
+			Alp.fprop(mb_x[s]);
+			Alp.bprop(mb_y[s]);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	layer_input<> Binp(incCnt);
+	LFC<Act_t> Blow(lowerCnt, lr);
+	LFC<Act_t> Bfc(neurCnt, lr);
+	LO Boutp(mb_y[0].cols(), lr);
+
+	auto Blp = make_layers(Binp, Blow, Bfc, Boutp);
+	auto Bnn = make_nnet(Blp);
+	Blp.for_each_layer_exc_input(setGW);
+
+	ASSERT_TRUE(Blow.set_weights(::std::move(AlowW)));
+	ASSERT_TRUE(Bfc.set_weights(::std::move(AfcW)));
+	ASSERT_TRUE(Boutp.set_weights(::std::move(AoutpW)));
+
+	//the boundaries of effective batches are normally marked by nnet::train()
+	Bnn.___get_common_data()._set_grad_accum_steps(steps);
+	ec = Bnn.___init(microBatch, microBatch, false);
+	ASSERT_EQ(decltype(Bnn)::ErrorCode::Success, ec);
+
+	Bnn.___get_common_data().set_mode_and_batch_size(true, microBatch);
+	Blp.on_batch_size_change(microBatch);
+	for (unsigned e = 0; e < epochs; ++e) {
+		//the effective batch with the first micro-batch made on mb_x[0] and the last one skipped, then the one with
+		// the first micro-batch skipped and the last one made on mb_x[1]
+		for (unsigned s = 0; s < steps; ++s) {
+			Blp.for_each_layer(hlpr_layer_gw_grad_accum_begin());
+			Bnn.___get_common_data()._set_grad_accum_step(s, steps);
+			Blp.fprop(mb_x[s]);
+			Blp.bprop(mb_y[s]);
+			Bnn.___get_common_data()._set_grad_accum_step(steps - 1, steps);
+			Blp.for_each_layer_down(hlpr_layer_gw_grad_accum_end());
+		}
+	}
+	Bnn.___get_common_data()._set_grad_accum_step(0, 1);
+
+	ASSERT_REALMTX_NEAR(Aoutp.get_weights(), Boutp.get_weights(), "Output layer weights comparison failed!", TestNnetGA_EPS<real_t>::eps);
+	ASSERT_REALMTX_NEAR(Afc.get_weights(), Bfc.get_weights(), "Hidden layer weights comparison failed!", TestNnetGA_EPS<real_t>::eps);
+	ASSERT_REALMTX_NEAR(Alow.get_weights(), Blow.get_weights(), "Lower layer weights comparison failed!", TestNnetGA_EPS<real_t>::eps);
+}
+
+//inmem_train_data that keeps the order of training samples, so the batches nnet::train() makes are known in advance
+template<typename XT>
+class ordered_train_data final : public _inmem_train_data<ordered_train_data<XT>, XT, XT> {
+	typedef _inmem_train_data<ordered_train_data<XT>, XT, XT> _base_class_t;
+public:
+	template<typename CommonDataT>
+	numel_cnt_t on_next_epoch(const numel_cnt_t epochIdx, const CommonDataT& cd, vec_len_t batchSize = 0) noexcept {
+		const auto numBatches = _base_class_t::on_next_epoch(epochIdx, cd, batchSize);
+		::std::sort(this->m_vSampleIdxs.begin(), this->m_vSampleIdxs.end());
+		return numBatches;
+	}
+};
+
+//nnet::train() with gradient accumulation must be the same as training on effective batches. 5 micro-batches per epoch
+//with 2 steps make effective batches of 2, 2 and 1 micro-batches
+TEST(TestNnet, GradAccumulationTrain) {
+	constexpr vec_len_t microBatch = 50, microBatches = 5, samplesCnt = microBatch*microBatches, testCnt = 20;
+	constexpr unsigned steps = 2, epochs = 2;
+	constexpr neurons_count_t incCnt = 17, lowerCnt = 19, neurCnt = 16;
+	const real_t lr = real_t(.5), momentum = real_t(.9), l2 = real_t(.01);
+
+	realmtxdef_t trX(samplesCnt, incCnt, true), trY(samplesCnt, 1, false), tX(testCnt, incCnt, true), tY(testCnt, 1, false);
+	ASSERT_TRUE(!trX.isAllocationFailed() && !trY.isAllocationFailed() && !tX.isAllocationFailed() && !tY.isAllocationFailed());
+
+	typedef activation::sigm<real_t> Act_t;
+	typedef layer_output<activation::sigm_quad_loss<real_t>> LO;
+
+	auto setGW = [momentum, l2](auto& lyr) {
+		lyr.get_gradWorks().nesterov_momentum(momentum).L2(l2);
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	layer_input<> Ainp(incCnt);
+	LFC<Act_t> Alow(lowerCnt, lr);
+	LFC<Act_t> Afc(neurCnt, lr);
+	LO Aoutp(trY.cols(), lr);
+
+	auto Alp = make_layers(Ainp, Alow, Afc, Aoutp);
+	auto Ann = make_nnet(Alp);
+	Alp.for_each_layer_exc_input(setGW);
+
+	auto& rg = Ann.get_iRng();
+	rg.gen_matrix_no_bias(trX, real_t(5));
+	rg.gen_matrix_norm(trY);
+	rg.gen_matrix_no_bias(tX, real_t(5));
+	rg.gen_matrix_norm(tY);
+
+	auto ec = Ann.___init(microBatch*steps, microBatch*steps, false);
+	ASSERT_EQ(decltype(Ann)::ErrorCode::Success, ec);
+
+	realmtx_t AlowW, AfcW, AoutpW;
+	ASSERT_TRUE(Alow.get_weights().clone_to(AlowW));
+	ASSERT_TRUE(Afc.get_weights().clone_to(AfcW));
+	ASSERT_TRUE(Aoutp.get_weights().clone_to(AoutpW));
+
+	for (unsigned e = 0; e < epochs; ++e) {
+		for (vec_len_t first = 0; first < microBatches; first += steps) {
+			const vec_len_t bs = microBatch*::std::min(static_cast<vec_len_t>(steps), microBatches - first);
+			realmtx_t bx(bs, incCnt, true), by(bs, 1, false);
+			ASSERT_TRUE(!bx.isAllocationFailed() && !by.isAllocationFailed());
+			for (vec_len_t r = 0; r < bs; ++r) {
+				for (vec_len_t c = 0; c < incCnt; ++c) bx.set(r, c, trX.get(first*microBatch + r, c));
+				by.set(r, 0, trY.get(first*microBatch + r, 0));
+			}
+
+			Ann.___get_common_data().set_mode_and_batch_size(true, bs);
+			Alp.on_batch_size_change(bs);
+			Alp.fprop(bx);
+			Alp.bprop(by);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	ordered_train_data<real_t> td;
+	ASSERT_TRUE(td.absorb(::std::move(trX), ::std::move(trY), ::std::move(tX), ::std::move(tY)));
+
+	layer_input<> Binp(incCnt);
+	LFC<Act_t> Blow(lowerCnt, lr);
+	LFC<Act_t> Bfc(neurCnt, lr);
+	LO Boutp(td.train_y().cols(), lr);
+
+	auto Blp = make_layers(Binp, Blow, Bfc, Boutp);
+	auto Bnn = make_nnet(Blp);
+	Blp.for_each_layer_exc_input(setGW);
+
+	ASSERT_TRUE(Blow.set_weights(::std::move(AlowW)));
+	ASSERT_TRUE(Bfc.set_weights(::std::move(AfcW)));
+	ASSERT_TRUE(Boutp.set_weights(::std::move(AoutpW)));
+
+	nnet_train_opts<real_t, training_observer_silent<real_t>> opts(epochs);
+	opts.batchSize(microBatch).gradAccumSteps(steps);
+	ec = Bnn.train(td, opts);
+	ASSERT_EQ(decltype(Bnn)::ErrorCode::Success, ec) << "Error code description: " << Bnn.get_last_error_string();
+
+	ASSERT_REALMTX_NEAR(Aoutp.get_weights(), Boutp.get_weights(), "Output layer weights comparison failed!", TestNnetGA_EPS<real_t>::eps);
+	ASSERT_REALMTX_NEAR(Afc.get_weights(), Bfc.get_weights(), "Hidden layer weights comparison failed!", TestNnetGA_EPS<real_t>::eps);
+	ASSERT_REALMTX_NEAR(Alow.get_weights(), Blow.get_weights(), "Lower layer weights comparison failed!", TestNnetGA_EPS<real_t>::eps);
+}
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+// the same activation with the fused f_dLdZ()/f_loss() hidden, so layer_output falls back to f() followed by dLdZ()/loss()
+template<typename RealT>
+class softmax_xentropy_loss_unfused : public activation::softmax_xentropy_loss<RealT> {
+public:
+	static void f_dLdZ() = delete;
+	static void f_loss() = delete;
+};
+static_assert(activation::has_fused_loss<activation::softmax_xentropy_loss<real_t>>::value, "softmax_xentropy_loss must be fused");
+static_assert(!activation::has_fused_loss<softmax_xentropy_loss_unfused<real_t>>::value, "softmax_xentropy_loss_unfused must not be fused");
+
+template<typename real_t>
+struct testFusedLoss_res {
+	realmtx_t fclW, outpW;
+	::std::vector<real_t> trainLoss, testLoss;
+};
+
+template<typename ActT>
+void testFusedLoss(inmem_train_data<real_t>& td, uint64_t rngSeed, testFusedLoss_res<real_t>& res, const size_t epochs) noexcept {
+	SCOPED_TRACE(activation::has_fused_loss<ActT>::value ? "fused" : "unfused");
+	const real_t learningRate(.1);
+
+	layer_input<> inp(td.train_x().cols_no_bias());
+	layer_fully_connected<activation::sigm<real_t>> fcl(30, learningRate);
+	layer_output<ActT> outp(td.train_y().cols(), learningRate);
+
+	auto lp = make_layers(inp, fcl, outp);
+
+	nnet_train_opts<real_t, training_observer_silent<real_t>> opts(epochs);
+	opts.calcFullLossValue(true).batchSize(100);
+
+	auto nn = make_nnet(lp);
+	nn.get_iRng().seed64(rngSeed);
+
+	res.trainLoss.clear();
+	res.testLoss.clear();
+	//train() deinitializes the nnet on return, so the loss must be computed while it's still running
+	auto ec = nn.train(td, opts, [&nn, &td, &opts, &res](const size_t) {
+		res.trainLoss.push_back(nn.calcLossAndReport(td, td.train_set_id, opts.observer()));
+		res.testLoss.push_back(nn.calcLossAndReport(td, td.test_set_id, opts.observer()));
+		return true;
+	});
+	ASSERT_EQ(decltype(nn)::ErrorCode::Success, ec) << "Error code description: " << nn.get_last_error_string();
+	ASSERT_EQ(epochs, res.trainLoss.size());
+
+	ASSERT_TRUE(fcl.get_weights().clone_to(res.fclW));
+	ASSERT_TRUE(outp.get_weights().clone_to(res.outpW));
+}
+
+TEST(TestNnet, FusedSoftmaxXEntropyLoss) {
+	inmem_train_data<real_t> td;
+	readTd(td, MNIST_FILE_DEBUG);
+
+	const size_t epochs = 3;
+	const auto seed = ::std::time(0);
+	STDCOUTL("Seed = " << seed);
+
+	testFusedLoss_res<real_t> fused, unfused;
+	ASSERT_NO_FATAL_FAILURE(testFusedLoss<activation::softmax_xentropy_loss<real_t>>(td, seed, fused, epochs));
+	ASSERT_NO_FATAL_FAILURE(testFusedLoss<softmax_xentropy_loss_unfused<real_t>>(td, seed, unfused, epochs));
+
+	for (size_t e = 0; e < epochs; ++e) {
+		ASSERT_NEAR(unfused.trainLoss[e], fused.trainLoss[e], TestNnetGA_EPS<real_t>::eps*::std::abs(unfused.trainLoss[e]))
+			<< "Train loss differs at epoch " << e;
+		ASSERT_NEAR(unfused.testLoss[e], fused.testLoss[e], TestNnetGA_EPS<real_t>::eps*::std::abs(unfused.testLoss[e]))
+			<< "Test loss differs at epoch " << e;
+	}
+	ASSERT_REALMTX_NEAR(unfused.outpW, fused.outpW, "Output layer weights comparison failed!", TestNnetGA_EPS<real_t>::eps);
+	ASSERT_REALMTX_NEAR(unfused.fclW, fused.fclW, "Hidden layer weights comparison failed!", TestNnetGA_EPS<real_t>::eps);
+}
+
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
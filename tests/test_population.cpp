@@ -0,0 +1,125 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2021, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "stdafx.h"
+
+#include "../nntl/nntl.h"
+#include "../nntl/_supp/io/binfile.h"
+#include "../nntl/population_trainer.h"
+
+#include "asserts.h"
+#include "common_routines.h"
+
+using namespace nntl;
+typedef nntl_supp::binfile reader_t;
+
+typedef d_interfaces::real_t real_t;
+
+TEST(TestPopulation, WorkersActiveLimit) {
+	typedef threads::Workers<real_t, numel_cnt_t> workers_t;
+	workers_t t(3);
+	ASSERT_EQ(3, t.cur_workers_count());
+	ASSERT_EQ(3, t.active_workers());
+
+	thread_id_t used = 0;
+	::std::atomic<numel_cnt_t> processed(0);
+	auto fn = [&processed](const workers_t::par_range_t& r) { processed += r.cnt(); };
+
+	t.run(fn, 100, 0, &used);
+	ASSERT_EQ(3, used);
+	ASSERT_EQ(100, processed);
+
+	t.set_active_workers(1);
+	ASSERT_EQ(1, t.active_workers());
+	processed = 0;
+	t.run(fn, 100, 0, &used);
+	ASSERT_EQ(1, used);
+	ASSERT_EQ(100, processed);
+
+	//explicitly requested count wins
+	processed = 0;
+	t.run(fn, 100, 2, &used);
+	ASSERT_EQ(2, used);
+	ASSERT_EQ(100, processed);
+
+	t.set_active_workers(100);
+	ASSERT_EQ(3, t.active_workers());
+
+	//single threaded Workers must work too
+	workers_t t1(1);
+	processed = 0;
+	t1.run(fn, 100, 0, &used);
+	ASSERT_EQ(1, used);
+	ASSERT_EQ(100, processed);
+}
+
+TEST(TestPopulation, TrainPopulation) {
+	inmem_train_data<real_t> td;
+	reader_t reader;
+
+	const auto srcFile = MNIST_FILE_DEBUG;
+	STDCOUTL("Reading datafile '" << srcFile << "'...");
+	reader_t::ErrorCode rec = reader.read(srcFile, td);
+	ASSERT_EQ(reader_t::ErrorCode::Success, rec) << "Error code description: " << reader.get_last_error_str();
+
+	constexpr numel_cnt_t membersCnt = 7;
+	constexpr thread_id_t totalCores = 4;
+	population_trainer<d_interfaces, real_t> pt(td, 2, totalCores);
+
+	::std::vector<char> visited(membersCnt, 0);
+	const auto nOk = pt.run(membersCnt, [&td, &visited](auto& env) {
+		visited[env.idx] = 1;
+
+		//every member has its own hyperparameters
+		const real_t learningRate = real_t(.01) * (env.idx + 1);
+		const neurons_count_t nc = static_cast<neurons_count_t>(20 + 10 * env.idx);
+
+		layer_input<> inp(td.train_x().cols_no_bias());
+		layer_fully_connected<activation::sigm<real_t>> fcl(nc, learningRate);
+		layer_output<activation::sigm_xentropy_loss<real_t>> outp(td.train_y().cols(), learningRate);
+		auto lp = make_layers(inp, fcl, outp);
+
+		//members thread pool must be limited by the population trainer
+		EXPECT_LE(env.iMath.ithreads().active_workers(), 2);
+
+		nnet_train_opts<real_t, training_observer_silent<real_t>> opts(3 + env.idx % 3);//different members finish at different time
+		opts.batchSize(100);
+
+		auto nn = make_nnet(lp, env.iMath, env.iRng);
+		return nn.train(env.td, opts);
+	});
+
+	ASSERT_EQ(membersCnt, nOk);
+	for (numel_cnt_t i = 0; i < membersCnt; ++i) {
+		ASSERT_EQ(_nnet_errs::ErrorCode::Success, pt.results()[i]);
+		ASSERT_TRUE(visited[i]);
+	}
+}
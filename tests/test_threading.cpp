@@ -140,6 +140,46 @@ TEST(TestThreading, WorkersBasics) {
 	threads_basics_test(t);
 }
 
+#if NNTL_CFG_THREADS_TELEMETRY
+TEST(TestThreading, WorkersTelemetry) {
+	typedef threads::Workers<real_t, numel_cnt_t> workers_t;
+	workers_t t(4);
+	auto& tel = t.get_telemetry();
+	tel.reset();
+
+	//the thread with tid==3 is always the slowest
+	for (int i = 0; i < 10; ++i) {
+		NNTL_THREADS_TAG("telemetry_test");
+		t.run([](const workers_t::par_range_t& r) {
+			if (3 == r.tid()) ::std::this_thread::sleep_for(::std::chrono::milliseconds(5));
+		}, 4);
+	}
+	//untagged jobs are accounted under functor's type name
+	t.run([](const workers_t::par_range_t&) {}, 4);
+
+	unsigned tagsCnt = 0;
+	tel.for_each_tag([&tagsCnt](const threads::telemetry::tag_stats&, const threads::telemetry::thread_stats*) { ++tagsCnt; });
+	ASSERT_EQ(2, tagsCnt);
+
+	const auto ts = tel.get_tag("telemetry_test");
+	ASSERT_EQ(10, ts.jobs);
+	ASSERT_EQ(40, ts.elements);
+	ASSERT_EQ(30, ts.dispatchCnt);
+	ASSERT_GT(ts.imbalance_mean(), 2.);
+	ASSERT_GE(ts.wait_mean_ns(), 4e6);
+
+	tel.for_each_tag([](const threads::telemetry::tag_stats& s, const threads::telemetry::thread_stats* pThr) {
+		if (::std::strcmp(s.szTag, "telemetry_test")) return;
+		for (thread_id_t i = 0; i < 4; ++i) {
+			ASSERT_EQ(10, pThr[i].jobs);
+			ASSERT_EQ(3 == i ? 10 : 0, pThr[i].slowestCnt);
+		}
+	});
+
+	tel.report();
+}
+#endif //NNTL_CFG_THREADS_TELEMETRY
+
 
 #if !TESTS_SKIP_THREADING_PERFS
 